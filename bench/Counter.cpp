@@ -0,0 +1,202 @@
+// Frame counter registry: CFrameCounter::updateAll() throughput, create and
+// destroy churn, and both at once from two threads (a destroyed counter's
+// callback may only be called by the pass running when it was destroyed, so
+// its parameter is only invalidated once that pass is over)
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Util/Counter.hpp"
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace doll;
+
+struct SCallbackParm
+{
+	U32 uMagic;
+};
+static const U32 kCallbackMagic = 0xC0FFEE11;
+
+static std::atomic< U32 > g_cBadCallbacks( 0 );
+
+static F64 DOLL_API calcChecked_f( Void *pParm, F64 fValue, F64 )
+{
+	const SCallbackParm *const pCallbackParm = ( const SCallbackParm * )pParm;
+	if( !pCallbackParm || pCallbackParm->uMagic != kCallbackMagic ) {
+		g_cBadCallbacks.fetch_add( 1, std::memory_order_relaxed );
+		return 0.0;
+	}
+
+	return fValue*0.5;
+}
+
+static const EFrameCounter kTypes[] = {
+	EFrameCounter::Linear,
+	EFrameCounter::Slerp,
+	EFrameCounter::Accel,
+	EFrameCounter::Decel,
+	EFrameCounter::AccelDecel
+};
+static const EFrameCounterMode kModes[] = {
+	EFrameCounterMode::Normal,
+	EFrameCounterMode::Clamp,
+	EFrameCounterMode::WrapAround,
+	EFrameCounterMode::Loop
+};
+
+static SCallbackParm g_callbackParm = { kCallbackMagic };
+
+static CFrameCounter *makeCounter( U32 i )
+{
+	CFrameCounter *const pCounter = new CFrameCounter();
+	if( !pCounter ) {
+		return nullptr;
+	}
+
+	// Every eighth counter uses a user callback; the rest a built-in curve
+	if( i%8 == 0 ) {
+		pCounter->setCalculateCallback( &calcChecked_f, &g_callbackParm );
+	} else {
+		pCounter->setType( kTypes[ i%arraySize( kTypes ) ] );
+	}
+	pCounter->setMode( kModes[ i%arraySize( kModes ) ] );
+	pCounter->setRange( 0.0, F64( i%100 ) );
+	pCounter->activateMicroseconds( 1000 + ( i%5000 ) );
+
+	return pCounter;
+}
+
+static Void benchUpdateAll( U32 cCounters, U32 cFrames )
+{
+	std::vector< CFrameCounter * > counters;
+	counters.reserve( cCounters );
+	for( U32 i = 0; i < cCounters; ++i ) {
+		CFrameCounter *const pCounter = makeCounter( i );
+		if( !DOLL_CHECK( pCounter != nullptr ) ) {
+			break;
+		}
+		counters.push_back( pCounter );
+	}
+
+	const F64 fStart = test::seconds();
+	for( U32 uFrame = 0; uFrame < cFrames; ++uFrame ) {
+		CFrameCounter::updateAll();
+	}
+	const F64 fElapsed = test::seconds() - fStart;
+
+	F64 fSum = 0.0;
+	for( CFrameCounter *pCounter : counters ) {
+		fSum += pCounter->getValue();
+	}
+	test::keep( fSum );
+
+	test::report( "updateAll", fElapsed*1e9/( F64( cCounters )*F64( cFrames ) ), "ns/counter" );
+
+	for( CFrameCounter *pCounter : counters ) {
+		delete pCounter;
+	}
+}
+
+static Void benchChurn( U32 cPairs )
+{
+	const F64 fStart = test::seconds();
+	for( U32 i = 0; i < cPairs; ++i ) {
+		CFrameCounter *const pCounter = new CFrameCounter();
+		if( !DOLL_CHECK( pCounter != nullptr ) ) {
+			return;
+		}
+
+		pCounter->setType( EFrameCounter::Linear );
+		delete pCounter;
+	}
+	const F64 fElapsed = test::seconds() - fStart;
+
+	test::report( "create+destroy", fElapsed*1e9/F64( cPairs ), "ns/counter" );
+}
+
+static Void benchContended( U32 cCounters, U32 cPairs )
+{
+	std::vector< CFrameCounter * > counters;
+	counters.reserve( cCounters );
+	for( U32 i = 0; i < cCounters; ++i ) {
+		CFrameCounter *const pCounter = makeCounter( i );
+		if( !DOLL_CHECK( pCounter != nullptr ) ) {
+			break;
+		}
+		counters.push_back( pCounter );
+	}
+
+	std::atomic< Bool > bDone( false );
+	std::atomic< U32 > cStartedUpdates( 0 );
+	std::atomic< U32 > cUpdates( 0 );
+
+	std::thread updater( [&]() {
+		while( !bDone.load( std::memory_order_acquire ) ) {
+			cStartedUpdates.fetch_add( 1, std::memory_order_acq_rel );
+			CFrameCounter::updateAll();
+			cUpdates.fetch_add( 1, std::memory_order_acq_rel );
+		}
+	} );
+
+	// Parameters of destroyed counters, with the number of passes started
+	// by then; each is invalidated once those passes are all over
+	std::vector< SCallbackParm > parms( cPairs );
+	std::deque< std::pair< U32, U32 > > retired;
+
+	// Churn callback counters while the other thread updates
+	const F64 fStart = test::seconds();
+	for( U32 i = 0; i < cPairs; ++i ) {
+		CFrameCounter *const pCounter = new CFrameCounter();
+		if( !DOLL_CHECK( pCounter != nullptr ) ) {
+			break;
+		}
+
+		parms[ i ].uMagic = kCallbackMagic;
+		pCounter->setCalculateCallback( &calcChecked_f, &parms[ i ] );
+		pCounter->activateMicroseconds( 1000 );
+		delete pCounter;
+		retired.push_back( std::make_pair( i, cStartedUpdates.load( std::memory_order_acquire ) ) );
+
+		const U32 cDone = cUpdates.load( std::memory_order_acquire );
+		while( !retired.empty() && retired.front().second <= cDone ) {
+			parms[ retired.front().first ].uMagic = 0;
+			retired.pop_front();
+		}
+	}
+	const F64 fElapsed = test::seconds() - fStart;
+
+	bDone.store( true, std::memory_order_release );
+	updater.join();
+
+	test::report( "create+destroy (contended)", fElapsed*1e9/F64( cPairs ), "ns/counter" );
+	test::report( "updateAll passes meanwhile", F64( cUpdates.load() ), "passes" );
+
+	DOLL_CHECK( g_cBadCallbacks.load() == 0 );
+
+	for( CFrameCounter *pCounter : counters ) {
+		delete pCounter;
+	}
+}
+
+int main( int argc, char **argv )
+{
+	const Bool bQuick = test::isQuickRun( argc, argv );
+
+	const U32 cCounters = bQuick ?  10000 :  100000;
+	const U32 cFrames   = bQuick ?     50 :     500;
+	const U32 cPairs    = bQuick ? 100000 : 2000000;
+
+	printf( "Frame counters (%u counters, %u frames)\n", cCounters, cFrames );
+
+	benchUpdateAll( cCounters, cFrames );
+	benchChurn( cPairs );
+	benchContended( cCounters, cPairs/10 );
+
+	DOLL_CHECK( CFrameCounter::getLiveCount() == 0 );
+
+	return test::finish( "Bench-Counter" );
+}
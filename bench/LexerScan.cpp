@@ -0,0 +1,103 @@
+// Lexer byte scanning: lexScan_find() (sixteen bytes per step with SSE)
+// against lexScan_findScalar() for each byte class, over runs of skipped
+// bytes of a few typical lengths. Both must stop on the same bytes.
+
+#include "Common/DollTest.hpp"
+
+#include "Script/LexerScan.hpp"
+
+#include <vector>
+
+using namespace doll;
+using namespace doll::script;
+
+// A buffer of runs of `cRunBytes` bytes from `pszSkip`, each ended by `chStop`
+static std::vector< char > makeRuns( UPtr cBytes, UPtr cRunBytes, const char *pszSkip, char chStop )
+{
+	std::vector< char > buf( cBytes );
+
+	const UPtr cSkip = strlen( pszSkip );
+	for( UPtr i = 0; i < cBytes; ++i ) {
+		buf[ i ] = ( i + 1 )%( cRunBytes + 1 ) == 0 ? chStop : pszSkip[ i%cSkip ];
+	}
+
+	return buf;
+}
+
+// Walk the whole buffer, stopping on every match; returns the match count
+template< typename TFind >
+static UPtr walk( const std::vector< char > &buf, TFind find )
+{
+	const char *p = buf.data();
+	const char *const e = p + buf.size();
+
+	UPtr cStops = 0;
+	while( p < e ) {
+		p = find( p, e );
+		if( p < e ) {
+			++cStops;
+			++p;
+		}
+	}
+
+	return cStops;
+}
+
+template< typename TClass >
+static Void benchClass( const char *pszName, const TClass &cls, const char *pszSkip, char chStop, UPtr cBytes, U32 cPasses )
+{
+	static const UPtr kRunLengths[] = { 8, 64, 1024 };
+
+	for( UPtr cRunBytes : kRunLengths ) {
+		const std::vector< char > buf = makeRuns( cBytes, cRunBytes, pszSkip, chStop );
+
+		UPtr cSimdStops = 0;
+		UPtr cScalarStops = 0;
+
+		const F64 fSimdStart = test::seconds();
+		for( U32 uPass = 0; uPass < cPasses; ++uPass ) {
+			cSimdStops = walk( buf, [&]( const char *p, const char *e ) { return lexScan_find( p, e, cls ); } );
+		}
+		const F64 fSimdElapsed = test::seconds() - fSimdStart;
+
+		const F64 fScalarStart = test::seconds();
+		for( U32 uPass = 0; uPass < cPasses; ++uPass ) {
+			cScalarStops = walk( buf, [&]( const char *p, const char *e ) { return lexScan_findScalar( p, e, cls ); } );
+		}
+		const F64 fScalarElapsed = test::seconds() - fScalarStart;
+
+		DOLL_CHECK( cSimdStops == cScalarStops );
+		DOLL_CHECK( cSimdStops == cBytes/( cRunBytes + 1 ) );
+
+		const F64 fMegabytes = F64( cBytes )*F64( cPasses )/( 1024.0*1024.0 );
+		char szBuf[ 128 ];
+
+		axspf( szBuf, "%s, runs of %u, SIMD", pszName, U32( cRunBytes ) );
+		test::report( szBuf, fMegabytes/( fSimdElapsed > 0.0 ? fSimdElapsed : 1e-9 ), "MB/s" );
+		axspf( szBuf, "%s, runs of %u, scalar", pszName, U32( cRunBytes ) );
+		test::report( szBuf, fMegabytes/( fScalarElapsed > 0.0 ? fScalarElapsed : 1e-9 ), "MB/s" );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	const Bool bQuick = test::isQuickRun( argc, argv );
+
+	const UPtr cBytes  = bQuick ? 1024*1024 : 16*1024*1024;
+	const U32  cPasses = bQuick ? 2 : 10;
+
+	printf( "Lexer byte scanning (%u KB x %u passes)%s\n", U32( cBytes/1024 ), cPasses,
+#if AX_INTRIN_SSE
+		""
+#else
+		" -- no SSE, both paths are scalar"
+#endif
+	);
+
+	benchClass( "blank", SLexScan_Blank(), " \t \t    ", 'x', cBytes, cPasses );
+	benchClass( "ident", SLexScan_Ident(), "speaker_Name42", ' ', cBytes, cPasses );
+	benchClass( "comment", SLexScan_Either( '*', '\n' ), "a comment body. ", '\n', cBytes, cPasses );
+	benchClass( "dialogue", SLexScan_String( '"', false ), "The storm has not passed yet. ", '"', cBytes, cPasses );
+
+	return test::finish( "Bench-LexerScan" );
+}
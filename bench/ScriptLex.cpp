@@ -0,0 +1,119 @@
+// Script lexing: a large synthetic dialogue script through the whole lexing
+// pass (open, lex, string table), plus the string table on its own at two
+// sizes, where the cost per string should stay flat as the table grows
+
+#include "Common/DollTest.hpp"
+#include "Common/ScriptGen.hpp"
+
+#include "doll/Script/Scripting.hpp"
+#include "doll/Script/ProgramData.hpp"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace doll;
+
+static const char *const kScriptFilename = "Bench-ScriptLex.script";
+
+static Void benchLex( UPtr cScriptBytes, U32 cPasses )
+{
+	if( !DOLL_CHECK( test::writeTextFile( kScriptFilename, test::makeDialogueScript( cScriptBytes ) ) ) ) {
+		return;
+	}
+
+	F64 fBest = 0.0;
+	for( U32 uPass = 0; uPass < cPasses; ++uPass ) {
+		const F64 fStart = test::seconds();
+
+		RCompiler *pCompiler = sc_new();
+		if( !DOLL_CHECK( pCompiler != nullptr ) ) {
+			break;
+		}
+
+		const Bool bOpened = sc_openSource( pCompiler, kScriptFilename );
+		const Bool bLexed = bOpened && sc_lexSources( pCompiler, 1 );
+
+		pCompiler = sc_delete( pCompiler );
+
+		const F64 fElapsed = test::seconds() - fStart;
+
+		if( !DOLL_CHECK( bOpened ) || !DOLL_CHECK( bLexed ) ) {
+			break;
+		}
+		if( uPass == 0 || fElapsed < fBest ) {
+			fBest = fElapsed;
+		}
+	}
+
+	fs_remove( kScriptFilename );
+
+	if( fBest > 0.0 ) {
+		test::report( "lex dialogue script (best pass)", F64( cScriptBytes )/( fBest*1024.0*1024.0 ), "MB/s" );
+	}
+}
+
+static Void benchStringTable( U32 cUnique )
+{
+	// Every fourth string is a repeat of an earlier one, as in real scripts
+	std::vector< std::string > strings;
+	strings.reserve( cUnique + cUnique/3 );
+
+	test::SRandom rng = { cUnique };
+	char szBuf[ 128 ];
+	for( U32 i = 0; i < cUnique; ++i ) {
+		axspf( szBuf, "Line %u: the storm has not passed yet (%u)", i, rng.next()%1000 );
+		strings.push_back( szBuf );
+
+		if( i%3 == 2 ) {
+			strings.push_back( strings[ rng.next()%strings.size() ] );
+		}
+	}
+
+	std::unordered_set< std::string > unique( strings.begin(), strings.end() );
+
+	script::CProgramData progData;
+
+	const F64 fStart = test::seconds();
+	U32 cFailed = 0;
+	for( const std::string &s : strings ) {
+		cFailed += U32( !progData.addString( Str( s.data(), s.data() + s.size() ) ) );
+	}
+	const F64 fElapsed = test::seconds() - fStart;
+
+	axspf( szBuf, "addString (%u unique)", cUnique );
+	test::report( szBuf, fElapsed*1e9/F64( strings.size() ), "ns/string" );
+
+	DOLL_CHECK( cFailed == 0 );
+	DOLL_CHECK( progData.getStringCount() == unique.size() );
+
+	// Strings come back in the order they were first added
+	U32 cMismatches = 0;
+	for( UPtr i = 0; i < progData.getStringCount(); ++i ) {
+		const Str s = progData.getString( i );
+		cMismatches += U32( unique.find( std::string( s.get(), s.len() ) ) == unique.end() );
+	}
+	DOLL_CHECK( cMismatches == 0 );
+}
+
+int main( int argc, char **argv )
+{
+	const Bool bQuick = test::isQuickRun( argc, argv );
+
+	// The compiler reads sources of up to 16MB
+	const UPtr cScriptBytes = bQuick ? 512*1024 : 8*1024*1024;
+	const U32  cPasses      = bQuick ? 1 : 5;
+
+	test::SConsoleApp app;
+	if( !DOLL_CHECK( app.bInitialized ) ) {
+		return test::finish( "Bench-ScriptLex" );
+	}
+
+	printf( "Script lexing (%u KB dialogue script)\n", U32( cScriptBytes/1024 ) );
+
+	benchLex( cScriptBytes, cPasses );
+	benchStringTable( bQuick ? 2000 : 10000 );
+	benchStringTable( bQuick ? 32000 : 160000 );
+
+	return test::finish( "Bench-ScriptLex" );
+}
@@ -0,0 +1,126 @@
+// Script parsing: a large synthetic dialogue script lexed on its own, then
+// lexed and parsed into a syntax tree (the parser pulls tokens from the
+// lexer as it goes), so the difference is the parser's share. The script
+// must parse without syntax errors.
+
+#include "Common/DollTest.hpp"
+#include "Common/ScriptGen.hpp"
+
+#include "doll/Script/Compiler.hpp"
+#include "doll/Script/LanguageVersion.hpp"
+#include "doll/Script/Parser.hpp"
+
+using namespace doll;
+using namespace doll::script;
+
+static const char *const kScriptFilename = "Bench-ScriptParse.script";
+
+struct SPassResult
+{
+	F64 fSeconds;
+	U32 cItems;
+};
+
+// Each pass gets a fresh context, so identifiers and strings are new to it
+static Bool openScript( CCompilerContext &ctx )
+{
+	return DOLL_CHECK( ctx.init( kVer_1_0 ) ) && DOLL_CHECK( ctx.openSource( kScriptFilename ) );
+}
+
+static Bool lexPass( SPassResult &dst )
+{
+	CCompilerContext ctx;
+	if( !openScript( ctx ) ) {
+		return false;
+	}
+
+	const F64 fStart = test::seconds();
+
+	CLexer lexer( ctx );
+	SToken tok;
+	U32 cTokens = 0;
+	while( lexer.lex( tok ) ) {
+		++cTokens;
+	}
+
+	dst.fSeconds = test::seconds() - fStart;
+	dst.cItems = cTokens;
+
+	return DOLL_CHECK( cTokens > 0 );
+}
+
+static Bool parsePass( SPassResult &dst )
+{
+	CCompilerContext ctx;
+	if( !openScript( ctx ) ) {
+		return false;
+	}
+
+	const F64 fStart = test::seconds();
+
+	CLexer lexer( ctx );
+	CSyntaxTree tree;
+	CParser parser( lexer, ctx.getDiagnosticEngine(), tree );
+	const Bool bParsed = parser.parseProgram();
+
+	dst.fSeconds = test::seconds() - fStart;
+	dst.cItems = tree.num();
+
+	return DOLL_CHECK( bParsed ) && DOLL_CHECK( tree.num() > 1 );
+}
+
+template< typename TPass >
+static Bool bestOf( SPassResult &dst, U32 cPasses, TPass pfnPass )
+{
+	for( U32 uPass = 0; uPass < cPasses; ++uPass ) {
+		SPassResult result;
+		if( !pfnPass( result ) ) {
+			return false;
+		}
+
+		if( uPass == 0 || result.fSeconds < dst.fSeconds ) {
+			dst = result;
+		}
+	}
+
+	return true;
+}
+
+int main( int argc, char **argv )
+{
+	const Bool bQuick = test::isQuickRun( argc, argv );
+
+	// The compiler reads sources of up to 16MB
+	const UPtr cScriptBytes = bQuick ? 512*1024 : 8*1024*1024;
+	const U32  cPasses      = bQuick ? 1 : 5;
+
+	test::SConsoleApp app;
+	if( !DOLL_CHECK( app.bInitialized ) ) {
+		return test::finish( "Bench-ScriptParse" );
+	}
+
+	printf( "Script parsing (%u KB dialogue script, best of %u)\n", U32( cScriptBytes/1024 ), cPasses );
+
+	if( !DOLL_CHECK( test::writeTextFile( kScriptFilename, test::makeDialogueScript( cScriptBytes ) ) ) ) {
+		return test::finish( "Bench-ScriptParse" );
+	}
+
+	SPassResult lexed = { 0.0, 0 };
+	SPassResult parsed = { 0.0, 0 };
+
+	if( bestOf( lexed, cPasses, &lexPass ) && bestOf( parsed, cPasses, &parsePass ) ) {
+		const F64 fMegabytes = F64( cScriptBytes )/( 1024.0*1024.0 );
+		const F64 fParseSeconds = parsed.fSeconds > lexed.fSeconds ? parsed.fSeconds - lexed.fSeconds : 0.0;
+
+		test::report( "lex", fMegabytes/( lexed.fSeconds > 0.0 ? lexed.fSeconds : 1e-9 ), "MB/s" );
+		test::report( "lex + parse", fMegabytes/( parsed.fSeconds > 0.0 ? parsed.fSeconds : 1e-9 ), "MB/s" );
+		test::report( "tokens", F64( lexed.cItems ), "" );
+		test::report( "syntax nodes", F64( parsed.cItems ), "" );
+		test::report( "parse share", fParseSeconds*100.0/( parsed.fSeconds > 0.0 ? parsed.fSeconds : 1e-9 ), "%" );
+		test::report( "parse (excluding lexing)", fParseSeconds*1e9/F64( parsed.cItems ), "ns/node" );
+	}
+
+	fs_remove( kScriptFilename );
+
+	return test::finish( "Bench-ScriptParse" );
+}
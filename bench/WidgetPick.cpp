@@ -0,0 +1,132 @@
+// Widget picking: MWidgets::pick() through the pick index against a linear
+// walk of the sibling list (what picking did before the index), over 50,000
+// overlapping root widgets. Every query is checked against the linear walk.
+
+#include "Common/DollTest.hpp"
+
+#include "doll/UX/Widget.hpp"
+
+#include <vector>
+
+using namespace doll;
+
+static const S32 kAreaResX = 8192;
+static const S32 kAreaResY = 8192;
+
+// First visible widget (in sibling order) that contains `pos` and accepts it
+static IWidget *linearPick( const std::vector< IWidget * > &widgets, const SIntVector2 &pos )
+{
+	for( IWidget *pWidget : widgets ) {
+		if( !pWidget->isVisible() ) {
+			continue;
+		}
+
+		const SRect &shape = pWidget->getShape();
+		if( pos.x < shape.x1 || pos.y < shape.y1 || pos.x >= shape.x2 || pos.y >= shape.y2 ) {
+			continue;
+		}
+
+		if( pWidget->pick( pos - pWidget->getPosition() ) ) {
+			return pWidget;
+		}
+	}
+
+	return nullptr;
+}
+
+int main( int argc, char **argv )
+{
+	const Bool bQuick = test::isQuickRun( argc, argv );
+
+	const U32 cWidgets = 50000;
+	const U32 cQueries = bQuick ? 2000 : 20000;
+
+	MWidgets &widgetMgr = DOLL__UX_WIDGETS;
+
+	printf( "Widget picking (%u widgets, %u queries)\n", cWidgets, cQueries );
+
+	test::SRandom rng = { 12345 };
+
+	std::vector< IWidget * > widgets;
+	widgets.reserve( cWidgets );
+
+	const F64 fBuildStart = test::seconds();
+	for( U32 i = 0; i < cWidgets; ++i ) {
+		WBaseWidget *const pWidget = widgetMgr.newWidget< WBaseWidget >();
+		if( !DOLL_CHECK( pWidget != nullptr ) ) {
+			break;
+		}
+
+		// Mostly small widgets with a few large panels so overlap is common
+		const S32 iResX = i%64 == 0 ? rng.range( 256, 2048 ) : rng.range( 8, 128 );
+		const S32 iResY = i%64 == 0 ? rng.range( 256, 2048 ) : rng.range( 8, 128 );
+		const S32 iPosX = rng.range( 0, kAreaResX - iResX );
+		const S32 iPosY = rng.range( 0, kAreaResY - iResY );
+
+		pWidget->setShape( SRect( iPosX, iPosY, iPosX + iResX, iPosY + iResY ) );
+
+		// A few hidden widgets must never be picked
+		if( i%97 == 0 ) {
+			pWidget->setVisible( false );
+		}
+
+		widgets.push_back( pWidget );
+	}
+	const F64 fBuildElapsed = test::seconds() - fBuildStart;
+
+	std::vector< SIntVector2 > queries;
+	queries.reserve( cQueries );
+	for( U32 i = 0; i < cQueries; ++i ) {
+		queries.push_back( SIntVector2( rng.range( 0, kAreaResX ), rng.range( 0, kAreaResY ) ) );
+	}
+
+	std::vector< IWidget * > expected;
+	expected.reserve( cQueries );
+
+	const F64 fLinearStart = test::seconds();
+	for( const SIntVector2 &pos : queries ) {
+		expected.push_back( linearPick( widgets, pos ) );
+	}
+	const F64 fLinearElapsed = test::seconds() - fLinearStart;
+
+	U32 cMismatches = 0;
+	U32 cHits = 0;
+
+	const F64 fIndexStart = test::seconds();
+	for( U32 i = 0; i < cQueries; ++i ) {
+		IWidget *const pPicked = widgetMgr.pick( queries[ i ] );
+
+		cHits += U32( pPicked != nullptr );
+		cMismatches += U32( pPicked != expected[ i ] );
+	}
+	const F64 fIndexElapsed = test::seconds() - fIndexStart;
+
+	// Moving widgets around keeps the index balanced and in sync
+	const F64 fMoveStart = test::seconds();
+	for( U32 i = 0; i < cWidgets; i += 7 ) {
+		const SRect &shape = widgets[ i ]->getShape();
+		const S32 iPosX = rng.range( 0, kAreaResX - shape.resX() );
+		const S32 iPosY = rng.range( 0, kAreaResY - shape.resY() );
+
+		widgets[ i ]->setShape( SRect( iPosX, iPosY, iPosX + shape.resX(), iPosY + shape.resY() ) );
+	}
+	const F64 fMoveElapsed = test::seconds() - fMoveStart;
+
+	for( const SIntVector2 &pos : queries ) {
+		cMismatches += U32( widgetMgr.pick( pos ) != linearPick( widgets, pos ) );
+	}
+
+	test::report( "build (insert + setShape)", fBuildElapsed*1e9/F64( cWidgets ), "ns/widget" );
+	test::report( "pick, linear scan", fLinearElapsed*1e9/F64( cQueries ), "ns/query" );
+	test::report( "pick, index", fIndexElapsed*1e9/F64( cQueries ), "ns/query" );
+	test::report( "speedup", fLinearElapsed/( fIndexElapsed > 0.0 ? fIndexElapsed : 1e-9 ), "x" );
+	test::report( "move (setShape)", fMoveElapsed*1e9/F64( ( cWidgets + 6 )/7 ), "ns/widget" );
+	test::report( "queries that hit a widget", F64( cHits )*100.0/F64( cQueries ), "%" );
+
+	DOLL_CHECK( cMismatches == 0 );
+	DOLL_CHECK( cHits > 0 );
+
+	widgetMgr.deleteAllWidgets();
+
+	return test::finish( "Bench-WidgetPick" );
+}
@@ -282,6 +282,7 @@ namespace doll
 	struct SCoreTooling
 	{
 		Bool         isTool        = false;
+		Bool         isHeadless    = false;
 		EConsoleType stdoutType    = kConsoleTypeNone;
 		EConsoleType stderrType    = kConsoleTypeNone;
 		EConsoleType stdinType     = kConsoleTypeNone;
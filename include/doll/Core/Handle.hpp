@@ -4,6 +4,9 @@
 
 #include "Private/Variants.hpp"
 #include "Version.hpp"
+#include "Memory.hpp"
+
+#include <type_traits>
 
 // Systems implementing handles should define these to the appropriate runtime
 // error routines for their subsystem.
@@ -276,6 +279,213 @@ private:
 	}
 };
 
+/*
+
+	THandleTable is an allocator pool (see TPoolObject) that keeps objects in
+	fixed-size pages of slots. A slot's index never changes once handed out,
+	released slots are reused through a free list, and each slot carries a
+	generation that is bumped on release so stale handles resolve to nullptr
+	rather than to whatever object took the slot next.
+
+	Pages are never returned to the heap, so raw pointers obtained from get()
+	stay valid until the object itself is deleted.
+
+	Not thread-safe; meant for objects owned by a single (main) thread.
+
+	Handles are plain data (no constructors) so DOLL_FUNC routines can take
+	and return them by value through the C API. A value-initialized handle,
+	`Handle()` or `= {}`, is the null handle.
+
+*/
+template<typename T, int tTag = 0, unsigned tSlotsPerPage = 256>
+class THandleTable {
+public:
+	struct Handle: public internal::HandleImpl {
+		using ObjectType = T;
+
+		bool operator!() const { return uIndex==0; }
+		operator bool() const { return uIndex!=0; }
+
+		bool operator==( decltype(nullptr) ) const { return uIndex==0; }
+		bool operator!=( decltype(nullptr) ) const { return uIndex!=0; }
+
+		bool operator==( Handle h ) const { return uIndex==h.uIndex && uGeneration==h.uGeneration; }
+		bool operator!=( Handle h ) const { return uIndex!=h.uIndex || uGeneration!=h.uGeneration; }
+	};
+
+	static const unsigned kSlotsPerPage = tSlotsPerPage;
+	static const unsigned kMaxPages     = 4096;
+
+	// TPoolObject interface
+	void *alloc( UPtr n, int tag, const char *file, int line, const char *func ) {
+		AX_ASSERT_MSG( n <= sizeof(T), "Object does not fit in handle table slot" );
+		((void)n);
+
+		unsigned index;
+		if( mFreeHead != 0 ) {
+			index = mFreeHead - 1;
+			mFreeHead = info( index ).uNextFree;
+		} else {
+			if( mcSlots == kMaxPages*kSlotsPerPage ) {
+				AX_ASSERT_MSG( false, "Handle table is full" );
+				return nullptr;
+			}
+
+			index = mcSlots;
+			if( index%kSlotsPerPage == 0 && !commitPage( index/kSlotsPerPage, tag, file, line, func ) ) {
+				return nullptr;
+			}
+
+			++mcSlots;
+		}
+
+		SSlotInfo &slot = info( index );
+		slot.uNextFree = 0;
+		slot.bLive     = true;
+
+		++mcLive;
+
+		U8 *const p = slotBase( index );
+		*( unsigned * )p = index;
+		return ( void * )( p + kHeaderSize );
+	}
+	void *dealloc( void *p, const char *file, int line, const char *func ) {
+		((void)file);
+		((void)line);
+		((void)func);
+
+		if( !p ) {
+			return nullptr;
+		}
+
+		const unsigned index = indexOf( p );
+		SSlotInfo &slot = info( index );
+		AX_ASSERT_MSG( slot.bLive, "Slot released twice" );
+
+		slot.bLive     = false;
+		slot.uAge     += 1;
+		slot.uNextFree = mFreeHead;
+		mFreeHead      = index + 1;
+
+		--mcLive;
+		return nullptr;
+	}
+
+	// Retrieve the handle of an object allocated from this table
+	Handle handleOf( const T *pObject ) const {
+		Handle h = Handle();
+		if( !pObject ) {
+			return h;
+		}
+
+		const unsigned index = indexOf( pObject );
+
+		h.uIndex      = index + 1;
+		h.uGeneration = info( index ).uAge & internal::HandleImpl::kGenMask;
+		return h;
+	}
+	// Resolve a handle; nullptr if the handle is null, out of range or stale
+	T *get( Handle h ) const {
+		if( !h ) {
+			return nullptr;
+		}
+
+		const unsigned index = h.uIndex - 1;
+		if( index >= mcSlots ) {
+			DOLL__RUNTIME_ERROR_INVALID_HANDLE();
+			return nullptr;
+		}
+
+		const SSlotInfo &slot = info( index );
+		if( !slot.bLive ) {
+			DOLL__RUNTIME_ERROR_DEAD_HANDLE();
+			return nullptr;
+		}
+		if( ( slot.uAge & internal::HandleImpl::kGenMask ) != h.uGeneration ) {
+			DOLL__RUNTIME_ERROR_REUSED_HANDLE();
+			return nullptr;
+		}
+
+		return ( T * )( slotBase( index ) + kHeaderSize );
+	}
+	bool isValid( Handle h ) const {
+		if( !h || h.uIndex > mcSlots ) {
+			return false;
+		}
+
+		const SSlotInfo &slot = info( h.uIndex - 1 );
+		return slot.bLive && ( slot.uAge & internal::HandleImpl::kGenMask ) == h.uGeneration;
+	}
+
+	// Number of objects currently allocated
+	unsigned getLiveCount() const { return mcLive; }
+	// Number of slots ever handed out (live objects plus the free list)
+	unsigned getSlotCount() const { return mcSlots; }
+
+	// Object in slot `index` or nullptr if that slot is free; lets callers
+	// walk every live object in storage order
+	T *getBySlot( unsigned index ) const {
+		if( index >= mcSlots || !info( index ).bLive ) {
+			return nullptr;
+		}
+
+		return ( T * )( slotBase( index ) + kHeaderSize );
+	}
+
+private:
+	struct SSlotInfo {
+		unsigned uAge;
+		unsigned uNextFree; // one-based; 0 terminates the free list
+		bool     bLive;
+	};
+
+	// Each slot is prefixed with its own index so pointers map back to slots
+	static const UPtr kHeaderSize = 16;
+	static const UPtr kInfoBytes  = DOLL_ALIGN( sizeof(SSlotInfo)*tSlotsPerPage, 16 );
+
+	static UPtr slotStride() {
+		return kHeaderSize + DOLL_ALIGN( sizeof(T), 16 );
+	}
+
+	U8      *mPages[ kMaxPages ] = {};
+	unsigned mcSlots             = 0;
+	unsigned mcLive              = 0;
+	unsigned mFreeHead           = 0;
+
+	bool commitPage( unsigned page, int tag, const char *file, int line, const char *func ) {
+		const UPtr n = kInfoBytes + slotStride()*kSlotsPerPage;
+
+		U8 *const p = ( U8 * )DOLL__HEAP_ALLOCATOR->alloc( n, tag != 0 ? tag : tTag, file, line, func );
+		if( !AX_VERIFY_MEMORY( p ) ) {
+			return false;
+		}
+
+		SSlotInfo *const pInfo = ( SSlotInfo * )p;
+		for( unsigned i = 0; i < kSlotsPerPage; ++i ) {
+			pInfo[ i ].uAge      = 0;
+			pInfo[ i ].uNextFree = 0;
+			pInfo[ i ].bLive     = false;
+		}
+
+		mPages[ page ] = p;
+		return true;
+	}
+
+	SSlotInfo &info( unsigned index ) const {
+		return ( ( SSlotInfo * )mPages[ index/kSlotsPerPage ] )[ index%kSlotsPerPage ];
+	}
+	U8 *slotBase( unsigned index ) const {
+		return mPages[ index/kSlotsPerPage ] + kInfoBytes + slotStride()*( index%kSlotsPerPage );
+	}
+	unsigned indexOf( const void *pObject ) const {
+		const unsigned index = *( const unsigned * )( ( const U8 * )pObject - kHeaderSize );
+		AX_ASSERT_MSG( index < mcSlots && slotBase( index ) + kHeaderSize == ( const U8 * )pObject, "Object was not allocated from this handle table" );
+		return index;
+	}
+
+	static_assert( std::is_pod<Handle>::value, "Handles cross the C API by value and must stay plain data" );
+};
+
 /*
 
 	// Example of usage:
@@ -148,6 +148,21 @@ namespace doll
 
 		void tagAlloc( void *p, UPtr size, int tag, const char *file, int line, const char *func );
 		void tagDealloc( void *p, UPtr size, int tag, const char *file, int line, const char *func );
+
+		// Running totals for a tag, maintained on every allocation (unlike the
+		// frame/app stats above, which are folded once per frame)
+		struct STagLiveCounts
+		{
+			U64 cLiveBytes;
+			U64 cPeakBytes;
+			U64 cLiveAllocs;
+			U64 cTotalAllocs;
+			U64 cTotalAllocBytes;
+			U64 cTotalFreeBytes;
+		};
+
+		void getTagLiveCounts( int tag, STagLiveCounts &dst );
+		void resetTagPeaks();
 #endif
 
 	}
@@ -706,6 +721,11 @@ namespace doll
 			gPool.dealloc( p, nullptr, 0, nullptr );
 		}
 
+		inline static PoolT &getPool()
+		{
+			return gPool;
+		}
+
 	protected:
 		static PoolT gPool;
 	};
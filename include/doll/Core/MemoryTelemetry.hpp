@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Defs.hpp"
+#include "Memory.hpp"
+#include "MemoryTags.hpp"
+
+namespace doll
+{
+
+	/*
+	===========================================================================
+
+		MEMORY TELEMETRY
+
+		Periodic snapshots of the per-tag counters kept by Mem::tagAlloc(),
+		kept in a fixed-size history so growth over a long session can be
+		inspected or exported. Two snapshots can be diffed to see what was
+		left behind between two points (e.g., two level loads).
+
+		Development and debug builds can additionally attribute allocations
+		to their call sites (callstack hash). Site tracking is off by default
+		since capturing a callstack on every allocation is expensive.
+
+	===========================================================================
+	*/
+
+	// Maximum number of return addresses recorded per allocation site
+	static const UPtr kMaxMemSiteFrames = 16;
+
+	struct SMemTagSample
+	{
+		// Bytes currently allocated under the tag
+		U64 cLiveBytes;
+		// Highest cLiveBytes seen since startup (or the last mem_resetPeaks())
+		U64 cPeakBytes;
+		// Allocations currently outstanding
+		U64 cLiveAllocs;
+		// Totals since startup
+		U64 cTotalAllocs;
+		U64 cTotalAllocBytes;
+		U64 cTotalFreeBytes;
+		// Rates measured against the previous snapshot
+		F64 fAllocsPerSec;
+		F64 fAllocBytesPerSec;
+		F64 fFreeBytesPerSec;
+	};
+
+	struct SMemSnapshot
+	{
+		// Time (microseconds()) at which the snapshot was taken
+		U64           uTimeMicrosecs;
+		// Update frame the snapshot was taken on
+		U32           uFrameId;
+		// One entry per memory tag (indexed by kTag_*)
+		SMemTagSample tags[ kMaxTags ];
+
+		U64 getTotalLiveBytes() const
+		{
+			U64 n = 0;
+			for( const SMemTagSample &t : tags ) {
+				n += t.cLiveBytes;
+			}
+			return n;
+		}
+	};
+
+	struct SMemTagDelta
+	{
+		S64 iLiveBytes;
+		S64 iLiveAllocs;
+		S64 iPeakBytes;
+		U64 cAllocs;
+		U64 cAllocBytes;
+		U64 cFreeBytes;
+	};
+
+	struct SMemSnapshotDiff
+	{
+		U64          uElapsedMicrosecs;
+		U32          cElapsedFrames;
+		S64          iTotalLiveBytes;
+		// One entry per memory tag (indexed by kTag_*); "after" minus "before"
+		SMemTagDelta tags[ kMaxTags ];
+	};
+
+	struct SMemAllocSite
+	{
+		// Hash of the callstack (and source location) that allocated
+		U64         uHash;
+		int         tag;
+		const char *pszFile;
+		int         iLine;
+		const char *pszFunc;
+
+		U64         cLiveBytes;
+		U64         cLiveAllocs;
+		U64         cTotalAllocs;
+		// Change in cLiveBytes since the last mem_markAllocSites()
+		S64         iBytesSinceMark;
+
+		UPtr        cFrames;
+		UPtr        frames[ kMaxMemSiteFrames ];
+	};
+
+	enum class EMemExportFormat
+	{
+		CSV,
+		JSON
+	};
+
+	// Set how often a snapshot is recorded automatically (0 disables)
+	DOLL_FUNC Void DOLL_API mem_setSnapshotInterval( U32 uMilliseconds );
+	DOLL_FUNC U32 DOLL_API mem_getSnapshotInterval();
+	// Set how many snapshots are retained; the oldest are dropped first
+	DOLL_FUNC Bool DOLL_API mem_setSnapshotHistory( U32 cSnapshots );
+	DOLL_FUNC U32 DOLL_API mem_getSnapshotHistory();
+
+	// Take a snapshot now and add it to the history
+	DOLL_FUNC Void DOLL_API mem_takeSnapshot( SMemSnapshot &dst );
+	// Number of snapshots currently held in the history
+	DOLL_FUNC U32 DOLL_API mem_getSnapshotCount();
+	// Retrieve a snapshot from the history (0 is the oldest)
+	DOLL_FUNC Bool DOLL_API mem_getSnapshot( U32 uIndex, SMemSnapshot &dst );
+	DOLL_FUNC Void DOLL_API mem_clearSnapshots();
+
+	// Reset every tag's peak to its current live size
+	DOLL_FUNC Void DOLL_API mem_resetPeaks();
+
+	// Compute the difference between two snapshots
+	DOLL_FUNC Void DOLL_API mem_diffSnapshots( SMemSnapshotDiff &dst, const SMemSnapshot &before, const SMemSnapshot &after );
+
+	// Write the snapshot history to a file
+	DOLL_FUNC Bool DOLL_API mem_exportSnapshots( Str filename, EMemExportFormat fmt );
+	// Write a snapshot diff to a file
+	DOLL_FUNC Bool DOLL_API mem_exportSnapshotDiff( Str filename, const SMemSnapshotDiff &diff, EMemExportFormat fmt );
+
+	// Whether allocation sites can be tracked in this build
+	DOLL_FUNC Bool DOLL_API mem_isAllocSiteTrackingAvailable();
+	// Start or stop recording allocation sites (no-op if unavailable)
+	DOLL_FUNC Void DOLL_API mem_enableAllocSiteTracking( Bool bEnable );
+	DOLL_FUNC Bool DOLL_API mem_isAllocSiteTrackingEnabled();
+	// Remember every site's current live size as the baseline for iBytesSinceMark
+	DOLL_FUNC Void DOLL_API mem_markAllocSites();
+	// Copy up to cMaxSites sites, largest live size first; returns the total site count
+	DOLL_FUNC UPtr DOLL_API mem_getAllocSites( SMemAllocSite *pDstSites, UPtr cMaxSites );
+	// Write every tracked allocation site to a file
+	DOLL_FUNC Bool DOLL_API mem_exportAllocSites( Str filename, EMemExportFormat fmt );
+
+	namespace Mem
+	{
+
+		// Called from the tagging hooks and the engine's update step
+		void telemetryRecordAlloc( void *p, UPtr size, int tag, const char *file, int line, const char *func );
+		void telemetryRecordDealloc( void *p, UPtr size, int tag );
+		void updateTelemetry();
+
+	}
+
+}
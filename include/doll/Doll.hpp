@@ -19,9 +19,11 @@
 #include "Core/Logger.hpp"
 #include "Core/Memory.hpp"
 #include "Core/MemoryTags.hpp"
+#include "Core/MemoryTelemetry.hpp"
 
 #include "Front/Frontend.hpp"
 #include "Front/Input.hpp"
+#include "Front/InputEvents.hpp"
 #include "Front/Setup.hpp"
 
 #include "Gfx/Action.hpp"
@@ -54,11 +56,13 @@
 #include "Script/Ident.hpp"
 #include "Script/LanguageVersion.hpp"
 #include "Script/Lexer.hpp"
+#include "Script/LexerState.hpp"
 #include "Script/ProgramData.hpp"
 #include "Script/Scripting.hpp"
 #include "Script/Source.hpp"
 #include "Script/SourceLoc.hpp"
 #include "Script/Token.hpp"
+#include "Script/TokenCache.hpp"
 #include "Script/Type.hpp"
 
 #include "Snd/ChannelUtil.hpp"
@@ -78,3 +82,4 @@
 
 #include "UX/DialogueWidget.hpp"
 #include "UX/Widget.hpp"
+#include "UX/WidgetIndex.hpp"
@@ -13,6 +13,10 @@ namespace doll
 	DOLL_FUNC Void DOLL_API doll_preInit();
 	DOLL_FUNC Bool DOLL_API doll_init( const SCoreConfig *pConf = nullptr );
 	DOLL_FUNC Bool DOLL_API doll_initConsoleApp();
+	// Like doll_init() but with no window or sound, rendering with the
+	// software renderer at the configured resolution (for tests and tools
+	// that render frames and read them back)
+	DOLL_FUNC Bool DOLL_API doll_initHeadless( const SCoreConfig *pConf = nullptr );
 	DOLL_FUNC Void DOLL_API doll_fini();
 
 	DOLL_FUNC Bool DOLL_API doll_sync_app();
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+#include "../Core/Engine.hpp"
+#include "../OS/Key.hpp"
+#include "../OS/Window.hpp"
+
+namespace doll
+{
+
+	/*
+	===========================================================================
+
+		INPUT EVENTS
+
+		Every key, character and mouse message received from the OS (or
+		GLFW) is stamped with the time and update frame it arrived on and
+		appended to a fixed-size ring. At the start of each update frame the
+		ring is folded into an immutable snapshot of the input state, so
+		presses and releases that happen between two polls are never lost
+		and jobs running during the update can read input without locking.
+
+		The ring can be recorded to a file and replayed later. Replay is
+		keyed by update frame (not wall time), so the same recording
+		produces the same per-frame snapshots on every run.
+
+	===========================================================================
+	*/
+
+	// Number of events held in the ring; older events are overwritten
+	static const UPtr kInputEventRingSize = 4096;
+	// Number of snapshots kept alive; a snapshot stays valid this many frames
+	static const UPtr kInputSnapshotCount = 4;
+
+	enum class EInputEvent: U8
+	{
+		None,
+
+		FocusGained,
+		FocusLost,
+
+		KeyPress,
+		KeyRepeat,
+		KeyRelease,
+		KeyChar,
+
+		MousePress,
+		MouseRelease,
+		MouseWheel,
+		MouseMove,
+		MouseExit,
+
+		// A core input action was triggered (derived; never recorded)
+		Action
+	};
+
+	struct SInputEvent
+	{
+		// Time (microseconds()) at which the event was received
+		U64         uTimeMicrosecs;
+		// Update frame (g_core.frame.uUpdateId) the event was received on
+		U32         uFrameId;
+		EInputEvent type;
+		// EKey, EMouse or ECoreInputAction depending on `type`
+		U8          uCode;
+		U16         uReserved;
+		// Modifier flags, or the UTF-32 character for `EInputEvent::KeyChar`
+		U32         uMods;
+		// Client position for mouse events
+		S32         x;
+		S32         y;
+		// Wheel delta for `EInputEvent::MouseWheel`
+		F32         z;
+	};
+	static_assert( sizeof( SInputEvent ) == 32, "SInputEvent layout is part of the recording format" );
+
+	struct SInputSnapshot
+	{
+		static const UPtr kNumFieldBits = sizeof(U64)*8;
+		static const UPtr kNumKeyFields = 0x100/kNumFieldBits;
+		static const UPtr kNumMouseBtns = 8;
+
+		// Update frame this snapshot was taken for
+		U32  uFrameId;
+		// Time (microseconds()) at which the snapshot was taken
+		U64  uTimeMicrosecs;
+		// Range of event sequence numbers folded into this snapshot
+		U64  uFirstEvent;
+		U64  uEndEvent;
+		// Number of events that were overwritten before they could be folded
+		U32  cLostEvents;
+
+		// Keys held down at the end of the frame
+		U64  keys[ kNumKeyFields ];
+		// Presses and releases during the frame (saturates at 255)
+		U8   keyPresses[ 0x100 ];
+		U8   keyReleases[ 0x100 ];
+		// Last key pressed during the frame, or 0
+		U8   uLastKey;
+
+		U32  uMouseButtons;
+		U8   mousePresses[ kNumMouseBtns ];
+		U8   mouseReleases[ kNumMouseBtns ];
+		S32  mouseX, mouseY;
+		F32  mouseZ;
+		S32  mouseDeltaX, mouseDeltaY;
+		F32  mouseDeltaZ;
+		Bool mouseInWindow;
+		Bool hasFocus;
+
+		// One bit per ECoreInputAction triggered during the frame
+		U32  uActions;
+
+		inline Bool isKeyDown( EKey key ) const
+		{
+			const U8 i = U8( key );
+			return ( keys[ i/kNumFieldBits ] & ( U64(1)<<( i%kNumFieldBits ) ) ) != 0;
+		}
+		inline Bool wasKeyPressed( EKey key ) const
+		{
+			return keyPresses[ U8( key ) ] != 0;
+		}
+		inline Bool wasKeyReleased( EKey key ) const
+		{
+			return keyReleases[ U8( key ) ] != 0;
+		}
+
+		inline Bool isMouseDown( EMouse button ) const
+		{
+			const U32 i = U32( button );
+			return i > 0 && i <= kNumMouseBtns && ( uMouseButtons & ( 1U<<( i - 1 ) ) ) != 0;
+		}
+		inline Bool wasMousePressed( EMouse button ) const
+		{
+			const U32 i = U32( button );
+			return i > 0 && i <= kNumMouseBtns && mousePresses[ i - 1 ] != 0;
+		}
+		inline Bool wasMouseReleased( EMouse button ) const
+		{
+			const U32 i = U32( button );
+			return i > 0 && i <= kNumMouseBtns && mouseReleases[ i - 1 ] != 0;
+		}
+
+		inline Bool wasActionTriggered( ECoreInputAction act ) const
+		{
+			return ( uActions & ( 1U<<U32( act ) ) ) != 0;
+		}
+	};
+
+	// Sequence number the next event will be written with
+	DOLL_FUNC U64 DOLL_API in_getEventSequence();
+	// Copy events starting at `uInOutSeq` (up to `cMaxEvents`) and advance
+	// `uInOutSeq` past them. Events that were already overwritten are skipped.
+	// Safe to call from any thread.
+	DOLL_FUNC UPtr DOLL_API in_readEvents( SInputEvent *pDstEvents, UPtr cMaxEvents, U64 &uInOutSeq );
+
+	// Retrieve the snapshot for the current update frame
+	//
+	// The returned snapshot is never modified and stays valid for
+	// `kInputSnapshotCount - 1` further frames, so update jobs may read it
+	// concurrently without synchronization.
+	DOLL_FUNC const SInputSnapshot *DOLL_API in_getSnapshot();
+
+	// Start writing every received input event to a file (through the VFS)
+	DOLL_FUNC Bool DOLL_API in_startRecording( Str filename );
+	// Stop recording and close the file
+	DOLL_FUNC Void DOLL_API in_stopRecording();
+	DOLL_FUNC Bool DOLL_API in_isRecording();
+
+	// Replay a recording made with `in_startRecording()`
+	//
+	// Live OS input is ignored while replaying. Replay stops on its own once
+	// the last recorded frame has been injected.
+	DOLL_FUNC Bool DOLL_API in_startReplay( Str filename );
+	DOLL_FUNC Void DOLL_API in_stopReplay();
+	DOLL_FUNC Bool DOLL_API in_isReplaying();
+
+	namespace In
+	{
+
+		// Called by the input callbacks; stamps the event and adds it to the
+		// ring. Returns false if the event should be dropped (live input
+		// arriving during a replay).
+		Bool submitEvent( EInputEvent type, U8 uCode, U32 uMods = 0, S32 x = 0, S32 y = 0, F32 z = 0.0f );
+		// Called at the start of each update frame
+		Void updateFrame();
+
+	}
+
+}
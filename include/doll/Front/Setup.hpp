@@ -19,6 +19,15 @@ namespace doll
 			U32  uFrameLimit         = ~0U;
 			char szAPIs      [ 128 ] = { '\0' };
 
+			// File to capture render API calls to (empty to not capture)
+			char szCapture   [ 256 ] = { '\0' };
+			U32  uCaptureFirstFrame  = 0;
+			U32  cCaptureFrames      = 0;
+
+			// GPU memory textures may take, in megabytes (0 for no limit; see
+			// gfx_setTextureBudget)
+			U32  uTextureBudgetMB    = 0;
+
 			// FIXME: Add adapters
 
 #ifdef DOLL__BUILD
@@ -68,6 +77,21 @@ namespace doll
 			video.uFrameLimit = uFrameLimitFPS;
 			return *this;
 		}
+		// Capture the render API calls of `cFrames` frames (0 for all of
+		// them) starting at `uFirstFrame` to `filename` (see gfx_captureAPI)
+		inline SUserConfig &setCapture( const Str &filename, U32 uFirstFrame = 0, U32 cFrames = 0 )
+		{
+			axstr_cpy( video.szCapture, filename );
+			video.uCaptureFirstFrame = uFirstFrame;
+			video.cCaptureFrames     = cFrames;
+			return *this;
+		}
+		// Limit the GPU memory textures take (0 for no limit)
+		inline SUserConfig &setTextureBudget( U32 cMegabytes )
+		{
+			video.uTextureBudgetMB = cMegabytes;
+			return *this;
+		}
 
 		// Set the render API
 		//
@@ -76,6 +100,7 @@ namespace doll
 		// - "dx", "d3d", or "d3d11"
 		// - "gl", "ogl", or "opengl"
 		// - "vk", or "vulkan"
+		// - "soft", "software", or "headless"
 		// - "d3d12"
 		inline SUserConfig &setRenderAPI( const Str &api )
 		{
@@ -88,6 +113,7 @@ namespace doll
 		// - "dx", "d3d", or "d3d11"
 		// - "gl", "ogl", or "opengl"
 		// - "vk", or "vulkan"
+		// - "soft", "software", or "headless"
 		// - "d3d12"
 		inline SUserConfig &addRenderAPI( const Str &api )
 		{
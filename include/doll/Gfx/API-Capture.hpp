@@ -0,0 +1,157 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+#include "API.hpp"
+
+namespace doll
+{
+
+/*
+===============================================================================
+
+	CAPTURE AND REPLAY
+
+	A capture wraps an IGfxAPI and records the calls made to it for a range
+	of frames into a file (through the VFS): resources, buffer writes,
+	texture uploads, state and draws. Replaying the file on any other API,
+	such as the software renderer, makes the same calls again and times
+	each of them, so a slow frame from somewhere else can be profiled or
+	bisected offline.
+
+	Frames before the range aren't recorded. Instead, the capture remembers
+	the objects alive and the state set up to that point, and starts the
+	file with whatever recreates them (texture contents are kept in memory
+	while waiting; buffer contents are read back from the API). Render
+	targets are recreated with undefined contents, so frames should draw
+	into them before using them.
+
+	Shaders are recorded as passed to createShader(); backends that load
+	the source from the filename need that file present when replaying.
+
+===============================================================================
+*/
+
+// Calls recorded in a capture
+enum EGfxCaptureCall
+{
+	kGfxCapEnd,
+
+	kGfxCapCreateSampler,
+	kGfxCapCreateTexture,
+	kGfxCapCreateLayout,
+	kGfxCapCreateVBuffer,
+	kGfxCapCreateIBuffer,
+	kGfxCapCreateUBuffer,
+	kGfxCapCreateShader,
+	kGfxCapCreateProgram,
+	kGfxCapCreateRenderTarget,
+
+	kGfxCapDestroySampler,
+	kGfxCapDestroyTexture,
+	kGfxCapDestroyLayout,
+	kGfxCapDestroyVBuffer,
+	kGfxCapDestroyIBuffer,
+	kGfxCapDestroyUBuffer,
+	kGfxCapDestroyShader,
+	kGfxCapDestroyProgram,
+	kGfxCapDestroyRenderTarget,
+
+	kGfxCapSetDefaultState,
+	kGfxCapResize,
+	kGfxCapPresent,
+
+	kGfxCapSetProjection,
+	kGfxCapSetModelView,
+	kGfxCapSetScissorEnable,
+	kGfxCapSetTextureEnable,
+	kGfxCapSetBlend,
+	kGfxCapSetScissor,
+	kGfxCapSetViewport,
+
+	kGfxCapSetLayout,
+	kGfxCapBindTexture,
+	kGfxCapBindSampler,
+	kGfxCapBindVBuffer,
+	kGfxCapBindIBuffer,
+	kGfxCapBindInstanceBuffer,
+	kGfxCapBindProgram,
+	kGfxCapUnbindProgram,
+	kGfxCapUpdateProgramBindings,
+	kGfxCapBindRenderTarget,
+
+	kGfxCapClearRect,
+	kGfxCapUpdateTexture,
+	kGfxCapWriteVBuffer,
+	kGfxCapWriteIBuffer,
+	kGfxCapWriteUBuffer,
+	kGfxCapReadVBuffer,
+	kGfxCapReadIBuffer,
+	kGfxCapReadUBuffer,
+	kGfxCapResolveRenderTarget,
+
+	kGfxCapDraw,
+	kGfxCapDrawIndexed,
+	kGfxCapDrawInstanced,
+	kGfxCapDrawIndexedInstanced,
+
+	kNumGfxCaptureCalls
+};
+
+struct SGfxCaptureDesc
+{
+	// File to write the capture to
+	Str filename;
+	// First frame to record (counting frames presented since the capture
+	// began)
+	U32 uFirstFrame;
+	// Number of frames to record (0 to record until the API is finalized)
+	U32 cFrames;
+};
+
+// Time spent in one kind of call while replaying
+struct SGfxReplayCallStats
+{
+	U32 cCalls;
+	U64 uMicrosecs;
+	U64 uMaxMicrosecs;
+};
+struct SGfxReplayStats
+{
+	// Frames presented and calls made
+	U32 cFrames;
+	U32 cCalls;
+	// Time spent in the API, in total and in the slowest frame
+	U64 uMicrosecs;
+	U64 uMaxFrameMicrosecs;
+	// Slowest frame (0 is the first one)
+	U32 uMaxFrame;
+
+	SGfxReplayCallStats calls[kNumGfxCaptureCalls];
+};
+
+// Called after each replayed call, with the time the API took
+typedef Void(DOLL_API *FnGfxReplayCall)(Void *pParm, EGfxCaptureCall call, U32 uFrame, U64 uMicrosecs);
+
+// Start capturing the calls made to `pAPI`
+//
+// Returns the API to use in place of `pAPI`, or `pAPI` itself if the
+// capture couldn't start. gfx_finiAPI() on the returned API finishes the
+// file and finalizes `pAPI`.
+DOLL_FUNC IGfxAPI *DOLL_API gfx_captureAPI(IGfxAPI *pAPI, const SGfxCaptureDesc &desc);
+// The API being captured by `pAPI`, or `pAPI` itself if it isn't a capture
+DOLL_FUNC IGfxAPI *DOLL_API gfx_getCapturedAPI(IGfxAPI *pAPI);
+// Whether `pAPI` is a capture that has written all of its frames
+DOLL_FUNC Bool DOLL_API gfx_isCaptureDone(IGfxAPI *pAPI);
+
+// Make the calls recorded in `filename` on `api`
+//
+// The API should be freshly initialized; objects the capture leaves alive
+// are destroyed at the end. Returns false if the file can't be read or is
+// damaged (the calls before the damage are still made).
+DOLL_FUNC Bool DOLL_API gfx_replayCapture(IGfxAPI &api, Str filename, SGfxReplayStats *pOutStats = nullptr, FnGfxReplayCall pfnCall = nullptr, Void *pParm = nullptr);
+
+// Name of a call (e.g., "DrawIndexed") for reports; a static string
+DOLL_FUNC const char *DOLL_API gfx_getCaptureCallName(EGfxCaptureCall call);
+
+} // namespace doll
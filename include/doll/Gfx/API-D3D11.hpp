@@ -37,6 +37,10 @@ class CGfxAPI_D3D11 : public virtual IGfxAPI
 	virtual IGfxAPITexture *createTexture(ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData) override;
 	virtual Void destroyTexture(IGfxAPITexture *) override;
 
+	virtual IGfxAPIRenderTarget *createRenderTarget(U16 resX, U16 resY) override;
+	virtual Void destroyRenderTarget(IGfxAPIRenderTarget *) override;
+	virtual IGfxAPITexture *getRenderTargetTexture(IGfxAPIRenderTarget *) override;
+
 	virtual IGfxAPIVLayout *createLayout(const SGfxLayout &desc) override;
 	virtual Void destroyLayout(IGfxAPIVLayout *) override;
 
@@ -70,12 +74,15 @@ class CGfxAPI_D3D11 : public virtual IGfxAPI
 	virtual Void tsBindTexture(IGfxAPITexture *, U32 uStage) override;
 	virtual Void tsBindSampler(IGfxAPISampler *, U32 uStage) override;
 	virtual Void iaBindVBuffer(IGfxAPIVBuffer *) override;
-	virtual Void iaBindIBuffer(IGfxAPIIBuffer *) override;
+	virtual Void iaBindIBuffer(IGfxAPIIBuffer *, EIndexFormat) override;
+	virtual Void iaBindInstanceBuffer(IGfxAPIVBuffer *) override;
 
 	virtual Void plBindProgram(IGfxAPIProgram *) override;
 	virtual Void plUnbindProgram() override;
 	virtual Void cmdUpdateProgramBindings(const SGfxBinding &) override;
 
+	virtual Void omBindRenderTarget(IGfxAPIRenderTarget *) override;
+
 	virtual Void cmdClearRect(S32 posX, S32 posY, U32 resX, U32 resY, U32 value) override;
 	virtual Void cmdUpdateTexture(IGfxAPITexture *, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData) override;
 	virtual Void cmdWriteVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, const Void *pData) override;
@@ -84,9 +91,12 @@ class CGfxAPI_D3D11 : public virtual IGfxAPI
 	virtual Void cmdReadVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, Void *pData) override;
 	virtual Void cmdReadIBuffer(IGfxAPIIBuffer *, UPtr offset, UPtr size, Void *pData) override;
 	virtual Void cmdReadUBuffer(IGfxAPIUBuffer *, UPtr offset, UPtr size, Void *pData) override;
+	virtual Void cmdResolveRenderTarget(IGfxAPIRenderTarget *) override;
 
 	virtual Void cmdDraw(ETopology, U32 cVerts, U32 uOffset) override;
 	virtual Void cmdDrawIndexed(ETopology, U32 cIndices, U32 uOffset, U32 uBias) override;
+	virtual Void cmdDrawInstanced(ETopology, U32 cVerts, U32 uOffset, U32 cInstances) override;
+	virtual Void cmdDrawIndexedInstanced(ETopology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances) override;
 
 	static CGfxAPI_D3D11 *init(OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider)
 	{
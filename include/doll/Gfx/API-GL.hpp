@@ -4,6 +4,7 @@
 
 #include "Vertex.hpp"
 #include "API.hpp"
+#include "ShaderCache.hpp"
 
 #if DOLL__USE_GLFW
 struct GLFWwindow;
@@ -13,6 +14,8 @@ namespace doll
 {
 
 struct SGLContext;
+struct SGLRenderTarget;
+struct SGLLayout;
 class CGfxAPI_GL;
 
 DOLL_FUNC CGfxAPI_GL *DOLL_API gfx__api_init_gl(OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider);
@@ -41,6 +44,10 @@ class CGfxAPI_GL : public virtual IGfxAPI
 	virtual IGfxAPITexture *createTexture(ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData) override;
 	virtual Void destroyTexture(IGfxAPITexture *) override;
 
+	virtual IGfxAPIRenderTarget *createRenderTarget(U16 resX, U16 resY) override;
+	virtual Void destroyRenderTarget(IGfxAPIRenderTarget *) override;
+	virtual IGfxAPITexture *getRenderTargetTexture(IGfxAPIRenderTarget *) override;
+
 	virtual IGfxAPIVLayout *createLayout(const SGfxLayout &desc) override;
 	virtual Void destroyLayout(IGfxAPIVLayout *) override;
 
@@ -74,12 +81,15 @@ class CGfxAPI_GL : public virtual IGfxAPI
 	virtual Void tsBindTexture(IGfxAPITexture *, U32 uStage) override;
 	virtual Void tsBindSampler(IGfxAPISampler *, U32 uStage) override;
 	virtual Void iaBindVBuffer(IGfxAPIVBuffer *) override;
-	virtual Void iaBindIBuffer(IGfxAPIIBuffer *) override;
+	virtual Void iaBindIBuffer(IGfxAPIIBuffer *, EIndexFormat) override;
+	virtual Void iaBindInstanceBuffer(IGfxAPIVBuffer *) override;
 
 	virtual Void plBindProgram(IGfxAPIProgram *) override;
 	virtual Void plUnbindProgram() override;
 	virtual Void cmdUpdateProgramBindings(const SGfxBinding &) override;
 
+	virtual Void omBindRenderTarget(IGfxAPIRenderTarget *) override;
+
 	virtual Void cmdClearRect(S32 posX, S32 posY, U32 resX, U32 resY, U32 value) override;
 	virtual Void cmdUpdateTexture(IGfxAPITexture *, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData) override;
 	virtual Void cmdWriteVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, const Void *pData) override;
@@ -88,9 +98,12 @@ class CGfxAPI_GL : public virtual IGfxAPI
 	virtual Void cmdReadVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, Void *pData) override;
 	virtual Void cmdReadIBuffer(IGfxAPIIBuffer *, UPtr offset, UPtr size, Void *pData) override;
 	virtual Void cmdReadUBuffer(IGfxAPIUBuffer *, UPtr offset, UPtr size, Void *pData) override;
+	virtual Void cmdResolveRenderTarget(IGfxAPIRenderTarget *) override;
 
 	virtual Void cmdDraw(ETopology, U32 cVerts, U32 uOffset) override;
 	virtual Void cmdDrawIndexed(ETopology, U32 cIndices, U32 uOffset, U32 uBias) override;
+	virtual Void cmdDrawInstanced(ETopology, U32 cVerts, U32 uOffset, U32 cInstances) override;
+	virtual Void cmdDrawIndexedInstanced(ETopology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances) override;
 
 	static CGfxAPI_GL *init(OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider)
 	{
@@ -103,10 +116,35 @@ class CGfxAPI_GL : public virtual IGfxAPI
 #else
 	SGLContext *const m_pCtx;
 #endif
-	SGfxLayout *m_pCurrLayout;
+	SGLLayout *m_pCurrLayout;
 	U32 m_layoutVBuf;
+	// Buffer bound with iaBindInstanceBuffer() (0 if none)
+	U32 m_instanceVBuf;
+	// Generic attribute arrays enabled for the last layout drawn through its
+	// program (0 while drawing from client arrays)
+	U32 m_cAttribArrays;
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, per iaBindIBuffer()
+	U32 m_indexType;
+	// Render target drawn into (null for the window)
+	SGLRenderTarget *m_pTarget;
+
+	// Linked program binaries (see setCacheDirectory())
+	CShaderCache m_shaderCache;
+	// Whether the driver can hand back program binaries
+	Bool m_bProgramBinaries;
+	// Identifies the driver the binaries came from (0 until first needed)
+	U64 m_uDriverKey;
 
 	Void applyLayout();
+	Void applyLayoutAttribs(U32 vbo);
+	Void disableAttribArrays();
+	S32 fixYPos(S32 y) const;
+	Void drawInstances(ETopology, U32 cCount, U32 uOffset, U32 uBias, Bool bIndexed, U32 cInstances);
+
+	U64 getDriverKey();
+	Bool isProgramCacheEnabled() const;
+	Bool loadProgramBinary(U32 programObj, U64 uKey);
+	Void storeProgramBinary(U32 programObj, U64 uKey);
 };
 
 } // namespace doll
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+#include "Vertex.hpp"
+#include "API.hpp"
+
+namespace doll
+{
+
+/*
+===============================================================================
+
+	SOFTWARE RENDERER
+
+	Renders on the CPU into a framebuffer in memory, so it works without a
+	GPU or a window (CI, benchmarks, servers). It follows the fixed function
+	state the GL backend uses: vertex colors modulated by texture stage 0,
+	the blend equation, scissor and viewport, and the default alpha test.
+
+	Draws are transformed, clipped and set up immediately, then binned into
+	64x64 tiles. The bins are rasterized when the frame is presented or read
+	back (or a texture or render target in use changes), with the tiles split
+	between worker threads; each tile is only ever touched by one thread, so
+	the workers don't need to synchronize. Shading and blending work on four
+	pixels at a time.
+
+	Shaders and programs aren't supported.
+
+===============================================================================
+*/
+
+struct SSoftContext;
+class CGfxAPI_Soft;
+
+// Result of comparing the framebuffer against a reference image
+struct SSoftImageDiff
+{
+	// Whether both images are the same size (nothing is compared if not)
+	Bool bSameSize;
+	// Pixels compared
+	U32 cPixels;
+	// Pixels with a channel further off than the tolerance allows
+	U32 cMismatched;
+	// Largest difference seen in any channel (0-255)
+	U32 uMaxDelta;
+	// Top-left most mismatched pixel (if any)
+	U32 uFirstX;
+	U32 uFirstY;
+};
+
+DOLL_FUNC CGfxAPI_Soft *DOLL_API gfx__api_init_soft(OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider);
+
+class CGfxAPI_Soft : public virtual IGfxAPI
+{
+  public:
+	// Most threads a flush will use
+	static const U32 kMaxThreads = 16;
+
+	CGfxAPI_Soft(IGfxAPIProvider &provider, SSoftContext *pCtx);
+	virtual ~CGfxAPI_Soft();
+
+	virtual EGfxAPI getAPI() const override;
+
+	virtual TArr<EShaderFormat> getSupportedShaderFormats() const override;
+	virtual TArr<EShaderStage> getSupportedShaderStages() const override;
+
+	virtual Void setDefaultState(const Mat4f &proj) override;
+
+	virtual Void resize(U32 uResX, U32 uResY) override;
+	virtual Void getSize(U32 &uResX, U32 &uResY) override;
+
+	virtual Void wsiPresent() override;
+
+	virtual IGfxAPISampler *createSampler(const SGfxSamplerDesc &desc) override;
+	virtual Void destroySampler(IGfxAPISampler *) override;
+
+	virtual IGfxAPITexture *createTexture(ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData) override;
+	virtual Void destroyTexture(IGfxAPITexture *) override;
+
+	virtual IGfxAPIRenderTarget *createRenderTarget(U16 resX, U16 resY) override;
+	virtual Void destroyRenderTarget(IGfxAPIRenderTarget *) override;
+	virtual IGfxAPITexture *getRenderTargetTexture(IGfxAPIRenderTarget *) override;
+
+	virtual IGfxAPIVLayout *createLayout(const SGfxLayout &desc) override;
+	virtual Void destroyLayout(IGfxAPIVLayout *) override;
+
+	virtual IGfxAPIVBuffer *createVBuffer(UPtr cBytes, const Void *pData, EBufferPerformance, EBufferPurpose) override;
+	virtual IGfxAPIIBuffer *createIBuffer(UPtr cBytes, const Void *pData, EBufferPerformance, EBufferPurpose) override;
+	virtual IGfxAPIUBuffer *createUBuffer(UPtr cBytes, const Void *pData, EBufferPerformance, EBufferPurpose) override;
+	virtual Void destroyVBuffer(IGfxAPIVBuffer *) override;
+	virtual Void destroyIBuffer(IGfxAPIIBuffer *) override;
+	virtual Void destroyUBuffer(IGfxAPIUBuffer *) override;
+
+	virtual IGfxAPIShader *createShader(Str filename, EShaderFormat, EShaderStage, UPtr cBytes, const Void *pData, IGfxDiagnostic *) override;
+	virtual IGfxAPIProgram *createProgram(TArr<IGfxAPIShader *> shaders, IGfxDiagnostic *) override;
+	virtual Void destroyShader(IGfxAPIShader *) override;
+	virtual Void destroyProgram(IGfxAPIProgram *) override;
+	virtual Bool setCacheDirectory(Str basePath) override;
+	virtual Str getCacheDirectory() const override;
+	virtual Void invalidateShaderCache() override;
+
+	virtual Void vsSetProjectionMatrix(const F32 *matrix) override;
+	virtual Void vsSetModelViewMatrix(const F32 *matrix) override;
+
+	virtual Void psoSetScissorEnable(Bool enable) override;
+	virtual Void psoSetTextureEnable(Bool enable) override;
+	virtual Void psoSetBlend(EBlendOp, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB) override;
+
+	virtual Void rsSetScissor(S32 posX, S32 posY, U32 resX, U32 resY) override;
+	virtual Void rsSetViewport(S32 posX, S32 posY, U32 resX, U32 resY) override;
+
+	virtual Void iaSetLayout(IGfxAPIVLayout *) override;
+
+	virtual Void tsBindTexture(IGfxAPITexture *, U32 uStage) override;
+	virtual Void tsBindSampler(IGfxAPISampler *, U32 uStage) override;
+	virtual Void iaBindVBuffer(IGfxAPIVBuffer *) override;
+	virtual Void iaBindIBuffer(IGfxAPIIBuffer *, EIndexFormat) override;
+	virtual Void iaBindInstanceBuffer(IGfxAPIVBuffer *) override;
+
+	virtual Void plBindProgram(IGfxAPIProgram *) override;
+	virtual Void plUnbindProgram() override;
+	virtual Void cmdUpdateProgramBindings(const SGfxBinding &) override;
+
+	virtual Void omBindRenderTarget(IGfxAPIRenderTarget *) override;
+
+	virtual Void cmdClearRect(S32 posX, S32 posY, U32 resX, U32 resY, U32 value) override;
+	virtual Void cmdUpdateTexture(IGfxAPITexture *, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData) override;
+	virtual Void cmdWriteVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, const Void *pData) override;
+	virtual Void cmdWriteIBuffer(IGfxAPIIBuffer *, UPtr offset, UPtr size, const Void *pData) override;
+	virtual Void cmdWriteUBuffer(IGfxAPIUBuffer *, UPtr offset, UPtr size, const Void *pData) override;
+	virtual Void cmdReadVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, Void *pData) override;
+	virtual Void cmdReadIBuffer(IGfxAPIIBuffer *, UPtr offset, UPtr size, Void *pData) override;
+	virtual Void cmdReadUBuffer(IGfxAPIUBuffer *, UPtr offset, UPtr size, Void *pData) override;
+	virtual Void cmdResolveRenderTarget(IGfxAPIRenderTarget *) override;
+
+	virtual Void cmdDraw(ETopology, U32 cVerts, U32 uOffset) override;
+	virtual Void cmdDrawIndexed(ETopology, U32 cIndices, U32 uOffset, U32 uBias) override;
+	virtual Void cmdDrawInstanced(ETopology, U32 cVerts, U32 uOffset, U32 cInstances) override;
+	virtual Void cmdDrawIndexedInstanced(ETopology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances) override;
+
+	// Finish all pending rendering and return the framebuffer: getSize()
+	// pixels, top row first, each a DOLL_RGBA() value (R,G,B,A in memory)
+	const U32 *readback();
+	// Finish all pending rendering and save the framebuffer as a PNG
+	Bool writePNG(Str filename);
+
+	// Finish all pending rendering and compare the framebuffer against
+	// `pPixels` (laid out as with readback()); a channel may differ by up to
+	// `uTolerance` before the pixel counts as mismatched. Returns true if the
+	// images match.
+	Bool compareImage(const U32 *pPixels, U32 uResX, U32 uResY, U32 uTolerance, SSoftImageDiff &outDiff);
+	// As compareImage(), against an image file (e.g., a golden image saved by
+	// writePNG()); nothing is compared if the file couldn't be loaded
+	Bool compareImageFile(Str filename, U32 uTolerance, SSoftImageDiff &outDiff);
+
+	// Number of threads used to rasterize (0 for the default; the calling
+	// thread counts as one)
+	Void setThreadCount(U32 cThreads);
+	U32 getThreadCount() const;
+
+	// Number of frames presented so far
+	U32 getFrameCount() const;
+
+	static CGfxAPI_Soft *init(OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider)
+	{
+		return gfx__api_init_soft(wnd, desc, provider);
+	}
+
+  private:
+	SSoftContext *const m_pCtx;
+
+	// Rasterize everything binned so far
+	Void flush();
+};
+
+// The software renderer behind `pAPI`, or null if `pAPI` is another API
+DOLL_FUNC CGfxAPI_Soft *DOLL_API gfx_getSoftAPI(IGfxAPI *pAPI);
+
+} // namespace doll
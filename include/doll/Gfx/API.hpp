@@ -26,6 +26,7 @@ class IGfxAPIUBuffer;
 class IGfxAPIShader;
 class IGfxAPIProgram;
 class IGfxAPIBindings;
+class IGfxAPIRenderTarget;
 
 enum EGfxAPI
 {
@@ -61,7 +62,12 @@ enum EVectorType
 	kVectorTypeS32,
 	kVectorTypeF32,
 	kVectorTypeF32_SNorm,
-	kVectorTypeF32_UNorm
+	kVectorTypeF32_UNorm,
+	// Half-precision float (see F16)
+	kVectorTypeF16,
+	// U16 read as 0.0 to 1.0 wherever it's used (plain U16 is only
+	// normalized for colors)
+	kVectorTypeU16_UNorm
 };
 
 enum EBufferPerformance
@@ -76,6 +82,11 @@ enum EBufferPurpose
 	kBufferPurposeRead,
 	kBufferPurposeCopy
 };
+enum EIndexFormat
+{
+	kIndexFormatU16,
+	kIndexFormatU32
+};
 enum EAccess
 {
 	kAccessNone = 0x0,
@@ -135,7 +146,12 @@ enum EGfxLayoutElement
 	kGfxLayoutElementVertex,
 	kGfxLayoutElementNormal,
 	kGfxLayoutElementColor,
-	kGfxLayoutElementTexCoord
+	kGfxLayoutElementTexCoord,
+	// Rectangles ( x1, y1, x2, y2 ) of quads, usually per-instance; each
+	// vertex's position is then a corner (0 or 1 on each axis) picking its
+	// place within them (see gfx_r_layoutVertexRect())
+	kGfxLayoutElementVertexRect,
+	kGfxLayoutElementTexCoordRect
 };
 enum
 {
@@ -260,11 +276,18 @@ struct SGfxLayoutElement
 
 	UPtr uOffset;
 	UPtr cBytes;
+
+	// 0 for per-vertex data (read from the vertex buffer); otherwise the
+	// element is per-instance data (read from the instance buffer), moving
+	// on to the next record every `uStepRate` instances
+	U32 uStepRate;
 };
 
 struct SGfxLayout : public TPoolObject<SGfxLayout, kTag_RenderMisc>
 {
 	UPtr stride;
+	// Size of a record in the instance buffer (per-instance elements only)
+	UPtr instanceStride;
 	UPtr cElements;
 	SGfxLayoutElement elements[kMaxLayoutElements];
 
@@ -376,9 +399,21 @@ class IGfxDiagnostic
 	virtual Void diagnostic(Str filename, U32 line, U32 column, Str message) = 0;
 };
 
+// How many state changes made through a frame reached the backend
+struct SGfxStateStats
+{
+	// Changes passed on to the backend
+	U32 cIssued;
+	// Changes dropped because the backend already had that state
+	U32 cElided;
+};
+
 class CGfxFrame : public TPoolObject<CGfxFrame, kTag_RenderMisc>
 {
   public:
+	// Texture stages whose bindings are tracked (others are always passed on)
+	static const U32 kMaxTrackedTexStages = 8;
+
 	CGfxFrame(IGfxAPI &ctx);
 	~CGfxFrame();
 
@@ -398,7 +433,89 @@ class CGfxFrame : public TPoolObject<CGfxFrame, kTag_RenderMisc>
 	Void finiLayout(SGfxLayout *);
 	IGfxAPIVLayout *compileLayout(const SGfxLayout &);
 
+	// State changes; each is only passed on to the backend if it differs
+	// from what was last passed on
+	Void setProjection(const F32 *matrix);
+	Void setModelView(const F32 *matrix);
+	Void setScissorEnable(Bool enable);
+	Void setScissor(S32 posX, S32 posY, U32 resX, U32 resY);
+	Void setViewport(S32 posX, S32 posY, U32 resX, U32 resY);
+	Void setBlend(EBlendOp, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB);
+	// Blend state last passed on (false if it isn't known)
+	Bool getBlend(EBlendOp &, EBlendFactor &colA, EBlendFactor &colB, EBlendFactor &alphaA, EBlendFactor &alphaB) const;
+	Void setTextureEnable(Bool enable);
+	Void setTexture(IGfxAPITexture *, U32 uStage);
+	Void setVBuffer(IGfxAPIVBuffer *);
+	Void setIBuffer(IGfxAPIIBuffer *, EIndexFormat);
+	Void setInstanceBuffer(IGfxAPIVBuffer *);
+
+	// Forget the backend's state, so the next change of each kind is passed
+	// on (call after anything that changes the backend's state behind the
+	// frame's back)
+	Void invalidateState();
+	// Forget bindings of an object about to be destroyed or created (the
+	// backend may reuse the handle, or bind the new object)
+	Void forgetTexture(IGfxAPITexture *);
+	Void forgetVBuffer(IGfxAPIVBuffer *);
+	Void forgetIBuffer(IGfxAPIIBuffer *);
+
+	// Draw into `pTarget` (null for the window)
+	//
+	// The frame's position (originX, originY) lands on the target's top
+	// left; positions given to setViewport(), setScissor() and clearRect()
+	// stay in frame pixels. While a target is bound, alpha is blended as
+	// coverage (see setBlend()), so the target ends up premultiplied.
+	Void setRenderTarget(IGfxAPIRenderTarget *pTarget, S32 originX = 0, S32 originY = 0);
+	inline IGfxAPIRenderTarget *getRenderTarget() const { return m_pTarget; }
+	inline S32 getRenderTargetOriginX() const { return m_targetOrigin[0]; }
+	inline S32 getRenderTargetOriginY() const { return m_targetOrigin[1]; }
+	Void clearRect(S32 posX, S32 posY, U32 resX, U32 resY, U32 value);
+
+	// Counts for the last presented frame, and for the one in progress
+	inline const SGfxStateStats &getStateStats() const { return m_lastStats; }
+	inline const SGfxStateStats &getCurrentStateStats() const { return m_stats; }
+
   private:
+	// Bits of `SShadowState::uKnown`
+	enum : U32 {
+		kShadow_Projection = 1 << 0,
+		kShadow_ModelView = 1 << 1,
+		kShadow_ScissorEnable = 1 << 2,
+		kShadow_Scissor = 1 << 3,
+		kShadow_Viewport = 1 << 4,
+		kShadow_Blend = 1 << 5,
+		kShadow_TextureEnable = 1 << 6,
+		kShadow_VBuffer = 1 << 7,
+		kShadow_IBuffer = 1 << 8,
+		kShadow_Layout = 1 << 9,
+		kShadow_InstanceBuffer = 1 << 10
+	};
+
+	// State last passed on to the backend (only meaningful where known)
+	struct SShadowState
+	{
+		U32 uKnown;
+		// Bit per texture stage
+		U32 uKnownTextures;
+		// Set once a stage other than 0 is bound; the GL backend's texture
+		// enable follows the active stage, so it's no longer tracked
+		Bool bMultiTexture;
+
+		F32 projection[16];
+		F32 modelView[16];
+		Bool bScissor;
+		S32 scissor[4];
+		S32 viewport[4];
+		EBlendOp blendOp;
+		EBlendFactor blendFactors[4];
+		Bool bTexture;
+		IGfxAPITexture *pTextures[kMaxTrackedTexStages];
+		IGfxAPIVBuffer *pVBuffer;
+		IGfxAPIIBuffer *pIBuffer;
+		EIndexFormat indexFormat;
+		IGfxAPIVBuffer *pInstanceBuffer;
+	};
+
 	IGfxAPI &m_context;
 	U32 m_uResX, m_uResY;
 	Mat4f m_proj2D;
@@ -407,6 +524,15 @@ class CGfxFrame : public TPoolObject<CGfxFrame, kTag_RenderMisc>
 	UPtr m_cVBufBytes;
 
 	SGfxLayout *m_pLayout;
+
+	IGfxAPIRenderTarget *m_pTarget;
+	S32 m_targetOrigin[2];
+
+	SShadowState m_shadow;
+	SGfxStateStats m_stats;
+	SGfxStateStats m_lastStats;
+
+	Bool isRedundant(U32 uBit, Bool bSame);
 };
 
 class IGfxAPI
@@ -440,6 +566,14 @@ class IGfxAPI
 	virtual IGfxAPITexture *createTexture(ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData) = 0;
 	virtual Void destroyTexture(IGfxAPITexture *) = 0;
 
+	// Offscreen RGBA8 color buffer to draw into (null if unsupported); its
+	// contents start out undefined
+	virtual IGfxAPIRenderTarget *createRenderTarget(U16 resX, U16 resY) = 0;
+	virtual Void destroyRenderTarget(IGfxAPIRenderTarget *) = 0;
+	// Texture showing what cmdResolveRenderTarget() last copied out of the
+	// target, top row first (owned by the target; don't destroy it)
+	virtual IGfxAPITexture *getRenderTargetTexture(IGfxAPIRenderTarget *) = 0;
+
 	virtual IGfxAPIVLayout *createLayout(const SGfxLayout &desc) = 0;
 	virtual Void destroyLayout(IGfxAPIVLayout *) = 0;
 
@@ -473,12 +607,18 @@ class IGfxAPI
 	virtual Void tsBindTexture(IGfxAPITexture *, U32 uStage) = 0;
 	virtual Void tsBindSampler(IGfxAPISampler *, U32 uStage) = 0;
 	virtual Void iaBindVBuffer(IGfxAPIVBuffer *) = 0;
-	virtual Void iaBindIBuffer(IGfxAPIIBuffer *) = 0;
+	virtual Void iaBindIBuffer(IGfxAPIIBuffer *, EIndexFormat) = 0;
+	// Buffer the layout's per-instance elements are read from
+	virtual Void iaBindInstanceBuffer(IGfxAPIVBuffer *) = 0;
 
 	virtual Void plBindProgram(IGfxAPIProgram *) = 0;
 	virtual Void plUnbindProgram() = 0;
 	virtual Void cmdUpdateProgramBindings(const SGfxBinding &) = 0;
 
+	// Draw into `pTarget` instead of the window (null for the window);
+	// viewport and scissor positions are then relative to the target
+	virtual Void omBindRenderTarget(IGfxAPIRenderTarget *) = 0;
+
 	virtual Void cmdClearRect(S32 posX, S32 posY, U32 resX, U32 resY, U32 value) = 0;
 	virtual Void cmdUpdateTexture(IGfxAPITexture *, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData) = 0;
 	virtual Void cmdWriteVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, const Void *pData) = 0;
@@ -487,9 +627,15 @@ class IGfxAPI
 	virtual Void cmdReadVBuffer(IGfxAPIVBuffer *, UPtr offset, UPtr size, Void *pData) = 0;
 	virtual Void cmdReadIBuffer(IGfxAPIIBuffer *, UPtr offset, UPtr size, Void *pData) = 0;
 	virtual Void cmdReadUBuffer(IGfxAPIUBuffer *, UPtr offset, UPtr size, Void *pData) = 0;
+	// Copy what has been drawn into the target to its texture
+	virtual Void cmdResolveRenderTarget(IGfxAPIRenderTarget *) = 0;
 
 	virtual Void cmdDraw(ETopology, U32 cVerts, U32 uOffset) = 0;
 	virtual Void cmdDrawIndexed(ETopology, U32 cIndices, U32 uOffset, U32 uBias) = 0;
+	// Draw `cInstances` copies, each reading its own per-instance data
+	// (non-instanced draws read that of instance 0)
+	virtual Void cmdDrawInstanced(ETopology, U32 cVerts, U32 uOffset, U32 cInstances) = 0;
+	virtual Void cmdDrawIndexedInstanced(ETopology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances) = 0;
 };
 
 class IGfxAPIProvider
@@ -517,6 +663,8 @@ inline UPtr gfx_r_calcSize(EVectorSize n, EVectorType t)
 
 	case kVectorTypeU16:
 	case kVectorTypeS16:
+	case kVectorTypeF16:
+	case kVectorTypeU16_UNorm:
 		baseSize = 2;
 		break;
 
@@ -552,6 +700,9 @@ DOLL_FUNC NullPtr DOLL_API gfx_finiAPI(IGfxAPI *);
 DOLL_FUNC Void DOLL_API gfx_r_setFrame(CGfxFrame *pFrame);
 DOLL_FUNC CGfxFrame *DOLL_API gfx_r_getFrame();
 
+DOLL_FUNC Void DOLL_API gfx_r_invalidateState();
+DOLL_FUNC Void DOLL_API gfx_r_getStateStats(SGfxStateStats &outStats);
+
 DOLL_FUNC U32 DOLL_API gfx_r_resX();
 DOLL_FUNC U32 DOLL_API gfx_r_resY();
 
@@ -568,22 +719,41 @@ DOLL_FUNC Void DOLL_API gfx_r_setViewport(S32 posX, S32 posY, U32 resX, U32 resY
 DOLL_FUNC UPtr DOLL_API gfx_r_createTexture(ETextureFormat fmt, U16 resX, U16 resY, const U8 *data);
 DOLL_FUNC Void DOLL_API gfx_r_destroyTexture(UPtr tex);
 
-DOLL_FUNC Void DOLL_API gfx_r_updateTexture(UPtr tex, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *data);
+// `fmt` is the format `tex` was created with (which `data` is in)
+DOLL_FUNC Void DOLL_API gfx_r_updateTexture(UPtr tex, ETextureFormat fmt, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *data);
+
+// Offscreen color buffers (0 if the API has none; see CGfxFrame::setRenderTarget())
+DOLL_FUNC UPtr DOLL_API gfx_r_createRenderTarget(U16 resX, U16 resY);
+DOLL_FUNC Void DOLL_API gfx_r_destroyRenderTarget(UPtr rt);
+DOLL_FUNC Void DOLL_API gfx_r_setRenderTarget(UPtr rt, S32 originX = 0, S32 originY = 0);
+DOLL_FUNC UPtr DOLL_API gfx_r_getRenderTarget(S32 *pOutOriginX = nullptr, S32 *pOutOriginY = nullptr);
+// Copy what has been drawn into `rt` to its texture, returning the texture
+DOLL_FUNC UPtr DOLL_API gfx_r_resolveRenderTarget(UPtr rt);
+DOLL_FUNC UPtr DOLL_API gfx_r_getRenderTargetTexture(UPtr rt);
 
 DOLL_FUNC Void DOLL_API gfx_r_setBlend(EBlendOp, EBlendFactor srgb, EBlendFactor drgb, EBlendFactor sa, EBlendFactor da);
+// Blend state last set; false (with the default blend) if it isn't known
+DOLL_FUNC Bool DOLL_API gfx_r_getBlend(EBlendOp *op, EBlendFactor *srgb, EBlendFactor *drgb, EBlendFactor *sa, EBlendFactor *da);
 
 DOLL_FUNC Void DOLL_API gfx_r_enableTexture2D();
 DOLL_FUNC Void DOLL_API gfx_r_disableTexture2D();
 
 DOLL_FUNC Void DOLL_API gfx_r_setTexture(UPtr tex, U32 stage = 0);
 
-DOLL_FUNC UPtr DOLL_API gfx_r_createLayout(UPtr stride = 0);
+DOLL_FUNC UPtr DOLL_API gfx_r_createLayout(UPtr stride = 0, UPtr instanceStride = 0);
 DOLL_FUNC Void DOLL_API gfx_r_destroyLayout(UPtr layout);
 
-DOLL_FUNC Void DOLL_API gfx_r_layoutVertex(UPtr layout, EVectorSize size, EVectorType type = kVectorTypeF32, UPtr offset = ~0U);
-DOLL_FUNC Void DOLL_API gfx_r_layoutNormal(UPtr layout, EVectorType type = kVectorTypeF32, UPtr offset = ~0U);
-DOLL_FUNC Void DOLL_API gfx_r_layoutColor(UPtr layout, EVectorSize size = kVectorSize4, EVectorType type = kVectorTypeU8, UPtr offset = ~0U);
-DOLL_FUNC Void DOLL_API gfx_r_layoutTexCoord(UPtr layout, EVectorSize size = kVectorSize2, EVectorType type = kVectorTypeF32, UPtr offset = ~0U);
+// A nonzero `uStepRate` makes the element per-instance (see SGfxLayoutElement)
+DOLL_FUNC Void DOLL_API gfx_r_layoutVertex(UPtr layout, EVectorSize size, EVectorType type = kVectorTypeF32, UPtr offset = ~0U, U32 uStepRate = 0);
+DOLL_FUNC Void DOLL_API gfx_r_layoutNormal(UPtr layout, EVectorType type = kVectorTypeF32, UPtr offset = ~0U, U32 uStepRate = 0);
+DOLL_FUNC Void DOLL_API gfx_r_layoutColor(UPtr layout, EVectorSize size = kVectorSize4, EVectorType type = kVectorTypeU8, UPtr offset = ~0U, U32 uStepRate = 0);
+DOLL_FUNC Void DOLL_API gfx_r_layoutTexCoord(UPtr layout, EVectorSize size = kVectorSize2, EVectorType type = kVectorTypeF32, UPtr offset = ~0U, U32 uStepRate = 0);
+// Quads from one record each: the layout's position picks a corner of the
+// rectangle ( x1, y1, x2, y2 ) for each vertex, taking x1 where it's 0 and x2
+// where it's 1 (y likewise); the texture rectangle does the same for the next
+// texture stage's coordinates
+DOLL_FUNC Void DOLL_API gfx_r_layoutVertexRect(UPtr layout, EVectorType type = kVectorTypeF32, UPtr offset = ~0U, U32 uStepRate = 1);
+DOLL_FUNC Void DOLL_API gfx_r_layoutTexCoordRect(UPtr layout, EVectorType type = kVectorTypeF32, UPtr offset = ~0U, U32 uStepRate = 1);
 DOLL_FUNC Bool DOLL_API gfx_r_finishLayout(UPtr layout);
 
 DOLL_FUNC Void DOLL_API gfx_r_setLayout(UPtr layout);
@@ -606,7 +776,8 @@ DOLL_FUNC Void DOLL_API gfx_r_destroyIBuffer(UPtr ibuffer);
 DOLL_FUNC Void DOLL_API gfx_r_destroyUBuffer(UPtr ubuffer);
 
 DOLL_FUNC Void DOLL_API gfx_r_setVBuffer(UPtr vbuffer);
-DOLL_FUNC Void DOLL_API gfx_r_setIBuffer(UPtr ibuffer);
+DOLL_FUNC Void DOLL_API gfx_r_setIBuffer(UPtr ibuffer, EIndexFormat fmt = kIndexFormatU16);
+DOLL_FUNC Void DOLL_API gfx_r_setInstanceBuffer(UPtr vbuffer);
 
 DOLL_FUNC Void DOLL_API gfx_r_bindProgram(UPtr program);
 DOLL_FUNC Void DOLL_API gfx_r_unbindProgram();
@@ -614,6 +785,8 @@ DOLL_FUNC Void DOLL_API gfx_r_updateProgramBindings(const SGfxBinding &);
 
 DOLL_FUNC Void DOLL_API gfx_r_draw(ETopology mode, U32 cVerts, U32 uOffset = 0);
 DOLL_FUNC Void DOLL_API gfx_r_drawIndexed(ETopology mode, U32 cIndices, U32 uOffset = 0, U32 uBias = 0);
+DOLL_FUNC Void DOLL_API gfx_r_drawInstanced(ETopology mode, U32 cVerts, U32 cInstances, U32 uOffset = 0);
+DOLL_FUNC Void DOLL_API gfx_r_drawIndexedInstanced(ETopology mode, U32 cIndices, U32 cInstances, U32 uOffset = 0, U32 uBias = 0);
 DOLL_FUNC Void DOLL_API gfx_r_drawMem(ETopology mode, U32 cVerts, UPtr cStrideBytes, const void *pMem);
 
 } // namespace doll
@@ -23,6 +23,10 @@
 # endif
 #endif
 
+#ifndef DOLL_GFX_SOFTWARE_ENABLED
+# define DOLL_GFX_SOFTWARE_ENABLED 1
+#endif
+
 // OpenGL API
 #if DOLL_GFX_OPENGL_ENABLED
 DOLL_GFX__API(OpenGL, GL)
@@ -33,6 +37,11 @@ DOLL_GFX__API(OpenGL, GL)
 DOLL_GFX__API(Direct3D11, D3D11)
 #endif
 
+// Software renderer (no GPU or window needed)
+#if DOLL_GFX_SOFTWARE_ENABLED
+DOLL_GFX__API(Software, Soft)
+#endif
+
 #ifdef DOLL_GFX__UNDEF__API
 # undef DOLL_GFX__UNDEF__API
 # undef DOLL_GFX__API
@@ -3,6 +3,7 @@
 #include "../Core/Defs.hpp"
 #include "../Core/Memory.hpp"
 #include "../Core/MemoryTags.hpp"
+#include "../Core/Handle.hpp"
 
 #include "../Math/IntVector2.hpp"
 #include "../Math/Rect.hpp"
@@ -25,6 +26,9 @@ namespace doll
 
 	typedef ax::TList< ILayerEffect * > LayerEffectList;
 
+	typedef THandleTable< RLayer, kTag_Layer > LayerTable;
+	typedef LayerTable::Handle HLayer;
+
 	class CGfxFrame;
 	
 	enum ELayout : U32
@@ -216,7 +220,7 @@ namespace doll
 	
 	//--------------------------------------------------------------------//
 
-	class RLayer: public TPoolObject< RLayer, kTag_Layer >
+	class RLayer: public TPoolObject< RLayer, kTag_Layer, LayerTable >
 	{
 	friend class MLayers;
 	public:
@@ -289,6 +293,12 @@ namespace doll
 			PrimitiveBuffer    primitives;
 			// Stored text data (for text rendering commands)
 			MutStr             textBuffer;
+			// Render target holding the layer when cached as a texture (0 if
+			// none yet), and the viewport it was drawn for
+			UPtr               cacheTarget;
+			SRect              cacheShape;
+			// Whether the cached texture needs to be drawn again
+			Bool               bCacheDirty;
 
 			SRenderer();
 			Void reset();
@@ -301,6 +311,9 @@ namespace doll
 			Bool   bIsVisible;
 			// Controls whether the command/primitive buffers are cleared after rendering
 			Bool   bAutoclear;
+			// Whether the layer (and its children) are drawn once into a texture,
+			// which is then drawn instead until invalidated
+			Bool   bCacheAsTexture;
 			// Name assigned by user (good for debugging)
 			MutStr name;
 
@@ -386,8 +399,23 @@ namespace doll
 		Void setVisible( Bool bVisible = true );
 		Bool isVisible() const;
 
+		inline HLayer getHandle() const
+		{
+			return getPool().handleOf( this );
+		}
+		static inline RLayer *fromHandle( HLayer h )
+		{
+			return getPool().get( h );
+		}
+
 		Void setAutoclear( Bool bAutoclear = true );
 		Bool getAutoclear() const;
+
+		Void setCacheAsTexture( Bool bCache = true );
+		Bool getCacheAsTexture() const;
+		// Draw the cached texture again on the next render (call whenever
+		// anything the layer or its children show has changed)
+		Void invalidateCache();
 		
 		Void setUserPointer( Void *pUserData );
 		Void *getUserPointer() const;
@@ -437,6 +465,10 @@ namespace doll
 		SProperties					m_Properties;
 		
 		Void renderGroupsGL( detail::SGroupList &List, CGfxFrame *pFrame );
+		Void renderContentsGL( MLayers::SRenderer &Renderer, CGfxFrame *pFrame, const SViewport &VP );
+		Bool updateCacheGL( MLayers::SRenderer &Renderer, CGfxFrame *pFrame, const SViewport &VP );
+		Void drawCacheGL( const SViewport &VP );
+		Void freeCache();
 		Void reflowWithin( const SRect &Host );
 
 		RLayer( const RLayer & ) AX_DELETE_FUNC;
@@ -502,6 +534,12 @@ namespace doll
 	inline Void RLayer::SRenderer::reset()
 	{
 		pFrame = nullptr;
+		cacheTarget = 0;
+		cacheShape.x1 = 0;
+		cacheShape.y1 = 0;
+		cacheShape.x2 = 0;
+		cacheShape.y2 = 0;
+		bCacheDirty = true;
 	}
 
 	inline RLayer::SProperties::SProperties()
@@ -513,6 +551,7 @@ namespace doll
 		pUserPointer = nullptr;
 		bIsVisible = true;
 		bAutoclear = false;
+		bCacheAsTexture = false;
 	}
 	
 	inline const RLayer::SHierarchy &RLayer::hierarchy() const
@@ -833,6 +872,14 @@ namespace doll
 	DOLL_FUNC Void DOLL_API gfx_toggleLayerAutoclear( RLayer *layer );
 	DOLL_FUNC Bool DOLL_API gfx_isLayerAutoclearEnabled( const RLayer *layer );
 
+	// Draw the layer and its children into a texture once, then draw just the
+	// texture until gfx_invalidateLayerCache() is called (or the layer's
+	// viewport changes); for layers that rarely change
+	DOLL_FUNC Void DOLL_API gfx_enableLayerCache( RLayer *layer );
+	DOLL_FUNC Void DOLL_API gfx_disableLayerCache( RLayer *layer );
+	DOLL_FUNC Bool DOLL_API gfx_isLayerCacheEnabled( const RLayer *layer );
+	DOLL_FUNC Void DOLL_API gfx_invalidateLayerCache( RLayer *layer );
+
 	DOLL_FUNC Void DOLL_API gfx_moveLayerTop( RLayer *layer );
 	DOLL_FUNC Void DOLL_API gfx_moveLayerBottom( RLayer *layer );
 
@@ -849,4 +896,22 @@ namespace doll
 	DOLL_FUNC F32 DOLL_API gfx_getLayerAspectRatio( const RLayer *pLayer );
 	DOLL_FUNC EAspect DOLL_API gfx_getLayerAspectMode( const RLayer *pLayer );
 
+	// Handle-based variants; a deleted layer's handle resolves to nullptr
+	DOLL_FUNC HLayer DOLL_API gfx_getLayerHandle( const RLayer *layer );
+	DOLL_FUNC RLayer *DOLL_API gfx_getLayerFromHandle( HLayer layer );
+	DOLL_FUNC Bool DOLL_API gfx_isLayerHandleValid( HLayer layer );
+	DOLL_FUNC U32 DOLL_API gfx_getLiveLayerCount();
+
+	DOLL_FUNC HLayer DOLL_API gfx_newLayerHandle();
+	DOLL_FUNC HLayer DOLL_API gfx_deleteLayerByHandle( HLayer layer );
+
+	DOLL_FUNC Void DOLL_API gfx_setLayerParentByHandle( HLayer layer, HLayer parent );
+	DOLL_FUNC HLayer DOLL_API gfx_getLayerParentByHandle( HLayer layer );
+	DOLL_FUNC Void DOLL_API gfx_setLayerVisibleByHandle( HLayer layer, Bool visible );
+	DOLL_FUNC Bool DOLL_API gfx_getLayerVisibleByHandle( HLayer layer );
+	DOLL_FUNC Void DOLL_API gfx_setLayerPositionByHandle( HLayer layer, S32 x, S32 y );
+	DOLL_FUNC Void DOLL_API gfx_setLayerSizeByHandle( HLayer layer, S32 w, S32 h );
+	DOLL_FUNC Void DOLL_API gfx_addLayerPrerenderSpriteGroupByHandle( HLayer layer, RSpriteGroup *group );
+	DOLL_FUNC Void DOLL_API gfx_addLayerPostrenderSpriteGroupByHandle( HLayer layer, RSpriteGroup *group );
+
 }
@@ -29,4 +29,13 @@ namespace doll
 
 	DOLL_FUNC void DOLL_API gfx_measureOSText( Str text, SRect &dstArea );
 
+	// Text drawn with `gfx_drawOSText()` is cached as textures (least recently
+	// used first out) until they take up more than this many bytes
+	DOLL_FUNC Void DOLL_API gfx_setOSTextCacheBudget( UPtr cBytes );
+	DOLL_FUNC UPtr DOLL_API gfx_getOSTextCacheBudget();
+
+	// (Internal) Release the textures OS text holds (cached runs and glyph
+	// pages); the engine calls this before finalizing the render API
+	DOLL_FUNC Void DOLL_API gfx__ostext_fini();
+
 }
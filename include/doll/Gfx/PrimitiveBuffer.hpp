@@ -163,6 +163,15 @@ namespace doll
 
 		EResult addVertices( const Vertex *verts, UPtr numVerts );
 
+		// Whether a position fits kVF_PosS16 (whole pixels in range) or
+		// kVF_PosF16 (within 1/32 of a pixel), and whether texture
+		// coordinates fit kVF_TexUNorm16 (0 to 1); see submitCompact()
+		static Bool fitsPosS16( F32 x, F32 y );
+		static Bool fitsPosF16( F32 x, F32 y );
+		static Bool fitsTexUNorm16( F32 u, F32 v );
+		// Nearest UNORM16 value (0 to 65535) to `x` (0 to 1)
+		static U16 packUNorm16( F32 x );
+
 		inline void setOffset( F32 x, F32 y )
 		{
 			offsetX = x;
@@ -198,6 +207,11 @@ namespace doll
 		{
 			return ( Vertex * )&buffer[ size ];
 		}
+
+		// Draw the first `cVerts` vertices in the smallest compact format
+		// (see kVF_PosS16) they all fit; returns false, leaving the buffer as
+		// it was, if there's none or the API can't take it
+		Bool submitCompact( U32 cVerts );
 		inline EResult submitFullBuffer()
 		{
 			if( !isBufferFull() ) {
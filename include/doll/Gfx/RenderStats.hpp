@@ -0,0 +1,194 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+namespace doll
+{
+
+	class RLayer;
+	class RSpriteGroup;
+
+	/*
+	===============================================================================
+
+		RENDER STATISTICS
+		Counts the work each frame hands the render API (draws, vertices, state
+		changes, texture binds and uploads), split up by the layer and sprite
+		group that caused it
+
+		Counting happens in the `gfx_r_*` wrappers, so work done by calling an
+		IGfxAPI directly isn't seen. A frame ends whenever one is presented.
+		Statistics are off until `gfx_enableRenderStats()` is called.
+
+	===============================================================================
+	*/
+
+	struct SGfxRenderCounters
+	{
+		// Draw calls (including `gfx_r_drawMem()`)
+		U32 cDraws;
+		// Vertices drawn (indices for indexed draws, times the number of
+		// instances for instanced draws)
+		U32 cVertices;
+		// State changes passed on to the API, and dropped as redundant
+		U32 cStateChanges;
+		U32 cElidedStateChanges;
+		// Texture binds passed on to the API
+		U32 cTextureBinds;
+		// Bytes written to vertex buffers (including `gfx_r_drawMem()`)
+		U64 cVBufferBytes;
+		// Bytes of texels uploaded (creating or updating textures)
+		U64 cTextureBytes;
+	};
+
+	// Work done while a given layer or sprite group was rendering
+	struct SGfxRenderScopeStats
+	{
+		// Layer being rendered, or null outside of any layer
+		//
+		// Only for telling scopes apart; the layer may be gone by the time
+		// the statistics are read, so don't dereference it
+		const RLayer *      pLayer;
+		// Sprite group being rendered, or null (same caveat as above)
+		const RSpriteGroup *pGroup;
+		// Name of the layer when the frame was rendered (may be cut short)
+		char                szLayerName[ 32 ];
+
+		SGfxRenderCounters  counters;
+	};
+
+	struct SGfxRenderFrameStats
+	{
+		// Frames presented before this one since statistics were enabled
+		U32                uFrame;
+		// Number of scopes (see `gfx_getRenderStatsScope()`)
+		U32                cScopes;
+		// Everything done in the frame
+		SGfxRenderCounters total;
+	};
+
+	// Start counting, keeping the last `cHistoryFrames` frames
+	DOLL_FUNC Bool DOLL_API gfx_enableRenderStats( U32 cHistoryFrames = 120 );
+	// Stop counting and free the history
+	DOLL_FUNC Void DOLL_API gfx_disableRenderStats();
+	DOLL_FUNC Bool DOLL_API gfx_areRenderStatsEnabled();
+
+	// Number of finished frames in the history
+	DOLL_FUNC U32 DOLL_API gfx_getRenderStatsFrameCount();
+	// Statistics of a finished frame (0 is the last one presented, 1 the one
+	// before, and so on)
+	DOLL_FUNC Bool DOLL_API gfx_getRenderStatsFrame( SGfxRenderFrameStats &dst, U32 uFramesAgo = 0 );
+	DOLL_FUNC Bool DOLL_API gfx_getRenderStatsScope( SGfxRenderScopeStats &dst, U32 uScope, U32 uFramesAgo = 0 );
+	// Sum of every scope of `pLayer` in a finished frame (its sprite groups
+	// included, its child layers not)
+	DOLL_FUNC Bool DOLL_API gfx_getLayerRenderStats( SGfxRenderCounters &dst, const RLayer *pLayer, U32 uFramesAgo = 0 );
+
+	// Attribute the work done until the matching pop to a layer and sprite
+	// group (nests; layers and sprite groups do this themselves)
+	DOLL_FUNC Void DOLL_API gfx_pushRenderStatsScope( const RLayer *pLayer, const RSpriteGroup *pGroup = nullptr );
+	DOLL_FUNC Void DOLL_API gfx_popRenderStatsScope();
+
+	// Show or hide a layer drawing the statistics of recent frames over
+	// everything else (enables statistics if needed)
+	DOLL_FUNC Bool DOLL_API gfx_showRenderStatsOverlay( Bool bShow = true );
+	DOLL_FUNC Bool DOLL_API gfx_isRenderStatsOverlayShown();
+
+#ifdef DOLL__BUILD
+	class MRenderStats
+	{
+	public:
+		static MRenderStats &get();
+
+		Bool enable( U32 cHistoryFrames );
+		Void disable();
+		inline Bool isEnabled() const
+		{
+			return m_bEnabled;
+		}
+
+		U32 getFrameCount() const;
+		const SGfxRenderFrameStats *getFrame( U32 uFramesAgo ) const;
+		const SGfxRenderScopeStats *getScope( U32 uScope, U32 uFramesAgo ) const;
+
+		Void pushScope( const RLayer *pLayer, const RSpriteGroup *pGroup );
+		Void popScope();
+
+		// Called by the `gfx_r_*` wrappers
+		inline Void countDraw( U32 cVertices )
+		{
+			if( m_bEnabled ) {
+				SGfxRenderCounters &c = current();
+				++c.cDraws;
+				c.cVertices += cVertices;
+			}
+		}
+		inline Void countStateChange( Bool bElided )
+		{
+			if( m_bEnabled ) {
+				++( bElided ? current().cElidedStateChanges : current().cStateChanges );
+			}
+		}
+		inline Void countTextureBind()
+		{
+			if( m_bEnabled ) {
+				++current().cTextureBinds;
+			}
+		}
+		inline Void countVBufferBytes( UPtr cBytes )
+		{
+			if( m_bEnabled ) {
+				current().cVBufferBytes += cBytes;
+			}
+		}
+		inline Void countTextureBytes( UPtr cBytes )
+		{
+			if( m_bEnabled ) {
+				current().cTextureBytes += cBytes;
+			}
+		}
+
+		// Finish the current frame (called when a frame is presented)
+		Void endFrame();
+
+	private:
+		struct SFrame
+		{
+			SGfxRenderFrameStats           stats;
+			TMutArr<SGfxRenderScopeStats> scopes;
+		};
+		struct SScopeKey
+		{
+			const RLayer *      pLayer;
+			const RSpriteGroup *pGroup;
+		};
+
+		Bool                m_bEnabled;
+		// Finished frames (a ring; the oldest is overwritten first)
+		SFrame *            m_pHistory;
+		U32                 m_cMaxHistory;
+		U32                 m_cHistory;
+		U32                 m_uNextHistory;
+		// Frame being rendered
+		SFrame              m_frame;
+		TMutArr<SScopeKey>  m_scopeStack;
+		// Pushes past the top of `m_scopeStack` that weren't kept (too deep,
+		// or out of memory); popped before anything on the stack
+		U32                 m_cOverflow;
+		// Index in `m_frame.scopes` of the current scope (0 is outside of
+		// any scope)
+		UPtr                m_uScope;
+
+		MRenderStats();
+		~MRenderStats();
+
+		inline SGfxRenderCounters &current()
+		{
+			return m_frame.scopes[ m_uScope ].counters;
+		}
+		Bool selectScope( const RLayer *pLayer, const RSpriteGroup *pGroup );
+		Void resetFrame();
+	};
+	static ax::TManager< MRenderStats > g_renderStats;
+#endif
+
+}
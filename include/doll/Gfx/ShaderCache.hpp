@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+#include "API.hpp"
+
+/*
+===============================================================================
+
+	SHADER CACHE
+
+	Stores compiled shaders and programs in a directory so later runs can
+	skip compiling them. Nothing in here knows about any particular backend:
+	a backend builds a key from everything its output depends on (the shader
+	sources, their format and stage, and the driver that compiled them) and
+	stores whatever blob the driver hands back, along with a tag (e.g., the
+	driver's binary format).
+
+	Each entry is one file named after its key. Its header repeats the key
+	and carries the blob's size and checksum, all of which are checked on
+	load; entries that fail are deleted. Files go through the VFS.
+
+	Once the directory holds more than the byte budget, the entries stored
+	longest ago (by their files' modification times) are deleted. Loading an
+	entry doesn't update its time, so this evicts by age rather than by use:
+	a shader in constant use still goes once it's among the oldest, and gets
+	stored again (as the newest entry) the next time it's compiled. The
+	directory is only listed when the cache is pointed at it and whenever the
+	bytes stored since could have put it over budget, not on every store.
+
+===============================================================================
+*/
+
+namespace doll
+{
+
+// Accumulates the things a cache entry depends on into a 64-bit key
+//
+// The same values added in the same order always give the same key, on
+// every platform and run (64-bit FNV-1a)
+class CShaderCacheKey
+{
+  public:
+	CShaderCacheKey() : m_uHash(kBasis) {}
+
+	CShaderCacheKey &addBytes(const Void *pData, UPtr cBytes);
+	CShaderCacheKey &addString(Str s);
+	CShaderCacheKey &addU32(U32 x);
+	CShaderCacheKey &addU64(U64 x);
+
+	U64 get() const { return m_uHash; }
+
+  private:
+	static const U64 kBasis = 0xCBF29CE484222325ULL;
+	static const U64 kPrime = 0x00000100000001B3ULL;
+
+	U64 m_uHash;
+};
+
+// Key for a shader's source; `extraKey` should identify the backend and
+// driver that will compile it
+DOLL_FUNC U64 DOLL_API gfx_calcShaderCacheKey(EShaderFormat fmt, EShaderStage stage, const Void *pSource, UPtr cSourceBytes, U64 extraKey = 0);
+
+class CShaderCache
+{
+  public:
+	// Default byte budget for the cache directory
+	static const U64 kDefaultMaxBytes = U64(64) << 20;
+
+	CShaderCache();
+	~CShaderCache();
+
+	// Use `dirname` (created if needed) for the cache; an empty name
+	// disables the cache
+	Bool setDirectory(Str dirname);
+	Str getDirectory() const { return m_dirname; }
+	Bool isEnabled() const { return m_dirname.isUsed(); }
+
+	// Most bytes the cache's files may take before old entries get evicted
+	Void setMaxBytes(U64 cMaxBytes) { m_cMaxBytes = cMaxBytes; }
+	U64 getMaxBytes() const { return m_cMaxBytes; }
+
+	// Load the blob stored for `uKey`, and the tag it was stored with
+	//
+	// Returns false if there's no valid entry (a damaged or mismatched one
+	// is deleted)
+	Bool load(U64 uKey, TMutArr<U8> &dst, U32 &outTag);
+	// Store a blob for `uKey`, replacing any existing entry, then evict old
+	// entries if the cache may be over budget
+	Bool store(U64 uKey, U32 uTag, const Void *pData, UPtr cBytes);
+	// Delete the entry for `uKey`
+	Void remove(U64 uKey);
+
+	// Delete every entry
+	Void clear();
+	// Delete the oldest entries until the cache fits in its budget
+	Void trim();
+
+  private:
+	MutStr m_dirname;
+	U64 m_cMaxBytes;
+	// Bytes in the directory as of the last trim(), plus those stored since
+	U64 m_cBytes;
+
+	Bool getEntryFilename(MutStr &dst, U64 uKey) const;
+};
+
+} // namespace doll
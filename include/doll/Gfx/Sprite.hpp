@@ -21,6 +21,9 @@ namespace doll
 
 	class ActiveAction; // in "doll-gfx-action.hpp"
 
+	typedef THandleTable< RSprite, kTag_Sprite > SpriteTable;
+	typedef SpriteTable::Handle HSprite;
+
 	struct SSpriteTransform
 	{
 		Vec2f translation;
@@ -131,7 +134,7 @@ namespace doll
 	===============================================================================
 	*/
 
-	class RSprite: public TPoolObject< RSprite, kTag_Sprite >
+	class RSprite: public TPoolObject< RSprite, kTag_Sprite, SpriteTable >
 	{
 	friend class RSpriteGroup;
 	friend class ActiveAction;
@@ -533,6 +536,15 @@ namespace doll
 			visible = visibility;
 		}
 
+		inline HSprite getHandle() const
+		{
+			return getPool().handleOf( this );
+		}
+		static inline RSprite *fromHandle( HSprite h )
+		{
+			return getPool().get( h );
+		}
+
 	protected:
 		RSpriteGroup *grp_parent;
 		TIntrLink<RSprite> grp_spriteLink;
@@ -787,6 +799,17 @@ namespace doll
 		Void render_gl( CGfxFrame *pFrame );
 		Void update();
 
+		// Whether sprites that can be drawn as instances are (see
+		// gfx_enableSpriteInstancing())
+		inline Void setInstancingEnabled( Bool bEnable )
+		{
+			instancingEnabled = bEnable;
+		}
+		inline Bool isInstancingEnabled() const
+		{
+			return instancingEnabled;
+		}
+
 		inline RSpriteGroup *getDefaultSpriteGroup()
 		{
 			return defaultSpriteGroup;
@@ -806,6 +829,7 @@ namespace doll
 		TIntrList< RSpriteGroup > mgr_spriteGroupList;
 
 	private:
+		Bool instancingEnabled;
 		RSpriteGroup *defaultSpriteGroup;
 	};
 	extern MSprites &g_spriteMgr;
@@ -821,6 +845,11 @@ namespace doll
 	DOLL_FUNC RSpriteGroup *DOLL_API gfx_newSpriteGroup();
 	DOLL_FUNC RSpriteGroup *DOLL_API gfx_deleteSpriteGroup( RSpriteGroup *group );
 	DOLL_FUNC RSpriteGroup *DOLL_API gfx_getDefaultSpriteGroup();
+	// Draw sprites that stay axis-aligned and are one color as one instance
+	// record each rather than six vertices (on by default; other sprites, and
+	// APIs that refuse the instanced layout, always get six vertices)
+	DOLL_FUNC Void DOLL_API gfx_enableSpriteInstancing( Bool bEnable = true );
+	DOLL_FUNC Bool DOLL_API gfx_isSpriteInstancingEnabled();
 	DOLL_FUNC Void DOLL_API gfx_showSpriteGroup( RSpriteGroup *group );
 	DOLL_FUNC Void DOLL_API gfx_hideSpriteGroup( RSpriteGroup *group );
 	DOLL_FUNC Bool DOLL_API gfx_isSpriteGroupVisible( const RSpriteGroup *group );
@@ -966,4 +995,38 @@ namespace doll
 	DOLL_FUNC Void DOLL_API gfx_setSpriteVisible( RSprite *sprite, S32 visible );
 	DOLL_FUNC Bool DOLL_API gfx_isSpriteVisible( const RSprite *sprite );
 
+	// Handle-based variants; a deleted sprite's handle resolves to nullptr
+	DOLL_FUNC HSprite DOLL_API gfx_getSpriteHandle( const RSprite *sprite );
+	DOLL_FUNC RSprite *DOLL_API gfx_getSpriteFromHandle( HSprite sprite );
+	DOLL_FUNC Bool DOLL_API gfx_isSpriteHandleValid( HSprite sprite );
+	DOLL_FUNC U32 DOLL_API gfx_getLiveSpriteCount();
+
+	DOLL_FUNC HSprite DOLL_API gfx_newSpriteHandle();
+	DOLL_FUNC HSprite DOLL_API gfx_newSpriteHandleInGroup( RSpriteGroup *group );
+	DOLL_FUNC HSprite DOLL_API gfx_loadAnimSpriteHandle( HTexture texture, S32 cellResX, S32 cellResY, S32 startFrame, S32 numFrames, S32 offX, S32 offY, S32 padX, S32 padY );
+	DOLL_FUNC HSprite DOLL_API gfx_deleteSpriteByHandle( HSprite sprite );
+
+	DOLL_FUNC Void DOLL_API gfx_moveSpriteByHandle( HSprite sprite, F32 x, F32 y );
+	DOLL_FUNC Void DOLL_API gfx_turnSpriteByHandle( HSprite sprite, F32 theta );
+	DOLL_FUNC Void DOLL_API gfx_setSpritePositionByHandle( HSprite sprite, F32 x, F32 y );
+	DOLL_FUNC Bool DOLL_API gfx_getSpritePositionByHandle( HSprite sprite, F32 *x, F32 *y );
+	DOLL_FUNC Void DOLL_API gfx_setSpriteRotationByHandle( HSprite sprite, F32 angle );
+	DOLL_FUNC F32 DOLL_API gfx_getSpriteRotationByHandle( HSprite sprite );
+	DOLL_FUNC Void DOLL_API gfx_setSpriteScaleByHandle( HSprite sprite, F32 x, F32 y );
+	DOLL_FUNC Bool DOLL_API gfx_getSpriteScaleByHandle( HSprite sprite, F32 *x, F32 *y );
+
+	DOLL_FUNC Void DOLL_API gfx_setSpriteTextureByHandle( HSprite sprite, HTexture texture );
+	DOLL_FUNC HTexture DOLL_API gfx_getSpriteTextureByHandle( HSprite sprite );
+	DOLL_FUNC Void DOLL_API gfx_setSpriteCurrentFrameByHandle( HSprite sprite, U32 frameIndex );
+	DOLL_FUNC Void DOLL_API gfx_playSpriteAnimationByHandle( HSprite sprite, U32 beginFrame, U32 endFrame );
+	DOLL_FUNC Void DOLL_API gfx_loopSpriteAnimationByHandle( HSprite sprite, U32 beginFrame, U32 endFrame );
+	DOLL_FUNC Void DOLL_API gfx_stopSpriteAnimationByHandle( HSprite sprite );
+
+	DOLL_FUNC Void DOLL_API gfx_bindSpriteByHandle( HSprite sprite, HSprite master );
+	DOLL_FUNC Void DOLL_API gfx_unbindSpriteByHandle( HSprite sprite );
+	DOLL_FUNC HSprite DOLL_API gfx_getSpriteBindMasterByHandle( HSprite sprite );
+
+	DOLL_FUNC Void DOLL_API gfx_setSpriteVisibleByHandle( HSprite sprite, S32 visible );
+	DOLL_FUNC Bool DOLL_API gfx_isSpriteVisibleByHandle( HSprite sprite );
+
 }
@@ -3,6 +3,7 @@
 #include "../Core/Defs.hpp"
 #include "../Core/Memory.hpp"
 #include "../Core/MemoryTags.hpp"
+#include "../Core/Handle.hpp"
 #include "API.hpp"
 
 namespace doll
@@ -15,6 +16,11 @@ namespace doll
 	class RTexture;
 	class CTextureAtlas;
 	class MTextures;
+	class CAsyncOp;
+	class IFile;
+
+	typedef THandleTable< RTexture, kTag_Texture > TextureTable;
+	typedef TextureTable::Handle HTexture;
 
 	struct STextureRect
 	{
@@ -102,6 +108,17 @@ namespace doll
 		{
 			return UPtr( gfx_getTexelByteSize( format ) );
 		}
+		// Bytes the backing texture takes while resident
+		inline U64 getByteCount() const
+		{
+			return U64( resolution.x )*U64( resolution.y )*U64( getBytesPerPixel() );
+		}
+
+		// Whether the backing texture is on the GPU (see gfx_setTextureBudget)
+		inline Bool isResident() const
+		{
+			return texture != 0;
+		}
 
 	protected:
 		TIntrLink< CTextureAtlas > mgrAtlas_link;
@@ -111,6 +128,15 @@ namespace doll
 		Bool init( ETextureFormat fmt, U16 resX, U16 resY );
 		Void fini();
 
+		// Whether every texture in the atlas can be brought back after the
+		// backing texture is destroyed
+		Bool isEvictable();
+		// Destroy the backing texture, keeping the textures in it
+		Void evict();
+		// Recreate the backing texture, then upload the textures again (or
+		// start reloading them)
+		Bool restore();
+
 #if DOLL_TEXTURE_MEMORY_ENABLED
 		Bool updateTextures( UPtr numTextures, const RTexture *const *textures );
 #else
@@ -126,13 +152,18 @@ namespace doll
 		UPtr                texture;
 		SPixelVec2          resolution;
 		ETextureFormat      format;
+		Bool                bEvicted;
+		// Render frame the atlas was last drawn from (see MTextures::endFrame())
+		U32                 uLastUseFrame;
+		// Textures in the atlas still being reloaded after a restore
+		U32                 cPendingReloads;
 
 		CRectangleAllocator allocator;
 
 		TIntrList<RTexture> atlas_list;
 	};
 
-	class RTexture: public TPoolObject< RTexture, kTag_Texture >
+	class RTexture: public TPoolObject< RTexture, kTag_Texture, TextureTable >
 	{
 	friend class CTextureAtlas;
 	friend class MTextures;
@@ -208,11 +239,31 @@ namespace doll
 
 			return atlas->getBackingTexture();
 		}
+		// Backing texture to draw the texture with this frame, marking its
+		// atlas as used
+		//
+		// If the atlas was evicted this starts bringing it back and returns a
+		// placeholder until every texture in it has been reloaded
+		UPtr useBackingTexture() const;
+
+		// File the texture was loaded from (empty if made from memory)
+		inline Str getSource() const
+		{
+			return source;
+		}
 
 		inline U16 getIdentifier() const
 		{
 			return ident;
 		}
+		inline HTexture getHandle() const
+		{
+			return getPool().handleOf( this );
+		}
+		static inline RTexture *fromHandle( HTexture h )
+		{
+			return getPool().get( h );
+		}
 
 		inline F32 getUnitResX() const
 		{
@@ -240,6 +291,7 @@ namespace doll
 #endif
 
 		MutStr         name;
+		MutStr         source;
 	};
 
 	class MTextures
@@ -252,6 +304,9 @@ namespace doll
 		static MTextures instance;
 
 		RTexture *makeTexture( U16 width, U16 height, const Void *data, ETextureFormat format = kTexFmtRGBA8, CTextureAtlas *specificAtlas = nullptr );
+		// Like makeTexture() but only tries `atlas`, returning nullptr without
+		// reporting an error if there is no room left in it
+		RTexture *makeTextureInAtlas( U16 width, U16 height, const Void *data, ETextureFormat format, CTextureAtlas *atlas );
 		RTexture *loadTexture( Str filename, CTextureAtlas *specificAtlas = nullptr );
 
 		CTextureAtlas *allocateAtlas( ETextureFormat fmt, U16 resX, U16 resY );
@@ -264,11 +319,34 @@ namespace doll
 			return defAtlasRes;
 		}
 
+		// Evict atlases drawn from least recently once the backing textures
+		// take more than `cBytes` (0 for no limit)
+		Void setBudget( U64 cBytes );
+		inline U64 getBudget() const
+		{
+			return budgetBytes;
+		}
+		inline U64 getResidentBytes() const
+		{
+			return residentBytes;
+		}
+
+		// Finish the reloads that are done and evict atlases over the budget
+		// (called after each frame is presented)
+		Void endFrame();
+		// Cancel pending reloads and destroy the placeholder (called before
+		// the render API is finalized)
+		Void fini();
+
 	protected:
 		U16 procureTextureId();
 		Void setHandleForTextureId( U16 textureId, RTexture *handle );
 		Void nullifyTextureId( U16 textureId );
 
+		UPtr useAtlas( CTextureAtlas *atlas );
+		Bool startReload( RTexture *tex );
+		Void cancelReload( RTexture *tex );
+
 	private:
 		MTextures();
 		~MTextures();
@@ -276,6 +354,18 @@ namespace doll
 		Void pushFreeTextureId( U16 textureId );
 		U16 popFreeTextureId();
 
+		Void trim();
+		UPtr getPlaceholder();
+		Bool finishReload( RTexture *tex, CAsyncOp *pOp );
+
+		// A texture being read back in for an atlas that was restored
+		struct SReload
+		{
+			RTexture *pTexture;
+			IFile *   pFile;
+			CAsyncOp *pOp;
+		};
+
 		RTexture *               textures[ MAX_TEXTURES ];    //0 is set to nullptr, always
 		U16                      freeIds[ MAX_TEXTURES - 1 ]; //0 is always nullptr, sub 1
 		U16                      freeIds_sp;                  //stack pointer
@@ -284,6 +374,14 @@ namespace doll
 
 		TIntrList<CTextureAtlas> mgrAtlas_list;
 		TIntrList<RTexture>      mgrTex_list;
+
+		U64                      budgetBytes;
+		U64                      residentBytes;
+		// Render frame being drawn (starts at 1; 0 means never used)
+		U32                      uFrame;
+		// Drawn in place of atlases being reloaded
+		UPtr                     placeholder;
+		TMutArr<SReload>         reloads;
 	};
 	extern MTextures &g_textureMgr;
 
@@ -302,4 +400,27 @@ namespace doll
 	DOLL_FUNC U32 DOLL_API gfx_getTextureResX( const RTexture *textureId );
 	DOLL_FUNC U32 DOLL_API gfx_getTextureResY( const RTexture *textureId );
 
+	// Handle-based variants; a deleted texture's handle resolves to nullptr
+	DOLL_FUNC HTexture DOLL_API gfx_getTextureHandle( const RTexture *texture );
+	DOLL_FUNC RTexture *DOLL_API gfx_getTextureFromHandle( HTexture texture );
+	DOLL_FUNC Bool DOLL_API gfx_isTextureHandleValid( HTexture texture );
+	DOLL_FUNC U32 DOLL_API gfx_getLiveTextureCount();
+
+	DOLL_FUNC HTexture DOLL_API gfx_newTextureHandle( U16 width, U16 height, const void *data, ETextureFormat format );
+	DOLL_FUNC HTexture DOLL_API gfx_loadTextureHandle( Str filename );
+	DOLL_FUNC HTexture DOLL_API gfx_deleteTextureByHandle( HTexture texture );
+	DOLL_FUNC U32 DOLL_API gfx_getTextureResXByHandle( HTexture texture );
+	DOLL_FUNC U32 DOLL_API gfx_getTextureResYByHandle( HTexture texture );
+
+	// Limit the GPU memory atlases take to `cBytes` (0 for no limit)
+	//
+	// Past the limit, atlases that haven't been drawn from for the longest
+	// are evicted at the end of each frame. Their textures stay valid and
+	// are reloaded from their files the next time they're drawn. Atlases
+	// with textures made from memory are never evicted.
+	DOLL_FUNC Void DOLL_API gfx_setTextureBudget( U64 cBytes );
+	DOLL_FUNC U64 DOLL_API gfx_getTextureBudget();
+	// Bytes the resident atlases take
+	DOLL_FUNC U64 DOLL_API gfx_getResidentTextureBytes();
+
 }
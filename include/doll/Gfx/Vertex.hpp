@@ -31,6 +31,19 @@ namespace doll
 		kVF_Tex7       = 0x70000000,
 		kVF_Tex8       = 0x80000000,
 
+		// Compact forms of kVF_XY with up to one set of texture coordinates,
+		// which PrimitiveBuffer uploads in place of SVertex2DSprite when a
+		// batch fits them: positions as whole S16 pixels or F16, and texture
+		// coordinates as UNORM16 (0 to 65535 for 0.0 to 1.0)
+		//
+		// The packed vertex is the position (4 bytes), the diffuse color (4
+		// bytes) and, if textured, the texture coordinates (4 bytes as
+		// UNORM16, 8 as F32); 12 bytes rather than 20 when fully packed, and
+		// 16 on OpenGL, which always refuses UNORM16 texture coordinates
+		kVF_PosS16     = 0x00000100,
+		kVF_PosF16     = 0x00000200,
+		kVF_TexUNorm16 = 0x00000400,
+
 		kVFMask_Pos    = 0x00000003,
 		kVFShft_Pos    = 0,
 
@@ -214,6 +214,10 @@ namespace doll
 	DOLL_FUNC Void DOLL_API sysfs_leave();
 
 	DOLL_FUNC Bool DOLL_API sysfs_mkdir( const Str &dir );
+	// Delete a file (not a directory)
+	DOLL_FUNC Bool DOLL_API sysfs_remove( const Str &filename );
+	// Delete an empty directory
+	DOLL_FUNC Bool DOLL_API sysfs_rmdir( const Str &dir );
 
 	DOLL_FUNC Bool DOLL_API sysfs_getAppDataDir( Str &dst );
 	DOLL_FUNC Bool DOLL_API sysfs_getMyDocsDir( Str &dst );
@@ -69,6 +69,8 @@ namespace doll
 		virtual Void closeDir( IDir *pDir ) override;
 
 		virtual Bool stat( const Str &filename, SFileStat &dstStat ) override;
+		virtual Bool remove( const Str &filename ) override;
+		virtual Bool mkdir( const Str &dirname ) override;
 
 	private:
 		CFileProvider_Sysfs();
@@ -139,6 +139,20 @@ namespace doll
 			close( p );
 			return r;
 		}
+
+		// Delete a file; providers that can't (e.g., archives) return false
+		virtual Bool remove( const Str &filename )
+		{
+			( Void )filename;
+			return false;
+		}
+		// Create a directory, along with any missing parents; providers that
+		// can't return false
+		virtual Bool mkdir( const Str &dirname )
+		{
+			( Void )dirname;
+			return false;
+		}
 	};
 
 	inline NullPtr IFile::drop()
@@ -202,6 +216,12 @@ namespace doll
 	DOLL_FUNC Bool DOLL_API fs_filteredStat( const TArr<IFileProvider *> &providers, const Str &filename, SFileStat &dstStat );
 	DOLL_FUNC Bool DOLL_API fs_stat( const Str &filename, SFileStat &dstStat );
 
+	DOLL_FUNC Bool DOLL_API fs_filteredRemove( const TArr<IFileProvider *> &providers, const Str &filename );
+	DOLL_FUNC Bool DOLL_API fs_remove( const Str &filename );
+
+	DOLL_FUNC Bool DOLL_API fs_filteredMkdir( const TArr<IFileProvider *> &providers, const Str &dirname );
+	DOLL_FUNC Bool DOLL_API fs_mkdir( const Str &dirname );
+
 	inline Bool DOLL_API fs_pathExists( const Str &filename )
 	{
 		SFileStat s;
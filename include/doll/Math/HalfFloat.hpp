@@ -14,6 +14,10 @@ namespace doll {
 		
 		F16 &operator=( float f );
 		operator float() const;
+
+		/// Raw bits, for packing into (and reading out of) vertex data.
+		static F16 fromBits( U16 uBits );
+		U16 getBits() const;
 	
 	private:
 		U16 m_uBits;
@@ -32,6 +36,17 @@ namespace doll {
 	{
 	}
 
+	inline F16 F16::fromBits( U16 uBits )
+	{
+		F16 x;
+		x.m_uBits = uBits;
+		return x;
+	}
+	inline U16 F16::getBits() const
+	{
+		return m_uBits;
+	}
+
 	/// Convert a float value to a half-float value.
 	inline F16 &F16::operator=( float f )
 	{
@@ -263,6 +263,75 @@ namespace doll {
 		return r;
 #else
 # error AX_INTRIN: Unhandled intrinsic
+#endif
+	}
+	/// Take the lesser of each component of vector \a a and vector \a b.
+	inline V128 AX_VCALL vecMin( P_V128 a, P_V128 b )
+	{
+#if AX_INTRIN_SSE
+		return _mm_min_ps( a, b );
+#elif AX_INTRIN_NONE
+		V128 r;
+
+		r.f[ 0 ] = a.f[ 0 ] < b.f[ 0 ] ? a.f[ 0 ] : b.f[ 0 ];
+		r.f[ 1 ] = a.f[ 1 ] < b.f[ 1 ] ? a.f[ 1 ] : b.f[ 1 ];
+		r.f[ 2 ] = a.f[ 2 ] < b.f[ 2 ] ? a.f[ 2 ] : b.f[ 2 ];
+		r.f[ 3 ] = a.f[ 3 ] < b.f[ 3 ] ? a.f[ 3 ] : b.f[ 3 ];
+
+		return r;
+#else
+# error AX_INTRIN: Unhandled intrinsic
+#endif
+	}
+	/// Take the greater of each component of vector \a a and vector \a b.
+	inline V128 AX_VCALL vecMax( P_V128 a, P_V128 b )
+	{
+#if AX_INTRIN_SSE
+		return _mm_max_ps( a, b );
+#elif AX_INTRIN_NONE
+		V128 r;
+
+		r.f[ 0 ] = a.f[ 0 ] > b.f[ 0 ] ? a.f[ 0 ] : b.f[ 0 ];
+		r.f[ 1 ] = a.f[ 1 ] > b.f[ 1 ] ? a.f[ 1 ] : b.f[ 1 ];
+		r.f[ 2 ] = a.f[ 2 ] > b.f[ 2 ] ? a.f[ 2 ] : b.f[ 2 ];
+		r.f[ 3 ] = a.f[ 3 ] > b.f[ 3 ] ? a.f[ 3 ] : b.f[ 3 ];
+
+		return r;
+#else
+# error AX_INTRIN: Unhandled intrinsic
+#endif
+	}
+
+	/// Load a vector from four floats (\a p must be suitably aligned.)
+	inline V128 AX_VCALL vecLoad( const F32 *p )
+	{
+#if AX_INTRIN_SSE
+		return _mm_load_ps( p );
+#elif AX_INTRIN_NONE
+		V128 r;
+
+		r.f[ 0 ] = p[ 0 ];
+		r.f[ 1 ] = p[ 1 ];
+		r.f[ 2 ] = p[ 2 ];
+		r.f[ 3 ] = p[ 3 ];
+
+		return r;
+#else
+# error AX_INTRIN: Unhandled intrinsic
+#endif
+	}
+	/// Store a vector to four floats (\a p must be suitably aligned.)
+	inline Void AX_VCALL vecStore( F32 *p, P_V128 a )
+	{
+#if AX_INTRIN_SSE
+		_mm_store_ps( p, a );
+#elif AX_INTRIN_NONE
+		p[ 0 ] = a.f[ 0 ];
+		p[ 1 ] = a.f[ 1 ];
+		p[ 2 ] = a.f[ 2 ];
+		p[ 3 ] = a.f[ 3 ];
+#else
+# error AX_INTRIN: Unhandled intrinsic
 #endif
 	}
 
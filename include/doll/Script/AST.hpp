@@ -1,112 +1,216 @@
 #pragma once
 
 #include "../Core/Defs.hpp"
-#include "CompilerMemory.hpp"
+#include "Token.hpp"
 
-namespace doll { namespace script {
+/*
+===============================================================================
 
-class Decl;
-class Expr;
-class Stmt;
-
-class Node: public CompilerObject {
-	enum Kind {
-		kDecl,
-		kExpr,
-		kStmt
-	};
-	Kind m_kind;
-	union {
-		Decl *decl;
-		Expr *expr;
-		Stmt *stmt;
-	} m_data;
+	SYNTAX TREE
 
-public:
-	Node( CCompilerContext &ctx, Decl *decl )
-	: CompilerObject( ctx )
-	, m_kind( kDecl )
-	{
-		m_data.decl = decl;
-	}
-	Node( CCompilerContext &ctx, Expr *expr )
-	: CompilerObject( ctx )
-	, m_kind( kExpr )
-	{
-		m_data.expr = expr;
-	}
-	Node( CCompilerContext &ctx, Stmt *stmt )
-	: CompilerObject( ctx )
-	, m_kind( kStmt )
-	{
-		m_data.stmt = stmt;
-	}
+	The parser's output is a flat array of nodes rather than a graph of heap
+	objects. Nodes refer to each other by index: each node knows its first
+	child and its next sibling, so a node's children form a singly linked
+	list within the same array. Node 0 is always the root (`kSN_Program`),
+	which is never anyone's child or sibling, so an index of 0 means "none".
 
-	Bool isDecl() const { return m_kind == kDecl; }
-	Bool isExpr() const { return m_kind == kExpr; }
-	Bool isStmt() const { return m_kind == kStmt; }
+	Every node has a token (`CSyntaxTree::getToken`), kept in a second
+	array alongside the nodes: the name or literal for a leaf, the operator
+	for an operation, or the keyword/first token for everything else. The
+	token gives the node's location for diagnostics and, through its value,
+	the identifier or literal it holds.
 
-	const Decl *getAsDecl_const() const {
-		return isDecl() ? m_data.decl : nullptr;
-	}
-	const Expr *getAsExpr_const() const {
-		return isExpr() ? m_data.expr : nullptr;
-	}
-	const Stmt *getAsStmt_const() const {
-		return isStmt() ? m_data.stmt : nullptr;
-	}
+	A tree is built in one pass and never has nodes removed, so both arrays
+	only grow and a whole tree is released at once.
 
-	const Decl *getAsDecl() const { return getAsDecl_const(); }
-	const Expr *getAsExpr() const { return getAsExpr_const(); }
-	const Stmt *getAsStmt() const { return getAsStmt_const(); }
+===============================================================================
+*/
 
-	Decl *getAsDecl() { return const_cast< Decl * >( getAsDecl_const() ); }
-	Expr *getAsExpr() { return const_cast< Expr * >( getAsExpr_const() ); }
-	Stmt *getAsStmt() { return const_cast< Stmt * >( getAsStmt_const() ); }
+namespace doll { namespace script {
+
+// Kind of a syntax node; the comment lists the node's children in order
+enum ESyntaxKind: U8 {
+	// Something that couldn't be parsed (already diagnosed)
+	kSN_Error,
+
+	//
+	//	Statements
+	//
+
+	// Statements of the whole source
+	kSN_Program,
+	// `{` statements... `}`
+	kSN_Block,
+	// Expression used as a statement: expr
+	kSN_ExprStmt,
+	// `var`/`let` (the token) name [type] [initializer]
+	kSN_VarDecl,
+	// `func` name params... [type] body (a block or expression)
+	kSN_FuncDecl,
+	// Function parameter: name [type]
+	kSN_Param,
+	// `struct`/`class`/`extension`/`interface`/`protocol` (the token)
+	// name [bases...] block
+	kSN_TypeDecl,
+	// `if`/`elseif` cond then [else] (else is another kSN_If or a block)
+	kSN_If,
+	// `while` cond body
+	kSN_While,
+	// `do` body `while` cond
+	kSN_DoWhile,
+	// `loop` body
+	kSN_Loop,
+	// `for` name `in` sequence body
+	kSN_ForIn,
+	// `switch` value cases...
+	kSN_Switch,
+	// `case` values... statements... (`default` if it has no values; see
+	// `kSNF_Default`)
+	kSN_Case,
+	// `menu` choices...
+	kSN_Menu,
+	// Menu choice: caption body (neither for a blank item, whose token is
+	// the lexer's kTT_Blank)
+	kSN_MenuChoice,
+	// `return` [value]
+	kSN_Return,
+	// `break`
+	kSN_Break,
+	// `continue`
+	kSN_Continue,
+	// `defer` body
+	kSN_Defer,
+	// `goto` label
+	kSN_Goto,
+	// Label definition (`*label` starting a line)
+	kSN_Label,
+	// Line of dialogue: koe, speaker and message tokens, in source order
+	kSN_Dialogue,
+	// `multimessage` block
+	kSN_MultiMessage,
 
-	Bool semant();
-	Bool codegen();
+	//
+	//	Expressions
+	//
+
+	// Identifier or special reference (name, type, label, `$x`, `#x`, `%x`,
+	// `@x`, ...); see the token's type
+	kSN_Name,
+	// Numeric literal
+	kSN_Number,
+	// String literal
+	kSN_String,
+	// `null`, `true` or `false`
+	kSN_Constant,
+	// Dialogue token used as a value (koe, speaker or message)
+	kSN_DialogueToken,
+	// Prefix (or postfix; see `kSNF_Postfix`) operator: operand
+	kSN_Unary,
+	// Binary operator (including assignments): left right
+	kSN_Binary,
+	// cond `?` then `:` else
+	kSN_Conditional,
+	// callee args...
+	kSN_Call,
+	// object index
+	kSN_Index,
+	// object name
+	kSN_Member,
+	// `[` elements... `]`
+	kSN_ArrayLiteral,
+
+	kNumSyntaxKinds
 };
 
-class Decl: public CompilerObject {
-public:
-	virtual Bool semant();
-	virtual Bool codegen();
+// Flags in `SSyntaxNode::uFlags`
+enum ESyntaxNodeFlags: U8 {
+	// kSN_Unary: the operator follows its operand
+	kSNF_Postfix    = 0x01,
+	// kSN_Binary: the operator assigns to its left operand
+	kSNF_Assignment = 0x02,
+	// kSN_Case: this is the `default` case
+	kSNF_Default    = 0x04,
+	// kSN_FuncDecl: the body is an expression rather than a block
+	kSNF_ExprBody   = 0x08
 };
-class Expr: public CompilerObject {
-public:
-	virtual Bool semant();
-	virtual Bool codegen();
+
+// One node of a CSyntaxTree (kept small; there's one per token or so)
+struct SSyntaxNode {
+	ESyntaxKind kind;
+	U8          uFlags;
+	// Number of children (saturates at 0xFFFF)
+	U16         cChildren;
+	// Index of the first child, or 0
+	U32         uFirstChild;
+	// Index of the next child of the same parent, or 0
+	U32         uNextSibling;
 };
-class Stmt: public CompilerObject {
+static_assert( sizeof( SSyntaxNode ) == 12, "SSyntaxNode should stay compact" );
+
+class CSyntaxTree {
 public:
-	virtual Bool semant();
-	virtual Bool codegen();
-};
+	static const U32 kRoot = 0;
+
+	CSyntaxTree();
+	~CSyntaxTree();
+
+	// Remove every node (the next node added becomes the root)
+	Void clear();
+	// Make room for about `cNodes` nodes
+	Bool reserve( UPtr cNodes );
+
+	// Add a node without children; returns its index (0 on failure, which
+	// is never a valid result as the root is added first)
+	U32 addNode( ESyntaxKind kind, const SToken &tok, U8 uFlags = 0 );
+	// Link `uChild` in as the last child of `uParent`; `uLastChild` is the
+	// parent's current last child (0 for none) and is updated
+	Void appendChild( U32 uParent, U32 &uLastChild, U32 uChild );
+	// Set flags (ESyntaxNodeFlags) on a node
+	Void addFlags( U32 uIndex, U8 uFlags ) {
+		AX_ASSERT( uIndex < m_nodes.num() );
+		m_nodes[ uIndex ].uFlags |= uFlags;
+	}
+
+	U32 num() const {
+		return U32( m_nodes.num() );
+	}
+	Bool isEmpty() const {
+		return m_nodes.isEmpty();
+	}
 
-inline Bool Node::semant() {
-	if( Decl *d = getAsDecl() ) {
-		return d->semant();
-	} else if( Expr *e = getAsExpr() ) {
-		return e->semant();
-	} else if( Stmt *s = getAsStmt() ) {
-		return s->semant();
+	const SSyntaxNode &getNode( U32 uIndex ) const {
+		AX_ASSERT( uIndex < m_nodes.num() );
+		return m_nodes[ uIndex ];
+	}
+	const SToken &getToken( U32 uIndex ) const {
+		AX_ASSERT( uIndex < m_tokens.num() );
+		return m_tokens[ uIndex ];
 	}
 
-	AX_UNREACHABLE();
-	return false;
-}
-inline Bool Node::codegen() {
-	if( Decl *d = getAsDecl() ) {
-		return d->codegen();
-	} else if( Expr *e = getAsExpr() ) {
-		return e->codegen();
-	} else if( Stmt *s = getAsStmt() ) {
-		return s->codegen();
+	ESyntaxKind getKind( U32 uIndex ) const {
+		return getNode( uIndex ).kind;
+	}
+	// First child of a node, or 0
+	U32 getFirstChild( U32 uIndex ) const {
+		return getNode( uIndex ).uFirstChild;
 	}
+	// Next sibling of a node, or 0
+	U32 getNextSibling( U32 uIndex ) const {
+		return getNode( uIndex ).uNextSibling;
+	}
+	// `uNth` (zero-based) child of a node, or 0
+	U32 getChild( U32 uIndex, U32 uNth ) const;
+
+	// Bytes used by the tree's arrays
+	UPtr getMemoryUsage() const;
+
+private:
+	TMutArr<SSyntaxNode> m_nodes;
+	// Token of each node (same index as `m_nodes`)
+	TMutArr<SToken>      m_tokens;
+};
 
-	AX_UNREACHABLE();
-	return false;
-}
+// Name of a node kind (for dumps and tests)
+Str scr_syntaxKindToString( ESyntaxKind kind );
 
 }}
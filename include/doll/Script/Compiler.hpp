@@ -40,13 +40,43 @@ namespace doll { namespace script {
 			return getActiveSource_const();
 		}
 
+		CCompilerArena &getArena();
 		CDiagnosticEngine &getDiagnosticEngine();
 		CProgramData &getProgramData();
 		IdentDictionary &getSymbolMap();
 
 		Bool testCurrentSource();
 
+		// Lex every loaded source that hasn't been lexed yet into its `tokens`
+		// using up to `cThreads` threads (zero picks a default). Each source
+		// is lexed against its own identifier and string tables, which are
+		// then merged into the context's in source order, along with that
+		// source's diagnostics, so the result is the same for any thread count
+		Bool lexSources( U32 cThreads = 0 );
+
+		// Directory to keep lexed sources in between runs (see TokenCache.hpp);
+		// unchanged sources are loaded from there instead of being lexed again.
+		// Empty (the default) disables the cache
+		Bool setTokenCacheDir( const Str &dir );
+		Str getTokenCacheDir() const;
+
+		// Replace `cRemoveBytes` bytes at `uOffset` of a source's buffer with
+		// `text`, then lex only the part of the source the edit can change.
+		// Lexing restarts from the last saved lexer state before the edit and
+		// stops once the lexer reaches a state it was in before the edit
+		// (same next token, flags and bracket balance); the old tokens from
+		// there on are kept, moved by the change in length. Identifiers and
+		// strings come from the context's tables as usual
+		Bool editSource( Source &src, U32 uOffset, U32 cRemoveBytes, const Str &text );
+
 	private:
+		// Memory for every compiler object of this context (declared first so
+		// it is released last)
+		CCompilerArena     m_arena;
+
+		// Language version this context was initialized with
+		EVersion           m_version;
+
 		// Master collection of source files
 		TMutArr<Source *> m_pSources;
 		// Current source stack (from the source we're presently operating on)
@@ -63,6 +93,9 @@ namespace doll { namespace script {
 		// Identifier dictionary (used to speedup identifier/symbol lookups)
 		IdentDictionary    m_symDict;
 
+		// Where lexSources() loads and saves token caches (empty if disabled)
+		MutStr             m_tokenCacheDir;
+
 		Source *allocSource();
 		NullPtr freeSource( Source *pSrc );
 
@@ -74,7 +107,7 @@ namespace doll { namespace script {
 			AX_ASSERT( name.len() > 0 );
 			AX_ASSERT( name[ 0 ] >= 'A' && name[ 0 ] <= 'Z' );
 
-			T *const pType = new T( *this, move( args )... );
+			T *const pType = DOLL__SCRIPTOBJ_NEW( *this ) T( *this, move( args )... );
 			if( !AX_VERIFY_MEMORY( pType ) ) {
 				return false;
 			}
@@ -87,7 +120,7 @@ namespace doll { namespace script {
 
 			AX_ASSERT_IS_NULL( pEntry->pData );
 
-			Ident *const pIdent = new Ident( *this );
+			Ident *const pIdent = DOLL__SCRIPTOBJ_NEW( *this ) Ident( *this );
 			if( !AX_VERIFY_MEMORY( pIdent ) ) {
 				delete pType;
 				return false;
@@ -3,14 +3,111 @@
 #include "../Core/Defs.hpp"
 #include "../Core/Memory.hpp"
 
+// Allocate each compiler object individually (with its file/line) instead of
+// from the context's arena, so leaks and bad deletes can be tracked down
+#ifndef DOLL_SCRIPT_ARENA_TRACKING
+# define DOLL_SCRIPT_ARENA_TRACKING 0
+#endif
+
 namespace doll { namespace script {
 
 	class CCompilerContext;
 
 #define DOLL__SCRIPTOBJ_LINFO  __FILE__, __LINE__, AX_FUNCTION
-#define DOLL__SCRIPTOBJ_NEW    new   ( DOLL__SCRIPTOBJ_LINFO )
+#define DOLL__SCRIPTOBJ_NEW( Ctx_ ) new( Ctx_, DOLL__SCRIPTOBJ_LINFO )
 #define DOLL__SCRIPTOBJ_DELETE delete( DOLL__SCRIPTOBJ_LINFO )
 
+	/*
+	===========================================================================
+
+		COMPILER ARENA
+
+		Every compiler object (identifiers, sources, types, AST nodes) lives
+		exactly as long as the CCompilerContext that made it, so they're
+		bump allocated out of large chunks owned by the context and all
+		released together when the context is destroyed. Deleting an object
+		still runs its destructor, but its memory isn't reused.
+
+		With DOLL_SCRIPT_ARENA_TRACKING each object is allocated from the
+		heap instead, tagged with its file/line, and kept in a list so any
+		objects still alive when the arena is released can be reported.
+
+	===========================================================================
+	*/
+
+	class CCompilerArena
+	{
+	public:
+		// Default size of each chunk
+		static const UPtr kChunkSize = 64*1024;
+		// Alignment of every allocation
+		static const UPtr kAlignment = 16;
+
+		CCompilerArena();
+		~CCompilerArena();
+
+		Void *alloc( UPtr cBytes, const char *pszFilename, U32 uLine, const char *pszFunc );
+		static Void dealloc( Void *pBytes );
+
+		// Copy of `s` that lives as long as the arena (empty on failure)
+		Str copyStr( const Str &s, const char *pszFilename = nullptr, U32 uLine = 0, const char *pszFunc = nullptr );
+
+		// Free everything allocated from this arena
+		Void releaseAll();
+
+		// Bytes handed out by alloc() (including alignment padding)
+		inline UPtr getUsedBytes() const
+		{
+			return m_cUsedBytes;
+		}
+		// Bytes requested from the heap
+		inline UPtr getReservedBytes() const
+		{
+			return m_cReservedBytes;
+		}
+
+	private:
+		struct SChunk
+		{
+			SChunk *pNext;
+			UPtr    cBytes;
+		};
+
+		// Most recently allocated chunk first; allocations come from the head
+		SChunk *m_pChunks;
+		U8 *    m_pCursor;
+		U8 *    m_pEnd;
+
+		UPtr    m_cUsedBytes;
+		UPtr    m_cReservedBytes;
+
+#if DOLL_SCRIPT_ARENA_TRACKING
+		struct STrackedAlloc
+		{
+			CCompilerArena *pArena;
+			STrackedAlloc * pPrev;
+			STrackedAlloc * pNext;
+			UPtr            cBytes;
+			const char *    pszFilename;
+			U32             uLine;
+			const char *    pszFunc;
+		};
+
+		STrackedAlloc *m_pTracked;
+		UPtr           m_cTracked;
+
+		static UPtr getTrackedHeaderSize()
+		{
+			return ( sizeof( STrackedAlloc ) + kAlignment - 1 ) & ~( kAlignment - 1 );
+		}
+#endif
+
+		SChunk *newChunk( UPtr cDataBytes );
+
+		CCompilerArena( const CCompilerArena & ) AX_DELETE_FUNC;
+		CCompilerArena &operator=( const CCompilerArena & ) AX_DELETE_FUNC;
+	};
+
 	class CompilerObject
 	{
 	public:
@@ -22,17 +119,22 @@ namespace doll { namespace script {
 			return m_context;
 		}
 
-		static Void *operator new( SizeType cBytes );
-		static Void operator delete( Void *pBytes );
+		// Allocate from the context's arena
+		static Void *operator new( SizeType cBytes, CCompilerContext &ctx );
+		static Void operator delete( Void *pBytes, CCompilerContext &ctx );
 
-		static Void *operator new[]( SizeType cBytes );
-		static Void operator delete[]( Void *pBytes );
+		static Void *operator new( SizeType cBytes, CCompilerContext &ctx, const char *pszFilename, U32 uLine, const char *pszFunc );
+		static Void operator delete( Void *pBytes, CCompilerContext &ctx, const char *pszFilename, U32 uLine, const char *pszFunc );
 
-		static Void *operator new( SizeType cBytes, const char *pszFilename, U32 uLine, const char *pszFunc );
-		static Void operator delete( Void *pBytes, const char *pszFilename, U32 uLine, const char *pszFunc );
+		// Allocate from a specific arena (e.g., one owned by a worker thread)
+		static Void *operator new( SizeType cBytes, CCompilerArena &arena );
+		static Void operator delete( Void *pBytes, CCompilerArena &arena );
 
-		static Void *operator new[]( SizeType cBytes, const char *pszFilename, U32 uLine, const char *pszFunc );
-		static Void operator delete[]( Void *pBytes, const char *pszFilename, U32 uLine, const char *pszFunc );
+		static Void *operator new( SizeType cBytes, CCompilerArena &arena, const char *pszFilename, U32 uLine, const char *pszFunc );
+		static Void operator delete( Void *pBytes, CCompilerArena &arena, const char *pszFilename, U32 uLine, const char *pszFunc );
+
+		// Memory is given back to the arena only when the context is destroyed
+		static Void operator delete( Void *pBytes );
 
 		// placement new
 		static Void *operator new( SizeType cBytes, Void *pExistingObj );
@@ -93,6 +93,27 @@ DOLL_SCRIPT_ERROR(AlreadyInMenu, Lexer, None,
 DOLL_SCRIPT_ERROR(ExpectedMenu, Lexer, None,
 	"Expected '{' for menu choices", ())
 
+// -- Parser ---------------------------------------------------------------- //
+
+DOLL_SCRIPT_ERROR(ExpectedExpression, Parser, None,
+	"Expected an expression", ())
+DOLL_SCRIPT_ERROR(ExpectedToken, Parser, None,
+	"Expected '%0'", (Str))
+DOLL_SCRIPT_ERROR(ExpectedStatementEnd, Parser, None,
+	"Expected a new line or ';' after the statement", ())
+DOLL_SCRIPT_ERROR(ExpectedName, Parser, None,
+	"Expected a name", ())
+DOLL_SCRIPT_ERROR(ExpectedTypeName, Parser, None,
+	"Expected a type name", ())
+DOLL_SCRIPT_ERROR(ExpectedLabel, Parser, None,
+	"Expected a label (*name) after 'goto'", ())
+DOLL_SCRIPT_ERROR(ExpectedBlock, Parser, None,
+	"Expected '{' to begin a block", ())
+DOLL_SCRIPT_ERROR(UnexpectedToken, Parser, None,
+	"Unexpected '%0'", (Str))
+DOLL_SCRIPT_ERROR(NestingTooDeep, Parser, None,
+	"Code is nested too deeply", ())
+
 // -- Testing --------------------------------------------------------------- //
 
 DOLL_SCRIPT_ERROR(TestInvalidType, Testing, None,
@@ -150,6 +150,10 @@ namespace doll { namespace script {
 		virtual ~CBuiltinLogger_DiagnosticReporter();
 
 		virtual Void report( const Diagnostic &, const SDiagnosticDetails & ) override;
+
+	private:
+		// Message with the source excerpt appended
+		MutStr m_message;
 	};
 
 	class CDiagnosticEngine
@@ -251,6 +255,36 @@ namespace doll { namespace script {
 			return !testOption( kOptF_DiscardWarnings );
 		}
 
+		// While deferred, diagnostics are only recorded (not counted or
+		// reported) until flushDeferred() passes them on to another engine.
+		// Lets a worker thread diagnose without touching shared state.
+		Void enableDeferred()
+		{
+			setOption( kOptF_Deferred );
+		}
+		Void disableDeferred()
+		{
+			clearOption( kOptF_Deferred );
+		}
+		Bool isDeferred() const
+		{
+			return testOption( kOptF_Deferred );
+		}
+
+		UPtr numDeferred() const
+		{
+			return m_pDeferred.num();
+		}
+		// The `i`th diagnostic recorded while deferred
+		const Diagnostic &getDeferred( UPtr i ) const
+		{
+			AX_ASSERT( i < m_pDeferred.num() );
+			return *m_pDeferred[ i ];
+		}
+
+		// Send every recorded diagnostic, in order, to `dst`
+		Void flushDeferred( CDiagnosticEngine &dst );
+
 	protected:
 		// Added so Clang would STFU
 		inline U32 getStates_() const
@@ -264,7 +298,8 @@ namespace doll { namespace script {
 			kOptF_WarningsAreErrors = 0x00000001,
 			kOptF_ErrorsAreFatal    = 0x00000002,
 			kOptF_DiscardNotes      = 0x00000004,
-			kOptF_DiscardWarnings   = 0x00000008
+			kOptF_DiscardWarnings   = 0x00000008,
+			kOptF_Deferred          = 0x00000010
 		};
 		enum: U32
 		{
@@ -278,6 +313,7 @@ namespace doll { namespace script {
 		U32                            m_options;
 		U32                            m_states;
 		MutStr                         m_formatted;
+		TMutArr<Diagnostic *>          m_pDeferred;
 
 		inline Void setOption( U32 opt )
 		{
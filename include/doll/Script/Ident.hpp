@@ -12,7 +12,8 @@ namespace doll { namespace script {
 	class Ident: public CompilerObject
 	{
 	public:
-		// Reference to the identifier's text (this can be directly from the loaded source file)
+		// The identifier's text (a copy owned by the arena the identifier came
+		// from, since source buffers can be edited)
 		Str              name;
 		// Whether this is a keyword
 		Bool             isKeyword;
@@ -20,6 +21,9 @@ namespace doll { namespace script {
 		ESubtokenKeyword keyword;
 		// If this is a type, then which type?
 		Type *           pType;
+		// Context-wide identifier this one was merged into (only set on the
+		// identifiers of a worker's dictionary; see `CCompilerContext::lexSources`)
+		Ident *          pMerged;
 
 		Ident( CCompilerContext &ctx );
 		virtual ~Ident();
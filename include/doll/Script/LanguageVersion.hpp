@@ -14,5 +14,7 @@ namespace doll { namespace script {
 
 	// Initialize the compiler's dictionary with the given version's keywords and types
 	Bool initCompilerDictionary( CCompilerContext &ctx, IdentDictionary &dstDict, EVersion ver );
+	// Same as above, but the keyword identifiers are allocated from `arena`
+	Bool initCompilerDictionary( CCompilerContext &ctx, CCompilerArena &arena, IdentDictionary &dstDict, EVersion ver );
 
 }}
\ No newline at end of file
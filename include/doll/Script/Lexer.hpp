@@ -5,6 +5,7 @@
 #include "../Util/ValueStack.hpp"
 
 #include "Ident.hpp"
+#include "LexerState.hpp"
 #include "ProgramData.hpp"
 #include "Source.hpp"
 #include "SourceLoc.hpp"
@@ -60,12 +61,20 @@ namespace doll { namespace script {
 	{
 	public:
 		CLexer( Source &src, CDiagnosticEngine &diagEngine, IdentDictionary &dict, CProgramData &progData, const LexerOpts &opts = LexerOpts() );
+		// New identifiers are allocated from `arena` rather than the context's arena
+		CLexer( Source &src, CDiagnosticEngine &diagEngine, IdentDictionary &dict, CProgramData &progData, CCompilerArena &arena, const LexerOpts &opts = LexerOpts() );
+		// Carries on from `state` (see `saveState`) instead of the start of the source
+		CLexer( Source &src, CDiagnosticEngine &diagEngine, IdentDictionary &dict, CProgramData &progData, CCompilerArena &arena, const SLexerState &state, const LexerOpts &opts = LexerOpts() );
 		CLexer( CCompilerContext &ctx, const LexerOpts &opts = LexerOpts() );
 		~CLexer();
 
 		Bool lex( SToken &dstTok );
 		Bool peek( SToken &dstTok ) const;
 
+		// Record where the lexer is, so a later lexer can carry on from here.
+		// `uToken` is the index the next token will have in the source
+		Bool saveState( SLexerState &dst, U32 uToken ) const;
+
 		Bool skip();
 
 		Str getFilename() const
@@ -171,6 +180,7 @@ namespace doll { namespace script {
 		CDiagnosticEngine &       m_diagEngine;
 		CProgramData &            m_progData;
 		IdentDictionary &         m_dict;
+		CCompilerArena &          m_arena;
 		Str                       m_buffer;
 		TMutArr<SToken>           m_tokStack;
 		SToken                    m_nextToken;
@@ -180,8 +190,14 @@ namespace doll { namespace script {
 		TValueStack<kNumBalances> m_balance;
 		U32                       m_nestingLevels[ 3 ];
 		LexerOpts                 m_opts;
+		// Decoded text of the string being read (kept per lexer rather than
+		// shared, since lexers can run on several threads at once)
+		MutStr                    m_strBlob;
 
 		Bool lexNextToken();
+		// Whether a just read closing punctuation token has something to
+		// close; reports it if not
+		Bool checkCloser( const SToken &tok );
 
 		Bool skipWhitespaceAndComments();
 
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+#include "../Util/ValueStack.hpp"
+
+#include "Token.hpp"
+
+namespace doll { namespace script {
+
+	// Everything a CLexer needs to carry on from a point in its source. It is
+	// taken between tokens: `nextToken` has been read but not yet returned
+	struct SLexerState
+	{
+		static const unsigned kNumBalances = 3;
+
+		// Index in `Source::tokens` of `nextToken`
+		U32                       uToken;
+		// Offset in the buffer where the lexer continues (after `nextToken`)
+		U32                       uResume;
+		// The token the lexer will return next
+		SToken                    nextToken;
+		// CLexer's state flags, ()/[]/{} nesting and balance stack
+		U32                       stateFlags;
+		U32                       nestingLevels[ kNumBalances ];
+		TValueStack<kNumBalances> balance;
+
+		SLexerState()
+		: uToken( 0 )
+		, uResume( 0 )
+		, nextToken()
+		, stateFlags( 0 )
+		, nestingLevels()
+		, balance()
+		{
+			nextToken.reset();
+		}
+
+		// Whether the lexer would produce the same tokens from here as from
+		// `x`, given that everything after `x` moved by `iDelta` bytes
+		Bool resumesLike( const SLexerState &x, S32 iDelta ) const
+		{
+			if( S64( uResume ) != S64( x.uResume ) + iDelta || S64( nextToken.getOffset() ) != S64( x.nextToken.getOffset() ) + iDelta ) {
+				return false;
+			}
+
+			if( nextToken.getType() != x.nextToken.getType() || nextToken.getFlags() != x.nextToken.getFlags() ||
+			nextToken.getLength() != x.nextToken.getLength() || nextToken.isStartingLine() != x.nextToken.isStartingLine() ||
+			nextToken.value.i != x.nextToken.value.i ) {
+				return false;
+			}
+
+			if( stateFlags != x.stateFlags || balance.num() != x.balance.num() ) {
+				return false;
+			}
+
+			for( unsigned i = 0; i < kNumBalances; ++i ) {
+				if( nestingLevels[ i ] != x.nestingLevels[ i ] ) {
+					return false;
+				}
+			}
+
+			return balance == x.balance;
+		}
+	};
+
+}}
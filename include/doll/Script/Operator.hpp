@@ -93,6 +93,8 @@ enum class ECast {
 
 struct SOperator {
 	Str        operatorText;
+	// Punctuation token spelling the operator (ESubtokenPunctuation)
+	U8         punct;
 	S32        precedence;
 	EAssoc     assoc;
 	EOpType    type;
@@ -100,6 +102,27 @@ struct SOperator {
 	Bool       isAssignment;
 };
 
+// Precedence levels of the built-in operators (higher binds tighter)
+enum EPrecedence: S32 {
+	kPrec_Assignment     = 10,
+	kPrec_Conditional    = 20,
+	kPrec_NilCoalesce    = 30,
+	kPrec_RelOr          = 40,
+	kPrec_RelAnd         = 50,
+	kPrec_Comparison     = 60,
+	kPrec_Range          = 70,
+	kPrec_Additive       = 80,
+	kPrec_Multiplicative = 90,
+	kPrec_Shift          = 100,
+	kPrec_Prefix         = 110,
+	kPrec_Postfix        = 120
+};
+
+// The language's binary (infix) operators
+TArr<SOperator> getBuiltinBinaryOps();
+// The language's unary (prefix) operators
+TArr<SOperator> getBuiltinUnaryOps();
+
 inline Bool isRelOp( EBuiltinOp op ) {
 	switch( op ) {
 	case EBuiltinOp::RelAnd:
@@ -1,40 +1,143 @@
 #pragma once
 
 #include "../Core/Defs.hpp"
+#include "AST.hpp"
+#include "Diagnostics.hpp"
 #include "Lexer.hpp"
+#include "Operator.hpp"
 
 namespace doll { namespace script {
 
-class StmtSeq;
-class Expr;
-class ExprSeq;
+/*
+===============================================================================
 
-struct SToken;
-struct SOperator;
+	PARSER
 
-class CParser {
-	CLexer &m_lexer;
+	Builds a CSyntaxTree from the tokens of a CLexer. Statements are parsed
+	by recursive descent; expressions by precedence climbing (a Pratt parser)
+	driven by the operator tables, so adding an operator is a table entry.
+
+	Statements end at the end of their line, at a `;`, or before a `}`. An
+	expression carries on to the next line only while inside `(` or `[`, or
+	when the line ends in an operator that still needs its right side.
+
+	On a syntax error the parser reports it, puts a kSN_Error node where the
+	bad construct was, and skips to the start of the next statement (the
+	next line, `;` or `}` at the same brace depth), so one mistake yields
+	one diagnostic and the rest of the source is still parsed.
 
-	Expr *parseTerminal();
-	Expr *parseNameTerminal();
-	Expr *parseUnaryExpression( TArr<SOperator> ops );
-	Expr *parseSubexpression( S32 precedenceLevel, TArr<SOperator> ops );
+===============================================================================
+*/
 
+class CParser {
 public:
-	CParser( CLexer &lexer )
-	: m_lexer( lexer )
-	{
-	}
+	// Deepest nesting of expressions and blocks allowed
+	static const U32 kMaxDepth = 256;
+
+	CParser( CLexer &lexer, CDiagnosticEngine &diagEngine, CSyntaxTree &tree, TArr<SOperator> binaryOps = getBuiltinBinaryOps(), TArr<SOperator> unaryOps = getBuiltinUnaryOps() );
 	~CParser() {
 	}
 
+	// Parse the rest of the lexer's tokens into the tree's root. Returns
+	// false if there were syntax errors (the tree is still complete) or
+	// memory ran out
 	Bool parseProgram();
-	Bool parseStatement( StmtSeq &dstSeq );
-	Expr *parseExpression( Expr *prntExpr = nullptr );
-	ExprSeq *parseExpressionList( const SToken *tok = nullptr );
 
-	Bool semant();
-	Bool codegen();
+	// Parse one statement and append it to `uParent`'s children
+	Bool parseStatement( U32 uParent, U32 &uLastChild );
+	// Parse an expression; returns its node (a kSN_Error node on a syntax
+	// error, 0 if out of memory)
+	U32 parseExpression();
+
+private:
+	CLexer &            m_lexer;
+	CDiagnosticEngine & m_diagEngine;
+	CSyntaxTree &       m_tree;
+	TArr<SOperator>     m_binaryOps;
+	TArr<SOperator>     m_unaryOps;
+
+	// Index into the operator tables by punctuation subtoken (0xFF if none)
+	U8                  m_binaryIndex[ 128 ];
+	U8                  m_unaryIndex[ 128 ];
+
+	// Token being looked at (not yet consumed)
+	SToken              m_tok;
+	// Open `(` and `[` in the current expression (lines don't end it)
+	U32                 m_cGroupDepth;
+	// Current recursion depth (see `kMaxDepth`)
+	U32                 m_cDepth;
+	// Syntax errors reported
+	U32                 m_cErrors;
+	// Offset of the token the last error was reported at (one per token)
+	U32                 m_uErrorOffset;
+	// Out of memory; stop parsing
+	Bool                m_bNoMem;
+
+	Void advance();
+	Bool isPunct( U8 punct ) const;
+	Bool isKeyword( U8 keyword ) const;
+	Bool acceptPunct( U8 punct );
+	Bool expectPunct( U8 punct, const Str &text );
+	Bool expectKeyword( U8 keyword, const Str &text );
+	// Whether the token ends the current statement
+	Bool isAtStatementEnd() const;
+	// Whether the token can't continue the current expression
+	Bool isAtExpressionEnd() const;
+
+	U32 addNode( ESyntaxKind kind, const SToken &tok, U8 uFlags = 0 );
+	U32 addLeaf( ESyntaxKind kind );
+	Void append( U32 uParent, U32 &uLastChild, U32 uChild );
+
+	// Report a syntax error at `tok`
+	template< typename... TArgs >
+	Void report( const SToken &tok, TDiagnosticInfo< Void( TArgs... ) > diag, TArgs... args )
+	{
+		// Don't pile more errors on a token that already has one
+		if( m_cErrors > 0 && m_uErrorOffset == U32( tok.getOffset() ) ) {
+			return;
+		}
+
+		++m_cErrors;
+		m_uErrorOffset = U32( tok.getOffset() );
+
+		m_diagEngine.diagnose( m_lexer.getRangeFromToken( tok ), diag, args... );
+	}
+	// Report `tok` as unexpected
+	Void reportUnexpected( const SToken &tok );
+	// Count an error the lexer reported before the token now looked at
+	Void noteLexerError();
+	// Node standing in for something that couldn't be parsed
+	U32 errorNode( const SToken &tok );
+	// Skip to where the next statement begins
+	Void synchronize();
+
+	U32 parseBlock();
+	U32 parseVarDecl();
+	U32 parseFuncDecl();
+	U32 parseTypeDecl();
+	U32 parseIf();
+	U32 parseWhile();
+	U32 parseDoWhile();
+	U32 parseLoop();
+	U32 parseForIn();
+	U32 parseSwitch();
+	U32 parseMenu();
+	U32 parseReturn();
+	U32 parseKeywordLeaf( ESyntaxKind kind );
+	U32 parseDefer();
+	U32 parseGoto();
+	U32 parseDialogue();
+	U32 parseMultiMessage();
+	U32 parseTypeName();
+
+	U32 parseTerminal();
+	U32 parseNameTerminal();
+	U32 parseArrayLiteral();
+	U32 parsePostfix( U32 uOperand );
+	U32 parseUnaryExpression();
+	U32 parseSubexpression( S32 precedenceLevel );
+	// Comma separated expressions up to `closePunct`, appended to `uParent`
+	Bool parseExpressionList( U32 uParent, U32 &uLastChild, U8 closePunct, const Str &closeText );
 };
 
 }}
@@ -28,11 +28,37 @@ namespace doll { namespace script {
 		CProgramData();
 		~CProgramData();
 
+		// Add a string literal to the string table (if it isn't there already)
 		Bool addString( const Str &s );
 
+		inline UPtr getStringCount() const
+		{
+			return m_strings.num();
+		}
+		inline Str getString( UPtr uIndex ) const
+		{
+			AX_ASSERT( uIndex < m_strings.num() );
+
+			const SStringData &strdat = m_strings[ uIndex ];
+			const char *const s = ( const char * )m_blob.pointer() + strdat.uOffset;
+
+			return Str( s, s + strdat.cBytes - 1 );
+		}
+
 	private:
+		// Strings in the order they were added
 		TMutArr<SStringData> m_strings;
+		// Contents of every string (null terminated), packed back to back
 		TMutArr<U8>          m_blob;
+		// Open-addressed index into `m_strings`; each slot holds the string's
+		// index plus one (zero for an empty slot). Always a power of two
+		TMutArr<U32>         m_index;
+
+		Bool growIndex();
+		static inline U32 getIndexSlot( U64 uHash )
+		{
+			return U32( uHash ^ ( uHash>>32 ) );
+		}
 	};
 
 }}
@@ -32,4 +32,16 @@ namespace doll {
 	// written "test comments" written in that source
 	DOLL_FUNC Bool DOLL_API sc_testCurrentSource( RCompiler *compiler );
 
+	// Lex every opened source that hasn't been lexed yet, spread over up to
+	// `cThreads` threads (0 picks a default). Diagnostics are reported in
+	// source order and the results don't depend on the number of threads
+	DOLL_FUNC Bool DOLL_API sc_lexSources( RCompiler *compiler, U32 cThreads = 0 );
+	// Keep lexed sources in `dir` so unchanged sources needn't be lexed again
+	// on the next run (an empty string disables this)
+	DOLL_FUNC Bool DOLL_API sc_setTokenCacheDir( RCompiler *compiler, const Str &dir );
+	// Replace `cRemoveBytes` bytes at `uOffset` of the current source with
+	// `text`; if the source was lexed, only the part around the edit is
+	// lexed again
+	DOLL_FUNC Bool DOLL_API sc_editSource( RCompiler *compiler, U32 uOffset, U32 cRemoveBytes, const Str &text );
+
 }
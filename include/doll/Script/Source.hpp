@@ -3,6 +3,7 @@
 #include "../Core/Defs.hpp"
 
 #include "CompilerMemory.hpp"
+#include "LexerState.hpp"
 #include "Token.hpp"
 
 namespace doll { namespace script {
@@ -16,12 +17,44 @@ namespace doll { namespace script {
 		// Source buffer
 		MutStr      buffer;
 
+		// Tokens of the whole file (filled in by `CCompilerContext::lexSources`)
+		TMutArr<SToken> tokens;
+		// Whether `tokens` is complete
+		Bool        isLexed;
+		// Lexer states saved every so often while lexing, in token order, so
+		// an edit only needs to be lexed again from the state just before it
+		// (kept in the token cache along with the tokens)
+		TMutArr<SLexerState> lexStates;
+		// Whether lexSources() loaded `tokens` from the token cache
+		Bool        isFromTokenCache;
+		// Number of tokens the last editSource() lexed again
+		U32         cRelexedTokens;
+
 		// Index of this source file
 		U16         index;
 		static const U16 kMaxSources = U16( 1 )<<12;
 
 		Source( CCompilerContext &ctx );
 		virtual ~Source();
+
+		// Build the line table if it hasn't been built yet (called lazily
+		// by the functions below)
+		Bool calcLineStarts() const;
+		// Forget the line table after the buffer changes
+		Void clearLineStarts();
+
+		// Number of lines in the buffer (an empty buffer has one line)
+		U32 numLines() const;
+		// Zero-based line containing the given byte offset
+		U32 findLine( U32 uOffset ) const;
+		// Byte offset at which the given zero-based line starts
+		U32 getLineStart( U32 uLine ) const;
+		// Text of the given zero-based line, without its line break
+		Str getLineText( U32 uLine ) const;
+
+	private:
+		// Byte offset of the start of each line, in order
+		mutable TMutArr<U32> m_lineStarts;
 	};
 
 }}
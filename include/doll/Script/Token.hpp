@@ -635,6 +635,27 @@ namespace doll { namespace script {
 		{
 			return getType() == kTT_None && getFlags() == kTN_Error;
 		}
+		// Check if `value.p` refers to an identifier (see `CLexer::readIdent`)
+		inline Bool hasIdent() const
+		{
+			switch( getType() ) {
+			case kTT_Keyword:
+			case kTT_Name:
+			case kTT_Type:
+			case kTT_Label:
+			case kTT_ConfigVar:
+			case kTT_SystemVar:
+			case kTT_TagRef:
+			case kTT_ProgTagRef:
+			case kTT_CharRef:
+				return true;
+
+			default:
+				break;
+			}
+
+			return false;
+		}
 	};
 #pragma pack(pop)
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+#include "CompilerMemory.hpp"
+#include "Ident.hpp"
+#include "LanguageVersion.hpp"
+#include "ProgramData.hpp"
+#include "Source.hpp"
+
+/*
+===============================================================================
+
+	TOKEN CACHE
+
+	Lexing a source only depends on its contents and the language version,
+	so the result can be saved to disk and reused on the next run. A cache
+	file holds one source's token stream, the identifiers its tokens refer
+	to, the strings it added to the string table, and the lexer states
+	saved along the way (so editSource() on a cached source still only
+	lexes the edited part again). The file is named after a hash of the
+	source's contents.
+
+	Files are flat (offsets and indexes only, no pointers) so they can be
+	used straight from the loaded image. Identifier names are stored as
+	ranges of the source buffer rather than copied. Loading rebuilds the
+	same per-source tables the lexer would have produced, so the rest of
+	the compiler can't tell a cached source from a freshly lexed one.
+
+===============================================================================
+*/
+
+namespace doll { namespace script {
+
+	// Bump this whenever the lexer's output or the layout of `SToken` or
+	// `SLexerState` changes
+	static const U16 kTokenCacheFormat = 3;
+
+	enum class ETokenCacheResult
+	{
+		// Loaded; the source's tokens, identifiers and strings were filled in
+		Hit,
+		// No usable cache file (missing, stale, or for another version)
+		Miss,
+		// A valid cache file was found but couldn't be loaded (out of memory)
+		Failed
+	};
+
+	// Fill in `src.tokens` and `src.lexStates` from its cache file in
+	// `cacheDir`. Identifiers are added to `dict`, allocated from `arena`.
+	// Strings are added to `progData`.
+	ETokenCacheResult loadTokenCache( const Str &cacheDir, Source &src, EVersion ver, CCompilerArena &arena, IdentDictionary &dict, CProgramData &progData );
+	// Write the cache file for a freshly lexed source. `progData` must hold
+	// only the strings this source added (in order), and the tokens must
+	// still refer to identifiers named from this source or keywords
+	Bool saveTokenCache( const Str &cacheDir, const Source &src, EVersion ver, const CProgramData &progData );
+	// Path of the cache file in `cacheDir` for the current contents of `src`
+	Bool getTokenCacheFilename( MutStr &dst, const Str &cacheDir, const Source &src );
+
+}}
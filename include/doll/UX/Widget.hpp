@@ -10,6 +10,8 @@
 #include "../OS/Key.hpp"
 #include "../OS/Window.hpp"
 
+#include "WidgetIndex.hpp"
+
 namespace doll
 {
 
@@ -148,6 +150,7 @@ namespace doll
 	private:
 		TIntrList<IWidget> m_widgets;
 		TIntrList<IWidget> m_refreshWidgets;
+		CWidgetIndex       m_pickIndex;
 		IWidget *          m_pHoverWidget;
 		RLayer *           m_pWidgetLayer;
 
@@ -274,6 +277,7 @@ namespace doll
 
 			m_pParent = pParent;
 			newSiblings.addTail( m_siblings );
+			linkPickEntry( pParent != nullptr ? pParent->m_childIndex : DOLL__UX_WIDGETS.m_pickIndex );
 
 			if( m_pLayer != nullptr ) {
 				updateLayerParent();
@@ -283,6 +287,45 @@ namespace doll
 			onParentChanged( pOldParent );
 		}
 
+		//! Show or hide the widget
+		//!
+		//! Hidden widgets (and their subwidgets) are neither drawn nor picked.
+		inline Void setVisible( Bool bVisible )
+		{
+			if( m_bVisible == bVisible ) {
+				return;
+			}
+
+			m_bVisible = bVisible;
+
+			if( bVisible ) {
+				insertPickEntry();
+				invalidate();
+			} else {
+				removePickEntry();
+			}
+
+			if( m_pLayer != nullptr ) {
+				gfx_setLayerVisible( m_pLayer, bVisible );
+			}
+		}
+		//! Determine whether the widget itself is visible
+		inline Bool isVisible() const
+		{
+			return m_bVisible;
+		}
+		//! Determine whether the widget and all of its ancestors are visible
+		inline Bool isShown() const
+		{
+			for( const IWidget *pTest = this; pTest != nullptr; pTest = pTest->m_pParent ) {
+				if( !pTest->m_bVisible ) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
 		//! Initialize the layer
 		inline Bool initLayer()
 		{
@@ -352,6 +395,9 @@ namespace doll
 		}
 
 		//! Determine whether a given offset intersects the widget
+		//!
+		//! Only offsets within the widget's shape are tested; `MWidgets`
+		//! culls everything else through its pick index before calling this.
 		virtual Bool pick( const SIntVector2 &localOffset ) const = 0;
 
 		//! Handle a key press event
@@ -391,6 +437,11 @@ namespace doll
 		, m_children()
 		, m_refreshLink( this )
 		, m_pLayer( nullptr )
+		, m_childIndex()
+		, m_pPickIndex( nullptr )
+		, m_uPickLeaf( CWidgetIndex::kNull )
+		, m_uPickOrder( 0 )
+		, m_bVisible( true )
 		{
 			DOLL__UX_WIDGETS.m_refreshWidgets.addTail( m_refreshLink );
 		}
@@ -402,6 +453,8 @@ namespace doll
 			while( m_children.isUsed() ) {
 				mgr.deleteWidget( m_children.head() );
 			}
+
+			removePickEntry();
 		}
 
 	private:
@@ -412,6 +465,52 @@ namespace doll
 		TIntrLink<IWidget> m_refreshLink;
 		RLayer *           m_pLayer;
 
+		// Pick index over `m_children`
+		CWidgetIndex       m_childIndex;
+		// Index of the sibling list this widget is in, and its entry there
+		CWidgetIndex *     m_pPickIndex;
+		U32                m_uPickLeaf;
+		U64                m_uPickOrder;
+		Bool               m_bVisible;
+
+		// Called whenever the widget is appended to a sibling list
+		inline Void linkPickEntry( CWidgetIndex &index )
+		{
+			removePickEntry();
+
+			m_pPickIndex = &index;
+			m_uPickOrder = index.allocOrder();
+
+			insertPickEntry();
+		}
+		inline Void insertPickEntry()
+		{
+			if( !m_bVisible || !m_pPickIndex || m_uPickLeaf != CWidgetIndex::kNull ) {
+				return;
+			}
+
+			m_uPickLeaf = m_pPickIndex->insert( this, m_shape, m_uPickOrder );
+		}
+		inline Void removePickEntry()
+		{
+			if( m_uPickLeaf == CWidgetIndex::kNull ) {
+				return;
+			}
+
+			AX_ASSERT_NOT_NULL( m_pPickIndex );
+			m_pPickIndex->remove( m_uPickLeaf );
+			m_uPickLeaf = CWidgetIndex::kNull;
+		}
+		inline Void updatePickEntry()
+		{
+			if( m_uPickLeaf == CWidgetIndex::kNull ) {
+				return;
+			}
+
+			AX_ASSERT_NOT_NULL( m_pPickIndex );
+			m_pPickIndex->update( m_uPickLeaf, m_shape );
+		}
+
 		inline Void updateLayerParent()
 		{
 			if( !m_pLayer ) {
@@ -445,11 +544,14 @@ namespace doll
 
 		virtual Void setShape( const SRect &shape ) override
 		{
-			if( m_shape != shape ) {
-				invalidate();
+			if( m_shape == shape ) {
+				return;
 			}
 
+			invalidate();
+
 			m_shape = shape;
+			updatePickEntry();
 		}
 		virtual Bool pick( const SIntVector2 &localOffset ) const override
 		{
@@ -494,6 +596,7 @@ namespace doll
 		IWidget *const pWidget = static_cast< IWidget * >( p );
 
 		m_widgets.addTail( pWidget->m_siblings );
+		pWidget->linkPickEntry( m_pickIndex );
 		return p;
 	}
 	template< typename T, typename... TArgs >
@@ -511,6 +614,7 @@ namespace doll
 		IWidget *const pWidget = reinterpret_cast< IWidget * >( p );
 
 		m_widgets.addTail( pWidget->m_siblings );
+		pWidget->linkPickEntry( m_pickIndex );
 		return ( T * )pWidget;
 	}
 
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Core/Defs.hpp"
+
+#include "../Math/IntVector2.hpp"
+#include "../Math/Rect.hpp"
+
+namespace doll
+{
+
+	class IWidget;
+
+	/*
+	===========================================================================
+
+		WIDGET PICK INDEX
+
+		Bounding volume hierarchy over the shapes of one sibling list (the
+		root widgets, or the children of a single widget). Shapes are stored
+		in the parent's local space, exactly as `IWidget::getShape()` returns
+		them, so moving a parent never touches its children's entries.
+
+		The tree is kept balanced as leaves are inserted, moved and removed,
+		so a pick costs O(log n) per level of the widget hierarchy instead of
+		a walk over every sibling.
+
+		Every leaf carries the widget's sibling order. Siblings earlier in
+		the list take priority when they overlap, so a pick returns the
+		lowest-ordered hit; subtrees whose lowest order can't beat the
+		current best are skipped.
+
+	===========================================================================
+	*/
+
+	//! \internal
+	class CWidgetIndex
+	{
+	public:
+		static constexpr U32 kNull = ~U32( 0 );
+
+		CWidgetIndex();
+		~CWidgetIndex();
+
+		//! Retrieve the order key for a widget being added to the end of the sibling list
+		inline U64 allocOrder()
+		{
+			return ++m_uLastOrder;
+		}
+
+		//! Add a widget's shape, returning the leaf that refers to it
+		U32 insert( IWidget *pWidget, const SRect &shape, U64 uOrder );
+		//! Remove a leaf returned by `insert()`
+		Void remove( U32 uLeaf );
+		//! Update the shape of a leaf (the leaf index does not change)
+		Void update( U32 uLeaf, const SRect &shape );
+
+		//! Find the first widget (in sibling order) whose shape contains `pos`
+		//! and whose `pick()` accepts it; `pos` is in the parent's local space
+		IWidget *pick( const SIntVector2 &pos ) const;
+
+		//! Number of widgets currently in the index
+		inline U32 getLeafCount() const
+		{
+			return m_cLeaves;
+		}
+		//! Height of the tree (0 if empty)
+		inline S32 getHeight() const
+		{
+			return m_uRoot != kNull ? m_pNodes[ m_uRoot ].iHeight + 1 : 0;
+		}
+
+	private:
+		struct SNode
+		{
+			SRect    box;
+			// Lowest sibling order of any leaf in this subtree
+			U64      uMinOrder;
+			// Widget (leaves only)
+			IWidget *pWidget;
+			// Parent node, or the next free node when unused
+			U32      uParent;
+			U32      uChild1;
+			U32      uChild2;
+			// 0 for leaves, -1 for free nodes
+			S32      iHeight;
+
+			inline Bool isLeaf() const
+			{
+				return uChild1 == kNull;
+			}
+		};
+
+		SNode *m_pNodes;
+		U32    m_cNodes;
+		U32    m_cCapacity;
+		U32    m_uRoot;
+		U32    m_uFreeList;
+		U32    m_cLeaves;
+		U64    m_uLastOrder;
+
+		Bool reserveNodes( U32 cNodes );
+		U32 allocNode();
+		Void freeNode( U32 uNode );
+
+		Void insertLeaf( U32 uLeaf );
+		Void removeLeaf( U32 uLeaf );
+		Void refit( U32 uNode );
+		U32 balance( U32 uNode );
+		Void fixUpwards( U32 uNode );
+
+		CWidgetIndex( const CWidgetIndex & ) AX_DELETE_FUNC;
+		CWidgetIndex &operator=( const CWidgetIndex & ) AX_DELETE_FUNC;
+	};
+
+}
@@ -3,6 +3,7 @@
 #include "../Core/Defs.hpp"
 #include "../Core/Memory.hpp"
 #include "../Core/MemoryTags.hpp"
+#include "../Core/Handle.hpp"
 
 namespace doll
 {
@@ -64,20 +65,18 @@ namespace doll
 		Void activateMicroseconds( U64 uTimeInMicroseconds );
 		Void deactivate();
 
+		// Number of counter slots currently live in the registry
+		static U32 getLiveCount();
+
 	private:
-		static TIntrList< CFrameCounter > gFrameCounters;
-		static ax::CQuickMutex            gListAccessor;
-
-		FnCalculateFrameCounter    mpfnCalculate;
-		Void *                     mpParm;
-		EFrameCounterMode          mMode;
-		U64                        muStart;
-		U64                        muEnd;
-		F64                        mfCurrent;
-		F64                        mfRange[ 2 ];
-		TIntrLink< CFrameCounter > mSiblings;
-
-		Void update();
+		// The counter's state lives in the registry's SoA table (see
+		// Counter.cpp); this is the generational handle to that slot
+		internal::HandleImpl mHandle;
+
+		U32 slot() const;
+
+		// Each counter owns its slot; a copy would release it twice
+		AX_DELETE_COPYFUNCS( CFrameCounter );
 	};
 
 }
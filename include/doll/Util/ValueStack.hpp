@@ -34,6 +34,10 @@ namespace doll
 			{
 				return x.last();
 			}
+			static inline const ValueStoreType &at( const TArrType &x, unsigned i )
+			{
+				return x[ i ];
+			}
 		};
 
 	}
@@ -138,6 +142,26 @@ namespace doll
 			return m_cValues != 0;
 		}
 
+		inline Bool operator==( const TValueStack &x ) const
+		{
+			if( m_cValues != x.m_cValues || m_mainValue != x.m_mainValue ) {
+				return false;
+			}
+
+			// Same number of values means the same number of extra items
+			for( SizeType i = 0; i < m_cValues/kValuesPerItem; ++i ) {
+				if( MutArrAdapter::at( m_extraValues, i ) != MutArrAdapter::at( x.m_extraValues, i ) ) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+		inline Bool operator!=( const TValueStack &x ) const
+		{
+			return !( *this == x );
+		}
+
 	private:
 		typedef detail::TValueStackMutArrAdapter< TDynArr > MutArrAdapter;
 
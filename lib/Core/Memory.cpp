@@ -4,6 +4,9 @@
 #include "doll/Core/Memory.hpp"
 #include "doll/Core/MemoryTags.hpp"
 #include "doll/Core/Logger.hpp"
+#include "doll/Core/MemoryTelemetry.hpp"
+
+#include <atomic>
 
 namespace doll
 {
@@ -81,6 +84,20 @@ namespace doll
 
 		static STagStats tags[ kMaxTags ];
 
+		// Kept separately from STagStats since these are never reset and must
+		// stay exact when several threads allocate at once
+		struct STagLiveStats
+		{
+			std::atomic< U64 > cLiveBytes;
+			std::atomic< U64 > cPeakBytes;
+			std::atomic< U64 > cLiveAllocs;
+			std::atomic< U64 > cTotalAllocs;
+			std::atomic< U64 > cTotalAllocBytes;
+			std::atomic< U64 > cTotalFreeBytes;
+		};
+
+		static STagLiveStats liveTags[ kMaxTags ];
+
 		void initTags()
 		{
 			memset( &tags[ 0 ], 0, sizeof( tags ) );
@@ -125,6 +142,29 @@ namespace doll
 			return tags[ tag ].name;
 		}
 
+		void getTagLiveCounts( int tag, STagLiveCounts &dst )
+		{
+			if( ( UPtr )tag >= kMaxTags ) {
+				memset( &dst, 0, sizeof( dst ) );
+				return;
+			}
+
+			const STagLiveStats &t = liveTags[ tag ];
+
+			dst.cLiveBytes = t.cLiveBytes.load( std::memory_order_relaxed );
+			dst.cPeakBytes = t.cPeakBytes.load( std::memory_order_relaxed );
+			dst.cLiveAllocs = t.cLiveAllocs.load( std::memory_order_relaxed );
+			dst.cTotalAllocs = t.cTotalAllocs.load( std::memory_order_relaxed );
+			dst.cTotalAllocBytes = t.cTotalAllocBytes.load( std::memory_order_relaxed );
+			dst.cTotalFreeBytes = t.cTotalFreeBytes.load( std::memory_order_relaxed );
+		}
+		void resetTagPeaks()
+		{
+			for( UPtr i = 0; i < kMaxTags; ++i ) {
+				liveTags[ i ].cPeakBytes.store( liveTags[ i ].cLiveBytes.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+			}
+		}
+
 		void enableTagReporting()
 		{
 			reportingEnabled = true;
@@ -166,6 +206,19 @@ namespace doll
 			t.avgAllocSize += ( UPtr )( double( size - t.avgAllocSize )/
 										  double( t.avgAllocSize ) );
 
+			STagLiveStats &l = liveTags[ tag ];
+
+			const U64 cLive = l.cLiveBytes.fetch_add( size, std::memory_order_relaxed ) + size;
+			l.cLiveAllocs.fetch_add( 1, std::memory_order_relaxed );
+			l.cTotalAllocs.fetch_add( 1, std::memory_order_relaxed );
+			l.cTotalAllocBytes.fetch_add( size, std::memory_order_relaxed );
+
+			U64 cPeak = l.cPeakBytes.load( std::memory_order_relaxed );
+			while( cLive > cPeak && !l.cPeakBytes.compare_exchange_weak( cPeak, cLive, std::memory_order_relaxed ) ) {
+			}
+
+			telemetryRecordAlloc( p, size, tag, file, line, func );
+
 			if( reportingEnabled ) {
 				char buf[ 512 ];
 
@@ -191,6 +244,14 @@ namespace doll
 			++t.numDeallocs;
 			t.totalDeallocSize += size;
 
+			STagLiveStats &l = liveTags[ tag ];
+
+			l.cLiveBytes.fetch_sub( size, std::memory_order_relaxed );
+			l.cLiveAllocs.fetch_sub( 1, std::memory_order_relaxed );
+			l.cTotalFreeBytes.fetch_add( size, std::memory_order_relaxed );
+
+			telemetryRecordDealloc( p, size, tag );
+
 			if( reportingEnabled ) {
 				char buf[ 512 ];
 
@@ -0,0 +1,830 @@
+#define DOLL_TRACE_FACILITY doll::kLog_CoreMemory
+#include "../BuildSettings.hpp"
+
+#include "doll/Core/MemoryTelemetry.hpp"
+#include "doll/Core/Engine.hpp"
+#include "doll/Core/Logger.hpp"
+#include "doll/IO/VFS.hpp"
+
+#ifndef DOLL_MEMTELEMETRY_SITES
+# if DOLL_BUILD_VARIANT == DOLL_VARIANT_DEVELOPMENT || DOLL_BUILD_VARIANT == DOLL_VARIANT_DEBUG
+#  define DOLL_MEMTELEMETRY_SITES 1
+# else
+#  define DOLL_MEMTELEMETRY_SITES 0
+# endif
+#endif
+
+#if DOLL_MEMTELEMETRY_SITES
+# ifdef _WIN32
+#  include <Windows.h>
+# else
+#  include <execinfo.h>
+# endif
+# include <stdlib.h> // malloc/realloc/free
+# include <string.h> // memset
+#endif
+
+namespace doll
+{
+
+	/*
+	===========================================================================
+
+		SNAPSHOT HISTORY
+
+	===========================================================================
+	*/
+
+	static const U32 kDefaultSnapshotHistory = 120;
+
+	static TMutArr< SMemSnapshot > g_snapshots;
+	// Index of the oldest snapshot in g_snapshots (a ring once it is full)
+	static U32                     g_uFirstSnapshot     = 0;
+	static U32                     g_cSnapshots         = 0;
+	static U32                     g_cSnapshotHistory   = kDefaultSnapshotHistory;
+	static U32                     g_uSnapshotInterval  = 0;
+	static U64                     g_uLastSnapshotTime  = 0;
+
+	// Totals at the previous snapshot; rates are measured against these
+	static Bool                    g_bHaveRateBase      = false;
+	static U64                     g_uRateBaseTime      = 0;
+	static Mem::STagLiveCounts     g_rateBase[ kMaxTags ];
+
+	static Void sampleTags( SMemSnapshot &dst )
+	{
+		dst.uTimeMicrosecs = microseconds();
+		dst.uFrameId = g_core.frame.uUpdateId;
+
+		const F64 fElapsedSecs = g_bHaveRateBase && dst.uTimeMicrosecs > g_uRateBaseTime ? F64( dst.uTimeMicrosecs - g_uRateBaseTime )/1000000.0 : 0.0;
+
+		for( UPtr i = 0; i < kMaxTags; ++i ) {
+			Mem::STagLiveCounts counts;
+			Mem::getTagLiveCounts( int( i ), counts );
+
+			SMemTagSample &t = dst.tags[ i ];
+
+			t.cLiveBytes = counts.cLiveBytes;
+			t.cPeakBytes = counts.cPeakBytes;
+			t.cLiveAllocs = counts.cLiveAllocs;
+			t.cTotalAllocs = counts.cTotalAllocs;
+			t.cTotalAllocBytes = counts.cTotalAllocBytes;
+			t.cTotalFreeBytes = counts.cTotalFreeBytes;
+
+			if( fElapsedSecs > 0.0 ) {
+				const Mem::STagLiveCounts &base = g_rateBase[ i ];
+
+				t.fAllocsPerSec = F64( counts.cTotalAllocs - base.cTotalAllocs )/fElapsedSecs;
+				t.fAllocBytesPerSec = F64( counts.cTotalAllocBytes - base.cTotalAllocBytes )/fElapsedSecs;
+				t.fFreeBytesPerSec = F64( counts.cTotalFreeBytes - base.cTotalFreeBytes )/fElapsedSecs;
+			} else {
+				t.fAllocsPerSec = 0.0;
+				t.fAllocBytesPerSec = 0.0;
+				t.fFreeBytesPerSec = 0.0;
+			}
+
+			g_rateBase[ i ] = counts;
+		}
+
+		g_bHaveRateBase = true;
+		g_uRateBaseTime = dst.uTimeMicrosecs;
+	}
+	static Void pushSnapshot( const SMemSnapshot &snap )
+	{
+		if( !g_cSnapshotHistory ) {
+			return;
+		}
+
+		if( g_snapshots.num() < g_cSnapshotHistory ) {
+			if( !AX_VERIFY_MEMORY( g_snapshots.append( snap ) ) ) {
+				return;
+			}
+
+			++g_cSnapshots;
+			return;
+		}
+
+		// Full; overwrite the oldest
+		g_snapshots[ g_uFirstSnapshot ] = snap;
+		g_uFirstSnapshot = ( g_uFirstSnapshot + 1 )%g_cSnapshotHistory;
+	}
+	static const SMemSnapshot &snapshotAt( U32 uIndex )
+	{
+		AX_ASSERT( uIndex < g_cSnapshots );
+		return g_snapshots[ ( g_uFirstSnapshot + uIndex )%g_snapshots.num() ];
+	}
+
+	DOLL_FUNC Void DOLL_API mem_setSnapshotInterval( U32 uMilliseconds )
+	{
+		g_uSnapshotInterval = uMilliseconds;
+		g_uLastSnapshotTime = microseconds();
+	}
+	DOLL_FUNC U32 DOLL_API mem_getSnapshotInterval()
+	{
+		return g_uSnapshotInterval;
+	}
+	DOLL_FUNC Bool DOLL_API mem_setSnapshotHistory( U32 cSnapshots )
+	{
+		// Re-linearize the ring, keeping the newest snapshots
+		const U32 cKeep = g_cSnapshots < cSnapshots ? g_cSnapshots : cSnapshots;
+
+		TMutArr< SMemSnapshot > kept;
+		if( !AX_VERIFY_MEMORY( kept.resize( cKeep ) ) ) {
+			return false;
+		}
+		for( U32 i = 0; i < cKeep; ++i ) {
+			kept[ i ] = snapshotAt( g_cSnapshots - cKeep + i );
+		}
+
+		if( !AX_VERIFY_MEMORY( g_snapshots.resize( cKeep ) ) ) {
+			return false;
+		}
+		for( U32 i = 0; i < cKeep; ++i ) {
+			g_snapshots[ i ] = kept[ i ];
+		}
+
+		g_uFirstSnapshot = 0;
+		g_cSnapshots = cKeep;
+		g_cSnapshotHistory = cSnapshots;
+
+		return true;
+	}
+	DOLL_FUNC U32 DOLL_API mem_getSnapshotHistory()
+	{
+		return g_cSnapshotHistory;
+	}
+
+	DOLL_FUNC Void DOLL_API mem_takeSnapshot( SMemSnapshot &dst )
+	{
+		sampleTags( dst );
+		pushSnapshot( dst );
+	}
+	DOLL_FUNC U32 DOLL_API mem_getSnapshotCount()
+	{
+		return g_cSnapshots;
+	}
+	DOLL_FUNC Bool DOLL_API mem_getSnapshot( U32 uIndex, SMemSnapshot &dst )
+	{
+		if( uIndex >= g_cSnapshots ) {
+			return false;
+		}
+
+		dst = snapshotAt( uIndex );
+		return true;
+	}
+	DOLL_FUNC Void DOLL_API mem_clearSnapshots()
+	{
+		g_snapshots.clear();
+		g_uFirstSnapshot = 0;
+		g_cSnapshots = 0;
+	}
+
+	DOLL_FUNC Void DOLL_API mem_resetPeaks()
+	{
+		Mem::resetTagPeaks();
+	}
+
+	DOLL_FUNC Void DOLL_API mem_diffSnapshots( SMemSnapshotDiff &dst, const SMemSnapshot &before, const SMemSnapshot &after )
+	{
+		dst.uElapsedMicrosecs = after.uTimeMicrosecs - before.uTimeMicrosecs;
+		dst.cElapsedFrames = after.uFrameId - before.uFrameId;
+		dst.iTotalLiveBytes = S64( after.getTotalLiveBytes() ) - S64( before.getTotalLiveBytes() );
+
+		for( UPtr i = 0; i < kMaxTags; ++i ) {
+			const SMemTagSample &a = before.tags[ i ];
+			const SMemTagSample &b = after.tags[ i ];
+			SMemTagDelta &d = dst.tags[ i ];
+
+			d.iLiveBytes = S64( b.cLiveBytes ) - S64( a.cLiveBytes );
+			d.iLiveAllocs = S64( b.cLiveAllocs ) - S64( a.cLiveAllocs );
+			d.iPeakBytes = S64( b.cPeakBytes ) - S64( a.cPeakBytes );
+			d.cAllocs = b.cTotalAllocs - a.cTotalAllocs;
+			d.cAllocBytes = b.cTotalAllocBytes - a.cTotalAllocBytes;
+			d.cFreeBytes = b.cTotalFreeBytes - a.cTotalFreeBytes;
+		}
+	}
+
+	/*
+	===========================================================================
+
+		ALLOCATION SITES
+
+		Each tracked allocation is mapped from its address to the site that
+		made it, so a deallocation can be credited back to that site. Both
+		tables are open-addressed and live on the CRT heap, never on a Doll
+		allocator, so recording never re-enters the tagging hooks.
+
+	===========================================================================
+	*/
+
+#if DOLL_MEMTELEMETRY_SITES
+	struct SSiteRecord
+	{
+		SMemAllocSite site;
+		U64           cMarkBytes;
+	};
+	struct SLiveAlloc
+	{
+		void *p;
+		U32   uSite;
+	};
+
+	static ax::CQuickMutex g_siteLock;
+	static Bool            g_bTrackSites    = false;
+
+	static SSiteRecord *   g_pSites         = nullptr;
+	static U32             g_cSites         = 0;
+	static U32             g_cMaxSites      = 0;
+	// Open-addressed; site index + 1, zero for empty
+	static U32 *           g_pSiteBuckets   = nullptr;
+	static U32             g_cSiteBuckets   = 0;
+
+	// Open-addressed (linear probing); null p for empty
+	static SLiveAlloc *    g_pLiveAllocs    = nullptr;
+	static UPtr            g_cLiveAllocs    = 0;
+	static UPtr            g_cAllocBuckets  = 0;
+
+	static thread_local Bool t_bInSiteHook = false;
+
+	static inline U64 hashStep( U64 h, U64 x )
+	{
+		// FNV-1a over the eight bytes of x
+		for( U32 i = 0; i < 8; ++i ) {
+			h ^= ( x>>( i*8 ) ) & 0xFF;
+			h *= U64( 0x100000001B3 );
+		}
+		return h;
+	}
+	static inline UPtr hashPointer( const void *p )
+	{
+		U64 x = U64( UPtr( p ) );
+		x ^= x>>33;
+		x *= U64( 0xFF51AFD7ED558CCD );
+		x ^= x>>33;
+		return UPtr( x );
+	}
+
+	static UPtr captureCallstack( UPtr *pDst, UPtr cMax )
+	{
+		// Skip ourselves, telemetryRecordAlloc(), and Mem::tagAlloc()
+		static const UPtr kSkipFrames = 3;
+
+		void *frames[ kMaxMemSiteFrames + kSkipFrames ];
+		UPtr cFrames = 0;
+
+# ifdef _WIN32
+		cFrames = UPtr( RtlCaptureStackBackTrace( 0, DWORD( cMax + kSkipFrames ), frames, nullptr ) );
+# else
+		const int n = backtrace( frames, int( cMax + kSkipFrames ) );
+		cFrames = n > 0 ? UPtr( n ) : 0;
+# endif
+
+		if( cFrames <= kSkipFrames ) {
+			return 0;
+		}
+
+		cFrames -= kSkipFrames;
+		for( UPtr i = 0; i < cFrames; ++i ) {
+			pDst[ i ] = UPtr( frames[ kSkipFrames + i ] );
+		}
+
+		return cFrames;
+	}
+
+	static Bool growSiteBuckets()
+	{
+		const U32 cNewBuckets = g_cSiteBuckets ? g_cSiteBuckets*2 : 1024;
+		U32 *const pNewBuckets = ( U32 * )calloc( cNewBuckets, sizeof( U32 ) );
+		if( !pNewBuckets ) {
+			return false;
+		}
+
+		for( U32 i = 0; i < g_cSites; ++i ) {
+			U32 b = U32( g_pSites[ i ].site.uHash ) & ( cNewBuckets - 1 );
+			while( pNewBuckets[ b ] != 0 ) {
+				b = ( b + 1 ) & ( cNewBuckets - 1 );
+			}
+			pNewBuckets[ b ] = i + 1;
+		}
+
+		free( ( void * )g_pSiteBuckets );
+		g_pSiteBuckets = pNewBuckets;
+		g_cSiteBuckets = cNewBuckets;
+
+		return true;
+	}
+	static U32 findOrAddSite( U64 uHash, int tag, const char *file, int line, const char *func, const UPtr *pFrames, UPtr cFrames )
+	{
+		if( ( g_cSites + 1 )*2 > g_cSiteBuckets && !growSiteBuckets() ) {
+			return ~U32( 0 );
+		}
+
+		U32 b = U32( uHash ) & ( g_cSiteBuckets - 1 );
+		while( g_pSiteBuckets[ b ] != 0 ) {
+			const U32 uSite = g_pSiteBuckets[ b ] - 1;
+			if( g_pSites[ uSite ].site.uHash == uHash ) {
+				return uSite;
+			}
+
+			b = ( b + 1 ) & ( g_cSiteBuckets - 1 );
+		}
+
+		if( g_cSites == g_cMaxSites ) {
+			const U32 cNewMax = g_cMaxSites ? g_cMaxSites*2 : 512;
+			SSiteRecord *const pNewSites = ( SSiteRecord * )realloc( ( void * )g_pSites, sizeof( SSiteRecord )*cNewMax );
+			if( !pNewSites ) {
+				return ~U32( 0 );
+			}
+
+			g_pSites = pNewSites;
+			g_cMaxSites = cNewMax;
+		}
+
+		const U32 uSite = g_cSites++;
+		SSiteRecord &rec = g_pSites[ uSite ];
+		memset( ( void * )&rec, 0, sizeof( rec ) );
+
+		rec.site.uHash = uHash;
+		rec.site.tag = tag;
+		rec.site.pszFile = file;
+		rec.site.iLine = line;
+		rec.site.pszFunc = func;
+		rec.site.cFrames = cFrames;
+		for( UPtr i = 0; i < cFrames; ++i ) {
+			rec.site.frames[ i ] = pFrames[ i ];
+		}
+
+		g_pSiteBuckets[ b ] = uSite + 1;
+		return uSite;
+	}
+
+	static Bool growAllocBuckets()
+	{
+		const UPtr cNewBuckets = g_cAllocBuckets ? g_cAllocBuckets*2 : 4096;
+		SLiveAlloc *const pNewAllocs = ( SLiveAlloc * )calloc( cNewBuckets, sizeof( SLiveAlloc ) );
+		if( !pNewAllocs ) {
+			return false;
+		}
+
+		for( UPtr i = 0; i < g_cAllocBuckets; ++i ) {
+			const SLiveAlloc &a = g_pLiveAllocs[ i ];
+			if( !a.p ) {
+				continue;
+			}
+
+			UPtr b = hashPointer( a.p ) & ( cNewBuckets - 1 );
+			while( pNewAllocs[ b ].p != nullptr ) {
+				b = ( b + 1 ) & ( cNewBuckets - 1 );
+			}
+			pNewAllocs[ b ] = a;
+		}
+
+		free( ( void * )g_pLiveAllocs );
+		g_pLiveAllocs = pNewAllocs;
+		g_cAllocBuckets = cNewBuckets;
+
+		return true;
+	}
+	static Void insertLiveAlloc( void *p, U32 uSite )
+	{
+		if( ( g_cLiveAllocs + 1 )*2 > g_cAllocBuckets && !growAllocBuckets() ) {
+			return;
+		}
+
+		UPtr b = hashPointer( p ) & ( g_cAllocBuckets - 1 );
+		while( g_pLiveAllocs[ b ].p != nullptr ) {
+			b = ( b + 1 ) & ( g_cAllocBuckets - 1 );
+		}
+
+		g_pLiveAllocs[ b ].p = p;
+		g_pLiveAllocs[ b ].uSite = uSite;
+		++g_cLiveAllocs;
+	}
+	static Bool removeLiveAlloc( void *p, U32 &uSite )
+	{
+		if( !g_cAllocBuckets ) {
+			return false;
+		}
+
+		const UPtr uMask = g_cAllocBuckets - 1;
+
+		UPtr b = hashPointer( p ) & uMask;
+		while( g_pLiveAllocs[ b ].p != p ) {
+			if( !g_pLiveAllocs[ b ].p ) {
+				// Allocated before tracking was enabled
+				return false;
+			}
+
+			b = ( b + 1 ) & uMask;
+		}
+
+		uSite = g_pLiveAllocs[ b ].uSite;
+		--g_cLiveAllocs;
+
+		// Backward-shift deletion keeps probe chains intact without tombstones
+		UPtr hole = b;
+		for( UPtr i = ( hole + 1 ) & uMask; g_pLiveAllocs[ i ].p != nullptr; i = ( i + 1 ) & uMask ) {
+			const UPtr home = hashPointer( g_pLiveAllocs[ i ].p ) & uMask;
+			// Move the entry into the hole unless its home lies in (hole, i]
+			const Bool bStays = hole <= i ? ( hole < home && home <= i ) : ( hole < home || home <= i );
+			if( bStays ) {
+				continue;
+			}
+
+			g_pLiveAllocs[ hole ] = g_pLiveAllocs[ i ];
+			hole = i;
+		}
+		g_pLiveAllocs[ hole ].p = nullptr;
+
+		return true;
+	}
+#endif
+
+	namespace Mem
+	{
+
+		void telemetryRecordAlloc( void *p, UPtr size, int tag, const char *file, int line, const char *func )
+		{
+#if DOLL_MEMTELEMETRY_SITES
+			if( !g_bTrackSites || t_bInSiteHook ) {
+				return;
+			}
+
+			t_bInSiteHook = true;
+
+			UPtr frames[ kMaxMemSiteFrames ];
+			const UPtr cFrames = captureCallstack( frames, kMaxMemSiteFrames );
+
+			U64 uHash = U64( 0xCBF29CE484222325 );
+			for( UPtr i = 0; i < cFrames; ++i ) {
+				uHash = hashStep( uHash, U64( frames[ i ] ) );
+			}
+			uHash = hashStep( uHash, U64( UPtr( file ) ) );
+			uHash = hashStep( uHash, U64( line ) );
+			uHash = hashStep( uHash, U64( tag ) );
+
+			g_siteLock.lock();
+
+			const U32 uSite = findOrAddSite( uHash, tag, file, line, func, frames, cFrames );
+			if( uSite != ~U32( 0 ) ) {
+				SMemAllocSite &site = g_pSites[ uSite ].site;
+
+				site.cLiveBytes += size;
+				++site.cLiveAllocs;
+				++site.cTotalAllocs;
+
+				insertLiveAlloc( p, uSite );
+			}
+
+			g_siteLock.unlock();
+
+			t_bInSiteHook = false;
+#else
+			( Void )p;
+			( Void )size;
+			( Void )tag;
+			( Void )file;
+			( Void )line;
+			( Void )func;
+#endif
+		}
+		void telemetryRecordDealloc( void *p, UPtr size, int tag )
+		{
+			( Void )tag;
+
+#if DOLL_MEMTELEMETRY_SITES
+			// Deallocations are still credited while tracking is off so sites
+			// don't report memory that has since been released
+			if( !g_cLiveAllocs || t_bInSiteHook ) {
+				return;
+			}
+
+			g_siteLock.lock();
+
+			U32 uSite;
+			if( removeLiveAlloc( p, uSite ) ) {
+				SMemAllocSite &site = g_pSites[ uSite ].site;
+
+				site.cLiveBytes -= size;
+				--site.cLiveAllocs;
+			}
+
+			g_siteLock.unlock();
+#else
+			( Void )p;
+			( Void )size;
+#endif
+		}
+
+		void updateTelemetry()
+		{
+			if( !g_uSnapshotInterval ) {
+				return;
+			}
+
+			const U64 uNow = microseconds();
+			if( uNow - g_uLastSnapshotTime < U64( g_uSnapshotInterval )*1000 ) {
+				return;
+			}
+
+			g_uLastSnapshotTime = uNow;
+
+			SMemSnapshot snap;
+			mem_takeSnapshot( snap );
+		}
+
+	}
+
+	DOLL_FUNC Bool DOLL_API mem_isAllocSiteTrackingAvailable()
+	{
+		return DOLL_MEMTELEMETRY_SITES != 0;
+	}
+	DOLL_FUNC Void DOLL_API mem_enableAllocSiteTracking( Bool bEnable )
+	{
+#if DOLL_MEMTELEMETRY_SITES
+		g_bTrackSites = bEnable;
+#else
+		( Void )bEnable;
+#endif
+	}
+	DOLL_FUNC Bool DOLL_API mem_isAllocSiteTrackingEnabled()
+	{
+#if DOLL_MEMTELEMETRY_SITES
+		return g_bTrackSites;
+#else
+		return false;
+#endif
+	}
+	DOLL_FUNC Void DOLL_API mem_markAllocSites()
+	{
+#if DOLL_MEMTELEMETRY_SITES
+		g_siteLock.lock();
+		for( U32 i = 0; i < g_cSites; ++i ) {
+			g_pSites[ i ].cMarkBytes = g_pSites[ i ].site.cLiveBytes;
+		}
+		g_siteLock.unlock();
+#endif
+	}
+#if DOLL_MEMTELEMETRY_SITES
+	static int compareSitesByLiveBytes( const void *a, const void *b )
+	{
+		const SMemAllocSite &x = *( const SMemAllocSite * )a;
+		const SMemAllocSite &y = *( const SMemAllocSite * )b;
+
+		if( x.cLiveBytes != y.cLiveBytes ) {
+			return x.cLiveBytes > y.cLiveBytes ? -1 : 1;
+		}
+		if( x.uHash != y.uHash ) {
+			return x.uHash < y.uHash ? -1 : 1;
+		}
+		return 0;
+	}
+#endif
+
+	DOLL_FUNC UPtr DOLL_API mem_getAllocSites( SMemAllocSite *pDstSites, UPtr cMaxSites )
+	{
+#if DOLL_MEMTELEMETRY_SITES
+		AX_ASSERT( pDstSites != nullptr || cMaxSites == 0 );
+
+		if( !cMaxSites ) {
+			return g_cSites;
+		}
+
+		// Copy out under the lock, then sort without holding it
+		TMutArr< SMemAllocSite > sites;
+
+		g_siteLock.lock();
+		const UPtr cSites = g_cSites;
+		const Bool bCopied = sites.resize( cSites );
+		if( bCopied ) {
+			for( UPtr i = 0; i < cSites; ++i ) {
+				sites[ i ] = g_pSites[ i ].site;
+				sites[ i ].iBytesSinceMark = S64( g_pSites[ i ].site.cLiveBytes ) - S64( g_pSites[ i ].cMarkBytes );
+			}
+		}
+		g_siteLock.unlock();
+
+		if( !AX_VERIFY_MEMORY( bCopied ) ) {
+			return 0;
+		}
+
+		qsort( ( void * )sites.pointer(), cSites, sizeof( SMemAllocSite ), &compareSitesByLiveBytes );
+
+		const UPtr cCopy = cSites < cMaxSites ? cSites : cMaxSites;
+		for( UPtr i = 0; i < cCopy; ++i ) {
+			pDstSites[ i ] = sites[ i ];
+		}
+
+		return cSites;
+#else
+		( Void )pDstSites;
+		( Void )cMaxSites;
+
+		return 0;
+#endif
+	}
+
+	/*
+	===========================================================================
+
+		EXPORT
+
+	===========================================================================
+	*/
+
+	// JSON string contents; paths from __FILE__ may contain backslashes
+	static Bool writeJSONString( IFile *pFile, const char *psz )
+	{
+		if( !psz ) {
+			return fs_pf( pFile, "null" );
+		}
+
+		char szBuf[ 512 ];
+		UPtr n = 0;
+
+		szBuf[ n++ ] = '\"';
+		for( const char *p = psz; *p != '\0' && n + 3 < sizeof( szBuf ); ++p ) {
+			if( *p == '\\' || *p == '\"' ) {
+				szBuf[ n++ ] = '\\';
+			}
+			szBuf[ n++ ] = *p;
+		}
+		szBuf[ n++ ] = '\"';
+
+		return fs_write( pFile, szBuf, n ) == n;
+	}
+
+	static Bool writeSnapshotsCSV( IFile *pFile )
+	{
+		Bool r = fs_pf( pFile, "time_us,frame,tag,live_bytes,peak_bytes,live_allocs,total_allocs,total_alloc_bytes,total_free_bytes,allocs_per_sec,alloc_bytes_per_sec,free_bytes_per_sec\n" );
+
+		for( U32 i = 0; i < g_cSnapshots && r; ++i ) {
+			const SMemSnapshot &snap = snapshotAt( i );
+
+			for( UPtr j = 0; j < kMaxTags && r; ++j ) {
+				const SMemTagSample &t = snap.tags[ j ];
+
+				r = fs_pf( pFile, "%llu,%u,%s,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f\n",
+					( unsigned long long )snap.uTimeMicrosecs, snap.uFrameId, kTagNames[ j ],
+					( unsigned long long )t.cLiveBytes, ( unsigned long long )t.cPeakBytes,
+					( unsigned long long )t.cLiveAllocs, ( unsigned long long )t.cTotalAllocs,
+					( unsigned long long )t.cTotalAllocBytes, ( unsigned long long )t.cTotalFreeBytes,
+					t.fAllocsPerSec, t.fAllocBytesPerSec, t.fFreeBytesPerSec );
+			}
+		}
+
+		return r;
+	}
+	static Bool writeSnapshotsJSON( IFile *pFile )
+	{
+		Bool r = fs_pf( pFile, "{\n\t\"snapshots\": [" );
+
+		for( U32 i = 0; i < g_cSnapshots && r; ++i ) {
+			const SMemSnapshot &snap = snapshotAt( i );
+
+			r = fs_pf( pFile, "%s\n\t\t{ \"time_us\": %llu, \"frame\": %u, \"tags\": {",
+				i > 0 ? "," : "", ( unsigned long long )snap.uTimeMicrosecs, snap.uFrameId );
+
+			for( UPtr j = 0; j < kMaxTags && r; ++j ) {
+				const SMemTagSample &t = snap.tags[ j ];
+
+				r = fs_pf( pFile, "%s\n\t\t\t\"%s\": { \"live_bytes\": %llu, \"peak_bytes\": %llu, \"live_allocs\": %llu, \"total_allocs\": %llu, \"total_alloc_bytes\": %llu, \"total_free_bytes\": %llu, \"allocs_per_sec\": %.3f, \"alloc_bytes_per_sec\": %.3f, \"free_bytes_per_sec\": %.3f }",
+					j > 0 ? "," : "", kTagNames[ j ],
+					( unsigned long long )t.cLiveBytes, ( unsigned long long )t.cPeakBytes,
+					( unsigned long long )t.cLiveAllocs, ( unsigned long long )t.cTotalAllocs,
+					( unsigned long long )t.cTotalAllocBytes, ( unsigned long long )t.cTotalFreeBytes,
+					t.fAllocsPerSec, t.fAllocBytesPerSec, t.fFreeBytesPerSec );
+			}
+
+			r = r && fs_pf( pFile, "\n\t\t} }" );
+		}
+
+		return r && fs_pf( pFile, "\n\t]\n}\n" );
+	}
+
+	static IFile *openExportFile( Str filename )
+	{
+		IFile *const pFile = fs_open( filename, kFileOpenF_W | kFileOpenF_Sequential );
+		if( !pFile ) {
+			g_ErrorLog( filename ) += "Failed to open file for writing.";
+		}
+
+		return pFile;
+	}
+
+	DOLL_FUNC Bool DOLL_API mem_exportSnapshots( Str filename, EMemExportFormat fmt )
+	{
+		IFile *const pFile = openExportFile( filename );
+		if( !pFile ) {
+			return false;
+		}
+
+		auto closer = makeScopeGuard([pFile](){fs_close(pFile);});
+
+		switch( fmt )
+		{
+		case EMemExportFormat::CSV:
+			return writeSnapshotsCSV( pFile );
+		case EMemExportFormat::JSON:
+			return writeSnapshotsJSON( pFile );
+		}
+
+		return false;
+	}
+
+	DOLL_FUNC Bool DOLL_API mem_exportSnapshotDiff( Str filename, const SMemSnapshotDiff &diff, EMemExportFormat fmt )
+	{
+		IFile *const pFile = openExportFile( filename );
+		if( !pFile ) {
+			return false;
+		}
+
+		auto closer = makeScopeGuard([pFile](){fs_close(pFile);});
+
+		Bool r;
+		if( fmt == EMemExportFormat::CSV ) {
+			r = fs_pf( pFile, "tag,live_bytes,live_allocs,peak_bytes,allocs,alloc_bytes,free_bytes\n" );
+			for( UPtr i = 0; i < kMaxTags && r; ++i ) {
+				const SMemTagDelta &d = diff.tags[ i ];
+
+				r = fs_pf( pFile, "%s,%lld,%lld,%lld,%llu,%llu,%llu\n", kTagNames[ i ],
+					( long long )d.iLiveBytes, ( long long )d.iLiveAllocs, ( long long )d.iPeakBytes,
+					( unsigned long long )d.cAllocs, ( unsigned long long )d.cAllocBytes, ( unsigned long long )d.cFreeBytes );
+			}
+
+			return r;
+		}
+
+		r = fs_pf( pFile, "{\n\t\"elapsed_us\": %llu,\n\t\"elapsed_frames\": %u,\n\t\"total_live_bytes\": %lld,\n\t\"tags\": {",
+			( unsigned long long )diff.uElapsedMicrosecs, diff.cElapsedFrames, ( long long )diff.iTotalLiveBytes );
+		for( UPtr i = 0; i < kMaxTags && r; ++i ) {
+			const SMemTagDelta &d = diff.tags[ i ];
+
+			r = fs_pf( pFile, "%s\n\t\t\"%s\": { \"live_bytes\": %lld, \"live_allocs\": %lld, \"peak_bytes\": %lld, \"allocs\": %llu, \"alloc_bytes\": %llu, \"free_bytes\": %llu }",
+				i > 0 ? "," : "", kTagNames[ i ],
+				( long long )d.iLiveBytes, ( long long )d.iLiveAllocs, ( long long )d.iPeakBytes,
+				( unsigned long long )d.cAllocs, ( unsigned long long )d.cAllocBytes, ( unsigned long long )d.cFreeBytes );
+		}
+
+		return r && fs_pf( pFile, "\n\t}\n}\n" );
+	}
+
+	DOLL_FUNC Bool DOLL_API mem_exportAllocSites( Str filename, EMemExportFormat fmt )
+	{
+		const UPtr cSites = mem_getAllocSites( nullptr, 0 );
+
+		TMutArr< SMemAllocSite > sites;
+		if( !AX_VERIFY_MEMORY( sites.resize( cSites ) ) ) {
+			return false;
+		}
+
+		// Sites may have been added in between; only the largest cSites are kept
+		if( cSites > 0 ) {
+			( Void )mem_getAllocSites( sites.pointer(), cSites );
+		}
+
+		IFile *const pFile = openExportFile( filename );
+		if( !pFile ) {
+			return false;
+		}
+
+		auto closer = makeScopeGuard([pFile](){fs_close(pFile);});
+
+		const Bool bCSV = fmt == EMemExportFormat::CSV;
+
+		Bool r = bCSV ?
+			fs_pf( pFile, "hash,tag,file,line,func,live_bytes,live_allocs,total_allocs,bytes_since_mark,frames\n" ) :
+			fs_pf( pFile, "{\n\t\"sites\": [" );
+
+		for( UPtr i = 0; i < sites.num() && r; ++i ) {
+			const SMemAllocSite &s = sites[ i ];
+			const char *const pszTag = ( UPtr )s.tag < kMaxTags ? kTagNames[ s.tag ] : "";
+
+			if( bCSV ) {
+				r = fs_pf( pFile, "%016llx,%s,\"%s\",%i,\"%s\",%llu,%llu,%llu,%lld,",
+					( unsigned long long )s.uHash, pszTag, s.pszFile ? s.pszFile : "", s.iLine, s.pszFunc ? s.pszFunc : "",
+					( unsigned long long )s.cLiveBytes, ( unsigned long long )s.cLiveAllocs,
+					( unsigned long long )s.cTotalAllocs, ( long long )s.iBytesSinceMark );
+				for( UPtr j = 0; j < s.cFrames && r; ++j ) {
+					r = fs_pf( pFile, "%s%llx", j > 0 ? " " : "", ( unsigned long long )s.frames[ j ] );
+				}
+				r = r && fs_pf( pFile, "\n" );
+				continue;
+			}
+
+			r = fs_pf( pFile, "%s\n\t\t{ \"hash\": \"%016llx\", \"tag\": \"%s\", \"file\": ", i > 0 ? "," : "", ( unsigned long long )s.uHash, pszTag );
+			r = r && writeJSONString( pFile, s.pszFile );
+			r = r && fs_pf( pFile, ", \"line\": %i, \"func\": ", s.iLine );
+			r = r && writeJSONString( pFile, s.pszFunc );
+			r = r && fs_pf( pFile, ", \"live_bytes\": %llu, \"live_allocs\": %llu, \"total_allocs\": %llu, \"bytes_since_mark\": %lld, \"frames\": [",
+				( unsigned long long )s.cLiveBytes, ( unsigned long long )s.cLiveAllocs,
+				( unsigned long long )s.cTotalAllocs, ( long long )s.iBytesSinceMark );
+			for( UPtr j = 0; j < s.cFrames && r; ++j ) {
+				r = fs_pf( pFile, "%s\"%llx\"", j > 0 ? ", " : "", ( unsigned long long )s.frames[ j ] );
+			}
+			r = r && fs_pf( pFile, "] }" );
+		}
+
+		return r && ( bCSV || fs_pf( pFile, "\n\t]\n}\n" ) );
+	}
+
+}
@@ -12,20 +12,24 @@
 
 #include "doll/Front/Frontend.hpp"
 #include "doll/Front/Input.hpp"
+#include "doll/Front/InputEvents.hpp"
 #include "doll/Front/Setup.hpp"
 
 #include "doll/Core/Defs.hpp"
 
 #include "doll/Core/Config.hpp"
 #include "doll/Core/Logger.hpp"
+#include "doll/Core/MemoryTelemetry.hpp"
 #include "doll/Core/Version.hpp"
 
 #include "doll/Gfx/Action.hpp"
 #include "doll/Gfx/API.hpp"
+#include "doll/Gfx/API-Capture.hpp"
 #include "doll/Gfx/Layer.hpp"
 #include "doll/Gfx/OSText.hpp"
 #include "doll/Gfx/RenderCommands.hpp"
 #include "doll/Gfx/Sprite.hpp"
+#include "doll/Gfx/Texture.hpp"
 
 #include "doll/IO/AsyncIO.hpp"
 #include "doll/IO/VFS.hpp"
@@ -894,6 +898,16 @@ namespace doll
 			return false;
 		}
 
+		if( conf.video.szCapture[ 0 ] != '\0' ) {
+			SGfxCaptureDesc captureDesc;
+			captureDesc.filename    = Str( conf.video.szCapture );
+			captureDesc.uFirstFrame = conf.video.uCaptureFirstFrame;
+			captureDesc.cFrames     = conf.video.cCaptureFrames;
+
+			DOLL_TRACE("gfx: Trying gfx_captureAPI");
+			g_core.view.pGfxAPI = gfx_captureAPI( g_core.view.pGfxAPI, captureDesc );
+		}
+
 		DOLL_TRACE("gfx: Trying newCGfxFrame");
 		g_core.view.pGfxFrame = new CGfxFrame( *g_core.view.pGfxAPI );
 		if( !AX_VERIFY_MEMORY( g_core.view.pGfxFrame ) ) {
@@ -930,14 +944,17 @@ namespace doll
 			return false;
 		}
 
+		gfx_setTextureBudget( U64( conf.video.uTextureBudgetMB )<<20 );
+
 #if DOLL__USE_GLFW
 		DOLL_TRACE("gfx: glfw: Resize properly");
-		do {
+		while( g_core.view.window != nullptr ) {
 			int w = 0, h = 0;
 			glfwGetFramebufferSize( g_core.view.window, &w, &h );
 			DOLL_TRACE( axf( "gfx: glfw: got %i x %i", w, h ) );
 			glfw_onSized_f( g_core.view.window, w, h );
-		} while( false );
+			break;
+		}
 #endif
 
 		DOLL_TRACE("gfx: done");
@@ -946,6 +963,8 @@ namespace doll
 	static Void doll__gfx_fini()
 	{
 		g_spriteMgr.fini_gl();
+		gfx__ostext_fini();
+		g_textureMgr.fini();
 
 		g_core.view.pGfxFrame = ( ( delete g_core.view.pGfxFrame ), nullptr );
 		g_core.view.pGfxAPI   = gfx_finiAPI( g_core.view.pGfxAPI );
@@ -977,6 +996,9 @@ namespace doll
 #if DOLL_GFX_OPENGL_ENABLED
 	extern IGfxAPIProvider &openGLGfxAPIProvider;
 #endif
+#if DOLL_GFX_SOFTWARE_ENABLED
+	extern IGfxAPIProvider &softwareGfxAPIProvider;
+#endif
 
 	DOLL_FUNC Void DOLL_API doll_preInit()
 	{
@@ -985,6 +1007,9 @@ namespace doll
 #endif
 #if DOLL_GFX_OPENGL_ENABLED
 		doll_registerGfxAPI( openGLGfxAPIProvider );
+#endif
+#if DOLL_GFX_SOFTWARE_ENABLED
+		doll_registerGfxAPI( softwareGfxAPIProvider );
 #endif
 	}
 
@@ -1053,9 +1078,46 @@ namespace doll
 		g_core.frame.timing.updateMe( microseconds() );
 		return true;
 	}
+	DOLL_FUNC Bool DOLL_API doll_initHeadless( const SCoreConfig *pConf )
+	{
+		doll_preInit();
+
+		AX_ASSERT( g_core.notInitialized() );
+
+		g_DebugLog += doll_getEngineString();
+
+		g_core.tooling.isHeadless = true;
+
+		SCoreConfig conf;
+		if( !doll__sys_init( conf, pConf ) ) {
+			g_core.tooling.isHeadless = false;
+			return false;
+		}
+
+		// Only the software renderer can do without a window, and there's no
+		// display to pace the frames to
+		conf.setRenderAPI( "soft" );
+		g_core.frame.uLimitMillisecs = 0;
+
+		if( !doll__gfx_init( conf ) ) {
+			doll__sys_fini();
+			g_core.tooling.isHeadless = false;
+			return false;
+		}
+
+		if( conf.video.uResX != 0 && conf.video.uResY != 0 ) {
+			( Void )onSized_f( OSWindow( 0 ), conf.video.uResX, conf.video.uResY );
+		}
+
+		g_core.frame.timing.updateMe( microseconds() );
+		return true;
+	}
 	DOLL_FUNC Void DOLL_API doll_fini()
 	{
-		if( !g_core.tooling.isTool ) {
+		if( g_core.tooling.isHeadless ) {
+			doll__gfx_fini();
+			g_core.tooling.isHeadless = false;
+		} else if( !g_core.tooling.isTool ) {
 			doll__snd_fini();
 			doll__gfx_fini();
 			doll__wnd_fini();
@@ -1077,6 +1139,9 @@ namespace doll
 	}
 	DOLL_FUNC Void DOLL_API doll_sync_update()
 	{
+		// Fold the input received since the last update into a new snapshot
+		In::updateFrame();
+
 		// Step forward the asynchronous IO system
 		async_step();
 
@@ -1087,7 +1152,9 @@ namespace doll
 			g_spriteMgr.update();
 
 			// Update the sound system
-			snd_sync();
+			if( !g_core.tooling.isHeadless ) {
+				snd_sync();
+			}
 		}
 
 		// Increment the general frame counter
@@ -1096,6 +1163,7 @@ namespace doll
 		// Update the memory tags
 #if DOLL_TAGS_ENABLED
 		Mem::updateTags();
+		Mem::updateTelemetry();
 #endif
 	}
 	DOLL_FUNC Void DOLL_API doll_sync_render()
@@ -1118,7 +1186,10 @@ namespace doll
 
 		// Update the user's commands
 		g_layerMgr->renderGL( g_core.view.pGfxFrame );
-		g_core.view.pGfxAPI->wsiPresent();
+		g_core.view.pGfxFrame->wsiPresent();
+
+		// Finish texture reloads and stay within the texture budget
+		g_textureMgr.endFrame();
 
 		// Increment the rendering frame counter
 		++g_core.frame.uRenderId;
@@ -1156,6 +1227,14 @@ namespace doll
 			return true;
 		}
 
+		// No window events to handle
+		if( g_core.tooling.isHeadless ) {
+			doll_sync_update();
+			doll_sync_render();
+			doll_sync_timing();
+			return true;
+		}
+
 		// Update general stuff and the renderer
 		doll_sync_update();
 		doll_sync_render();
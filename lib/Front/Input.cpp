@@ -2,6 +2,7 @@
 #include "../BuildSettings.hpp"
 
 #include "doll/Front/Input.hpp"
+#include "doll/Front/InputEvents.hpp"
 #include "doll/Front/Frontend.hpp"
 
 #include "doll/Core/Logger.hpp"
@@ -18,6 +19,10 @@ namespace doll
 
 		static const UPtr kNumMouseBtns = 8;
 
+		// Open-addressed (key, modifiers) -> action index table
+		static const UPtr kActionHashSize = 64;
+		static_assert( kActionHashSize >= kMaxInputActions*2, "Action hash table is too small" );
+
 		UPtr   keys[ kNumKeyFields ];
 		UPtr   mouse;
 
@@ -41,6 +46,8 @@ namespace doll
 
 		U32              cActions;
 		SCoreInputAction actions[ kMaxInputActions ];
+		// One-based index into `actions`; 0 is an empty bucket
+		U8               actionHash[ kActionHashSize ];
 
 		inline SWndInputState()
 		: mouse(0)
@@ -62,6 +69,7 @@ namespace doll
 			memset( &keyRels[0], 0, sizeof(keyRels) );
 			memset( &mouseHits[0], 0, sizeof(mouseHits) );
 			memset( &mouseRels[0], 0, sizeof(mouseRels) );
+			memset( &actionHash[0], 0, sizeof(actionHash) );
 		}
 
 		inline Void setKey( U8 index )
@@ -186,10 +194,19 @@ namespace doll
 
 			return nullptr;
 		}
+		static inline UPtr hashAction( EKey key, U32 uMods )
+		{
+			U32 h = ( U32( key ) | ( uMods<<8 ) )*0x9E3779B1U;
+			return UPtr( h>>( 32 - 6 ) )%kActionHashSize;
+		}
 		const SCoreInputAction *findAction( EKey key, U32 uMods ) const
 		{
-			for( U32 i = 0; i < cActions; ++i ) {
-				const SCoreInputAction &act = actions[ i ];
+			for( UPtr i = hashAction( key, uMods ), n = 0; n < kActionHashSize; i = ( i + 1 )%kActionHashSize, ++n ) {
+				if( !actionHash[ i ] ) {
+					break;
+				}
+
+				const SCoreInputAction &act = actions[ actionHash[ i ] - 1 ];
 				if( act.key == key && act.uMods == uMods ) {
 					return &act;
 				}
@@ -197,6 +214,30 @@ namespace doll
 
 			return nullptr;
 		}
+		// Called whenever `actions` changes; the first action bound to a
+		// given key combination wins, as with the old linear search
+		Void rehashActions()
+		{
+			memset( &actionHash[0], 0, sizeof(actionHash) );
+
+			for( U32 j = 0; j < cActions; ++j ) {
+				const SCoreInputAction &act = actions[ j ];
+
+				UPtr i = hashAction( act.key, act.uMods );
+				while( actionHash[ i ] != 0 ) {
+					const SCoreInputAction &other = actions[ actionHash[ i ] - 1 ];
+					if( other.key == act.key && other.uMods == act.uMods ) {
+						break;
+					}
+
+					i = ( i + 1 )%kActionHashSize;
+				}
+
+				if( !actionHash[ i ] ) {
+					actionHash[ i ] = U8( j + 1 );
+				}
+			}
+		}
 
 		Bool addAction( const SCoreInputAction &act )
 		{
@@ -214,6 +255,7 @@ namespace doll
 			}
 
 			actions[ cActions++ ] = act;
+			rehashActions();
 			return true;
 		}
 		Bool setAction( const SCoreInputAction &act )
@@ -224,6 +266,7 @@ namespace doll
 			}
 
 			*pAct = act;
+			rehashActions();
 			return true;
 		}
 		Void removeAction( const SCoreInputAction &act )
@@ -238,6 +281,8 @@ namespace doll
 					cmpAct = actions[ cActions ];
 				}
 			}
+
+			rehashActions();
 		}
 		Bool hasAction( const SCoreInputAction &act ) const
 		{
@@ -285,6 +330,7 @@ namespace doll
 				return false;
 			}
 
+			( Void )In::submitEvent( EInputEvent::Action, U8( pAct->command ) );
 			issueCommand( pAct->command );
 			return true;
 		}
@@ -320,6 +366,10 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
+		if( !In::submitEvent( EInputEvent::FocusGained, 0 ) ) {
+			return EWndReply::Handled;
+		}
+
 		// FIXME: Load all current key state up here (at the time of the
 		//        message's delivery)
 
@@ -332,6 +382,10 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
+		if( !In::submitEvent( EInputEvent::FocusLost, 0 ) ) {
+			return EWndReply::Handled;
+		}
+
 		// FIXME: This should probably do something useful or be removed
 
 		return EWndReply::Handled;
@@ -344,6 +398,10 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
+		if( !In::submitEvent( isRepeat ? EInputEvent::KeyRepeat : EInputEvent::KeyPress, U8( key ), uModFlags ) ) {
+			return EWndReply::Handled;
+		}
+
 		if( !isRepeat ) {
 			if( p->checkCommand( key, uModFlags ) ) {
 				return EWndReply::Handled;
@@ -363,7 +421,9 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
-		( Void )uModFlags;
+		if( !In::submitEvent( EInputEvent::KeyRelease, U8( key ), uModFlags ) ) {
+			return EWndReply::Handled;
+		}
 
 		p->relKey( (U8)key );
 		if( p->keyPressed == ( U8 )key ) {
@@ -380,6 +440,10 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
+		if( !In::submitEvent( EInputEvent::KeyChar, 0, utf32Char ) ) {
+			return EWndReply::Handled;
+		}
+
 		// FIXME: Check return value and do something useful (like notify the user)
 		p->handleEntryChar( utf32Char );
 
@@ -393,7 +457,9 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
-		( Void )uModFlags;
+		if( !In::submitEvent( EInputEvent::MousePress, U8( button ), uModFlags, clientPosX, clientPosY ) ) {
+			return EWndReply::Handled;
+		}
 
 		p->setMouse( U8(button) - 1 );
 		p->handleMouseMove( clientPosX, clientPosY );
@@ -410,7 +476,9 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
-		( Void )uModFlags;
+		if( !In::submitEvent( EInputEvent::MouseRelease, U8( button ), uModFlags, clientPosX, clientPosY ) ) {
+			return EWndReply::Handled;
+		}
 
 		p->clearMouse( U8(button) - 1 );
 		p->handleMouseMove( clientPosX, clientPosY );
@@ -427,7 +495,9 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
-		( Void )uModFlags;
+		if( !In::submitEvent( EInputEvent::MouseWheel, 0, uModFlags, clientPosX, clientPosY, fDelta ) ) {
+			return EWndReply::Handled;
+		}
 
 		p->mouseZ += fDelta;
 		p->mouseDeltaZ += fDelta;
@@ -443,7 +513,9 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
-		( void )uModFlags;
+		if( !In::submitEvent( EInputEvent::MouseMove, 0, uModFlags, clientPosX, clientPosY ) ) {
+			return EWndReply::Handled;
+		}
 
 		p->handleMouseMove( clientPosX, clientPosY );
 		p->mouseInWindow = true;
@@ -457,7 +529,9 @@ namespace doll
 			return EWndReply::NotHandled;
 		}
 
-		( Void )uModFlags;
+		if( !In::submitEvent( EInputEvent::MouseExit, 0, uModFlags ) ) {
+			return EWndReply::Handled;
+		}
 
 		p->mouseInWindow = false;
 
@@ -0,0 +1,542 @@
+#define DOLL_TRACE_FACILITY doll::kLog_FrontendInput
+#include "../BuildSettings.hpp"
+
+#include "doll/Front/InputEvents.hpp"
+#include "doll/Front/Input.hpp"
+
+#include "doll/Core/Logger.hpp"
+#include "doll/Core/MemoryTags.hpp"
+#include "doll/IO/File.hpp"
+#include "doll/IO/VFS.hpp"
+
+#include <atomic>
+
+namespace doll
+{
+
+	/*
+	===========================================================================
+
+		EVENT RING
+
+		Written only from the thread that runs the OS message loop (the
+		main thread). Readers on other threads copy events out and then
+		re-check the write sequence to discard anything overwritten while
+		they were copying.
+
+	===========================================================================
+	*/
+
+	static_assert( ( kInputEventRingSize & ( kInputEventRingSize - 1 ) ) == 0, "Ring size must be a power of two" );
+
+	static SInputEvent      g_eventRing[ kInputEventRingSize ];
+	static std::atomic<U64> g_uEventWriteSeq( 0 );
+
+	static inline Void pushEvent( const SInputEvent &ev )
+	{
+		const U64 uSeq = g_uEventWriteSeq.load( std::memory_order_relaxed );
+
+		g_eventRing[ uSeq & ( kInputEventRingSize - 1 ) ] = ev;
+		g_uEventWriteSeq.store( uSeq + 1, std::memory_order_release );
+	}
+
+	DOLL_FUNC U64 DOLL_API in_getEventSequence()
+	{
+		return g_uEventWriteSeq.load( std::memory_order_acquire );
+	}
+	DOLL_FUNC UPtr DOLL_API in_readEvents( SInputEvent *pDstEvents, UPtr cMaxEvents, U64 &uInOutSeq )
+	{
+		AX_ASSERT_NOT_NULL( pDstEvents );
+
+		const U64 uEnd = g_uEventWriteSeq.load( std::memory_order_acquire );
+
+		U64 uSeq = uInOutSeq;
+		if( uEnd - uSeq > kInputEventRingSize ) {
+			uSeq = uEnd - kInputEventRingSize;
+		}
+
+		const U64 uFirst = uSeq;
+
+		UPtr n = 0;
+		while( uSeq < uEnd && n < cMaxEvents ) {
+			pDstEvents[ n++ ] = g_eventRing[ uSeq & ( kInputEventRingSize - 1 ) ];
+			++uSeq;
+		}
+
+		// Anything the writer lapped while we were copying is garbage
+		std::atomic_thread_fence( std::memory_order_acquire );
+		const U64 uEndAfter = g_uEventWriteSeq.load( std::memory_order_relaxed );
+		if( uEndAfter > kInputEventRingSize && uEndAfter - kInputEventRingSize > uFirst ) {
+			const U64 cTorn = uEndAfter - kInputEventRingSize - uFirst;
+			if( cTorn >= n ) {
+				uInOutSeq = uEndAfter - kInputEventRingSize;
+				return 0;
+			}
+
+			memmove( ( Void * )pDstEvents, ( const Void * )( pDstEvents + cTorn ), sizeof( SInputEvent )*( n - UPtr( cTorn ) ) );
+			n -= UPtr( cTorn );
+		}
+
+		uInOutSeq = uSeq;
+		return n;
+	}
+
+	/*
+	===========================================================================
+
+		RECORD / REPLAY
+
+	===========================================================================
+	*/
+
+	struct SInputRecordHeader
+	{
+		char magic[ 4 ];
+		U32  uVersion;
+		U32  cEventBytes;
+		U32  uReserved;
+	};
+	static const char kInputRecordMagic[ 4 ] = { 'D', 'I', 'N', 'R' };
+	static const U32  kInputRecordVersion = 1;
+
+	struct SInputRecorder
+	{
+		IFile *pFile       = nullptr;
+		U32    uStartFrame = 0;
+		U64    uStartTime  = 0;
+	};
+	struct SInputReplayer
+	{
+		U8                *pData       = nullptr;
+		const SInputEvent *pEvents     = nullptr;
+		UPtr               cEvents     = 0;
+		UPtr               uNext       = 0;
+		U32                uStartFrame = 0;
+		U64                uStartTime  = 0;
+
+		Bool               bInjecting  = false;
+		U64                uInjectTime = 0;
+
+		inline Bool isActive() const
+		{
+			return pData != nullptr;
+		}
+	};
+
+	static SInputRecorder g_recorder;
+	static SInputReplayer g_replayer;
+
+	DOLL_FUNC Bool DOLL_API in_startRecording( Str filename )
+	{
+		in_stopRecording();
+
+		IFile *const pFile = fs_open( filename, kFileOpenF_W | kFileOpenF_Sequential );
+		if( !pFile ) {
+			g_ErrorLog( filename ) += "Failed to open input recording for writing.";
+			return false;
+		}
+
+		SInputRecordHeader hdr;
+		memcpy( &hdr.magic[0], &kInputRecordMagic[0], sizeof( hdr.magic ) );
+		hdr.uVersion    = kInputRecordVersion;
+		hdr.cEventBytes = U32( sizeof( SInputEvent ) );
+		hdr.uReserved   = 0;
+
+		if( fs_write( pFile, &hdr, sizeof( hdr ) ) != sizeof( hdr ) ) {
+			g_ErrorLog( filename ) += "Failed to write input recording header.";
+			fs_close( pFile );
+			return false;
+		}
+
+		g_recorder.pFile       = pFile;
+		g_recorder.uStartFrame = g_core.frame.uUpdateId;
+		g_recorder.uStartTime  = microseconds();
+
+		return true;
+	}
+	DOLL_FUNC Void DOLL_API in_stopRecording()
+	{
+		if( !g_recorder.pFile ) {
+			return;
+		}
+
+		g_recorder.pFile = fs_close( g_recorder.pFile );
+	}
+	DOLL_FUNC Bool DOLL_API in_isRecording()
+	{
+		return g_recorder.pFile != nullptr;
+	}
+
+	DOLL_FUNC Bool DOLL_API in_startReplay( Str filename )
+	{
+		in_stopReplay();
+
+		U8 *pData = nullptr;
+		UPtr cBytes = 0;
+		if( !core_loadFile( filename, pData, cBytes, kTag_FileSys ) ) {
+			g_ErrorLog( filename ) += "Failed to load input recording.";
+			return false;
+		}
+
+		const SInputRecordHeader *const pHdr = ( const SInputRecordHeader * )pData;
+		if( cBytes < sizeof( *pHdr ) || memcmp( &pHdr->magic[0], &kInputRecordMagic[0], sizeof( pHdr->magic ) ) != 0 ) {
+			g_ErrorLog( filename ) += "Not an input recording.";
+			core_freeFile( pData );
+			return false;
+		}
+		if( pHdr->uVersion != kInputRecordVersion || pHdr->cEventBytes != sizeof( SInputEvent ) ) {
+			g_ErrorLog( filename ) += "Unsupported input recording version.";
+			core_freeFile( pData );
+			return false;
+		}
+		if( ( cBytes - sizeof( *pHdr ) )%sizeof( SInputEvent ) != 0 ) {
+			g_ErrorLog( filename ) += "Input recording is truncated.";
+			core_freeFile( pData );
+			return false;
+		}
+
+		g_replayer.pData       = pData;
+		g_replayer.pEvents     = ( const SInputEvent * )( pData + sizeof( *pHdr ) );
+		g_replayer.cEvents     = ( cBytes - sizeof( *pHdr ) )/sizeof( SInputEvent );
+		g_replayer.uNext       = 0;
+		g_replayer.uStartFrame = g_core.frame.uUpdateId;
+		g_replayer.uStartTime  = microseconds();
+		g_replayer.bInjecting  = false;
+
+		return true;
+	}
+	DOLL_FUNC Void DOLL_API in_stopReplay()
+	{
+		if( !g_replayer.isActive() ) {
+			return;
+		}
+
+		core_freeFile( g_replayer.pData );
+		g_replayer = SInputReplayer();
+	}
+	DOLL_FUNC Bool DOLL_API in_isReplaying()
+	{
+		return g_replayer.isActive();
+	}
+
+	static Void injectEvent( const SInputEvent &ev )
+	{
+		const OSWindow wnd = OSWindow( 0 );
+
+		switch( ev.type )
+		{
+		case EInputEvent::None:
+		case EInputEvent::Action:
+			break;
+
+		case EInputEvent::FocusGained:
+			( Void )in_onAcceptKey_f( wnd );
+			break;
+		case EInputEvent::FocusLost:
+			( Void )in_onResignKey_f( wnd );
+			break;
+
+		case EInputEvent::KeyPress:
+			( Void )in_onKeyPress_f( wnd, EKey( ev.uCode ), ev.uMods, false );
+			break;
+		case EInputEvent::KeyRepeat:
+			( Void )in_onKeyPress_f( wnd, EKey( ev.uCode ), ev.uMods, true );
+			break;
+		case EInputEvent::KeyRelease:
+			( Void )in_onKeyRelease_f( wnd, EKey( ev.uCode ), ev.uMods );
+			break;
+		case EInputEvent::KeyChar:
+			( Void )in_onKeyChar_f( wnd, ev.uMods );
+			break;
+
+		case EInputEvent::MousePress:
+			( Void )in_onMousePress_f( wnd, EMouse( ev.uCode ), ev.x, ev.y, ev.uMods );
+			break;
+		case EInputEvent::MouseRelease:
+			( Void )in_onMouseRelease_f( wnd, EMouse( ev.uCode ), ev.x, ev.y, ev.uMods );
+			break;
+		case EInputEvent::MouseWheel:
+			( Void )in_onMouseWheel_f( wnd, ev.z, ev.x, ev.y, ev.uMods );
+			break;
+		case EInputEvent::MouseMove:
+			( Void )in_onMouseMove_f( wnd, ev.x, ev.y, ev.uMods );
+			break;
+		case EInputEvent::MouseExit:
+			( Void )in_onMouseExit_f( wnd, ev.uMods );
+			break;
+		}
+	}
+	static Void injectReplayFrame()
+	{
+		const U32 uFrame = g_core.frame.uUpdateId - g_replayer.uStartFrame;
+
+		g_replayer.bInjecting = true;
+		while( g_replayer.uNext < g_replayer.cEvents ) {
+			const SInputEvent &ev = g_replayer.pEvents[ g_replayer.uNext ];
+			if( ev.uFrameId > uFrame ) {
+				break;
+			}
+
+			g_replayer.uInjectTime = g_replayer.uStartTime + ev.uTimeMicrosecs;
+			injectEvent( ev );
+
+			++g_replayer.uNext;
+		}
+		g_replayer.bInjecting = false;
+
+		if( g_replayer.uNext == g_replayer.cEvents ) {
+			g_DebugLog += "Input replay finished.";
+			in_stopReplay();
+		}
+	}
+	static Void recordEvents( U64 uFirst, U64 uEnd )
+	{
+		static const UPtr kBatchSize = 256;
+
+		SInputEvent batch[ kBatchSize ];
+		UPtr n = 0;
+
+		const U32 uFrame = g_core.frame.uUpdateId - g_recorder.uStartFrame;
+
+		for( U64 uSeq = uFirst; uSeq < uEnd; ++uSeq ) {
+			const SInputEvent &ev = g_eventRing[ uSeq & ( kInputEventRingSize - 1 ) ];
+			if( ev.type == EInputEvent::Action ) {
+				continue;
+			}
+
+			SInputEvent &rec = batch[ n++ ];
+			rec = ev;
+			rec.uFrameId       = uFrame;
+			rec.uTimeMicrosecs = ev.uTimeMicrosecs >= g_recorder.uStartTime ? ev.uTimeMicrosecs - g_recorder.uStartTime : 0;
+
+			if( n == kBatchSize ) {
+				if( fs_write( g_recorder.pFile, &batch[0], sizeof( SInputEvent )*n ) != sizeof( SInputEvent )*n ) {
+					DOLL_ERROR_LOG += "Failed to write input recording; recording stopped.";
+					in_stopRecording();
+					return;
+				}
+
+				n = 0;
+			}
+		}
+
+		if( n > 0 && fs_write( g_recorder.pFile, &batch[0], sizeof( SInputEvent )*n ) != sizeof( SInputEvent )*n ) {
+			DOLL_ERROR_LOG += "Failed to write input recording; recording stopped.";
+			in_stopRecording();
+		}
+	}
+
+	/*
+	===========================================================================
+
+		SNAPSHOTS
+
+	===========================================================================
+	*/
+
+	static SInputSnapshot   g_snapshots[ kInputSnapshotCount ];
+	static std::atomic<U32> g_uCurrSnapshot( 0 );
+	static U64              g_uFoldSeq = 0;
+	static Bool             g_bMousePosKnown = false;
+
+	static inline Void setBit( U64 *pFields, U8 i )
+	{
+		pFields[ i/SInputSnapshot::kNumFieldBits ] |= U64(1)<<( i%SInputSnapshot::kNumFieldBits );
+	}
+	static inline Void clearBit( U64 *pFields, U8 i )
+	{
+		pFields[ i/SInputSnapshot::kNumFieldBits ] &= ~( U64(1)<<( i%SInputSnapshot::kNumFieldBits ) );
+	}
+	static inline Void bump( U8 &n )
+	{
+		if( n < 0xFF ) {
+			++n;
+		}
+	}
+
+	static Void foldMousePos( SInputSnapshot &s, const SInputEvent &ev )
+	{
+		if( g_bMousePosKnown ) {
+			s.mouseDeltaX += ev.x - s.mouseX;
+			s.mouseDeltaY += ev.y - s.mouseY;
+		}
+
+		s.mouseX = ev.x;
+		s.mouseY = ev.y;
+		s.mouseInWindow = true;
+
+		g_bMousePosKnown = true;
+	}
+	static Void foldEvent( SInputSnapshot &s, const SInputEvent &ev )
+	{
+		const U8 uBtn = ev.uCode - 1;
+
+		switch( ev.type )
+		{
+		case EInputEvent::None:
+		case EInputEvent::KeyChar:
+			break;
+
+		case EInputEvent::FocusGained:
+			s.hasFocus = true;
+			break;
+		case EInputEvent::FocusLost:
+			s.hasFocus = false;
+			break;
+
+		case EInputEvent::KeyPress:
+			setBit( s.keys, ev.uCode );
+			bump( s.keyPresses[ ev.uCode ] );
+			s.uLastKey = ev.uCode;
+			break;
+		case EInputEvent::KeyRepeat:
+			setBit( s.keys, ev.uCode );
+			break;
+		case EInputEvent::KeyRelease:
+			clearBit( s.keys, ev.uCode );
+			bump( s.keyReleases[ ev.uCode ] );
+			break;
+
+		case EInputEvent::MousePress:
+			if( ev.uCode > 0 && ev.uCode <= SInputSnapshot::kNumMouseBtns ) {
+				s.uMouseButtons |= 1U<<uBtn;
+				bump( s.mousePresses[ uBtn ] );
+			}
+			foldMousePos( s, ev );
+			break;
+		case EInputEvent::MouseRelease:
+			if( ev.uCode > 0 && ev.uCode <= SInputSnapshot::kNumMouseBtns ) {
+				s.uMouseButtons &= ~( 1U<<uBtn );
+				bump( s.mouseReleases[ uBtn ] );
+			}
+			foldMousePos( s, ev );
+			break;
+		case EInputEvent::MouseWheel:
+			s.mouseZ += ev.z;
+			s.mouseDeltaZ += ev.z;
+			foldMousePos( s, ev );
+			break;
+		case EInputEvent::MouseMove:
+			foldMousePos( s, ev );
+			break;
+		case EInputEvent::MouseExit:
+			s.mouseInWindow = false;
+			break;
+
+		case EInputEvent::Action:
+			s.uActions |= 1U<<ev.uCode;
+			break;
+		}
+	}
+	// Rebuild the persistent state from the input system after events were lost
+	static Void resyncSnapshot( SInputSnapshot &s )
+	{
+		memset( &s.keys[0], 0, sizeof( s.keys ) );
+		for( U32 i = 1; i < 0x100; ++i ) {
+			if( in_keyState( EKey( i ) ) ) {
+				setBit( s.keys, U8( i ) );
+			}
+		}
+
+		s.uMouseButtons = 0;
+		for( U32 i = 0; i < SInputSnapshot::kNumMouseBtns; ++i ) {
+			if( in_mouseState( EMouse( i + 1 ) ) ) {
+				s.uMouseButtons |= 1U<<i;
+			}
+		}
+
+		s.mouseX = in_mouseX();
+		s.mouseY = in_mouseY();
+		s.mouseZ = in_mouseZ();
+	}
+
+	DOLL_FUNC const SInputSnapshot *DOLL_API in_getSnapshot()
+	{
+		return &g_snapshots[ g_uCurrSnapshot.load( std::memory_order_acquire ) ];
+	}
+
+	namespace In
+	{
+
+		Bool submitEvent( EInputEvent type, U8 uCode, U32 uMods, S32 x, S32 y, F32 z )
+		{
+			// Live input is ignored while a recording is being played back
+			if( g_replayer.isActive() && !g_replayer.bInjecting ) {
+				return false;
+			}
+
+			SInputEvent ev;
+
+			ev.uTimeMicrosecs = g_replayer.bInjecting ? g_replayer.uInjectTime : microseconds();
+			ev.uFrameId       = g_core.frame.uUpdateId;
+			ev.type           = type;
+			ev.uCode          = uCode;
+			ev.uReserved      = 0;
+			ev.uMods          = uMods;
+			ev.x              = x;
+			ev.y              = y;
+			ev.z              = z;
+
+			pushEvent( ev );
+			return true;
+		}
+
+		Void updateFrame()
+		{
+			if( g_replayer.isActive() ) {
+				injectReplayFrame();
+			}
+
+			const U32 uPrev = g_uCurrSnapshot.load( std::memory_order_relaxed );
+			const U32 uNext = ( uPrev + 1 )%kInputSnapshotCount;
+
+			const SInputSnapshot &prev = g_snapshots[ uPrev ];
+			SInputSnapshot &s = g_snapshots[ uNext ];
+
+			// Carry over the persistent state; reset the per-frame counters
+			s = prev;
+			memset( &s.keyPresses[0], 0, sizeof( s.keyPresses ) );
+			memset( &s.keyReleases[0], 0, sizeof( s.keyReleases ) );
+			memset( &s.mousePresses[0], 0, sizeof( s.mousePresses ) );
+			memset( &s.mouseReleases[0], 0, sizeof( s.mouseReleases ) );
+			s.uLastKey    = 0;
+			s.mouseDeltaX = 0;
+			s.mouseDeltaY = 0;
+			s.mouseDeltaZ = 0.0f;
+			s.uActions    = 0;
+			s.cLostEvents = 0;
+
+			const U64 uEnd = g_uEventWriteSeq.load( std::memory_order_relaxed );
+			U64 uFirst = g_uFoldSeq;
+			if( uEnd - uFirst > kInputEventRingSize ) {
+				s.cLostEvents = U32( uEnd - uFirst - kInputEventRingSize );
+				uFirst = uEnd - kInputEventRingSize;
+
+				DOLL_WARNING_LOG += "Input event ring overflowed; some events were lost.";
+			}
+
+			for( U64 uSeq = uFirst; uSeq < uEnd; ++uSeq ) {
+				foldEvent( s, g_eventRing[ uSeq & ( kInputEventRingSize - 1 ) ] );
+			}
+
+			if( s.cLostEvents > 0 ) {
+				resyncSnapshot( s );
+			}
+
+			s.uFrameId       = g_core.frame.uUpdateId;
+			s.uTimeMicrosecs = microseconds();
+			s.uFirstEvent    = uFirst;
+			s.uEndEvent      = uEnd;
+
+			g_uCurrSnapshot.store( uNext, std::memory_order_release );
+
+			if( g_recorder.pFile != nullptr ) {
+				recordEvents( uFirst, uEnd );
+			}
+
+			g_uFoldSeq = uEnd;
+		}
+
+	}
+
+}
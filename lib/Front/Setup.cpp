@@ -208,6 +208,10 @@ namespace doll
 			r |= readConfigU32( *pSect, "FrameLimit", video.uFrameLimit );
 			r |= readConfigText( *pSect, "ScreenMode", video.szScreenMode );
 			r |= readConfigText( *pSect, "API", video.szAPIs );
+			r |= readConfigText( *pSect, "Capture", video.szCapture );
+			r |= readConfigU32( *pSect, "CaptureFirstFrame", video.uCaptureFirstFrame );
+			r |= readConfigU32( *pSect, "CaptureFrames", video.cCaptureFrames );
+			r |= readConfigU32( *pSect, "TextureBudget", video.uTextureBudgetMB );
 
 			Bool bFullscreen = false;
 			if( readConfigBool( *pSect, "Fullscreen", bFullscreen ) ) {
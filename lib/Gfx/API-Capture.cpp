@@ -0,0 +1,2520 @@
+#define DOLL_TRACE_FACILITY doll::kLog_GfxAPIDrv
+#include "../BuildSettings.hpp"
+
+#include "doll/Gfx/API-Capture.hpp"
+
+#include "doll/Core/Logger.hpp"
+#include "doll/IO/File.hpp"
+#include "doll/IO/VFS.hpp"
+
+namespace doll {
+
+// "DGCP"
+static const U32 kCaptureMagic = 0x50434744;
+// Bump this whenever the layout of a call changes
+static const U16 kCaptureVersion = 3;
+// Calls are buffered until there are this many bytes to write
+static const UPtr kCaptureFlushBytes = 256 * 1024;
+// Texture stages whose bindings are recreated at the start of a capture
+static const U32 kCaptureTexStages = 8;
+
+// Bytes before each call's parameters: the call, then their size
+static const UPtr kCaptureCallHeaderBytes = 1 + 4;
+
+enum ECaptureObject {
+	kCapObjSampler,
+	kCapObjTexture,
+	kCapObjLayout,
+	kCapObjVBuffer,
+	kCapObjIBuffer,
+	kCapObjUBuffer,
+	kCapObjShader,
+	kCapObjProgram,
+	kCapObjRenderTarget,
+
+	kNumCapObjs
+};
+
+static const EGfxCaptureCall kCapObjCreateCalls[kNumCapObjs] = {
+	kGfxCapCreateSampler,
+	kGfxCapCreateTexture,
+	kGfxCapCreateLayout,
+	kGfxCapCreateVBuffer,
+	kGfxCapCreateIBuffer,
+	kGfxCapCreateUBuffer,
+	kGfxCapCreateShader,
+	kGfxCapCreateProgram,
+	kGfxCapCreateRenderTarget
+};
+static const EGfxCaptureCall kCapObjDestroyCalls[kNumCapObjs] = {
+	kGfxCapDestroySampler,
+	kGfxCapDestroyTexture,
+	kGfxCapDestroyLayout,
+	kGfxCapDestroyVBuffer,
+	kGfxCapDestroyIBuffer,
+	kGfxCapDestroyUBuffer,
+	kGfxCapDestroyShader,
+	kGfxCapDestroyProgram,
+	kGfxCapDestroyRenderTarget
+};
+
+// An object created through the capture; its address is the handle given
+// to the caller
+struct SCaptureObject {
+	ECaptureObject type;
+	// Identifies the object in the file (never reused)
+	U32 uId;
+	// Index in `CGfxAPI_Capture::m_objects`
+	UPtr uIndex;
+	// The captured API's handle
+	Void *pInner;
+
+	SGfxSamplerDesc sampler;
+	ETextureFormat texFmt;
+	U16 texResX, texResY;
+	SGfxLayout layout;
+	UPtr cBufferBytes;
+	EBufferPerformance bufferPerf;
+	EBufferPurpose bufferPurpose;
+	MutStr shaderFilename;
+	EShaderFormat shaderFmt;
+	EShaderStage shaderStage;
+	// Shaders of a program
+	TMutArr<U32> programShaders;
+	// Texture of a render target, which the target owns; and, for that
+	// texture, the render target it belongs to
+	SCaptureObject *pTargetTexture;
+	SCaptureObject *pOwner;
+
+	// Shader code, or texels (BGRA) until the capture starts recording
+	TMutArr<U8> data;
+};
+
+template<typename T>
+static SCaptureObject *toCapObj( T *p ) {
+	return reinterpret_cast<SCaptureObject *>( p );
+}
+template<typename T>
+static T *innerOf( T *p ) {
+	return p != nullptr ? reinterpret_cast<T *>( toCapObj( p )->pInner ) : nullptr;
+}
+static U32 idOf( const Void *p ) {
+	return p != nullptr ? reinterpret_cast<const SCaptureObject *>( p )->uId : 0;
+}
+
+enum ECaptureState {
+	// Waiting for the first frame to record
+	kCapStateWaiting,
+	kCapStateRecording,
+	// All frames written (or writing failed); calls are just passed on
+	kCapStateDone
+};
+
+// Bits of `SCaptureShadow::uKnown`
+enum {
+	kCapKnown_Default = 1 << 0,
+	kCapKnown_Projection = 1 << 1,
+	kCapKnown_ModelView = 1 << 2,
+	kCapKnown_ScissorEnable = 1 << 3,
+	kCapKnown_TextureEnable = 1 << 4,
+	kCapKnown_Blend = 1 << 5,
+	kCapKnown_Scissor = 1 << 6,
+	kCapKnown_Viewport = 1 << 7
+};
+
+// State set before the capture starts recording, recreated when it does
+struct SCaptureShadow {
+	U32 uKnown;
+
+	F32 defaultProj[16];
+	F32 projection[16];
+	F32 modelView[16];
+	Bool bScissor;
+	Bool bTexture;
+	U32 blend[5];
+	S32 scissor[4];
+	S32 viewport[4];
+
+	SCaptureObject *pLayout;
+	SCaptureObject *pVBuffer;
+	SCaptureObject *pIBuffer;
+	EIndexFormat indexFormat;
+	SCaptureObject *pInstanceBuffer;
+	SCaptureObject *pProgram;
+	SCaptureObject *pTextures[kCaptureTexStages];
+	SCaptureObject *pSamplers[kCaptureTexStages];
+	SCaptureObject *pRenderTarget;
+};
+
+class CGfxAPIProvider_Capture : public IGfxAPIProvider {
+public:
+	virtual Void drop() override {
+	}
+
+	virtual Bool is( const Str &name ) const override {
+		return name.caseCmp( "capture" );
+	}
+	virtual Str getName() const override {
+		return Str( "capture" );
+	}
+	virtual Str getDescription() const override {
+		return Str( "Call capture (wraps another API)" );
+	}
+	virtual IGfxAPI *initAPI( OSWindow wnd, const SGfxInitDesc &desc ) override {
+		( (Void)wnd );
+		( (Void)desc );
+
+		// Only made through gfx_captureAPI()
+		return nullptr;
+	}
+	virtual Void finiAPI( IGfxAPI *pAPI ) override {
+		delete pAPI;
+	}
+};
+static CGfxAPIProvider_Capture captureGfxAPIProvider;
+
+class CGfxAPI_Capture : public virtual IGfxAPI {
+public:
+	CGfxAPI_Capture( IGfxAPI &inner );
+	virtual ~CGfxAPI_Capture();
+
+	Bool init( const SGfxCaptureDesc &desc );
+
+	IGfxAPI &getInner() { return m_inner; }
+	Bool isDone() const { return m_state == kCapStateDone; }
+
+	virtual EGfxAPI getAPI() const override;
+
+	virtual TArr<EShaderFormat> getSupportedShaderFormats() const override;
+	virtual TArr<EShaderStage> getSupportedShaderStages() const override;
+
+	virtual Void setDefaultState( const Mat4f &proj ) override;
+
+	virtual Void resize( U32 uResX, U32 uResY ) override;
+	virtual Void getSize( U32 &uResX, U32 &uResY ) override;
+
+	virtual Void wsiPresent() override;
+
+	virtual IGfxAPISampler *createSampler( const SGfxSamplerDesc &desc ) override;
+	virtual Void destroySampler( IGfxAPISampler * ) override;
+
+	virtual IGfxAPITexture *createTexture( ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData ) override;
+	virtual Void destroyTexture( IGfxAPITexture * ) override;
+
+	virtual IGfxAPIRenderTarget *createRenderTarget( U16 resX, U16 resY ) override;
+	virtual Void destroyRenderTarget( IGfxAPIRenderTarget * ) override;
+	virtual IGfxAPITexture *getRenderTargetTexture( IGfxAPIRenderTarget * ) override;
+
+	virtual IGfxAPIVLayout *createLayout( const SGfxLayout &desc ) override;
+	virtual Void destroyLayout( IGfxAPIVLayout * ) override;
+
+	virtual IGfxAPIVBuffer *createVBuffer( UPtr cBytes, const Void *pData, EBufferPerformance, EBufferPurpose ) override;
+	virtual IGfxAPIIBuffer *createIBuffer( UPtr cBytes, const Void *pData, EBufferPerformance, EBufferPurpose ) override;
+	virtual IGfxAPIUBuffer *createUBuffer( UPtr cBytes, const Void *pData, EBufferPerformance, EBufferPurpose ) override;
+	virtual Void destroyVBuffer( IGfxAPIVBuffer * ) override;
+	virtual Void destroyIBuffer( IGfxAPIIBuffer * ) override;
+	virtual Void destroyUBuffer( IGfxAPIUBuffer * ) override;
+
+	virtual IGfxAPIShader *createShader( Str filename, EShaderFormat, EShaderStage, UPtr cBytes, const Void *pData, IGfxDiagnostic * ) override;
+	virtual IGfxAPIProgram *createProgram( TArr<IGfxAPIShader *> shaders, IGfxDiagnostic * ) override;
+	virtual Void destroyShader( IGfxAPIShader * ) override;
+	virtual Void destroyProgram( IGfxAPIProgram * ) override;
+	virtual Bool setCacheDirectory( Str basePath ) override;
+	virtual Str getCacheDirectory() const override;
+	virtual Void invalidateShaderCache() override;
+
+	virtual Void vsSetProjectionMatrix( const F32 *matrix ) override;
+	virtual Void vsSetModelViewMatrix( const F32 *matrix ) override;
+
+	virtual Void psoSetScissorEnable( Bool enable ) override;
+	virtual Void psoSetTextureEnable( Bool enable ) override;
+	virtual Void psoSetBlend( EBlendOp, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB ) override;
+
+	virtual Void rsSetScissor( S32 posX, S32 posY, U32 resX, U32 resY ) override;
+	virtual Void rsSetViewport( S32 posX, S32 posY, U32 resX, U32 resY ) override;
+
+	virtual Void iaSetLayout( IGfxAPIVLayout * ) override;
+
+	virtual Void tsBindTexture( IGfxAPITexture *, U32 uStage ) override;
+	virtual Void tsBindSampler( IGfxAPISampler *, U32 uStage ) override;
+	virtual Void iaBindVBuffer( IGfxAPIVBuffer * ) override;
+	virtual Void iaBindIBuffer( IGfxAPIIBuffer *, EIndexFormat ) override;
+	virtual Void iaBindInstanceBuffer( IGfxAPIVBuffer * ) override;
+
+	virtual Void plBindProgram( IGfxAPIProgram * ) override;
+	virtual Void plUnbindProgram() override;
+	virtual Void cmdUpdateProgramBindings( const SGfxBinding & ) override;
+
+	virtual Void omBindRenderTarget( IGfxAPIRenderTarget * ) override;
+
+	virtual Void cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value ) override;
+	virtual Void cmdUpdateTexture( IGfxAPITexture *, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData ) override;
+	virtual Void cmdWriteVBuffer( IGfxAPIVBuffer *, UPtr offset, UPtr size, const Void *pData ) override;
+	virtual Void cmdWriteIBuffer( IGfxAPIIBuffer *, UPtr offset, UPtr size, const Void *pData ) override;
+	virtual Void cmdWriteUBuffer( IGfxAPIUBuffer *, UPtr offset, UPtr size, const Void *pData ) override;
+	virtual Void cmdReadVBuffer( IGfxAPIVBuffer *, UPtr offset, UPtr size, Void *pData ) override;
+	virtual Void cmdReadIBuffer( IGfxAPIIBuffer *, UPtr offset, UPtr size, Void *pData ) override;
+	virtual Void cmdReadUBuffer( IGfxAPIUBuffer *, UPtr offset, UPtr size, Void *pData ) override;
+	virtual Void cmdResolveRenderTarget( IGfxAPIRenderTarget * ) override;
+
+	virtual Void cmdDraw( ETopology, U32 cVerts, U32 uOffset ) override;
+	virtual Void cmdDrawIndexed( ETopology, U32 cIndices, U32 uOffset, U32 uBias ) override;
+	virtual Void cmdDrawInstanced( ETopology, U32 cVerts, U32 uOffset, U32 cInstances ) override;
+	virtual Void cmdDrawIndexedInstanced( ETopology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances ) override;
+
+private:
+	IGfxAPI &m_inner;
+	// Set once the capture has started; finalizing the capture then
+	// finalizes the captured API too
+	Bool m_bOwnsInner;
+
+	ECaptureState m_state;
+	MutStr m_filename;
+	IFile *m_pFile;
+	U32 m_uFirstFrame;
+	U32 m_cFrames;
+	// Frames presented since the capture began
+	U32 m_uFrame;
+	U32 m_uNextId;
+	U32 m_uResX, m_uResY;
+
+	TMutArr<SCaptureObject *> m_objects;
+	SCaptureShadow m_shadow;
+
+	// Calls not yet written to the file, and where the current one began
+	TMutArr<U8> m_stream;
+	UPtr m_uCallStart;
+
+	Bool isRecording() const { return m_state == kCapStateRecording; }
+
+	Void startRecording();
+	Void finish();
+	Void flush();
+	Void fail();
+
+	SCaptureObject *newObject( ECaptureObject type, Void *pInner );
+	Void deleteObject( SCaptureObject *pObj );
+	Void writeObject( const SCaptureObject &obj );
+	Void writeBufferContents( const SCaptureObject &obj );
+	Void forgetBinding( const SCaptureObject *pObj );
+
+	Void beginCall( EGfxCaptureCall call );
+	Void endCall();
+
+	Void putBytes( const Void *pData, UPtr cBytes );
+	Void putU8( U8 x );
+	Void putU16( U16 x );
+	Void putU32( U32 x );
+	Void putS32( S32 x ) { putU32( U32( x ) ); }
+	Void putF32( F32 x );
+	Void putUPtr( UPtr x ) { putU32( U32( x ) ); }
+	Void putBlob( const Void *pData, UPtr cBytes );
+	Void putMatrix( const F32 *matrix );
+	Void putRect( S32 posX, S32 posY, U32 resX, U32 resY );
+};
+
+//====================================================================//
+
+CGfxAPI_Capture::CGfxAPI_Capture( IGfxAPI &inner )
+: IGfxAPI( captureGfxAPIProvider )
+, m_inner( inner )
+, m_bOwnsInner( false )
+, m_state( kCapStateDone )
+, m_filename()
+, m_pFile( nullptr )
+, m_uFirstFrame( 0 )
+, m_cFrames( 0 )
+, m_uFrame( 0 )
+, m_uNextId( 1 )
+, m_uResX( 0 )
+, m_uResY( 0 )
+, m_objects()
+, m_stream()
+, m_uCallStart( 0 ) {
+	memset( &m_shadow, 0, sizeof( m_shadow ) );
+}
+CGfxAPI_Capture::~CGfxAPI_Capture() {
+	finish();
+
+	for( SCaptureObject *pObj : m_objects ) {
+		delete pObj;
+	}
+	m_objects.purge();
+
+	if( m_bOwnsInner ) {
+		m_inner.getAPIProvider().finiAPI( &m_inner );
+	}
+}
+
+Bool CGfxAPI_Capture::init( const SGfxCaptureDesc &desc ) {
+	if( !AX_VERIFY_MEMORY( m_filename.tryAssign( desc.filename ) ) ) {
+		return false;
+	}
+
+	// Fail now rather than after waiting for the first frame
+	IFile *const pFile = fs_open( desc.filename, kFileOpenF_W | kFileOpenF_Recreate, kFileAttrib_Regular );
+	if( !pFile ) {
+		g_ErrorLog( desc.filename ) += "Cannot open for capturing.";
+		return false;
+	}
+	fs_close( pFile );
+
+	m_uFirstFrame = desc.uFirstFrame;
+	m_cFrames     = desc.cFrames;
+	m_inner.getSize( m_uResX, m_uResY );
+
+	m_bOwnsInner = true;
+
+	m_state = kCapStateWaiting;
+	if( !m_uFirstFrame ) {
+		startRecording();
+	}
+
+	return true;
+}
+
+Void CGfxAPI_Capture::startRecording() {
+	AX_ASSERT( m_state == kCapStateWaiting );
+
+	m_pFile = fs_open( m_filename, kFileOpenF_W | kFileOpenF_Recreate, kFileAttrib_Regular );
+	if( !m_pFile ) {
+		g_ErrorLog( m_filename ) += "Cannot open for capturing.";
+		fail();
+		return;
+	}
+
+	DOLL_DEBUG_LOG += axf( "Capturing %u frame(s) to \"%.*s\"", m_cFrames, m_filename.lenInt(), m_filename.get() );
+
+	m_state = kCapStateRecording;
+
+	putU32( kCaptureMagic );
+	putU16( kCaptureVersion );
+	putU16( 0 );
+	putU32( m_uResX );
+	putU32( m_uResY );
+
+	// Recreate the objects alive so far; programs refer to shaders, so go
+	// type by type
+	for( U32 uType = 0; uType < kNumCapObjs; ++uType ) {
+		for( SCaptureObject *pObj : m_objects ) {
+			// A render target's texture is made along with it
+			if( pObj->type == ECaptureObject( uType ) && !pObj->pOwner ) {
+				writeObject( *pObj );
+			}
+		}
+	}
+
+	// Then the state they were left in
+	const SCaptureShadow &s = m_shadow;
+	if( s.uKnown & kCapKnown_Default ) {
+		beginCall( kGfxCapSetDefaultState );
+		putMatrix( s.defaultProj );
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_Projection ) {
+		beginCall( kGfxCapSetProjection );
+		putMatrix( s.projection );
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_ModelView ) {
+		beginCall( kGfxCapSetModelView );
+		putMatrix( s.modelView );
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_ScissorEnable ) {
+		beginCall( kGfxCapSetScissorEnable );
+		putU8( U8( s.bScissor ) );
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_TextureEnable ) {
+		beginCall( kGfxCapSetTextureEnable );
+		putU8( U8( s.bTexture ) );
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_Blend ) {
+		beginCall( kGfxCapSetBlend );
+		for( U32 x : s.blend ) {
+			putU32( x );
+		}
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_Scissor ) {
+		beginCall( kGfxCapSetScissor );
+		putRect( s.scissor[0], s.scissor[1], U32( s.scissor[2] ), U32( s.scissor[3] ) );
+		endCall();
+	}
+	if( s.uKnown & kCapKnown_Viewport ) {
+		beginCall( kGfxCapSetViewport );
+		putRect( s.viewport[0], s.viewport[1], U32( s.viewport[2] ), U32( s.viewport[3] ) );
+		endCall();
+	}
+	if( s.pLayout != nullptr ) {
+		beginCall( kGfxCapSetLayout );
+		putU32( s.pLayout->uId );
+		endCall();
+	}
+	if( s.pVBuffer != nullptr ) {
+		beginCall( kGfxCapBindVBuffer );
+		putU32( s.pVBuffer->uId );
+		endCall();
+	}
+	if( s.pIBuffer != nullptr ) {
+		beginCall( kGfxCapBindIBuffer );
+		putU32( s.pIBuffer->uId );
+		putU32( U32( s.indexFormat ) );
+		endCall();
+	}
+	if( s.pInstanceBuffer != nullptr ) {
+		beginCall( kGfxCapBindInstanceBuffer );
+		putU32( s.pInstanceBuffer->uId );
+		endCall();
+	}
+	if( s.pProgram != nullptr ) {
+		beginCall( kGfxCapBindProgram );
+		putU32( s.pProgram->uId );
+		endCall();
+	}
+	if( s.pRenderTarget != nullptr ) {
+		beginCall( kGfxCapBindRenderTarget );
+		putU32( s.pRenderTarget->uId );
+		endCall();
+	}
+	for( U32 i = 0; i < kCaptureTexStages; ++i ) {
+		if( s.pTextures[i] != nullptr ) {
+			beginCall( kGfxCapBindTexture );
+			putU32( s.pTextures[i]->uId );
+			putU32( i );
+			endCall();
+		}
+		if( s.pSamplers[i] != nullptr ) {
+			beginCall( kGfxCapBindSampler );
+			putU32( s.pSamplers[i]->uId );
+			putU32( i );
+			endCall();
+		}
+	}
+
+	// Texels were only kept for the above
+	for( SCaptureObject *pObj : m_objects ) {
+		if( pObj->type == kCapObjTexture ) {
+			pObj->data.purge();
+		}
+	}
+}
+Void CGfxAPI_Capture::finish() {
+	if( m_state == kCapStateRecording ) {
+		beginCall( kGfxCapEnd );
+		endCall();
+		flush();
+
+		DOLL_DEBUG_LOG += axf( "Captured %u frame(s) to \"%.*s\"", m_uFrame - m_uFirstFrame, m_filename.lenInt(), m_filename.get() );
+	}
+
+	if( m_pFile != nullptr ) {
+		fs_close( m_pFile );
+		m_pFile = nullptr;
+	}
+
+	m_state = kCapStateDone;
+	m_stream.purge();
+
+	for( SCaptureObject *pObj : m_objects ) {
+		pObj->data.purge();
+	}
+}
+Void CGfxAPI_Capture::flush() {
+	if( !m_pFile || m_stream.isEmpty() ) {
+		return;
+	}
+
+	if( fs_write( m_pFile, m_stream.pointer(), m_stream.num() ) != m_stream.num() ) {
+		g_ErrorLog( m_filename ) += "Failed to write capture.";
+		m_stream.clear();
+		fail();
+		return;
+	}
+
+	m_stream.clear();
+}
+Void CGfxAPI_Capture::fail() {
+	// Whatever was written so far is still readable up to the failure
+	if( m_pFile != nullptr ) {
+		fs_close( m_pFile );
+		m_pFile = nullptr;
+	}
+
+	m_state = kCapStateDone;
+	m_stream.purge();
+
+	for( SCaptureObject *pObj : m_objects ) {
+		pObj->data.purge();
+	}
+}
+
+SCaptureObject *CGfxAPI_Capture::newObject( ECaptureObject type, Void *pInner ) {
+	AX_ASSERT_NOT_NULL( pInner );
+
+	SCaptureObject *const pObj = new SCaptureObject();
+	if( !AX_VERIFY_MEMORY( pObj ) ) {
+		return nullptr;
+	}
+
+	pObj->type           = type;
+	pObj->uId            = m_uNextId++;
+	pObj->uIndex         = m_objects.num();
+	pObj->pInner         = pInner;
+	pObj->pTargetTexture = nullptr;
+	pObj->pOwner         = nullptr;
+
+	if( !AX_VERIFY_MEMORY( m_objects.append( pObj ) ) ) {
+		delete pObj;
+		return nullptr;
+	}
+
+	return pObj;
+}
+Void CGfxAPI_Capture::deleteObject( SCaptureObject *pObj ) {
+	AX_ASSERT_NOT_NULL( pObj );
+	AX_ASSERT( pObj->uIndex < m_objects.num() && m_objects[pObj->uIndex] == pObj );
+
+	forgetBinding( pObj );
+
+	const UPtr uLast = m_objects.num() - 1;
+	if( pObj->uIndex != uLast ) {
+		m_objects[pObj->uIndex]         = m_objects[uLast];
+		m_objects[pObj->uIndex]->uIndex = pObj->uIndex;
+	}
+	m_objects.resize( uLast );
+
+	delete pObj;
+}
+Void CGfxAPI_Capture::forgetBinding( const SCaptureObject *pObj ) {
+	SCaptureShadow &s = m_shadow;
+
+	if( s.pLayout == pObj ) {
+		s.pLayout = nullptr;
+	}
+	if( s.pVBuffer == pObj ) {
+		s.pVBuffer = nullptr;
+	}
+	if( s.pIBuffer == pObj ) {
+		s.pIBuffer = nullptr;
+	}
+	if( s.pInstanceBuffer == pObj ) {
+		s.pInstanceBuffer = nullptr;
+	}
+	if( s.pProgram == pObj ) {
+		s.pProgram = nullptr;
+	}
+	if( s.pRenderTarget == pObj ) {
+		s.pRenderTarget = nullptr;
+	}
+	for( U32 i = 0; i < kCaptureTexStages; ++i ) {
+		if( s.pTextures[i] == pObj ) {
+			s.pTextures[i] = nullptr;
+		}
+		if( s.pSamplers[i] == pObj ) {
+			s.pSamplers[i] = nullptr;
+		}
+	}
+}
+
+// Write the call that creates `obj` as it is now (only used when recording
+// starts; objects created while recording are written as they're created)
+Void CGfxAPI_Capture::writeObject( const SCaptureObject &obj ) {
+	beginCall( kCapObjCreateCalls[obj.type] );
+	putU32( obj.uId );
+
+	switch( obj.type ) {
+	case kCapObjSampler: {
+		const SGfxSamplerDesc &d = obj.sampler;
+		putU32( U32( d.magFilter ) );
+		putU32( U32( d.minFilter ) );
+		putU32( U32( d.mipmapMode ) );
+		putU32( U32( d.wrapU ) );
+		putU32( U32( d.wrapV ) );
+		putU32( U32( d.wrapW ) );
+		putF32( d.mipLodBias );
+		putF32( d.minLod );
+		putF32( d.maxLod );
+		putU8( U8( d.anisotropyEnable ) );
+		putF32( d.maxAnisotropy );
+		putU8( U8( d.compareEnable ) );
+		putU32( U32( d.compareOp ) );
+		putU32( U32( d.borderColor ) );
+		endCall();
+		break;
+	}
+
+	case kCapObjTexture:
+		// Texels are kept as BGRA, so the contents go in an update
+		putU32( U32( obj.texFmt ) );
+		putU16( obj.texResX );
+		putU16( obj.texResY );
+		putBlob( nullptr, 0 );
+		endCall();
+
+		if( !obj.data.isEmpty() ) {
+			beginCall( kGfxCapUpdateTexture );
+			putU32( obj.uId );
+			putU16( 0 );
+			putU16( 0 );
+			putU16( obj.texResX );
+			putU16( obj.texResY );
+			putBlob( obj.data.pointer(), obj.data.num() );
+			endCall();
+		}
+		break;
+
+	case kCapObjLayout:
+		putUPtr( obj.layout.stride );
+		putUPtr( obj.layout.instanceStride );
+		putUPtr( obj.layout.cElements );
+		for( UPtr i = 0; i < obj.layout.cElements; ++i ) {
+			const SGfxLayoutElement &e = obj.layout.elements[i];
+			putU32( U32( e.type ) );
+			putU32( U32( e.cComps ) );
+			putU32( U32( e.compTy ) );
+			putUPtr( e.uOffset );
+			putUPtr( e.cBytes );
+			putU32( e.uStepRate );
+		}
+		endCall();
+		break;
+
+	case kCapObjVBuffer:
+	case kCapObjIBuffer:
+	case kCapObjUBuffer:
+		putUPtr( obj.cBufferBytes );
+		putU32( U32( obj.bufferPerf ) );
+		putU32( U32( obj.bufferPurpose ) );
+		writeBufferContents( obj );
+		endCall();
+		break;
+
+	case kCapObjShader:
+		putBlob( obj.shaderFilename.get(), obj.shaderFilename.len() );
+		putU32( U32( obj.shaderFmt ) );
+		putU32( U32( obj.shaderStage ) );
+		putBlob( obj.data.pointer(), obj.data.num() );
+		endCall();
+		break;
+
+	case kCapObjProgram:
+		putU32( U32( obj.programShaders.num() ) );
+		for( U32 uShaderId : obj.programShaders ) {
+			putU32( uShaderId );
+		}
+		endCall();
+		break;
+
+	case kCapObjRenderTarget:
+		putU32( obj.pTargetTexture->uId );
+		putU16( obj.texResX );
+		putU16( obj.texResY );
+		endCall();
+		break;
+
+	case kNumCapObjs:
+		AX_UNREACHABLE();
+	}
+}
+// Read a buffer back from the captured API into the call being written
+Void CGfxAPI_Capture::writeBufferContents( const SCaptureObject &obj ) {
+	TMutArr<U8> contents;
+	if( !AX_VERIFY_MEMORY( contents.resize( obj.cBufferBytes ) ) ) {
+		putBlob( nullptr, 0 );
+		return;
+	}
+
+	switch( obj.type ) {
+	case kCapObjVBuffer:
+		m_inner.cmdReadVBuffer( reinterpret_cast<IGfxAPIVBuffer *>( obj.pInner ), 0, obj.cBufferBytes, contents.pointer() );
+		break;
+	case kCapObjIBuffer:
+		m_inner.cmdReadIBuffer( reinterpret_cast<IGfxAPIIBuffer *>( obj.pInner ), 0, obj.cBufferBytes, contents.pointer() );
+		break;
+	case kCapObjUBuffer:
+		m_inner.cmdReadUBuffer( reinterpret_cast<IGfxAPIUBuffer *>( obj.pInner ), 0, obj.cBufferBytes, contents.pointer() );
+		break;
+	default:
+		AX_UNREACHABLE();
+	}
+
+	putBlob( contents.pointer(), contents.num() );
+}
+
+Void CGfxAPI_Capture::beginCall( EGfxCaptureCall call ) {
+	m_uCallStart = m_stream.num();
+
+	putU8( U8( call ) );
+	putU32( 0 );
+}
+Void CGfxAPI_Capture::endCall() {
+	if( !isRecording() ) {
+		return;
+	}
+
+	AX_ASSERT( m_stream.num() >= m_uCallStart + kCaptureCallHeaderBytes );
+
+	// Patch in the size of the parameters
+	const U32 cBytes = U32( m_stream.num() - m_uCallStart - kCaptureCallHeaderBytes );
+	U8 *const p = m_stream.pointer() + m_uCallStart + 1;
+	p[0] = U8( cBytes );
+	p[1] = U8( cBytes >> 8 );
+	p[2] = U8( cBytes >> 16 );
+	p[3] = U8( cBytes >> 24 );
+
+	if( m_stream.num() >= kCaptureFlushBytes ) {
+		flush();
+	}
+}
+
+Void CGfxAPI_Capture::putBytes( const Void *pData, UPtr cBytes ) {
+	if( !isRecording() || !cBytes ) {
+		return;
+	}
+
+	const UPtr n = m_stream.num();
+	if( !AX_VERIFY_MEMORY( m_stream.resize( n + cBytes ) ) ) {
+		fail();
+		return;
+	}
+
+	memcpy( m_stream.pointer() + n, pData, cBytes );
+}
+Void CGfxAPI_Capture::putU8( U8 x ) {
+	putBytes( &x, 1 );
+}
+// Little endian, whatever the platform
+Void CGfxAPI_Capture::putU16( U16 x ) {
+	const U8 bytes[2] = { U8( x ), U8( x >> 8 ) };
+	putBytes( bytes, sizeof( bytes ) );
+}
+Void CGfxAPI_Capture::putU32( U32 x ) {
+	const U8 bytes[4] = { U8( x ), U8( x >> 8 ), U8( x >> 16 ), U8( x >> 24 ) };
+	putBytes( bytes, sizeof( bytes ) );
+}
+Void CGfxAPI_Capture::putF32( F32 x ) {
+	U32 u;
+	memcpy( &u, &x, sizeof( u ) );
+	putU32( u );
+}
+Void CGfxAPI_Capture::putBlob( const Void *pData, UPtr cBytes ) {
+	AX_ASSERT( pData != nullptr || cBytes == 0 );
+
+	putU32( U32( cBytes ) );
+	putBytes( pData, cBytes );
+}
+Void CGfxAPI_Capture::putMatrix( const F32 *matrix ) {
+	AX_ASSERT_NOT_NULL( matrix );
+
+	for( U32 i = 0; i < 16; ++i ) {
+		putF32( matrix[i] );
+	}
+}
+Void CGfxAPI_Capture::putRect( S32 posX, S32 posY, U32 resX, U32 resY ) {
+	putS32( posX );
+	putS32( posY );
+	putU32( resX );
+	putU32( resY );
+}
+
+//====================================================================//
+
+EGfxAPI CGfxAPI_Capture::getAPI() const {
+	return m_inner.getAPI();
+}
+
+TArr<EShaderFormat> CGfxAPI_Capture::getSupportedShaderFormats() const {
+	return m_inner.getSupportedShaderFormats();
+}
+TArr<EShaderStage> CGfxAPI_Capture::getSupportedShaderStages() const {
+	return m_inner.getSupportedShaderStages();
+}
+
+Void CGfxAPI_Capture::setDefaultState( const Mat4f &proj ) {
+	m_inner.setDefaultState( proj );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetDefaultState );
+		putMatrix( proj.ptr() );
+		endCall();
+		return;
+	}
+
+	// Everything set before is overridden (including the bound texture)
+	SCaptureShadow &s = m_shadow;
+	s.uKnown = kCapKnown_Default;
+	memcpy( s.defaultProj, proj.ptr(), sizeof( s.defaultProj ) );
+	for( SCaptureObject *&pTex : s.pTextures ) {
+		pTex = nullptr;
+	}
+}
+
+Void CGfxAPI_Capture::resize( U32 uResX, U32 uResY ) {
+	m_inner.resize( uResX, uResY );
+
+	m_uResX = uResX;
+	m_uResY = uResY;
+
+	beginCall( kGfxCapResize );
+	putU32( uResX );
+	putU32( uResY );
+	endCall();
+}
+Void CGfxAPI_Capture::getSize( U32 &uResX, U32 &uResY ) {
+	m_inner.getSize( uResX, uResY );
+}
+
+Void CGfxAPI_Capture::wsiPresent() {
+	beginCall( kGfxCapPresent );
+	endCall();
+
+	m_inner.wsiPresent();
+	++m_uFrame;
+
+	if( m_state == kCapStateWaiting && m_uFrame == m_uFirstFrame ) {
+		startRecording();
+	} else if( isRecording() ) {
+		if( m_cFrames > 0 && m_uFrame - m_uFirstFrame >= m_cFrames ) {
+			finish();
+		} else {
+			flush();
+		}
+	}
+}
+
+IGfxAPISampler *CGfxAPI_Capture::createSampler( const SGfxSamplerDesc &desc ) {
+	IGfxAPISampler *const pInner = m_inner.createSampler( desc );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjSampler, pInner );
+	if( !pObj ) {
+		m_inner.destroySampler( pInner );
+		return nullptr;
+	}
+
+	pObj->sampler = desc;
+	writeObject( *pObj );
+
+	return reinterpret_cast<IGfxAPISampler *>( pObj );
+}
+Void CGfxAPI_Capture::destroySampler( IGfxAPISampler *pSampler ) {
+	if( !pSampler ) {
+		return;
+	}
+
+	m_inner.destroySampler( innerOf( pSampler ) );
+
+	beginCall( kGfxCapDestroySampler );
+	putU32( idOf( pSampler ) );
+	endCall();
+
+	deleteObject( toCapObj( pSampler ) );
+}
+
+IGfxAPITexture *CGfxAPI_Capture::createTexture( ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData ) {
+	IGfxAPITexture *const pInner = m_inner.createTexture( fmt, resX, resY, pData );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjTexture, pInner );
+	if( !pObj ) {
+		m_inner.destroyTexture( pInner );
+		return nullptr;
+	}
+
+	pObj->texFmt  = fmt;
+	pObj->texResX = resX;
+	pObj->texResY = resY;
+
+	const UPtr cTexels = UPtr( resX ) * UPtr( resY );
+	const UPtr cSrcBytes = fmt == kTexFmtRGB8 ? 3 : 4;
+
+	if( isRecording() ) {
+		beginCall( kGfxCapCreateTexture );
+		putU32( pObj->uId );
+		putU32( U32( fmt ) );
+		putU16( resX );
+		putU16( resY );
+		putBlob( pData, pData != nullptr ? cTexels * cSrcBytes : 0 );
+		endCall();
+	} else if( m_state == kCapStateWaiting && pData != nullptr ) {
+		// Keep the texels (as BGRA, the format updates use) for when
+		// recording starts
+		if( AX_VERIFY_MEMORY( pObj->data.resize( cTexels * 4 ) ) ) {
+			U8 *const pDst = pObj->data.pointer();
+			for( UPtr i = 0; i < cTexels; ++i ) {
+				pDst[i * 4 + 0] = pData[i * cSrcBytes + 0];
+				pDst[i * 4 + 1] = pData[i * cSrcBytes + 1];
+				pDst[i * 4 + 2] = pData[i * cSrcBytes + 2];
+				pDst[i * 4 + 3] = cSrcBytes == 4 ? pData[i * cSrcBytes + 3] : 0xFF;
+			}
+		}
+	}
+
+	return reinterpret_cast<IGfxAPITexture *>( pObj );
+}
+Void CGfxAPI_Capture::destroyTexture( IGfxAPITexture *pTexture ) {
+	if( !pTexture ) {
+		return;
+	}
+
+	m_inner.destroyTexture( innerOf( pTexture ) );
+
+	beginCall( kGfxCapDestroyTexture );
+	putU32( idOf( pTexture ) );
+	endCall();
+
+	deleteObject( toCapObj( pTexture ) );
+}
+
+IGfxAPIRenderTarget *CGfxAPI_Capture::createRenderTarget( U16 resX, U16 resY ) {
+	IGfxAPIRenderTarget *const pInner = m_inner.createRenderTarget( resX, resY );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjRenderTarget, pInner );
+	SCaptureObject *const pTex = pObj != nullptr ? newObject( kCapObjTexture, m_inner.getRenderTargetTexture( pInner ) ) : nullptr;
+	if( !pTex ) {
+		if( pObj != nullptr ) {
+			deleteObject( pObj );
+		}
+		m_inner.destroyRenderTarget( pInner );
+		return nullptr;
+	}
+
+	pObj->texFmt         = kTexFmtRGBA8;
+	pObj->texResX        = resX;
+	pObj->texResY        = resY;
+	pObj->pTargetTexture = pTex;
+
+	pTex->texFmt  = kTexFmtRGBA8;
+	pTex->texResX = resX;
+	pTex->texResY = resY;
+	pTex->pOwner  = pObj;
+
+	writeObject( *pObj );
+	return reinterpret_cast<IGfxAPIRenderTarget *>( pObj );
+}
+Void CGfxAPI_Capture::destroyRenderTarget( IGfxAPIRenderTarget *pTarget ) {
+	if( !pTarget ) {
+		return;
+	}
+
+	m_inner.destroyRenderTarget( innerOf( pTarget ) );
+
+	beginCall( kGfxCapDestroyRenderTarget );
+	putU32( idOf( pTarget ) );
+	endCall();
+
+	SCaptureObject *const pObj = toCapObj( pTarget );
+	deleteObject( pObj->pTargetTexture );
+	deleteObject( pObj );
+}
+IGfxAPITexture *CGfxAPI_Capture::getRenderTargetTexture( IGfxAPIRenderTarget *pTarget ) {
+	return pTarget != nullptr ? reinterpret_cast<IGfxAPITexture *>( toCapObj( pTarget )->pTargetTexture ) : nullptr;
+}
+
+IGfxAPIVLayout *CGfxAPI_Capture::createLayout( const SGfxLayout &desc ) {
+	IGfxAPIVLayout *const pInner = m_inner.createLayout( desc );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjLayout, pInner );
+	if( !pObj ) {
+		m_inner.destroyLayout( pInner );
+		return nullptr;
+	}
+
+	pObj->layout.stride         = desc.stride;
+	pObj->layout.instanceStride = desc.instanceStride;
+	pObj->layout.cElements      = desc.cElements;
+	pObj->layout.pAPIObj        = nullptr;
+	for( UPtr i = 0; i < desc.cElements && i < kMaxLayoutElements; ++i ) {
+		pObj->layout.elements[i] = desc.elements[i];
+	}
+
+	writeObject( *pObj );
+
+	return reinterpret_cast<IGfxAPIVLayout *>( pObj );
+}
+Void CGfxAPI_Capture::destroyLayout( IGfxAPIVLayout *pLayout ) {
+	if( !pLayout ) {
+		return;
+	}
+
+	m_inner.destroyLayout( innerOf( pLayout ) );
+
+	beginCall( kGfxCapDestroyLayout );
+	putU32( idOf( pLayout ) );
+	endCall();
+
+	deleteObject( toCapObj( pLayout ) );
+}
+
+IGfxAPIVBuffer *CGfxAPI_Capture::createVBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
+	IGfxAPIVBuffer *const pInner = m_inner.createVBuffer( cBytes, pData, perf, purpose );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjVBuffer, pInner );
+	if( !pObj ) {
+		m_inner.destroyVBuffer( pInner );
+		return nullptr;
+	}
+
+	pObj->cBufferBytes  = cBytes;
+	pObj->bufferPerf    = perf;
+	pObj->bufferPurpose = purpose;
+
+	beginCall( kGfxCapCreateVBuffer );
+	putU32( pObj->uId );
+	putUPtr( cBytes );
+	putU32( U32( perf ) );
+	putU32( U32( purpose ) );
+	putBlob( pData, pData != nullptr ? cBytes : 0 );
+	endCall();
+
+	return reinterpret_cast<IGfxAPIVBuffer *>( pObj );
+}
+IGfxAPIIBuffer *CGfxAPI_Capture::createIBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
+	IGfxAPIIBuffer *const pInner = m_inner.createIBuffer( cBytes, pData, perf, purpose );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjIBuffer, pInner );
+	if( !pObj ) {
+		m_inner.destroyIBuffer( pInner );
+		return nullptr;
+	}
+
+	pObj->cBufferBytes  = cBytes;
+	pObj->bufferPerf    = perf;
+	pObj->bufferPurpose = purpose;
+
+	beginCall( kGfxCapCreateIBuffer );
+	putU32( pObj->uId );
+	putUPtr( cBytes );
+	putU32( U32( perf ) );
+	putU32( U32( purpose ) );
+	putBlob( pData, pData != nullptr ? cBytes : 0 );
+	endCall();
+
+	return reinterpret_cast<IGfxAPIIBuffer *>( pObj );
+}
+IGfxAPIUBuffer *CGfxAPI_Capture::createUBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
+	IGfxAPIUBuffer *const pInner = m_inner.createUBuffer( cBytes, pData, perf, purpose );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjUBuffer, pInner );
+	if( !pObj ) {
+		m_inner.destroyUBuffer( pInner );
+		return nullptr;
+	}
+
+	pObj->cBufferBytes  = cBytes;
+	pObj->bufferPerf    = perf;
+	pObj->bufferPurpose = purpose;
+
+	beginCall( kGfxCapCreateUBuffer );
+	putU32( pObj->uId );
+	putUPtr( cBytes );
+	putU32( U32( perf ) );
+	putU32( U32( purpose ) );
+	putBlob( pData, pData != nullptr ? cBytes : 0 );
+	endCall();
+
+	return reinterpret_cast<IGfxAPIUBuffer *>( pObj );
+}
+Void CGfxAPI_Capture::destroyVBuffer( IGfxAPIVBuffer *pVBuffer ) {
+	if( !pVBuffer ) {
+		return;
+	}
+
+	m_inner.destroyVBuffer( innerOf( pVBuffer ) );
+
+	beginCall( kGfxCapDestroyVBuffer );
+	putU32( idOf( pVBuffer ) );
+	endCall();
+
+	deleteObject( toCapObj( pVBuffer ) );
+}
+Void CGfxAPI_Capture::destroyIBuffer( IGfxAPIIBuffer *pIBuffer ) {
+	if( !pIBuffer ) {
+		return;
+	}
+
+	m_inner.destroyIBuffer( innerOf( pIBuffer ) );
+
+	beginCall( kGfxCapDestroyIBuffer );
+	putU32( idOf( pIBuffer ) );
+	endCall();
+
+	deleteObject( toCapObj( pIBuffer ) );
+}
+Void CGfxAPI_Capture::destroyUBuffer( IGfxAPIUBuffer *pUBuffer ) {
+	if( !pUBuffer ) {
+		return;
+	}
+
+	m_inner.destroyUBuffer( innerOf( pUBuffer ) );
+
+	beginCall( kGfxCapDestroyUBuffer );
+	putU32( idOf( pUBuffer ) );
+	endCall();
+
+	deleteObject( toCapObj( pUBuffer ) );
+}
+
+IGfxAPIShader *CGfxAPI_Capture::createShader( Str filename, EShaderFormat fmt, EShaderStage stage, UPtr cBytes, const Void *pData, IGfxDiagnostic *pDiag ) {
+	IGfxAPIShader *const pInner = m_inner.createShader( filename, fmt, stage, cBytes, pData, pDiag );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjShader, pInner );
+	if( !pObj ) {
+		m_inner.destroyShader( pInner );
+		return nullptr;
+	}
+
+	pObj->shaderFmt   = fmt;
+	pObj->shaderStage = stage;
+
+	// Shaders are small, and can be needed whenever recording starts
+	if( m_state != kCapStateDone ) {
+		if( !AX_VERIFY_MEMORY( pObj->shaderFilename.tryAssign( filename ) ) ) {
+			pObj->shaderFilename.clear();
+		}
+		if( pData != nullptr && cBytes > 0 && AX_VERIFY_MEMORY( pObj->data.resize( cBytes ) ) ) {
+			memcpy( pObj->data.pointer(), pData, cBytes );
+		}
+	}
+
+	if( isRecording() ) {
+		writeObject( *pObj );
+	}
+
+	return reinterpret_cast<IGfxAPIShader *>( pObj );
+}
+IGfxAPIProgram *CGfxAPI_Capture::createProgram( TArr<IGfxAPIShader *> shaders, IGfxDiagnostic *pDiag ) {
+	TMutArr<IGfxAPIShader *> innerShaders;
+	TMutArr<U32> shaderIds;
+	if( !AX_VERIFY_MEMORY( innerShaders.reserve( shaders.num() ) ) || !AX_VERIFY_MEMORY( shaderIds.reserve( shaders.num() ) ) ) {
+		return nullptr;
+	}
+
+	for( IGfxAPIShader *pShader : shaders ) {
+		innerShaders.append( innerOf( pShader ) );
+		shaderIds.append( idOf( pShader ) );
+	}
+
+	IGfxAPIProgram *const pInner = m_inner.createProgram( innerShaders, pDiag );
+	if( !pInner ) {
+		return nullptr;
+	}
+
+	SCaptureObject *const pObj = newObject( kCapObjProgram, pInner );
+	if( !pObj ) {
+		m_inner.destroyProgram( pInner );
+		return nullptr;
+	}
+
+	pObj->programShaders.swap( shaderIds );
+	writeObject( *pObj );
+
+	return reinterpret_cast<IGfxAPIProgram *>( pObj );
+}
+Void CGfxAPI_Capture::destroyShader( IGfxAPIShader *pShader ) {
+	if( !pShader ) {
+		return;
+	}
+
+	m_inner.destroyShader( innerOf( pShader ) );
+
+	beginCall( kGfxCapDestroyShader );
+	putU32( idOf( pShader ) );
+	endCall();
+
+	deleteObject( toCapObj( pShader ) );
+}
+Void CGfxAPI_Capture::destroyProgram( IGfxAPIProgram *pProgram ) {
+	if( !pProgram ) {
+		return;
+	}
+
+	m_inner.destroyProgram( innerOf( pProgram ) );
+
+	beginCall( kGfxCapDestroyProgram );
+	putU32( idOf( pProgram ) );
+	endCall();
+
+	deleteObject( toCapObj( pProgram ) );
+}
+Bool CGfxAPI_Capture::setCacheDirectory( Str basePath ) {
+	return m_inner.setCacheDirectory( basePath );
+}
+Str CGfxAPI_Capture::getCacheDirectory() const {
+	return m_inner.getCacheDirectory();
+}
+Void CGfxAPI_Capture::invalidateShaderCache() {
+	m_inner.invalidateShaderCache();
+}
+
+Void CGfxAPI_Capture::vsSetProjectionMatrix( const F32 *matrix ) {
+	m_inner.vsSetProjectionMatrix( matrix );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetProjection );
+		putMatrix( matrix );
+		endCall();
+	} else {
+		m_shadow.uKnown |= kCapKnown_Projection;
+		memcpy( m_shadow.projection, matrix, sizeof( m_shadow.projection ) );
+	}
+}
+Void CGfxAPI_Capture::vsSetModelViewMatrix( const F32 *matrix ) {
+	m_inner.vsSetModelViewMatrix( matrix );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetModelView );
+		putMatrix( matrix );
+		endCall();
+	} else {
+		m_shadow.uKnown |= kCapKnown_ModelView;
+		memcpy( m_shadow.modelView, matrix, sizeof( m_shadow.modelView ) );
+	}
+}
+
+Void CGfxAPI_Capture::psoSetScissorEnable( Bool enable ) {
+	m_inner.psoSetScissorEnable( enable );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetScissorEnable );
+		putU8( U8( enable ) );
+		endCall();
+	} else {
+		m_shadow.uKnown |= kCapKnown_ScissorEnable;
+		m_shadow.bScissor = enable;
+	}
+}
+Void CGfxAPI_Capture::psoSetTextureEnable( Bool enable ) {
+	m_inner.psoSetTextureEnable( enable );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetTextureEnable );
+		putU8( U8( enable ) );
+		endCall();
+	} else {
+		m_shadow.uKnown |= kCapKnown_TextureEnable;
+		m_shadow.bTexture = enable;
+	}
+}
+Void CGfxAPI_Capture::psoSetBlend( EBlendOp op, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB ) {
+	m_inner.psoSetBlend( op, colA, colB, alphaA, alphaB );
+
+	const U32 blend[5] = { U32( op ), U32( colA ), U32( colB ), U32( alphaA ), U32( alphaB ) };
+	if( isRecording() ) {
+		beginCall( kGfxCapSetBlend );
+		for( U32 x : blend ) {
+			putU32( x );
+		}
+		endCall();
+	} else {
+		m_shadow.uKnown |= kCapKnown_Blend;
+		memcpy( m_shadow.blend, blend, sizeof( m_shadow.blend ) );
+	}
+}
+
+Void CGfxAPI_Capture::rsSetScissor( S32 posX, S32 posY, U32 resX, U32 resY ) {
+	m_inner.rsSetScissor( posX, posY, resX, resY );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetScissor );
+		putRect( posX, posY, resX, resY );
+		endCall();
+	} else {
+		const S32 rect[4] = { posX, posY, S32( resX ), S32( resY ) };
+		m_shadow.uKnown |= kCapKnown_Scissor;
+		memcpy( m_shadow.scissor, rect, sizeof( m_shadow.scissor ) );
+	}
+}
+Void CGfxAPI_Capture::rsSetViewport( S32 posX, S32 posY, U32 resX, U32 resY ) {
+	m_inner.rsSetViewport( posX, posY, resX, resY );
+
+	if( isRecording() ) {
+		beginCall( kGfxCapSetViewport );
+		putRect( posX, posY, resX, resY );
+		endCall();
+	} else {
+		const S32 rect[4] = { posX, posY, S32( resX ), S32( resY ) };
+		m_shadow.uKnown |= kCapKnown_Viewport;
+		memcpy( m_shadow.viewport, rect, sizeof( m_shadow.viewport ) );
+	}
+}
+
+Void CGfxAPI_Capture::iaSetLayout( IGfxAPIVLayout *pLayout ) {
+	m_inner.iaSetLayout( innerOf( pLayout ) );
+
+	m_shadow.pLayout = toCapObj( pLayout );
+
+	beginCall( kGfxCapSetLayout );
+	putU32( idOf( pLayout ) );
+	endCall();
+}
+
+Void CGfxAPI_Capture::tsBindTexture( IGfxAPITexture *pTexture, U32 uStage ) {
+	m_inner.tsBindTexture( innerOf( pTexture ), uStage );
+
+	if( uStage < kCaptureTexStages ) {
+		m_shadow.pTextures[uStage] = toCapObj( pTexture );
+	}
+
+	beginCall( kGfxCapBindTexture );
+	putU32( idOf( pTexture ) );
+	putU32( uStage );
+	endCall();
+}
+Void CGfxAPI_Capture::tsBindSampler( IGfxAPISampler *pSampler, U32 uStage ) {
+	m_inner.tsBindSampler( innerOf( pSampler ), uStage );
+
+	if( uStage < kCaptureTexStages ) {
+		m_shadow.pSamplers[uStage] = toCapObj( pSampler );
+	}
+
+	beginCall( kGfxCapBindSampler );
+	putU32( idOf( pSampler ) );
+	putU32( uStage );
+	endCall();
+}
+Void CGfxAPI_Capture::iaBindVBuffer( IGfxAPIVBuffer *pVBuffer ) {
+	m_inner.iaBindVBuffer( innerOf( pVBuffer ) );
+
+	m_shadow.pVBuffer = toCapObj( pVBuffer );
+
+	beginCall( kGfxCapBindVBuffer );
+	putU32( idOf( pVBuffer ) );
+	endCall();
+}
+Void CGfxAPI_Capture::iaBindIBuffer( IGfxAPIIBuffer *pIBuffer, EIndexFormat fmt ) {
+	m_inner.iaBindIBuffer( innerOf( pIBuffer ), fmt );
+
+	m_shadow.pIBuffer    = toCapObj( pIBuffer );
+	m_shadow.indexFormat = fmt;
+
+	beginCall( kGfxCapBindIBuffer );
+	putU32( idOf( pIBuffer ) );
+	putU32( U32( fmt ) );
+	endCall();
+}
+Void CGfxAPI_Capture::iaBindInstanceBuffer( IGfxAPIVBuffer *pVBuffer ) {
+	m_inner.iaBindInstanceBuffer( innerOf( pVBuffer ) );
+
+	m_shadow.pInstanceBuffer = toCapObj( pVBuffer );
+
+	beginCall( kGfxCapBindInstanceBuffer );
+	putU32( idOf( pVBuffer ) );
+	endCall();
+}
+
+Void CGfxAPI_Capture::plBindProgram( IGfxAPIProgram *pProgram ) {
+	m_inner.plBindProgram( innerOf( pProgram ) );
+
+	m_shadow.pProgram = toCapObj( pProgram );
+
+	beginCall( kGfxCapBindProgram );
+	putU32( idOf( pProgram ) );
+	endCall();
+}
+Void CGfxAPI_Capture::plUnbindProgram() {
+	m_inner.plUnbindProgram();
+
+	m_shadow.pProgram = nullptr;
+
+	beginCall( kGfxCapUnbindProgram );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdUpdateProgramBindings( const SGfxBinding &binding ) {
+	SGfxBinding innerBinding = binding;
+	const Void *pObj = nullptr;
+	switch( binding.type ) {
+	case kGfxBindingSampler:
+		pObj                       = binding.data.sampler;
+		innerBinding.data.sampler = innerOf( binding.data.sampler );
+		break;
+	case kGfxBindingTexture:
+		pObj                       = binding.data.texture;
+		innerBinding.data.texture = innerOf( binding.data.texture );
+		break;
+	case kGfxBindingUniformBuffer:
+		pObj                       = binding.data.ubuffer;
+		innerBinding.data.ubuffer = innerOf( binding.data.ubuffer );
+		break;
+	}
+
+	m_inner.cmdUpdateProgramBindings( innerBinding );
+
+	beginCall( kGfxCapUpdateProgramBindings );
+	putU32( U32( binding.type ) );
+	putU32( binding.location );
+	putU32( idOf( pObj ) );
+	putU32( binding.stageBits );
+	endCall();
+}
+
+Void CGfxAPI_Capture::omBindRenderTarget( IGfxAPIRenderTarget *pTarget ) {
+	m_inner.omBindRenderTarget( innerOf( pTarget ) );
+
+	m_shadow.pRenderTarget = toCapObj( pTarget );
+
+	beginCall( kGfxCapBindRenderTarget );
+	putU32( idOf( pTarget ) );
+	endCall();
+}
+
+Void CGfxAPI_Capture::cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value ) {
+	m_inner.cmdClearRect( posX, posY, resX, resY, value );
+
+	beginCall( kGfxCapClearRect );
+	putRect( posX, posY, resX, resY );
+	putU32( value );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdUpdateTexture( IGfxAPITexture *pTexture, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData ) {
+	m_inner.cmdUpdateTexture( innerOf( pTexture ), posX, posY, resX, resY, pData );
+
+	// Always BGRA
+	const UPtr cBytes = UPtr( resX ) * UPtr( resY ) * 4;
+
+	if( isRecording() ) {
+		beginCall( kGfxCapUpdateTexture );
+		putU32( idOf( pTexture ) );
+		putU16( posX );
+		putU16( posY );
+		putU16( resX );
+		putU16( resY );
+		putBlob( pData, cBytes );
+		endCall();
+		return;
+	}
+
+	if( m_state != kCapStateWaiting || !pTexture || !pData ) {
+		return;
+	}
+
+	// Keep the texture's contents up to date for when recording starts
+	SCaptureObject &obj = *toCapObj( pTexture );
+	if( U32( posX ) + resX > obj.texResX || U32( posY ) + resY > obj.texResY ) {
+		return;
+	}
+	if( obj.data.isEmpty() ) {
+		if( !AX_VERIFY_MEMORY( obj.data.resize( UPtr( obj.texResX ) * UPtr( obj.texResY ) * 4 ) ) ) {
+			return;
+		}
+		memset( obj.data.pointer(), 0, obj.data.num() );
+	}
+
+	for( U32 y = 0; y < resY; ++y ) {
+		U8 *const pDst = obj.data.pointer() + ( UPtr( posY + y ) * obj.texResX + posX ) * 4;
+		memcpy( pDst, pData + UPtr( y ) * resX * 4, UPtr( resX ) * 4 );
+	}
+}
+Void CGfxAPI_Capture::cmdWriteVBuffer( IGfxAPIVBuffer *pVBuffer, UPtr offset, UPtr size, const Void *pData ) {
+	m_inner.cmdWriteVBuffer( innerOf( pVBuffer ), offset, size, pData );
+
+	beginCall( kGfxCapWriteVBuffer );
+	putU32( idOf( pVBuffer ) );
+	putUPtr( offset );
+	putBlob( pData, size );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdWriteIBuffer( IGfxAPIIBuffer *pIBuffer, UPtr offset, UPtr size, const Void *pData ) {
+	m_inner.cmdWriteIBuffer( innerOf( pIBuffer ), offset, size, pData );
+
+	beginCall( kGfxCapWriteIBuffer );
+	putU32( idOf( pIBuffer ) );
+	putUPtr( offset );
+	putBlob( pData, size );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdWriteUBuffer( IGfxAPIUBuffer *pUBuffer, UPtr offset, UPtr size, const Void *pData ) {
+	m_inner.cmdWriteUBuffer( innerOf( pUBuffer ), offset, size, pData );
+
+	beginCall( kGfxCapWriteUBuffer );
+	putU32( idOf( pUBuffer ) );
+	putUPtr( offset );
+	putBlob( pData, size );
+	endCall();
+}
+// Reads are recorded for their cost; their results aren't
+Void CGfxAPI_Capture::cmdReadVBuffer( IGfxAPIVBuffer *pVBuffer, UPtr offset, UPtr size, Void *pData ) {
+	m_inner.cmdReadVBuffer( innerOf( pVBuffer ), offset, size, pData );
+
+	beginCall( kGfxCapReadVBuffer );
+	putU32( idOf( pVBuffer ) );
+	putUPtr( offset );
+	putUPtr( size );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdReadIBuffer( IGfxAPIIBuffer *pIBuffer, UPtr offset, UPtr size, Void *pData ) {
+	m_inner.cmdReadIBuffer( innerOf( pIBuffer ), offset, size, pData );
+
+	beginCall( kGfxCapReadIBuffer );
+	putU32( idOf( pIBuffer ) );
+	putUPtr( offset );
+	putUPtr( size );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdReadUBuffer( IGfxAPIUBuffer *pUBuffer, UPtr offset, UPtr size, Void *pData ) {
+	m_inner.cmdReadUBuffer( innerOf( pUBuffer ), offset, size, pData );
+
+	beginCall( kGfxCapReadUBuffer );
+	putU32( idOf( pUBuffer ) );
+	putUPtr( offset );
+	putUPtr( size );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdResolveRenderTarget( IGfxAPIRenderTarget *pTarget ) {
+	m_inner.cmdResolveRenderTarget( innerOf( pTarget ) );
+
+	beginCall( kGfxCapResolveRenderTarget );
+	putU32( idOf( pTarget ) );
+	endCall();
+}
+
+Void CGfxAPI_Capture::cmdDraw( ETopology topology, U32 cVerts, U32 uOffset ) {
+	m_inner.cmdDraw( topology, cVerts, uOffset );
+
+	beginCall( kGfxCapDraw );
+	putU32( U32( topology ) );
+	putU32( cVerts );
+	putU32( uOffset );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdDrawIndexed( ETopology topology, U32 cIndices, U32 uOffset, U32 uBias ) {
+	m_inner.cmdDrawIndexed( topology, cIndices, uOffset, uBias );
+
+	beginCall( kGfxCapDrawIndexed );
+	putU32( U32( topology ) );
+	putU32( cIndices );
+	putU32( uOffset );
+	putU32( uBias );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdDrawInstanced( ETopology topology, U32 cVerts, U32 uOffset, U32 cInstances ) {
+	m_inner.cmdDrawInstanced( topology, cVerts, uOffset, cInstances );
+
+	beginCall( kGfxCapDrawInstanced );
+	putU32( U32( topology ) );
+	putU32( cVerts );
+	putU32( uOffset );
+	putU32( cInstances );
+	endCall();
+}
+Void CGfxAPI_Capture::cmdDrawIndexedInstanced( ETopology topology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances ) {
+	m_inner.cmdDrawIndexedInstanced( topology, cIndices, uOffset, uBias, cInstances );
+
+	beginCall( kGfxCapDrawIndexedInstanced );
+	putU32( U32( topology ) );
+	putU32( cIndices );
+	putU32( uOffset );
+	putU32( uBias );
+	putU32( cInstances );
+	endCall();
+}
+
+//====================================================================//
+
+DOLL_FUNC IGfxAPI *DOLL_API gfx_captureAPI( IGfxAPI *pAPI, const SGfxCaptureDesc &desc ) {
+	if( !pAPI ) {
+		return nullptr;
+	}
+
+	CGfxAPI_Capture *const pCapture = new CGfxAPI_Capture( *pAPI );
+	if( !AX_VERIFY_MEMORY( pCapture ) ) {
+		return pAPI;
+	}
+
+	if( !pCapture->init( desc ) ) {
+		// The capture doesn't own `pAPI` yet, so this leaves it alone
+		delete pCapture;
+		return pAPI;
+	}
+
+	return pCapture;
+}
+DOLL_FUNC IGfxAPI *DOLL_API gfx_getCapturedAPI( IGfxAPI *pAPI ) {
+	CGfxAPI_Capture *const pCapture = dynamic_cast<CGfxAPI_Capture *>( pAPI );
+	return pCapture != nullptr ? &pCapture->getInner() : pAPI;
+}
+DOLL_FUNC Bool DOLL_API gfx_isCaptureDone( IGfxAPI *pAPI ) {
+	CGfxAPI_Capture *const pCapture = dynamic_cast<CGfxAPI_Capture *>( pAPI );
+	return pCapture != nullptr && pCapture->isDone();
+}
+
+//====================================================================//
+
+// Reads the parameters of one call
+class CCaptureReader {
+public:
+	CCaptureReader( const U8 *p, UPtr cBytes )
+	: m_p( p )
+	, m_pEnd( p + cBytes )
+	, m_bOk( true ) {
+	}
+
+	Bool isOk() const { return m_bOk; }
+	Bool isAtEnd() const { return m_p == m_pEnd; }
+
+	const U8 *getBytes( UPtr cBytes ) {
+		if( !m_bOk || UPtr( m_pEnd - m_p ) < cBytes ) {
+			m_bOk = false;
+			return nullptr;
+		}
+
+		const U8 *const p = m_p;
+		m_p += cBytes;
+		return p;
+	}
+	U8 getU8() {
+		const U8 *const p = getBytes( 1 );
+		return p != nullptr ? p[0] : 0;
+	}
+	U16 getU16() {
+		const U8 *const p = getBytes( 2 );
+		return p != nullptr ? U16( p[0] | ( p[1] << 8 ) ) : 0;
+	}
+	U32 getU32() {
+		const U8 *const p = getBytes( 4 );
+		return p != nullptr ? U32( p[0] ) | ( U32( p[1] ) << 8 ) | ( U32( p[2] ) << 16 ) | ( U32( p[3] ) << 24 ) : 0;
+	}
+	S32 getS32() {
+		return S32( getU32() );
+	}
+	F32 getF32() {
+		const U32 u = getU32();
+		F32 x;
+		memcpy( &x, &u, sizeof( x ) );
+		return x;
+	}
+	// Returns null for an empty blob
+	const U8 *getBlob( UPtr &cBytes ) {
+		cBytes = getU32();
+		return cBytes > 0 ? getBytes( cBytes ) : nullptr;
+	}
+	Void getMatrix( F32 *matrix ) {
+		for( U32 i = 0; i < 16; ++i ) {
+			matrix[i] = getF32();
+		}
+	}
+
+private:
+	const U8 *m_p;
+	const U8 *const m_pEnd;
+	Bool m_bOk;
+};
+
+// Objects made while replaying, by capture ID
+class CReplayObjects {
+public:
+	~CReplayObjects() {
+		AX_ASSERT( m_objects.isEmpty() );
+	}
+
+	Bool set( U32 uId, ECaptureObject type, Void *p ) {
+		if( !uId ) {
+			return false;
+		}
+
+		if( uId >= m_objects.num() ) {
+			const UPtr n = m_objects.num();
+			if( !AX_VERIFY_MEMORY( m_objects.resize( UPtr( uId ) + 1 ) ) || !AX_VERIFY_MEMORY( m_types.resize( UPtr( uId ) + 1 ) ) ) {
+				return false;
+			}
+			for( UPtr i = n; i < m_objects.num(); ++i ) {
+				m_objects[i] = nullptr;
+				m_types[i]   = U8( kNumCapObjs );
+			}
+		}
+
+		m_objects[uId] = p;
+		m_types[uId]   = U8( type );
+		return true;
+	}
+	template<typename T>
+	T *get( U32 uId, ECaptureObject type ) const {
+		if( uId >= m_objects.num() || m_types[uId] != U8( type ) ) {
+			return nullptr;
+		}
+
+		return reinterpret_cast<T *>( m_objects[uId] );
+	}
+	// Forget the object, returning it
+	template<typename T>
+	T *take( U32 uId, ECaptureObject type ) {
+		T *const p = get<T>( uId, type );
+		if( p != nullptr ) {
+			m_objects[uId] = nullptr;
+			m_types[uId]   = U8( kNumCapObjs );
+		}
+
+		return p;
+	}
+
+	// Forget whichever object `p` is, without destroying it
+	Void forget( const Void *p ) {
+		for( UPtr i = 0; i < m_objects.num(); ++i ) {
+			if( m_objects[i] == p ) {
+				m_objects[i] = nullptr;
+				m_types[i]   = U8( kNumCapObjs );
+			}
+		}
+	}
+
+	// Destroy everything still alive (programs before their shaders)
+	Void destroyAll( IGfxAPI &api ) {
+		for( U32 uType = kNumCapObjs; uType-- > 0; ) {
+			for( UPtr i = 0; i < m_objects.num(); ++i ) {
+				if( m_types[i] != U8( uType ) || !m_objects[i] ) {
+					continue;
+				}
+
+				Void *const p = m_objects[i];
+				switch( ECaptureObject( uType ) ) {
+				case kCapObjSampler:
+					api.destroySampler( reinterpret_cast<IGfxAPISampler *>( p ) );
+					break;
+				case kCapObjTexture:
+					api.destroyTexture( reinterpret_cast<IGfxAPITexture *>( p ) );
+					break;
+				case kCapObjLayout:
+					api.destroyLayout( reinterpret_cast<IGfxAPIVLayout *>( p ) );
+					break;
+				case kCapObjVBuffer:
+					api.destroyVBuffer( reinterpret_cast<IGfxAPIVBuffer *>( p ) );
+					break;
+				case kCapObjIBuffer:
+					api.destroyIBuffer( reinterpret_cast<IGfxAPIIBuffer *>( p ) );
+					break;
+				case kCapObjUBuffer:
+					api.destroyUBuffer( reinterpret_cast<IGfxAPIUBuffer *>( p ) );
+					break;
+				case kCapObjShader:
+					api.destroyShader( reinterpret_cast<IGfxAPIShader *>( p ) );
+					break;
+				case kCapObjProgram:
+					api.destroyProgram( reinterpret_cast<IGfxAPIProgram *>( p ) );
+					break;
+				case kCapObjRenderTarget: {
+					// The target's texture goes with it
+					IGfxAPIRenderTarget *const pTarget = reinterpret_cast<IGfxAPIRenderTarget *>( p );
+					forget( api.getRenderTargetTexture( pTarget ) );
+					api.destroyRenderTarget( pTarget );
+					break;
+				}
+				case kNumCapObjs:
+					break;
+				}
+			}
+		}
+
+		m_objects.purge();
+		m_types.purge();
+	}
+
+private:
+	TMutArr<Void *> m_objects;
+	TMutArr<U8> m_types;
+};
+
+// Make one recorded call; returns false if its parameters are bad
+static Bool replayCall( IGfxAPI &api, CGfxFrame &frame, CReplayObjects &objs, EGfxCaptureCall call, CCaptureReader &r, TMutArr<U8> &scratch ) {
+	switch( call ) {
+	case kGfxCapEnd:
+		return true;
+
+	case kGfxCapCreateSampler: {
+		const U32 uId = r.getU32();
+
+		SGfxSamplerDesc d;
+		d.magFilter        = ETextureFilter( r.getU32() );
+		d.minFilter        = ETextureFilter( r.getU32() );
+		d.mipmapMode       = EMipmapMode( r.getU32() );
+		d.wrapU            = ETextureWrap( r.getU32() );
+		d.wrapV            = ETextureWrap( r.getU32() );
+		d.wrapW            = ETextureWrap( r.getU32() );
+		d.mipLodBias       = r.getF32();
+		d.minLod           = r.getF32();
+		d.maxLod           = r.getF32();
+		d.anisotropyEnable = r.getU8() != 0;
+		d.maxAnisotropy    = r.getF32();
+		d.compareEnable    = r.getU8() != 0;
+		d.compareOp        = EGfxCompareOp( r.getU32() );
+		d.borderColor      = ETextureBorder( r.getU32() );
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		return objs.set( uId, kCapObjSampler, api.createSampler( d ) );
+	}
+	case kGfxCapCreateTexture: {
+		const U32 uId = r.getU32();
+		const ETextureFormat fmt = ETextureFormat( r.getU32() );
+		const U16 resX = r.getU16();
+		const U16 resY = r.getU16();
+		UPtr cBytes;
+		const U8 *const pData = r.getBlob( cBytes );
+		if( !r.isOk() || ( pData != nullptr && cBytes < UPtr( resX ) * UPtr( resY ) * ( fmt == kTexFmtRGB8 ? 3 : 4 ) ) ) {
+			return false;
+		}
+
+		return objs.set( uId, kCapObjTexture, api.createTexture( fmt, resX, resY, pData ) );
+	}
+	case kGfxCapCreateLayout: {
+		const U32 uId = r.getU32();
+
+		SGfxLayout desc;
+		desc.stride         = r.getU32();
+		desc.instanceStride = r.getU32();
+		desc.cElements      = r.getU32();
+		desc.pAPIObj        = nullptr;
+		if( desc.cElements > kMaxLayoutElements ) {
+			return false;
+		}
+		for( UPtr i = 0; i < desc.cElements; ++i ) {
+			SGfxLayoutElement &e = desc.elements[i];
+			e.type    = EGfxLayoutElement( r.getU32() );
+			e.cComps  = EVectorSize( r.getU32() );
+			e.compTy  = EVectorType( r.getU32() );
+			e.uOffset   = r.getU32();
+			e.cBytes    = r.getU32();
+			e.uStepRate = r.getU32();
+		}
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		return objs.set( uId, kCapObjLayout, api.createLayout( desc ) );
+	}
+	case kGfxCapCreateVBuffer:
+	case kGfxCapCreateIBuffer:
+	case kGfxCapCreateUBuffer: {
+		const U32 uId = r.getU32();
+		const UPtr cBytes = r.getU32();
+		const EBufferPerformance perf = EBufferPerformance( r.getU32() );
+		const EBufferPurpose purpose = EBufferPurpose( r.getU32() );
+		UPtr cDataBytes;
+		const U8 *const pData = r.getBlob( cDataBytes );
+		if( !r.isOk() || ( pData != nullptr && cDataBytes != cBytes ) ) {
+			return false;
+		}
+
+		if( call == kGfxCapCreateVBuffer ) {
+			return objs.set( uId, kCapObjVBuffer, api.createVBuffer( cBytes, pData, perf, purpose ) );
+		}
+		if( call == kGfxCapCreateIBuffer ) {
+			return objs.set( uId, kCapObjIBuffer, api.createIBuffer( cBytes, pData, perf, purpose ) );
+		}
+		return objs.set( uId, kCapObjUBuffer, api.createUBuffer( cBytes, pData, perf, purpose ) );
+	}
+	case kGfxCapCreateShader: {
+		const U32 uId = r.getU32();
+		UPtr cNameBytes;
+		const U8 *const pName = r.getBlob( cNameBytes );
+		const EShaderFormat fmt = EShaderFormat( r.getU32() );
+		const EShaderStage stage = EShaderStage( r.getU32() );
+		UPtr cBytes;
+		const U8 *const pData = r.getBlob( cBytes );
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		const Str filename( reinterpret_cast<const char *>( pName ), reinterpret_cast<const char *>( pName ) + cNameBytes );
+		IGfxAPIShader *const pShader = api.createShader( filename, fmt, stage, cBytes, pData, nullptr );
+		if( !pShader ) {
+			// Programs using it won't be made either, but the rest can go on
+			g_WarningLog( filename ) += "Replayed shader failed to compile.";
+			return true;
+		}
+
+		return objs.set( uId, kCapObjShader, pShader );
+	}
+	case kGfxCapCreateProgram: {
+		const U32 uId = r.getU32();
+		const U32 cShaders = r.getU32();
+
+		TMutArr<IGfxAPIShader *> shaders;
+		if( !r.isOk() || cShaders > 16 || !AX_VERIFY_MEMORY( shaders.resize( cShaders ) ) ) {
+			return false;
+		}
+		for( IGfxAPIShader *&pShader : shaders ) {
+			pShader = objs.get<IGfxAPIShader>( r.getU32(), kCapObjShader );
+			if( !pShader ) {
+				return r.isOk();
+			}
+		}
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		IGfxAPIProgram *const pProgram = api.createProgram( shaders, nullptr );
+		return !pProgram || objs.set( uId, kCapObjProgram, pProgram );
+	}
+	case kGfxCapCreateRenderTarget: {
+		const U32 uId    = r.getU32();
+		const U32 uTexId = r.getU32();
+		const U16 resX   = r.getU16();
+		const U16 resY   = r.getU16();
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		// Not every API has render targets; calls using this one are skipped
+		IGfxAPIRenderTarget *const pTarget = api.createRenderTarget( resX, resY );
+		return !pTarget || ( objs.set( uId, kCapObjRenderTarget, pTarget ) && objs.set( uTexId, kCapObjTexture, api.getRenderTargetTexture( pTarget ) ) );
+	}
+
+	case kGfxCapDestroySampler:
+		api.destroySampler( objs.take<IGfxAPISampler>( r.getU32(), kCapObjSampler ) );
+		return r.isOk();
+	case kGfxCapDestroyTexture:
+		api.destroyTexture( objs.take<IGfxAPITexture>( r.getU32(), kCapObjTexture ) );
+		return r.isOk();
+	case kGfxCapDestroyLayout:
+		api.destroyLayout( objs.take<IGfxAPIVLayout>( r.getU32(), kCapObjLayout ) );
+		return r.isOk();
+	case kGfxCapDestroyVBuffer:
+		api.destroyVBuffer( objs.take<IGfxAPIVBuffer>( r.getU32(), kCapObjVBuffer ) );
+		return r.isOk();
+	case kGfxCapDestroyIBuffer:
+		api.destroyIBuffer( objs.take<IGfxAPIIBuffer>( r.getU32(), kCapObjIBuffer ) );
+		return r.isOk();
+	case kGfxCapDestroyUBuffer:
+		api.destroyUBuffer( objs.take<IGfxAPIUBuffer>( r.getU32(), kCapObjUBuffer ) );
+		return r.isOk();
+	case kGfxCapDestroyShader:
+		api.destroyShader( objs.take<IGfxAPIShader>( r.getU32(), kCapObjShader ) );
+		return r.isOk();
+	case kGfxCapDestroyProgram:
+		api.destroyProgram( objs.take<IGfxAPIProgram>( r.getU32(), kCapObjProgram ) );
+		return r.isOk();
+	case kGfxCapDestroyRenderTarget: {
+		IGfxAPIRenderTarget *const pTarget = objs.take<IGfxAPIRenderTarget>( r.getU32(), kCapObjRenderTarget );
+		if( pTarget != nullptr ) {
+			objs.forget( api.getRenderTargetTexture( pTarget ) );
+			api.destroyRenderTarget( pTarget );
+		}
+		return r.isOk();
+	}
+
+	case kGfxCapSetDefaultState: {
+		Mat4f proj;
+		r.getMatrix( proj.ptr() );
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		api.setDefaultState( proj );
+		return true;
+	}
+	case kGfxCapResize: {
+		const U32 uResX = r.getU32();
+		const U32 uResY = r.getU32();
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		// Through the frame, so gfx_r_resX() and gfx_r_resY() match
+		frame.resize( uResX, uResY );
+		return true;
+	}
+	case kGfxCapPresent:
+		api.wsiPresent();
+		return true;
+
+	case kGfxCapSetProjection:
+	case kGfxCapSetModelView: {
+		F32 matrix[16];
+		r.getMatrix( matrix );
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		if( call == kGfxCapSetProjection ) {
+			api.vsSetProjectionMatrix( matrix );
+		} else {
+			api.vsSetModelViewMatrix( matrix );
+		}
+		return true;
+	}
+	case kGfxCapSetScissorEnable: {
+		const Bool enable = r.getU8() != 0;
+		if( r.isOk() ) {
+			api.psoSetScissorEnable( enable );
+		}
+		return r.isOk();
+	}
+	case kGfxCapSetTextureEnable: {
+		const Bool enable = r.getU8() != 0;
+		if( r.isOk() ) {
+			api.psoSetTextureEnable( enable );
+		}
+		return r.isOk();
+	}
+	case kGfxCapSetBlend: {
+		const EBlendOp op = EBlendOp( r.getU32() );
+		const EBlendFactor colA = EBlendFactor( r.getU32() );
+		const EBlendFactor colB = EBlendFactor( r.getU32() );
+		const EBlendFactor alphaA = EBlendFactor( r.getU32() );
+		const EBlendFactor alphaB = EBlendFactor( r.getU32() );
+		if( r.isOk() ) {
+			api.psoSetBlend( op, colA, colB, alphaA, alphaB );
+		}
+		return r.isOk();
+	}
+	case kGfxCapSetScissor:
+	case kGfxCapSetViewport: {
+		const S32 posX = r.getS32();
+		const S32 posY = r.getS32();
+		const U32 resX = r.getU32();
+		const U32 resY = r.getU32();
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		if( call == kGfxCapSetScissor ) {
+			api.rsSetScissor( posX, posY, resX, resY );
+		} else {
+			api.rsSetViewport( posX, posY, resX, resY );
+		}
+		return true;
+	}
+
+	case kGfxCapSetLayout:
+		api.iaSetLayout( objs.get<IGfxAPIVLayout>( r.getU32(), kCapObjLayout ) );
+		return r.isOk();
+	case kGfxCapBindTexture: {
+		IGfxAPITexture *const pTexture = objs.get<IGfxAPITexture>( r.getU32(), kCapObjTexture );
+		const U32 uStage = r.getU32();
+		if( r.isOk() ) {
+			api.tsBindTexture( pTexture, uStage );
+		}
+		return r.isOk();
+	}
+	case kGfxCapBindSampler: {
+		IGfxAPISampler *const pSampler = objs.get<IGfxAPISampler>( r.getU32(), kCapObjSampler );
+		const U32 uStage = r.getU32();
+		if( r.isOk() ) {
+			api.tsBindSampler( pSampler, uStage );
+		}
+		return r.isOk();
+	}
+	case kGfxCapBindVBuffer: {
+		IGfxAPIVBuffer *const pVBuffer = objs.get<IGfxAPIVBuffer>( r.getU32(), kCapObjVBuffer );
+		if( r.isOk() && pVBuffer != nullptr ) {
+			api.iaBindVBuffer( pVBuffer );
+		}
+		return r.isOk();
+	}
+	case kGfxCapBindIBuffer: {
+		IGfxAPIIBuffer *const pIBuffer = objs.get<IGfxAPIIBuffer>( r.getU32(), kCapObjIBuffer );
+		const EIndexFormat fmt = EIndexFormat( r.getU32() );
+		if( r.isOk() && pIBuffer != nullptr ) {
+			api.iaBindIBuffer( pIBuffer, fmt );
+		}
+		return r.isOk();
+	}
+	case kGfxCapBindInstanceBuffer: {
+		IGfxAPIVBuffer *const pVBuffer = objs.get<IGfxAPIVBuffer>( r.getU32(), kCapObjVBuffer );
+		if( r.isOk() ) {
+			api.iaBindInstanceBuffer( pVBuffer );
+		}
+		return r.isOk();
+	}
+	case kGfxCapBindProgram: {
+		IGfxAPIProgram *const pProgram = objs.get<IGfxAPIProgram>( r.getU32(), kCapObjProgram );
+		if( r.isOk() && pProgram != nullptr ) {
+			api.plBindProgram( pProgram );
+		}
+		return r.isOk();
+	}
+	case kGfxCapUnbindProgram:
+		api.plUnbindProgram();
+		return true;
+	case kGfxCapUpdateProgramBindings: {
+		SGfxBinding binding;
+		binding.type      = EGfxBindingType( r.getU32() );
+		binding.location  = r.getU32();
+		const U32 uId     = r.getU32();
+		binding.stageBits = r.getU32();
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		switch( binding.type ) {
+		case kGfxBindingSampler:
+			binding.data.sampler = objs.get<IGfxAPISampler>( uId, kCapObjSampler );
+			break;
+		case kGfxBindingTexture:
+			binding.data.texture = objs.get<IGfxAPITexture>( uId, kCapObjTexture );
+			break;
+		case kGfxBindingUniformBuffer:
+			binding.data.ubuffer = objs.get<IGfxAPIUBuffer>( uId, kCapObjUBuffer );
+			break;
+		default:
+			return false;
+		}
+
+		api.cmdUpdateProgramBindings( binding );
+		return true;
+	}
+	case kGfxCapBindRenderTarget: {
+		const U32 uId = r.getU32();
+		IGfxAPIRenderTarget *const pTarget = objs.get<IGfxAPIRenderTarget>( uId, kCapObjRenderTarget );
+		// 0 is the window
+		if( r.isOk() && ( !uId || pTarget != nullptr ) ) {
+			api.omBindRenderTarget( pTarget );
+		}
+		return r.isOk();
+	}
+
+	case kGfxCapClearRect: {
+		const S32 posX = r.getS32();
+		const S32 posY = r.getS32();
+		const U32 resX = r.getU32();
+		const U32 resY = r.getU32();
+		const U32 value = r.getU32();
+		if( r.isOk() ) {
+			api.cmdClearRect( posX, posY, resX, resY, value );
+		}
+		return r.isOk();
+	}
+	case kGfxCapUpdateTexture: {
+		IGfxAPITexture *const pTexture = objs.get<IGfxAPITexture>( r.getU32(), kCapObjTexture );
+		const U16 posX = r.getU16();
+		const U16 posY = r.getU16();
+		const U16 resX = r.getU16();
+		const U16 resY = r.getU16();
+		UPtr cBytes;
+		const U8 *const pData = r.getBlob( cBytes );
+		if( !r.isOk() || !pData || cBytes != UPtr( resX ) * UPtr( resY ) * 4 ) {
+			return false;
+		}
+
+		if( pTexture != nullptr ) {
+			api.cmdUpdateTexture( pTexture, posX, posY, resX, resY, pData );
+		}
+		return true;
+	}
+	case kGfxCapWriteVBuffer:
+	case kGfxCapWriteIBuffer:
+	case kGfxCapWriteUBuffer: {
+		const U32 uId = r.getU32();
+		const UPtr offset = r.getU32();
+		UPtr cBytes;
+		const U8 *const pData = r.getBlob( cBytes );
+		if( !r.isOk() ) {
+			return false;
+		}
+
+		if( call == kGfxCapWriteVBuffer ) {
+			IGfxAPIVBuffer *const p = objs.get<IGfxAPIVBuffer>( uId, kCapObjVBuffer );
+			if( p != nullptr ) {
+				api.cmdWriteVBuffer( p, offset, cBytes, pData );
+			}
+		} else if( call == kGfxCapWriteIBuffer ) {
+			IGfxAPIIBuffer *const p = objs.get<IGfxAPIIBuffer>( uId, kCapObjIBuffer );
+			if( p != nullptr ) {
+				api.cmdWriteIBuffer( p, offset, cBytes, pData );
+			}
+		} else {
+			IGfxAPIUBuffer *const p = objs.get<IGfxAPIUBuffer>( uId, kCapObjUBuffer );
+			if( p != nullptr ) {
+				api.cmdWriteUBuffer( p, offset, cBytes, pData );
+			}
+		}
+		return true;
+	}
+	case kGfxCapReadVBuffer:
+	case kGfxCapReadIBuffer:
+	case kGfxCapReadUBuffer: {
+		const U32 uId = r.getU32();
+		const UPtr offset = r.getU32();
+		const UPtr cBytes = r.getU32();
+		if( !r.isOk() ) {
+			return false;
+		}
+		if( scratch.num() < cBytes && !AX_VERIFY_MEMORY( scratch.resize( cBytes ) ) ) {
+			return false;
+		}
+
+		if( call == kGfxCapReadVBuffer ) {
+			IGfxAPIVBuffer *const p = objs.get<IGfxAPIVBuffer>( uId, kCapObjVBuffer );
+			if( p != nullptr ) {
+				api.cmdReadVBuffer( p, offset, cBytes, scratch.pointer() );
+			}
+		} else if( call == kGfxCapReadIBuffer ) {
+			IGfxAPIIBuffer *const p = objs.get<IGfxAPIIBuffer>( uId, kCapObjIBuffer );
+			if( p != nullptr ) {
+				api.cmdReadIBuffer( p, offset, cBytes, scratch.pointer() );
+			}
+		} else {
+			IGfxAPIUBuffer *const p = objs.get<IGfxAPIUBuffer>( uId, kCapObjUBuffer );
+			if( p != nullptr ) {
+				api.cmdReadUBuffer( p, offset, cBytes, scratch.pointer() );
+			}
+		}
+		return true;
+	}
+	case kGfxCapResolveRenderTarget: {
+		IGfxAPIRenderTarget *const pTarget = objs.get<IGfxAPIRenderTarget>( r.getU32(), kCapObjRenderTarget );
+		if( r.isOk() && pTarget != nullptr ) {
+			api.cmdResolveRenderTarget( pTarget );
+		}
+		return r.isOk();
+	}
+
+	case kGfxCapDraw: {
+		const ETopology topology = ETopology( r.getU32() );
+		const U32 cVerts = r.getU32();
+		const U32 uOffset = r.getU32();
+		if( r.isOk() ) {
+			api.cmdDraw( topology, cVerts, uOffset );
+		}
+		return r.isOk();
+	}
+	case kGfxCapDrawIndexed: {
+		const ETopology topology = ETopology( r.getU32() );
+		const U32 cIndices = r.getU32();
+		const U32 uOffset = r.getU32();
+		const U32 uBias = r.getU32();
+		if( r.isOk() ) {
+			api.cmdDrawIndexed( topology, cIndices, uOffset, uBias );
+		}
+		return r.isOk();
+	}
+	case kGfxCapDrawInstanced: {
+		const ETopology topology = ETopology( r.getU32() );
+		const U32 cVerts = r.getU32();
+		const U32 uOffset = r.getU32();
+		const U32 cInstances = r.getU32();
+		if( r.isOk() ) {
+			api.cmdDrawInstanced( topology, cVerts, uOffset, cInstances );
+		}
+		return r.isOk();
+	}
+	case kGfxCapDrawIndexedInstanced: {
+		const ETopology topology = ETopology( r.getU32() );
+		const U32 cIndices = r.getU32();
+		const U32 uOffset = r.getU32();
+		const U32 uBias = r.getU32();
+		const U32 cInstances = r.getU32();
+		if( r.isOk() ) {
+			api.cmdDrawIndexedInstanced( topology, cIndices, uOffset, uBias, cInstances );
+		}
+		return r.isOk();
+	}
+
+	case kNumGfxCaptureCalls:
+		break;
+	}
+
+	return false;
+}
+
+DOLL_FUNC Bool DOLL_API gfx_replayCapture( IGfxAPI &api, Str filename, SGfxReplayStats *pOutStats, FnGfxReplayCall pfnCall, Void *pParm ) {
+	SGfxReplayStats stats;
+	memset( &stats, 0, sizeof( stats ) );
+	if( pOutStats != nullptr ) {
+		*pOutStats = stats;
+	}
+
+	U8 *pFile = nullptr;
+	UPtr cFileBytes = 0;
+	if( !core_loadFile( filename, pFile, cFileBytes ) ) {
+		g_ErrorLog( filename ) += "Cannot load capture.";
+		return false;
+	}
+
+	CCaptureReader file( pFile, cFileBytes );
+	const U32 uMagic = file.getU32();
+	const U16 uVersion = file.getU16();
+	( (Void)file.getU16() );
+	const U32 uResX = file.getU32();
+	const U32 uResY = file.getU32();
+	if( !file.isOk() || uMagic != kCaptureMagic || uVersion != kCaptureVersion ) {
+		g_ErrorLog( filename ) += "Not a capture, or from an unsupported version.";
+		core_freeFile( pFile );
+		return false;
+	}
+
+	// Backends may look at the current frame (e.g., for the resolution)
+	CGfxFrame *const pPrevFrame = gfx_r_getFrame();
+	CGfxFrame *const pFrame = new CGfxFrame( api );
+	if( !AX_VERIFY_MEMORY( pFrame ) ) {
+		core_freeFile( pFile );
+		return false;
+	}
+
+	gfx_r_setFrame( pFrame );
+	pFrame->resize( uResX, uResY );
+
+	CReplayObjects objs;
+	TMutArr<U8> scratch;
+	U64 uFrameMicrosecs = 0;
+	Bool bOk = true;
+
+	for(;;) {
+		const U8 call = file.getU8();
+		const U32 cBytes = file.getU32();
+		const U8 *const pParms = file.getBytes( cBytes );
+		if( !file.isOk() || call >= U8( kNumGfxCaptureCalls ) ) {
+			g_ErrorLog( filename ) += "Capture is truncated or damaged.";
+			bOk = false;
+			break;
+		}
+
+		if( call == U8( kGfxCapEnd ) ) {
+			break;
+		}
+
+		CCaptureReader parms( pParms, cBytes );
+
+		const U64 uStart = microseconds();
+		const Bool bCallOk = replayCall( api, *pFrame, objs, EGfxCaptureCall( call ), parms, scratch );
+		const U64 uElapsed = microseconds() - uStart;
+
+		if( !bCallOk ) {
+			g_ErrorLog( filename ) += axf( "Bad parameters for %s call.", gfx_getCaptureCallName( EGfxCaptureCall( call ) ) );
+			bOk = false;
+			break;
+		}
+
+		SGfxReplayCallStats &callStats = stats.calls[call];
+		++callStats.cCalls;
+		callStats.uMicrosecs += uElapsed;
+		if( callStats.uMaxMicrosecs < uElapsed ) {
+			callStats.uMaxMicrosecs = uElapsed;
+		}
+
+		++stats.cCalls;
+		stats.uMicrosecs += uElapsed;
+		uFrameMicrosecs += uElapsed;
+
+		if( pfnCall != nullptr ) {
+			pfnCall( pParm, EGfxCaptureCall( call ), stats.cFrames, uElapsed );
+		}
+
+		if( call == U8( kGfxCapPresent ) ) {
+			if( stats.uMaxFrameMicrosecs < uFrameMicrosecs ) {
+				stats.uMaxFrameMicrosecs = uFrameMicrosecs;
+				stats.uMaxFrame          = stats.cFrames;
+			}
+
+			++stats.cFrames;
+			uFrameMicrosecs = 0;
+		}
+	}
+
+	objs.destroyAll( api );
+	core_freeFile( pFile );
+
+	gfx_r_setFrame( pPrevFrame );
+	delete pFrame;
+
+	DOLL_DEBUG_LOG += axf( "Replayed %u frame(s), %u call(s) in %llu us", stats.cFrames, stats.cCalls, ( unsigned long long )stats.uMicrosecs );
+
+	if( pOutStats != nullptr ) {
+		*pOutStats = stats;
+	}
+
+	return bOk;
+}
+
+DOLL_FUNC const char *DOLL_API gfx_getCaptureCallName( EGfxCaptureCall call ) {
+	switch( call ) {
+#define CALL_(Name_) \
+	case kGfxCap##Name_: \
+		return #Name_;
+
+	CALL_( End )
+
+	CALL_( CreateSampler )
+	CALL_( CreateTexture )
+	CALL_( CreateLayout )
+	CALL_( CreateVBuffer )
+	CALL_( CreateIBuffer )
+	CALL_( CreateUBuffer )
+	CALL_( CreateShader )
+	CALL_( CreateProgram )
+	CALL_( CreateRenderTarget )
+
+	CALL_( DestroySampler )
+	CALL_( DestroyTexture )
+	CALL_( DestroyLayout )
+	CALL_( DestroyVBuffer )
+	CALL_( DestroyIBuffer )
+	CALL_( DestroyUBuffer )
+	CALL_( DestroyShader )
+	CALL_( DestroyProgram )
+	CALL_( DestroyRenderTarget )
+
+	CALL_( SetDefaultState )
+	CALL_( Resize )
+	CALL_( Present )
+
+	CALL_( SetProjection )
+	CALL_( SetModelView )
+	CALL_( SetScissorEnable )
+	CALL_( SetTextureEnable )
+	CALL_( SetBlend )
+	CALL_( SetScissor )
+	CALL_( SetViewport )
+
+	CALL_( SetLayout )
+	CALL_( BindTexture )
+	CALL_( BindSampler )
+	CALL_( BindVBuffer )
+	CALL_( BindIBuffer )
+	CALL_( BindInstanceBuffer )
+	CALL_( BindProgram )
+	CALL_( UnbindProgram )
+	CALL_( UpdateProgramBindings )
+	CALL_( BindRenderTarget )
+
+	CALL_( ClearRect )
+	CALL_( UpdateTexture )
+	CALL_( WriteVBuffer )
+	CALL_( WriteIBuffer )
+	CALL_( WriteUBuffer )
+	CALL_( ReadVBuffer )
+	CALL_( ReadIBuffer )
+	CALL_( ReadUBuffer )
+	CALL_( ResolveRenderTarget )
+
+	CALL_( Draw )
+	CALL_( DrawIndexed )
+	CALL_( DrawInstanced )
+	CALL_( DrawIndexedInstanced )
+
+#undef CALL_
+
+	case kNumGfxCaptureCalls:
+		break;
+	}
+
+	return "(unknown)";
+}
+
+} // namespace doll
@@ -125,6 +125,21 @@ Void CGfxAPI_D3D11::destroyTexture( IGfxAPITexture *pTex ) {
 	( (Void)pTex );
 }
 
+IGfxAPIRenderTarget *CGfxAPI_D3D11::createRenderTarget( U16 resX, U16 resY ) {
+	( (Void)resX );
+	( (Void)resY );
+
+	return nullptr;
+}
+Void CGfxAPI_D3D11::destroyRenderTarget( IGfxAPIRenderTarget *pTarget ) {
+	( (Void)pTarget );
+}
+IGfxAPITexture *CGfxAPI_D3D11::getRenderTargetTexture( IGfxAPIRenderTarget *pTarget ) {
+	( (Void)pTarget );
+
+	return nullptr;
+}
+
 IGfxAPIVLayout *CGfxAPI_D3D11::createLayout( const SGfxLayout &desc ) {
 	( (Void)desc );
 	return nullptr;
@@ -249,8 +264,12 @@ Void CGfxAPI_D3D11::tsBindSampler( IGfxAPISampler *pSampler, U32 uStage ) {
 Void CGfxAPI_D3D11::iaBindVBuffer( IGfxAPIVBuffer *pVBuf ) {
 	( (Void)pVBuf );
 }
-Void CGfxAPI_D3D11::iaBindIBuffer( IGfxAPIIBuffer *pIBuf ) {
+Void CGfxAPI_D3D11::iaBindIBuffer( IGfxAPIIBuffer *pIBuf, EIndexFormat fmt ) {
 	( (Void)pIBuf );
+	( (Void)fmt );
+}
+Void CGfxAPI_D3D11::iaBindInstanceBuffer( IGfxAPIVBuffer *pVBuf ) {
+	( (Void)pVBuf );
 }
 
 Void CGfxAPI_D3D11::plBindProgram( IGfxAPIProgram *pProgram ) {
@@ -262,6 +281,10 @@ Void CGfxAPI_D3D11::cmdUpdateProgramBindings( const SGfxBinding &binding ) {
 	( (Void)binding );
 }
 
+Void CGfxAPI_D3D11::omBindRenderTarget( IGfxAPIRenderTarget *pTarget ) {
+	( (Void)pTarget );
+}
+
 Void CGfxAPI_D3D11::cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value ) {
 	( (Void)posX );
 	( (Void)posY );
@@ -313,6 +336,9 @@ Void CGfxAPI_D3D11::cmdReadUBuffer( IGfxAPIUBuffer *pUBuf, UPtr offset, UPtr siz
 	( (Void)size );
 	( (Void)pData );
 }
+Void CGfxAPI_D3D11::cmdResolveRenderTarget( IGfxAPIRenderTarget *pTarget ) {
+	( (Void)pTarget );
+}
 
 Void CGfxAPI_D3D11::cmdDraw( ETopology topology, U32 cVerts, U32 uOffset ) {
 	( (Void)topology );
@@ -325,6 +351,19 @@ Void CGfxAPI_D3D11::cmdDrawIndexed( ETopology topology, U32 cIndices, U32 uOffse
 	( (Void)uOffset );
 	( (Void)uBias );
 }
+Void CGfxAPI_D3D11::cmdDrawInstanced( ETopology topology, U32 cVerts, U32 uOffset, U32 cInstances ) {
+	( (Void)topology );
+	( (Void)cVerts );
+	( (Void)uOffset );
+	( (Void)cInstances );
+}
+Void CGfxAPI_D3D11::cmdDrawIndexedInstanced( ETopology topology, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances ) {
+	( (Void)topology );
+	( (Void)cIndices );
+	( (Void)uOffset );
+	( (Void)uBias );
+	( (Void)cInstances );
+}
 
 DOLL_FUNC CGfxAPI_D3D11 *DOLL_API gfx__api_init_d3d11( OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider ) {
 	( (Void)wnd );
@@ -10,11 +10,15 @@
 
 #	include "doll/Core/Logger.hpp"
 #	include "doll/IO/File.hpp"
+#	include "doll/Math/HalfFloat.hpp"
 #	include "doll/Math/Matrix.hpp"
 #	include "doll/OS/OpenGL.hpp"
 
 #	include <GL/glew.h>
 
+#	include <stdarg.h>
+#	include <stdio.h>
+
 #	if DOLL__USE_GLFW
 #		include "doll/Core/Engine.hpp"
 #		include <GLFW/glfw3.h>
@@ -58,6 +62,35 @@ struct GLProgram {
 	} bindPoints;
 };
 
+// Offscreen color buffer (see createRenderTarget())
+struct SGLRenderTarget {
+	U16 resX;
+	U16 resY;
+	// Framebuffer drawn into, and its color buffer
+	GLuint fbo;
+	GLuint colorRB;
+	// Framebuffer around `tex`; resolving blits into it upside down, so the
+	// texture's first row is the top of the target like any other texture
+	GLuint resolveFBO;
+	GLuint tex;
+};
+
+// Vertex layout (see createLayout()); a copy of the description, which needn't
+// outlive it
+struct SGLLayout {
+	UPtr stride;
+	UPtr instanceStride;
+	UPtr cElements;
+	SGfxLayoutElement elements[kMaxLayoutElements];
+
+	// Program reading the elements from generic attributes, for layouts the
+	// fixed-function arrays can't take (0 for the others)
+	GLuint program;
+	// Generic attribute of each element; the position always takes 0, which
+	// compatibility contexts need enabled to draw anything
+	GLuint attribs[kMaxLayoutElements];
+};
+
 class CGfxAPIProvider_GL : public IGfxAPIProvider {
 public:
 	virtual Void drop() override {
@@ -126,22 +159,26 @@ static GLuint getGLBufUint( GLenum target, GLenum pname ) {
 	return x;
 }
 
-static S32 fixYPos( S32 y ) {
-	return S32( gfx_r_resY() ) - y;
+S32 CGfxAPI_GL::fixYPos( S32 y ) const {
+	// GL's origin is the bottom left of whatever is being drawn into
+	return S32( m_pTarget != nullptr ? U32( m_pTarget->resY ) : gfx_r_resY() ) - y;
 }
 
 static GLenum compTyToGLTy( EVectorType compTy ) {
 	switch( compTy ) {
 	case kVectorTypeS8:
-		break;
+		return GL_BYTE;
 	case kVectorTypeS16:
-		break;
+		return GL_SHORT;
 	case kVectorTypeS32:
-		break;
+		return GL_INT;
 	case kVectorTypeU8:
 		return GL_UNSIGNED_BYTE;
 	case kVectorTypeU16:
+	case kVectorTypeU16_UNorm:
 		return GL_UNSIGNED_SHORT;
+	case kVectorTypeF16:
+		return GL_HALF_FLOAT;
 	case kVectorTypeU32:
 		return GL_UNSIGNED_INT;
 	case kVectorTypeF32:
@@ -222,6 +259,15 @@ CGfxAPI_GL::CGfxAPI_GL( IGfxAPIProvider &provider, SGLContext *pCtx )
 #	else
 , m_pCtx( pCtx )
 #	endif
+, m_pCurrLayout( nullptr )
+, m_layoutVBuf( ~0U )
+, m_instanceVBuf( 0 )
+, m_cAttribArrays( 0 )
+, m_indexType( GL_UNSIGNED_SHORT )
+, m_pTarget( nullptr )
+, m_shaderCache()
+, m_bProgramBinaries( false )
+, m_uDriverKey( 0 )
 {
 #	if DOLL__USE_GLFW
 	( (void)pCtx );
@@ -540,16 +586,178 @@ Void CGfxAPI_GL::destroyTexture( IGfxAPITexture *tex ) {
 	glDeleteTextures( 1, &texh );
 }
 
+IGfxAPIRenderTarget *CGfxAPI_GL::createRenderTarget( U16 resX, U16 resY ) {
+	AX_ASSERT( resX > 0 );
+	AX_ASSERT( resY > 0 );
+
+	// Framebuffer objects and blits are core in 3.0
+	if( !GLEW_VERSION_3_0 && !GLEW_ARB_framebuffer_object ) {
+		DOLL_WARNING_LOG += "Render targets need GL 3.0 or ARB_framebuffer_object";
+		return nullptr;
+	}
+
+	SGLRenderTarget *const pTarget = new SGLRenderTarget();
+	if( !AX_VERIFY_MEMORY( pTarget ) ) {
+		return nullptr;
+	}
+
+	pTarget->resX       = resX;
+	pTarget->resY       = resY;
+	pTarget->fbo        = 0;
+	pTarget->colorRB    = 0;
+	pTarget->resolveFBO = 0;
+	pTarget->tex        = pointerToObject( createTexture( kTexFmtRGBA8, resX, resY, nullptr ) );
+	if( !pTarget->tex ) {
+		delete pTarget;
+		return nullptr;
+	}
+
+	glGenRenderbuffers( 1, &pTarget->colorRB );
+	glBindRenderbuffer( GL_RENDERBUFFER, pTarget->colorRB );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, resX, resY );
+	glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+	CHECKGL();
+
+	glGenFramebuffers( 1, &pTarget->fbo );
+	glGenFramebuffers( 1, &pTarget->resolveFBO );
+
+	glBindFramebuffer( GL_FRAMEBUFFER, pTarget->fbo );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, pTarget->colorRB );
+	Bool bComplete = glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+
+	glBindFramebuffer( GL_FRAMEBUFFER, pTarget->resolveFBO );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pTarget->tex, 0 );
+	bComplete = bComplete && glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+
+	glBindFramebuffer( GL_FRAMEBUFFER, m_pTarget != nullptr ? m_pTarget->fbo : 0 );
+	CHECKGL();
+
+	if( !bComplete ) {
+		DOLL_ERROR_LOG += axf( "Failed to make a %ux%u render target", U32( resX ), U32( resY ) );
+		destroyRenderTarget( reinterpret_cast<IGfxAPIRenderTarget *>( pTarget ) );
+		return nullptr;
+	}
+
+	return reinterpret_cast<IGfxAPIRenderTarget *>( pTarget );
+}
+Void CGfxAPI_GL::destroyRenderTarget( IGfxAPIRenderTarget *rt ) {
+	if( !rt ) {
+		return;
+	}
+
+	SGLRenderTarget *const pTarget = reinterpret_cast<SGLRenderTarget *>( rt );
+	if( m_pTarget == pTarget ) {
+		omBindRenderTarget( nullptr );
+	}
+
+	glDeleteFramebuffers( 1, &pTarget->fbo );
+	glDeleteFramebuffers( 1, &pTarget->resolveFBO );
+	glDeleteRenderbuffers( 1, &pTarget->colorRB );
+	glDeleteTextures( 1, &pTarget->tex );
+	CHECKGL();
+
+	delete pTarget;
+}
+IGfxAPITexture *CGfxAPI_GL::getRenderTargetTexture( IGfxAPIRenderTarget *rt ) {
+	if( !rt ) {
+		return nullptr;
+	}
+
+	return objectToPointer<IGfxAPITexture>( reinterpret_cast<SGLRenderTarget *>( rt )->tex );
+}
+
+// Per-instance elements need generic attributes with divisors (GL 3.3 or
+// ARB_instanced_arrays); the instanced draws that read them need GL 3.2, so a
+// draw per instance never has to step them by hand (see issueDrawGL())
+static Bool DOLL_API canStepPerInstanceGL() {
+	return GLEW_VERSION_3_3 || ( GLEW_VERSION_3_2 && GLEW_ARB_instanced_arrays );
+}
+static Void DOLL_API setAttribDivisorGL( GLuint attrib, U32 uStepRate ) {
+	if( GLEW_VERSION_3_3 ) {
+		glVertexAttribDivisor( attrib, uStepRate );
+	} else {
+		glVertexAttribDivisorARB( attrib, uStepRate );
+	}
+}
+
+static GLuint DOLL_API makeLayoutProgramGL( const SGLLayout &layout );
+
 IGfxAPIVLayout *CGfxAPI_GL::createLayout( const SGfxLayout &desc ) {
-	return (IGfxAPIVLayout *)&desc;
+	// Per-instance elements and quad rectangles are read by a program
+	Bool bPerInstance = false;
+	Bool bProgram     = false;
+	UPtr uVertex      = ~UPtr( 0 );
+	for( UPtr i = 0; i < desc.cElements; ++i ) {
+		const SGfxLayoutElement &q = desc.elements[i];
+
+		bPerInstance |= q.uStepRate != 0;
+		bProgram |= q.uStepRate != 0 || q.type == kGfxLayoutElementVertexRect || q.type == kGfxLayoutElementTexCoordRect;
+
+		if( q.type == kGfxLayoutElementVertex && uVertex == ~UPtr( 0 ) ) {
+			uVertex = i;
+		}
+
+		// Half-float arrays need GL 3.0 or ARB_half_float_vertex
+		if( q.compTy == kVectorTypeF16 && !GLEW_VERSION_3_0 && !GLEW_ARB_half_float_vertex ) {
+			return nullptr;
+		}
+	}
+
+	// Refused quietly; callers with a compact layout fall back to a wider one,
+	// and sprites to six vertices per quad
+	if( !bProgram ) {
+		for( UPtr i = 0; i < desc.cElements; ++i ) {
+			// Fixed-function arrays only normalize colors
+			if( desc.elements[i].compTy == kVectorTypeU16_UNorm && desc.elements[i].type != kGfxLayoutElementColor ) {
+				return nullptr;
+			}
+		}
+	} else if( !GLEW_VERSION_2_0 || ( bPerInstance && !canStepPerInstanceGL() ) ) {
+		return nullptr;
+	} else if( uVertex == ~UPtr( 0 ) || desc.elements[uVertex].uStepRate != 0 ) {
+		// Attribute 0 has to be a per-vertex array
+		return nullptr;
+	}
+
+	SGLLayout *const pLayout = new SGLLayout();
+	if( !AX_VERIFY_MEMORY( pLayout ) ) {
+		return nullptr;
+	}
+
+	pLayout->stride         = desc.stride;
+	pLayout->instanceStride = desc.instanceStride;
+	pLayout->cElements      = desc.cElements;
+	pLayout->program        = 0;
+	for( UPtr i = 0; i < desc.cElements; ++i ) {
+		pLayout->elements[i] = desc.elements[i];
+		pLayout->attribs[i]  = GLuint( i == uVertex ? 0 : i < uVertex ? i + 1 : i );
+	}
+
+	if( bProgram && !( pLayout->program = makeLayoutProgramGL( *pLayout ) ) ) {
+		delete pLayout;
+		return nullptr;
+	}
+
+	return (IGfxAPIVLayout *)pLayout;
 }
 Void CGfxAPI_GL::destroyLayout( IGfxAPIVLayout *pLayout ) {
-	if( m_pCurrLayout != (SGfxLayout *)pLayout ) {
+	SGLLayout *const p = (SGLLayout *)pLayout;
+	if( !p ) {
 		return;
 	}
 
-	m_pCurrLayout = nullptr;
-	m_layoutVBuf  = ~0U;
+	if( m_pCurrLayout == p ) {
+		disableAttribArrays();
+
+		m_pCurrLayout = nullptr;
+		m_layoutVBuf  = ~0U;
+	}
+
+	if( p->program != 0 ) {
+		glDeleteProgram( p->program );
+	}
+
+	delete p;
 }
 
 IGfxAPIVBuffer *CGfxAPI_GL::createVBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
@@ -650,6 +858,10 @@ Void CGfxAPI_GL::destroyVBuffer( IGfxAPIVBuffer *vb ) {
 	if( m_layoutVBuf == vbo ) {
 		m_layoutVBuf = ~0U;
 	}
+	if( m_instanceVBuf == vbo ) {
+		m_instanceVBuf = 0;
+		m_layoutVBuf   = ~0U;
+	}
 
 	destroyBufferGL( vbo );
 }
@@ -685,28 +897,36 @@ static GLenum shaderStageToEnum( EShaderStage stage ) {
 	return 0;
 }
 
-IGfxAPIShader *CGfxAPI_GL::createShader( Str filename, EShaderFormat fmt, EShaderStage stage, UPtr cBytes, const Void *pData, IGfxDiagnostic *pDiag ) {
-	IGfxDiagnostic &diag = getDiag( pDiag );
+// Shader handed out by createShader()
+//
+// With the program cache enabled, compiling is put off until a program
+// using the shader misses the cache, so a warm start compiles nothing
+struct GLShader {
+	// Zero until compiled
+	GLuint shaderObject;
+	GLenum shaderType;
+	// Key of the source (see gfx_calcShaderCacheKey())
+	U64 uCacheKey;
+
+	MutStr filename;
+	// Source that hasn't been compiled yet (emptied once it is)
+	MutStr source;
+};
 
-	if( fmt != kShaderFormatGLSL ) {
-		diag.error( filename, 0, 0, "Expected GLSL format." );
-		return nullptr;
-	}
+static GLShader *toGLShader( IGfxAPIShader *pShader ) {
+	return reinterpret_cast<GLShader *>( pShader );
+}
 
-	// TODO: Use a shader cache to avoid compiling on each call
-	// TODO: Use a generic lexer/preprocessor to process the text rather than just using it as-is
+static Bool compileShaderGL( GLShader &shader, const MutStr &shaderSource, IGfxDiagnostic &diag ) {
+	const Str filename( shader.filename );
 
-	MutStr shaderSource;
-	if( !core_readText( shaderSource, filename ) ) {
-		diag.error( filename, 0, 0, "Failed to read." );
-		return nullptr;
-	}
+	// TODO: Use a generic lexer/preprocessor to process the text rather than just using it as-is
 
-	GLuint shaderObj = glCreateShader( shaderStageToEnum( stage ) );
+	GLuint shaderObj = glCreateShader( shader.shaderType );
 	if( !shaderObj ) {
 		CHECKGL();
 		diag.error( filename, 0, 0, "Failed to create shader object." );
-		return nullptr;
+		return false;
 	}
 
 	const GLchar *sources[]{ reinterpret_cast<const GLchar *>( shaderSource.get() ) };
@@ -739,14 +959,66 @@ IGfxAPIShader *CGfxAPI_GL::createShader( Str filename, EShaderFormat fmt, EShade
 		}
 
 		glDeleteShader( shaderObj );
-		return nullptr;
+		return false;
 	}
 
 	if( diagString.isUsed() ) {
 		diag.diagnostic( filename, 0, 0, diagString );
 	}
 
-	return objectToPointer<IGfxAPIShader>( shaderObj );
+	shader.shaderObject = shaderObj;
+	shader.source.clear();
+	return true;
+}
+
+IGfxAPIShader *CGfxAPI_GL::createShader( Str filename, EShaderFormat fmt, EShaderStage stage, UPtr cBytes, const Void *pData, IGfxDiagnostic *pDiag ) {
+	( (Void)cBytes );
+	( (Void)pData );
+
+	IGfxDiagnostic &diag = getDiag( pDiag );
+
+	if( fmt != kShaderFormatGLSL ) {
+		diag.error( filename, 0, 0, "Expected GLSL format." );
+		return nullptr;
+	}
+
+	MutStr shaderSource;
+	if( !core_readText( shaderSource, filename ) ) {
+		diag.error( filename, 0, 0, "Failed to read." );
+		return nullptr;
+	}
+
+	GLShader *const pShader = new GLShader();
+	if( !AX_VERIFY_MEMORY( pShader ) ) {
+		return nullptr;
+	}
+
+	pShader->shaderObject = 0;
+	pShader->shaderType   = shaderStageToEnum( stage );
+	pShader->uCacheKey    = gfx_calcShaderCacheKey( fmt, stage, shaderSource.get(), shaderSource.len(), getDriverKey() );
+
+	if( !AX_VERIFY_MEMORY( pShader->filename.tryAssign( filename ) ) ) {
+		delete pShader;
+		return nullptr;
+	}
+
+	// The program may come from the cache, in which case this never needs
+	// compiling
+	if( isProgramCacheEnabled() ) {
+		if( !AX_VERIFY_MEMORY( pShader->source.tryAssign( shaderSource ) ) ) {
+			delete pShader;
+			return nullptr;
+		}
+
+		return reinterpret_cast<IGfxAPIShader *>( pShader );
+	}
+
+	if( !compileShaderGL( *pShader, shaderSource, diag ) ) {
+		delete pShader;
+		return nullptr;
+	}
+
+	return reinterpret_cast<IGfxAPIShader *>( pShader );
 }
 
 constexpr size_t shaderTypeToIndex( GLenum shaderType ) {
@@ -794,7 +1066,7 @@ constexpr bool isComputeShader( GLenum shaderType ) {
 	return shaderType == GL_COMPUTE_SHADER;
 }
 
-static bool attachShadersToProgram( GLuint programObj, const TArr<IGfxAPIShader *> &shaders, IGfxDiagnostic &diag ) {
+static bool checkProgramShaders( const TArr<IGfxAPIShader *> &shaders, IGfxDiagnostic &diag ) {
 	bool hasShader[6]{};
 	bool hasAnyGfxShader = false;
 
@@ -803,13 +1075,9 @@ static bool attachShadersToProgram( GLuint programObj, const TArr<IGfxAPIShader
 			continue;
 		}
 
-		const GLuint shaderObj = pointerToObject( shader );
+		const GLenum shaderType = toGLShader( shader )->shaderType;
 
-		GLint shaderType = 0;
-		glGetShaderiv( shaderObj, GL_SHADER_TYPE, &shaderType );
-		CHECKGL();
-
-		const size_t shaderIndex = shaderTypeToIndex( GLenum( shaderType ) );
+		const size_t shaderIndex = shaderTypeToIndex( shaderType );
 		if( shaderIndex == ~size_t( 0 ) ) {
 			diag.error( Str(), 0, 0, "Invalid shader type" );
 			return false;
@@ -863,9 +1131,182 @@ public:
 	void nvm() { _program = 0; }
 };
 
+// Appends formatted text to `pszDst`, which has `cChars` of its `cMaxChars`
+// used already
+static Void appendSourceGL( char *pszDst, UPtr cMaxChars, UPtr &cChars, const char *pszFormat, ... ) {
+	va_list args;
+	va_start( args, pszFormat );
+	const int r = vsnprintf( pszDst + cChars, cMaxChars - cChars, pszFormat, args );
+	va_end( args );
+
+	if( r > 0 ) {
+		cChars = cChars + UPtr( r ) < cMaxChars ? cChars + UPtr( r ) : cMaxChars - 1;
+	}
+}
+
+// Vertex program standing in for the fixed-function vertex stage: each element
+// comes from its generic attribute, and a quad rectangle takes the corner the
+// position picks (see gfx_r_layoutVertexRect()); with no fragment shader, the
+// texture environment, alpha test and blending apply as they would without it
+static GLuint DOLL_API makeLayoutProgramGL( const SGLLayout &layout ) {
+	char szSource[4096];
+	UPtr cChars = 0;
+
+	appendSourceGL( szSource, sizeof( szSource ), cChars, "#version 120\n" );
+	for( UPtr i = 0; i < layout.cElements; ++i ) {
+		appendSourceGL( szSource, sizeof( szSource ), cChars, "attribute vec4 a%u;\n", U32( layout.attribs[i] ) );
+	}
+
+	appendSourceGL( szSource, sizeof( szSource ), cChars, "void main() {\n\tvec4 pos = a0;\n\tgl_FrontColor = gl_Color;\n" );
+
+	U32 uTexStage = 0;
+	for( UPtr i = 0; i < layout.cElements; ++i ) {
+		const U32 a = U32( layout.attribs[i] );
+
+		switch( layout.elements[i].type ) {
+		case kGfxLayoutElementVertex:
+		case kGfxLayoutElementNormal:
+			break;
+
+		case kGfxLayoutElementColor:
+			appendSourceGL( szSource, sizeof( szSource ), cChars, "\tgl_FrontColor = a%u;\n", a );
+			break;
+
+		case kGfxLayoutElementTexCoord:
+			appendSourceGL( szSource, sizeof( szSource ), cChars, "\tgl_TexCoord[%u] = a%u;\n", uTexStage, a );
+			++uTexStage;
+			break;
+
+		case kGfxLayoutElementVertexRect:
+			appendSourceGL( szSource, sizeof( szSource ), cChars, "\tpos.xy = mix( a%u.xy, a%u.zw, a0.xy );\n", a, a );
+			break;
+
+		case kGfxLayoutElementTexCoordRect:
+			appendSourceGL( szSource, sizeof( szSource ), cChars, "\tgl_TexCoord[%u] = vec4( mix( a%u.xy, a%u.zw, a0.xy ), 0.0, 1.0 );\n", uTexStage, a, a );
+			++uTexStage;
+			break;
+		}
+	}
+
+	appendSourceGL( szSource, sizeof( szSource ), cChars, "\tgl_Position = gl_ModelViewProjectionMatrix*pos;\n}\n" );
+
+	MutStr source;
+	if( !AX_VERIFY_MEMORY( source.tryAssign( Str( szSource ) ) ) ) {
+		return 0;
+	}
+
+	GLShader shader;
+	shader.shaderObject = 0;
+	shader.shaderType   = GL_VERTEX_SHADER;
+	shader.uCacheKey    = 0;
+	if( !compileShaderGL( shader, source, getDiag( nullptr ) ) ) {
+		return 0;
+	}
+
+	const GLuint programObj = glCreateProgram();
+	if( !programObj ) {
+		CHECKGL();
+		glDeleteShader( shader.shaderObject );
+		return 0;
+	}
+
+	AutofreeProgram autodeleteProgram( programObj );
+
+	glAttachShader( programObj, shader.shaderObject );
+	for( UPtr i = 0; i < layout.cElements; ++i ) {
+		char szName[16];
+		snprintf( szName, sizeof( szName ), "a%u", U32( layout.attribs[i] ) );
+		glBindAttribLocation( programObj, layout.attribs[i], szName );
+	}
+	glLinkProgram( programObj );
+
+	glDetachShader( programObj, shader.shaderObject );
+	glDeleteShader( shader.shaderObject );
+	CHECKGL();
+
+	GLint didLinkSucceed = 0;
+	glGetProgramiv( programObj, GL_LINK_STATUS, &didLinkSucceed );
+	if( !didLinkSucceed ) {
+		g_ErrorLog += "GL: Failed to link the program for a vertex layout.";
+		return 0;
+	}
+
+	autodeleteProgram.nvm();
+	return programObj;
+}
+
+U64 CGfxAPI_GL::getDriverKey() {
+	// Binaries from one driver (or version of it) mean nothing to another
+	if( !m_uDriverKey ) {
+		const char *const pszVendor   = (const char *)glGetString( GL_VENDOR );
+		const char *const pszRenderer = (const char *)glGetString( GL_RENDERER );
+		const char *const pszVersion  = (const char *)glGetString( GL_VERSION );
+
+		m_uDriverKey =
+			CShaderCacheKey()
+			.addString( Str( "gl" ) )
+			.addString( Str( pszVendor != nullptr ? pszVendor : "" ) )
+			.addString( Str( pszRenderer != nullptr ? pszRenderer : "" ) )
+			.addString( Str( pszVersion != nullptr ? pszVersion : "" ) )
+			.get();
+	}
+
+	return m_uDriverKey;
+}
+Bool CGfxAPI_GL::isProgramCacheEnabled() const {
+	return m_bProgramBinaries && m_shaderCache.isEnabled();
+}
+
+Bool CGfxAPI_GL::loadProgramBinary( U32 programObj, U64 uKey ) {
+	TMutArr<U8> binary;
+	U32 uFormat = 0;
+	if( !m_shaderCache.load( uKey, binary, uFormat ) ) {
+		return false;
+	}
+
+	glProgramBinary( programObj, GLenum( uFormat ), binary.pointer(), GLsizei( binary.num() ) );
+
+	GLint didLinkSucceed = 0;
+	glGetProgramiv( programObj, GL_LINK_STATUS, &didLinkSucceed );
+
+	// The driver may reject binaries from an older version of itself even
+	// though it reports the same strings
+	if( !didLinkSucceed ) {
+		m_shaderCache.remove( uKey );
+		return false;
+	}
+
+	return true;
+}
+Void CGfxAPI_GL::storeProgramBinary( U32 programObj, U64 uKey ) {
+	GLint cBytes = 0;
+	glGetProgramiv( programObj, GL_PROGRAM_BINARY_LENGTH, &cBytes );
+	if( cBytes <= 0 ) {
+		return;
+	}
+
+	TMutArr<U8> binary;
+	if( !AX_VERIFY_MEMORY( binary.resize( UPtr( cBytes ) ) ) ) {
+		return;
+	}
+
+	GLsizei cWritten = 0;
+	GLenum format = 0;
+	glGetProgramBinary( programObj, GLsizei( cBytes ), &cWritten, &format, binary.pointer() );
+	CHECKGL();
+
+	if( cWritten > 0 ) {
+		m_shaderCache.store( uKey, U32( format ), binary.pointer(), UPtr( cWritten ) );
+	}
+}
+
 IGfxAPIProgram *CGfxAPI_GL::createProgram( TArr<IGfxAPIShader *> shaders, IGfxDiagnostic *pDiag ) {
 	IGfxDiagnostic &diag = getDiag( pDiag );
 
+	if( !checkProgramShaders( shaders, diag ) ) {
+		return nullptr;
+	}
+
 	GLuint programObj = glCreateProgram();
 	CHECKGL();
 
@@ -876,9 +1317,51 @@ IGfxAPIProgram *CGfxAPI_GL::createProgram( TArr<IGfxAPIShader *> shaders, IGfxDi
 
 	AutofreeProgram autodeleteProgram( programObj );
 
-	attachShadersToProgram( programObj, shaders, diag );
+	// The program depends on the driver and each shader (in order)
+	const Bool bUseCache = isProgramCacheEnabled();
+	U64 uProgramKey = 0;
+	if( bUseCache ) {
+		CShaderCacheKey key;
+		key.addU64( getDriverKey() );
+		for( IGfxAPIShader *pShader : shaders ) {
+			key.addU64( pShader != nullptr ? toGLShader( pShader )->uCacheKey : 0 );
+		}
+		uProgramKey = key.get();
+
+		if( loadProgramBinary( programObj, uProgramKey ) ) {
+			autodeleteProgram.nvm();
+			return objectToPointer<IGfxAPIProgram>( programObj );
+		}
+	}
+
+	// Compile whatever was put off for the cache
+	for( IGfxAPIShader *pShader : shaders ) {
+		if( !pShader ) {
+			continue;
+		}
+
+		GLShader &shader = *toGLShader( pShader );
+		if( !shader.shaderObject && !compileShaderGL( shader, shader.source, diag ) ) {
+			return nullptr;
+		}
+
+		glAttachShader( programObj, shader.shaderObject );
+		CHECKGL();
+	}
+
+	if( bUseCache ) {
+		glProgramParameteri( programObj, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+	}
+
 	glLinkProgram( programObj );
 
+	// Linked programs don't need their shaders
+	for( IGfxAPIShader *pShader : shaders ) {
+		if( pShader != nullptr ) {
+			glDetachShader( programObj, toGLShader( pShader )->shaderObject );
+		}
+	}
+
 	GLint didLinkSucceed = 0;
 	glGetProgramiv( programObj, GL_LINK_STATUS, &didLinkSucceed );
 
@@ -905,6 +1388,10 @@ IGfxAPIProgram *CGfxAPI_GL::createProgram( TArr<IGfxAPIShader *> shaders, IGfxDi
 		diag.diagnostic( Str(), 0, 0, diagString );
 	}
 
+	if( bUseCache ) {
+		storeProgramBinary( programObj, uProgramKey );
+	}
+
 	autodeleteProgram.nvm();
 	return objectToPointer<IGfxAPIProgram>( programObj );
 }
@@ -913,10 +1400,13 @@ Void CGfxAPI_GL::destroyShader( IGfxAPIShader *pShader ) {
 		return;
 	}
 
-	const GLuint shaderObj = pointerToObject( pShader );
-	AX_ASSERT_MSG( glIsShader( shaderObj ), "Expected shader object" );
+	GLShader *const p = toGLShader( pShader );
+	if( p->shaderObject != 0 ) {
+		AX_ASSERT_MSG( glIsShader( p->shaderObject ), "Expected shader object" );
+		glDeleteShader( p->shaderObject );
+	}
 
-	glDeleteShader( shaderObj );
+	delete p;
 }
 Void CGfxAPI_GL::destroyProgram( IGfxAPIProgram *pProgram ) {
 	if( !pProgram ) {
@@ -929,18 +1419,27 @@ Void CGfxAPI_GL::destroyProgram( IGfxAPIProgram *pProgram ) {
 	glDeleteProgram( programObj );
 }
 Bool CGfxAPI_GL::setCacheDirectory( Str basePath ) {
-	( (Void)basePath );
+	if( basePath.isUsed() ) {
+		GLint cFormats = 0;
+		if( GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary ) {
+			glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &cFormats );
+		}
 
-	AX_ASSERT_MSG( false, "CGfxAPI_GL::setCacheDirectory() not yet implemented" );
+		m_bProgramBinaries = cFormats > 0;
+		if( !m_bProgramBinaries ) {
+			DOLL_WARNING_LOG += "Driver can't save program binaries; shaders won't be cached.";
+			m_shaderCache.setDirectory( Str() );
+			return false;
+		}
+	}
 
-	return false;
+	return m_shaderCache.setDirectory( basePath );
 }
 Str CGfxAPI_GL::getCacheDirectory() const {
-	AX_ASSERT_MSG( false, "CGfxAPI_GL::getCacheDirectory() not yet implemented" );
-	return Str();
+	return m_shaderCache.getDirectory();
 }
 Void CGfxAPI_GL::invalidateShaderCache() {
-	AX_ASSERT_MSG( false, "CGfxAPI_GL::invalidateShaderCache() not yet implemented" );
+	m_shaderCache.clear();
 }
 
 Void CGfxAPI_GL::vsSetProjectionMatrix( const F32 *matrix ) {
@@ -1083,13 +1582,16 @@ Void CGfxAPI_GL::rsSetViewport( S32 posX, S32 posY, U32 resX, U32 resY ) {
 	CHECKGL();
 }
 
-static Void DOLL_API applyLayoutPointers( SGfxLayout *p, UPtr base ) {
+static Void DOLL_API disableClientArraysGL() {
 	glDisableClientState( GL_VERTEX_ARRAY );
 	glDisableClientState( GL_NORMAL_ARRAY );
 	glDisableClientState( GL_COLOR_ARRAY );
 	glDisableClientState( GL_SECONDARY_COLOR_ARRAY );
 	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
 	CHECKGL();
+}
+static Void DOLL_API applyLayoutPointers( SGLLayout *p, UPtr base ) {
+	disableClientArraysGL();
 
 	const GLsizei stride = (GLsizei)p->stride;
 	U8 uTexStage         = 0;
@@ -1130,6 +1632,11 @@ static Void DOLL_API applyLayoutPointers( SGfxLayout *p, UPtr base ) {
 
 			++uTexStage;
 			break;
+
+		case kGfxLayoutElementVertexRect:
+		case kGfxLayoutElementTexCoordRect:
+			// Only drawn through the layout's program
+			break;
 		}
 	}
 }
@@ -1142,16 +1649,80 @@ Void CGfxAPI_GL::applyLayout() {
 	if( m_layoutVBuf != vbo ) {
 		m_layoutVBuf = vbo;
 
-		applyLayoutPointers( (SGfxLayout *)m_pCurrLayout, 0 );
+		if( m_pCurrLayout->program != 0 ) {
+			applyLayoutAttribs( vbo );
+		} else {
+			disableAttribArrays();
+			applyLayoutPointers( m_pCurrLayout, 0 );
+		}
+	}
+}
+Void CGfxAPI_GL::applyLayoutAttribs( U32 vbo ) {
+	const SGLLayout &layout = *m_pCurrLayout;
+
+	disableClientArraysGL();
+	glUseProgram( layout.program );
+
+	// Per-instance elements come from the instance buffer, stepping with their
+	// divisors; without one they keep the attribute's current value
+	for( UPtr i = 0; i < layout.cElements; ++i ) {
+		const SGfxLayoutElement &q = layout.elements[i];
+		const GLuint attrib        = layout.attribs[i];
+
+		if( q.uStepRate != 0 && !m_instanceVBuf ) {
+			glDisableVertexAttribArray( attrib );
+			continue;
+		}
+
+		const Bool bNormalized = q.type == kGfxLayoutElementColor || q.compTy == kVectorTypeU16_UNorm;
+		const GLsizei stride   = GLsizei( q.uStepRate != 0 ? layout.instanceStride : layout.stride );
+
+		glBindBuffer( GL_ARRAY_BUFFER, q.uStepRate != 0 ? m_instanceVBuf : vbo );
+		glEnableVertexAttribArray( attrib );
+		glVertexAttribPointer( attrib, GLint( q.cComps ), compTyToGLTy( q.compTy ), bNormalized ? GL_TRUE : GL_FALSE, stride, (const GLvoid *)q.uOffset );
+		if( canStepPerInstanceGL() ) {
+			setAttribDivisorGL( attrib, q.uStepRate );
+		}
+		CHECKGL();
+	}
+
+	glBindBuffer( GL_ARRAY_BUFFER, vbo );
+
+	// Arrays only a previous layout had
+	for( U32 i = U32( layout.cElements ); i < m_cAttribArrays; ++i ) {
+		if( canStepPerInstanceGL() ) {
+			setAttribDivisorGL( i, 0 );
+		}
+		glDisableVertexAttribArray( i );
+	}
+	CHECKGL();
+
+	m_cAttribArrays = U32( layout.cElements );
+}
+Void CGfxAPI_GL::disableAttribArrays() {
+	if( !m_cAttribArrays ) {
+		return;
+	}
+
+	for( U32 i = 0; i < m_cAttribArrays; ++i ) {
+		if( canStepPerInstanceGL() ) {
+			setAttribDivisorGL( i, 0 );
+		}
+		glDisableVertexAttribArray( i );
 	}
+
+	glUseProgram( 0 );
+	CHECKGL();
+
+	m_cAttribArrays = 0;
 }
 
 Void CGfxAPI_GL::iaSetLayout( IGfxAPIVLayout *pLayout ) {
-	if( m_pCurrLayout == (SGfxLayout *)pLayout ) {
+	if( m_pCurrLayout == (SGLLayout *)pLayout ) {
 		return;
 	}
 
-	m_pCurrLayout = (SGfxLayout *)pLayout;
+	m_pCurrLayout = (SGLLayout *)pLayout;
 	m_layoutVBuf  = ~0U;
 }
 
@@ -1170,11 +1741,23 @@ Void CGfxAPI_GL::iaBindVBuffer( IGfxAPIVBuffer *vb ) {
 	glBindBuffer( GL_ARRAY_BUFFER, ( GLint )(UPtr)vb );
 	CHECKGL();
 }
-Void CGfxAPI_GL::iaBindIBuffer( IGfxAPIIBuffer *ib ) {
+Void CGfxAPI_GL::iaBindIBuffer( IGfxAPIIBuffer *ib, EIndexFormat fmt ) {
 	AX_ASSERT_NOT_NULL( ib );
 
 	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ( GLint )(UPtr)ib );
 	CHECKGL();
+
+	m_indexType = fmt == kIndexFormatU32 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+Void CGfxAPI_GL::iaBindInstanceBuffer( IGfxAPIVBuffer *vb ) {
+	const GLuint vbo = pointerToObject( vb );
+	if( m_instanceVBuf == vbo ) {
+		return;
+	}
+
+	// Read when the layout's attributes are next set up
+	m_instanceVBuf = vbo;
+	m_layoutVBuf   = ~0U;
 }
 
 Void CGfxAPI_GL::plBindProgram( IGfxAPIProgram *pProgram ) {
@@ -1191,6 +1774,18 @@ Void CGfxAPI_GL::cmdUpdateProgramBindings( const SGfxBinding &binding ) {
 	AX_ASSERT_MSG( false, "CGfxAPI_GL::cmdUpdateProgramBindings() not yet implemented" );
 }
 
+Void CGfxAPI_GL::omBindRenderTarget( IGfxAPIRenderTarget *rt ) {
+	// Without framebuffer objects nothing but the window is ever bound
+	if( !rt && !m_pTarget ) {
+		return;
+	}
+
+	m_pTarget = reinterpret_cast<SGLRenderTarget *>( rt );
+
+	glBindFramebuffer( GL_FRAMEBUFFER, m_pTarget != nullptr ? m_pTarget->fbo : 0 );
+	CHECKGL();
+}
+
 Void CGfxAPI_GL::cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value ) {
 	GLint box[4];
 	glGetIntegerv( GL_SCISSOR_BOX, box );
@@ -1198,7 +1793,7 @@ Void CGfxAPI_GL::cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value
 	const Bool enabled = glIsEnabled( GL_SCISSOR_TEST ) != 0;
 
 	glEnable( GL_SCISSOR_TEST );
-	gfx_r_setScissor( posX, posY, resX, resY );
+	rsSetScissor( posX, posY, resX, resY );
 
 	glClearColor(
 	    F32( DOLL_COLOR_R( value ) ) / 255.0f,
@@ -1233,6 +1828,28 @@ Void CGfxAPI_GL::cmdUpdateTexture( IGfxAPITexture *tex, U16 posX, U16 posY, U16
 	CHECKGL();
 }
 
+Void CGfxAPI_GL::cmdResolveRenderTarget( IGfxAPIRenderTarget *rt ) {
+	if( !rt ) {
+		return;
+	}
+
+	const SGLRenderTarget &t = *reinterpret_cast<SGLRenderTarget *>( rt );
+
+	// Blits are scissored like any other write
+	const Bool bScissor = glIsEnabled( GL_SCISSOR_TEST ) != 0;
+	glDisable( GL_SCISSOR_TEST );
+
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, t.fbo );
+	glBindFramebuffer( GL_DRAW_FRAMEBUFFER, t.resolveFBO );
+	glBlitFramebuffer( 0, 0, t.resX, t.resY, 0, t.resY, t.resX, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	glBindFramebuffer( GL_FRAMEBUFFER, m_pTarget != nullptr ? m_pTarget->fbo : 0 );
+	CHECKGL();
+
+	if( bScissor ) {
+		glEnable( GL_SCISSOR_TEST );
+	}
+}
+
 static Bool updateBufferGL( GLenum target, GLenum targetBinding, UPtr vbuffer, UPtr offset, UPtr size, const void *pData ) {
 	const GLuint oldvbo = getGLUint( targetBinding );
 
@@ -1300,31 +1917,66 @@ Void CGfxAPI_GL::cmdReadUBuffer( IGfxAPIUBuffer *ub, UPtr offset, UPtr size, Voi
 	( Void ) readBufferGL( GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING, pointerToObject( ub ), offset, size, pData );
 }
 
-Void CGfxAPI_GL::cmdDraw( ETopology mode, U32 cVerts, U32 uOffset ) {
-	AX_ASSERT( getGLUint( GL_ARRAY_BUFFER_BINDING ) != 0 );
-	AX_ASSERT_NOT_NULL( m_pCurrLayout );
+// One draw call of `cInstances` instances (a call per instance before GL 3.1,
+// which only layouts without per-instance elements get to; see createLayout())
+static Void DOLL_API issueDrawGL( GLenum topology, U32 cCount, U32 uOffset, U32 uBias, GLenum indexType, U32 cInstances ) {
+	const Bool bInstanced = cInstances > 1 && ( uBias > 0 ? GLEW_VERSION_3_2 : GLEW_VERSION_3_1 );
+	const U32 cCalls      = cInstances > 1 && !bInstanced ? cInstances : 1;
 
-	applyLayout();
+	const GLvoid *const pIndices = (const GLvoid *)(UPtr)uOffset;
 
-	glDrawArrays( getTopologyGL( mode ), (GLint)uOffset, (GLsizei)cVerts );
-	CHECKGL();
+	for( U32 i = 0; i < cCalls; ++i ) {
+		if( !indexType ) {
+			if( bInstanced ) {
+				glDrawArraysInstanced( topology, (GLint)uOffset, (GLsizei)cCount, (GLsizei)cInstances );
+			} else {
+				glDrawArrays( topology, (GLint)uOffset, (GLsizei)cCount );
+			}
+		} else if( uBias > 0 ) {
+			if( bInstanced ) {
+				glDrawElementsInstancedBaseVertex( topology, (GLsizei)cCount, indexType, pIndices, (GLsizei)cInstances, (GLint)uBias );
+			} else {
+				glDrawElementsBaseVertex( topology, (GLsizei)cCount, indexType, pIndices, (GLint)uBias );
+			}
+		} else {
+			if( bInstanced ) {
+				glDrawElementsInstanced( topology, (GLsizei)cCount, indexType, pIndices, (GLsizei)cInstances );
+			} else {
+				glDrawElements( topology, (GLsizei)cCount, indexType, pIndices );
+			}
+		}
+		CHECKGL();
+	}
 }
-Void CGfxAPI_GL::cmdDrawIndexed( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias ) {
+
+Void CGfxAPI_GL::drawInstances( ETopology mode, U32 cCount, U32 uOffset, U32 uBias, Bool bIndexed, U32 cInstances ) {
 	AX_ASSERT( getGLUint( GL_ARRAY_BUFFER_BINDING ) != 0 );
-	AX_ASSERT( getGLUint( GL_ELEMENT_ARRAY_BUFFER_BINDING ) != 0 );
+	AX_ASSERT( !bIndexed || getGLUint( GL_ELEMENT_ARRAY_BUFFER_BINDING ) != 0 );
 	AX_ASSERT_NOT_NULL( m_pCurrLayout );
 
+	if( !cInstances ) {
+		return;
+	}
+
 	applyLayout();
 
-	const GLenum topology = getTopologyGL( mode );
+	const GLenum topology  = getTopologyGL( mode );
+	const GLenum indexType = bIndexed ? GLenum( m_indexType ) : GLenum( 0 );
 
-	if( uBias > 0 ) {
-		glDrawElementsBaseVertex( topology, (GLsizei)cIndices, GL_UNSIGNED_SHORT, (const GLvoid *)(UPtr)uOffset, (GLint)uBias );
-		CHECKGL();
-	} else {
-		glDrawElements( topology, (GLsizei)cIndices, GL_UNSIGNED_SHORT, (const GLvoid *)(UPtr)uOffset );
-		CHECKGL();
-	}
+	issueDrawGL( topology, cCount, uOffset, uBias, indexType, cInstances );
+}
+
+Void CGfxAPI_GL::cmdDraw( ETopology mode, U32 cVerts, U32 uOffset ) {
+	drawInstances( mode, cVerts, uOffset, 0, false, 1 );
+}
+Void CGfxAPI_GL::cmdDrawIndexed( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias ) {
+	drawInstances( mode, cIndices, uOffset, uBias, true, 1 );
+}
+Void CGfxAPI_GL::cmdDrawInstanced( ETopology mode, U32 cVerts, U32 uOffset, U32 cInstances ) {
+	drawInstances( mode, cVerts, uOffset, 0, false, cInstances );
+}
+Void CGfxAPI_GL::cmdDrawIndexedInstanced( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances ) {
+	drawInstances( mode, cIndices, uOffset, uBias, true, cInstances );
 }
 
 static void errorBox( OSWindow wnd, const char *message, const char *title = "Error" ) {
@@ -1343,6 +1995,8 @@ DOLL_FUNC CGfxAPI_GL *DOLL_API gfx__api_init_gl( OSWindow wnd, const SGfxInitDes
 #	if DOLL__USE_GLFW
 	( (void)desc );
 #	else
+	AX_ASSERT_NOT_NULL( wnd );
+
 	SGLContext *const pCtx = os_initGL( wnd, SGLInitInfo().setDepthStencil( 24, 8 ).setFullscreen( desc.windowing != kGfxScreenModeWindowed, desc.vsync ) );
 	if( !AX_VERIFY_MSG( pCtx != nullptr, "Failed to initialize OpenGL context" ) ) {
 		axpf( "f\n" );
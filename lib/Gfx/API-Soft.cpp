@@ -0,0 +1,2561 @@
+#define DOLL_TRACE_FACILITY doll::kLog_GfxAPIDrv
+#include "../BuildSettings.hpp"
+
+#include "doll/Core/Defs.hpp"
+#include "doll/Gfx/APIs.def.hpp"
+#if DOLL_GFX_SOFTWARE_ENABLED
+
+#	include "DummyDiag.hpp"
+#	include "doll/Gfx/API-Soft.hpp"
+
+#	include "doll/Core/Logger.hpp"
+#	include "doll/IO/File.hpp"
+#	include "doll/IO/SysFS.hpp"
+#	include "doll/Math/Basic.hpp"
+#	include "doll/Math/HalfFloat.hpp"
+#	include "doll/Math/SIMD.hpp"
+
+#	define STB_IMAGE_WRITE_IMPLEMENTATION
+#	define STBIW_ASSERT AX_ASSERT
+
+#	ifdef _MSC_VER
+#		pragma warning(push)
+#		pragma warning(disable:4456)
+#		pragma warning(disable:4457)
+#		pragma warning(disable:6001)
+#		pragma warning(disable:6011)
+#		pragma warning(disable:6385)
+#	endif
+#	ifdef __GNUC__
+#		pragma GCC diagnostic push
+#		pragma GCC diagnostic ignored "-Wunused-parameter"
+#		pragma GCC diagnostic ignored "-Wunused-function"
+#		pragma GCC diagnostic ignored "-Wunused-variable"
+#	endif
+
+#	include <stb_image_write.h>
+
+#	ifdef __GNUC__
+#		pragma GCC diagnostic pop
+#	endif
+#	ifdef _MSC_VER
+#		pragma warning(pop)
+#	endif
+
+// Implemented in Texture.cpp
+#	include <stb_image.h>
+
+#	include <condition_variable>
+#	include <mutex>
+
+namespace doll {
+
+// Tiles are kSoftTileSize pixels square
+static const U32 kSoftTileShift = 6;
+static const U32 kSoftTileSize = U32( 1 ) << kSoftTileShift;
+// Vertex positions are snapped to 1/16th of a pixel
+static const S32 kSoftSubpixelBits = 4;
+static const S32 kSoftSubpixels = S32( 1 ) << kSoftSubpixelBits;
+// Largest snapped coordinate accepted (edge functions stay well within S64)
+static const F32 kSoftMaxCoord = F32( 1 << 26 );
+// Geometry is clipped against x,y = +/-kSoftGuardBand*w; what's left
+// outside the viewport is cut off by the clip rectangle when rasterizing
+static const F32 kSoftGuardBand = 2.0f;
+// Triangles with a smaller w are clipped away (behind the eye)
+static const F32 kSoftMinW = 1.0f/65536.0f;
+
+static const U32 kSoftDefaultThreads = 4;
+// Fewest pending commands worth handing to more than one thread
+static const UPtr kSoftMinThreadedCmds = 64;
+// Pending triangles that force a flush (bounds the memory used for bins)
+static const UPtr kSoftMaxPendingTris = 1<<16;
+// Framebuffer size when there's no window to take it from
+static const U32 kSoftDefaultResX = 1280;
+static const U32 kSoftDefaultResY = 720;
+static const U32 kSoftMaxStages = 8;
+// Post-transform vertex cache entries per draw (power of two)
+static const U32 kSoftVertexCacheSize = 32;
+// Set on entries of SSoftContext::cmds that index `clears` (not `tris`)
+static const U32 kSoftClearBit = 0x80000000;
+
+struct SSoftBuffer {
+	TMutArr<U8> data;
+};
+struct SSoftTexture {
+	U32 uResX;
+	U32 uResY;
+	// DOLL_RGBA() texels, top row first
+	TMutArr<U32> texels;
+};
+struct SSoftRenderTarget {
+	// Drawn into while bound
+	SSoftTexture color;
+	// What cmdResolveRenderTarget() last copied out of `color`
+	SSoftTexture texture;
+};
+struct SSoftSampler {
+	ETextureFilter magFilter;
+	ETextureFilter minFilter;
+	ETextureWrap wrapU;
+	ETextureWrap wrapV;
+	U32 borderColor;
+};
+
+// Half-open pixel rectangle: [x0,x1) x [y0,y1)
+struct SSoftRect {
+	S32 x0, y0;
+	S32 x1, y1;
+
+	Bool isEmpty() const {
+		return x0 >= x1 || y0 >= y1;
+	}
+	SSoftRect intersect( const SSoftRect &o ) const {
+		SSoftRect r;
+		r.x0 = x0 > o.x0 ? x0 : o.x0;
+		r.y0 = y0 > o.y0 ? y0 : o.y0;
+		r.x1 = x1 < o.x1 ? x1 : o.x1;
+		r.y1 = y1 < o.y1 ? y1 : o.y1;
+		return r;
+	}
+};
+static SSoftRect makeRect( S32 posX, S32 posY, U32 resX, U32 resY ) {
+	SSoftRect r;
+	r.x0 = posX;
+	r.y0 = posY;
+	r.x1 = S32( S64( posX ) + S64( resX ) > S64( 0x7FFFFFFF ) ? 0x7FFFFFFF : S64( posX ) + S64( resX ) );
+	r.y1 = S32( S64( posY ) + S64( resY ) > S64( 0x7FFFFFFF ) ? 0x7FFFFFFF : S64( posY ) + S64( resY ) );
+	return r;
+}
+
+// Fixed function state a batch of triangles is drawn with
+struct SSoftDrawState {
+	// Texture for stage 0 (null if texturing is off)
+	const SSoftTexture *pTexture;
+	SSoftSampler sampler;
+
+	EBlendOp blendOp;
+	EBlendFactor colA;
+	EBlendFactor colB;
+	EBlendFactor alphaA;
+	EBlendFactor alphaB;
+
+	Bool bAlphaTest;
+	// Viewport and scissor (if enabled), within the framebuffer
+	SSoftRect clip;
+};
+static Bool isSameState( const SSoftDrawState &a, const SSoftDrawState &b ) {
+	return
+		a.pTexture == b.pTexture &&
+		a.sampler.magFilter == b.sampler.magFilter &&
+		a.sampler.minFilter == b.sampler.minFilter &&
+		a.sampler.wrapU == b.sampler.wrapU &&
+		a.sampler.wrapV == b.sampler.wrapV &&
+		a.sampler.borderColor == b.sampler.borderColor &&
+		a.blendOp == b.blendOp &&
+		a.colA == b.colA && a.colB == b.colB &&
+		a.alphaA == b.alphaA && a.alphaB == b.alphaB &&
+		a.bAlphaTest == b.bAlphaTest &&
+		a.clip.x0 == b.clip.x0 && a.clip.y0 == b.clip.y0 &&
+		a.clip.x1 == b.clip.x1 && a.clip.y1 == b.clip.y1;
+}
+
+// Interpolated attributes (each divided by w when perspective correct)
+enum {
+	kSoftAttrR,
+	kSoftAttrG,
+	kSoftAttrB,
+	kSoftAttrA,
+	kSoftAttrU,
+	kSoftAttrV,
+	kSoftNumVertAttrs,
+
+	// 1/w (perspective correct triangles only)
+	kSoftAttrInvW = kSoftNumVertAttrs,
+	kSoftNumAttrs
+};
+
+// Vertex after the transform, before clipping
+struct SSoftVertex {
+	F32 clip[4];
+	F32 attrs[kSoftNumVertAttrs];
+};
+
+// Triangle set up for rasterization
+struct SSoftTriangle {
+	// Edge functions on the 28.4 grid, E(x,y) = A*x + B*y + C; a sample is
+	// inside where all three are >= 0 (C includes the fill rule bias)
+	S64 edgeA[3];
+	S64 edgeB[3];
+	S64 edgeC[3];
+	// Pixels the triangle may touch (within the state's clip rectangle)
+	SSoftRect bounds;
+	// Planes of each attribute: value at the center of bounds' first pixel,
+	// then the change per pixel in x and in y
+	F32 attrs[kSoftNumAttrs][3];
+	U32 uState;
+	Bool bPerspective;
+	Bool bLinear;
+};
+struct SSoftClear {
+	SSoftRect rc;
+	U32 value;
+};
+
+struct SSoftContext;
+
+// One of the rasterizer threads of an SSoftPool
+struct SSoftWorker {
+	SSoftContext *pCtx       = nullptr;
+	// Tiles taken on a flush: every cActive'th, starting from this one
+	U32           uIndex     = 0;
+	// Last `SSoftPool::uFlush` seen
+	U32           uSeenFlush = 0;
+	axthread_t    thread     = AXTHREAD_INITIALIZER;
+	Bool          bStarted   = false;
+};
+
+// Threads flushSoft() hands tiles to. They're started with the context (and
+// again when the thread count changes), sleep between flushes and are
+// joined when the context goes away. Worker N takes part in a flush when
+// N < cActive; the flushing thread is worker 0
+struct SSoftPool {
+	SSoftWorker workers[CGfxAPI_Soft::kMaxThreads];
+	// Workers 1 to cStarted are running
+	U32 cStarted;
+
+	std::mutex lock;
+	// Signalled when uFlush changes or bQuit is set
+	std::condition_variable wake;
+	// Signalled when the last busy worker finishes
+	std::condition_variable done;
+	// Incremented for each flush handed out
+	U32 uFlush;
+	U32 cActive;
+	// Workers still rasterizing the current flush (not counting worker 0)
+	U32 cBusy;
+	Bool bQuit;
+
+	SSoftPool()
+	: cStarted( 0 )
+	, uFlush( 0 )
+	, cActive( 1 )
+	, cBusy( 0 )
+	, bQuit( false )
+	{
+	}
+};
+
+struct SSoftContext {
+	OSWindow wnd;
+
+	U32 uResX;
+	U32 uResY;
+	// DOLL_RGBA() pixels, top row first
+	TMutArr<U32> pixels;
+	// Render target being drawn into (null for `pixels`)
+	SSoftRenderTarget *pTarget;
+	// Pixels being drawn into (either of the above) and their size
+	U32 *pDraw;
+	U32 uDrawResX;
+	U32 uDrawResY;
+	U32 cFrames;
+	U32 cThreads;
+
+	F32 proj[16];
+	F32 modelView[16];
+	// Columns of proj*modelView
+	V128 mvp[4];
+
+	SSoftRect viewport;
+	SSoftRect scissor;
+	Bool bScissor;
+	Bool bTexture;
+	Bool bAlphaTest;
+	EBlendOp blendOp;
+	EBlendFactor colA;
+	EBlendFactor colB;
+	EBlendFactor alphaA;
+	EBlendFactor alphaB;
+
+	const SGfxLayout *pLayout;
+	SSoftBuffer *pVBuf;
+	SSoftBuffer *pIBuf;
+	EIndexFormat indexFormat;
+	SSoftBuffer *pInstBuf;
+	SSoftTexture *pTextures[kSoftMaxStages];
+	SSoftSampler *pSamplers[kSoftMaxStages];
+
+	// Pending work, in submission order (see kSoftClearBit)
+	TMutArr<U32> cmds;
+	TMutArr<SSoftTriangle> tris;
+	TMutArr<SSoftClear> clears;
+	TMutArr<SSoftDrawState> states;
+	// State changed since the last entry of `states`
+	Bool bStateChanged;
+
+	// Commands of each tile, built by flushSoft(): tile N's are
+	// binCmds[ binStart[N] ] up to binCmds[ binStart[N + 1] ]
+	TMutArr<U32> binStart;
+	TMutArr<U32> binFill;
+	TMutArr<U32> binCmds;
+	U32 cTilesX;
+	U32 cTilesY;
+
+	SSoftPool pool;
+
+	SSoftContext()
+	: wnd( nullptr )
+	, uResX( 0 )
+	, uResY( 0 )
+	, pixels()
+	, pTarget( nullptr )
+	, pDraw( nullptr )
+	, uDrawResX( 0 )
+	, uDrawResY( 0 )
+	, cFrames( 0 )
+	, cThreads( kSoftDefaultThreads )
+	, bScissor( false )
+	, bTexture( false )
+	, bAlphaTest( true )
+	, blendOp( kBlendAdd )
+	, colA( kBlendSrcAlpha )
+	, colB( kBlendInvSrcAlpha )
+	, alphaA( kBlendSrcAlpha )
+	, alphaB( kBlendInvSrcAlpha )
+	, pLayout( nullptr )
+	, pVBuf( nullptr )
+	, pIBuf( nullptr )
+	, indexFormat( kIndexFormatU16 )
+	, pInstBuf( nullptr )
+	, cmds()
+	, tris()
+	, clears()
+	, states()
+	, bStateChanged( true )
+	, binStart()
+	, binFill()
+	, binCmds()
+	, cTilesX( 0 )
+	, cTilesY( 0 )
+	, pool()
+	{
+		for( U32 i = 0; i < 16; ++i ) {
+			proj[i]      = ( i%5 == 0 ) ? 1.0f : 0.0f;
+			modelView[i] = ( i%5 == 0 ) ? 1.0f : 0.0f;
+		}
+		for( U32 i = 0; i < kSoftMaxStages; ++i ) {
+			pTextures[i] = nullptr;
+			pSamplers[i] = nullptr;
+		}
+
+		viewport = makeRect( 0, 0, 0, 0 );
+		scissor  = makeRect( 0, 0, 0, 0 );
+	}
+};
+
+class CGfxAPIProvider_Soft : public IGfxAPIProvider {
+public:
+	virtual Void drop() override {
+	}
+
+	virtual Bool is( const Str &name ) const override {
+		return
+			name.caseCmp( "soft" ) ||
+			name.caseCmp( "software" ) ||
+			name.caseCmp( "sw" ) ||
+			name.caseCmp( "cpu" ) ||
+			name.caseCmp( "headless" );
+	}
+	virtual Str getName() const override {
+		return Str( "soft" );
+	}
+	virtual Str getDescription() const override {
+		return Str( "Software (CPU)" );
+	}
+	virtual IGfxAPI *initAPI( OSWindow wnd, const SGfxInitDesc &desc ) override {
+		return CGfxAPI_Soft::init( wnd, desc, *this );
+	}
+	virtual Void finiAPI( IGfxAPI *pAPI ) override {
+		delete pAPI;
+	}
+};
+static CGfxAPIProvider_Soft softwareGfxAPIProvider_;
+IGfxAPIProvider &softwareGfxAPIProvider = softwareGfxAPIProvider_;
+
+//====================================================================//
+
+static S64 floorDiv( S64 n, S64 d ) {
+	AX_ASSERT( d > 0 );
+
+	S64 q = n/d;
+	if( n%d != 0 && n < 0 ) {
+		--q;
+	}
+	return q;
+}
+static S64 ceilDiv( S64 n, S64 d ) {
+	return -floorDiv( -n, d );
+}
+static S32 floorToInt( F32 f ) {
+	// Keep the conversion in range; texture coordinates this large are
+	// meaningless anyway
+	if( !( f > -16777216.0f ) ) {
+		return -16777216;
+	}
+	if( !( f < 16777216.0f ) ) {
+		return 16777216;
+	}
+
+	const S32 i = S32( f );
+	return F32( i ) > f ? i - 1 : i;
+}
+
+static Void updateMVP( SSoftContext &ctx ) {
+	// Both are column major (as given to glLoadMatrixf)
+	for( U32 c = 0; c < 4; ++c ) {
+		V128 col = vecZero();
+		for( U32 k = 0; k < 4; ++k ) {
+			const V128 p = vecSet( ctx.proj[k*4 + 0], ctx.proj[k*4 + 1], ctx.proj[k*4 + 2], ctx.proj[k*4 + 3] );
+			col = vecAdd( col, vecScale( p, ctx.modelView[c*4 + k] ) );
+		}
+		ctx.mvp[c] = col;
+	}
+}
+
+// Draw into the bound render target, or the window if there's none
+static Void selectDrawTarget( SSoftContext &ctx ) {
+	if( ctx.pTarget != nullptr ) {
+		SSoftTexture &color = ctx.pTarget->color;
+		ctx.pDraw     = color.texels.pointer();
+		ctx.uDrawResX = color.uResX;
+		ctx.uDrawResY = color.uResY;
+	} else {
+		ctx.pDraw     = ctx.pixels.pointer();
+		ctx.uDrawResX = ctx.uResX;
+		ctx.uDrawResY = ctx.uResY;
+	}
+
+	// Clip rectangles depend on the size
+	ctx.bStateChanged = true;
+}
+
+static F32 readComponent( const U8 *p, EVectorType ty, Bool bNormalized ) {
+	switch( ty ) {
+	case kVectorTypeF16: {
+		U16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return F32( F16::fromBits( x ) );
+	}
+	case kVectorTypeU16_UNorm: {
+		U16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return F32( x )/65535.0f;
+	}
+	case kVectorTypeU8:
+		return bNormalized ? F32( *p )/255.0f : F32( *p );
+	case kVectorTypeS8:
+		return bNormalized ? F32( S8( *p ) )/127.0f : F32( S8( *p ) );
+	case kVectorTypeU16: {
+		U16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return bNormalized ? F32( x )/65535.0f : F32( x );
+	}
+	case kVectorTypeS16: {
+		S16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return bNormalized ? F32( x )/32767.0f : F32( x );
+	}
+	case kVectorTypeU32: {
+		U32 x;
+		memcpy( &x, p, sizeof( x ) );
+		return bNormalized ? F32( F64( x )/4294967295.0 ) : F32( x );
+	}
+	case kVectorTypeS32: {
+		S32 x;
+		memcpy( &x, p, sizeof( x ) );
+		return bNormalized ? F32( F64( x )/2147483647.0 ) : F32( x );
+	}
+	case kVectorTypeF32:
+	case kVectorTypeF32_SNorm:
+	case kVectorTypeF32_UNorm: {
+		F32 x;
+		memcpy( &x, p, sizeof( x ) );
+		return x;
+	}
+	}
+
+	return 0.0f;
+}
+
+// Read and transform vertex `uIndex` of the bound vertex buffer, with the
+// per-instance elements of instance `uInstance`
+static Bool fetchVertex( const SSoftContext &ctx, U32 uIndex, U32 uInstance, SSoftVertex &dst ) {
+	AX_ASSERT_NOT_NULL( ctx.pLayout );
+	AX_ASSERT_NOT_NULL( ctx.pVBuf );
+
+	const SGfxLayout &layout = *ctx.pLayout;
+	const UPtr vertexBase = UPtr( uIndex )*layout.stride;
+
+	F32 pos[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	dst.attrs[kSoftAttrR] = 1.0f;
+	dst.attrs[kSoftAttrG] = 1.0f;
+	dst.attrs[kSoftAttrB] = 1.0f;
+	dst.attrs[kSoftAttrA] = 1.0f;
+	dst.attrs[kSoftAttrU] = 0.0f;
+	dst.attrs[kSoftAttrV] = 0.0f;
+
+	Bool bHaveTexCoord = false;
+
+	// Quad rectangles the position picks a corner of
+	F32 rect[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	F32 texRect[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	Bool bHaveRect = false;
+	Bool bHaveTexRect = false;
+
+	for( UPtr i = 0; i < layout.cElements; ++i ) {
+		const SGfxLayoutElement &q = layout.elements[i];
+
+		if( q.uStepRate != 0 && !ctx.pInstBuf ) {
+			return false;
+		}
+
+		const TMutArr<U8> &data = q.uStepRate != 0 ? ctx.pInstBuf->data : ctx.pVBuf->data;
+		const UPtr base = q.uStepRate != 0 ? UPtr( uInstance/q.uStepRate )*layout.instanceStride : vertexBase;
+		if( base + q.uOffset + q.cBytes > data.num() ) {
+			return false;
+		}
+
+		const U8 *const p = data.pointer() + base + q.uOffset;
+		const UPtr cComps = UPtr( q.cComps ) < 4 ? UPtr( q.cComps ) : 4;
+		const UPtr cCompBytes = q.cBytes/UPtr( q.cComps );
+
+		switch( q.type ) {
+		case kGfxLayoutElementVertex:
+			for( UPtr c = 0; c < cComps; ++c ) {
+				pos[c] = readComponent( p + c*cCompBytes, q.compTy, false );
+			}
+			break;
+
+		case kGfxLayoutElementColor:
+			for( UPtr c = 0; c < cComps; ++c ) {
+				dst.attrs[kSoftAttrR + c] = readComponent( p + c*cCompBytes, q.compTy, true );
+			}
+			break;
+
+		case kGfxLayoutElementTexCoord:
+			// Only stage 0 is sampled
+			if( bHaveTexCoord ) {
+				break;
+			}
+			bHaveTexCoord = true;
+
+			for( UPtr c = 0; c < cComps && c < 2; ++c ) {
+				dst.attrs[kSoftAttrU + c] = readComponent( p + c*cCompBytes, q.compTy, false );
+			}
+			break;
+
+		case kGfxLayoutElementVertexRect:
+			bHaveRect = true;
+			for( UPtr c = 0; c < cComps; ++c ) {
+				rect[c] = readComponent( p + c*cCompBytes, q.compTy, false );
+			}
+			break;
+
+		case kGfxLayoutElementTexCoordRect:
+			// Takes a stage like other texture coordinates
+			if( bHaveTexCoord ) {
+				break;
+			}
+			bHaveTexCoord = true;
+			bHaveTexRect = true;
+
+			for( UPtr c = 0; c < cComps; ++c ) {
+				texRect[c] = readComponent( p + c*cCompBytes, q.compTy, false );
+			}
+			break;
+
+		case kGfxLayoutElementNormal:
+			// No lighting
+			break;
+		}
+	}
+
+	// Weighted so corners of 0 and 1 give the rectangle's edges exactly
+	const F32 corner[2] = { pos[0], pos[1] };
+	if( bHaveRect ) {
+		pos[0] = rect[0]*( 1.0f - corner[0] ) + rect[2]*corner[0];
+		pos[1] = rect[1]*( 1.0f - corner[1] ) + rect[3]*corner[1];
+	}
+	if( bHaveTexRect ) {
+		dst.attrs[kSoftAttrU] = texRect[0]*( 1.0f - corner[0] ) + texRect[2]*corner[0];
+		dst.attrs[kSoftAttrV] = texRect[1]*( 1.0f - corner[1] ) + texRect[3]*corner[1];
+	}
+
+	V128 clip = vecScale( ctx.mvp[0], pos[0] );
+	clip = vecAdd( clip, vecScale( ctx.mvp[1], pos[1] ) );
+	clip = vecAdd( clip, vecScale( ctx.mvp[2], pos[2] ) );
+	clip = vecAdd( clip, vecScale( ctx.mvp[3], pos[3] ) );
+
+	DOLL_VECALIGN F32 clipOut[4];
+	vecStore( clipOut, clip );
+
+	dst.clip[0] = clipOut[0];
+	dst.clip[1] = clipOut[1];
+	dst.clip[2] = clipOut[2];
+	dst.clip[3] = clipOut[3];
+
+	return true;
+}
+
+//====================================================================//
+
+static Void flushSoft( SSoftContext &ctx );
+
+// Index of the current state in ctx.states, adding it if it changed (~0U if
+// out of memory)
+static U32 captureState( SSoftContext &ctx ) {
+	if( !ctx.bStateChanged && ctx.states.isUsed() ) {
+		return U32( ctx.states.num() - 1 );
+	}
+
+	SSoftDrawState state;
+
+	state.pTexture = ctx.bTexture ? ctx.pTextures[0] : nullptr;
+	if( ctx.pSamplers[0] != nullptr ) {
+		state.sampler = *ctx.pSamplers[0];
+	} else {
+		// Textures are created with these in the GL backend
+		state.sampler.magFilter   = kTexFilterNearest;
+		state.sampler.minFilter   = kTexFilterNearest;
+		state.sampler.wrapU       = kTexWrapRepeat;
+		state.sampler.wrapV       = kTexWrapRepeat;
+		state.sampler.borderColor = 0;
+	}
+
+	state.blendOp    = ctx.blendOp;
+	state.colA       = ctx.colA;
+	state.colB       = ctx.colB;
+	state.alphaA     = ctx.alphaA;
+	state.alphaB     = ctx.alphaB;
+	state.bAlphaTest = ctx.bAlphaTest;
+
+	state.clip = ctx.viewport.intersect( makeRect( 0, 0, ctx.uDrawResX, ctx.uDrawResY ) );
+	if( ctx.bScissor ) {
+		state.clip = state.clip.intersect( ctx.scissor );
+	}
+
+	ctx.bStateChanged = false;
+
+	if( ctx.states.isUsed() && isSameState( ctx.states[ctx.states.num() - 1], state ) ) {
+		return U32( ctx.states.num() - 1 );
+	}
+	if( !AX_VERIFY_MEMORY( ctx.states.append( state ) ) ) {
+		ctx.bStateChanged = true;
+		return ~0U;
+	}
+
+	return U32( ctx.states.num() - 1 );
+}
+
+// Make room for another triangle, flushing if too many are pending; the
+// flush drops the recorded states, so `uState` is captured again
+static Bool reserveTriangle( SSoftContext &ctx, U32 &uState ) {
+	if( ctx.tris.num() < kSoftMaxPendingTris ) {
+		return true;
+	}
+
+	flushSoft( ctx );
+
+	uState = captureState( ctx );
+	return uState != ~0U;
+}
+
+static S32 toFixed( F32 f ) {
+	const F32 x = f*F32( kSoftSubpixels );
+	return S32( x < 0.0f ? x - 0.5f : x + 0.5f );
+}
+
+// Set up a clipped triangle and add it to the pending work
+static Bool setupTriangle( SSoftContext &ctx, U32 &uState, const SSoftVertex &a, const SSoftVertex &b, const SSoftVertex &c ) {
+	const SSoftVertex *const verts[3] = { &a, &b, &c };
+
+	const SSoftRect &vp = ctx.viewport;
+	const F32 halfW = 0.5f*F32( vp.x1 - vp.x0 );
+	const F32 halfH = 0.5f*F32( vp.y1 - vp.y0 );
+
+	F32 invW[3];
+	S32 fx[3], fy[3];
+	for( U32 i = 0; i < 3; ++i ) {
+		const SSoftVertex &v = *verts[i];
+
+		invW[i] = 1.0f/v.clip[3];
+
+		const F32 sx = F32( vp.x0 ) + ( v.clip[0]*invW[i] + 1.0f )*halfW;
+		const F32 sy = F32( vp.y0 ) + ( 1.0f - v.clip[1]*invW[i] )*halfH;
+
+		// Only from a huge viewport or NaNs; nothing sensible to draw
+		if( !( sx > -kSoftMaxCoord && sx < kSoftMaxCoord && sy > -kSoftMaxCoord && sy < kSoftMaxCoord ) ) {
+			return true;
+		}
+
+		fx[i] = toFixed( sx );
+		fy[i] = toFixed( sy );
+	}
+
+	// Order the vertices so the (y down) area is positive; culling is off
+	U32 ord[3] = { 0, 1, 2 };
+	S64 area = S64( fx[1] - fx[0] )*S64( fy[2] - fy[0] ) - S64( fx[2] - fx[0] )*S64( fy[1] - fy[0] );
+	if( area == 0 ) {
+		return true;
+	}
+	if( area < 0 ) {
+		ord[1] = 2;
+		ord[2] = 1;
+		area = -area;
+	}
+
+	// Copied, as a flush in reserveTriangle() resets the recorded states
+	const SSoftDrawState state = ctx.states[uState];
+
+	S32 minX = fx[0], maxX = fx[0];
+	S32 minY = fy[0], maxY = fy[0];
+	for( U32 i = 1; i < 3; ++i ) {
+		minX = fx[i] < minX ? fx[i] : minX;
+		maxX = fx[i] > maxX ? fx[i] : maxX;
+		minY = fy[i] < minY ? fy[i] : minY;
+		maxY = fy[i] > maxY ? fy[i] : maxY;
+	}
+
+	// Pixel centers are at +0.5
+	const S64 kHalf = kSoftSubpixels/2;
+	SSoftRect bounds;
+	bounds.x0 = S32( ceilDiv( S64( minX ) - kHalf, kSoftSubpixels ) );
+	bounds.y0 = S32( ceilDiv( S64( minY ) - kHalf, kSoftSubpixels ) );
+	bounds.x1 = S32( floorDiv( S64( maxX ) - kHalf, kSoftSubpixels ) ) + 1;
+	bounds.y1 = S32( floorDiv( S64( maxY ) - kHalf, kSoftSubpixels ) ) + 1;
+
+	bounds = bounds.intersect( state.clip );
+	if( bounds.isEmpty() ) {
+		return true;
+	}
+
+	if( !reserveTriangle( ctx, uState ) ) {
+		return false;
+	}
+
+	SSoftTriangle tri;
+	tri.bounds = bounds;
+	tri.uState = uState;
+
+	// Edge k runs between the two vertices other than vertex k
+	for( U32 k = 0; k < 3; ++k ) {
+		const U32 i = ord[( k + 1 )%3];
+		const U32 j = ord[( k + 2 )%3];
+
+		const S64 A = S64( fy[i] ) - S64( fy[j] );
+		const S64 B = S64( fx[j] ) - S64( fx[i] );
+
+		tri.edgeA[k] = A;
+		tri.edgeB[k] = B;
+		tri.edgeC[k] = -( A*fx[i] + B*fy[i] );
+
+		// Top-left fill rule: samples exactly on other edges are outside
+		if( !( A > 0 || ( A == 0 && B > 0 ) ) ) {
+			tri.edgeC[k] -= 1;
+		}
+	}
+
+	// Attribute planes
+	const U32 i0 = ord[0], i1 = ord[1], i2 = ord[2];
+	const F32 x0 = F32( fx[i0] )/F32( kSoftSubpixels );
+	const F32 y0 = F32( fy[i0] )/F32( kSoftSubpixels );
+	const F32 dx1 = F32( fx[i1] - fx[i0] )/F32( kSoftSubpixels );
+	const F32 dy1 = F32( fy[i1] - fy[i0] )/F32( kSoftSubpixels );
+	const F32 dx2 = F32( fx[i2] - fx[i0] )/F32( kSoftSubpixels );
+	const F32 dy2 = F32( fy[i2] - fy[i0] )/F32( kSoftSubpixels );
+	const F32 invDet = 1.0f/( dx1*dy2 - dx2*dy1 );
+
+	const F32 ox = F32( bounds.x0 ) + 0.5f - x0;
+	const F32 oy = F32( bounds.y0 ) + 0.5f - y0;
+
+	tri.bPerspective = !( invW[0] == invW[1] && invW[1] == invW[2] );
+
+	for( U32 n = 0; n < kSoftNumAttrs; ++n ) {
+		F32 f[3];
+		for( U32 i = 0; i < 3; ++i ) {
+			const U32 v = ord[i];
+			if( n == kSoftAttrInvW ) {
+				f[i] = invW[v];
+			} else {
+				f[i] = tri.bPerspective ? verts[v]->attrs[n]*invW[v] : verts[v]->attrs[n];
+			}
+		}
+
+		const F32 df1 = f[1] - f[0];
+		const F32 df2 = f[2] - f[0];
+		const F32 dfdx = ( df1*dy2 - df2*dy1 )*invDet;
+		const F32 dfdy = ( df2*dx1 - df1*dx2 )*invDet;
+
+		tri.attrs[n][0] = f[0] + dfdx*ox + dfdy*oy;
+		tri.attrs[n][1] = dfdx;
+		tri.attrs[n][2] = dfdy;
+	}
+
+	// Pick the sampler filter by whether the texture is shrunk (measured at
+	// the first vertex for perspective correct triangles)
+	tri.bLinear = false;
+	if( state.pTexture != nullptr ) {
+		const F32 w = tri.bPerspective ? 1.0f/invW[i0] : 1.0f;
+		const F32 dudx = tri.attrs[kSoftAttrU][1]*w*F32( state.pTexture->uResX );
+		const F32 dudy = tri.attrs[kSoftAttrU][2]*w*F32( state.pTexture->uResX );
+		const F32 dvdx = tri.attrs[kSoftAttrV][1]*w*F32( state.pTexture->uResY );
+		const F32 dvdy = tri.attrs[kSoftAttrV][2]*w*F32( state.pTexture->uResY );
+		const Bool bMinify = dudx*dudx + dvdx*dvdx > 1.0f || dudy*dudy + dvdy*dvdy > 1.0f;
+
+		tri.bLinear = ( bMinify ? state.sampler.minFilter : state.sampler.magFilter ) == kTexFilterLinear;
+	}
+
+	if( !AX_VERIFY_MEMORY( ctx.tris.append( tri ) ) ) {
+		return false;
+	}
+	if( !AX_VERIFY_MEMORY( ctx.cmds.append( U32( ctx.tris.num() - 1 ) ) ) ) {
+		ctx.tris.resize( ctx.tris.num() - 1 );
+		return false;
+	}
+
+	return true;
+}
+
+static Void lerpVertex( SSoftVertex &dst, const SSoftVertex &a, const SSoftVertex &b, F32 t ) {
+	for( U32 i = 0; i < 4; ++i ) {
+		dst.clip[i] = a.clip[i] + ( b.clip[i] - a.clip[i] )*t;
+	}
+	for( U32 i = 0; i < kSoftNumVertAttrs; ++i ) {
+		dst.attrs[i] = a.attrs[i] + ( b.attrs[i] - a.attrs[i] )*t;
+	}
+}
+// Distance of `v` inside clip plane `uPlane` (negative if outside)
+static F32 clipDistance( const SSoftVertex &v, U32 uPlane ) {
+	const F32 *const c = v.clip;
+
+	switch( uPlane ) {
+	case 0:
+		return c[3] - kSoftMinW;
+	case 1:
+		return kSoftGuardBand*c[3] - c[0];
+	case 2:
+		return kSoftGuardBand*c[3] + c[0];
+	case 3:
+		return kSoftGuardBand*c[3] - c[1];
+	case 4:
+		return kSoftGuardBand*c[3] + c[1];
+	}
+
+	return 0.0f;
+}
+static const U32 kSoftNumClipPlanes = 5;
+
+// Clip a triangle against the guard band and set up what's left
+static Bool clipTriangle( SSoftContext &ctx, U32 &uState, const SSoftVertex &a, const SSoftVertex &b, const SSoftVertex &c ) {
+	U32 uOutside = 0;
+	for( U32 p = 0; p < kSoftNumClipPlanes; ++p ) {
+		const Bool bA = clipDistance( a, p ) < 0.0f;
+		const Bool bB = clipDistance( b, p ) < 0.0f;
+		const Bool bC = clipDistance( c, p ) < 0.0f;
+
+		if( bA && bB && bC ) {
+			return true;
+		}
+		if( bA || bB || bC ) {
+			uOutside |= 1U<<p;
+		}
+	}
+
+	if( !uOutside ) {
+		return setupTriangle( ctx, uState, a, b, c );
+	}
+
+	// Each plane adds at most one vertex
+	SSoftVertex polys[2][3 + kSoftNumClipPlanes];
+	U32 cVerts = 3;
+	polys[0][0] = a;
+	polys[0][1] = b;
+	polys[0][2] = c;
+
+	U32 uSrc = 0;
+	for( U32 p = 0; p < kSoftNumClipPlanes && cVerts >= 3; ++p ) {
+		if( !( uOutside & ( 1U<<p ) ) ) {
+			continue;
+		}
+
+		const SSoftVertex *const src = polys[uSrc];
+		SSoftVertex *const dst = polys[uSrc ^ 1];
+		U32 cDst = 0;
+
+		for( U32 i = 0; i < cVerts; ++i ) {
+			const SSoftVertex &v0 = src[i];
+			const SSoftVertex &v1 = src[( i + 1 )%cVerts];
+			const F32 d0 = clipDistance( v0, p );
+			const F32 d1 = clipDistance( v1, p );
+
+			if( d0 >= 0.0f ) {
+				dst[cDst++] = v0;
+			}
+			if( ( d0 >= 0.0f ) != ( d1 >= 0.0f ) ) {
+				lerpVertex( dst[cDst++], v0, v1, d0/( d0 - d1 ) );
+			}
+		}
+
+		cVerts = cDst;
+		uSrc ^= 1;
+	}
+
+	for( U32 i = 2; i < cVerts; ++i ) {
+		if( !setupTriangle( ctx, uState, polys[uSrc][0], polys[uSrc][i - 1], polys[uSrc][i] ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Lines and points become screen aligned quads (one pixel wide)
+static Bool expandLine( SSoftContext &ctx, U32 &uState, const SSoftVertex &a, const SSoftVertex &b ) {
+	if( a.clip[3] < kSoftMinW || b.clip[3] < kSoftMinW ) {
+		return true;
+	}
+
+	const F32 pixelX = 2.0f/F32( ctx.viewport.x1 - ctx.viewport.x0 );
+	const F32 pixelY = 2.0f/F32( ctx.viewport.y1 - ctx.viewport.y0 );
+
+	// Direction in pixels
+	const F32 dx = ( b.clip[0]/b.clip[3] - a.clip[0]/a.clip[3] )/pixelX;
+	const F32 dy = ( b.clip[1]/b.clip[3] - a.clip[1]/a.clip[3] )/pixelY;
+	const F32 len = sqrt( dx*dx + dy*dy );
+	if( !( len > 0.0f ) ) {
+		return true;
+	}
+
+	// Half a pixel to each side
+	const F32 nx = -dy/len*0.5f*pixelX;
+	const F32 ny =  dx/len*0.5f*pixelY;
+
+	SSoftVertex q[4] = { a, a, b, b };
+	q[0].clip[0] += nx*a.clip[3];
+	q[0].clip[1] += ny*a.clip[3];
+	q[1].clip[0] -= nx*a.clip[3];
+	q[1].clip[1] -= ny*a.clip[3];
+	q[2].clip[0] -= nx*b.clip[3];
+	q[2].clip[1] -= ny*b.clip[3];
+	q[3].clip[0] += nx*b.clip[3];
+	q[3].clip[1] += ny*b.clip[3];
+
+	return clipTriangle( ctx, uState, q[0], q[1], q[2] ) && clipTriangle( ctx, uState, q[0], q[2], q[3] );
+}
+static Bool expandPoint( SSoftContext &ctx, U32 &uState, const SSoftVertex &a ) {
+	if( a.clip[3] < kSoftMinW ) {
+		return true;
+	}
+
+	const F32 hx = a.clip[3]/F32( ctx.viewport.x1 - ctx.viewport.x0 );
+	const F32 hy = a.clip[3]/F32( ctx.viewport.y1 - ctx.viewport.y0 );
+
+	SSoftVertex q[4] = { a, a, a, a };
+	q[0].clip[0] -= hx;
+	q[0].clip[1] += hy;
+	q[1].clip[0] += hx;
+	q[1].clip[1] += hy;
+	q[2].clip[0] += hx;
+	q[2].clip[1] -= hy;
+	q[3].clip[0] -= hx;
+	q[3].clip[1] -= hy;
+
+	return clipTriangle( ctx, uState, q[0], q[1], q[2] ) && clipTriangle( ctx, uState, q[0], q[2], q[3] );
+}
+
+// Turns a stream of vertex indexes into primitives
+class CSoftAssembler {
+public:
+	CSoftAssembler( SSoftContext &ctx, ETopology topology )
+	: m_ctx( ctx )
+	, m_topology( topology )
+	, m_uState( captureState( ctx ) )
+	, m_cVerts( 0 )
+	, m_bFailed( m_uState == ~0U )
+	, m_bBadIndex( false )
+	, m_uInstance( 0 )
+	{
+		for( U32 i = 0; i < kSoftVertexCacheSize; ++i ) {
+			m_cacheKeys[i] = ~0U;
+		}
+	}
+
+	// Start over with another instance (primitives don't span instances)
+	Void setInstance( U32 uInstance ) {
+		m_uInstance = uInstance;
+		m_cVerts    = 0;
+
+		for( U32 i = 0; i < kSoftVertexCacheSize; ++i ) {
+			m_cacheKeys[i] = ~0U;
+		}
+	}
+
+	Bool isOk() const {
+		return !m_bFailed;
+	}
+	// Whether an index was outside the vertex buffer
+	Bool hadBadIndex() const {
+		return m_bBadIndex;
+	}
+
+	Void push( U32 uIndex ) {
+		if( m_bFailed ) {
+			return;
+		}
+
+		const SSoftVertex *const pVert = getVertex( uIndex );
+		if( !pVert ) {
+			// Drop the primitive this vertex was part of and start over
+			m_bBadIndex = true;
+			m_cVerts    = 0;
+			return;
+		}
+
+		switch( m_topology ) {
+		case kTopologyPointList:
+			m_bFailed = !expandPoint( m_ctx, m_uState, *pVert );
+			break;
+
+		case kTopologyLineList:
+			m_window[m_cVerts++] = *pVert;
+			if( m_cVerts == 2 ) {
+				m_bFailed = !expandLine( m_ctx, m_uState, m_window[0], m_window[1] );
+				m_cVerts  = 0;
+			}
+			break;
+
+		case kTopologyLineStrip:
+			m_window[m_cVerts++] = *pVert;
+			if( m_cVerts == 2 ) {
+				m_bFailed   = !expandLine( m_ctx, m_uState, m_window[0], m_window[1] );
+				m_window[0] = m_window[1];
+				m_cVerts    = 1;
+			}
+			break;
+
+		case kTopologyTriangleList:
+			m_window[m_cVerts++] = *pVert;
+			if( m_cVerts == 3 ) {
+				m_bFailed = !clipTriangle( m_ctx, m_uState, m_window[0], m_window[1], m_window[2] );
+				m_cVerts  = 0;
+			}
+			break;
+
+		case kTopologyTriangleStrip:
+			m_window[m_cVerts++] = *pVert;
+			if( m_cVerts == 3 ) {
+				// Winding doesn't matter without culling, so no need to
+				// flip every other triangle
+				m_bFailed   = !clipTriangle( m_ctx, m_uState, m_window[0], m_window[1], m_window[2] );
+				m_window[0] = m_window[1];
+				m_window[1] = m_window[2];
+				m_cVerts    = 2;
+			}
+			break;
+
+		case kTopologyTriangleFan:
+			m_window[m_cVerts++] = *pVert;
+			if( m_cVerts == 3 ) {
+				m_bFailed   = !clipTriangle( m_ctx, m_uState, m_window[0], m_window[1], m_window[2] );
+				m_window[1] = m_window[2];
+				m_cVerts    = 2;
+			}
+			break;
+		}
+	}
+
+private:
+	SSoftContext &m_ctx;
+	const ETopology m_topology;
+	U32 m_uState;
+
+	// Vertexes of the primitive being assembled
+	SSoftVertex m_window[3];
+	U32 m_cVerts;
+	Bool m_bFailed;
+	Bool m_bBadIndex;
+	U32 m_uInstance;
+
+	// Direct mapped post-transform cache (for indexed draws reusing vertexes)
+	U32 m_cacheKeys[kSoftVertexCacheSize];
+	SSoftVertex m_cache[kSoftVertexCacheSize];
+
+	const SSoftVertex *getVertex( U32 uIndex ) {
+		const U32 uSlot = uIndex & ( kSoftVertexCacheSize - 1 );
+		if( m_cacheKeys[uSlot] == uIndex ) {
+			return &m_cache[uSlot];
+		}
+
+		if( !fetchVertex( m_ctx, uIndex, m_uInstance, m_cache[uSlot] ) ) {
+			m_cacheKeys[uSlot] = ~0U;
+			return nullptr;
+		}
+
+		m_cacheKeys[uSlot] = uIndex;
+		return &m_cache[uSlot];
+	}
+};
+
+//====================================================================//
+
+static U32 wrapTexel( S32 i, U32 n, ETextureWrap wrap, Bool &bBorder ) {
+	const S32 c = S32( n );
+
+	switch( wrap ) {
+	case kTexWrapRepeat: {
+		const S32 m = i%c;
+		return U32( m < 0 ? m + c : m );
+	}
+	case kTexWrapMirror: {
+		S32 m = i%( c*2 );
+		if( m < 0 ) {
+			m += c*2;
+		}
+		return U32( m < c ? m : c*2 - 1 - m );
+	}
+	case kTexWrapClamp:
+		return U32( i < 0 ? 0 : i >= c ? c - 1 : i );
+	case kTexWrapBorder:
+		if( i < 0 || i >= c ) {
+			bBorder = true;
+			return 0;
+		}
+		return U32( i );
+	}
+
+	return 0;
+}
+static U32 fetchTexel( const SSoftTexture &tex, const SSoftSampler &ss, S32 x, S32 y ) {
+	Bool bBorder = false;
+	const U32 u = wrapTexel( x, tex.uResX, ss.wrapU, bBorder );
+	const U32 v = wrapTexel( y, tex.uResY, ss.wrapV, bBorder );
+
+	return bBorder ? ss.borderColor : tex.texels[UPtr( v )*tex.uResX + u];
+}
+// Mix two packed colors; `w` is the weight of `b` out of 256
+static U32 lerpTexel( U32 a, U32 b, U32 w ) {
+	const U32 rb = ( ( a & 0x00FF00FF )*( 256 - w ) + ( b & 0x00FF00FF )*w ) >> 8;
+	const U32 ag = ( ( ( a >> 8 ) & 0x00FF00FF )*( 256 - w ) + ( ( b >> 8 ) & 0x00FF00FF )*w );
+
+	return ( rb & 0x00FF00FF ) | ( ag & 0xFF00FF00 );
+}
+static U32 sampleTexture( const SSoftTexture &tex, const SSoftSampler &ss, Bool bLinear, F32 u, F32 v ) {
+	const F32 fu = u*F32( tex.uResX );
+	const F32 fv = v*F32( tex.uResY );
+
+	if( !bLinear ) {
+		return fetchTexel( tex, ss, floorToInt( fu ), floorToInt( fv ) );
+	}
+
+	const F32 su = fu - 0.5f;
+	const F32 sv = fv - 0.5f;
+	const S32 x = floorToInt( su );
+	const S32 y = floorToInt( sv );
+	const U32 wx = U32( ( su - F32( x ) )*256.0f );
+	const U32 wy = U32( ( sv - F32( y ) )*256.0f );
+
+	const U32 top = lerpTexel( fetchTexel( tex, ss, x, y     ), fetchTexel( tex, ss, x + 1, y     ), wx );
+	const U32 bot = lerpTexel( fetchTexel( tex, ss, x, y + 1 ), fetchTexel( tex, ss, x + 1, y + 1 ), wx );
+
+	return lerpTexel( top, bot, wy );
+}
+
+// Four pixels' worth of one channel per vector
+struct SSoftQuad {
+	V128 r, g, b, a;
+};
+
+static Void unpackQuad( SSoftQuad &dst, const U32 ( &px )[4] ) {
+	DOLL_VECALIGN F32 ch[4][4];
+	for( U32 i = 0; i < 4; ++i ) {
+		ch[0][i] = F32( DOLL_COLOR_R( px[i] ) );
+		ch[1][i] = F32( DOLL_COLOR_G( px[i] ) );
+		ch[2][i] = F32( DOLL_COLOR_B( px[i] ) );
+		ch[3][i] = F32( DOLL_COLOR_A( px[i] ) );
+	}
+
+	const F32 kScale = 1.0f/255.0f;
+	dst.r = vecScale( vecLoad( ch[0] ), kScale );
+	dst.g = vecScale( vecLoad( ch[1] ), kScale );
+	dst.b = vecScale( vecLoad( ch[2] ), kScale );
+	dst.a = vecScale( vecLoad( ch[3] ), kScale );
+}
+static Void packQuad( U32 ( &px )[4], const SSoftQuad &src ) {
+	const V128 zero = vecZero();
+	const V128 one = vecSet1( 1.0f );
+
+	DOLL_VECALIGN F32 ch[4][4];
+	vecStore( ch[0], vecMin( vecMax( src.r, zero ), one ) );
+	vecStore( ch[1], vecMin( vecMax( src.g, zero ), one ) );
+	vecStore( ch[2], vecMin( vecMax( src.b, zero ), one ) );
+	vecStore( ch[3], vecMin( vecMax( src.a, zero ), one ) );
+
+	for( U32 i = 0; i < 4; ++i ) {
+		px[i] = DOLL_RGBA(
+			U32( ch[0][i]*255.0f + 0.5f ),
+			U32( ch[1][i]*255.0f + 0.5f ),
+			U32( ch[2][i]*255.0f + 0.5f ),
+			U32( ch[3][i]*255.0f + 0.5f ) );
+	}
+}
+
+static V128 blendFactor( EBlendFactor f, P_V128 src, P_V128 srcA, P_V128 dst, P_V128 dstA ) {
+	switch( f ) {
+	case kBlendZero:
+		return vecZero();
+	case kBlendOne:
+		return vecSet1( 1.0f );
+	case kBlendSrcColor:
+		return src;
+	case kBlendSrcAlpha:
+		return srcA;
+	case kBlendDstColor:
+		return dst;
+	case kBlendDstAlpha:
+		return dstA;
+	case kBlendInvSrcColor:
+		return vecSub( vecSet1( 1.0f ), src );
+	case kBlendInvSrcAlpha:
+		return vecSub( vecSet1( 1.0f ), srcA );
+	case kBlendInvDstColor:
+		return vecSub( vecSet1( 1.0f ), dst );
+	case kBlendInvDstAlpha:
+		return vecSub( vecSet1( 1.0f ), dstA );
+	}
+
+	return vecZero();
+}
+static V128 blendChannel( EBlendOp op, P_V128 src, P_V128 srcFactor, P_V128 dst, P_V128 dstFactor ) {
+	switch( op ) {
+	case kBlendAdd:
+		return vecAdd( vecMul( src, srcFactor ), vecMul( dst, dstFactor ) );
+	case kBlendSub:
+		return vecSub( vecMul( src, srcFactor ), vecMul( dst, dstFactor ) );
+	case kBlendRevSub:
+		return vecSub( vecMul( dst, dstFactor ), vecMul( src, srcFactor ) );
+	case kBlendMin:
+		return vecMin( src, dst );
+	case kBlendMax:
+		return vecMax( src, dst );
+
+	default:
+		break;
+	}
+
+	return src;
+}
+static Bool isLogicalOp( EBlendOp op ) {
+	return op >= kBlendLogicalClear;
+}
+static U32 logicalOp( EBlendOp op, U32 s, U32 d ) {
+	switch( op ) {
+	case kBlendLogicalClear:
+		return 0;
+	case kBlendLogicalSet:
+		return ~0U;
+	case kBlendLogicalCopy:
+		return s;
+	case kBlendLogicalCopyInverted:
+		return ~s;
+	case kBlendLogicalNop:
+		return d;
+	case kBlendLogicalInvert:
+		return ~d;
+	case kBlendLogicalAnd:
+		return s & d;
+	case kBlendLogicalNand:
+		return ~( s & d );
+	case kBlendLogicalOr:
+		return s | d;
+	case kBlendLogicalNor:
+		return ~( s | d );
+	case kBlendLogicalXor:
+		return s ^ d;
+	case kBlendLogicalEquiv:
+		return ~( s ^ d );
+	case kBlendLogicalAndReverse:
+		return s & ~d;
+	case kBlendLogicalAndInverted:
+		return ~s & d;
+	case kBlendLogicalOrReverse:
+		return s | ~d;
+	case kBlendLogicalOrInverted:
+		return ~s | d;
+
+	default:
+		break;
+	}
+
+	return s;
+}
+// Whether the blend just replaces the destination
+static Bool isOpaqueBlend( const SSoftDrawState &state ) {
+	return
+		state.blendOp == kBlendAdd &&
+		state.colA == kBlendOne && state.colB == kBlendZero &&
+		state.alphaA == kBlendOne && state.alphaB == kBlendZero;
+}
+
+// Blend four shaded pixels into `pDst` (only the lanes set in `uMask`)
+static Void blendQuad( const SSoftDrawState &state, U32 *pDst, U32 uMask, const SSoftQuad &src ) {
+	U32 dstPx[4] = { 0, 0, 0, 0 };
+	U32 outPx[4];
+
+	// Opaque draws don't need the destination
+	if( !isOpaqueBlend( state ) ) {
+		for( U32 i = 0; i < 4; ++i ) {
+			if( uMask & ( 1U<<i ) ) {
+				dstPx[i] = pDst[i];
+			}
+		}
+	}
+
+	if( isOpaqueBlend( state ) ) {
+		packQuad( outPx, src );
+	} else if( isLogicalOp( state.blendOp ) ) {
+		packQuad( outPx, src );
+		for( U32 i = 0; i < 4; ++i ) {
+			outPx[i] = logicalOp( state.blendOp, outPx[i], dstPx[i] );
+		}
+	} else {
+		SSoftQuad dst;
+		unpackQuad( dst, dstPx );
+
+		SSoftQuad out;
+		out.r = blendChannel( state.blendOp,
+			src.r, blendFactor( state.colA, src.r, src.a, dst.r, dst.a ),
+			dst.r, blendFactor( state.colB, src.r, src.a, dst.r, dst.a ) );
+		out.g = blendChannel( state.blendOp,
+			src.g, blendFactor( state.colA, src.g, src.a, dst.g, dst.a ),
+			dst.g, blendFactor( state.colB, src.g, src.a, dst.g, dst.a ) );
+		out.b = blendChannel( state.blendOp,
+			src.b, blendFactor( state.colA, src.b, src.a, dst.b, dst.a ),
+			dst.b, blendFactor( state.colB, src.b, src.a, dst.b, dst.a ) );
+		out.a = blendChannel( state.blendOp,
+			src.a, blendFactor( state.alphaA, src.a, src.a, dst.a, dst.a ),
+			dst.a, blendFactor( state.alphaB, src.a, src.a, dst.a, dst.a ) );
+
+		packQuad( outPx, out );
+	}
+
+	for( U32 i = 0; i < 4; ++i ) {
+		if( uMask & ( 1U<<i ) ) {
+			pDst[i] = outPx[i];
+		}
+	}
+}
+
+// Shade and blend pixels [x0,x1) of row `y`
+static Void shadeSpan( SSoftContext &ctx, const SSoftTriangle &tri, const SSoftDrawState &state, S32 y, S32 x0, S32 x1 ) {
+	U32 *const pRow = ctx.pDraw + UPtr( y )*ctx.uDrawResX;
+
+	const F32 fx = F32( x0 - tri.bounds.x0 );
+	const F32 fy = F32( y - tri.bounds.y0 );
+
+	// Each attribute for the first four pixels, and the step to the next four
+	V128 attrs[kSoftNumAttrs];
+	V128 steps[kSoftNumAttrs];
+	const U32 cAttrs = tri.bPerspective ? U32( kSoftNumAttrs ) : U32( kSoftNumVertAttrs );
+	for( U32 n = 0; n < cAttrs; ++n ) {
+		const F32 *const plane = tri.attrs[n];
+		const F32 start = plane[0] + plane[1]*fx + plane[2]*fy;
+
+		attrs[n] = vecSet( start, start + plane[1], start + 2.0f*plane[1], start + 3.0f*plane[1] );
+		steps[n] = vecSet1( 4.0f*plane[1] );
+	}
+
+	const V128 one = vecSet1( 1.0f );
+
+	for( S32 x = x0; x < x1; x += 4 ) {
+		const S32 cLanes = x1 - x < 4 ? x1 - x : 4;
+		U32 uMask = ( 1U<<cLanes ) - 1;
+
+		SSoftQuad color;
+		V128 u, v;
+		if( tri.bPerspective ) {
+			const V128 w = vecDiv( one, attrs[kSoftAttrInvW] );
+
+			color.r = vecMul( attrs[kSoftAttrR], w );
+			color.g = vecMul( attrs[kSoftAttrG], w );
+			color.b = vecMul( attrs[kSoftAttrB], w );
+			color.a = vecMul( attrs[kSoftAttrA], w );
+			u = vecMul( attrs[kSoftAttrU], w );
+			v = vecMul( attrs[kSoftAttrV], w );
+		} else {
+			color.r = attrs[kSoftAttrR];
+			color.g = attrs[kSoftAttrG];
+			color.b = attrs[kSoftAttrB];
+			color.a = attrs[kSoftAttrA];
+			u = attrs[kSoftAttrU];
+			v = attrs[kSoftAttrV];
+		}
+
+		// Modulate by the texture (sampled a pixel at a time; there's no
+		// gather to do it four at once)
+		if( state.pTexture != nullptr ) {
+			DOLL_VECALIGN F32 us[4];
+			DOLL_VECALIGN F32 vs[4];
+			vecStore( us, u );
+			vecStore( vs, v );
+
+			U32 texels[4] = { 0, 0, 0, 0 };
+			for( S32 i = 0; i < cLanes; ++i ) {
+				texels[i] = sampleTexture( *state.pTexture, state.sampler, tri.bLinear, us[i], vs[i] );
+			}
+
+			SSoftQuad tex;
+			unpackQuad( tex, texels );
+
+			color.r = vecMul( color.r, tex.r );
+			color.g = vecMul( color.g, tex.g );
+			color.b = vecMul( color.b, tex.b );
+			color.a = vecMul( color.a, tex.a );
+		}
+
+		// Alpha test (alpha >= 1/255, as set up by setDefaultState())
+		if( state.bAlphaTest ) {
+			DOLL_VECALIGN F32 as[4];
+			vecStore( as, color.a );
+
+			for( S32 i = 0; i < cLanes; ++i ) {
+				if( !( as[i] >= 1.0f/255.0f ) ) {
+					uMask &= ~( 1U<<i );
+				}
+			}
+		}
+
+		if( uMask != 0 ) {
+			blendQuad( state, pRow + x, uMask, color );
+		}
+
+		for( U32 n = 0; n < cAttrs; ++n ) {
+			attrs[n] = vecAdd( attrs[n], steps[n] );
+		}
+	}
+}
+
+static Void rasterTriangle( SSoftContext &ctx, const SSoftTriangle &tri, const SSoftRect &tile ) {
+	const SSoftRect rc = tri.bounds.intersect( tile );
+	if( rc.isEmpty() ) {
+		return;
+	}
+
+	const SSoftDrawState &state = ctx.states[tri.uState];
+
+	const S64 kHalf = kSoftSubpixels/2;
+	const S64 px = S64( rc.x0 )*kSoftSubpixels + kHalf;
+	const S64 cPixels = rc.x1 - rc.x0;
+
+	// Each row's span is solved exactly from the edge functions, so only
+	// the pixels inside get shaded
+	for( S32 y = rc.y0; y < rc.y1; ++y ) {
+		const S64 py = S64( y )*kSoftSubpixels + kHalf;
+
+		S64 kMin = 0;
+		S64 kMax = cPixels;
+		for( U32 i = 0; i < 3 && kMin < kMax; ++i ) {
+			const S64 e = tri.edgeA[i]*px + tri.edgeB[i]*py + tri.edgeC[i];
+			const S64 step = tri.edgeA[i]*kSoftSubpixels;
+
+			if( step > 0 ) {
+				const S64 k = ceilDiv( -e, step );
+				kMin = k > kMin ? k : kMin;
+			} else if( step < 0 ) {
+				const S64 k = floorDiv( e, -step ) + 1;
+				kMax = k < kMax ? k : kMax;
+			} else if( e < 0 ) {
+				kMax = 0;
+			}
+		}
+
+		if( kMin < kMax ) {
+			shadeSpan( ctx, tri, state, y, rc.x0 + S32( kMin ), rc.x0 + S32( kMax ) );
+		}
+	}
+}
+static Void rasterClear( SSoftContext &ctx, const SSoftClear &clear, const SSoftRect &tile ) {
+	const SSoftRect rc = clear.rc.intersect( tile );
+	if( rc.isEmpty() ) {
+		return;
+	}
+
+	for( S32 y = rc.y0; y < rc.y1; ++y ) {
+		U32 *const pRow = ctx.pDraw + UPtr( y )*ctx.uDrawResX;
+		for( S32 x = rc.x0; x < rc.x1; ++x ) {
+			pRow[x] = clear.value;
+		}
+	}
+}
+
+static SSoftRect getCommandBounds( const SSoftContext &ctx, U32 uCmd ) {
+	if( uCmd & kSoftClearBit ) {
+		return ctx.clears[uCmd & ~kSoftClearBit].rc;
+	}
+
+	return ctx.tris[uCmd].bounds;
+}
+
+// Sort the pending commands into per tile lists (keeping their order)
+static Bool binCommands( SSoftContext &ctx ) {
+	ctx.cTilesX = ( ctx.uDrawResX + kSoftTileSize - 1 ) >> kSoftTileShift;
+	ctx.cTilesY = ( ctx.uDrawResY + kSoftTileSize - 1 ) >> kSoftTileShift;
+
+	const U32 cTiles = ctx.cTilesX*ctx.cTilesY;
+	if( !AX_VERIFY_MEMORY( ctx.binStart.resize( cTiles + 1 ) ) || !AX_VERIFY_MEMORY( ctx.binFill.resize( cTiles ) ) ) {
+		return false;
+	}
+	for( U32 i = 0; i <= cTiles; ++i ) {
+		ctx.binStart[i] = 0;
+	}
+
+	// Count each tile's commands, then turn the counts into offsets
+	for( U32 uCmd : ctx.cmds ) {
+		const SSoftRect rc = getCommandBounds( ctx, uCmd );
+		if( rc.isEmpty() ) {
+			continue;
+		}
+
+		for( U32 ty = U32( rc.y0 ) >> kSoftTileShift; ty <= U32( rc.y1 - 1 ) >> kSoftTileShift; ++ty ) {
+			for( U32 tx = U32( rc.x0 ) >> kSoftTileShift; tx <= U32( rc.x1 - 1 ) >> kSoftTileShift; ++tx ) {
+				++ctx.binStart[ty*ctx.cTilesX + tx + 1];
+			}
+		}
+	}
+	for( U32 i = 0; i < cTiles; ++i ) {
+		ctx.binStart[i + 1] += ctx.binStart[i];
+		ctx.binFill[i]       = ctx.binStart[i];
+	}
+
+	if( !AX_VERIFY_MEMORY( ctx.binCmds.resize( ctx.binStart[cTiles] ) ) ) {
+		return false;
+	}
+
+	for( U32 uCmd : ctx.cmds ) {
+		const SSoftRect rc = getCommandBounds( ctx, uCmd );
+		if( rc.isEmpty() ) {
+			continue;
+		}
+
+		for( U32 ty = U32( rc.y0 ) >> kSoftTileShift; ty <= U32( rc.y1 - 1 ) >> kSoftTileShift; ++ty ) {
+			for( U32 tx = U32( rc.x0 ) >> kSoftTileShift; tx <= U32( rc.x1 - 1 ) >> kSoftTileShift; ++tx ) {
+				ctx.binCmds[ctx.binFill[ty*ctx.cTilesX + tx]++] = uCmd;
+			}
+		}
+	}
+
+	return true;
+}
+
+static Void renderTile( SSoftContext &ctx, U32 uTile ) {
+	const U32 tx = uTile%ctx.cTilesX;
+	const U32 ty = uTile/ctx.cTilesX;
+
+	SSoftRect tile;
+	tile.x0 = S32( tx << kSoftTileShift );
+	tile.y0 = S32( ty << kSoftTileShift );
+	tile.x1 = S32( tile.x0 + kSoftTileSize < ctx.uDrawResX ? tile.x0 + kSoftTileSize : ctx.uDrawResX );
+	tile.y1 = S32( tile.y0 + kSoftTileSize < ctx.uDrawResY ? tile.y0 + kSoftTileSize : ctx.uDrawResY );
+
+	for( U32 i = ctx.binStart[uTile]; i < ctx.binStart[uTile + 1]; ++i ) {
+		const U32 uCmd = ctx.binCmds[i];
+
+		if( uCmd & kSoftClearBit ) {
+			rasterClear( ctx, ctx.clears[uCmd & ~kSoftClearBit], tile );
+		} else {
+			rasterTriangle( ctx, ctx.tris[uCmd], tile );
+		}
+	}
+}
+
+// Every uTileStep'th tile from uFirstTile; tiles don't overlap, so threads
+// doing this at once never write the same pixels
+static Void renderTiles( SSoftContext &ctx, U32 uFirstTile, U32 uTileStep ) {
+	const U32 cTiles = ctx.cTilesX*ctx.cTilesY;
+	for( U32 uTile = uFirstTile; uTile < cTiles; uTile += uTileStep ) {
+		renderTile( ctx, uTile );
+	}
+}
+
+static int AXTHREAD_CALL softWorker_f( axthread_t *, Void *pParm ) {
+	SSoftWorker &worker = *reinterpret_cast<SSoftWorker *>( pParm );
+	SSoftContext &ctx = *worker.pCtx;
+	SSoftPool &pool = ctx.pool;
+
+	for(;;) {
+		U32 cActive;
+		{
+			std::unique_lock<std::mutex> guard( pool.lock );
+			pool.wake.wait( guard, [&]() { return pool.bQuit || pool.uFlush != worker.uSeenFlush; } );
+			if( pool.bQuit ) {
+				break;
+			}
+
+			worker.uSeenFlush = pool.uFlush;
+			cActive = pool.cActive;
+		}
+
+		if( worker.uIndex >= cActive ) {
+			continue;
+		}
+
+		renderTiles( ctx, worker.uIndex, cActive );
+
+		std::lock_guard<std::mutex> guard( pool.lock );
+		if( --pool.cBusy == 0 ) {
+			pool.done.notify_one();
+		}
+	}
+
+	return 0;
+}
+
+// Join every worker thread
+static Void stopSoftPool( SSoftContext &ctx ) {
+	SSoftPool &pool = ctx.pool;
+
+	{
+		std::lock_guard<std::mutex> guard( pool.lock );
+		pool.bQuit = true;
+	}
+	pool.wake.notify_all();
+
+	for( U32 i = 1; i <= pool.cStarted; ++i ) {
+		axthread_fini( &pool.workers[i].thread );
+		pool.workers[i].bStarted = false;
+	}
+
+	pool.cStarted = 0;
+	pool.bQuit = false;
+}
+// Start enough worker threads for ctx.cThreads (fewer if they can't be
+// started; flushes then use fewer threads)
+static Void startSoftPool( SSoftContext &ctx ) {
+	SSoftPool &pool = ctx.pool;
+
+	AX_ASSERT( pool.cStarted == 0 );
+
+	const U32 cThreads = ctx.cThreads < CGfxAPI_Soft::kMaxThreads ? ctx.cThreads : U32( CGfxAPI_Soft::kMaxThreads );
+	for( U32 i = 0; i < cThreads; ++i ) {
+		pool.workers[i].pCtx       = &ctx;
+		pool.workers[i].uIndex     = i;
+		pool.workers[i].uSeenFlush = pool.uFlush;
+	}
+
+	for( U32 i = 1; i < cThreads; ++i ) {
+		SSoftWorker &worker = pool.workers[i];
+
+		worker.bStarted = axthread_init( &worker.thread, &softWorker_f, ( Void * )&worker ) != 0;
+		if( !worker.bStarted ) {
+			DOLL_WARNING_LOG += axf( "Software renderer: only started %u of %u threads", i, cThreads );
+			break;
+		}
+
+		axthread_set_name( &worker.thread, "[Doll] Software Renderer" );
+		pool.cStarted = i;
+	}
+}
+
+static Void resetPending( SSoftContext &ctx ) {
+	ctx.cmds.clear();
+	ctx.tris.clear();
+	ctx.clears.clear();
+	ctx.states.clear();
+	ctx.bStateChanged = true;
+}
+
+static Void flushSoft( SSoftContext &ctx ) {
+	if( ctx.cmds.isEmpty() ) {
+		return;
+	}
+
+	if( !binCommands( ctx ) ) {
+		DOLL_ERROR_LOG += "Software renderer: out of memory; dropped a frame's rendering";
+		resetPending( ctx );
+		return;
+	}
+
+	const U32 cTiles = ctx.cTilesX*ctx.cTilesY;
+
+	SSoftPool &pool = ctx.pool;
+
+	U32 cThreads = pool.cStarted + 1;
+	if( cThreads > cTiles ) {
+		cThreads = cTiles;
+	}
+	if( cThreads < 1 || ctx.cmds.num() < kSoftMinThreadedCmds ) {
+		cThreads = 1;
+	}
+
+	// Interleave the tiles so busy parts of the screen get shared out; the
+	// calling thread is worker 0 and the pool's threads are woken for the
+	// rest
+	if( cThreads > 1 ) {
+		{
+			std::lock_guard<std::mutex> guard( pool.lock );
+			pool.cActive = cThreads;
+			pool.cBusy = cThreads - 1;
+			++pool.uFlush;
+		}
+		pool.wake.notify_all();
+	}
+
+	renderTiles( ctx, 0, cThreads );
+
+	if( cThreads > 1 ) {
+		std::unique_lock<std::mutex> guard( pool.lock );
+		pool.done.wait( guard, [&]() { return pool.cBusy == 0; } );
+	}
+
+	resetPending( ctx );
+}
+
+//====================================================================//
+
+CGfxAPI_Soft::CGfxAPI_Soft( IGfxAPIProvider &provider, SSoftContext *pCtx )
+: IGfxAPI( provider )
+, m_pCtx( pCtx ) {
+	AX_ASSERT_NOT_NULL( pCtx );
+
+	updateMVP( *m_pCtx );
+}
+CGfxAPI_Soft::~CGfxAPI_Soft() {
+	stopSoftPool( *m_pCtx );
+	delete m_pCtx;
+}
+
+EGfxAPI CGfxAPI_Soft::getAPI() const {
+	return kGfxAPISoftware;
+}
+TArr<EShaderFormat> CGfxAPI_Soft::getSupportedShaderFormats() const {
+	return TArr<EShaderFormat>();
+}
+TArr<EShaderStage> CGfxAPI_Soft::getSupportedShaderStages() const {
+	return TArr<EShaderStage>();
+}
+
+Void CGfxAPI_Soft::setDefaultState( const Mat4f &proj ) {
+	// Like the GL backend, this leaves the projection alone
+	( (Void)proj );
+
+	SSoftContext &ctx = *m_pCtx;
+
+	ctx.blendOp    = kBlendAdd;
+	ctx.colA       = kBlendSrcAlpha;
+	ctx.colB       = kBlendInvSrcAlpha;
+	ctx.alphaA     = kBlendSrcAlpha;
+	ctx.alphaB     = kBlendInvSrcAlpha;
+	ctx.bAlphaTest = true;
+	ctx.bScissor   = false;
+	ctx.bTexture   = false;
+	ctx.pTextures[0] = nullptr;
+
+	for( U32 i = 0; i < 16; ++i ) {
+		ctx.modelView[i] = ( i%5 == 0 ) ? 1.0f : 0.0f;
+	}
+	updateMVP( ctx );
+
+	ctx.viewport      = makeRect( 0, 0, ctx.uResX, ctx.uResY );
+	ctx.bStateChanged = true;
+}
+
+Void CGfxAPI_Soft::resize( U32 uResX, U32 uResY ) {
+	SSoftContext &ctx = *m_pCtx;
+
+	if( ctx.uResX == uResX && ctx.uResY == uResY ) {
+		return;
+	}
+
+	flush();
+
+	if( !AX_VERIFY_MEMORY( ctx.pixels.resize( UPtr( uResX )*UPtr( uResY ) ) ) ) {
+		return;
+	}
+	for( U32 &px : ctx.pixels ) {
+		px = 0;
+	}
+
+	ctx.uResX = uResX;
+	ctx.uResY = uResY;
+	selectDrawTarget( ctx );
+}
+Void CGfxAPI_Soft::getSize( U32 &uResX, U32 &uResY ) {
+	uResX = m_pCtx->uResX;
+	uResY = m_pCtx->uResY;
+}
+
+Void CGfxAPI_Soft::wsiPresent() {
+	// Nothing to show the frame on; it stays in memory for readback()
+	flush();
+	++m_pCtx->cFrames;
+}
+
+IGfxAPISampler *CGfxAPI_Soft::createSampler( const SGfxSamplerDesc &desc ) {
+	SSoftSampler *const pSampler = new SSoftSampler();
+	if( !AX_VERIFY_MEMORY( pSampler ) ) {
+		return nullptr;
+	}
+
+	// No mipmaps, anisotropy or compare modes
+	pSampler->magFilter = desc.magFilter;
+	pSampler->minFilter = desc.minFilter;
+	pSampler->wrapU     = desc.wrapU;
+	pSampler->wrapV     = desc.wrapV;
+
+	switch( desc.borderColor ) {
+	case kTexBorderTransparentBlack:
+		pSampler->borderColor = DOLL_RGBA( 0x00, 0x00, 0x00, 0x00 );
+		break;
+	case kTexBorderTransparentWhite:
+		pSampler->borderColor = DOLL_RGBA( 0xFF, 0xFF, 0xFF, 0x00 );
+		break;
+	case kTexBorderOpaqueBlack:
+		pSampler->borderColor = DOLL_RGBA( 0x00, 0x00, 0x00, 0xFF );
+		break;
+	case kTexBorderOpaqueWhite:
+		pSampler->borderColor = DOLL_RGBA( 0xFF, 0xFF, 0xFF, 0xFF );
+		break;
+	}
+
+	return reinterpret_cast<IGfxAPISampler *>( pSampler );
+}
+Void CGfxAPI_Soft::destroySampler( IGfxAPISampler *pSampler ) {
+	if( !pSampler ) {
+		return;
+	}
+
+	SSoftContext &ctx = *m_pCtx;
+	SSoftSampler *const p = reinterpret_cast<SSoftSampler *>( pSampler );
+
+	// Recorded states hold copies, so there's no need to flush
+	for( U32 i = 0; i < kSoftMaxStages; ++i ) {
+		if( ctx.pSamplers[i] == p ) {
+			ctx.pSamplers[i]  = nullptr;
+			ctx.bStateChanged = true;
+		}
+	}
+
+	delete p;
+}
+
+static Void copyTexels( SSoftTexture &tex, ETextureFormat fmt, U32 posX, U32 posY, U32 resX, U32 resY, const U8 *pData ) {
+	// Source rows are BGRA (or BGR), as with the GL backend
+	const UPtr cSrcBytes = fmt == kTexFmtRGB8 ? 3 : 4;
+
+	for( U32 y = 0; y < resY; ++y ) {
+		U32 *const pDst = tex.texels.pointer() + UPtr( posY + y )*tex.uResX + posX;
+		const U8 *pSrc = pData + UPtr( y )*resX*cSrcBytes;
+
+		for( U32 x = 0; x < resX; ++x ) {
+			const U32 a = cSrcBytes == 4 ? pSrc[3] : 0xFF;
+			pDst[x] = DOLL_RGBA( pSrc[2], pSrc[1], pSrc[0], a );
+			pSrc += cSrcBytes;
+		}
+	}
+}
+
+IGfxAPITexture *CGfxAPI_Soft::createTexture( ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData ) {
+	AX_ASSERT( resX > 0 );
+	AX_ASSERT( resY > 0 );
+
+	SSoftTexture *const pTex = new SSoftTexture();
+	if( !AX_VERIFY_MEMORY( pTex ) ) {
+		return nullptr;
+	}
+
+	pTex->uResX = resX;
+	pTex->uResY = resY;
+	if( !AX_VERIFY_MEMORY( pTex->texels.resize( UPtr( resX )*UPtr( resY ) ) ) ) {
+		delete pTex;
+		return nullptr;
+	}
+
+	if( pData != nullptr ) {
+		copyTexels( *pTex, fmt, 0, 0, resX, resY, pData );
+	} else {
+		for( U32 &texel : pTex->texels ) {
+			texel = 0;
+		}
+	}
+
+	return reinterpret_cast<IGfxAPITexture *>( pTex );
+}
+Void CGfxAPI_Soft::destroyTexture( IGfxAPITexture *tex ) {
+	if( !tex ) {
+		return;
+	}
+
+	SSoftContext &ctx = *m_pCtx;
+	SSoftTexture *const p = reinterpret_cast<SSoftTexture *>( tex );
+
+	// Pending triangles may still sample it
+	flush();
+
+	for( U32 i = 0; i < kSoftMaxStages; ++i ) {
+		if( ctx.pTextures[i] == p ) {
+			ctx.pTextures[i]  = nullptr;
+			ctx.bStateChanged = true;
+		}
+	}
+
+	delete p;
+}
+
+static Bool initTextureSoft( SSoftTexture &tex, U16 resX, U16 resY ) {
+	tex.uResX = resX;
+	tex.uResY = resY;
+	if( !AX_VERIFY_MEMORY( tex.texels.resize( UPtr( resX )*UPtr( resY ) ) ) ) {
+		return false;
+	}
+
+	for( U32 &texel : tex.texels ) {
+		texel = 0;
+	}
+
+	return true;
+}
+
+IGfxAPIRenderTarget *CGfxAPI_Soft::createRenderTarget( U16 resX, U16 resY ) {
+	AX_ASSERT( resX > 0 );
+	AX_ASSERT( resY > 0 );
+
+	SSoftRenderTarget *const pTarget = new SSoftRenderTarget();
+	if( !AX_VERIFY_MEMORY( pTarget ) ) {
+		return nullptr;
+	}
+
+	if( !initTextureSoft( pTarget->color, resX, resY ) || !initTextureSoft( pTarget->texture, resX, resY ) ) {
+		delete pTarget;
+		return nullptr;
+	}
+
+	return reinterpret_cast<IGfxAPIRenderTarget *>( pTarget );
+}
+Void CGfxAPI_Soft::destroyRenderTarget( IGfxAPIRenderTarget *rt ) {
+	if( !rt ) {
+		return;
+	}
+
+	SSoftContext &ctx = *m_pCtx;
+	SSoftRenderTarget *const p = reinterpret_cast<SSoftRenderTarget *>( rt );
+
+	// Pending triangles may draw into it or sample its texture
+	flush();
+
+	if( ctx.pTarget == p ) {
+		ctx.pTarget = nullptr;
+		selectDrawTarget( ctx );
+	}
+	for( U32 i = 0; i < kSoftMaxStages; ++i ) {
+		if( ctx.pTextures[i] == &p->texture ) {
+			ctx.pTextures[i]  = nullptr;
+			ctx.bStateChanged = true;
+		}
+	}
+
+	delete p;
+}
+IGfxAPITexture *CGfxAPI_Soft::getRenderTargetTexture( IGfxAPIRenderTarget *rt ) {
+	if( !rt ) {
+		return nullptr;
+	}
+
+	return reinterpret_cast<IGfxAPITexture *>( &reinterpret_cast<SSoftRenderTarget *>( rt )->texture );
+}
+
+IGfxAPIVLayout *CGfxAPI_Soft::createLayout( const SGfxLayout &desc ) {
+	return (IGfxAPIVLayout *)&desc;
+}
+Void CGfxAPI_Soft::destroyLayout( IGfxAPIVLayout *pLayout ) {
+	if( m_pCtx->pLayout == (const SGfxLayout *)pLayout ) {
+		m_pCtx->pLayout = nullptr;
+	}
+}
+
+static SSoftBuffer *createBufferSoft( UPtr cBytes, const Void *pData ) {
+	SSoftBuffer *const pBuf = new SSoftBuffer();
+	if( !AX_VERIFY_MEMORY( pBuf ) ) {
+		return nullptr;
+	}
+
+	if( !AX_VERIFY_MEMORY( pBuf->data.resize( cBytes ) ) ) {
+		delete pBuf;
+		return nullptr;
+	}
+
+	if( pData != nullptr ) {
+		memcpy( pBuf->data.pointer(), pData, cBytes );
+	} else if( cBytes > 0 ) {
+		memset( pBuf->data.pointer(), 0, cBytes );
+	}
+
+	return pBuf;
+}
+static Void writeBufferSoft( SSoftBuffer *pBuf, UPtr offset, UPtr size, const Void *pData ) {
+	AX_ASSERT_NOT_NULL( pBuf );
+
+	if( !pBuf || offset + size > pBuf->data.num() || offset + size < offset ) {
+		DOLL_ERROR_LOG += "Buffer write out of range.";
+		return;
+	}
+
+	// A null source just discards the contents (as with GL orphaning)
+	if( pData != nullptr && size > 0 ) {
+		memcpy( pBuf->data.pointer() + offset, pData, size );
+	}
+}
+static Void readBufferSoft( const SSoftBuffer *pBuf, UPtr offset, UPtr size, Void *pData ) {
+	AX_ASSERT_NOT_NULL( pBuf );
+	AX_ASSERT_NOT_NULL( pData );
+
+	if( !pBuf || !pData || offset + size > pBuf->data.num() || offset + size < offset ) {
+		DOLL_ERROR_LOG += "Buffer read out of range.";
+		return;
+	}
+
+	if( size > 0 ) {
+		memcpy( pData, pBuf->data.pointer() + offset, size );
+	}
+}
+
+IGfxAPIVBuffer *CGfxAPI_Soft::createVBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
+	( (Void)perf );
+	( (Void)purpose );
+
+	return reinterpret_cast<IGfxAPIVBuffer *>( createBufferSoft( cBytes, pData ) );
+}
+IGfxAPIIBuffer *CGfxAPI_Soft::createIBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
+	( (Void)perf );
+	( (Void)purpose );
+
+	return reinterpret_cast<IGfxAPIIBuffer *>( createBufferSoft( cBytes, pData ) );
+}
+IGfxAPIUBuffer *CGfxAPI_Soft::createUBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) {
+	( (Void)perf );
+	( (Void)purpose );
+
+	return reinterpret_cast<IGfxAPIUBuffer *>( createBufferSoft( cBytes, pData ) );
+}
+// Draws read their vertexes immediately, so buffers can go without a flush
+Void CGfxAPI_Soft::destroyVBuffer( IGfxAPIVBuffer *vb ) {
+	SSoftBuffer *const p = reinterpret_cast<SSoftBuffer *>( vb );
+	if( m_pCtx->pVBuf == p ) {
+		m_pCtx->pVBuf = nullptr;
+	}
+	if( m_pCtx->pInstBuf == p ) {
+		m_pCtx->pInstBuf = nullptr;
+	}
+
+	delete p;
+}
+Void CGfxAPI_Soft::destroyIBuffer( IGfxAPIIBuffer *ib ) {
+	SSoftBuffer *const p = reinterpret_cast<SSoftBuffer *>( ib );
+	if( m_pCtx->pIBuf == p ) {
+		m_pCtx->pIBuf = nullptr;
+	}
+
+	delete p;
+}
+Void CGfxAPI_Soft::destroyUBuffer( IGfxAPIUBuffer *ub ) {
+	delete reinterpret_cast<SSoftBuffer *>( ub );
+}
+
+static IGfxDiagnostic &getDiag( IGfxDiagnostic *pDiag ) {
+	static DummyDiag diag;
+	return pDiag != nullptr ? *pDiag : diag;
+}
+
+IGfxAPIShader *CGfxAPI_Soft::createShader( Str filename, EShaderFormat fmt, EShaderStage stage, UPtr cBytes, const Void *pData, IGfxDiagnostic *pDiag ) {
+	( (Void)fmt );
+	( (Void)stage );
+	( (Void)cBytes );
+	( (Void)pData );
+
+	getDiag( pDiag ).error( filename, 0, 0, "The software renderer doesn't support shaders." );
+	return nullptr;
+}
+IGfxAPIProgram *CGfxAPI_Soft::createProgram( TArr<IGfxAPIShader *> shaders, IGfxDiagnostic *pDiag ) {
+	( (Void)shaders );
+
+	getDiag( pDiag ).error( Str(), 0, 0, "The software renderer doesn't support shaders." );
+	return nullptr;
+}
+Void CGfxAPI_Soft::destroyShader( IGfxAPIShader *pShader ) {
+	( (Void)pShader );
+}
+Void CGfxAPI_Soft::destroyProgram( IGfxAPIProgram *pProgram ) {
+	( (Void)pProgram );
+}
+Bool CGfxAPI_Soft::setCacheDirectory( Str basePath ) {
+	( (Void)basePath );
+
+	return false;
+}
+Str CGfxAPI_Soft::getCacheDirectory() const {
+	return Str();
+}
+Void CGfxAPI_Soft::invalidateShaderCache() {
+}
+
+Void CGfxAPI_Soft::vsSetProjectionMatrix( const F32 *matrix ) {
+	AX_ASSERT_NOT_NULL( matrix );
+
+	memcpy( m_pCtx->proj, matrix, sizeof( m_pCtx->proj ) );
+	updateMVP( *m_pCtx );
+}
+Void CGfxAPI_Soft::vsSetModelViewMatrix( const F32 *matrix ) {
+	AX_ASSERT_NOT_NULL( matrix );
+
+	memcpy( m_pCtx->modelView, matrix, sizeof( m_pCtx->modelView ) );
+	updateMVP( *m_pCtx );
+}
+
+Void CGfxAPI_Soft::psoSetScissorEnable( Bool enable ) {
+	m_pCtx->bScissor      = enable;
+	m_pCtx->bStateChanged = true;
+}
+Void CGfxAPI_Soft::psoSetTextureEnable( Bool enable ) {
+	m_pCtx->bTexture      = enable;
+	m_pCtx->bStateChanged = true;
+}
+Void CGfxAPI_Soft::psoSetBlend( EBlendOp op, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB ) {
+	SSoftContext &ctx = *m_pCtx;
+
+	ctx.blendOp       = op;
+	ctx.colA          = colA;
+	ctx.colB          = colB;
+	ctx.alphaA        = alphaA;
+	ctx.alphaB        = alphaB;
+	ctx.bStateChanged = true;
+}
+
+// Both take the top-left corner (the GL backend flips them for GL)
+Void CGfxAPI_Soft::rsSetScissor( S32 posX, S32 posY, U32 resX, U32 resY ) {
+	m_pCtx->scissor       = makeRect( posX, posY, resX, resY );
+	m_pCtx->bStateChanged = true;
+}
+Void CGfxAPI_Soft::rsSetViewport( S32 posX, S32 posY, U32 resX, U32 resY ) {
+	m_pCtx->viewport      = makeRect( posX, posY, resX, resY );
+	m_pCtx->bStateChanged = true;
+}
+
+Void CGfxAPI_Soft::iaSetLayout( IGfxAPIVLayout *pLayout ) {
+	m_pCtx->pLayout = (const SGfxLayout *)pLayout;
+}
+
+Void CGfxAPI_Soft::tsBindTexture( IGfxAPITexture *tex, U32 uStage ) {
+	AX_ASSERT( uStage < kSoftMaxStages );
+	if( uStage >= kSoftMaxStages ) {
+		return;
+	}
+
+	m_pCtx->pTextures[uStage] = reinterpret_cast<SSoftTexture *>( tex );
+	m_pCtx->bStateChanged     = true;
+}
+Void CGfxAPI_Soft::tsBindSampler( IGfxAPISampler *pSampler, U32 uStage ) {
+	AX_ASSERT( uStage < kSoftMaxStages );
+	if( uStage >= kSoftMaxStages ) {
+		return;
+	}
+
+	m_pCtx->pSamplers[uStage] = reinterpret_cast<SSoftSampler *>( pSampler );
+	m_pCtx->bStateChanged     = true;
+}
+Void CGfxAPI_Soft::iaBindVBuffer( IGfxAPIVBuffer *vb ) {
+	AX_ASSERT_NOT_NULL( vb );
+
+	m_pCtx->pVBuf = reinterpret_cast<SSoftBuffer *>( vb );
+}
+Void CGfxAPI_Soft::iaBindIBuffer( IGfxAPIIBuffer *ib, EIndexFormat fmt ) {
+	AX_ASSERT_NOT_NULL( ib );
+
+	m_pCtx->pIBuf       = reinterpret_cast<SSoftBuffer *>( ib );
+	m_pCtx->indexFormat = fmt;
+}
+Void CGfxAPI_Soft::iaBindInstanceBuffer( IGfxAPIVBuffer *vb ) {
+	m_pCtx->pInstBuf = reinterpret_cast<SSoftBuffer *>( vb );
+}
+
+Void CGfxAPI_Soft::plBindProgram( IGfxAPIProgram *pProgram ) {
+	( (Void)pProgram );
+}
+Void CGfxAPI_Soft::plUnbindProgram() {
+}
+Void CGfxAPI_Soft::cmdUpdateProgramBindings( const SGfxBinding &binding ) {
+	( (Void)binding );
+}
+
+Void CGfxAPI_Soft::omBindRenderTarget( IGfxAPIRenderTarget *rt ) {
+	SSoftContext &ctx = *m_pCtx;
+	SSoftRenderTarget *const p = reinterpret_cast<SSoftRenderTarget *>( rt );
+
+	if( ctx.pTarget == p ) {
+		return;
+	}
+
+	// Pending work goes to the old target
+	flush();
+
+	ctx.pTarget = p;
+	selectDrawTarget( ctx );
+}
+
+Void CGfxAPI_Soft::cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value ) {
+	SSoftContext &ctx = *m_pCtx;
+
+	// Not affected by the scissor state (as with the GL backend)
+	SSoftClear clear;
+	clear.rc    = makeRect( posX, posY, resX, resY ).intersect( makeRect( 0, 0, ctx.uDrawResX, ctx.uDrawResY ) );
+	clear.value = value;
+
+	if( clear.rc.isEmpty() ) {
+		return;
+	}
+
+	if( !AX_VERIFY_MEMORY( ctx.clears.append( clear ) ) ) {
+		return;
+	}
+	if( !AX_VERIFY_MEMORY( ctx.cmds.append( U32( ctx.clears.num() - 1 ) | kSoftClearBit ) ) ) {
+		ctx.clears.resize( ctx.clears.num() - 1 );
+	}
+}
+Void CGfxAPI_Soft::cmdUpdateTexture( IGfxAPITexture *tex, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData ) {
+	AX_ASSERT_NOT_NULL( tex );
+	AX_ASSERT_NOT_NULL( pData );
+
+	SSoftTexture *const p = reinterpret_cast<SSoftTexture *>( tex );
+	if( !p || !pData ) {
+		return;
+	}
+
+	if( U32( posX ) + U32( resX ) > p->uResX || U32( posY ) + U32( resY ) > p->uResY ) {
+		DOLL_ERROR_LOG += "Texture update out of range.";
+		return;
+	}
+
+	// Earlier draws must see the old contents
+	flush();
+
+	// Always BGRA, as with the GL backend
+	copyTexels( *p, kTexFmtRGBA8, posX, posY, resX, resY, pData );
+}
+Void CGfxAPI_Soft::cmdWriteVBuffer( IGfxAPIVBuffer *vb, UPtr offset, UPtr size, const Void *pData ) {
+	writeBufferSoft( reinterpret_cast<SSoftBuffer *>( vb ), offset, size, pData );
+}
+Void CGfxAPI_Soft::cmdWriteIBuffer( IGfxAPIIBuffer *ib, UPtr offset, UPtr size, const Void *pData ) {
+	writeBufferSoft( reinterpret_cast<SSoftBuffer *>( ib ), offset, size, pData );
+}
+Void CGfxAPI_Soft::cmdWriteUBuffer( IGfxAPIUBuffer *ub, UPtr offset, UPtr size, const Void *pData ) {
+	writeBufferSoft( reinterpret_cast<SSoftBuffer *>( ub ), offset, size, pData );
+}
+Void CGfxAPI_Soft::cmdReadVBuffer( IGfxAPIVBuffer *vb, UPtr offset, UPtr size, Void *pData ) {
+	readBufferSoft( reinterpret_cast<const SSoftBuffer *>( vb ), offset, size, pData );
+}
+Void CGfxAPI_Soft::cmdReadIBuffer( IGfxAPIIBuffer *ib, UPtr offset, UPtr size, Void *pData ) {
+	readBufferSoft( reinterpret_cast<const SSoftBuffer *>( ib ), offset, size, pData );
+}
+Void CGfxAPI_Soft::cmdReadUBuffer( IGfxAPIUBuffer *ub, UPtr offset, UPtr size, Void *pData ) {
+	readBufferSoft( reinterpret_cast<const SSoftBuffer *>( ub ), offset, size, pData );
+}
+Void CGfxAPI_Soft::cmdResolveRenderTarget( IGfxAPIRenderTarget *rt ) {
+	if( !rt ) {
+		return;
+	}
+
+	SSoftRenderTarget &t = *reinterpret_cast<SSoftRenderTarget *>( rt );
+
+	// Finish drawing into it, and sampling the old contents
+	flush();
+
+	memcpy( t.texture.texels.pointer(), t.color.texels.pointer(), t.color.texels.num()*sizeof( U32 ) );
+}
+
+Void CGfxAPI_Soft::cmdDraw( ETopology mode, U32 cVerts, U32 uOffset ) {
+	cmdDrawInstanced( mode, cVerts, uOffset, 1 );
+}
+Void CGfxAPI_Soft::cmdDrawIndexed( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias ) {
+	cmdDrawIndexedInstanced( mode, cIndices, uOffset, uBias, 1 );
+}
+Void CGfxAPI_Soft::cmdDrawInstanced( ETopology mode, U32 cVerts, U32 uOffset, U32 cInstances ) {
+	SSoftContext &ctx = *m_pCtx;
+
+	AX_ASSERT_NOT_NULL( ctx.pVBuf );
+	AX_ASSERT_NOT_NULL( ctx.pLayout );
+	if( !ctx.pVBuf || !ctx.pLayout || !ctx.pLayout->stride ) {
+		return;
+	}
+
+	CSoftAssembler assembler( ctx, mode );
+	for( U32 uInstance = 0; uInstance < cInstances && assembler.isOk(); ++uInstance ) {
+		assembler.setInstance( uInstance );
+
+		for( U32 i = 0; i < cVerts && assembler.isOk(); ++i ) {
+			assembler.push( uOffset + i );
+		}
+	}
+
+	if( assembler.hadBadIndex() ) {
+		DOLL_ERROR_LOG += "Draw reads past the end of the vertex or instance buffer.";
+	}
+}
+Void CGfxAPI_Soft::cmdDrawIndexedInstanced( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances ) {
+	SSoftContext &ctx = *m_pCtx;
+
+	AX_ASSERT_NOT_NULL( ctx.pVBuf );
+	AX_ASSERT_NOT_NULL( ctx.pIBuf );
+	AX_ASSERT_NOT_NULL( ctx.pLayout );
+	if( !ctx.pVBuf || !ctx.pIBuf || !ctx.pLayout || !ctx.pLayout->stride ) {
+		return;
+	}
+
+	// 16 or 32-bit indexes, `uOffset` in bytes (as with the GL backend)
+	const UPtr cIndexBytes = ctx.indexFormat == kIndexFormatU32 ? sizeof( U32 ) : sizeof( U16 );
+
+	const TMutArr<U8> &indexData = ctx.pIBuf->data;
+	if( UPtr( uOffset ) + UPtr( cIndices )*cIndexBytes > indexData.num() ) {
+		DOLL_ERROR_LOG += "Indexed draw reads past the end of the index buffer.";
+		return;
+	}
+
+	const U8 *const pIndexes = indexData.pointer() + uOffset;
+
+	CSoftAssembler assembler( ctx, mode );
+	for( U32 uInstance = 0; uInstance < cInstances && assembler.isOk(); ++uInstance ) {
+		assembler.setInstance( uInstance );
+
+		for( U32 i = 0; i < cIndices && assembler.isOk(); ++i ) {
+			U32 uIndex;
+			if( cIndexBytes == sizeof( U32 ) ) {
+				memcpy( &uIndex, pIndexes + UPtr( i )*sizeof( U32 ), sizeof( uIndex ) );
+			} else {
+				U16 uShortIndex;
+				memcpy( &uShortIndex, pIndexes + UPtr( i )*sizeof( U16 ), sizeof( uShortIndex ) );
+				uIndex = U32( uShortIndex );
+			}
+
+			assembler.push( uIndex + uBias );
+		}
+	}
+
+	if( assembler.hadBadIndex() ) {
+		DOLL_ERROR_LOG += "Indexed draw reads past the end of the vertex or instance buffer.";
+	}
+}
+
+const U32 *CGfxAPI_Soft::readback() {
+	flush();
+	return m_pCtx->pixels.pointer();
+}
+Bool CGfxAPI_Soft::writePNG( Str filename ) {
+	const U32 *const pPixels = readback();
+	const SSoftContext &ctx = *m_pCtx;
+
+	if( !pPixels || !ctx.uResX || !ctx.uResY ) {
+		return false;
+	}
+
+	int cPNGBytes = 0;
+	unsigned char *const pPNG = stbi_write_png_to_mem( (unsigned char *)pPixels, int( ctx.uResX*4 ), int( ctx.uResX ), int( ctx.uResY ), 4, &cPNGBytes );
+	if( !AX_VERIFY_MEMORY( pPNG ) ) {
+		return false;
+	}
+
+	OSFile f = nullptr;
+	Bool bWritten = false;
+	if( sysfs_open( f, filename, kFileOpenF_W | kFileOpenF_Recreate, kFileAttrib_Regular ) == EFileOpenResult::Ok ) {
+		UPtr cWritten = 0;
+		bWritten =
+			sysfs_write( f, pPNG, UPtr( cPNGBytes ), cWritten ) == EFileIOResult::Ok &&
+			cWritten == UPtr( cPNGBytes );
+
+		sysfs_close( f );
+	}
+
+	STBIW_FREE( pPNG );
+
+	if( !bWritten ) {
+		DOLL_ERROR_LOG += axf( "Failed to write \"%.*s\"", filename.lenInt(), filename.get() );
+	}
+
+	return bWritten;
+}
+
+static U32 channelDelta( U32 a, U32 b, U32 uShift ) {
+	const U32 x = ( a >> uShift ) & 0xFF;
+	const U32 y = ( b >> uShift ) & 0xFF;
+
+	return x > y ? x - y : y - x;
+}
+
+Bool CGfxAPI_Soft::compareImage( const U32 *pPixels, U32 uResX, U32 uResY, U32 uTolerance, SSoftImageDiff &outDiff ) {
+	const U32 *const pFrame = readback();
+	const SSoftContext &ctx = *m_pCtx;
+
+	outDiff.bSameSize   = uResX == ctx.uResX && uResY == ctx.uResY;
+	outDiff.cPixels     = 0;
+	outDiff.cMismatched = 0;
+	outDiff.uMaxDelta   = 0;
+	outDiff.uFirstX     = 0;
+	outDiff.uFirstY     = 0;
+
+	if( !outDiff.bSameSize ) {
+		return false;
+	}
+
+	AX_ASSERT_NOT_NULL( pPixels );
+	if( !pPixels || !pFrame ) {
+		return false;
+	}
+
+	for( U32 y = 0; y < uResY; ++y ) {
+		const U32 *const pRowA = pFrame + UPtr( y )*uResX;
+		const U32 *const pRowB = pPixels + UPtr( y )*uResX;
+
+		for( U32 x = 0; x < uResX; ++x ) {
+			const U32 a = pRowA[x];
+			const U32 b = pRowB[x];
+			if( a == b ) {
+				continue;
+			}
+
+			U32 uDelta = 0;
+			for( U32 uShift = 0; uShift < 32; uShift += 8 ) {
+				const U32 d = channelDelta( a, b, uShift );
+				uDelta = d > uDelta ? d : uDelta;
+			}
+
+			outDiff.uMaxDelta = uDelta > outDiff.uMaxDelta ? uDelta : outDiff.uMaxDelta;
+			if( uDelta > uTolerance ) {
+				if( !outDiff.cMismatched ) {
+					outDiff.uFirstX = x;
+					outDiff.uFirstY = y;
+				}
+				++outDiff.cMismatched;
+			}
+		}
+	}
+
+	outDiff.cPixels = uResX*uResY;
+	return outDiff.cMismatched == 0;
+}
+Bool CGfxAPI_Soft::compareImageFile( Str filename, U32 uTolerance, SSoftImageDiff &outDiff ) {
+	outDiff.bSameSize   = false;
+	outDiff.cPixels     = 0;
+	outDiff.cMismatched = 0;
+	outDiff.uMaxDelta   = 0;
+	outDiff.uFirstX     = 0;
+	outDiff.uFirstY     = 0;
+
+	U8 *pFileData = nullptr;
+	UPtr cFileBytes = 0;
+	if( !core_loadFile( filename, pFileData, cFileBytes, kTag_Texture ) ) {
+		return false;
+	}
+
+	int resX = 0, resY = 0, cChannels = 0;
+	stbi_uc *const pImage = stbi_load_from_memory( pFileData, int( cFileBytes ), &resX, &resY, &cChannels, 4 );
+	core_freeFile( pFileData );
+
+	if( !pImage ) {
+		DOLL_ERROR_LOG += axf( "Failed to load \"%.*s\" for comparison", filename.lenInt(), filename.get() );
+		return false;
+	}
+
+	// Four channels were asked for, so the bytes are R,G,B,A as in readback()
+	const Bool bMatched = compareImage( reinterpret_cast<const U32 *>( pImage ), U32( resX ), U32( resY ), uTolerance, outDiff );
+	stbi_image_free( pImage );
+
+	return bMatched;
+}
+
+Void CGfxAPI_Soft::setThreadCount( U32 cThreads ) {
+	if( !cThreads ) {
+		cThreads = kSoftDefaultThreads;
+	}
+
+	cThreads = cThreads < kMaxThreads ? cThreads : U32( kMaxThreads );
+	if( cThreads == m_pCtx->cThreads ) {
+		return;
+	}
+
+	// Nothing is rasterizing between flushes, so the pool can be replaced
+	stopSoftPool( *m_pCtx );
+	m_pCtx->cThreads = cThreads;
+	startSoftPool( *m_pCtx );
+}
+U32 CGfxAPI_Soft::getThreadCount() const {
+	return m_pCtx->cThreads;
+}
+U32 CGfxAPI_Soft::getFrameCount() const {
+	return m_pCtx->cFrames;
+}
+
+Void CGfxAPI_Soft::flush() {
+	flushSoft( *m_pCtx );
+}
+
+DOLL_FUNC CGfxAPI_Soft *DOLL_API gfx__api_init_soft( OSWindow wnd, const SGfxInitDesc &desc, IGfxAPIProvider &provider ) {
+	( (Void)desc );
+
+	SSoftContext *const pCtx = new SSoftContext();
+	if( !AX_VERIFY_MEMORY( pCtx ) ) {
+		return nullptr;
+	}
+
+	// Match the window if there is one; headless callers resize() later
+	U32 uResX = 0, uResY = 0;
+	if( wnd != nullptr ) {
+		wnd_getSize( wnd, uResX, uResY );
+	}
+	if( !uResX || !uResY ) {
+		uResX = kSoftDefaultResX;
+		uResY = kSoftDefaultResY;
+	}
+
+	if( !AX_VERIFY_MEMORY( pCtx->pixels.resize( UPtr( uResX )*UPtr( uResY ) ) ) ) {
+		delete pCtx;
+		return nullptr;
+	}
+	for( U32 &px : pCtx->pixels ) {
+		px = 0;
+	}
+
+	pCtx->wnd      = wnd;
+	pCtx->uResX    = uResX;
+	pCtx->uResY    = uResY;
+	pCtx->viewport = makeRect( 0, 0, uResX, uResY );
+	selectDrawTarget( *pCtx );
+
+	CGfxAPI_Soft *const pSoftAPI = new CGfxAPI_Soft( provider, pCtx );
+	if( !AX_VERIFY_MEMORY( pSoftAPI ) ) {
+		delete pCtx;
+		return nullptr;
+	}
+
+	startSoftPool( *pCtx );
+
+	DOLL_DEBUG_LOG += axf( "Software renderer: %ux%u", uResX, uResY );
+	return pSoftAPI;
+}
+
+DOLL_FUNC CGfxAPI_Soft *DOLL_API gfx_getSoftAPI( IGfxAPI *pAPI ) {
+	if( !pAPI || pAPI->getAPI() != kGfxAPISoftware ) {
+		return nullptr;
+	}
+
+	return dynamic_cast<CGfxAPI_Soft *>( pAPI );
+}
+
+} // namespace doll
+
+#endif
@@ -2,6 +2,8 @@
 #include "../BuildSettings.hpp"
 
 #include "doll/Gfx/API.hpp"
+#include "doll/Gfx/RenderStats.hpp"
+#include "doll/Gfx/Texture.hpp"
 
 // FIXME: Find a better way to include files.
 
@@ -150,8 +152,16 @@ namespace doll
 	, m_proj2D()
 	, m_pMemVBuf( nullptr )
 	, m_cVBufBytes( 0 )
+	, m_pLayout( nullptr )
+	, m_pTarget( nullptr )
 	{
 		m_context.getSize( m_uResX, m_uResY );
+
+		m_targetOrigin[ 0 ] = 0;
+		m_targetOrigin[ 1 ] = 0;
+		memset( &m_shadow, 0, sizeof( m_shadow ) );
+		memset( &m_stats, 0, sizeof( m_stats ) );
+		memset( &m_lastStats, 0, sizeof( m_lastStats ) );
 	}
 	CGfxFrame::~CGfxFrame()
 	{
@@ -163,6 +173,14 @@ namespace doll
 	void CGfxFrame::setDefaultState()
 	{
 		m_context.setDefaultState( m_proj2D );
+		invalidateState();
+
+		// The default viewport covers the window, not the frame's place in
+		// the render target, and the default blend needs alpha as coverage
+		if( m_pTarget != nullptr ) {
+			m_context.rsSetViewport( -m_targetOrigin[ 0 ], -m_targetOrigin[ 1 ], m_uResX, m_uResY );
+			setBlend( kBlendAdd, kBlendSrcAlpha, kBlendInvSrcAlpha, kBlendSrcAlpha, kBlendInvSrcAlpha );
+		}
 	}
 
 	void CGfxFrame::resize( U32 uResX, U32 uResY )
@@ -170,11 +188,19 @@ namespace doll
 		m_uResX = uResX;
 		m_uResY = uResY;
 
+		m_context.resize( uResX, uResY );
+		invalidateState();
+
 		m_proj2D.loadOrthoProj( 0.0f, F32(uResX), F32(uResY), 0.0f, 0.0f, 1000.0f );
 	}
 	Void CGfxFrame::wsiPresent()
 	{
 		m_context.wsiPresent();
+		g_renderStats->endFrame();
+
+		m_lastStats = m_stats;
+		m_stats.cIssued = 0;
+		m_stats.cElided = 0;
 	}
 
 	IGfxAPIVBuffer *CGfxFrame::getMemVBuf( UPtr cBytes )
@@ -188,6 +214,11 @@ namespace doll
 			return 0;
 		}
 
+		// The old buffer's handle may be reused, and creating a buffer can
+		// bind it
+		forgetVBuffer( m_pMemVBuf );
+		forgetVBuffer( nullptr );
+
 		m_context.destroyVBuffer( m_pMemVBuf );
 		m_pMemVBuf = vbuf;
 
@@ -196,10 +227,12 @@ namespace doll
 
 	Void CGfxFrame::setLayout( SGfxLayout *p )
 	{
-		if( m_pLayout != p ) {
-			m_pLayout = p;
-			m_context.iaSetLayout( p != nullptr ? p->pAPIObj : nullptr );
+		if( isRedundant( kShadow_Layout, m_pLayout == p ) ) {
+			return;
 		}
+
+		m_pLayout = p;
+		m_context.iaSetLayout( p != nullptr ? p->pAPIObj : nullptr );
 	}
 	SGfxLayout *CGfxFrame::getLayout()
 	{
@@ -222,13 +255,250 @@ namespace doll
 		return m_context.createLayout( layout );
 	}
 
+	// Check a state change against the shadow state, counting it either way
+	Bool CGfxFrame::isRedundant( U32 uBit, Bool bSame )
+	{
+		if( ( m_shadow.uKnown & uBit ) != 0 && bSame ) {
+			++m_stats.cElided;
+			g_renderStats->countStateChange( true );
+			return true;
+		}
+
+		m_shadow.uKnown |= uBit;
+		++m_stats.cIssued;
+		g_renderStats->countStateChange( false );
+		return false;
+	}
+
+	Void CGfxFrame::setProjection( const F32 *matrix )
+	{
+		AX_ASSERT_NOT_NULL( matrix );
+
+		if( isRedundant( kShadow_Projection, memcmp( m_shadow.projection, matrix, sizeof( m_shadow.projection ) ) == 0 ) ) {
+			return;
+		}
+
+		memcpy( m_shadow.projection, matrix, sizeof( m_shadow.projection ) );
+		m_context.vsSetProjectionMatrix( matrix );
+	}
+	Void CGfxFrame::setModelView( const F32 *matrix )
+	{
+		AX_ASSERT_NOT_NULL( matrix );
+
+		if( isRedundant( kShadow_ModelView, memcmp( m_shadow.modelView, matrix, sizeof( m_shadow.modelView ) ) == 0 ) ) {
+			return;
+		}
+
+		memcpy( m_shadow.modelView, matrix, sizeof( m_shadow.modelView ) );
+		m_context.vsSetModelViewMatrix( matrix );
+	}
+	Void CGfxFrame::setScissorEnable( Bool enable )
+	{
+		if( isRedundant( kShadow_ScissorEnable, m_shadow.bScissor == enable ) ) {
+			return;
+		}
+
+		m_shadow.bScissor = enable;
+		m_context.psoSetScissorEnable( enable );
+	}
+	Void CGfxFrame::setScissor( S32 posX, S32 posY, U32 resX, U32 resY )
+	{
+		S32 *const p = m_shadow.scissor;
+		if( isRedundant( kShadow_Scissor, p[0] == posX && p[1] == posY && p[2] == S32( resX ) && p[3] == S32( resY ) ) ) {
+			return;
+		}
+
+		p[0] = posX;
+		p[1] = posY;
+		p[2] = S32( resX );
+		p[3] = S32( resY );
+		m_context.rsSetScissor( posX - m_targetOrigin[ 0 ], posY - m_targetOrigin[ 1 ], resX, resY );
+	}
+	Void CGfxFrame::setViewport( S32 posX, S32 posY, U32 resX, U32 resY )
+	{
+		S32 *const p = m_shadow.viewport;
+		if( isRedundant( kShadow_Viewport, p[0] == posX && p[1] == posY && p[2] == S32( resX ) && p[3] == S32( resY ) ) ) {
+			return;
+		}
+
+		p[0] = posX;
+		p[1] = posY;
+		p[2] = S32( resX );
+		p[3] = S32( resY );
+		m_context.rsSetViewport( posX - m_targetOrigin[ 0 ], posY - m_targetOrigin[ 1 ], resX, resY );
+	}
+	Void CGfxFrame::setBlend( EBlendOp op, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB )
+	{
+		// Render targets are drawn later as premultiplied alpha, so their
+		// alpha has to build up as coverage (a + d*(1 - a)) rather than be
+		// blended like the color, which would apply it twice
+		if( m_pTarget != nullptr && alphaA == kBlendSrcAlpha ) {
+			alphaA = kBlendOne;
+		}
+
+		EBlendFactor *const p = m_shadow.blendFactors;
+		if( isRedundant( kShadow_Blend, m_shadow.blendOp == op && p[0] == colA && p[1] == colB && p[2] == alphaA && p[3] == alphaB ) ) {
+			return;
+		}
+
+		m_shadow.blendOp = op;
+		p[0] = colA;
+		p[1] = colB;
+		p[2] = alphaA;
+		p[3] = alphaB;
+		m_context.psoSetBlend( op, colA, colB, alphaA, alphaB );
+	}
+	Bool CGfxFrame::getBlend( EBlendOp &op, EBlendFactor &colA, EBlendFactor &colB, EBlendFactor &alphaA, EBlendFactor &alphaB ) const
+	{
+		if( ( m_shadow.uKnown & kShadow_Blend ) == 0 ) {
+			return false;
+		}
+
+		op     = m_shadow.blendOp;
+		colA   = m_shadow.blendFactors[0];
+		colB   = m_shadow.blendFactors[1];
+		alphaA = m_shadow.blendFactors[2];
+		alphaB = m_shadow.blendFactors[3];
+		return true;
+	}
+	Void CGfxFrame::setTextureEnable( Bool enable )
+	{
+		if( m_shadow.bMultiTexture ) {
+			++m_stats.cIssued;
+			g_renderStats->countStateChange( false );
+			m_context.psoSetTextureEnable( enable );
+			return;
+		}
+
+		if( isRedundant( kShadow_TextureEnable, m_shadow.bTexture == enable ) ) {
+			return;
+		}
+
+		m_shadow.bTexture = enable;
+		m_context.psoSetTextureEnable( enable );
+	}
+	Void CGfxFrame::setTexture( IGfxAPITexture *pTexture, U32 uStage )
+	{
+		if( uStage != 0 ) {
+			m_shadow.bMultiTexture = true;
+		}
+
+		if( uStage >= kMaxTrackedTexStages ) {
+			++m_stats.cIssued;
+			g_renderStats->countStateChange( false );
+			g_renderStats->countTextureBind();
+			m_context.tsBindTexture( pTexture, uStage );
+			return;
+		}
+
+		const U32 uBit = U32( 1 )<<uStage;
+		if( ( m_shadow.uKnownTextures & uBit ) != 0 && m_shadow.pTextures[ uStage ] == pTexture ) {
+			++m_stats.cElided;
+			g_renderStats->countStateChange( true );
+			return;
+		}
+
+		m_shadow.uKnownTextures |= uBit;
+		m_shadow.pTextures[ uStage ] = pTexture;
+		++m_stats.cIssued;
+		g_renderStats->countStateChange( false );
+		g_renderStats->countTextureBind();
+		m_context.tsBindTexture( pTexture, uStage );
+	}
+	Void CGfxFrame::setVBuffer( IGfxAPIVBuffer *pVBuffer )
+	{
+		if( isRedundant( kShadow_VBuffer, m_shadow.pVBuffer == pVBuffer ) ) {
+			return;
+		}
+
+		m_shadow.pVBuffer = pVBuffer;
+		m_context.iaBindVBuffer( pVBuffer );
+	}
+	Void CGfxFrame::setIBuffer( IGfxAPIIBuffer *pIBuffer, EIndexFormat fmt )
+	{
+		if( isRedundant( kShadow_IBuffer, m_shadow.pIBuffer == pIBuffer && m_shadow.indexFormat == fmt ) ) {
+			return;
+		}
+
+		m_shadow.pIBuffer    = pIBuffer;
+		m_shadow.indexFormat = fmt;
+		m_context.iaBindIBuffer( pIBuffer, fmt );
+	}
+	Void CGfxFrame::setInstanceBuffer( IGfxAPIVBuffer *pVBuffer )
+	{
+		if( isRedundant( kShadow_InstanceBuffer, m_shadow.pInstanceBuffer == pVBuffer ) ) {
+			return;
+		}
+
+		m_shadow.pInstanceBuffer = pVBuffer;
+		m_context.iaBindInstanceBuffer( pVBuffer );
+	}
+
+	Void CGfxFrame::invalidateState()
+	{
+		m_shadow.uKnown         = 0;
+		m_shadow.uKnownTextures = 0;
+		m_shadow.bMultiTexture  = false;
+	}
+	Void CGfxFrame::forgetTexture( IGfxAPITexture *pTexture )
+	{
+		for( U32 i = 0; i < kMaxTrackedTexStages; ++i ) {
+			if( m_shadow.pTextures[ i ] == pTexture ) {
+				m_shadow.uKnownTextures &= ~( U32( 1 )<<i );
+			}
+		}
+	}
+	// A null buffer forgets whatever is bound (e.g., when creating a buffer)
+	Void CGfxFrame::forgetVBuffer( IGfxAPIVBuffer *pVBuffer )
+	{
+		if( !pVBuffer || m_shadow.pVBuffer == pVBuffer ) {
+			m_shadow.uKnown &= ~U32( kShadow_VBuffer );
+		}
+		if( !pVBuffer || m_shadow.pInstanceBuffer == pVBuffer ) {
+			m_shadow.uKnown &= ~U32( kShadow_InstanceBuffer );
+		}
+	}
+	Void CGfxFrame::forgetIBuffer( IGfxAPIIBuffer *pIBuffer )
+	{
+		if( !pIBuffer || m_shadow.pIBuffer == pIBuffer ) {
+			m_shadow.uKnown &= ~U32( kShadow_IBuffer );
+		}
+	}
+
+	Void CGfxFrame::setRenderTarget( IGfxAPIRenderTarget *pTarget, S32 originX, S32 originY )
+	{
+		if( !pTarget ) {
+			originX = 0;
+			originY = 0;
+		}
+
+		if( m_pTarget == pTarget && m_targetOrigin[ 0 ] == originX && m_targetOrigin[ 1 ] == originY ) {
+			return;
+		}
+
+		if( m_pTarget != pTarget ) {
+			m_context.omBindRenderTarget( pTarget );
+		}
+
+		m_pTarget = pTarget;
+		m_targetOrigin[ 0 ] = originX;
+		m_targetOrigin[ 1 ] = originY;
+
+		// The backend's rectangles were relative to the old target
+		m_shadow.uKnown &= ~U32( kShadow_Scissor | kShadow_Viewport );
+	}
+	Void CGfxFrame::clearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value )
+	{
+		m_context.cmdClearRect( posX - m_targetOrigin[ 0 ], posY - m_targetOrigin[ 1 ], resX, resY, value );
+	}
+
 	DOLL_FUNC IGfxAPI *DOLL_API gfx_initAPI( OSWindow wnd, const SGfxInitDesc *pInitDesc )
 	{
 #if DOLL__USE_GLFW && 0 // FIXME: Why was this here?
 		AX_ASSERT_IS_NULL( wnd );
-#else
-		AX_ASSERT_NOT_NULL( wnd );
 #endif
+		// Providers that need a window check for one themselves; the software
+		// renderer can run without (headless)
 
 		if( !pInitDesc || pInitDesc->apis.isEmpty() ) {
 			DOLL_TRACE( "Filling in defaults for initialization API..." );
@@ -279,14 +549,30 @@ namespace doll
 
 	DOLL_FUNC Void DOLL_API gfx_r_setFrame( CGfxFrame *pFrame )
 	{
-		g_pCurrentFrame =  pFrame;
-		g_pCurrentAPI   = &pFrame->getContext();
+		// Another frame may have changed the state of a shared context
+		if( pFrame != nullptr && g_pCurrentFrame != pFrame ) {
+			pFrame->invalidateState();
+		}
+
+		g_pCurrentFrame = pFrame;
+		g_pCurrentAPI   = pFrame != nullptr ? &pFrame->getContext() : nullptr;
 	}
 	DOLL_FUNC CGfxFrame *DOLL_API gfx_r_getFrame()
 	{
 		return g_pCurrentFrame;
 	}
 
+	DOLL_FUNC Void DOLL_API gfx_r_invalidateState()
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->invalidateState();
+	}
+	DOLL_FUNC Void DOLL_API gfx_r_getStateStats( SGfxStateStats &outStats )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		outStats = g_pCurrentFrame->getStateStats();
+	}
+
 	DOLL_FUNC U32 DOLL_API gfx_r_resX()
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
@@ -300,83 +586,160 @@ namespace doll
 
 	DOLL_FUNC Void DOLL_API gfx_r_loadProjection( const F32 *matrix )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->vsSetProjectionMatrix( matrix );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setProjection( matrix );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_loadModelView( const F32 *matrix )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->vsSetModelViewMatrix( matrix );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setModelView( matrix );
 	}
 
 	DOLL_FUNC Void DOLL_API gfx_r_enableScissor()
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->psoSetScissorEnable( true );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setScissorEnable( true );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_disableScissor()
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->psoSetScissorEnable( false );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setScissorEnable( false );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_setScissor( S32 posX, S32 posY, U32 resX, U32 resY )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->rsSetScissor( posX, posY, resX, resY );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setScissor( posX, posY, resX, resY );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_clearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->cmdClearRect( posX, posY, resX, resY, value );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->clearRect( posX, posY, resX, resY, value );
 	}
 
 	DOLL_FUNC Void DOLL_API gfx_r_setViewport( S32 posX, S32 posY, U32 resX, U32 resY )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->rsSetViewport( posX, posY, resX, resY );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setViewport( posX, posY, resX, resY );
 	}
 
 	DOLL_FUNC UPtr DOLL_API gfx_r_createTexture( ETextureFormat fmt, U16 resX, U16 resY, const U8 *data )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		if( data != nullptr ) {
+			g_renderStats->countTextureBytes( UPtr( resX )*UPtr( resY )*gfx_getTexelByteSize( fmt ) );
+		}
 		return (UPtr)g_pCurrentAPI->createTexture( fmt, resX, resY, data );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_destroyTexture( UPtr tex )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->forgetTexture( (IGfxAPITexture*)tex );
 		g_pCurrentAPI->destroyTexture( (IGfxAPITexture*)tex );
 	}
 
-	DOLL_FUNC Void DOLL_API gfx_r_updateTexture( UPtr tex, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *data )
+	DOLL_FUNC Void DOLL_API gfx_r_updateTexture( UPtr tex, ETextureFormat fmt, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *data )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		g_renderStats->countTextureBytes( UPtr( resX )*UPtr( resY )*gfx_getTexelByteSize( fmt ) );
 		g_pCurrentAPI->cmdUpdateTexture( (IGfxAPITexture*)tex, posX, posY, resX, resY, data );
 	}
 
-	DOLL_FUNC Void DOLL_API gfx_r_setBlend( EBlendOp op, EBlendFactor srgb, EBlendFactor drgb, EBlendFactor sa, EBlendFactor da )
+	DOLL_FUNC UPtr DOLL_API gfx_r_createRenderTarget( U16 resX, U16 resY )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->psoSetBlend( op, srgb, drgb, sa, da );
+		return (UPtr)g_pCurrentAPI->createRenderTarget( resX, resY );
 	}
+	DOLL_FUNC Void DOLL_API gfx_r_destroyRenderTarget( UPtr rt )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		if( !rt ) {
+			return;
+		}
 
-	DOLL_FUNC Void DOLL_API gfx_r_enableTexture2D()
+		IGfxAPIRenderTarget *const pTarget = (IGfxAPIRenderTarget*)rt;
+		if( g_pCurrentFrame->getRenderTarget() == pTarget ) {
+			g_pCurrentFrame->setRenderTarget( nullptr );
+		}
+		g_pCurrentFrame->forgetTexture( g_pCurrentAPI->getRenderTargetTexture( pTarget ) );
+		g_pCurrentAPI->destroyRenderTarget( pTarget );
+	}
+	DOLL_FUNC Void DOLL_API gfx_r_setRenderTarget( UPtr rt, S32 originX, S32 originY )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setRenderTarget( (IGfxAPIRenderTarget*)rt, originX, originY );
+	}
+	DOLL_FUNC UPtr DOLL_API gfx_r_getRenderTarget( S32 *pOutOriginX, S32 *pOutOriginY )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		if( pOutOriginX != nullptr ) {
+			*pOutOriginX = g_pCurrentFrame->getRenderTargetOriginX();
+		}
+		if( pOutOriginY != nullptr ) {
+			*pOutOriginY = g_pCurrentFrame->getRenderTargetOriginY();
+		}
+		return (UPtr)g_pCurrentFrame->getRenderTarget();
+	}
+	DOLL_FUNC UPtr DOLL_API gfx_r_resolveRenderTarget( UPtr rt )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->psoSetTextureEnable( true );
+		if( !rt ) {
+			return 0;
+		}
+
+		g_pCurrentAPI->cmdResolveRenderTarget( (IGfxAPIRenderTarget*)rt );
+		return (UPtr)g_pCurrentAPI->getRenderTargetTexture( (IGfxAPIRenderTarget*)rt );
 	}
-	DOLL_FUNC Void DOLL_API gfx_r_disableTexture2D()
+	DOLL_FUNC UPtr DOLL_API gfx_r_getRenderTargetTexture( UPtr rt )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->psoSetTextureEnable( false );
+		return rt != 0 ? (UPtr)g_pCurrentAPI->getRenderTargetTexture( (IGfxAPIRenderTarget*)rt ) : 0;
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_r_setBlend( EBlendOp op, EBlendFactor srgb, EBlendFactor drgb, EBlendFactor sa, EBlendFactor da )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setBlend( op, srgb, drgb, sa, da );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_r_getBlend( EBlendOp *op, EBlendFactor *srgb, EBlendFactor *drgb, EBlendFactor *sa, EBlendFactor *da )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		AX_ASSERT_NOT_NULL( op );
+		AX_ASSERT_NOT_NULL( srgb );
+		AX_ASSERT_NOT_NULL( drgb );
+		AX_ASSERT_NOT_NULL( sa );
+		AX_ASSERT_NOT_NULL( da );
+
+		if( g_pCurrentFrame->getBlend( *op, *srgb, *drgb, *sa, *da ) ) {
+			return true;
+		}
+
+		// What the backend's default state has
+		*op   = kBlendAdd;
+		*srgb = kBlendSrcAlpha;
+		*drgb = kBlendInvSrcAlpha;
+		*sa   = kBlendSrcAlpha;
+		*da   = kBlendInvSrcAlpha;
+		return false;
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_r_enableTexture2D()
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setTextureEnable( true );
+	}
+	DOLL_FUNC Void DOLL_API gfx_r_disableTexture2D()
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setTextureEnable( false );
 	}
 
 	DOLL_FUNC Void DOLL_API gfx_r_setTexture( UPtr tex, U32 stage )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->tsBindTexture( (IGfxAPITexture*)tex, stage );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setTexture( (IGfxAPITexture*)tex, stage );
 	}
 
-	DOLL_FUNC UPtr DOLL_API gfx_r_createLayout( UPtr stride )
+	DOLL_FUNC UPtr DOLL_API gfx_r_createLayout( UPtr stride, UPtr instanceStride )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
 
@@ -385,8 +748,9 @@ namespace doll
 			return 0;
 		}
 
-		p->stride    = stride;
-		p->cElements = 0;
+		p->stride         = stride;
+		p->instanceStride = instanceStride;
+		p->cElements      = 0;
 
 		p->pAPIObj   = nullptr;
 
@@ -405,21 +769,27 @@ namespace doll
 		delete p;
 	}
 
-	static SGfxLayoutElement *gfx_r_nextElement( SGfxLayout *p, UPtr offset )
+	static SGfxLayoutElement *gfx_r_nextElement( SGfxLayout *p, UPtr offset, U32 uStepRate )
 	{
 		AX_ASSERT_NOT_NULL( p );
 		AX_ASSERT( p->cElements < kMaxLayoutElements );
 
+		// Per-vertex and per-instance elements live in separate buffers, so
+		// each kind follows the last element of the same kind
 		if( offset == ~0U ) {
-			if( p->cElements > 0 ) {
-				offset = p->elements[p->cElements-1].uOffset + p->elements[p->cElements-1].cBytes;
-			} else {
-				offset = 0;
+			offset = 0;
+			for( UPtr i = p->cElements; i > 0; --i ) {
+				const SGfxLayoutElement &prev = p->elements[ i - 1 ];
+				if( ( prev.uStepRate != 0 ) == ( uStepRate != 0 ) ) {
+					offset = prev.uOffset + prev.cBytes;
+					break;
+				}
 			}
 		}
 
 		SGfxLayoutElement *const pElm = &p->elements[ p->cElements++ ];
-		pElm->uOffset = offset;
+		pElm->uOffset   = offset;
+		pElm->uStepRate = uStepRate;
 
 		return pElm;
 	}
@@ -463,12 +833,22 @@ namespace doll
 
 		return false;
 	}
+	inline Bool gfx_r_layoutHasVertexRect( const SGfxLayout *p )
+	{
+		for( UPtr i = 0; i < p->cElements; ++i ) {
+			if( p->elements[ i ].type == kGfxLayoutElementVertexRect ) {
+				return true;
+			}
+		}
 
-	DOLL_FUNC Void DOLL_API gfx_r_layoutVertex( UPtr layout, EVectorSize size, EVectorType type, UPtr offset )
+		return false;
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_r_layoutVertex( UPtr layout, EVectorSize size, EVectorType type, UPtr offset, U32 uStepRate )
 	{
 		AX_ASSERT( !gfx_r_layoutHasVertex( ( SGfxLayout * )layout ) );
 
-		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset );
+		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset, uStepRate );
 
 		p->type = kGfxLayoutElementVertex;
 		
@@ -477,11 +857,11 @@ namespace doll
 
 		p->cBytes = gfx_r_calcSize( size, type );
 	}
-	DOLL_FUNC Void DOLL_API gfx_r_layoutNormal( UPtr layout, EVectorType type, UPtr offset )
+	DOLL_FUNC Void DOLL_API gfx_r_layoutNormal( UPtr layout, EVectorType type, UPtr offset, U32 uStepRate )
 	{
 		AX_ASSERT( !gfx_r_layoutHasNormal( ( SGfxLayout * )layout ) );
 
-		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset );
+		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset, uStepRate );
 
 		p->type = kGfxLayoutElementNormal;
 
@@ -490,11 +870,11 @@ namespace doll
 
 		p->cBytes = gfx_r_calcSize( kVectorSize3, type );
 	}
-	DOLL_FUNC Void DOLL_API gfx_r_layoutColor( UPtr layout, EVectorSize size, EVectorType type, UPtr offset )
+	DOLL_FUNC Void DOLL_API gfx_r_layoutColor( UPtr layout, EVectorSize size, EVectorType type, UPtr offset, U32 uStepRate )
 	{
 		AX_ASSERT( !gfx_r_layoutHasColor( ( SGfxLayout * )layout ) );
 
-		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset );
+		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset, uStepRate );
 
 		p->type = kGfxLayoutElementColor;
 
@@ -503,9 +883,9 @@ namespace doll
 
 		p->cBytes = gfx_r_calcSize( size, type );
 	}
-	DOLL_FUNC Void DOLL_API gfx_r_layoutTexCoord( UPtr layout, EVectorSize size, EVectorType type, UPtr offset )
+	DOLL_FUNC Void DOLL_API gfx_r_layoutTexCoord( UPtr layout, EVectorSize size, EVectorType type, UPtr offset, U32 uStepRate )
 	{
-		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset );
+		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset, uStepRate );
 
 		p->type = kGfxLayoutElementTexCoord;
 
@@ -514,6 +894,30 @@ namespace doll
 
 		p->cBytes = gfx_r_calcSize( size, type );
 	}
+	DOLL_FUNC Void DOLL_API gfx_r_layoutVertexRect( UPtr layout, EVectorType type, UPtr offset, U32 uStepRate )
+	{
+		AX_ASSERT( !gfx_r_layoutHasVertexRect( ( SGfxLayout * )layout ) );
+
+		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset, uStepRate );
+
+		p->type = kGfxLayoutElementVertexRect;
+
+		p->cComps = kVectorSize4;
+		p->compTy = type;
+
+		p->cBytes = gfx_r_calcSize( kVectorSize4, type );
+	}
+	DOLL_FUNC Void DOLL_API gfx_r_layoutTexCoordRect( UPtr layout, EVectorType type, UPtr offset, U32 uStepRate )
+	{
+		SGfxLayoutElement *const p = gfx_r_nextElement( ( SGfxLayout * )layout, offset, uStepRate );
+
+		p->type = kGfxLayoutElementTexCoordRect;
+
+		p->cComps = kVectorSize4;
+		p->compTy = type;
+
+		p->cBytes = gfx_r_calcSize( kVectorSize4, type );
+	}
 	DOLL_FUNC Bool DOLL_API gfx_r_finishLayout( UPtr layout )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
@@ -525,16 +929,25 @@ namespace doll
 			return false;
 		}
 
-		if( p->stride == 0 ) {
+		if( p->stride == 0 || p->instanceStride == 0 ) {
 			UPtr best = 0;
+			UPtr bestInstance = 0;
 			for( UPtr i = 0; i < p->cElements; ++i ) {
 				const UPtr test = p->elements[ i ].uOffset + p->elements[ i ].cBytes;
-				if( best < test ) {
-					best = test;
+				UPtr &dst = p->elements[ i ].uStepRate != 0 ? bestInstance : best;
+				if( dst < test ) {
+					dst = test;
 				}
 			}
 
-			if( !( p->stride = best ) ) {
+			if( p->stride == 0 ) {
+				p->stride = best;
+			}
+			if( p->instanceStride == 0 ) {
+				p->instanceStride = bestInstance;
+			}
+
+			if( !p->stride && !p->instanceStride ) {
 				return false;
 			}
 		}
@@ -560,12 +973,15 @@ namespace doll
 
 	DOLL_FUNC UPtr DOLL_API gfx_r_createVBuffer( UPtr size, const void *pData, EBufferPerformance perf, EBufferPurpose purpose )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		// Creating a buffer may bind it
+		g_pCurrentFrame->forgetVBuffer( nullptr );
 		return (UPtr)g_pCurrentAPI->createVBuffer( size, pData, perf, purpose );
 	}
 	DOLL_FUNC UPtr DOLL_API gfx_r_createIBuffer( UPtr size, const void *pData, EBufferPerformance perf, EBufferPurpose purpose )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->forgetIBuffer( nullptr );
 		return (UPtr)g_pCurrentAPI->createIBuffer( size, pData, perf, purpose );
 	}
 	DOLL_FUNC UPtr DOLL_API gfx_r_createUBuffer( UPtr size, const void *pData, EBufferPerformance perf, EBufferPurpose purpose )
@@ -578,6 +994,7 @@ namespace doll
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
 		AX_ASSERT_NOT_NULL( vbuffer );
+		g_renderStats->countVBufferBytes( size );
 		g_pCurrentAPI->cmdWriteVBuffer( (IGfxAPIVBuffer*)vbuffer, offset, size, pData );
 		return true;
 	}
@@ -620,12 +1037,14 @@ namespace doll
 
 	DOLL_FUNC Void DOLL_API gfx_r_destroyVBuffer( UPtr vbuffer )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->forgetVBuffer( (IGfxAPIVBuffer*)vbuffer );
 		g_pCurrentAPI->destroyVBuffer( (IGfxAPIVBuffer*)vbuffer );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_destroyIBuffer( UPtr ibuffer )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->forgetIBuffer( (IGfxAPIIBuffer*)ibuffer );
 		g_pCurrentAPI->destroyIBuffer( (IGfxAPIIBuffer*)ibuffer );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_destroyUBuffer( UPtr ubuffer )
@@ -636,13 +1055,18 @@ namespace doll
 
 	DOLL_FUNC Void DOLL_API gfx_r_setVBuffer( UPtr vbuffer )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->iaBindVBuffer( (IGfxAPIVBuffer*)vbuffer );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setVBuffer( (IGfxAPIVBuffer*)vbuffer );
 	}
-	DOLL_FUNC Void DOLL_API gfx_r_setIBuffer( UPtr ibuffer )
+	DOLL_FUNC Void DOLL_API gfx_r_setIBuffer( UPtr ibuffer, EIndexFormat fmt )
 	{
-		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
-		g_pCurrentAPI->iaBindIBuffer( (IGfxAPIIBuffer*)ibuffer );
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setIBuffer( (IGfxAPIIBuffer*)ibuffer, fmt );
+	}
+	DOLL_FUNC Void DOLL_API gfx_r_setInstanceBuffer( UPtr vbuffer )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
+		g_pCurrentFrame->setInstanceBuffer( (IGfxAPIVBuffer*)vbuffer );
 	}
 
 	DOLL_FUNC Void DOLL_API gfx_r_bindProgram( UPtr program )
@@ -664,13 +1088,27 @@ namespace doll
 	DOLL_FUNC Void DOLL_API gfx_r_draw( ETopology mode, U32 cVerts, U32 uOffset )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		g_renderStats->countDraw( cVerts );
 		g_pCurrentAPI->cmdDraw( mode, cVerts, uOffset );
 	}
 	DOLL_FUNC Void DOLL_API gfx_r_drawIndexed( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		g_renderStats->countDraw( cIndices );
 		g_pCurrentAPI->cmdDrawIndexed( mode, cIndices, uOffset, uBias );
 	}
+	DOLL_FUNC Void DOLL_API gfx_r_drawInstanced( ETopology mode, U32 cVerts, U32 cInstances, U32 uOffset )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		g_renderStats->countDraw( cVerts*cInstances );
+		g_pCurrentAPI->cmdDrawInstanced( mode, cVerts, uOffset, cInstances );
+	}
+	DOLL_FUNC Void DOLL_API gfx_r_drawIndexedInstanced( ETopology mode, U32 cIndices, U32 cInstances, U32 uOffset, U32 uBias )
+	{
+		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentAPI );
+		g_renderStats->countDraw( cIndices*cInstances );
+		g_pCurrentAPI->cmdDrawIndexedInstanced( mode, cIndices, uOffset, uBias, cInstances );
+	}
 	DOLL_FUNC Void DOLL_API gfx_r_drawMem( ETopology mode, U32 cVerts, UPtr cStrideBytes, const void *pMem )
 	{
 		DOLL_GFXAPI_ASSERT_CURFRAME( g_pCurrentFrame );
@@ -0,0 +1,984 @@
+#define DOLL_TRACE_FACILITY doll::kLog_GfxOSText
+#include "../../BuildSettings.hpp"
+
+#include "OSText_FreeType.hpp"
+
+#include "doll/Core/Logger.hpp"
+#include "doll/Core/Memory.hpp"
+#include "doll/Core/MemoryTags.hpp"
+#include "doll/Gfx/Texture.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+#include "doll/IO/File.hpp"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+#include FT_STROKER_H
+
+#include <stdio.h>
+
+namespace doll { namespace FreeType {
+
+	// Resolution of each glyph page (atlas)
+	static const U16 kGlyphPageRes = 512;
+	// Outline radius in 26.6; matches the 3px pen of the GDI+ backend
+	static const FT_Fixed kStrokeRadius = 96;
+	// Maximum number of distinct font files
+	static const U16 kMaxFaces = 32;
+
+	// Directories searched for the files in `kFontAliases`, and for
+	// "<family>.ttf" when a family name isn't an alias
+	static const char *const kFontDirs[] = {
+		"/usr/share/fonts/truetype/dejavu",
+		"/usr/share/fonts/truetype/liberation",
+		"/usr/share/fonts/truetype/freefont",
+		"/usr/share/fonts/truetype",
+		"/usr/share/fonts/TTF",
+		"/usr/share/fonts/dejavu",
+		"/usr/share/fonts/liberation",
+		"/usr/share/fonts/gnu-free",
+		"/usr/share/fonts",
+		"/usr/local/share/fonts"
+	};
+	static const struct {
+		const char *pszFamily;
+		const char *pszFile;
+	} kFontAliases[] = {
+		{ "sans",      "DejaVuSans.ttf" },
+		{ "sans",      "LiberationSans-Regular.ttf" },
+		{ "sans",      "FreeSans.ttf" },
+		{ "serif",     "DejaVuSerif.ttf" },
+		{ "serif",     "LiberationSerif-Regular.ttf" },
+		{ "serif",     "FreeSerif.ttf" },
+		{ "monospace", "DejaVuSansMono.ttf" },
+		{ "monospace", "LiberationMono-Regular.ttf" },
+		{ "monospace", "FreeMono.ttf" }
+	};
+
+	static inline bool isName( const Str &s, const char *pszName ) {
+		const UPtr n = strlen( pszName );
+		return s.num() == n && memcmp( s.get(), pszName, n ) == 0;
+	}
+	static inline U32 mixKey( U32 a, U32 b ) {
+		const U64 x = ( ( U64( a )<<32 ) | U64( b ) )*U64( 0x9E3779B97F4A7C15ULL );
+		return U32( x>>32 ) ^ U32( x );
+	}
+
+	// Decode one UTF-8 code point, advancing `p`
+	static U32 decodeUTF8( const char *&p, const char *e ) {
+		const U8 c = U8( *p++ );
+		if( c < 0x80 ) {
+			return c;
+		}
+
+		U32 n, cp;
+		if( ( c & 0xE0 ) == 0xC0 ) {
+			n = 1; cp = c & 0x1F;
+		} else if( ( c & 0xF0 ) == 0xE0 ) {
+			n = 2; cp = c & 0x0F;
+		} else if( ( c & 0xF8 ) == 0xF0 ) {
+			n = 3; cp = c & 0x07;
+		} else {
+			return 0xFFFD;
+		}
+
+		while( n-- > 0 ) {
+			if( p == e || ( U8( *p ) & 0xC0 ) != 0x80 ) {
+				return 0xFFFD;
+			}
+			cp = ( cp<<6 ) | ( U8( *p++ ) & 0x3F );
+		}
+
+		return cp;
+	}
+
+	// ------------------------------------------------------------------ //
+
+	struct SFace {
+		char    szName[ 128 ];
+		FT_Face face;
+		// File contents when loaded through the VFS (must outlive `face`)
+		U8 *    pFileData;
+		// Pixel size currently selected on `face`
+		U16     uActiveSize;
+	};
+	struct SKerning {
+		U32 uSizeKey;
+		U32 uLeft;
+		U32 uRight;
+		S32 iKerning;
+	};
+
+	// Shared cache of faces, glyphs, kerning pairs and glyph pages
+	class MGlyphCache {
+	public:
+		static MGlyphCache &get();
+
+		U16 findFace( Str fontFamily );
+		const char *getFamilyName( U16 uFace ) const;
+		bool getSizeMetrics( U16 uFace, U16 uPixelSize, S32 &iAscender, S32 &iLineHeight );
+
+		U32 getGlyphIndex( U16 uFace, U32 utf32Char );
+		SGlyph *getGlyph( U16 uFace, U16 uPixelSize, U32 uGlyphIndex );
+		SGlyph *getStrokeGlyph( SGlyph &glyph );
+		S32 getKerning( U16 uFace, U16 uPixelSize, U32 uLeft, U32 uRight );
+
+		RTexture *getTexture( SGlyph &glyph );
+
+		// Release the glyph textures and pages (they are made again on the
+		// next draw); must be called before the render API is finalized
+		void fini();
+
+	private:
+		FT_Library                    m_library;
+		FT_Stroker                    m_stroker;
+
+		SFace                         m_faces[ kMaxFaces ];
+		U16                           m_cFaces;
+
+		// Open-addressed; slots are null when empty
+		SGlyph **                     m_pGlyphSlots;
+		U32                           m_cGlyphSlots;
+		U32                           m_cGlyphs;
+
+		// Open-addressed; `uSizeKey` is zero when empty
+		SKerning *                    m_pKerningSlots;
+		U32                           m_cKerningSlots;
+		U32                           m_cKernings;
+
+		TSmallArr<CTextureAtlas *, 4> m_pages;
+
+		MGlyphCache();
+		~MGlyphCache();
+
+		bool openFace( SFace &dst, const char *pszPath );
+		bool selectSize( SFace &face, U16 uPixelSize );
+		SGlyph *newGlyph( U16 uFace, U16 uPixelSize, U32 uGlyphIndex, bool bStroke, const FT_Bitmap &bitmap, S32 iLeft, S32 iTop, S32 iAdvance );
+
+		bool growGlyphSlots();
+		bool growKerningSlots();
+	};
+	static TManager<MGlyphCache> g_glyphCache;
+
+	// Scratch layout for draw() and render(); text is only drawn from the
+	// render thread
+	static STextLayout g_scratchLayout;
+
+	MGlyphCache &MGlyphCache::get() {
+		static MGlyphCache instance;
+		return instance;
+	}
+
+	MGlyphCache::MGlyphCache()
+	: m_library( nullptr )
+	, m_stroker( nullptr )
+	, m_cFaces( 0 )
+	, m_pGlyphSlots( nullptr )
+	, m_cGlyphSlots( 0 )
+	, m_cGlyphs( 0 )
+	, m_pKerningSlots( nullptr )
+	, m_cKerningSlots( 0 )
+	, m_cKernings( 0 )
+	, m_pages()
+	{
+		DOLL_TRACE( "MGlyphCache::MGlyphCache()" );
+
+		if( FT_Init_FreeType( &m_library ) != 0 ) {
+			g_ErrorLog += "FreeType failed to initialize";
+			m_library = nullptr;
+			return;
+		}
+
+		if( FT_Stroker_New( m_library, &m_stroker ) != 0 ) {
+			m_stroker = nullptr;
+		} else {
+			FT_Stroker_Set( m_stroker, kStrokeRadius, FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0 );
+		}
+	}
+	MGlyphCache::~MGlyphCache() {
+		DOLL_TRACE( "MGlyphCache::~MGlyphCache()" );
+
+		// Only CPU side state is released here; this runs at exit, after the
+		// render API is gone, so the textures must have been released by
+		// fini() already
+		AX_ASSERT( m_pages.len() == 0 );
+
+		for( U32 i = 0; i < m_cGlyphSlots; ++i ) {
+			SGlyph *pGlyph = m_pGlyphSlots[ i ];
+			if( !pGlyph ) {
+				continue;
+			}
+
+			if( pGlyph->pStroke != nullptr ) {
+				DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )pGlyph->pStroke );
+			}
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )pGlyph );
+		}
+		if( m_pGlyphSlots != nullptr ) {
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pGlyphSlots );
+		}
+		if( m_pKerningSlots != nullptr ) {
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pKerningSlots );
+		}
+
+		for( U16 i = 0; i < m_cFaces; ++i ) {
+			FT_Done_Face( m_faces[ i ].face );
+			if( m_faces[ i ].pFileData != nullptr ) {
+				core_freeFile( m_faces[ i ].pFileData );
+			}
+		}
+
+		if( m_stroker != nullptr ) {
+			FT_Stroker_Done( m_stroker );
+		}
+		if( m_library != nullptr ) {
+			FT_Done_FreeType( m_library );
+		}
+	}
+
+	void MGlyphCache::fini() {
+		DOLL_TRACE( "MGlyphCache::fini()" );
+
+		// The glyphs keep their coverage, so getTexture() can upload them
+		// again if text is drawn after the render API is brought back up
+		for( U32 i = 0; i < m_cGlyphSlots; ++i ) {
+			SGlyph *pGlyph = m_pGlyphSlots[ i ];
+			if( !pGlyph ) {
+				continue;
+			}
+
+			if( pGlyph->pStroke != nullptr && pGlyph->pStroke->pTexture != nullptr ) {
+				pGlyph->pStroke->pTexture = gfx_deleteTexture( pGlyph->pStroke->pTexture );
+			}
+			if( pGlyph->pTexture != nullptr ) {
+				pGlyph->pTexture = gfx_deleteTexture( pGlyph->pTexture );
+			}
+		}
+
+		for( SizeType i = 0; i < m_pages.len(); ++i ) {
+			gfx_deleteTextureAtlas( m_pages[ i ] );
+		}
+		m_pages.clear();
+	}
+
+	void fini() {
+		g_glyphCache->fini();
+	}
+
+	bool MGlyphCache::openFace( SFace &dst, const char *pszPath ) {
+		dst.face = nullptr;
+		dst.pFileData = nullptr;
+		dst.uActiveSize = 0;
+
+		// System fonts are opened directly; anything else goes through the VFS
+		if( pszPath[ 0 ] == '/' ) {
+			return FT_New_Face( m_library, pszPath, 0, &dst.face ) == 0;
+		}
+
+		UPtr cFileBytes = 0;
+		if( !core_loadFile( pszPath, dst.pFileData, cFileBytes, kTag_Font ) ) {
+			dst.pFileData = nullptr;
+			return false;
+		}
+
+		if( FT_New_Memory_Face( m_library, dst.pFileData, FT_Long( cFileBytes ), 0, &dst.face ) != 0 ) {
+			core_freeFile( dst.pFileData );
+			dst.pFileData = nullptr;
+			dst.face = nullptr;
+			return false;
+		}
+
+		return true;
+	}
+	U16 MGlyphCache::findFace( Str fontFamily ) {
+		if( !m_library ) {
+			return 0;
+		}
+
+		for( U16 i = 0; i < m_cFaces; ++i ) {
+			if( isName( fontFamily, m_faces[ i ].szName ) ) {
+				return i + 1;
+			}
+		}
+
+		if( m_cFaces == kMaxFaces ) {
+			g_WarningLog += "Too many fonts loaded";
+			return 0;
+		}
+
+		SFace &face = m_faces[ m_cFaces ];
+		snprintf( face.szName, sizeof( face.szName ), "%.*s", fontFamily.lenInt(), fontFamily.get() );
+
+		char szPath[ 512 ];
+		bool bFound = false;
+
+		// A path (either to a system font or a file in the VFS)
+		if( fontFamily.find( '/' ) >= 0 || fontFamily.find( '.' ) >= 0 ) {
+			bFound = openFace( face, face.szName );
+		}
+
+		// One of the generic family names
+		const char *pszAlias = isName( fontFamily, "sans-serif" ) ? "sans" : face.szName;
+		for( const auto &alias : kFontAliases ) {
+			if( bFound ) {
+				break;
+			}
+			if( strcmp( alias.pszFamily, pszAlias ) != 0 ) {
+				continue;
+			}
+
+			for( const char *pszDir : kFontDirs ) {
+				snprintf( szPath, sizeof( szPath ), "%s/%s", pszDir, alias.pszFile );
+				if( ( bFound = openFace( face, szPath ) ) == true ) {
+					break;
+				}
+			}
+		}
+
+		// "<family>.ttf" or "<family>-Regular.ttf" in one of the font directories
+		for( const char *pszDir : kFontDirs ) {
+			if( bFound ) {
+				break;
+			}
+
+			snprintf( szPath, sizeof( szPath ), "%s/%s.ttf", pszDir, face.szName );
+			if( ( bFound = openFace( face, szPath ) ) == true ) {
+				break;
+			}
+			snprintf( szPath, sizeof( szPath ), "%s/%s-Regular.ttf", pszDir, face.szName );
+			bFound = openFace( face, szPath );
+		}
+
+		if( !bFound ) {
+			if( strcmp( face.szName, "sans" ) != 0 ) {
+				g_WarningLog( face.szName ) += "Font not found; using the default sans font instead";
+				return findFace( "sans" );
+			}
+
+			g_ErrorLog += "No usable font was found";
+			return 0;
+		}
+
+		DOLL_TRACE( axf( "Loaded font \"%s\" (%s %s)", face.szName, face.face->family_name, face.face->style_name ) );
+
+		++m_cFaces;
+		return m_cFaces;
+	}
+
+	const char *MGlyphCache::getFamilyName( U16 uFace ) const {
+		AX_ASSERT( uFace > 0 && uFace <= m_cFaces );
+
+		const FT_Face face = m_faces[ uFace - 1 ].face;
+		return face->family_name != nullptr ? face->family_name : "";
+	}
+
+	bool MGlyphCache::selectSize( SFace &face, U16 uPixelSize ) {
+		if( face.uActiveSize == uPixelSize ) {
+			return true;
+		}
+
+		if( FT_Set_Pixel_Sizes( face.face, 0, uPixelSize ) != 0 ) {
+			return false;
+		}
+
+		face.uActiveSize = uPixelSize;
+		return true;
+	}
+	bool MGlyphCache::getSizeMetrics( U16 uFace, U16 uPixelSize, S32 &iAscender, S32 &iLineHeight ) {
+		AX_ASSERT( uFace > 0 && uFace <= m_cFaces );
+
+		SFace &face = m_faces[ uFace - 1 ];
+		if( !selectSize( face, uPixelSize ) ) {
+			return false;
+		}
+
+		const FT_Size_Metrics &metrics = face.face->size->metrics;
+		iAscender = S32( ( metrics.ascender + 63 )>>6 );
+		iLineHeight = S32( ( metrics.height + 63 )>>6 );
+
+		return true;
+	}
+
+	U32 MGlyphCache::getGlyphIndex( U16 uFace, U32 utf32Char ) {
+		AX_ASSERT( uFace > 0 && uFace <= m_cFaces );
+		return U32( FT_Get_Char_Index( m_faces[ uFace - 1 ].face, FT_ULong( utf32Char ) ) );
+	}
+
+	SGlyph *MGlyphCache::newGlyph( U16 uFace, U16 uPixelSize, U32 uGlyphIndex, bool bStroke, const FT_Bitmap &bitmap, S32 iLeft, S32 iTop, S32 iAdvance ) {
+		const U32 uResX = bitmap.width;
+		const U32 uResY = bitmap.rows;
+		if( !AX_VERIFY_MSG( uResX < 0x10000 && uResY < 0x10000, "Glyph is too large" ) ) {
+			return nullptr;
+		}
+
+		SGlyph *const pGlyph = reinterpret_cast< SGlyph * >( DOLL_ALLOC( *DOLL__DEFAULT_ALLOCATOR, sizeof( SGlyph ) + uResX*uResY, kTag_Font ) );
+		if( !AX_VERIFY_MEMORY( pGlyph ) ) {
+			return nullptr;
+		}
+
+		pGlyph->uFace       = uFace;
+		pGlyph->uPixelSize  = uPixelSize;
+		pGlyph->uGlyphIndex = uGlyphIndex;
+		pGlyph->bStroke     = bStroke;
+		pGlyph->iAdvance    = iAdvance;
+		pGlyph->iLeft       = iLeft;
+		pGlyph->iTop        = iTop;
+		pGlyph->uResX       = U16( uResX );
+		pGlyph->uResY       = U16( uResY );
+		pGlyph->pCoverage   = uResX*uResY > 0 ? reinterpret_cast< U8 * >( pGlyph + 1 ) : nullptr;
+		pGlyph->pTexture    = nullptr;
+		pGlyph->pStroke     = nullptr;
+
+		for( U32 y = 0; y < uResY; ++y ) {
+			const U8 *const pSrc = bitmap.buffer + S32( y )*bitmap.pitch;
+			U8 *const pDst = pGlyph->pCoverage + y*uResX;
+
+			if( bitmap.pixel_mode == FT_PIXEL_MODE_MONO ) {
+				for( U32 x = 0; x < uResX; ++x ) {
+					pDst[ x ] = ( pSrc[ x/8 ] & ( 0x80>>( x%8 ) ) ) != 0 ? 0xFF : 0x00;
+				}
+			} else {
+				memcpy( ( Void * )pDst, ( const Void * )pSrc, uResX );
+			}
+		}
+
+		return pGlyph;
+	}
+
+	bool MGlyphCache::growGlyphSlots() {
+		const U32 cNewSlots = m_cGlyphSlots < 256 ? 256 : m_cGlyphSlots*2;
+
+		SGlyph **const pNewSlots = reinterpret_cast< SGlyph ** >( DOLL_ALLOC( *DOLL__DEFAULT_ALLOCATOR, sizeof( SGlyph * )*cNewSlots, kTag_Font ) );
+		if( !AX_VERIFY_MEMORY( pNewSlots ) ) {
+			return false;
+		}
+		memset( ( Void * )pNewSlots, 0, sizeof( SGlyph * )*cNewSlots );
+
+		for( U32 i = 0; i < m_cGlyphSlots; ++i ) {
+			SGlyph *const pGlyph = m_pGlyphSlots[ i ];
+			if( !pGlyph ) {
+				continue;
+			}
+
+			U32 j = mixKey( ( U32( pGlyph->uFace )<<16 ) | pGlyph->uPixelSize, pGlyph->uGlyphIndex ) & ( cNewSlots - 1 );
+			while( pNewSlots[ j ] != nullptr ) {
+				j = ( j + 1 ) & ( cNewSlots - 1 );
+			}
+			pNewSlots[ j ] = pGlyph;
+		}
+
+		if( m_pGlyphSlots != nullptr ) {
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pGlyphSlots );
+		}
+
+		m_pGlyphSlots = pNewSlots;
+		m_cGlyphSlots = cNewSlots;
+		return true;
+	}
+	SGlyph *MGlyphCache::getGlyph( U16 uFace, U16 uPixelSize, U32 uGlyphIndex ) {
+		AX_ASSERT( uFace > 0 && uFace <= m_cFaces );
+
+		const U32 uSizeKey = ( U32( uFace )<<16 ) | uPixelSize;
+
+		U32 i = 0;
+		if( m_cGlyphSlots > 0 ) {
+			i = mixKey( uSizeKey, uGlyphIndex ) & ( m_cGlyphSlots - 1 );
+			while( m_pGlyphSlots[ i ] != nullptr ) {
+				SGlyph *const pGlyph = m_pGlyphSlots[ i ];
+				if( pGlyph->uGlyphIndex == uGlyphIndex && pGlyph->uPixelSize == uPixelSize && pGlyph->uFace == uFace ) {
+					return pGlyph;
+				}
+
+				i = ( i + 1 ) & ( m_cGlyphSlots - 1 );
+			}
+		}
+
+		// Not cached; rasterize it
+		SFace &face = m_faces[ uFace - 1 ];
+		if( !selectSize( face, uPixelSize ) ) {
+			return nullptr;
+		}
+
+		const FT_Int32 flags = FT_LOAD_RENDER | ( FT_IS_SCALABLE( face.face ) ? FT_LOAD_NO_BITMAP : 0 );
+		if( FT_Load_Glyph( face.face, uGlyphIndex, flags ) != 0 ) {
+			return nullptr;
+		}
+
+		const FT_GlyphSlot slot = face.face->glyph;
+		SGlyph *const pGlyph = newGlyph( uFace, uPixelSize, uGlyphIndex, false, slot->bitmap, slot->bitmap_left, slot->bitmap_top, S32( slot->advance.x ) );
+		if( !pGlyph ) {
+			return nullptr;
+		}
+
+		// Keep the table at most 3/4 full
+		if( ( m_cGlyphs + 1 )*4 > m_cGlyphSlots*3 ) {
+			if( !growGlyphSlots() ) {
+				DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )pGlyph );
+				return nullptr;
+			}
+
+			i = mixKey( uSizeKey, uGlyphIndex ) & ( m_cGlyphSlots - 1 );
+			while( m_pGlyphSlots[ i ] != nullptr ) {
+				i = ( i + 1 ) & ( m_cGlyphSlots - 1 );
+			}
+		}
+
+		m_pGlyphSlots[ i ] = pGlyph;
+		++m_cGlyphs;
+
+		return pGlyph;
+	}
+	SGlyph *MGlyphCache::getStrokeGlyph( SGlyph &glyph ) {
+		AX_ASSERT( !glyph.bStroke );
+
+		if( glyph.pStroke != nullptr || !glyph.pCoverage || !m_stroker ) {
+			return glyph.pStroke;
+		}
+
+		SFace &face = m_faces[ glyph.uFace - 1 ];
+		if( !selectSize( face, glyph.uPixelSize ) ) {
+			return nullptr;
+		}
+
+		if( FT_Load_Glyph( face.face, glyph.uGlyphIndex, FT_LOAD_NO_BITMAP ) != 0 || face.face->glyph->format != FT_GLYPH_FORMAT_OUTLINE ) {
+			return nullptr;
+		}
+
+		FT_Glyph outline = nullptr;
+		if( FT_Get_Glyph( face.face->glyph, &outline ) != 0 ) {
+			return nullptr;
+		}
+
+		if( FT_Glyph_StrokeBorder( &outline, m_stroker, 0, 1 ) != 0 || FT_Glyph_To_Bitmap( &outline, FT_RENDER_MODE_NORMAL, nullptr, 1 ) != 0 ) {
+			FT_Done_Glyph( outline );
+			return nullptr;
+		}
+
+		const FT_BitmapGlyph bitmapGlyph = reinterpret_cast< FT_BitmapGlyph >( outline );
+		glyph.pStroke = newGlyph( glyph.uFace, glyph.uPixelSize, glyph.uGlyphIndex, true, bitmapGlyph->bitmap, bitmapGlyph->left, bitmapGlyph->top, glyph.iAdvance );
+
+		FT_Done_Glyph( outline );
+		return glyph.pStroke;
+	}
+
+	bool MGlyphCache::growKerningSlots() {
+		const U32 cNewSlots = m_cKerningSlots < 256 ? 256 : m_cKerningSlots*2;
+
+		SKerning *const pNewSlots = reinterpret_cast< SKerning * >( DOLL_ALLOC( *DOLL__DEFAULT_ALLOCATOR, sizeof( SKerning )*cNewSlots, kTag_Font ) );
+		if( !AX_VERIFY_MEMORY( pNewSlots ) ) {
+			return false;
+		}
+		memset( ( Void * )pNewSlots, 0, sizeof( SKerning )*cNewSlots );
+
+		for( U32 i = 0; i < m_cKerningSlots; ++i ) {
+			const SKerning &kern = m_pKerningSlots[ i ];
+			if( !kern.uSizeKey ) {
+				continue;
+			}
+
+			U32 j = mixKey( mixKey( kern.uSizeKey, kern.uLeft ), kern.uRight ) & ( cNewSlots - 1 );
+			while( pNewSlots[ j ].uSizeKey != 0 ) {
+				j = ( j + 1 ) & ( cNewSlots - 1 );
+			}
+			pNewSlots[ j ] = kern;
+		}
+
+		if( m_pKerningSlots != nullptr ) {
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pKerningSlots );
+		}
+
+		m_pKerningSlots = pNewSlots;
+		m_cKerningSlots = cNewSlots;
+		return true;
+	}
+	S32 MGlyphCache::getKerning( U16 uFace, U16 uPixelSize, U32 uLeft, U32 uRight ) {
+		AX_ASSERT( uFace > 0 && uFace <= m_cFaces );
+
+		SFace &face = m_faces[ uFace - 1 ];
+		if( !FT_HAS_KERNING( face.face ) ) {
+			return 0;
+		}
+
+		const U32 uSizeKey = ( U32( uFace )<<16 ) | uPixelSize;
+		const U32 uHash = mixKey( mixKey( uSizeKey, uLeft ), uRight );
+
+		if( m_cKerningSlots > 0 ) {
+			for( U32 i = uHash & ( m_cKerningSlots - 1 ); m_pKerningSlots[ i ].uSizeKey != 0; i = ( i + 1 ) & ( m_cKerningSlots - 1 ) ) {
+				const SKerning &kern = m_pKerningSlots[ i ];
+				if( kern.uSizeKey == uSizeKey && kern.uLeft == uLeft && kern.uRight == uRight ) {
+					return kern.iKerning;
+				}
+			}
+		}
+
+		FT_Vector delta;
+		delta.x = 0;
+		if( !selectSize( face, uPixelSize ) || FT_Get_Kerning( face.face, uLeft, uRight, FT_KERNING_DEFAULT, &delta ) != 0 ) {
+			return 0;
+		}
+
+		if( ( m_cKernings + 1 )*4 > m_cKerningSlots*3 && !growKerningSlots() ) {
+			return S32( delta.x );
+		}
+
+		U32 i = uHash & ( m_cKerningSlots - 1 );
+		while( m_pKerningSlots[ i ].uSizeKey != 0 ) {
+			i = ( i + 1 ) & ( m_cKerningSlots - 1 );
+		}
+
+		SKerning &kern = m_pKerningSlots[ i ];
+		kern.uSizeKey = uSizeKey;
+		kern.uLeft    = uLeft;
+		kern.uRight   = uRight;
+		kern.iKerning = S32( delta.x );
+		++m_cKernings;
+
+		return kern.iKerning;
+	}
+
+	RTexture *MGlyphCache::getTexture( SGlyph &glyph ) {
+		if( glyph.pTexture != nullptr || !glyph.pCoverage ) {
+			return glyph.pTexture;
+		}
+
+		// White texels with the coverage as alpha, so one texture serves every
+		// color; the border keeps neighbors from bleeding in when filtered.
+		// Rows go in bottom first, as with every other texture (images are
+		// flipped on load, and drawing flips them back)
+		const U16 uResX = glyph.uResX + 2;
+		const U16 uResY = glyph.uResY + 2;
+
+		U32 *const pTexels = reinterpret_cast< U32 * >( DOLL_ALLOC( *DOLL__DEFAULT_ALLOCATOR, sizeof( U32 )*uResX*uResY, kTag_Font ) );
+		if( !AX_VERIFY_MEMORY( pTexels ) ) {
+			return nullptr;
+		}
+		memset( ( Void * )pTexels, 0, sizeof( U32 )*uResX*uResY );
+
+		for( U32 y = 0; y < glyph.uResY; ++y ) {
+			const U8 *const pSrc = glyph.pCoverage + y*glyph.uResX;
+			U32 *const pDst = pTexels + ( glyph.uResY - y )*uResX + 1;
+
+			for( U32 x = 0; x < glyph.uResX; ++x ) {
+				pDst[ x ] = ( U32( pSrc[ x ] )<<24 ) | 0x00FFFFFF;
+			}
+		}
+
+		if( uResX <= kGlyphPageRes && uResY <= kGlyphPageRes ) {
+			for( SizeType i = m_pages.len(); i > 0 && !glyph.pTexture; --i ) {
+				glyph.pTexture = g_textureMgr.makeTextureInAtlas( uResX, uResY, ( const Void * )pTexels, kTexFmtRGBA8, m_pages[ i - 1 ] );
+			}
+
+			if( !glyph.pTexture ) {
+				CTextureAtlas *const pPage = gfx_newTextureAtlas( kGlyphPageRes, kGlyphPageRes, kTexFmtRGBA8 );
+				if( AX_VERIFY_MEMORY( pPage ) ) {
+					if( !AX_VERIFY_MEMORY( m_pages.append( pPage ) ) ) {
+						gfx_deleteTextureAtlas( pPage );
+					} else {
+						glyph.pTexture = g_textureMgr.makeTextureInAtlas( uResX, uResY, ( const Void * )pTexels, kTexFmtRGBA8, pPage );
+					}
+				}
+			}
+		} else {
+			// Too big for a page (huge font sizes); give it an atlas of its own
+			glyph.pTexture = g_textureMgr.makeTexture( uResX, uResY, ( const Void * )pTexels, kTexFmtRGBA8 );
+		}
+
+		DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )pTexels );
+		return glyph.pTexture;
+	}
+
+	// ------------------------------------------------------------------ //
+
+	// Blend a glyph's coverage (in `color`) over a BGRA8 image; `x` and `y`
+	// are from the top, but the image is stored bottom row first, like the
+	// GDI bitmaps other backends render into
+	static void blendGlyph( U32 *pBits, const SIntVector2 &res, const SGlyph &glyph, S32 x, S32 y, U32 color ) {
+		const U32 r = DOLL_COLOR_R( color );
+		const U32 g = DOLL_COLOR_G( color );
+		const U32 b = DOLL_COLOR_B( color );
+		const U32 a = DOLL_COLOR_A( color );
+
+		const S32 y1 = y < 0 ? -y : 0;
+		const S32 y2 = y + glyph.uResY > res.y ? res.y - y : S32( glyph.uResY );
+		const S32 x1 = x < 0 ? -x : 0;
+		const S32 x2 = x + glyph.uResX > res.x ? res.x - x : S32( glyph.uResX );
+
+		for( S32 gy = y1; gy < y2; ++gy ) {
+			const U8 *const pSrc = glyph.pCoverage + gy*glyph.uResX;
+			U32 *const pDst = pBits + ( res.y - 1 - ( y + gy ) )*res.x + x;
+
+			for( S32 gx = x1; gx < x2; ++gx ) {
+				const U32 srcA = pSrc[ gx ]*a/255;
+				if( !srcA ) {
+					continue;
+				}
+
+				const U32 dst = pDst[ gx ];
+				const U32 dstA = ( dst>>24 )*( 255 - srcA )/255;
+				const U32 outA = srcA + dstA;
+
+				const U32 outR = ( r*srcA + ( ( dst>>16 ) & 0xFF )*dstA )/outA;
+				const U32 outG = ( g*srcA + ( ( dst>> 8 ) & 0xFF )*dstA )/outA;
+				const U32 outB = ( b*srcA + ( ( dst>> 0 ) & 0xFF )*dstA )/outA;
+
+				pDst[ gx ] = ( outA<<24 ) | ( outR<<16 ) | ( outG<<8 ) | outB;
+			}
+		}
+	}
+
+	FreeTypeFont::FreeTypeFont()
+	: m_uFace( 0 )
+	, m_uPixelSize( 0 )
+	, m_iAscender( 0 )
+	, m_iLineHeight( 0 )
+	{
+		DOLL_TRACE( "FreeTypeFont::FreeTypeFont()" );
+	}
+	FreeTypeFont::~FreeTypeFont() {
+		DOLL_TRACE( "FreeTypeFont::~FreeTypeFont()" );
+		clear();
+	}
+
+	bool FreeTypeFont::set( Str fontFamily, U32 size ) {
+		DOLL_TRACE( axf( "FreeTypeFont::set(fontFamily: \"%.*s\", size: %u)",
+			fontFamily.lenInt(), fontFamily.get(), size ) );
+
+		clear();
+
+		if( !size || size > 0xFFFF ) {
+			return false;
+		}
+
+		const U16 uFace = g_glyphCache->findFace( fontFamily );
+		if( !uFace ) {
+			return false;
+		}
+
+		if( !g_glyphCache->getSizeMetrics( uFace, U16( size ), m_iAscender, m_iLineHeight ) ) {
+			return false;
+		}
+
+		m_uFace = uFace;
+		m_uPixelSize = U16( size );
+		return true;
+	}
+	void FreeTypeFont::clear() {
+		// Faces and glyphs belong to the shared cache
+		m_uFace = 0;
+		m_uPixelSize = 0;
+		m_iAscender = 0;
+		m_iLineHeight = 0;
+	}
+	Str FreeTypeFont::getFamilyName() const {
+		return m_uFace != 0 ? Str( g_glyphCache->getFamilyName( m_uFace ) ) : Str();
+	}
+
+	bool FreeTypeFont::layout( STextLayout &dst, const Str &text, S32 maxWidth ) const {
+		dst.quads.clear();
+		dst.size = SIntVector2();
+
+		if( !m_uFace ) {
+			return false;
+		}
+
+		MGlyphCache &cache = *g_glyphCache;
+
+		const S32 iMaxPen = maxWidth > 0 ? maxWidth<<6 : 0;
+		const U32 uSpaceIndex = cache.getGlyphIndex( m_uFace, ' ' );
+
+		S32 iPen = 0;
+		S32 iBaseline = m_iAscender;
+		S32 iWidth = 0;
+		U32 uPrevIndex = 0;
+
+		// Where the current line can be broken (after its last space)
+		bool bCanBreak = false;
+		UPtr uBreakQuad = 0;
+		S32 iBreakPen = 0;
+		S32 iBreakLineEnd = 0;
+
+		const char *p = text.get();
+		const char *const e = p + text.num();
+		while( p < e ) {
+			const U32 ch = decodeUTF8( p, e );
+			if( ch == '\r' ) {
+				continue;
+			}
+			if( ch == '\n' ) {
+				iWidth = iPen > iWidth ? iPen : iWidth;
+				iPen = 0;
+				iBaseline += m_iLineHeight;
+				uPrevIndex = 0;
+				bCanBreak = false;
+				continue;
+			}
+
+			const U32 uIndex = ch == ' ' ? uSpaceIndex : cache.getGlyphIndex( m_uFace, ch );
+			if( uPrevIndex != 0 && uIndex != 0 ) {
+				iPen += cache.getKerning( m_uFace, m_uPixelSize, uPrevIndex, uIndex );
+			}
+			uPrevIndex = uIndex;
+
+			SGlyph *const pGlyph = cache.getGlyph( m_uFace, m_uPixelSize, uIndex );
+			if( !pGlyph ) {
+				continue;
+			}
+
+			if( ch == ' ' ) {
+				bCanBreak = true;
+				uBreakQuad = dst.quads.len();
+				iBreakLineEnd = iPen;
+				iPen += pGlyph->iAdvance;
+				iBreakPen = iPen;
+				continue;
+			}
+
+			// Move the current word down to a new line if it doesn't fit
+			if( iMaxPen > 0 && bCanBreak && iPen + pGlyph->iAdvance > iMaxPen ) {
+				iWidth = iBreakLineEnd > iWidth ? iBreakLineEnd : iWidth;
+
+				for( UPtr i = uBreakQuad; i < dst.quads.len(); ++i ) {
+					dst.quads[ i ].iPenX -= iBreakPen;
+					dst.quads[ i ].iBaseline += m_iLineHeight;
+				}
+
+				iPen -= iBreakPen;
+				iBaseline += m_iLineHeight;
+				bCanBreak = false;
+			}
+
+			SGlyphQuad quad;
+			quad.iPenX = iPen;
+			quad.iBaseline = iBaseline;
+			quad.pGlyph = pGlyph;
+			if( !AX_VERIFY_MEMORY( dst.quads.append( quad ) ) ) {
+				return false;
+			}
+
+			iPen += pGlyph->iAdvance;
+		}
+
+		iWidth = iPen > iWidth ? iPen : iWidth;
+
+		dst.size.x = ( iWidth + 63 )>>6;
+		dst.size.y = iBaseline - m_iAscender + m_iLineHeight;
+
+		return true;
+	}
+
+	bool FreeTypeFont::render( FreeTypeText &dst, const Str &text, const SIntVector2 &size, U32 lineColor, U32 fillColor ) const {
+		DOLL_TRACE( "FreeTypeFont::render()" );
+
+		dst.freeBits();
+
+		if( size.x <= 0 || size.y <= 0 || !layout( g_scratchLayout, text, size.x ) ) {
+			return false;
+		}
+
+		const UPtr cBytes = sizeof( U32 )*UPtr( size.x )*UPtr( size.y );
+		dst.m_pBits = reinterpret_cast< U32 * >( DOLL_ALLOC( *DOLL__DEFAULT_ALLOCATOR, cBytes, kTag_Font ) );
+		if( !AX_VERIFY_MEMORY( dst.m_pBits ) ) {
+			return false;
+		}
+		memset( ( Void * )dst.m_pBits, 0, cBytes );
+		dst.m_res = size;
+
+		const SGlyphQuad *const pQuads = g_scratchLayout.quads.pointer();
+		const UPtr cQuads = g_scratchLayout.quads.len();
+
+		if( DOLL_COLOR_A( lineColor ) != 0 ) {
+			for( UPtr i = 0; i < cQuads; ++i ) {
+				const SGlyphQuad &quad = pQuads[ i ];
+				const SGlyph *const pStroke = g_glyphCache->getStrokeGlyph( *quad.pGlyph );
+				if( !pStroke ) {
+					continue;
+				}
+
+				const S32 x = ( ( quad.iPenX + 32 )>>6 ) + pStroke->iLeft;
+				const S32 y = quad.iBaseline - pStroke->iTop;
+				blendGlyph( dst.m_pBits, size, *pStroke, x, y, lineColor );
+			}
+		}
+
+		for( UPtr i = 0; i < cQuads; ++i ) {
+			const SGlyphQuad &quad = pQuads[ i ];
+			if( !quad.pGlyph->pCoverage ) {
+				continue;
+			}
+
+			blendGlyph( dst.m_pBits, size, *quad.pGlyph, quad.getLeft(), quad.getTop(), fillColor );
+		}
+
+		return true;
+	}
+	bool FreeTypeFont::draw( const Str &text, const SRect &area, U32 lineColor, U32 fillColor ) const {
+		if( !layout( g_scratchLayout, text, area.resX() ) ) {
+			return false;
+		}
+
+		const SGlyphQuad *const pQuads = g_scratchLayout.quads.pointer();
+		const UPtr cQuads = g_scratchLayout.quads.len();
+
+		// Outlines first, then fills over them
+		for( U32 uPass = DOLL_COLOR_A( lineColor ) != 0 ? 0 : 1; uPass < 2; ++uPass ) {
+			const U32 color = uPass == 0 ? lineColor : fillColor;
+
+			for( UPtr i = 0; i < cQuads; ++i ) {
+				const SGlyphQuad &quad = pQuads[ i ];
+				SGlyph *const pGlyph = uPass == 0 ? g_glyphCache->getStrokeGlyph( *quad.pGlyph ) : quad.pGlyph;
+				if( !pGlyph || !pGlyph->pCoverage ) {
+					continue;
+				}
+
+				const S32 x = area.x1 + ( ( quad.iPenX + 32 )>>6 ) + pGlyph->iLeft;
+				const S32 y = area.y1 + quad.iBaseline - pGlyph->iTop;
+				if( y >= area.y2 || y + S32( pGlyph->uResY ) <= area.y1 ) {
+					continue;
+				}
+
+				RTexture *const pTexture = g_glyphCache->getTexture( *pGlyph );
+				if( !pTexture ) {
+					continue;
+				}
+
+				gfx_queDrawImage( x, y, pGlyph->uResX, pGlyph->uResY, 1, 1, pGlyph->uResX, pGlyph->uResY, color, color, color, color, pTexture );
+			}
+		}
+
+		return true;
+	}
+	void FreeTypeFont::measure( const Str &text, SRect &dstArea ) const {
+		dstArea = SRect();
+
+		if( !layout( g_scratchLayout, text, 0 ) ) {
+			return;
+		}
+
+		dstArea.x2 = g_scratchLayout.size.x;
+		dstArea.y2 = g_scratchLayout.size.y;
+	}
+
+	// ------------------------------------------------------------------ //
+
+	FreeTypeText::FreeTypeText()
+	: m_pBits( nullptr )
+	, m_res()
+	{
+	}
+	FreeTypeText::~FreeTypeText() {
+		freeBits();
+	}
+
+	const void *FreeTypeText::getBits() const {
+		return ( const void * )m_pBits;
+	}
+	void FreeTypeText::freeBits() {
+		if( m_pBits != nullptr ) {
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pBits );
+			m_pBits = nullptr;
+		}
+
+		m_res = SIntVector2();
+	}
+
+}}
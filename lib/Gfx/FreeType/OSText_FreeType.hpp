@@ -0,0 +1,118 @@
+#pragma once
+
+#include "doll/Core/Defs.hpp"
+#include "doll/Math/IntVector2.hpp"
+#include "doll/Math/Rect.hpp"
+
+namespace doll
+{
+
+	class RTexture;
+
+namespace FreeType {
+
+	class FreeTypeFont;
+	class FreeTypeText;
+
+	// A glyph rasterized at one size (cached; never freed before shutdown)
+	struct SGlyph {
+		// Face index, pixel size and glyph index this was rendered from
+		U16       uFace;
+		U16       uPixelSize;
+		U32       uGlyphIndex;
+		Bool      bStroke;
+
+		// Horizontal advance in 26.6 fixed point
+		S32       iAdvance;
+		// Bitmap offset from the pen position (top is up from the baseline)
+		S32       iLeft;
+		S32       iTop;
+		// Bitmap size
+		U16       uResX;
+		U16       uResY;
+		// 8-bit coverage, uResX*uResY bytes (nullptr for blank glyphs)
+		U8 *      pCoverage;
+
+		// Atlas texture with a one pixel transparent border (made on first draw)
+		RTexture *pTexture;
+		// Outline variant of this glyph (made on first use)
+		SGlyph *  pStroke;
+	};
+
+	// A positioned glyph within laid out text
+	struct SGlyphQuad {
+		// Pen position in 26.6 fixed point, relative to the left of the text
+		S32           iPenX;
+		// Baseline, in pixels from the top of the text
+		S32           iBaseline;
+		SGlyph *      pGlyph;
+
+		inline S32 getLeft() const {
+			return ( ( iPenX + 32 )>>6 ) + pGlyph->iLeft;
+		}
+		inline S32 getTop() const {
+			return iBaseline - pGlyph->iTop;
+		}
+	};
+
+	// Laid out text (reused between calls to avoid reallocating)
+	struct STextLayout {
+		TMutArr<SGlyphQuad> quads;
+		// Bounding size of the text
+		SIntVector2         size;
+	};
+
+	// Font data
+	class FreeTypeFont {
+		U16 m_uFace;
+		U16 m_uPixelSize;
+		S32 m_iAscender;
+		S32 m_iLineHeight;
+
+	public:
+		FreeTypeFont();
+		~FreeTypeFont();
+
+		bool set( Str fontFamily, U32 size );
+		void clear();
+
+		inline bool isValid() const {
+			return m_uFace != 0;
+		}
+		inline S32 getAscender() const {
+			return m_iAscender;
+		}
+		inline S32 getLineHeight() const {
+			return m_iLineHeight;
+		}
+		// Family name of the font file that was found (e.g., "DejaVu Sans"
+		// for "sans"); empty if no font is set
+		Str getFamilyName() const;
+
+		// Lay out `text` from the top-left, wrapping words at `maxWidth`
+		// pixels (0 disables wrapping)
+		bool layout( STextLayout &dst, const Str &text, S32 maxWidth ) const;
+
+		bool render( FreeTypeText &dst, const Str &text, const SIntVector2 &size, U32 lineColor, U32 fillColor ) const;
+		bool draw( const Str &text, const SRect &area, U32 lineColor, U32 fillColor ) const;
+		void measure( const Str &text, SRect &dstArea ) const;
+	};
+	// Release the textures held by the glyph cache (before the render API is
+	// finalized); glyphs are uploaded again when next drawn
+	void fini();
+
+	// Rendered text image (BGRA8, bottom row first like other texture data)
+	class FreeTypeText {
+	friend class FreeTypeFont;
+		U32 *       m_pBits;
+		SIntVector2 m_res;
+
+	public:
+		FreeTypeText();
+		~FreeTypeText();
+
+		const void *getBits() const;
+		void freeBits();
+	};
+
+}}
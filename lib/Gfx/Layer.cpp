@@ -4,8 +4,11 @@
 #include "doll/Gfx/Layer.hpp"
 #include "doll/Gfx/Sprite.hpp"
 #include "doll/Gfx/RenderCommands.hpp"
+#include "doll/Gfx/RenderStats.hpp"
 #include "doll/Gfx/API-GL.hpp"
 
+#include "doll/Core/Logger.hpp"
+
 #ifdef __APPLE__
 # include <OpenGL/OpenGL.h>
 #else
@@ -111,6 +114,7 @@ namespace doll
 	}
 	RLayer::~RLayer()
 	{
+		freeCache();
 	}
 
 	inline void setViewport( const SViewport &VP )
@@ -139,9 +143,27 @@ namespace doll
 
 		// Push the current viewport in the stack -- this maintains global transformation details
 		Renderer.pushViewport( m_View.shape );
+
+		// Draw the cached texture if there is one, otherwise everything
+		const SViewport VP = Renderer.topViewport();
+		if( m_Properties.bCacheAsTexture && updateCacheGL( Renderer, pView, VP ) ) {
+			drawCacheGL( VP );
+		} else {
+			renderContentsGL( Renderer, pView, VP );
+		}
+
+		// Restore the current viewport in the stack
+		Renderer.popViewport();
+
+		// Restore the old position and size (in the event they were changed by running effects)
+		m_View.shape = OldShape;
+	}
+	Void RLayer::renderContentsGL( MLayers::SRenderer &Renderer, CGfxFrame *pView, const SViewport &VP )
+	{
+		// Count what this layer draws separately from its parent and children
+		gfx_pushRenderStatsScope( this );
 		
 		// Apply the GL viewport
-		const SViewport VP = Renderer.topViewport();
 		setViewport( VP );
 
 		// Set the scissor rectangle
@@ -176,17 +198,131 @@ namespace doll
 		}
 		setViewport( VP );
 		postrenderGL( pView );
+		gfx_popRenderStatsScope();
 
 		// Render child layers
 		for( RLayer *pLayer = head(); pLayer != nullptr; pLayer = pLayer->next() ) {
 			pLayer->renderGL( Renderer, pView );
 		}
+	}
+	// Blend state to put back after drawing into or from a layer's cache
+	struct SSavedBlend
+	{
+		EBlendOp     op;
+		EBlendFactor factors[ 4 ];
 
-		// Restore the current viewport in the stack
-		Renderer.popViewport();
+		SSavedBlend()
+		{
+			gfx_r_getBlend( &op, &factors[ 0 ], &factors[ 1 ], &factors[ 2 ], &factors[ 3 ] );
+		}
+		Void restore() const
+		{
+			gfx_r_setBlend( op, factors[ 0 ], factors[ 1 ], factors[ 2 ], factors[ 3 ] );
+		}
+	};
 
-		// Restore the old position and size (in the event they were changed by running effects)
-		m_View.shape = OldShape;
+	Bool RLayer::updateCacheGL( MLayers::SRenderer &Renderer, CGfxFrame *pView, const SViewport &VP )
+	{
+		const S32 resX = VP.shape.resX();
+		const S32 resY = VP.shape.resY();
+		if( resX <= 0 || resY <= 0 || resX > 0xFFFF || resY > 0xFFFF ) {
+			return false;
+		}
+
+		if( m_Renderer.cacheTarget != 0 && !m_Renderer.bCacheDirty && m_Renderer.cacheShape == VP.shape ) {
+			return true;
+		}
+
+		// Only remake the target when the size changes
+		if( m_Renderer.cacheTarget != 0 && ( m_Renderer.cacheShape.resX() != resX || m_Renderer.cacheShape.resY() != resY ) ) {
+			freeCache();
+		}
+		if( !m_Renderer.cacheTarget ) {
+			m_Renderer.cacheTarget = gfx_r_createRenderTarget( U16( resX ), U16( resY ) );
+			if( !m_Renderer.cacheTarget ) {
+				DOLL_WARNING_LOG += "Cannot cache layer as a texture; drawing it directly instead";
+				m_Properties.bCacheAsTexture = false;
+				return false;
+			}
+		}
+
+		// The target covers exactly the layer's viewport, so everything
+		// below draws at the same frame positions as it otherwise would
+		S32 prevOriginX, prevOriginY;
+		const UPtr prevTarget = gfx_r_getRenderTarget( &prevOriginX, &prevOriginY );
+
+		// Drawing the contents resets the blend state (to one that blends
+		// alpha as coverage while the target is bound; see CGfxFrame)
+		const SSavedBlend prevBlend;
+
+		gfx_r_setRenderTarget( m_Renderer.cacheTarget, VP.shape.x1, VP.shape.y1 );
+		gfx_r_clearRect( VP.shape.x1, VP.shape.y1, U32( resX ), U32( resY ), 0 );
+		renderContentsGL( Renderer, pView, VP );
+		gfx_r_setRenderTarget( prevTarget, prevOriginX, prevOriginY );
+
+		prevBlend.restore();
+
+		gfx_r_resolveRenderTarget( m_Renderer.cacheTarget );
+
+		m_Renderer.cacheShape  = VP.shape;
+		m_Renderer.bCacheDirty = false;
+		return true;
+	}
+	Void RLayer::drawCacheGL( const SViewport &VP )
+	{
+		const S32 resX = VP.shape.resX();
+		const S32 resY = VP.shape.resY();
+
+		gfx_pushRenderStatsScope( this );
+
+		setViewport( VP );
+		gfx_r_setScissor( max( VP.shape.x1, 0 ), max( VP.shape.y1, 0 ), U32( resX ), U32( resY ) );
+
+		Mat4f proj;
+		proj.loadOrthoProj( 0, F32( resX ), F32( resY ), 0, 0, 1000 );
+		gfx_r_loadProjection( proj.ptr() );
+
+		// Drawing over transparent black left the texture's color multiplied
+		// by its alpha already
+		const SSavedBlend prevBlend;
+		gfx_r_setBlend( kBlendAdd, kBlendOne, kBlendInvSrcAlpha, kBlendOne, kBlendInvSrcAlpha );
+
+		PrimitiveBuffer &prims = m_Renderer.primitives;
+		prims.setPrimitiveType( kTopologyTriangleList );
+		prims.setVertexFormat( PrimitiveConfig::kFormat_Textured );
+		prims.setTexture( gfx_r_getRenderTargetTexture( m_Renderer.cacheTarget ) );
+
+		prims.color( 0xFFFFFFFF );
+		prims.texcoord2f( 0, 0 );
+		prims.vertex2i( 0, 0 );
+		prims.texcoord2f( 1, 0 );
+		prims.vertex2i( resX, 0 );
+		prims.texcoord2f( 0, 1 );
+		prims.vertex2i( 0, resY );
+
+		prims.texcoord2f( 1, 0 );
+		prims.vertex2i( resX, 0 );
+		prims.texcoord2f( 1, 1 );
+		prims.vertex2i( resX, resY );
+		prims.texcoord2f( 0, 1 );
+		prims.vertex2i( 0, resY );
+
+		prims.submit();
+		prims.setTexture( 0 );
+
+		prevBlend.restore();
+
+		gfx_popRenderStatsScope();
+	}
+	Void RLayer::freeCache()
+	{
+		// The API may already be gone when layers are deleted at shutdown
+		if( m_Renderer.cacheTarget != 0 && gfx_r_getFrame() != nullptr ) {
+			gfx_r_destroyRenderTarget( m_Renderer.cacheTarget );
+		}
+
+		m_Renderer.cacheTarget = 0;
+		m_Renderer.bCacheDirty = true;
 	}
 	Void RLayer::renderGroupsGL( detail::SGroupList &List, CGfxFrame *pView )
 	{
@@ -200,7 +336,9 @@ namespace doll
 				continue;
 			}
 
+			gfx_pushRenderStatsScope( this, p->pGroup );
 			p->pGroup->render_gl( w, h );
+			gfx_popRenderStatsScope();
 		}
 	}
 
@@ -414,6 +552,22 @@ namespace doll
 	{
 		return m_Properties.bAutoclear;
 	}
+
+	Void RLayer::setCacheAsTexture( Bool bCache )
+	{
+		m_Properties.bCacheAsTexture = bCache;
+		if( !bCache ) {
+			freeCache();
+		}
+	}
+	Bool RLayer::getCacheAsTexture() const
+	{
+		return m_Properties.bCacheAsTexture;
+	}
+	Void RLayer::invalidateCache()
+	{
+		m_Renderer.bCacheDirty = true;
+	}
 	
 	Void RLayer::setUserPointer( Void *pUserData )
 	{
@@ -1211,6 +1365,39 @@ namespace doll
 		return layer->getAutoclear();
 	}
 
+	DOLL_FUNC Void DOLL_API gfx_enableLayerCache( RLayer *layer )
+	{
+		if( !AX_VERIFY_NOT_NULL( layer ) ) {
+			return;
+		}
+
+		layer->setCacheAsTexture( true );
+	}
+	DOLL_FUNC Void DOLL_API gfx_disableLayerCache( RLayer *layer )
+	{
+		if( !AX_VERIFY_NOT_NULL( layer ) ) {
+			return;
+		}
+
+		layer->setCacheAsTexture( false );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isLayerCacheEnabled( const RLayer *layer )
+	{
+		if( !AX_VERIFY_NOT_NULL( layer ) ) {
+			return false;
+		}
+
+		return layer->getCacheAsTexture();
+	}
+	DOLL_FUNC Void DOLL_API gfx_invalidateLayerCache( RLayer *layer )
+	{
+		if( !AX_VERIFY_NOT_NULL( layer ) ) {
+			return;
+		}
+
+		layer->invalidateCache();
+	}
+
 	DOLL_FUNC Void DOLL_API gfx_moveLayerTop( RLayer *layer )
 	{
 		if( !AX_VERIFY_NOT_NULL( layer ) ) {
@@ -1311,4 +1498,106 @@ namespace doll
 		return pLayer->getAspectMode();
 	}
 
+	//--------------------------------------------------------------------//
+
+#define RESOLVE_LAYER( var, handle )\
+	RLayer *const var = RLayer::fromHandle( handle );\
+	if( !var )
+
+	DOLL_FUNC HLayer DOLL_API gfx_getLayerHandle( const RLayer *layer )
+	{
+		if( !layer ) {
+			return HLayer();
+		}
+
+		return layer->getHandle();
+	}
+	DOLL_FUNC RLayer *DOLL_API gfx_getLayerFromHandle( HLayer layer )
+	{
+		return RLayer::fromHandle( layer );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isLayerHandleValid( HLayer layer )
+	{
+		return RLayer::getPool().isValid( layer );
+	}
+	DOLL_FUNC U32 DOLL_API gfx_getLiveLayerCount()
+	{
+		return RLayer::getPool().getLiveCount();
+	}
+
+	DOLL_FUNC HLayer DOLL_API gfx_newLayerHandle()
+	{
+		return gfx_getLayerHandle( gfx_newLayer() );
+	}
+	DOLL_FUNC HLayer DOLL_API gfx_deleteLayerByHandle( HLayer layer )
+	{
+		delete RLayer::fromHandle( layer );
+		return HLayer();
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_setLayerParentByHandle( HLayer layer, HLayer parent )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return;
+		}
+
+		pLayer->setParent( RLayer::fromHandle( parent ) );
+	}
+	DOLL_FUNC HLayer DOLL_API gfx_getLayerParentByHandle( HLayer layer )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return HLayer();
+		}
+
+		return gfx_getLayerHandle( pLayer->getParent() );
+	}
+	DOLL_FUNC Void DOLL_API gfx_setLayerVisibleByHandle( HLayer layer, Bool visible )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return;
+		}
+
+		pLayer->setVisible( visible );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_getLayerVisibleByHandle( HLayer layer )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return false;
+		}
+
+		return pLayer->isVisible();
+	}
+	DOLL_FUNC Void DOLL_API gfx_setLayerPositionByHandle( HLayer layer, S32 x, S32 y )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return;
+		}
+
+		pLayer->setPosition( SIntVector2( x, y ) );
+	}
+	DOLL_FUNC Void DOLL_API gfx_setLayerSizeByHandle( HLayer layer, S32 w, S32 h )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return;
+		}
+
+		pLayer->setSize( SIntVector2( w, h ) );
+	}
+	DOLL_FUNC Void DOLL_API gfx_addLayerPrerenderSpriteGroupByHandle( HLayer layer, RSpriteGroup *group )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return;
+		}
+
+		gfx_addLayerPrerenderSpriteGroup( pLayer, group );
+	}
+	DOLL_FUNC Void DOLL_API gfx_addLayerPostrenderSpriteGroupByHandle( HLayer layer, RSpriteGroup *group )
+	{
+		RESOLVE_LAYER( pLayer, layer ) {
+			return;
+		}
+
+		gfx_addLayerPostrenderSpriteGroup( pLayer, group );
+	}
+
 }
@@ -24,6 +24,7 @@
 #define DOLL_OSTEXT_GDIPLUS 0
 #define DOLL_OSTEXT_DWRITE  0
 #define DOLL_OSTEXT_COCOA   0
+#define DOLL_OSTEXT_FREETYPE 0
 
 #if AX_OS_UWP
 # undef  DOLL_OSTEXT_DWRITE
@@ -34,10 +35,15 @@
 #elif AX_OS_MACOSX || AX_OS_IOS
 # undef  DOLL_OSTEXT_COCOA
 # define DOLL_OSTEXT_COCOA   1
+#else
+# undef  DOLL_OSTEXT_FREETYPE
+# define DOLL_OSTEXT_FREETYPE 1
 #endif
 
 #if DOLL_OSTEXT_COCOA
 # include "macOS/OSText_Cocoa.hpp"
+#elif DOLL_OSTEXT_FREETYPE
+# include "FreeType/OSText_FreeType.hpp"
 #endif
 
 #include "doll/Gfx/OSText.hpp"
@@ -45,6 +51,7 @@
 #include "doll/Gfx/RenderCommands.hpp"
 #include "doll/Core/Memory.hpp"
 #include "doll/Core/MemoryTags.hpp"
+#include "doll/Util/Hash.hpp"
 
 // ### FOR TESTING ###
 #ifdef __APPLE__
@@ -71,13 +78,16 @@ namespace doll
 #elif DOLL_OSTEXT_COCOA
 		// [Cocoa] Text style specific data
 		macOS::CocoaFont     font;
+#elif DOLL_OSTEXT_FREETYPE
+		// [FreeType] Face and size within the shared glyph cache
+		FreeType::FreeTypeFont font;
 #endif
 		// Font size
 		S32                  fontSize;
 
 		STextStyle()
 		: cRefs( 1 )
-#if DOLL_OSTEXT_GDIPLUS || DOLL_OSTEXT_COCOA
+#if DOLL_OSTEXT_GDIPLUS || DOLL_OSTEXT_COCOA || DOLL_OSTEXT_FREETYPE
 		, font()
 #endif
 		, fontSize( 12 )
@@ -140,6 +150,9 @@ namespace doll
 #elif DOLL_OSTEXT_COCOA
 		// [Cocoa] Text image
 		macOS::CocoaText textImage;
+#elif DOLL_OSTEXT_FREETYPE
+		// [FreeType] Text image
+		FreeType::FreeTypeText textImage;
 #endif
 
 		// Text string to render
@@ -157,7 +170,7 @@ namespace doll
 		, pBmpBits( nullptr )
 		, hBmp( NULL )
 		, hDC( NULL )
-#elif DOLL_OSTEXT_COOCA
+#elif DOLL_OSTEXT_COCOA || DOLL_OSTEXT_FREETYPE
 		, textImage()
 #endif
 		, text()
@@ -187,6 +200,57 @@ namespace doll
 		}
 	};
 
+	// Texture of text drawn by `gfx_drawOSText()`, kept for reuse on later
+	// frames until evicted
+	struct STextRun: public TPoolObject< STextRun, kTag_Font >
+	{
+		// Hash of the text, size, colors and style
+		U32                 uHash;
+		// Default style the text was rendered with
+		U32                 uStyleId;
+		// Size of the area the text was rendered into
+		SIntVector2         size;
+		// Outline color
+		U32                 uLineColor;
+		// Fill color
+		U32                 uFillColor;
+		// Text string (to tell apart runs with the same hash)
+		MutStr              text;
+
+		// Rendered text
+		RTexture *          pTexture;
+		// Approximate memory held by `pTexture`
+		UPtr                cBytes;
+		// Frame ID this run was last drawn on
+		U32                 uRenderId;
+
+		// Next run in the same hash bucket
+		STextRun *          pNextInBucket;
+		// Link in the LRU list (most recently used first)
+		TIntrLink<STextRun> lruLink;
+
+		STextRun()
+		: uHash( 0 )
+		, uStyleId( 0 )
+		, size()
+		, uLineColor( 0 )
+		, uFillColor( 0 )
+		, text()
+		, pTexture( nullptr )
+		, cBytes( 0 )
+		, uRenderId( 0 )
+		, pNextInBucket( nullptr )
+		, lruLink( this )
+		{
+		}
+		~STextRun()
+		{
+			if( pTexture != nullptr ) {
+				pTexture = gfx_deleteTexture( pTexture );
+			}
+		}
+	};
+
 	class MOSText
 	{
 	public:
@@ -196,17 +260,35 @@ namespace doll
 		STextItem *newText( Str text, const SIntVector2 &size, U32 lineColor, U32 fillColor );
 		Void drawText( STextItem &item );
 
-		Void addRenderedText( RTexture *texture );
-		Void clearRenderedTexts();
+		RTexture *getTextRun( Str text, const SIntVector2 &size, U32 lineColor, U32 fillColor );
+		Void setTextRunBudget( UPtr cBytes );
+		UPtr getTextRunBudget() const;
+		Void clearTextRuns();
+
+		// Release every texture held for text (before the render API is
+		// finalized)
+		Void fini();
 
 		Void measureText( const STextStyle *style, Str text, SRect &dstArea );
+#if DOLL_OSTEXT_FREETYPE
+		Void drawGlyphs( Str text, const SRect &area );
+#endif
 
 	private:
 		STextStyle *              m_pDefStyle;
 		TSmallArr<STextItem *, 8> m_items;
 
-		TSmallArr<RTexture *, 8>  m_renderCache;
-		U32                       m_lastCacheFrameId;
+		// Incremented whenever the default style changes (part of each run's key)
+		U32                       m_uStyleId;
+
+		static const UPtr         kTextRunBuckets = 256;
+		STextRun *                m_pTextRunBuckets[ kTextRunBuckets ];
+		TIntrList<STextRun>       m_textRunLRU;
+		UPtr                      m_cTextRunBytes;
+		UPtr                      m_cTextRunBudget;
+
+		Void evictTextRun( STextRun &run );
+		Void trimTextRuns();
 
 		MOSText();
 		~MOSText();
@@ -222,10 +304,13 @@ namespace doll
 	MOSText::MOSText()
 	: m_pDefStyle( nullptr )
 	, m_items()
-	, m_renderCache()
-	, m_lastCacheFrameId(0)
+	, m_uStyleId( 0 )
+	, m_textRunLRU()
+	, m_cTextRunBytes( 0 )
+	, m_cTextRunBudget( 16*1024*1024 )
 	{
 		DOLL_TRACE( "MOSText::MOSText()" );
+		memset( ( Void * )m_pTextRunBuckets, 0, sizeof( m_pTextRunBuckets ) );
 #if DOLL_OSTEXT_GDIPLUS
 		GdiplusStartupInput gdiplusStartupInput;
 		ULONG_PTR gdiplusToken;
@@ -235,7 +320,9 @@ namespace doll
 	MOSText::~MOSText()
 	{
 		DOLL_TRACE( "MOSText::~MOSText()" );
-		clearRenderedTexts();
+
+		// The text run textures went with fini(), before the render API
+		AX_ASSERT( m_cTextRunBytes == 0 );
 	}
 
 	Bool MOSText::setDefStyle( Str fontFamily, U32 fontSize )
@@ -282,6 +369,10 @@ namespace doll
 		if( !pTextStyle->font.set( fontFamily, double(fontSize) ) ) {
 			DOLL_TRACE( "Failed to set font (Cocoa)" );
 		}
+#elif DOLL_OSTEXT_FREETYPE
+		if( !pTextStyle->font.set( fontFamily, fontSize ) ) {
+			DOLL_TRACE( "Failed to set font (FreeType)" );
+		}
 #endif
 		pTextStyle->fontSize = S32( fontSize );
 
@@ -290,6 +381,7 @@ namespace doll
 		}
 
 		m_pDefStyle = pTextStyle;
+		++m_uStyleId;
 		DOLL_TRACE( "Font set successfully" );
 		return true;
 	}
@@ -420,27 +512,142 @@ namespace doll
 		AX_ASSERT_NOT_NULL( item.pStyle );
 
 		item.pStyle->font.render( item.textImage, item.text, item.drawSize );
+#elif DOLL_OSTEXT_FREETYPE
+		AX_ASSERT_NOT_NULL( item.pStyle );
+
+		item.pStyle->font.render( item.textImage, item.text, item.drawSize, item.uLineColor, item.uFillColor );
 #endif
 
 		item.uResX = item.drawSize.x;
 		item.uResY = item.drawSize.y;
 	}
 
-	Void MOSText::addRenderedText( RTexture *texture ) {
-		const U32 currentCacheFrameId = DOLL__CORESTRUC.frame.uRenderId;
-		if( m_lastCacheFrameId != currentCacheFrameId ) {
-			m_lastCacheFrameId = currentCacheFrameId;
-			clearRenderedTexts();
+	RTexture *MOSText::getTextRun( Str text, const SIntVector2 &size, U32 lineColor, U32 fillColor )
+	{
+		if( !m_pDefStyle && !setDefStyle( Str(), 0 ) ) {
+			return nullptr;
+		}
+
+		const U32 uRenderId = DOLL__CORESTRUC.frame.uRenderId;
+
+		U32 uHash = hashCRC32( text );
+		uHash = ( uHash ^ U32( size.x ) )*0x01000193;
+		uHash = ( uHash ^ U32( size.y ) )*0x01000193;
+		uHash = ( uHash ^ lineColor )*0x01000193;
+		uHash = ( uHash ^ fillColor )*0x01000193;
+		uHash = ( uHash ^ m_uStyleId )*0x01000193;
+
+		STextRun *&pBucket = m_pTextRunBuckets[ uHash%kTextRunBuckets ];
+		for( STextRun *pRun = pBucket; pRun != nullptr; pRun = pRun->pNextInBucket ) {
+			if( pRun->uHash != uHash || pRun->uStyleId != m_uStyleId ) {
+				continue;
+			}
+			if( pRun->size.x != size.x || pRun->size.y != size.y ) {
+				continue;
+			}
+			if( pRun->uLineColor != lineColor || pRun->uFillColor != fillColor ) {
+				continue;
+			}
+			if( pRun->text.num() != text.num() || memcmp( pRun->text.get(), text.get(), text.num() ) != 0 ) {
+				continue;
+			}
+
+			pRun->uRenderId = uRenderId;
+			pRun->lruLink.toFront();
+			return pRun->pTexture;
 		}
 
-		AX_EXPECT_MEMORY( m_renderCache.append( texture ) );
+		// Not cached; render it
+		RTexture *const pTexture = gfx_renderOSText( text, size, lineColor, fillColor );
+		if( !pTexture ) {
+			return nullptr;
+		}
+
+		STextRun *const pRun = new STextRun();
+		if( !AX_VERIFY_MEMORY( pRun ) ) {
+			gfx_deleteTexture( pTexture );
+			return nullptr;
+		}
+
+		if( !AX_VERIFY_MEMORY( pRun->text.tryAssign( text ) ) ) {
+			delete pRun;
+			gfx_deleteTexture( pTexture );
+			return nullptr;
+		}
+
+		pRun->uHash      = uHash;
+		pRun->uStyleId   = m_uStyleId;
+		pRun->size       = size;
+		pRun->uLineColor = lineColor;
+		pRun->uFillColor = fillColor;
+		pRun->pTexture   = pTexture;
+		pRun->cBytes     = UPtr( size.x )*UPtr( size.y )*4;
+		pRun->uRenderId  = uRenderId;
+
+		pRun->pNextInBucket = pBucket;
+		pBucket = pRun;
+		m_textRunLRU.addHead( pRun->lruLink );
+		m_cTextRunBytes += pRun->cBytes;
+
+		trimTextRuns();
+		return pTexture;
 	}
-	Void MOSText::clearRenderedTexts() {
-		for( SizeType n = m_renderCache.len(); n != 0; --n ) {
-			const SizeType i = n - 1;
-			m_renderCache[ i ] = gfx_deleteTexture( m_renderCache[ i ] );
+	Void MOSText::evictTextRun( STextRun &run )
+	{
+		STextRun **ppRun = &m_pTextRunBuckets[ run.uHash%kTextRunBuckets ];
+		while( *ppRun != &run ) {
+			AX_ASSERT_NOT_NULL( *ppRun );
+			ppRun = &( *ppRun )->pNextInBucket;
 		}
-		m_renderCache.clear();
+		*ppRun = run.pNextInBucket;
+		run.lruLink.unlink();
+
+		AX_ASSERT( m_cTextRunBytes >= run.cBytes );
+		m_cTextRunBytes -= run.cBytes;
+
+		delete &run;
+	}
+	Void MOSText::trimTextRuns()
+	{
+		// Runs drawn this frame are still referenced by queued draw commands,
+		// so the budget may be exceeded until the next frame
+		const U32 uRenderId = DOLL__CORESTRUC.frame.uRenderId;
+
+		while( m_cTextRunBytes > m_cTextRunBudget ) {
+			STextRun *const pRun = m_textRunLRU.tail();
+			if( !pRun || pRun->uRenderId == uRenderId ) {
+				break;
+			}
+
+			evictTextRun( *pRun );
+		}
+	}
+	Void MOSText::setTextRunBudget( UPtr cBytes )
+	{
+		m_cTextRunBudget = cBytes;
+		trimTextRuns();
+	}
+	UPtr MOSText::getTextRunBudget() const
+	{
+		return m_cTextRunBudget;
+	}
+	Void MOSText::clearTextRuns()
+	{
+		while( STextRun *const pRun = m_textRunLRU.tail() ) {
+			evictTextRun( *pRun );
+		}
+
+		AX_ASSERT( m_cTextRunBytes == 0 );
+	}
+
+	Void MOSText::fini()
+	{
+		DOLL_TRACE( "MOSText::fini()" );
+
+		clearTextRuns();
+#if DOLL_OSTEXT_FREETYPE
+		FreeType::fini();
+#endif
 	}
 
 	Void MOSText::measureText( const STextStyle *style_, Str text, SRect &dstArea ) {
@@ -481,9 +688,23 @@ namespace doll
 		dstArea.y1 = S32(boundingBox.Y);
 		dstArea.x2 = S32(boundingBox.X + boundingBox.Width);
 		dstArea.y2 = S32(boundingBox.Y + boundingBox.Height);
+#elif DOLL_OSTEXT_FREETYPE
+		style->font.measure( text, dstArea );
 #endif
 	}
 
+#if DOLL_OSTEXT_FREETYPE
+	Void MOSText::drawGlyphs( Str text, const SRect &area )
+	{
+		if( !m_pDefStyle && !setDefStyle( Str(), 0 ) ) {
+			return;
+		}
+
+		AX_ASSERT_NOT_NULL( m_pDefStyle );
+		m_pDefStyle->font.draw( text, area, DOLL_OSTEXT_LINE_COLOR, DOLL_OSTEXT_FILL_COLOR );
+	}
+#endif
+
 	DOLL_FUNC STextItem *DOLL_API gfx_newOSText( Str text, const SIntVector2 &size, U32 lineColor, U32 fillColor )
 	{
 		return g_osTextMgr->newText( text, size, lineColor, fillColor );
@@ -515,6 +736,8 @@ namespace doll
 		return ( const Void * )pText->pBmpBits;
 #elif DOLL_OSTEXT_COCOA
 		return ( const Void * )pText->textImage.getBits();
+#elif DOLL_OSTEXT_FREETYPE
+		return ( const Void * )pText->textImage.getBits();
 #else
 		return nullptr;
 #endif
@@ -549,14 +772,18 @@ namespace doll
 
 	DOLL_FUNC void DOLL_API gfx_drawOSText( Str text, const SRect &area )
 	{
-		RTexture *const tex = gfx_renderOSText( text, area.size() );
+#if DOLL_OSTEXT_FREETYPE
+		// Glyphs are already in the cache's atlas pages, so draw them directly
+		// rather than rasterizing the whole string into a new texture
+		g_osTextMgr->drawGlyphs( text, area );
+#else
+		RTexture *const tex = g_osTextMgr->getTextRun( text, area.size(), DOLL_OSTEXT_LINE_COLOR, DOLL_OSTEXT_FILL_COLOR );
 		if( !tex ) {
 			return;
 		}
 
-		g_osTextMgr->addRenderedText( tex );
-
 		gfx_queDrawImage( area.x1, area.y1, area.resX(), area.resY(), 0, 0, area.resX(), area.resY(), ~0U, ~0U, ~0U, ~0U, tex );
+#endif
 	}
 
 	DOLL_FUNC void DOLL_API gfx_measureOSText( Str text, SRect &dstArea )
@@ -564,4 +791,18 @@ namespace doll
 		g_osTextMgr->measureText( nullptr, text, dstArea );
 	}
 
+	DOLL_FUNC Void DOLL_API gfx_setOSTextCacheBudget( UPtr cBytes )
+	{
+		g_osTextMgr->setTextRunBudget( cBytes );
+	}
+	DOLL_FUNC UPtr DOLL_API gfx_getOSTextCacheBudget()
+	{
+		return g_osTextMgr->getTextRunBudget();
+	}
+
+	DOLL_FUNC Void DOLL_API gfx__ostext_fini()
+	{
+		g_osTextMgr->fini();
+	}
+
 }
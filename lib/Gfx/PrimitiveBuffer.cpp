@@ -6,6 +6,7 @@
 
 #include "doll/Core/Memory.hpp"
 #include "doll/Core/Logger.hpp"
+#include "doll/Math/HalfFloat.hpp"
 
 //#include <gl/GL.h>
 
@@ -57,17 +58,45 @@ namespace doll
 		SCacheItem m_cached[ 16 ];
 		UPtr       m_cCached;
 
+		static UPtr getStride( U32 uFlags )
+		{
+			if( !( uFlags & ( kVF_PosS16 | kVF_PosF16 | kVF_TexUNorm16 ) ) ) {
+				return sizeof( PrimitiveConfig::Vertex );
+			}
+
+			const U32 cTextures = ( uFlags & kVFMask_Tex )>>kVFShft_Tex;
+			const UPtr cPosBytes = ( uFlags & ( kVF_PosS16 | kVF_PosF16 ) ) != 0 ? 2*2 : 2*4;
+			const UPtr cTexBytes = ( uFlags & kVF_TexUNorm16 ) != 0 ? 2*2 : 2*4;
+
+			return cPosBytes + 4 + cTextures*cTexBytes;
+		}
+
 		UPtr fillLayout( SCacheItem &x, U32 uFlags )
 		{
-			if( !( x.vertexLayout = gfx_r_createLayout( sizeof( PrimitiveConfig::Vertex ) ) ) ) {
+			// Failures are cached as well (with a null layout) so a format the
+			// API can't take is only tried once
+			x.uFlags = uFlags;
+			x.link.setNode( &x );
+			x.link.unlink();
+			m_prioCache.addHead( x.link );
+
+			if( !( x.vertexLayout = gfx_r_createLayout( getStride( uFlags ) ) ) ) {
 				return 0;
 			}
 
 			UPtr offset = 0;
 			switch( uFlags & kVFMask_Pos ) {
 			case kVF_XY:
-				gfx_r_layoutVertex( x.vertexLayout, kVectorSize2 );
-				offset = 2*4;
+				if( uFlags & kVF_PosS16 ) {
+					gfx_r_layoutVertex( x.vertexLayout, kVectorSize2, kVectorTypeS16 );
+					offset = 2*2;
+				} else if( uFlags & kVF_PosF16 ) {
+					gfx_r_layoutVertex( x.vertexLayout, kVectorSize2, kVectorTypeF16 );
+					offset = 2*2;
+				} else {
+					gfx_r_layoutVertex( x.vertexLayout, kVectorSize2 );
+					offset = 2*4;
+				}
 				break;
 			case kVF_XYZ:
 				gfx_r_layoutVertex( x.vertexLayout, kVectorSize3 );
@@ -80,23 +109,25 @@ namespace doll
 			}
 
 			if( uFlags & kVF_DiffuseBit ) {
-				gfx_r_layoutColor( x.vertexLayout, kVectorSize4, kVectorTypeU8 );
+				gfx_r_layoutColor( x.vertexLayout, kVectorSize4, kVectorTypeU8, offset );
 			}
 			offset += 4;
 
 			const U32 cTextures = ( uFlags & kVFMask_Tex )>>kVFShft_Tex;
 			for( U32 i = 0; i < cTextures; ++i ) {
-				gfx_r_layoutTexCoord( x.vertexLayout, kVectorSize2, kVectorTypeF32, offset );
-				offset += 2*4;
+				if( uFlags & kVF_TexUNorm16 ) {
+					gfx_r_layoutTexCoord( x.vertexLayout, kVectorSize2, kVectorTypeU16_UNorm, offset );
+					offset += 2*2;
+				} else {
+					gfx_r_layoutTexCoord( x.vertexLayout, kVectorSize2, kVectorTypeF32, offset );
+					offset += 2*4;
+				}
 			}
 
-			// ### FIXME ### Check return value of gfx_r_finishLayout()
-			gfx_r_finishLayout( x.vertexLayout );
-
-			x.uFlags = uFlags;
-			x.link.setNode( &x );
-			x.link.unlink();
-			m_prioCache.addHead( x.link );
+			if( !gfx_r_finishLayout( x.vertexLayout ) ) {
+				gfx_r_destroyLayout( x.vertexLayout );
+				x.vertexLayout = 0;
+			}
 
 			return x.vertexLayout;
 		}
@@ -161,32 +192,146 @@ namespace doll
 			return kSuccess;
 		}
 
-		gfx_r_setLayout( getVertexLayout( vertexFormat ) );
-		gfx_r_drawMem( primType, getVertexCount(), sizeof( PrimitiveConfig::Vertex ), &buffer[0] );
+		// Packing the batch overwrites the buffer, so keep the vertices that
+		// carry over to the next one aside
+		const U32 cVerts = getVertexCount();
+		const U32 remainingSize = remains*VERTEX_SIZE;
+		AX_ASSERT( remains <= 2 );
 
-		U32 remainingSize = remains*VERTEX_SIZE;
+		Vertex tail[ 2 ];
 		if( remains>0 ) {
-#if DOLL__SECURE_LIB
-			memmove_s
-			(
-				buffer,
-				MAX_BUFFER,
-				( ( const char * )buffer ) + size - remainingSize,
-				remainingSize
-			);
-#else
-			memmove
-			(
-				buffer,
-				( ( const char * )buffer ) + size - remainingSize,
-				remainingSize
-			);
-#endif
+			memcpy( ( void * )tail, ( ( const char * )buffer ) + size - remainingSize, remainingSize );
+		}
+
+		if( !submitCompact( cVerts ) ) {
+			gfx_r_setLayout( getVertexLayout( vertexFormat ) );
+			gfx_r_drawMem( primType, cVerts, sizeof( PrimitiveConfig::Vertex ), &buffer[0] );
+		}
+
+		if( remains>0 ) {
+			memcpy( ( void * )buffer, ( const void * )tail, remainingSize );
 		}
 
 		size = remainingSize;
 		return kSuccess;
 	}
+	Bool PrimitiveBuffer::fitsPosS16( F32 x, F32 y )
+	{
+		return
+			x >= -32768.0f && x <= 32767.0f && floorf( x ) == x &&
+			y >= -32768.0f && y <= 32767.0f && floorf( y ) == y;
+	}
+	Bool PrimitiveBuffer::fitsPosF16( F32 x, F32 y )
+	{
+		static const F32 kMaxPosError = 1.0f/32;
+
+		// Out of range values become infinite, which is never close enough
+		return
+			fabsf( F32( F16( x ) ) - x ) <= kMaxPosError &&
+			fabsf( F32( F16( y ) ) - y ) <= kMaxPosError;
+	}
+	Bool PrimitiveBuffer::fitsTexUNorm16( F32 u, F32 v )
+	{
+		return u >= 0.0f && u <= 1.0f && v >= 0.0f && v <= 1.0f;
+	}
+	U16 PrimitiveBuffer::packUNorm16( F32 x )
+	{
+		return U16( x*65535.0f + 0.5f );
+	}
+
+	Bool PrimitiveBuffer::submitCompact( U32 cVerts )
+	{
+		if( ( vertexFormat & kVFMask_Pos ) != kVF_XY || ( vertexFormat & kVFMask_Tex ) > kVF_Tex1 ) {
+			return false;
+		}
+
+		const Vertex *const pVerts = ( const Vertex * )&buffer[0];
+		const Bool bTextured = ( vertexFormat & kVFMask_Tex ) == kVF_Tex1;
+
+		// Pick the smallest form every vertex of the batch fits
+		Bool bPosS16 = true;
+		Bool bPosF16 = true;
+		Bool bTexUNorm16 = bTextured;
+		for( U32 i = 0; i < cVerts && ( bPosS16 || bPosF16 || bTexUNorm16 ); ++i ) {
+			const Vertex &v = pVerts[ i ];
+
+			if( bPosS16 && !fitsPosS16( v.x, v.y ) ) {
+				bPosS16 = false;
+
+				// The vertices before this one were only checked against S16,
+				// and whole pixels past 2048 don't all fit F16
+				for( U32 j = 0; j < i && bPosF16; ++j ) {
+					bPosF16 = fitsPosF16( pVerts[ j ].x, pVerts[ j ].y );
+				}
+			}
+			if( bPosF16 && !bPosS16 ) {
+				bPosF16 = fitsPosF16( v.x, v.y );
+			}
+			if( bTexUNorm16 ) {
+				bTexUNorm16 = fitsTexUNorm16( v.u, v.v );
+			}
+		}
+
+		U32 uPosFlag = bPosS16 ? U32( kVF_PosS16 ) : bPosF16 ? U32( kVF_PosF16 ) : 0;
+		U32 uTexFlag = bTexUNorm16 ? U32( kVF_TexUNorm16 ) : 0;
+		if( !uPosFlag && !uTexFlag ) {
+			return false;
+		}
+
+		// Not every API takes every compact type; drop the texture coordinates
+		// back to F32 first, then give up
+		UPtr layout = getVertexLayout( vertexFormat | uPosFlag | uTexFlag );
+		if( !layout && uTexFlag != 0 && uPosFlag != 0 ) {
+			uTexFlag = 0;
+			layout = getVertexLayout( vertexFormat | uPosFlag );
+		}
+		if( !layout ) {
+			return false;
+		}
+
+		// Pack in place, front to back (a packed vertex is never larger than
+		// a full one, so nothing is overwritten before it's read)
+		char *pDst = &buffer[0];
+		for( U32 i = 0; i < cVerts; ++i ) {
+			const Vertex v = pVerts[ i ];
+
+			if( uPosFlag == kVF_PosS16 ) {
+				const S16 pos[ 2 ] = { S16( v.x ), S16( v.y ) };
+				memcpy( pDst, pos, sizeof( pos ) );
+				pDst += sizeof( pos );
+			} else if( uPosFlag == kVF_PosF16 ) {
+				const U16 pos[ 2 ] = { F16( v.x ).getBits(), F16( v.y ).getBits() };
+				memcpy( pDst, pos, sizeof( pos ) );
+				pDst += sizeof( pos );
+			} else {
+				const F32 pos[ 2 ] = { v.x, v.y };
+				memcpy( pDst, pos, sizeof( pos ) );
+				pDst += sizeof( pos );
+			}
+
+			memcpy( pDst, &v.diffuse, sizeof( v.diffuse ) );
+			pDst += sizeof( v.diffuse );
+
+			if( !bTextured ) {
+				continue;
+			}
+
+			if( uTexFlag != 0 ) {
+				const U16 tex[ 2 ] = { packUNorm16( v.u ), packUNorm16( v.v ) };
+				memcpy( pDst, tex, sizeof( tex ) );
+				pDst += sizeof( tex );
+			} else {
+				const F32 tex[ 2 ] = { v.u, v.v };
+				memcpy( pDst, tex, sizeof( tex ) );
+				pDst += sizeof( tex );
+			}
+		}
+
+		gfx_r_setLayout( layout );
+		gfx_r_drawMem( primType, cVerts, UPtr( pDst - &buffer[0] )/cVerts, &buffer[0] );
+
+		return true;
+	}
 
 #define DO_SUBMIT() \
 		EResult ret__ = submitFullBuffer();\
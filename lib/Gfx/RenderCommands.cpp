@@ -621,7 +621,7 @@ namespace doll
 			return;
 		}
 
-		UPtr gltex = tex->getBackingTexture();
+		UPtr gltex = tex->useBackingTexture();
 		if( !gltex ) {
 			return;
 		}
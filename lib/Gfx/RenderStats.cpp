@@ -0,0 +1,495 @@
+#define DOLL_TRACE_FACILITY doll::kLog_APIMgr
+#include "../BuildSettings.hpp"
+
+#include "doll/Gfx/RenderStats.hpp"
+
+#include "doll/Gfx/Layer.hpp"
+#include "doll/Gfx/LayerEffect.hpp"
+#include "doll/Gfx/OSText.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+
+#include <stdio.h>
+
+namespace doll
+{
+
+	// Deepest nesting of scopes; pushes beyond this are counted in the
+	// deepest scope
+	static const UPtr kMaxRenderStatsScopeDepth = 64;
+
+	MRenderStats &MRenderStats::get()
+	{
+		static MRenderStats instance;
+		return instance;
+	}
+
+	MRenderStats::MRenderStats()
+	: m_bEnabled( false )
+	, m_pHistory( nullptr )
+	, m_cMaxHistory( 0 )
+	, m_cHistory( 0 )
+	, m_uNextHistory( 0 )
+	, m_frame()
+	, m_scopeStack()
+	, m_cOverflow( 0 )
+	, m_uScope( 0 )
+	{
+		memset( &m_frame.stats, 0, sizeof( m_frame.stats ) );
+	}
+	MRenderStats::~MRenderStats()
+	{
+		disable();
+	}
+
+	Bool MRenderStats::enable( U32 cHistoryFrames )
+	{
+		if( !cHistoryFrames ) {
+			cHistoryFrames = 1;
+		}
+
+		if( m_bEnabled && m_cMaxHistory == cHistoryFrames ) {
+			return true;
+		}
+
+		disable();
+
+		m_pHistory = new SFrame[ cHistoryFrames ];
+		if( !AX_VERIFY_MEMORY( m_pHistory ) ) {
+			return false;
+		}
+
+		m_cMaxHistory  = cHistoryFrames;
+		m_cHistory     = 0;
+		m_uNextHistory = 0;
+
+		m_scopeStack.clear();
+		m_cOverflow = 0;
+		memset( &m_frame.stats, 0, sizeof( m_frame.stats ) );
+		resetFrame();
+
+		// Scope 0 (outside of any scope) must exist for the counters
+		if( m_frame.scopes.isEmpty() ) {
+			disable();
+			return false;
+		}
+
+		m_bEnabled = true;
+		return true;
+	}
+	Void MRenderStats::disable()
+	{
+		m_bEnabled = false;
+
+		delete[] m_pHistory;
+		m_pHistory = nullptr;
+
+		m_cMaxHistory  = 0;
+		m_cHistory     = 0;
+		m_uNextHistory = 0;
+
+		m_frame.scopes.purge();
+		m_scopeStack.purge();
+		m_cOverflow = 0;
+		m_uScope = 0;
+	}
+
+	U32 MRenderStats::getFrameCount() const
+	{
+		return m_cHistory;
+	}
+	const SGfxRenderFrameStats *MRenderStats::getFrame( U32 uFramesAgo ) const
+	{
+		if( uFramesAgo >= m_cHistory ) {
+			return nullptr;
+		}
+
+		const U32 uIndex = ( m_uNextHistory + m_cMaxHistory - 1 - uFramesAgo )%m_cMaxHistory;
+		return &m_pHistory[ uIndex ].stats;
+	}
+	const SGfxRenderScopeStats *MRenderStats::getScope( U32 uScope, U32 uFramesAgo ) const
+	{
+		if( uFramesAgo >= m_cHistory ) {
+			return nullptr;
+		}
+
+		const U32 uIndex = ( m_uNextHistory + m_cMaxHistory - 1 - uFramesAgo )%m_cMaxHistory;
+		const SFrame &frame = m_pHistory[ uIndex ];
+		if( uScope >= frame.scopes.num() ) {
+			return nullptr;
+		}
+
+		return &frame.scopes[ uScope ];
+	}
+
+	Void MRenderStats::pushScope( const RLayer *pLayer, const RSpriteGroup *pGroup )
+	{
+		if( !m_bEnabled ) {
+			return;
+		}
+
+		SScopeKey key;
+		key.pLayer = pLayer;
+		key.pGroup = pGroup;
+
+		// Too deep (or out of memory): the work goes to the current scope,
+		// and the matching pop must leave the stack alone
+		if( m_cOverflow > 0 || m_scopeStack.num() >= kMaxRenderStatsScopeDepth || !m_scopeStack.append( key ) ) {
+			++m_cOverflow;
+			return;
+		}
+
+		selectScope( pLayer, pGroup );
+	}
+	Void MRenderStats::popScope()
+	{
+		if( !m_bEnabled ) {
+			return;
+		}
+
+		if( m_cOverflow > 0 ) {
+			--m_cOverflow;
+			return;
+		}
+
+		if( m_scopeStack.isEmpty() ) {
+			return;
+		}
+
+		m_scopeStack.removeLast();
+
+		if( m_scopeStack.isEmpty() ) {
+			m_uScope = 0;
+			return;
+		}
+
+		const SScopeKey &top = m_scopeStack.last();
+		selectScope( top.pLayer, top.pGroup );
+	}
+
+	// Make the scope for the given layer and group current, adding it to the
+	// frame if this is its first use
+	Bool MRenderStats::selectScope( const RLayer *pLayer, const RSpriteGroup *pGroup )
+	{
+		// Layers push a scope for each sprite group, so check the last one
+		// used before searching
+		const UPtr cScopes = m_frame.scopes.num();
+		for( UPtr i = 0; i < cScopes; ++i ) {
+			const UPtr j = ( m_uScope + i )%cScopes;
+			const SGfxRenderScopeStats &scope = m_frame.scopes[ j ];
+			if( scope.pLayer == pLayer && scope.pGroup == pGroup ) {
+				m_uScope = j;
+				return true;
+			}
+		}
+
+		SGfxRenderScopeStats scope;
+		memset( &scope, 0, sizeof( scope ) );
+		scope.pLayer = pLayer;
+		scope.pGroup = pGroup;
+		if( pLayer != nullptr ) {
+			const Str name = pLayer->getName();
+			snprintf( scope.szLayerName, sizeof( scope.szLayerName ), "%.*s", name.lenInt(), name.get() );
+		}
+
+		if( !m_frame.scopes.append( scope ) ) {
+			m_uScope = 0;
+			return false;
+		}
+
+		m_uScope = cScopes;
+		return true;
+	}
+	Void MRenderStats::resetFrame()
+	{
+		m_frame.scopes.clear();
+		m_uScope = 0;
+
+		SGfxRenderScopeStats scope;
+		memset( &scope, 0, sizeof( scope ) );
+		if( !AX_VERIFY_MEMORY( m_frame.scopes.append( scope ) ) ) {
+			return;
+		}
+
+		// Scopes still open (e.g., presenting from within a layer) carry over
+		for( const SScopeKey &key : m_scopeStack ) {
+			selectScope( key.pLayer, key.pGroup );
+		}
+	}
+
+	Void MRenderStats::endFrame()
+	{
+		if( !m_bEnabled ) {
+			return;
+		}
+
+		SFrame &dst = m_pHistory[ m_uNextHistory ];
+
+		SGfxRenderCounters &total = m_frame.stats.total;
+		memset( &total, 0, sizeof( total ) );
+		for( const SGfxRenderScopeStats &scope : m_frame.scopes ) {
+			const SGfxRenderCounters &c = scope.counters;
+
+			total.cDraws              += c.cDraws;
+			total.cVertices           += c.cVertices;
+			total.cStateChanges       += c.cStateChanges;
+			total.cElidedStateChanges += c.cElidedStateChanges;
+			total.cTextureBinds       += c.cTextureBinds;
+			total.cVBufferBytes       += c.cVBufferBytes;
+			total.cTextureBytes       += c.cTextureBytes;
+		}
+		m_frame.stats.cScopes = U32( m_frame.scopes.num() );
+
+		// Swap rather than copy, so both keep their memory for later frames
+		dst.stats = m_frame.stats;
+		dst.scopes.swap( m_frame.scopes );
+
+		m_uNextHistory = ( m_uNextHistory + 1 )%m_cMaxHistory;
+		if( m_cHistory < m_cMaxHistory ) {
+			++m_cHistory;
+		}
+
+		++m_frame.stats.uFrame;
+		resetFrame();
+	}
+
+	//--------------------------------------------------------------------//
+
+	// Draws the statistics of recent frames into its layer
+	class CRenderStatsOverlay: public ILayerEffect
+	{
+	public:
+		static const S32 kResX = 320;
+		static const S32 kResY = 112;
+		// Frames between refreshes of the text (each new text is rendered
+		// into a new texture)
+		static const U32 kTextRefreshFrames = 15;
+
+		CRenderStatsOverlay()
+		: ILayerEffect()
+		, m_pLayer( nullptr )
+		, m_uTextFrame( 0 )
+		{
+			m_szText[ 0 ] = '\0';
+		}
+		virtual ~CRenderStatsOverlay()
+		{
+		}
+
+		Bool show( Bool bShow );
+		inline Bool isShown() const
+		{
+			return m_pLayer != nullptr;
+		}
+
+		virtual void run( RLayer &layer ) override;
+
+	private:
+		RLayer *m_pLayer;
+		char    m_szText[ 256 ];
+		U32     m_uTextFrame;
+
+		Void refreshText();
+	};
+	static CRenderStatsOverlay g_renderStatsOverlay;
+
+	Bool CRenderStatsOverlay::show( Bool bShow )
+	{
+		if( !bShow ) {
+			delete m_pLayer;
+			m_pLayer = nullptr;
+			return true;
+		}
+
+		if( m_pLayer != nullptr ) {
+			return true;
+		}
+
+		if( !g_renderStats->isEnabled() && !g_renderStats->enable( 120 ) ) {
+			return false;
+		}
+
+		m_pLayer = g_layerMgr->newLayer();
+		if( !AX_VERIFY_MEMORY( m_pLayer ) ) {
+			return false;
+		}
+
+		m_pLayer->setName( "RenderStatsOverlay" );
+		m_pLayer->setPosition( SIntVector2( 8, 8 ) );
+		m_pLayer->setSize( SIntVector2( kResX, kResY ) );
+		m_pLayer->setVirtualSpace( SRect( 0, 0, kResX, kResY ) );
+		m_pLayer->setAutoclear( true );
+		m_pLayer->addEffectToBack( *this );
+		m_pLayer->moveTop();
+
+		m_szText[ 0 ] = '\0';
+		m_uTextFrame  = 0;
+
+		return true;
+	}
+
+	Void CRenderStatsOverlay::refreshText()
+	{
+		const SGfxRenderFrameStats *const pFrame = g_renderStats->getFrame( 0 );
+		if( !pFrame ) {
+			m_szText[ 0 ] = '\0';
+			return;
+		}
+
+		const SGfxRenderCounters &c = pFrame->total;
+		snprintf
+		(
+			m_szText, sizeof( m_szText ),
+			"Draws: %u  Vertices: %u\n"
+			"State changes: %u (%u dropped)  Binds: %u\n"
+			"Uploads: %u KiB vertices, %u KiB texels\n"
+			"Scopes: %u",
+			c.cDraws, c.cVertices,
+			c.cStateChanges, c.cElidedStateChanges, c.cTextureBinds,
+			U32( c.cVBufferBytes/1024 ), U32( c.cTextureBytes/1024 ),
+			pFrame->cScopes
+		);
+	}
+
+	void CRenderStatsOverlay::run( RLayer &layer )
+	{
+		static const U32 kBackColor = DOLL_RGBA( 0x00, 0x00, 0x00, 0xB0 );
+		static const U32 kBarColor  = DOLL_RGBA( 0x40, 0xE0, 0x60, 0xFF );
+		static const S32 kGraphResY = 32;
+
+		// Statistics may have been turned off since the overlay was shown
+		if( !g_renderStats->isEnabled() ) {
+			return;
+		}
+
+		const SGfxRenderFrameStats *const pLast = g_renderStats->getFrame( 0 );
+		if( pLast != nullptr && ( !m_szText[ 0 ] || pLast->uFrame - m_uTextFrame >= kTextRefreshFrames ) ) {
+			refreshText();
+			m_uTextFrame = pLast->uFrame;
+		}
+
+		RLayer *const pPrevLayer = gfx_getCurrentLayer();
+		gfx_setCurrentLayer( &layer );
+
+		gfx_queDrawRect( 0, 0, kResX, kResY, 0, 0, 0, 0, kBackColor, kBackColor, kBackColor, kBackColor );
+
+		// Draw calls of recent frames, newest on the right, scaled to the
+		// busiest of them
+		U32 cBars = g_renderStats->getFrameCount();
+		if( cBars > U32( kResX/2 ) ) {
+			cBars = U32( kResX/2 );
+		}
+
+		U32 cMaxDraws = 1;
+		for( U32 i = 0; i < cBars; ++i ) {
+			const U32 cDraws = g_renderStats->getFrame( i )->total.cDraws;
+			if( cMaxDraws < cDraws ) {
+				cMaxDraws = cDraws;
+			}
+		}
+		for( U32 i = 0; i < cBars; ++i ) {
+			const U32 cDraws = g_renderStats->getFrame( i )->total.cDraws;
+			const S32 resY = S32( U64( cDraws )*kGraphResY/cMaxDraws );
+			if( !resY ) {
+				continue;
+			}
+
+			const S32 x = kResX - 2*S32( i + 1 );
+			gfx_queDrawRect( x, kResY - resY, x + 2, kResY, 0, 0, 0, 0, kBarColor, kBarColor, kBarColor, kBarColor );
+		}
+
+		if( m_szText[ 0 ] != '\0' ) {
+			gfx_drawOSText( Str( m_szText ), SRect( 4, 4, kResX - 4, kResY - kGraphResY - 4 ) );
+		}
+
+		gfx_setCurrentLayer( pPrevLayer );
+	}
+
+	//--------------------------------------------------------------------//
+
+	DOLL_FUNC Bool DOLL_API gfx_enableRenderStats( U32 cHistoryFrames )
+	{
+		return g_renderStats->enable( cHistoryFrames );
+	}
+	DOLL_FUNC Void DOLL_API gfx_disableRenderStats()
+	{
+		g_renderStats->disable();
+	}
+	DOLL_FUNC Bool DOLL_API gfx_areRenderStatsEnabled()
+	{
+		return g_renderStats->isEnabled();
+	}
+
+	DOLL_FUNC U32 DOLL_API gfx_getRenderStatsFrameCount()
+	{
+		return g_renderStats->getFrameCount();
+	}
+	DOLL_FUNC Bool DOLL_API gfx_getRenderStatsFrame( SGfxRenderFrameStats &dst, U32 uFramesAgo )
+	{
+		const SGfxRenderFrameStats *const p = g_renderStats->getFrame( uFramesAgo );
+		if( !p ) {
+			return false;
+		}
+
+		dst = *p;
+		return true;
+	}
+	DOLL_FUNC Bool DOLL_API gfx_getRenderStatsScope( SGfxRenderScopeStats &dst, U32 uScope, U32 uFramesAgo )
+	{
+		const SGfxRenderScopeStats *const p = g_renderStats->getScope( uScope, uFramesAgo );
+		if( !p ) {
+			return false;
+		}
+
+		dst = *p;
+		return true;
+	}
+	DOLL_FUNC Bool DOLL_API gfx_getLayerRenderStats( SGfxRenderCounters &dst, const RLayer *pLayer, U32 uFramesAgo )
+	{
+		const SGfxRenderFrameStats *const pFrame = g_renderStats->getFrame( uFramesAgo );
+		if( !pFrame ) {
+			return false;
+		}
+
+		memset( &dst, 0, sizeof( dst ) );
+
+		Bool bFound = false;
+		for( U32 i = 0; i < pFrame->cScopes; ++i ) {
+			const SGfxRenderScopeStats *const pScope = g_renderStats->getScope( i, uFramesAgo );
+			if( !pScope || pScope->pLayer != pLayer ) {
+				continue;
+			}
+
+			const SGfxRenderCounters &c = pScope->counters;
+			dst.cDraws              += c.cDraws;
+			dst.cVertices           += c.cVertices;
+			dst.cStateChanges       += c.cStateChanges;
+			dst.cElidedStateChanges += c.cElidedStateChanges;
+			dst.cTextureBinds       += c.cTextureBinds;
+			dst.cVBufferBytes       += c.cVBufferBytes;
+			dst.cTextureBytes       += c.cTextureBytes;
+
+			bFound = true;
+		}
+
+		return bFound;
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_pushRenderStatsScope( const RLayer *pLayer, const RSpriteGroup *pGroup )
+	{
+		g_renderStats->pushScope( pLayer, pGroup );
+	}
+	DOLL_FUNC Void DOLL_API gfx_popRenderStatsScope()
+	{
+		g_renderStats->popScope();
+	}
+
+	DOLL_FUNC Bool DOLL_API gfx_showRenderStatsOverlay( Bool bShow )
+	{
+		return g_renderStatsOverlay.show( bShow );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isRenderStatsOverlayShown()
+	{
+		return g_renderStatsOverlay.isShown();
+	}
+
+}
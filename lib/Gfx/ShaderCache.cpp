@@ -0,0 +1,385 @@
+#define DOLL_TRACE_FACILITY doll::kLog_GfxAPIDrv
+#include "../BuildSettings.hpp"
+
+#include "doll/Gfx/ShaderCache.hpp"
+
+#include "doll/Core/Logger.hpp"
+#include "doll/IO/VFS.hpp"
+
+#include <stdlib.h>
+
+namespace doll
+{
+
+	// "DSHC"
+	static const U32 kShaderCacheMagic = 0x43485344;
+	// Bump this whenever the entry layout changes
+	static const U16 kShaderCacheFormat = 1;
+	// Extension of entry files (anything else in the directory is left alone)
+	static const char *const kShaderCacheExt = ".dsc";
+	// Larger entries are ignored rather than loaded
+	static const U32 kMaxShaderCacheEntryBytes = U32( 1 )<<28;
+
+#pragma pack(push,1)
+	struct SShaderCacheHeader
+	{
+		// `kShaderCacheMagic`
+		U32 uMagic;
+		// `kShaderCacheFormat`
+		U16 uFormat;
+		U16 uReserved;
+		// Key the entry was stored under
+		U64 uKey;
+		// Backend defined tag
+		U32 uTag;
+		// Size and checksum of the blob (right after the header)
+		U32 cBytes;
+		U64 uChecksum;
+	};
+#pragma pack(pop)
+
+	CShaderCacheKey &CShaderCacheKey::addBytes( const Void *pData, UPtr cBytes )
+	{
+		AX_ASSERT( pData != nullptr || cBytes == 0 );
+
+		const U8 *const p = reinterpret_cast< const U8 * >( pData );
+		for( UPtr i = 0; i < cBytes; ++i ) {
+			m_uHash ^= U64( p[ i ] );
+			m_uHash *= kPrime;
+		}
+
+		return *this;
+	}
+	CShaderCacheKey &CShaderCacheKey::addString( Str s )
+	{
+		// Include the length so ("ab","c") and ("a","bc") differ
+		addU32( U32( s.len() ) );
+		return addBytes( s.get(), s.len() );
+	}
+	CShaderCacheKey &CShaderCacheKey::addU32( U32 x )
+	{
+		// Byte by byte, so the key doesn't depend on endianness
+		U8 bytes[ 4 ];
+		for( U32 i = 0; i < 4; ++i ) {
+			bytes[ i ] = U8( x>>( i*8 ) );
+		}
+
+		return addBytes( bytes, sizeof( bytes ) );
+	}
+	CShaderCacheKey &CShaderCacheKey::addU64( U64 x )
+	{
+		addU32( U32( x ) );
+		return addU32( U32( x>>32 ) );
+	}
+
+	DOLL_FUNC U64 DOLL_API gfx_calcShaderCacheKey( EShaderFormat fmt, EShaderStage stage, const Void *pSource, UPtr cSourceBytes, U64 extraKey )
+	{
+		return
+			CShaderCacheKey()
+			.addU32( U32( kShaderCacheFormat ) )
+			.addU32( U32( fmt ) )
+			.addU32( U32( stage ) )
+			.addU64( extraKey )
+			.addU64( U64( cSourceBytes ) )
+			.addBytes( pSource, cSourceBytes )
+			.get();
+	}
+
+	static U64 calcChecksum( const Void *pData, UPtr cBytes )
+	{
+		return CShaderCacheKey().addBytes( pData, cBytes ).get();
+	}
+
+	static Bool readEntryFile( TMutArr<U8> &dst, const Str &filename )
+	{
+		IFile *const pFile = fs_open( filename, kFileOpenF_R );
+		if( !pFile ) {
+			return false;
+		}
+
+		const U64 cBytes = fs_size( pFile );
+		const Bool bRead =
+			cBytes >= sizeof( SShaderCacheHeader ) &&
+			cBytes <= U64( kMaxShaderCacheEntryBytes ) + sizeof( SShaderCacheHeader ) &&
+			AX_VERIFY_MEMORY( dst.resize( UPtr( cBytes ) ) ) &&
+			fs_read( pFile, dst.pointer(), UPtr( cBytes ) ) == UPtr( cBytes );
+
+		fs_close( pFile );
+		return bRead;
+	}
+
+	CShaderCache::CShaderCache()
+	: m_dirname()
+	, m_cMaxBytes( kDefaultMaxBytes )
+	, m_cBytes( 0 )
+	{
+	}
+	CShaderCache::~CShaderCache()
+	{
+	}
+
+	Bool CShaderCache::setDirectory( Str dirname )
+	{
+		m_cBytes = 0;
+
+		if( dirname.isEmpty() ) {
+			m_dirname.clear();
+			return true;
+		}
+
+		if( !fs_dirExists( dirname ) && !fs_mkdir( dirname ) ) {
+			g_ErrorLog( dirname ) += "Cannot use as the shader cache directory.";
+			m_dirname.clear();
+			return false;
+		}
+
+		if( !AX_VERIFY_MEMORY( m_dirname.assign( dirname ) ) ) {
+			m_dirname.clear();
+			return false;
+		}
+
+		// The budget may have shrunk since the last run; this also counts the
+		// bytes already in the directory
+		trim();
+		return true;
+	}
+
+	// "<dir>/<key>.dsc"
+	Bool CShaderCache::getEntryFilename( MutStr &dst, U64 uKey ) const
+	{
+		static const char *const pszHex = "0123456789abcdef";
+
+		char szName[ 16 + 4 + 1 ];
+		for( UPtr i = 0; i < 16; ++i ) {
+			szName[ i ] = pszHex[ ( uKey>>( 60 - i*4 ) ) & 0xF ];
+		}
+		for( UPtr i = 0; i < 5; ++i ) {
+			szName[ 16 + i ] = kShaderCacheExt[ i ];
+		}
+
+		return dst.assign( m_dirname ) && dst.tryAppendPath( Str( szName ) );
+	}
+
+	Bool CShaderCache::load( U64 uKey, TMutArr<U8> &dst, U32 &outTag )
+	{
+		if( !isEnabled() ) {
+			return false;
+		}
+
+		MutStr filename;
+		if( !getEntryFilename( filename, uKey ) ) {
+			return false;
+		}
+
+		TMutArr<U8> image;
+		if( !readEntryFile( image, filename ) ) {
+			return false;
+		}
+
+		SShaderCacheHeader hdr;
+		memcpy( &hdr, image.pointer(), sizeof( hdr ) );
+
+		const U8 *const pBlob = image.pointer() + sizeof( hdr );
+		const Bool bValid =
+			hdr.uMagic == kShaderCacheMagic &&
+			hdr.uFormat == kShaderCacheFormat &&
+			hdr.uKey == uKey &&
+			UPtr( hdr.cBytes ) == image.num() - sizeof( hdr ) &&
+			hdr.uChecksum == calcChecksum( pBlob, hdr.cBytes );
+
+		if( !bValid ) {
+			DOLL_DEBUG_LOG += axf( "Discarding damaged shader cache entry \"%.*s\"", filename.lenInt(), filename.get() );
+			fs_remove( filename );
+			return false;
+		}
+
+		if( !AX_VERIFY_MEMORY( dst.resize( hdr.cBytes ) ) ) {
+			return false;
+		}
+		if( hdr.cBytes > 0 ) {
+			memcpy( dst.pointer(), pBlob, hdr.cBytes );
+		}
+
+		outTag = hdr.uTag;
+		return true;
+	}
+	Bool CShaderCache::store( U64 uKey, U32 uTag, const Void *pData, UPtr cBytes )
+	{
+		AX_ASSERT( pData != nullptr || cBytes == 0 );
+
+		if( !isEnabled() || cBytes > kMaxShaderCacheEntryBytes ) {
+			return false;
+		}
+
+		MutStr filename;
+		if( !getEntryFilename( filename, uKey ) ) {
+			return false;
+		}
+
+		SShaderCacheHeader hdr;
+		hdr.uMagic    = kShaderCacheMagic;
+		hdr.uFormat   = kShaderCacheFormat;
+		hdr.uReserved = 0;
+		hdr.uKey      = uKey;
+		hdr.uTag      = uTag;
+		hdr.cBytes    = U32( cBytes );
+		hdr.uChecksum = calcChecksum( pData, cBytes );
+
+		IFile *const pFile = fs_open( filename, kFileOpenF_W | kFileOpenF_Recreate, kFileAttrib_Regular );
+		if( !pFile ) {
+			return false;
+		}
+
+		const Bool bWritten =
+			fs_write( pFile, &hdr, sizeof( hdr ) ) == sizeof( hdr ) &&
+			fs_write( pFile, pData, cBytes ) == cBytes;
+
+		fs_close( pFile );
+
+		// Don't leave a truncated entry behind (it would only fail to load)
+		if( !bWritten ) {
+			fs_remove( filename );
+			return false;
+		}
+
+		// Only look at the directory again once the entries stored since it
+		// was last looked at could have put it over budget (an entry that was
+		// replaced is counted twice until then)
+		m_cBytes += sizeof( hdr ) + cBytes;
+		if( m_cBytes > m_cMaxBytes ) {
+			trim();
+		}
+
+		return true;
+	}
+	Void CShaderCache::remove( U64 uKey )
+	{
+		if( !isEnabled() ) {
+			return;
+		}
+
+		MutStr filename;
+		if( getEntryFilename( filename, uKey ) ) {
+			fs_remove( filename );
+		}
+	}
+
+	// An entry file found in the cache directory
+	struct SShaderCacheFile
+	{
+		char szName[ 16 + 4 + 1 ];
+		U64  uTimeModified;
+		U64  cBytes;
+	};
+	static int compareFilesByAge( const void *pA, const void *pB )
+	{
+		const SShaderCacheFile &a = *reinterpret_cast< const SShaderCacheFile * >( pA );
+		const SShaderCacheFile &b = *reinterpret_cast< const SShaderCacheFile * >( pB );
+
+		if( a.uTimeModified != b.uTimeModified ) {
+			return a.uTimeModified < b.uTimeModified ? -1 : 1;
+		}
+
+		return 0;
+	}
+
+	// List the entry files in `dirname`
+	static Bool listEntryFiles( TMutArr<SShaderCacheFile> &dst, const Str &dirname )
+	{
+		IDir *const pDir = fs_openDir( dirname );
+		if( !pDir ) {
+			return false;
+		}
+
+		Bool bOk = true;
+
+		SDirEntry entry;
+		while( fs_readDir( pDir, entry ) ) {
+			const Str name( entry.getName() );
+			if( ( entry.uAttributes & kFileAttribTypeMask ) != kFileAttrib_Regular ) {
+				continue;
+			}
+			if( name.len() != 16 + 4 || !name.getExtension().caseCmp( kShaderCacheExt ) ) {
+				continue;
+			}
+
+			SShaderCacheFile file;
+			memcpy( file.szName, name.get(), name.len() );
+			file.szName[ name.len() ] = '\0';
+			file.uTimeModified = entry.uTimeModified;
+			file.cBytes        = entry.cBytes;
+
+			if( !AX_VERIFY_MEMORY( dst.append( file ) ) ) {
+				bOk = false;
+				break;
+			}
+		}
+
+		fs_closeDir( pDir );
+		return bOk;
+	}
+
+	Void CShaderCache::clear()
+	{
+		if( !isEnabled() ) {
+			return;
+		}
+
+		TMutArr<SShaderCacheFile> files;
+		listEntryFiles( files, m_dirname );
+
+		MutStr filename;
+		for( const SShaderCacheFile &file : files ) {
+			if( filename.assign( m_dirname ) && filename.tryAppendPath( Str( file.szName ) ) ) {
+				fs_remove( filename );
+			}
+		}
+
+		m_cBytes = 0;
+	}
+	Void CShaderCache::trim()
+	{
+		if( !isEnabled() ) {
+			return;
+		}
+
+		// If the directory can't be listed, count from zero again rather than
+		// trying on every store
+		m_cBytes = 0;
+
+		TMutArr<SShaderCacheFile> files;
+		if( !listEntryFiles( files, m_dirname ) ) {
+			return;
+		}
+
+		U64 cTotalBytes = 0;
+		for( const SShaderCacheFile &file : files ) {
+			cTotalBytes += file.cBytes;
+		}
+		if( cTotalBytes <= m_cMaxBytes ) {
+			m_cBytes = cTotalBytes;
+			return;
+		}
+
+		// Oldest first
+		qsort( ( void * )files.pointer(), files.num(), sizeof( SShaderCacheFile ), &compareFilesByAge );
+
+		MutStr filename;
+		for( const SShaderCacheFile &file : files ) {
+			if( cTotalBytes <= m_cMaxBytes ) {
+				break;
+			}
+
+			if( !filename.assign( m_dirname ) || !filename.tryAppendPath( Str( file.szName ) ) ) {
+				break;
+			}
+
+			if( fs_remove( filename ) ) {
+				cTotalBytes -= file.cBytes;
+			}
+		}
+
+		m_cBytes = cTotalBytes;
+	}
+
+}
@@ -5,9 +5,12 @@
 #include "doll/Gfx/Action.hpp"
 #include "doll/Gfx/Vertex.hpp"
 #include "doll/Gfx/Layer.hpp"
+#include "doll/Gfx/RenderStats.hpp"
 #include "doll/Gfx/API-GL.hpp"
 #include "doll/Math/Math.hpp"
 
+#include <stddef.h>
+
 // FIXME: GL shouldn't be necessary now that we have a renderer API
 #ifdef __APPLE__
 # include <OpenGL/OpenGL.h>
@@ -23,6 +26,163 @@ namespace doll
 
 	SSpriteTransform SSpriteTransform::identity;
 
+	/*
+	===============================================================================
+
+		SPRITE INSTANCER
+		Draws sprites as one record each over a shared quad, rather than six
+		vertices each
+
+	===============================================================================
+	*/
+
+	// Corners of a sprite's two triangles, in the order they're expanded in
+	// (bottom-left, top-left, top-right; bottom-left, top-right, bottom-right)
+	static const F32 kSpriteCorners[ 6*2 ] = {
+		0, 1,  0, 0,  1, 0,
+		0, 1,  1, 0,  1, 1
+	};
+
+	struct SSpriteInstance
+	{
+		// Snapped corners ( x1, y1, x2, y2 ) of the quad, and the texture
+		// coordinates at those two corners
+		F32 rect[ 4 ];
+		F32 texRect[ 4 ];
+		U32 diffuse;
+	};
+
+	class CSpriteInstancer
+	{
+	public:
+		CSpriteInstancer()
+		: m_layout( 0 )
+		, m_cornerVBuf( 0 )
+		, m_instanceVBuf( 0 )
+		, m_bRefused( false )
+		, m_uTexture( 0 )
+		, m_cPending( 0 )
+		{
+		}
+		~CSpriteInstancer()
+		{
+		}
+
+		// Whether the API takes the instanced layout; set up on first use, and
+		// only tried once per API
+		Bool init()
+		{
+			if( m_layout != 0 ) {
+				return true;
+			}
+			if( m_bRefused ) {
+				return false;
+			}
+
+			m_bRefused = true;
+
+			if( !( m_layout = gfx_r_createLayout( sizeof( kSpriteCorners[ 0 ] )*2, sizeof( SSpriteInstance ) ) ) ) {
+				return false;
+			}
+
+			gfx_r_layoutVertex( m_layout, kVectorSize2, kVectorTypeF32, 0, 0 );
+			gfx_r_layoutVertexRect( m_layout, kVectorTypeF32, offsetof( SSpriteInstance, rect ) );
+			gfx_r_layoutTexCoordRect( m_layout, kVectorTypeF32, offsetof( SSpriteInstance, texRect ) );
+			gfx_r_layoutColor( m_layout, kVectorSize4, kVectorTypeU8, offsetof( SSpriteInstance, diffuse ), 1 );
+
+			if( !gfx_r_finishLayout( m_layout ) ) {
+				release();
+				return false;
+			}
+
+			m_cornerVBuf = gfx_r_createVBuffer( sizeof( kSpriteCorners ), kSpriteCorners, kBufferPerfStatic, kBufferPurposeDraw );
+			m_instanceVBuf = gfx_r_createVBuffer( sizeof( m_pending ), nullptr, kBufferPerfStream, kBufferPurposeDraw );
+			if( !m_cornerVBuf || !m_instanceVBuf ) {
+				release();
+				return false;
+			}
+
+			m_bRefused = false;
+			return true;
+		}
+		// Let go of the layout and buffers before the API they belong to goes
+		Void fini()
+		{
+			release();
+			m_bRefused = false;
+		}
+
+		// Queue a sprite drawn with texture `uTexture`, which must already be
+		// bound; instances for another texture are drawn first
+		Void add( const SSpriteInstance &inst, UPtr uTexture )
+		{
+			if( m_uTexture != uTexture || m_cPending == kMaxInstances ) {
+				flush();
+			}
+
+			m_uTexture = uTexture;
+			m_pending[ m_cPending++ ] = inst;
+		}
+		// Texture of the queued instances
+		UPtr getTexture() const
+		{
+			return m_cPending > 0 ? m_uTexture : 0;
+		}
+
+		Void flush()
+		{
+			if( !m_cPending ) {
+				return;
+			}
+
+			if( gfx_r_writeVBuffer( m_instanceVBuf, 0, m_cPending*sizeof( SSpriteInstance ), m_pending ) ) {
+				gfx_r_setLayout( m_layout );
+				gfx_r_setVBuffer( m_cornerVBuf );
+				gfx_r_setInstanceBuffer( m_instanceVBuf );
+				gfx_r_drawInstanced( kTopologyTriangleList, 6, m_cPending );
+			}
+
+			m_cPending = 0;
+		}
+
+	private:
+		static const U32 kMaxInstances = 1024;
+
+		UPtr            m_layout;
+		UPtr            m_cornerVBuf;
+		UPtr            m_instanceVBuf;
+		Bool            m_bRefused;
+
+		UPtr            m_uTexture;
+		U32             m_cPending;
+		SSpriteInstance m_pending[ kMaxInstances ];
+
+		Void release()
+		{
+			m_cPending = 0;
+
+			// Nothing to do (and no frame to do it with) once released
+			if( m_instanceVBuf != 0 ) {
+				gfx_r_destroyVBuffer( m_instanceVBuf );
+				m_instanceVBuf = 0;
+			}
+			if( m_cornerVBuf != 0 ) {
+				gfx_r_destroyVBuffer( m_cornerVBuf );
+				m_cornerVBuf = 0;
+			}
+			if( m_layout != 0 ) {
+				gfx_r_destroyLayout( m_layout );
+				m_layout = 0;
+			}
+		}
+	};
+
+	static CSpriteInstancer &getSpriteInstancer()
+	{
+		static CSpriteInstancer instancer;
+		return instancer;
+	}
+
 	/*
 	===============================================================================
 
@@ -31,7 +191,8 @@ namespace doll
 	===============================================================================
 	*/
 	MSprites::MSprites()
-	: defaultSpriteGroup( nullptr )
+	: instancingEnabled( true )
+	, defaultSpriteGroup( nullptr )
 	{
 	}
 	MSprites::~MSprites()
@@ -55,6 +216,7 @@ namespace doll
 	}
 	Void MSprites::fini_gl()
 	{
+		getSpriteInstancer().fini();
 	}
 
 	Void MSprites::render_gl( CGfxFrame *pFrame )
@@ -75,7 +237,9 @@ namespace doll
 #endif
 
 		for( RSpriteGroup *group = mgr_spriteGroupList.head(); group != nullptr; group = group->mgr_spriteGroupLink.next() ) {
+			gfx_pushRenderStatsScope( nullptr, group );
 			group->render_gl( w, h );
+			gfx_popRenderStatsScope();
 		}
 	}
 
@@ -209,6 +373,9 @@ namespace doll
 		renderPrims.reset();
 		renderPrims.setPrimitiveType( kTopologyTriangleList );
 
+		CSpriteInstancer &instancer = getSpriteInstancer();
+		const Bool bInstancing = g_spriteMgr.isInstancingEnabled() && instancer.init();
+
 		SVertex2DSprite quad[ 4 ];
 
 		// render each sprite
@@ -284,7 +451,33 @@ namespace doll
 #define Q_BL 2
 #define Q_BR 3
 
-			const UPtr texh = texture->getBackingTexture();
+			const UPtr texh = texture->useBackingTexture();
+
+			// Quads still axis-aligned once snapped, in one color, are drawn as
+			// an instance; whatever was queued before either kind is drawn
+			// first, keeping the sprites in order
+			const Bool bInstance = bInstancing &&
+				d1 == d2 && d1 == d3 && d1 == d4 &&
+				tr.x == br.x && tr.y == tl.y && bl.x == tl.x && bl.y == br.y;
+
+			if( bInstance ) {
+				if( instancer.getTexture() != texh ) {
+					instancer.flush();
+				}
+
+				renderPrims.setTexture( texh );
+				renderPrims.submit();
+
+				const SSpriteInstance inst = {
+					{ tl.x, tl.y, br.x, br.y },
+					{ s1, t2, s2, t1 },
+					d1
+				};
+				instancer.add( inst, texh );
+				continue;
+			}
+
+			instancer.flush();
 			renderPrims.setTexture( texh );
 
 			SETQ( Q_TL, tl.x, tl.y, d3, s1, t2 );
@@ -325,6 +518,7 @@ namespace doll
 #endif
 		}
 
+		instancer.flush();
 		renderPrims.submit();
 	}
 	Void RSpriteGroup::update()
@@ -851,6 +1045,14 @@ namespace doll
 	{
 		return g_spriteMgr.getDefaultSpriteGroup();
 	}
+	DOLL_FUNC Void DOLL_API gfx_enableSpriteInstancing( Bool bEnable )
+	{
+		g_spriteMgr.setInstancingEnabled( bEnable );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isSpriteInstancingEnabled()
+	{
+		return g_spriteMgr.isInstancingEnabled();
+	}
 	DOLL_FUNC Void DOLL_API gfx_showSpriteGroup( RSpriteGroup *group )
 	{
 		if( !group ) {
@@ -2017,4 +2219,218 @@ namespace doll
 		return sprite->isVisible();
 	}
 
+	/*
+	===============================================================================
+
+		HANDLE-BASED API
+		Each call resolves its handle first and does nothing (returning the
+		default value) if the sprite has already been deleted
+
+	===============================================================================
+	*/
+
+#define RESOLVE_SPRITE( var, handle )\
+	RSprite *const var = RSprite::fromHandle( handle );\
+	if( !var )
+
+	DOLL_FUNC HSprite DOLL_API gfx_getSpriteHandle( const RSprite *sprite )
+	{
+		if( !sprite ) {
+			return HSprite();
+		}
+
+		return sprite->getHandle();
+	}
+	DOLL_FUNC RSprite *DOLL_API gfx_getSpriteFromHandle( HSprite sprite )
+	{
+		return RSprite::fromHandle( sprite );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isSpriteHandleValid( HSprite sprite )
+	{
+		return RSprite::getPool().isValid( sprite );
+	}
+	DOLL_FUNC U32 DOLL_API gfx_getLiveSpriteCount()
+	{
+		return RSprite::getPool().getLiveCount();
+	}
+
+	DOLL_FUNC HSprite DOLL_API gfx_newSpriteHandle()
+	{
+		return gfx_getSpriteHandle( gfx_newSprite() );
+	}
+	DOLL_FUNC HSprite DOLL_API gfx_newSpriteHandleInGroup( RSpriteGroup *group )
+	{
+		return gfx_getSpriteHandle( gfx_newSpriteInGroup( group ) );
+	}
+	DOLL_FUNC HSprite DOLL_API gfx_loadAnimSpriteHandle( HTexture texture, S32 cellResX, S32 cellResY, S32 startFrame, S32 numFrames, S32 offX, S32 offY, S32 padX, S32 padY )
+	{
+		const RTexture *const pTexture = RTexture::fromHandle( texture );
+		if( !AX_VERIFY_MSG( pTexture != nullptr, "Invalid texture handle" ) ) {
+			return HSprite();
+		}
+
+		return gfx_getSpriteHandle( gfx_loadAnimSprite( pTexture, cellResX, cellResY, startFrame, numFrames, offX, offY, padX, padY ) );
+	}
+	DOLL_FUNC HSprite DOLL_API gfx_deleteSpriteByHandle( HSprite sprite )
+	{
+		delete RSprite::fromHandle( sprite );
+		return HSprite();
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_moveSpriteByHandle( HSprite sprite, F32 x, F32 y )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->move( Vec2f( x, y ) );
+	}
+	DOLL_FUNC Void DOLL_API gfx_turnSpriteByHandle( HSprite sprite, F32 theta )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->turn( theta );
+	}
+	DOLL_FUNC Void DOLL_API gfx_setSpritePositionByHandle( HSprite sprite, F32 x, F32 y )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->setPosition( Vec2f( x, y ) );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_getSpritePositionByHandle( HSprite sprite, F32 *x, F32 *y )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return false;
+		}
+
+		return gfx_getSpritePosition( pSprite, x, y );
+	}
+	DOLL_FUNC Void DOLL_API gfx_setSpriteRotationByHandle( HSprite sprite, F32 angle )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->setRotation( angle );
+	}
+	DOLL_FUNC F32 DOLL_API gfx_getSpriteRotationByHandle( HSprite sprite )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return 0;
+		}
+
+		return pSprite->getRotation();
+	}
+	DOLL_FUNC Void DOLL_API gfx_setSpriteScaleByHandle( HSprite sprite, F32 x, F32 y )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->setScale( Vec2f( x, y ) );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_getSpriteScaleByHandle( HSprite sprite, F32 *x, F32 *y )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return false;
+		}
+
+		return gfx_getSpriteScale( pSprite, x, y );
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_setSpriteTextureByHandle( HSprite sprite, HTexture texture )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->setTexture( RTexture::fromHandle( texture ) );
+	}
+	DOLL_FUNC HTexture DOLL_API gfx_getSpriteTextureByHandle( HSprite sprite )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return HTexture();
+		}
+
+		return gfx_getTextureHandle( pSprite->getTexture() );
+	}
+	DOLL_FUNC Void DOLL_API gfx_setSpriteCurrentFrameByHandle( HSprite sprite, U32 frameIndex )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->setCurrentFrame( frameIndex );
+	}
+	DOLL_FUNC Void DOLL_API gfx_playSpriteAnimationByHandle( HSprite sprite, U32 beginFrame, U32 endFrame )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->playAnimation( beginFrame, endFrame, RSprite::EAnimationMode::PlayOnce );
+	}
+	DOLL_FUNC Void DOLL_API gfx_loopSpriteAnimationByHandle( HSprite sprite, U32 beginFrame, U32 endFrame )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->playAnimation( beginFrame, endFrame, RSprite::EAnimationMode::Repeat );
+	}
+	DOLL_FUNC Void DOLL_API gfx_stopSpriteAnimationByHandle( HSprite sprite )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->stopAnimation();
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_bindSpriteByHandle( HSprite sprite, HSprite master )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->bind( RSprite::fromHandle( master ) );
+	}
+	DOLL_FUNC Void DOLL_API gfx_unbindSpriteByHandle( HSprite sprite )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->bind( nullptr );
+	}
+	DOLL_FUNC HSprite DOLL_API gfx_getSpriteBindMasterByHandle( HSprite sprite )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return HSprite();
+		}
+
+		return gfx_getSpriteHandle( pSprite->getBindMaster() );
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_setSpriteVisibleByHandle( HSprite sprite, S32 visible )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return;
+		}
+
+		pSprite->setVisible( !!visible );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isSpriteVisibleByHandle( HSprite sprite )
+	{
+		RESOLVE_SPRITE( pSprite, sprite ) {
+			return false;
+		}
+
+		return pSprite->isVisible();
+	}
+
 }
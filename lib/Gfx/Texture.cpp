@@ -3,7 +3,9 @@
 
 #include "doll/Gfx/Texture.hpp"
 #include "doll/Gfx/API-GL.hpp"
+#include "doll/IO/AsyncIO.hpp"
 #include "doll/IO/File.hpp"
+#include "doll/IO/VFS.hpp"
 #include "doll/Core/Logger.hpp"
 #include "doll/Core/Memory.hpp"
 #include "doll/Core/MemoryTags.hpp"
@@ -256,6 +258,19 @@ namespace doll
 		U8 *data() const { AX_ASSERT_NOT_NULL( m_data ); return m_data; }
 	};
 
+	// swap the red and blue channels of a loaded image in place
+	static Void swapRedAndBlue( U8 *data, U32 width, U32 height, U32 channels )
+	{
+		for( U32 y=0; y<height; ++y ) {
+			for( U32 x=0; x<width; ++x ) {
+				U8 *const off = &data[ ( y*width + x )*channels ];
+				const U8 tmp = off[ 2 ];
+				off[ 2 ] = off[ 0 ];
+				off[ 0 ] = tmp;
+			}
+		}
+	}
+
 	LoadingTexture::ELoadResult LoadingTexture::loadPNG( const Str &filename, const TArr<U8> &data ) {
 		static const U32 kMaxPNGRes = 16384;
 		static const UPtr kPNGSigSize = 8;
@@ -828,6 +843,11 @@ namespace doll
 	, defAtlasRes(0)
 	, mgrAtlas_list()
 	, mgrTex_list()
+	, budgetBytes(0)
+	, residentBytes(0)
+	, uFrame(1)
+	, placeholder(0)
+	, reloads()
 	{
 		for( freeIds_sp=0; freeIds_sp<0xFFFF; ++freeIds_sp ) {
 			freeIds[ freeIds_sp ] = 0xFFFF - freeIds_sp;
@@ -882,13 +902,18 @@ namespace doll
 			atlasWasFound = true;
 			atlas = specificAtlas;
 
+			if( !AX_VERIFY_MSG( atlas->isResident() || atlas->restore(), "Failed to restore atlas" ) ) {
+				return nullptr;
+			}
+
 			tex = atlas->reserveTexture( width, height );
 			if( !AX_VERIFY_MSG( tex != nullptr, "Atlas can't fit texture" ) ) {
 				return nullptr;
 			}
 		} else {
 			for( atlas = mgrAtlas_list.head(); atlas != nullptr; atlas = atlas->mgrAtlas_link.next() ) {
-				if( atlas->getFormat() != format ) {
+				// don't bring an evicted atlas back just to fit this in
+				if( atlas->getFormat() != format || !atlas->isResident() ) {
 					continue;
 				}
 
@@ -953,6 +978,39 @@ namespace doll
 
 		return nullptr;
 	}
+	// make a new texture in a specific atlas, failing quietly if it's full
+	RTexture *MTextures::makeTextureInAtlas( U16 width, U16 height, const Void *data, ETextureFormat format, CTextureAtlas *atlas )
+	{
+		if( !AX_VERIFY_NOT_NULL( data ) || !AX_VERIFY_NOT_NULL( atlas ) ) {
+			return nullptr;
+		}
+		if( !AX_VERIFY_MSG( atlas->getFormat() == format, "Invalid format for atlas" ) ) {
+			return nullptr;
+		}
+		if( !atlas->isResident() && !atlas->restore() ) {
+			return nullptr;
+		}
+
+		RTexture *const tex = atlas->reserveTexture( width, height );
+		if( !tex ) {
+			return nullptr;
+		}
+
+#if DOLL_TEXTURE_MEMORY_ENABLED
+		const UPtr totalSize = width*height*gfx_getTexelByteSize( format );
+		if( !AX_VERIFY_MSG( tex->copyMemory( data, totalSize ), "Copy memory failed" ) || !AX_VERIFY_MSG( atlas->updateTextures( 1, &tex ), "Textures failed to update" ) ) {
+			delete tex;
+			return nullptr;
+		}
+#else
+		if( !atlas->updateTexture( tex, format, data ) ) {
+			delete tex;
+			return nullptr;
+		}
+#endif
+
+		return tex;
+	}
 	// load up a new texture
 	RTexture *MTextures::loadTexture( Str filename, CTextureAtlas *specificAtlas )
 	{
@@ -988,18 +1046,17 @@ namespace doll
 		U8 *const data = loading.data();
 
 		// swap colors then copy the memory over
-		for( U32 y=0; y<height; ++y ) {
-			for( U32 x=0; x<width; ++x ) {
-				U8 *const off = &data[ ( y*width + x )*channels ];
-				const U8 tmp = off[ 2 ];
-				off[ 2 ] = off[ 0 ];
-				off[ 0 ] = tmp;
-			}
-		}
+		swapRedAndBlue( data, width, height, channels );
 
 		// load the image as an actual texture
 		RTexture *const tex = makeTexture( width, height, ( Void * )data, format, specificAtlas );
 
+		// remember the file so the texture can be reloaded if its atlas gets
+		// evicted (without it the atlas just stays resident)
+		if( tex != nullptr ) {
+			tex->source.tryAssign( filename );
+		}
+
 		// done
 		return tex;
 	}
@@ -1019,6 +1076,9 @@ namespace doll
 			return nullptr;
 		}
 
+		// make room for the new atlas
+		trim();
+
 		return atlas;
 	}
 	// retrieve the texture handle from the identifier given
@@ -1056,6 +1116,199 @@ namespace doll
 		pushFreeTextureId( textureId );
 	}
 
+	// set the residency budget
+	Void MTextures::setBudget( U64 cBytes )
+	{
+		budgetBytes = cBytes;
+		trim();
+	}
+	// evict the least recently drawn atlases until within the budget
+	//
+	// atlases drawn from this frame are kept, so going over the budget within
+	// one frame only defers the eviction
+	Void MTextures::trim()
+	{
+		if( !budgetBytes ) {
+			return;
+		}
+
+		while( residentBytes > budgetBytes ) {
+			CTextureAtlas *oldest = nullptr;
+
+			for( CTextureAtlas *atlas = mgrAtlas_list.head(); atlas != nullptr; atlas = atlas->mgrAtlas_link.next() ) {
+				if( !atlas->isResident() || atlas->uLastUseFrame >= uFrame || atlas->cPendingReloads > 0 ) {
+					continue;
+				}
+				if( oldest != nullptr && oldest->uLastUseFrame <= atlas->uLastUseFrame ) {
+					continue;
+				}
+				if( !atlas->isEvictable() ) {
+					continue;
+				}
+
+				oldest = atlas;
+			}
+
+			if( !oldest ) {
+				break;
+			}
+
+			oldest->evict();
+		}
+	}
+	// retrieve the texture drawn in place of atlases being reloaded
+	UPtr MTextures::getPlaceholder()
+	{
+		// transparent, so images that aren't back yet just don't show
+		static const U8 texel[ 4 ] = { 0, 0, 0, 0 };
+
+		if( !placeholder ) {
+			placeholder = gfx_r_createTexture( kTexFmtRGBA8, 1, 1, texel );
+		}
+
+		return placeholder;
+	}
+	// mark an atlas as used this frame, retrieving the texture to draw with
+	UPtr MTextures::useAtlas( CTextureAtlas *atlas )
+	{
+		AX_ASSERT_NOT_NULL( atlas );
+
+		atlas->uLastUseFrame = uFrame;
+
+		if( !atlas->isResident() && !atlas->restore() ) {
+			return getPlaceholder();
+		}
+		if( atlas->cPendingReloads > 0 ) {
+			return getPlaceholder();
+		}
+
+		return atlas->texture;
+	}
+
+	// start reading a texture's file back in
+	Bool MTextures::startReload( RTexture *tex )
+	{
+		AX_ASSERT_NOT_NULL( tex );
+		AX_ASSERT_NOT_NULL( tex->atlas );
+
+		if( tex->source.isEmpty() ) {
+			return false;
+		}
+
+		IFile *const pFile = fs_open( tex->source, kFileOpenF_R | kFileOpenF_Sequential );
+		if( !pFile ) {
+			return false;
+		}
+
+		CAsyncOp *const pOp = async_readFile( pFile, tex->source );
+		if( !pOp ) {
+			fs_close( pFile );
+			return false;
+		}
+
+		SReload reload;
+		reload.pTexture = tex;
+		reload.pFile    = pFile;
+		reload.pOp      = pOp;
+
+		if( !AX_VERIFY_MEMORY( reloads.append( reload ) ) ) {
+			async_close( pOp );
+			fs_close( pFile );
+			return false;
+		}
+
+		++tex->atlas->cPendingReloads;
+		return true;
+	}
+	// stop reading a texture's file back in (if it is)
+	Void MTextures::cancelReload( RTexture *tex )
+	{
+		for( UPtr i = 0; i < reloads.num(); ++i ) {
+			SReload &reload = reloads[ i ];
+			if( reload.pTexture != tex ) {
+				continue;
+			}
+
+			async_close( reload.pOp );
+			fs_close( reload.pFile );
+			--tex->atlas->cPendingReloads;
+
+			reload = reloads[ reloads.num() - 1 ];
+			reloads.removeLast();
+			return;
+		}
+	}
+	// decode a texture that was read back in and upload it to its atlas
+	Bool MTextures::finishReload( RTexture *tex, CAsyncOp *pOp )
+	{
+		LoadingTexture loading;
+
+		const TArr<U8> data( ( const U8 * )async_getPtr( pOp ), async_tell( pOp ) );
+		if( !loading.load( tex->source, data ) ) {
+			g_WarningLog( tex->source ) += "Failed to reload image.";
+			return false;
+		}
+
+		const SPixelVec2 res = tex->getResolution();
+		if( loading.res_x() != res.x || loading.res_y() != res.y ) {
+			g_WarningLog( tex->source ) += "Image changed size since it was loaded; not reloading it.";
+			return false;
+		}
+
+		swapRedAndBlue( loading.data(), loading.res_x(), loading.res_y(), loading.channels() );
+
+		const SPixelRect rc = tex->getAtlasRectangle();
+		gfx_r_updateTexture( tex->atlas->texture, tex->atlas->getFormat(), rc.off.x, rc.off.y, res.x, res.y, loading.data() );
+
+		return true;
+	}
+
+	// finish reloads and evict atlases over the budget
+	Void MTextures::endFrame()
+	{
+		UPtr i = 0;
+		while( i < reloads.num() ) {
+			const SReload reload = reloads[ i ];
+
+			const EAsyncStatus status = async_status( reload.pOp );
+			if( status == EAsyncStatus::Pending ) {
+				++i;
+				continue;
+			}
+
+			// a failed reload leaves that part of the atlas blank rather than
+			// holding the rest of it back
+			if( status != EAsyncStatus::Success ) {
+				g_WarningLog( reload.pTexture->source ) += "Failed to read image back in.";
+			} else {
+				finishReload( reload.pTexture, reload.pOp );
+			}
+
+			async_close( reload.pOp );
+			fs_close( reload.pFile );
+			--reload.pTexture->atlas->cPendingReloads;
+
+			reloads[ i ] = reloads[ reloads.num() - 1 ];
+			reloads.removeLast();
+		}
+
+		trim();
+		++uFrame;
+	}
+	// cancel the reloads and destroy the placeholder
+	Void MTextures::fini()
+	{
+		while( reloads.isUsed() ) {
+			cancelReload( reloads[ 0 ].pTexture );
+		}
+		reloads.purge();
+
+		if( placeholder != 0 ) {
+			gfx_r_destroyTexture( placeholder );
+			placeholder = 0;
+		}
+	}
+
 	/*
 	===============================================================================
 
@@ -1070,6 +1323,9 @@ namespace doll
 	, texture( 0 )
 	, resolution()
 	, format( kTexFmtRGBA8 )
+	, bEvicted( false )
+	, uLastUseFrame( 0 )
+	, cPendingReloads( 0 )
 	, allocator()
 	, atlas_list()
 	{
@@ -1107,13 +1363,17 @@ namespace doll
 		// set the format
 		format = fmt;
 
+		// count it as used now so it isn't evicted before it's drawn from
+		uLastUseFrame = g_textureMgr.uFrame;
+		g_textureMgr.residentBytes += getByteCount();
+
 		// done
 		return true;
 	}
 	// finish the atlas
 	Void CTextureAtlas::fini()
 	{
-		if( !texture ) {
+		if( !texture && !bEvicted ) {
 			return;
 		}
 
@@ -1128,8 +1388,77 @@ namespace doll
 		}
 		allocator.fini();
 
+		if( texture != 0 ) {
+			g_textureMgr.residentBytes -= getByteCount();
+
+			gfx_r_destroyTexture( texture );
+			texture = 0;
+		}
+
+		bEvicted = false;
+	}
+
+	// check whether the textures in this atlas can all be brought back
+	Bool CTextureAtlas::isEvictable()
+	{
+		for( RTexture *tex = atlas_list.head(); tex != nullptr; tex = tex->atlas_link.next() ) {
+#if DOLL_TEXTURE_MEMORY_ENABLED
+			if( tex->getMemoryPointer() != nullptr ) {
+				continue;
+			}
+#endif
+			if( tex->source.isEmpty() ) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+	// destroy the backing texture
+	Void CTextureAtlas::evict()
+	{
+		AX_ASSERT_MSG( texture != 0, "Atlas not resident" );
+		AX_ASSERT_MSG( cPendingReloads == 0, "Atlas still reloading" );
+
+		DOLL_DEBUG_LOG += axf( "Evicting %ux%u texture atlas (%u KiB)", resolution.x, resolution.y, U32( getByteCount()/1024 ) );
+
+		g_textureMgr.residentBytes -= getByteCount();
+
 		gfx_r_destroyTexture( texture );
 		texture = 0;
+		bEvicted = true;
+	}
+	// recreate the backing texture and bring its textures back
+	Bool CTextureAtlas::restore()
+	{
+		if( texture != 0 ) {
+			return true;
+		}
+
+		AX_ASSERT_MSG( bEvicted, "Atlas not initialized" );
+
+		texture = gfx_r_createTexture( format, resolution.x, resolution.y, nullptr );
+		if( !texture ) {
+			return false;
+		}
+
+		bEvicted = false;
+		uLastUseFrame = g_textureMgr.uFrame;
+		g_textureMgr.residentBytes += getByteCount();
+
+		for( RTexture *tex = atlas_list.head(); tex != nullptr; tex = tex->atlas_link.next() ) {
+#if DOLL_TEXTURE_MEMORY_ENABLED
+			if( tex->getMemoryPointer() != nullptr ) {
+				updateTextures( 1, &tex );
+				continue;
+			}
+#endif
+			if( !g_textureMgr.startReload( tex ) ) {
+				g_WarningLog( tex->source ) += "Cannot reload image.";
+			}
+		}
+
+		return true;
 	}
 
 #if DOLL_TEXTURE_MEMORY_ENABLED
@@ -1154,7 +1483,7 @@ namespace doll
 			const SPixelRect srcRect = src->getAtlasRectangle();
 			const SPixelVec2 srcRes = src->getResolution();
 
-			gfx_r_updateTexture( texture, srcRect.off.x, srcRect.off.y, srcRes.x, srcRes.y, mem );
+			gfx_r_updateTexture( texture, format, srcRect.off.x, srcRect.off.y, srcRes.x, srcRes.y, mem );
 		}
 
 		return true;
@@ -1170,7 +1499,7 @@ namespace doll
 		const SPixelVec2 sz = tex->getResolution();
 
 		( void )fmt;
-		gfx_r_updateTexture( texture, rc.off.x, rc.off.y, sz.x, sz.y, ( const U8 * )data );
+		gfx_r_updateTexture( texture, format, rc.off.x, rc.off.y, sz.x, sz.y, ( const U8 * )data );
 
 		return true;
 	}
@@ -1193,6 +1522,7 @@ namespace doll
 
 		Void *const texNode = allocator.allocateId( texRect, texId, texRes );
 		if( !texNode ) {
+			g_textureMgr.pushFreeTextureId( texId );
 			return nullptr;
 		}
 
@@ -1302,6 +1632,8 @@ namespace doll
 
 		AX_ASSERT_MSG( allocNode!=nullptr, "Invalid texture object" );
 
+		g_textureMgr.cancelReload( this );
+
 #if DOLL_TEXTURE_MEMORY_ENABLED
 		delete [] memory;
 		memory = nullptr;
@@ -1323,6 +1655,17 @@ namespace doll
 		texRect.res.y = 0;
 
 		name.purge();
+		source.purge();
+	}
+
+	// retrieve the texture to draw with, marking the atlas as used
+	UPtr RTexture::useBackingTexture() const
+	{
+		if( !atlas ) {
+			return 0;
+		}
+
+		return g_textureMgr.useAtlas( atlas );
 	}
 
 
@@ -1380,4 +1723,63 @@ namespace doll
 		return ( U32 )texture->getResolution().y;
 	}
 
+
+	DOLL_FUNC HTexture DOLL_API gfx_getTextureHandle( const RTexture *texture )
+	{
+		if( !texture ) {
+			return HTexture();
+		}
+
+		return texture->getHandle();
+	}
+	DOLL_FUNC RTexture *DOLL_API gfx_getTextureFromHandle( HTexture texture )
+	{
+		return RTexture::fromHandle( texture );
+	}
+	DOLL_FUNC Bool DOLL_API gfx_isTextureHandleValid( HTexture texture )
+	{
+		return RTexture::getPool().isValid( texture );
+	}
+	DOLL_FUNC U32 DOLL_API gfx_getLiveTextureCount()
+	{
+		return RTexture::getPool().getLiveCount();
+	}
+
+	DOLL_FUNC HTexture DOLL_API gfx_newTextureHandle( U16 width, U16 height, const void *data, ETextureFormat format )
+	{
+		return gfx_getTextureHandle( gfx_newTexture( width, height, data, format ) );
+	}
+	DOLL_FUNC HTexture DOLL_API gfx_loadTextureHandle( Str filename )
+	{
+		return gfx_getTextureHandle( gfx_loadTexture( filename ) );
+	}
+	DOLL_FUNC HTexture DOLL_API gfx_deleteTextureByHandle( HTexture texture )
+	{
+		delete RTexture::fromHandle( texture );
+		return HTexture();
+	}
+	DOLL_FUNC U32 DOLL_API gfx_getTextureResXByHandle( HTexture texture )
+	{
+		const RTexture *const pTexture = RTexture::fromHandle( texture );
+		return pTexture != nullptr ? ( U32 )pTexture->getResolution().x : 0;
+	}
+	DOLL_FUNC U32 DOLL_API gfx_getTextureResYByHandle( HTexture texture )
+	{
+		const RTexture *const pTexture = RTexture::fromHandle( texture );
+		return pTexture != nullptr ? ( U32 )pTexture->getResolution().y : 0;
+	}
+
+	DOLL_FUNC Void DOLL_API gfx_setTextureBudget( U64 cBytes )
+	{
+		g_textureMgr.setBudget( cBytes );
+	}
+	DOLL_FUNC U64 DOLL_API gfx_getTextureBudget()
+	{
+		return g_textureMgr.getBudget();
+	}
+	DOLL_FUNC U64 DOLL_API gfx_getResidentTextureBytes()
+	{
+		return g_textureMgr.getResidentBytes();
+	}
+
 }
@@ -1070,6 +1070,44 @@ namespace doll
 		// Done
 		return true;
 	}
+	DOLL_FUNC Bool DOLL_API sysfs_remove( const Str &filename )
+	{
+#ifdef _WIN32
+		wchar_t wszName[ kMaxPath*2 ];
+		if( !win32path( wszName, filename, EWin32Path::File ) ) {
+			return false;
+		}
+		wszName[ kMaxPath*2 - 1 ] = L'\0';
+
+		return DeleteFileW( wszName ) != FALSE;
+#else
+		char szPath[ kMaxPath ];
+		if( !unixpath( szPath, filename ) ) {
+			return false;
+		}
+
+		return ::unlink( szPath ) == 0;
+#endif
+	}
+	DOLL_FUNC Bool DOLL_API sysfs_rmdir( const Str &dir )
+	{
+#ifdef _WIN32
+		wchar_t wszName[ kMaxPath*2 ];
+		if( !win32path( wszName, dir, EWin32Path::File ) ) {
+			return false;
+		}
+		wszName[ kMaxPath*2 - 1 ] = L'\0';
+
+		return RemoveDirectoryW( wszName ) != FALSE;
+#else
+		char szPath[ kMaxPath ];
+		if( !unixpath( szPath, dir ) ) {
+			return false;
+		}
+
+		return ::rmdir( szPath ) == 0;
+#endif
+	}
 
 #ifdef _WIN32
 	template< int tCSIDL >
@@ -190,6 +190,14 @@ namespace doll
 	{
 		return sysfs_stat( dstStat, filename );
 	}
+	Bool CFileProvider_Sysfs::remove( const Str &filename )
+	{
+		return sysfs_remove( filename );
+	}
+	Bool CFileProvider_Sysfs::mkdir( const Str &dirname )
+	{
+		return sysfs_mkdir( dirname );
+	}
 
 	CFileProvider_Sysfs &CFileProvider_Sysfs::get()
 	{
@@ -393,4 +393,68 @@ namespace doll
 		return fs_filteredStat( TArr<IFileProvider*>(pFSProviders,cFSProviders), name, dstStat );
 	}
 
+	DOLL_FUNC Bool DOLL_API fs_filteredRemove( const TArr<IFileProvider *> &providers, const Str &filename )
+	{
+		for( IFileProvider *pFSProvider : providers ) {
+			AX_ASSERT_NOT_NULL( pFSProvider );
+
+			if( pFSProvider->remove( filename ) ) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+	DOLL_FUNC Bool DOLL_API fs_remove( const Str &filename )
+	{
+		Str prefix, name;
+		fs_getPrefixAndName( filename, prefix, name );
+
+		if( name.isEmpty() ) {
+			g_ErrorLog( filename ) += "Cannot remove file; invalid filename.";
+			return false;
+		}
+
+		IFileProvider *pFSProviders[ 64 ];
+		const UPtr cFSProviders = fs_findFileProviders( pFSProviders, arraySize( pFSProviders ), prefix );
+		if( !cFSProviders ) {
+			g_ErrorLog( filename ) += "Cannot remove file; no providers available.";
+			return false;
+		}
+
+		return fs_filteredRemove( TArr<IFileProvider*>(pFSProviders,cFSProviders), name );
+	}
+
+	DOLL_FUNC Bool DOLL_API fs_filteredMkdir( const TArr<IFileProvider *> &providers, const Str &dirname )
+	{
+		for( IFileProvider *pFSProvider : providers ) {
+			AX_ASSERT_NOT_NULL( pFSProvider );
+
+			if( pFSProvider->mkdir( dirname ) ) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+	DOLL_FUNC Bool DOLL_API fs_mkdir( const Str &dirname )
+	{
+		Str prefix, name;
+		fs_getPrefixAndName( dirname, prefix, name );
+
+		if( name.isEmpty() ) {
+			g_ErrorLog( dirname ) += "Cannot create directory; invalid name.";
+			return false;
+		}
+
+		IFileProvider *pFSProviders[ 64 ];
+		const UPtr cFSProviders = fs_findFileProviders( pFSProviders, arraySize( pFSProviders ), prefix );
+		if( !cFSProviders ) {
+			g_ErrorLog( dirname ) += "Cannot create directory; no providers available.";
+			return false;
+		}
+
+		return fs_filteredMkdir( TArr<IFileProvider*>(pFSProviders,cFSProviders), name );
+	}
+
 }
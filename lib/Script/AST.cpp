@@ -1,3 +1,145 @@
 #include "../BuildSettings.hpp"
 #include "doll/Script/AST.hpp"
 
+namespace doll { namespace script {
+
+CSyntaxTree::CSyntaxTree()
+: m_nodes()
+, m_tokens()
+{
+}
+CSyntaxTree::~CSyntaxTree()
+{
+}
+
+Void CSyntaxTree::clear()
+{
+	m_nodes.clear();
+	m_tokens.clear();
+}
+Bool CSyntaxTree::reserve( UPtr cNodes )
+{
+	if( !AX_VERIFY_MEMORY( m_nodes.reserve( cNodes ) ) ) {
+		return false;
+	}
+	if( !AX_VERIFY_MEMORY( m_tokens.reserve( cNodes ) ) ) {
+		return false;
+	}
+
+	return true;
+}
+
+U32 CSyntaxTree::addNode( ESyntaxKind kind, const SToken &tok, U8 uFlags )
+{
+	AX_ASSERT( m_nodes.num() == m_tokens.num() );
+
+	// Indexes must fit in U32 (with 0 reserved for the root)
+	if( m_nodes.num() >= UPtr( ~U32( 0 ) ) ) {
+		return 0;
+	}
+
+	SSyntaxNode node;
+	node.kind         = kind;
+	node.uFlags       = uFlags;
+	node.cChildren    = 0;
+	node.uFirstChild  = 0;
+	node.uNextSibling = 0;
+
+	if( !AX_VERIFY_MEMORY( m_nodes.append( node ) ) ) {
+		return 0;
+	}
+	if( !AX_VERIFY_MEMORY( m_tokens.append( tok ) ) ) {
+		m_nodes.resize( m_tokens.num() );
+		return 0;
+	}
+
+	return U32( m_nodes.num() - 1 );
+}
+Void CSyntaxTree::appendChild( U32 uParent, U32 &uLastChild, U32 uChild )
+{
+	AX_ASSERT( uParent < m_nodes.num() );
+	AX_ASSERT( uChild != kRoot && uChild < m_nodes.num() );
+	AX_ASSERT( m_nodes[ uChild ].uNextSibling == 0 );
+
+	SSyntaxNode &parent = m_nodes[ uParent ];
+
+	if( uLastChild != 0 ) {
+		AX_ASSERT( m_nodes[ uLastChild ].uNextSibling == 0 );
+		m_nodes[ uLastChild ].uNextSibling = uChild;
+	} else {
+		AX_ASSERT( parent.uFirstChild == 0 );
+		parent.uFirstChild = uChild;
+	}
+
+	if( parent.cChildren != 0xFFFF ) {
+		++parent.cChildren;
+	}
+
+	uLastChild = uChild;
+}
+
+U32 CSyntaxTree::getChild( U32 uIndex, U32 uNth ) const
+{
+	U32 uChild = getFirstChild( uIndex );
+	while( uChild != 0 && uNth > 0 ) {
+		uChild = getNextSibling( uChild );
+		--uNth;
+	}
+
+	return uChild;
+}
+
+UPtr CSyntaxTree::getMemoryUsage() const
+{
+	return m_nodes.num()*sizeof( SSyntaxNode ) + m_tokens.num()*sizeof( SToken );
+}
+
+Str scr_syntaxKindToString( ESyntaxKind kind )
+{
+	static const Str names[] = {
+		"Error",
+
+		"Program",
+		"Block",
+		"ExprStmt",
+		"VarDecl",
+		"FuncDecl",
+		"Param",
+		"TypeDecl",
+		"If",
+		"While",
+		"DoWhile",
+		"Loop",
+		"ForIn",
+		"Switch",
+		"Case",
+		"Menu",
+		"MenuChoice",
+		"Return",
+		"Break",
+		"Continue",
+		"Defer",
+		"Goto",
+		"Label",
+		"Dialogue",
+		"MultiMessage",
+
+		"Name",
+		"Number",
+		"String",
+		"Constant",
+		"DialogueToken",
+		"Unary",
+		"Binary",
+		"Conditional",
+		"Call",
+		"Index",
+		"Member",
+		"ArrayLiteral"
+	};
+	static_assert( sizeof( names )/sizeof( names[ 0 ] ) == kNumSyntaxKinds, "Missing syntax kind name" );
+
+	return U32( kind ) < U32( kNumSyntaxKinds ) ? names[ kind ] : Str( "(invalid)" );
+}
+
+}}
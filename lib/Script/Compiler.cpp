@@ -4,26 +4,37 @@
 #include "doll/Script/LanguageVersion.hpp"
 #include "doll/Script/Type.hpp"
 #include "doll/Script/Ident.hpp"
+#include "doll/Script/TokenCache.hpp"
 
 #include "doll/Core/Logger.hpp"
+#include "doll/IO/SysFS.hpp"
 
 namespace doll { namespace script {
 
 	CCompilerContext::CCompilerContext()
-	: m_pSources()
+	: m_arena()
+	, m_version( kVer_1_0 )
+	, m_pSources()
 	, m_srcStack()
 	, m_srcQueue()
 	, m_diagEngine( m_pSources )
 	, m_progData()
 	, m_symDict()
+	, m_tokenCacheDir()
 	{
 	}
 	CCompilerContext::~CCompilerContext()
 	{
+		// Sources own their buffers, so they're destroyed properly; their
+		// memory (and every other object's) goes with the arena
+		for( Source *&pSrc : m_pSources ) {
+			pSrc = freeSource( pSrc );
+		}
 	}
 
 	Bool CCompilerContext::init( EVersion ver )
 	{
+		m_version = ver;
 
 		// Initialize the dictionary system (efficient symbol look-up)
 		if( !initCompilerDictionary( *this, m_symDict, ver ) ) {
@@ -157,6 +168,10 @@ namespace doll { namespace script {
 
 		return m_pSources[ srcIdx ];
 	}
+	CCompilerArena &CCompilerContext::getArena()
+	{
+		return m_arena;
+	}
 	CDiagnosticEngine &CCompilerContext::getDiagnosticEngine()
 	{
 		return m_diagEngine;
@@ -519,6 +534,555 @@ namespace doll { namespace script {
 		return true;
 	}
 
+	namespace detail
+	{
+
+		// Default number of threads for lexSources()
+		static const U32 kDefaultLexThreads = 4;
+		// Most threads lexSources() will use
+		static const U32 kMaxLexThreads = 16;
+		// Tokens between saved lexer states (see `Source::lexStates`)
+		static const U32 kLexStateInterval = 256;
+		// editSource() won't restart from a state this close to the edit, as
+		// the lexer may have looked a little past the state's next token
+		static const U32 kLexEditSlack = 8;
+
+		// State for lexing one source without touching the context's tables
+		struct SLexJob
+		{
+			Source &          src;
+			EVersion          ver;
+			// Token cache directory (empty if disabled)
+			Str               cacheDir;
+
+			// Identifiers made while lexing (released once merged)
+			CCompilerArena    arena;
+			IdentDictionary   dict;
+			CProgramData      progData;
+			CDiagnosticEngine diagEngine;
+
+			Bool              bSuccess;
+			// Tokens came from the cache rather than the lexer
+			Bool              bFromCache;
+
+			SLexJob( Source &src, EVersion ver, const Str &cacheDir, const TMutArr<Source *> &pSources )
+			: src( src )
+			, ver( ver )
+			, cacheDir( cacheDir )
+			, arena()
+			, dict()
+			, progData()
+			, diagEngine( pSources )
+			, bSuccess( false )
+			, bFromCache( false )
+			{
+				diagEngine.enableDeferred();
+			}
+		};
+
+		// Jobs assigned to one thread
+		struct SLexWorker
+		{
+			TMutArr<SLexJob *> pJobs;
+			UPtr               cBytes = 0;
+			axthread_t         thread = AXTHREAD_INITIALIZER;
+			Bool               bStarted = false;
+		};
+
+		static Bool isSameToken( const SToken &a, const SToken &b )
+		{
+			return
+				a.getType() == b.getType() && a.getFlags() == b.getFlags() &&
+				a.getOffset() == b.getOffset() && a.getLength() == b.getLength();
+		}
+
+		// Save where `lexer` is to `dst` (not saved, but not an error, if the
+		// lexer has tokens pushed back)
+		static Bool appendLexState( TMutArr<SLexerState> &dst, const CLexer &lexer, U32 uToken )
+		{
+			SLexerState state;
+			if( !lexer.saveState( state, uToken ) ) {
+				return true;
+			}
+
+			return AX_VERIFY_MEMORY( dst.append( state ) );
+		}
+
+		// Runs on a worker thread; must only touch the job's own state
+		static Void runLexJob( SLexJob &job )
+		{
+			Source &src = job.src;
+
+			src.lexStates.clear();
+
+			if( !initCompilerDictionary( src.getContext(), job.arena, job.dict, job.ver ) ) {
+				return;
+			}
+
+			// Reuse the last run's tokens if the source hasn't changed since
+			switch( loadTokenCache( job.cacheDir, src, job.ver, job.arena, job.dict, job.progData ) ) {
+			case ETokenCacheResult::Hit:
+				job.bFromCache = true;
+				job.bSuccess = src.calcLineStarts();
+				return;
+
+			case ETokenCacheResult::Miss:
+				break;
+
+			case ETokenCacheResult::Failed:
+				src.tokens.clear();
+				return;
+			}
+
+			CLexer lexer( src, job.diagEngine, job.dict, job.progData, job.arena );
+
+			src.tokens.clear();
+
+			// The lexer has already read the first token
+			if( !appendLexState( src.lexStates, lexer, 0 ) ) {
+				return;
+			}
+
+			SToken tok;
+			for(;;) {
+				const UPtr cDiags = job.diagEngine.numDeferred();
+
+				if( !lexer.lex( tok ) ) {
+					break;
+				}
+
+				// A lexer error can leave the lexer on the same token
+				if( src.tokens.isUsed() && isSameToken( tok, src.tokens.last() ) && job.diagEngine.numDeferred() > cDiags ) {
+					break;
+				}
+
+				if( !AX_VERIFY_MEMORY( src.tokens.append( tok ) ) ) {
+					return;
+				}
+
+				if( src.tokens.num() % kLexStateInterval == 0 && !appendLexState( src.lexStates, lexer, U32( src.tokens.num() ) ) ) {
+					return;
+				}
+			}
+
+			// Keep the end-of-file token too, so its location is available
+			lexer.peek( tok );
+			if( !AX_VERIFY_MEMORY( src.tokens.append( tok ) ) ) {
+				return;
+			}
+
+			// Build the line table here too, rather than on the first
+			// diagnostic reported from the main thread
+			src.calcLineStarts();
+
+			job.bSuccess = true;
+		}
+
+		static int AXTHREAD_CALL lexWorker_f( axthread_t *, Void *pParm )
+		{
+			SLexWorker &worker = *reinterpret_cast< SLexWorker * >( pParm );
+
+			for( SLexJob *pJob : worker.pJobs ) {
+				runLexJob( *pJob );
+			}
+
+			return EXIT_SUCCESS;
+		}
+
+		// Runs on the calling thread, one job at a time in source order
+		static Bool mergeLexJob( CCompilerContext &ctx, SLexJob &job )
+		{
+			Source &src = job.src;
+
+			// Only clean sources are cached, so warnings show up every run
+			const Bool bSaveCache =
+				job.bSuccess && !job.bFromCache && job.cacheDir.isUsed() &&
+				job.diagEngine.numDeferred() == 0;
+
+			job.diagEngine.flushDeferred( ctx.getDiagnosticEngine() );
+
+			if( !job.bSuccess ) {
+				src.tokens.purge();
+				src.lexStates.purge();
+				return false;
+			}
+
+			CProgramData &progData = ctx.getProgramData();
+			for( UPtr i = 0; i < job.progData.getStringCount(); ++i ) {
+				if( !AX_VERIFY_MEMORY( progData.addString( job.progData.getString( i ) ) ) ) {
+					src.tokens.purge();
+					return false;
+				}
+			}
+
+			// Saved before the tokens are remapped, while they still only
+			// refer to identifiers named from this source
+			if( bSaveCache && !saveTokenCache( job.cacheDir, src, job.ver, job.progData ) ) {
+				g_DebugLog( src.filename ) += "Could not save token cache";
+			}
+
+			IdentDictionary &symDict = ctx.getSymbolMap();
+			for( SToken &tok : src.tokens ) {
+				if( !tok.hasIdent() || !tok.value.p ) {
+					continue;
+				}
+
+				Ident *const pLocal = tok.value.p;
+				if( !pLocal->pMerged ) {
+					IdentDictionary::SEntry *const pEntry = symDict.lookup( pLocal->name );
+					if( !AX_VERIFY_MEMORY( pEntry ) ) {
+						src.tokens.purge();
+						return false;
+					}
+
+					if( !pEntry->pData ) {
+						Ident *const pIdent = DOLL__SCRIPTOBJ_NEW( ctx ) Ident( ctx );
+						if( !AX_VERIFY_MEMORY( pIdent ) ) {
+							src.tokens.purge();
+							return false;
+						}
+
+						// The job's arena is released after merging
+						if( !AX_VERIFY_MEMORY( ( pIdent->name = ctx.getArena().copyStr( pLocal->name ) ).isUsed() ) ) {
+							src.tokens.purge();
+							return false;
+						}
+						pIdent->isKeyword = pLocal->isKeyword;
+						pIdent->keyword   = pLocal->keyword;
+
+						pEntry->pData = pIdent;
+					}
+
+					pLocal->pMerged = pEntry->pData;
+				}
+
+				tok.value.p = pLocal->pMerged;
+			}
+
+			// Each saved state's next token is a copy of one remapped above
+			for( SLexerState &state : src.lexStates ) {
+				if( state.uToken < src.tokens.num() ) {
+					state.nextToken.value = src.tokens[ state.uToken ].value;
+				}
+			}
+
+			src.isFromTokenCache = job.bFromCache;
+			src.isLexed = true;
+			return true;
+		}
+
+		// Lex `src` again after an edit, from where `lexer` is (at token
+		// `uFirstToken`, before the edit) until the lexer lines up with a
+		// state saved after the edit, and splice the new tokens in. The
+		// edit ended at `uNewEditEnd` and moved what follows by `iDelta`
+		static Bool relexEdit( Source &src, CLexer &lexer, U32 uFirstToken, U32 uNewEditEnd, S32 iDelta )
+		{
+			const S64 iOldEditEnd = S64( uNewEditEnd ) - iDelta;
+
+			TMutArr<SToken>      newTokens;
+			TMutArr<SLexerState> newStates;
+
+			if( !appendLexState( newStates, lexer, uFirstToken ) ) {
+				return false;
+			}
+
+			// Only states whose next token is past the edit can be lined up with
+			UPtr iOldState = 0;
+			while( iOldState < src.lexStates.num() && S64( src.lexStates[ iOldState ].nextToken.getOffset() ) < iOldEditEnd ) {
+				++iOldState;
+			}
+
+			// Index of the first old token to keep after the new ones
+			UPtr uResyncToken = ~UPtr( 0 );
+
+			SToken tok, next;
+			while( lexer.lex( tok ) ) {
+				// A lexer error can leave the lexer on the same token
+				if( newTokens.isUsed() && isSameToken( tok, newTokens.last() ) ) {
+					break;
+				}
+
+				if( !AX_VERIFY_MEMORY( newTokens.append( tok ) ) ) {
+					return false;
+				}
+
+				const U32 uToken = uFirstToken + U32( newTokens.num() );
+
+				lexer.peek( next );
+				const S64 iNext = S64( next.getOffset() );
+
+				while( iOldState < src.lexStates.num() && S64( src.lexStates[ iOldState ].nextToken.getOffset() ) + iDelta < iNext ) {
+					++iOldState;
+				}
+
+				if( iOldState < src.lexStates.num() && S64( src.lexStates[ iOldState ].nextToken.getOffset() ) + iDelta == iNext ) {
+					const SLexerState &oldState = src.lexStates[ iOldState ];
+
+					SLexerState state;
+					if( lexer.saveState( state, uToken ) && state.resumesLike( oldState, iDelta ) ) {
+						uResyncToken = oldState.uToken;
+						break;
+					}
+				}
+
+				if( newTokens.num() % kLexStateInterval == 0 && !appendLexState( newStates, lexer, uToken ) ) {
+					return false;
+				}
+			}
+
+			const Bool bResynced = uResyncToken != ~UPtr( 0 );
+
+			// Without lining up, the new tokens run to the end of the file
+			if( !bResynced ) {
+				lexer.peek( tok );
+				if( !AX_VERIFY_MEMORY( newTokens.append( tok ) ) ) {
+					return false;
+				}
+			}
+
+			const UPtr cTailTokens = bResynced ? src.tokens.num() - uResyncToken : 0;
+
+			TMutArr<SToken> tokens;
+			if( !AX_VERIFY_MEMORY( tokens.reserve( uFirstToken + newTokens.num() + cTailTokens ) ) ) {
+				return false;
+			}
+
+			if( !AX_VERIFY_MEMORY( tokens.append( uFirstToken, src.tokens.pointer() ) ) || !AX_VERIFY_MEMORY( tokens.append( newTokens.num(), newTokens.pointer() ) ) ) {
+				return false;
+			}
+
+			TMutArr<SLexerState> states;
+			for( const SLexerState &state : src.lexStates ) {
+				if( state.uToken >= uFirstToken ) {
+					break;
+				}
+
+				if( !AX_VERIFY_MEMORY( states.append( state ) ) ) {
+					return false;
+				}
+			}
+			for( const SLexerState &state : newStates ) {
+				if( !AX_VERIFY_MEMORY( states.append( state ) ) ) {
+					return false;
+				}
+			}
+
+			if( bResynced ) {
+				for( UPtr i = uResyncToken; i < src.tokens.num(); ++i ) {
+					SToken moved = src.tokens[ i ];
+					moved.setOffset( UPtr( S64( moved.getOffset() ) + iDelta ) );
+
+					if( !AX_VERIFY_MEMORY( tokens.append( moved ) ) ) {
+						return false;
+					}
+				}
+
+				const S64 iTokenDelta = S64( uFirstToken + newTokens.num() ) - S64( uResyncToken );
+				for( UPtr i = iOldState; i < src.lexStates.num(); ++i ) {
+					SLexerState state = src.lexStates[ i ];
+					state.uToken  = U32( S64( state.uToken ) + iTokenDelta );
+					state.uResume = U32( S64( state.uResume ) + iDelta );
+					state.nextToken.setOffset( UPtr( S64( state.nextToken.getOffset() ) + iDelta ) );
+
+					if( !AX_VERIFY_MEMORY( states.append( state ) ) ) {
+						return false;
+					}
+				}
+			}
+
+			src.tokens.swap( tokens );
+			src.lexStates.swap( states );
+
+			src.cRelexedTokens = U32( newTokens.num() );
+
+			return true;
+		}
+
+	}
+
+	Bool CCompilerContext::lexSources( U32 cThreads )
+	{
+		using namespace detail;
+
+		// One job per source still to be lexed, in source order
+		TMutArr<SLexJob *> pJobs;
+		Bool bSuccess = true;
+
+		for( Source *pSrc : m_pSources ) {
+			if( !pSrc || pSrc->isLexed ) {
+				continue;
+			}
+
+			SLexJob *const pJob = new SLexJob( *pSrc, m_version, m_tokenCacheDir, m_pSources );
+			if( !AX_VERIFY_MEMORY( pJob ) ) {
+				bSuccess = false;
+				break;
+			}
+
+			if( !AX_VERIFY_MEMORY( pJobs.append( pJob ) ) ) {
+				delete pJob;
+				bSuccess = false;
+				break;
+			}
+		}
+
+		if( !bSuccess || pJobs.isEmpty() ) {
+			for( SLexJob *pJob : pJobs ) {
+				delete pJob;
+			}
+
+			return bSuccess;
+		}
+
+		if( !cThreads ) {
+			cThreads = kDefaultLexThreads;
+		}
+		if( cThreads > kMaxLexThreads ) {
+			cThreads = kMaxLexThreads;
+		}
+		if( cThreads > pJobs.num() ) {
+			cThreads = U32( pJobs.num() );
+		}
+
+		// Hand each source to whichever thread has the fewest bytes so far;
+		// the first worker is the calling thread
+		SLexWorker workers[ kMaxLexThreads ];
+
+		for( SLexJob *pJob : pJobs ) {
+			SLexWorker *pWorker = &workers[ 0 ];
+			for( U32 i = 1; i < cThreads; ++i ) {
+				if( workers[ i ].cBytes < pWorker->cBytes ) {
+					pWorker = &workers[ i ];
+				}
+			}
+
+			if( !AX_VERIFY_MEMORY( pWorker->pJobs.append( pJob ) ) ) {
+				// Still lexed, just not in parallel
+				pWorker = &workers[ 0 ];
+				if( !AX_VERIFY_MEMORY( pWorker->pJobs.append( pJob ) ) ) {
+					continue;
+				}
+			}
+
+			pWorker->cBytes += pJob->src.buffer.len() + 1;
+		}
+
+		for( U32 i = 1; i < cThreads; ++i ) {
+			SLexWorker &worker = workers[ i ];
+
+			worker.bStarted = axthread_init( &worker.thread, &lexWorker_f, ( Void * )&worker ) != 0;
+			if( worker.bStarted ) {
+				axthread_set_name( &worker.thread, "[Doll] Script Lexer" );
+			}
+		}
+
+		lexWorker_f( nullptr, ( Void * )&workers[ 0 ] );
+
+		for( U32 i = 1; i < cThreads; ++i ) {
+			SLexWorker &worker = workers[ i ];
+
+			if( worker.bStarted ) {
+				axthread_fini( &worker.thread );
+			} else {
+				lexWorker_f( nullptr, ( Void * )&worker );
+			}
+		}
+
+		// Merge serially in source order so identifiers, strings and
+		// diagnostics come out the same regardless of scheduling
+		for( SLexJob *pJob : pJobs ) {
+			if( !mergeLexJob( *this, *pJob ) ) {
+				bSuccess = false;
+			}
+
+			delete pJob;
+		}
+
+		return bSuccess && !m_diagEngine.didError();
+	}
+
+	Bool CCompilerContext::editSource( Source &src, U32 uOffset, U32 cRemoveBytes, const Str &text )
+	{
+		using namespace detail;
+
+		AX_ASSERT_MSG( UPtr( uOffset ) + cRemoveBytes <= src.buffer.len(), "Edit is out of range" );
+
+		const UPtr cOldBytes = src.buffer.len();
+		const UPtr cNewBytes = cOldBytes - cRemoveBytes + text.len();
+		if( cNewBytes >= UPtr( 1 )<<24 ) {
+			g_ErrorLog( src.filename ) += "Source file too big.";
+			return false;
+		}
+
+		const U32 uOldEditEnd = uOffset + cRemoveBytes;
+		const U32 uNewEditEnd = uOffset + U32( text.len() );
+		const S32 iDelta = S32( cNewBytes ) - S32( cOldBytes );
+
+		MutStr newBuffer;
+		if( !AX_VERIFY_MEMORY( newBuffer.reserve( cNewBytes ) ) ||
+		!AX_VERIFY_MEMORY( newBuffer.tryAssign( Str( src.buffer.get(), src.buffer.get() + uOffset ) ) ) ||
+		!AX_VERIFY_MEMORY( newBuffer.tryAppend( text ) ) ||
+		!AX_VERIFY_MEMORY( newBuffer.tryAppend( Str( src.buffer.get() + uOldEditEnd, src.buffer.getEnd() ) ) ) ) {
+			return false;
+		}
+
+		src.buffer.swap( newBuffer );
+		src.clearLineStarts();
+
+		// lexSources() will get to it
+		if( !src.isLexed ) {
+			return true;
+		}
+
+		// Last state far enough before the edit to restart from
+		const SLexerState *pStart = nullptr;
+		for( const SLexerState &state : src.lexStates ) {
+			if( UPtr( state.uResume ) + kLexEditSlack > uOffset ) {
+				break;
+			}
+
+			pStart = &state;
+		}
+
+		Bool bSuccess;
+		if( pStart != nullptr ) {
+			const SLexerState start = *pStart;
+			CLexer lexer( src, m_diagEngine, m_symDict, m_progData, m_arena, start );
+			bSuccess = relexEdit( src, lexer, start.uToken, uNewEditEnd, iDelta );
+		} else {
+			CLexer lexer( src, m_diagEngine, m_symDict, m_progData, m_arena );
+			bSuccess = relexEdit( src, lexer, 0, uNewEditEnd, iDelta );
+		}
+
+		if( !bSuccess ) {
+			// The old tokens don't match the buffer anymore
+			src.tokens.purge();
+			src.lexStates.purge();
+			src.isLexed = false;
+			return false;
+		}
+
+		return true;
+	}
+
+	Bool CCompilerContext::setTokenCacheDir( const Str &dir )
+	{
+		if( !AX_VERIFY_MEMORY( m_tokenCacheDir.assign( dir ) ) ) {
+			return false;
+		}
+
+		// Fine if it already exists
+		if( dir.isUsed() ) {
+			( Void )sysfs_mkdir( dir );
+		}
+
+		return true;
+	}
+	Str CCompilerContext::getTokenCacheDir() const
+	{
+		return m_tokenCacheDir;
+	}
+
 	Source *CCompilerContext::allocSource()
 	{
 		Source **ppSrc = nullptr;
@@ -540,7 +1104,7 @@ namespace doll { namespace script {
 		}
 
 		Source *&pSrc = *ppSrc;
-		if( !AX_VERIFY_MEMORY( pSrc = DOLL__SCRIPTOBJ_NEW Source( *this ) ) ) {
+		if( !AX_VERIFY_MEMORY( pSrc = DOLL__SCRIPTOBJ_NEW( *this ) Source( *this ) ) ) {
 			return nullptr;
 		}
 
@@ -1,10 +1,211 @@
 #include "../BuildSettings.hpp"
 
 #include "doll/Script/CompilerMemory.hpp"
+#include "doll/Script/Compiler.hpp"
+#include "doll/Core/Logger.hpp"
 #include "doll/Core/MemoryTags.hpp"
 
 namespace doll { namespace script {
 
+	static inline UPtr alignArenaSize( UPtr cBytes )
+	{
+		return ( cBytes + CCompilerArena::kAlignment - 1 ) & ~( CCompilerArena::kAlignment - 1 );
+	}
+
+	CCompilerArena::CCompilerArena()
+	: m_pChunks( nullptr )
+	, m_pCursor( nullptr )
+	, m_pEnd( nullptr )
+	, m_cUsedBytes( 0 )
+	, m_cReservedBytes( 0 )
+#if DOLL_SCRIPT_ARENA_TRACKING
+	, m_pTracked( nullptr )
+	, m_cTracked( 0 )
+#endif
+	{
+	}
+	CCompilerArena::~CCompilerArena()
+	{
+		releaseAll();
+	}
+
+	CCompilerArena::SChunk *CCompilerArena::newChunk( UPtr cDataBytes )
+	{
+		const UPtr cBytes = alignArenaSize( sizeof( SChunk ) ) + cDataBytes;
+
+		SChunk *const pChunk = reinterpret_cast< SChunk * >( DOLL__TEMP_ALLOCATOR->alloc( cBytes, kTag_Script, nullptr, 0, nullptr ) );
+		if( !AX_VERIFY_MEMORY( pChunk ) ) {
+			return nullptr;
+		}
+
+		pChunk->pNext  = nullptr;
+		pChunk->cBytes = cBytes;
+
+		m_cReservedBytes += cBytes;
+		return pChunk;
+	}
+
+	Void *CCompilerArena::alloc( UPtr cBytes, const char *pszFilename, U32 uLine, const char *pszFunc )
+	{
+		cBytes = alignArenaSize( cBytes ? cBytes : 1 );
+
+#if DOLL_SCRIPT_ARENA_TRACKING
+		const UPtr cHeaderBytes = getTrackedHeaderSize();
+
+		U8 *const p = reinterpret_cast< U8 * >( DOLL__TEMP_ALLOCATOR->alloc( cHeaderBytes + cBytes, kTag_Script, pszFilename, int( uLine ), pszFunc ) );
+		if( !AX_VERIFY_MEMORY( p ) ) {
+			return nullptr;
+		}
+
+		STrackedAlloc *const pHeader = reinterpret_cast< STrackedAlloc * >( p );
+		pHeader->pArena      = this;
+		pHeader->pPrev       = nullptr;
+		pHeader->pNext       = m_pTracked;
+		pHeader->cBytes      = cBytes;
+		pHeader->pszFilename = pszFilename;
+		pHeader->uLine       = uLine;
+		pHeader->pszFunc     = pszFunc;
+
+		if( m_pTracked != nullptr ) {
+			m_pTracked->pPrev = pHeader;
+		}
+		m_pTracked = pHeader;
+		++m_cTracked;
+
+		m_cUsedBytes += cBytes;
+		m_cReservedBytes += cHeaderBytes + cBytes;
+
+		return ( Void * )( p + cHeaderBytes );
+#else
+		( Void )pszFilename;
+		( Void )uLine;
+		( Void )pszFunc;
+
+		if( UPtr( m_pEnd - m_pCursor ) < cBytes ) {
+			// Big allocations get a chunk of their own, placed behind the
+			// current chunk so the space left in it isn't wasted
+			if( cBytes > kChunkSize/4 && m_pChunks != nullptr ) {
+				SChunk *const pChunk = newChunk( cBytes );
+				if( !pChunk ) {
+					return nullptr;
+				}
+
+				pChunk->pNext = m_pChunks->pNext;
+				m_pChunks->pNext = pChunk;
+
+				m_cUsedBytes += cBytes;
+				return ( Void * )( reinterpret_cast< U8 * >( pChunk ) + alignArenaSize( sizeof( SChunk ) ) );
+			}
+
+			SChunk *const pChunk = newChunk( cBytes > kChunkSize ? cBytes : kChunkSize );
+			if( !pChunk ) {
+				return nullptr;
+			}
+
+			pChunk->pNext = m_pChunks;
+			m_pChunks = pChunk;
+
+			m_pCursor = reinterpret_cast< U8 * >( pChunk ) + alignArenaSize( sizeof( SChunk ) );
+			m_pEnd = reinterpret_cast< U8 * >( pChunk ) + pChunk->cBytes;
+		}
+
+		Void *const p = ( Void * )m_pCursor;
+		m_pCursor += cBytes;
+		m_cUsedBytes += cBytes;
+
+		return p;
+#endif
+	}
+	Void CCompilerArena::dealloc( Void *pBytes )
+	{
+#if DOLL_SCRIPT_ARENA_TRACKING
+		if( !pBytes ) {
+			return;
+		}
+
+		STrackedAlloc *const pHeader = reinterpret_cast< STrackedAlloc * >( reinterpret_cast< U8 * >( pBytes ) - getTrackedHeaderSize() );
+		CCompilerArena &arena = *pHeader->pArena;
+
+		AX_ASSERT( arena.m_cTracked > 0 );
+
+		if( pHeader->pPrev != nullptr ) {
+			pHeader->pPrev->pNext = pHeader->pNext;
+		} else {
+			AX_ASSERT( arena.m_pTracked == pHeader );
+			arena.m_pTracked = pHeader->pNext;
+		}
+		if( pHeader->pNext != nullptr ) {
+			pHeader->pNext->pPrev = pHeader->pPrev;
+		}
+		--arena.m_cTracked;
+
+		arena.m_cUsedBytes -= pHeader->cBytes;
+		arena.m_cReservedBytes -= getTrackedHeaderSize() + pHeader->cBytes;
+
+		DOLL__TEMP_ALLOCATOR->dealloc( ( Void * )pHeader, nullptr, 0, nullptr );
+#else
+		// Released with the rest of the arena
+		( Void )pBytes;
+#endif
+	}
+
+	Str CCompilerArena::copyStr( const Str &s, const char *pszFilename, U32 uLine, const char *pszFunc )
+	{
+		if( s.isEmpty() ) {
+			return Str();
+		}
+
+		char *const p = reinterpret_cast< char * >( alloc( s.len(), pszFilename, uLine, pszFunc ) );
+		if( !p ) {
+			return Str();
+		}
+
+		memcpy( ( Void * )p, ( const Void * )s.get(), s.len() );
+		return Str( p, p + s.len() );
+	}
+
+	Void CCompilerArena::releaseAll()
+	{
+#if DOLL_SCRIPT_ARENA_TRACKING
+		if( m_cTracked > 0 ) {
+			g_DebugLog += axf( "%u compiler object(s) were not deleted before their context", unsigned( m_cTracked ) );
+
+			for( const STrackedAlloc *pHeader = m_pTracked; pHeader != nullptr; pHeader = pHeader->pNext ) {
+				const char *const pszMessage = axf( "Compiler object (%u bytes) still alive", unsigned( pHeader->cBytes ) );
+
+				if( pHeader->pszFilename != nullptr ) {
+					g_DebugLog( pHeader->pszFilename, pHeader->uLine, pHeader->pszFunc ) += pszMessage;
+				} else {
+					g_DebugLog += pszMessage;
+				}
+			}
+		}
+
+		while( m_pTracked != nullptr ) {
+			STrackedAlloc *const pHeader = m_pTracked;
+			m_pTracked = pHeader->pNext;
+
+			DOLL__TEMP_ALLOCATOR->dealloc( ( Void * )pHeader, nullptr, 0, nullptr );
+		}
+		m_cTracked = 0;
+#endif
+
+		while( m_pChunks != nullptr ) {
+			SChunk *const pChunk = m_pChunks;
+			m_pChunks = pChunk->pNext;
+
+			DOLL__TEMP_ALLOCATOR->dealloc( ( Void * )pChunk, nullptr, 0, nullptr );
+		}
+
+		m_pCursor = nullptr;
+		m_pEnd = nullptr;
+
+		m_cUsedBytes = 0;
+		m_cReservedBytes = 0;
+	}
+
+	// ------------------------------------------------------------------ //
+
 	CompilerObject::CompilerObject( CCompilerContext &ctx )
 	: m_context( ctx )
 	{
@@ -13,40 +214,57 @@ namespace doll { namespace script {
 	{
 	}
 
-	Void *CompilerObject::operator new( SizeType cBytes )
+	Void *CompilerObject::operator new( SizeType cBytes, CCompilerContext &ctx )
 	{
-		return DOLL__TEMP_ALLOCATOR->alloc( cBytes, kTag_Script, nullptr, 0, nullptr );
+		return ctx.getArena().alloc( cBytes, nullptr, 0, nullptr );
 	}
-	Void CompilerObject::operator delete( Void *pBytes )
+	Void CompilerObject::operator delete( Void *pBytes, CCompilerContext &ctx )
 	{
-		DOLL__TEMP_ALLOCATOR->dealloc( pBytes, nullptr, 0, nullptr );
+		( Void )ctx;
+		CCompilerArena::dealloc( pBytes );
 	}
 
-	Void *CompilerObject::operator new[]( SizeType cBytes )
+	Void *CompilerObject::operator new( SizeType cBytes, CCompilerContext &ctx, const char *pszFilename, U32 uLine, const char *pszFunc )
 	{
-		return DOLL__TEMP_ALLOCATOR->alloc( cBytes, kTag_Script, nullptr, 0, nullptr );
+		return ctx.getArena().alloc( cBytes, pszFilename, uLine, pszFunc );
 	}
-	Void CompilerObject::operator delete[]( Void *pBytes )
+	Void CompilerObject::operator delete( Void *pBytes, CCompilerContext &ctx, const char *pszFilename, U32 uLine, const char *pszFunc )
 	{
-		DOLL__TEMP_ALLOCATOR->dealloc( pBytes, nullptr, 0, nullptr );
+		( Void )ctx;
+		( Void )pszFilename;
+		( Void )uLine;
+		( Void )pszFunc;
+
+		CCompilerArena::dealloc( pBytes );
 	}
 
-	Void *CompilerObject::operator new( SizeType cBytes, const char *pszFilename, U32 uLine, const char *pszFunc )
+	Void *CompilerObject::operator new( SizeType cBytes, CCompilerArena &arena )
 	{
-		return DOLL__TEMP_ALLOCATOR->alloc( cBytes, kTag_Script, pszFilename, int( uLine ), pszFunc );
+		return arena.alloc( cBytes, nullptr, 0, nullptr );
 	}
-	Void CompilerObject::operator delete( Void *pBytes, const char *pszFilename, U32 uLine, const char *pszFunc )
+	Void CompilerObject::operator delete( Void *pBytes, CCompilerArena &arena )
 	{
-		DOLL__TEMP_ALLOCATOR->dealloc( pBytes, pszFilename, int( uLine ), pszFunc );
+		( Void )arena;
+		CCompilerArena::dealloc( pBytes );
 	}
 
-	Void *CompilerObject::operator new[]( SizeType cBytes, const char *pszFilename, U32 uLine, const char *pszFunc )
+	Void *CompilerObject::operator new( SizeType cBytes, CCompilerArena &arena, const char *pszFilename, U32 uLine, const char *pszFunc )
 	{
-		return DOLL__TEMP_ALLOCATOR->alloc( cBytes, kTag_Script, pszFilename, int( uLine ), pszFunc );
+		return arena.alloc( cBytes, pszFilename, uLine, pszFunc );
 	}
-	Void CompilerObject::operator delete[]( Void *pBytes, const char *pszFilename, U32 uLine, const char *pszFunc )
+	Void CompilerObject::operator delete( Void *pBytes, CCompilerArena &arena, const char *pszFilename, U32 uLine, const char *pszFunc )
+	{
+		( Void )arena;
+		( Void )pszFilename;
+		( Void )uLine;
+		( Void )pszFunc;
+
+		CCompilerArena::dealloc( pBytes );
+	}
+
+	Void CompilerObject::operator delete( Void *pBytes )
 	{
-		DOLL__TEMP_ALLOCATOR->dealloc( pBytes, pszFilename, int( uLine ), pszFunc );
+		CCompilerArena::dealloc( pBytes );
 	}
 
 	Void *CompilerObject::operator new( SizeType cBytes, Void *pExistingObj )
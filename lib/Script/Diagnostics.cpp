@@ -37,6 +37,7 @@ namespace doll { namespace script {
 	, m_options( 0 )
 	, m_states( 0 )
 	, m_formatted()
+	, m_pDeferred()
 	{
 		static CBuiltinLogger_DiagnosticReporter defReporter;
 
@@ -44,10 +45,40 @@ namespace doll { namespace script {
 	}
 	CDiagnosticEngine::~CDiagnosticEngine()
 	{
+		for( Diagnostic *pDiag : m_pDeferred ) {
+			delete pDiag;
+		}
+	}
+
+	Void CDiagnosticEngine::flushDeferred( CDiagnosticEngine &dst )
+	{
+		AX_ASSERT_MSG( &dst != this, "Cannot flush diagnostics into their own engine" );
+
+		for( Diagnostic *&pDiag : m_pDeferred ) {
+			dst.diagnose( *pDiag );
+
+			delete pDiag;
+			pDiag = nullptr;
+		}
+
+		m_pDeferred.clear();
 	}
 
 	Void CDiagnosticEngine::diagnose( const Diagnostic &diag )
 	{
+		if( isDeferred() ) {
+			Diagnostic *const pDiag = new Diagnostic( diag );
+			if( !AX_VERIFY_MEMORY( pDiag ) ) {
+				return;
+			}
+
+			if( !AX_VERIFY_MEMORY( m_pDeferred.append( pDiag ) ) ) {
+				delete pDiag;
+			}
+
+			return;
+		}
+
 		const EDiagnosticId id = diag.getId();
 		AX_ASSERT( UPtr( id ) < arraySize( g_diagDetails ) );
 
@@ -118,8 +149,79 @@ namespace doll { namespace script {
 		diagnose( range, id, args );
 	}
 
+	// Append the line the diagnostic is on, followed by a line marking its
+	// location with '^' and underlining its ranges on that line with '~'
+	static Bool appendSourceExcerpt( MutStr &dst, const Diagnostic &diag )
+	{
+		const SourceLoc loc = diag.getLoc();
+		AX_ASSERT_NOT_NULL( loc.pSource );
+
+		const Source &src = *loc.pSource;
+		const TArr<SourceRange> ranges = diag.getRanges();
+
+		const U32 uLine = src.findLine( loc.uOffset );
+		const U32 uLineStart = src.getLineStart( uLine );
+		const Str text = src.getLineText( uLine );
+		const U32 uLineEnd = uLineStart + U32( text.len() );
+
+		// Nothing past the last marked byte is written
+		U32 uMarkEnd = loc.uOffset + 1;
+		for( const SourceRange &range : ranges ) {
+			if( range.pSource != loc.pSource || range.uOffset >= uLineEnd || range.uOffset + range.cBytes <= uLineStart ) {
+				continue;
+			}
+
+			const U32 uRangeEnd = range.uOffset + range.cBytes < uLineEnd ? range.uOffset + range.cBytes : uLineEnd;
+			if( uMarkEnd < uRangeEnd ) {
+				uMarkEnd = uRangeEnd;
+			}
+		}
+
+		Bool r = true;
+
+		r = r && dst.tryAppend( "\n" );
+		r = r && dst.tryAppend( text );
+		r = r && dst.tryAppend( "\n" );
+
+		const char *const s = text.get();
+		const char *const e = text.getEnd();
+		for( const char *p = s; p < e && r; ) {
+			const U32 uOffset = uLineStart + U32( p - s );
+			if( uOffset >= uMarkEnd ) {
+				break;
+			}
+
+			char ch = *p == '\t' ? '\t' : ' ';
+			if( uOffset == loc.uOffset ) {
+				ch = '^';
+			} else {
+				for( const SourceRange &range : ranges ) {
+					if( range.pSource == loc.pSource && uOffset >= range.uOffset && uOffset < range.uOffset + range.cBytes ) {
+						ch = '~';
+						break;
+					}
+				}
+			}
+
+			r = r && dst.tryAppend( Str( ch ) );
+
+			// One marker character per code point
+			do {
+				++p;
+			} while( p < e && ( U8( *p ) & 0xC0 ) == 0x80 );
+		}
+
+		// Location at the end of the line (e.g., a missing terminator)
+		if( loc.uOffset >= uLineEnd ) {
+			r = r && dst.tryAppend( "^" );
+		}
+
+		return r;
+	}
+
 	CBuiltinLogger_DiagnosticReporter::CBuiltinLogger_DiagnosticReporter()
 	: IDiagnosticReporter()
+	, m_message()
 	{
 	}
 	CBuiltinLogger_DiagnosticReporter::~CBuiltinLogger_DiagnosticReporter()
@@ -131,27 +233,31 @@ namespace doll { namespace script {
 		const Source *const pSrc = diag.getLoc().pSource;
 		Str filename;
 		U32 row = 0, col = 0;
+		Str msg = details.msg;
 
 		if( pSrc != nullptr ) {
 			filename = pSrc->filename;
 			scr_calcLineInfo( row, col, diag.getLoc() );
+
+			m_message.clear();
+			if( m_message.tryAppend( details.msg ) && appendSourceExcerpt( m_message, diag ) ) {
+				msg = m_message;
+			}
 		}
 
 		switch( details.sev ) {
 		case EDiagnosticSeverity::Error:
-			g_ErrorLog( filename, row, col ) += details.msg;
+			g_ErrorLog( filename, row, col ) += msg;
 			break;
 
 		case EDiagnosticSeverity::Warning:
-			g_WarningLog( filename, row, col ) += details.msg;
+			g_WarningLog( filename, row, col ) += msg;
 			break;
 
 		case EDiagnosticSeverity::Note:
-			g_InfoLog( filename, row, col ) += details.msg;
+			g_InfoLog( filename, row, col ) += msg;
 			break;
 		}
-
-		// FIXME: Display source ranges
 	}
 
 }}
@@ -9,6 +9,7 @@ namespace doll { namespace script {
 	, isKeyword( false )
 	, keyword()
 	, pType( nullptr )
+	, pMerged( nullptr )
 	{
 	}
 	Ident::~Ident()
@@ -1,5 +1,6 @@
 #include "../BuildSettings.hpp"
 #include "doll/Script/LanguageVersion.hpp"
+#include "doll/Script/Compiler.hpp"
 
 namespace doll { namespace script {
 
@@ -9,7 +10,7 @@ namespace doll { namespace script {
 		const ESubtokenKeyword value;
 	};
 
-	static Bool addKeyword( CCompilerContext &ctx, IdentDictionary &dstDict, const SKeyword &kw )
+	static Bool addKeyword( CCompilerContext &ctx, CCompilerArena &arena, IdentDictionary &dstDict, const SKeyword &kw )
 	{
 		IdentDictionary::SEntry *pEntry;
 
@@ -20,7 +21,7 @@ namespace doll { namespace script {
 
 		AX_ASSERT_IS_NULL( pEntry->pData );
 
-		if( !AX_VERIFY_MEMORY( pEntry->pData = DOLL__SCRIPTOBJ_NEW Ident( ctx ) ) ) {
+		if( !AX_VERIFY_MEMORY( pEntry->pData = DOLL__SCRIPTOBJ_NEW( arena ) Ident( ctx ) ) ) {
 			return false;
 		}
 
@@ -31,10 +32,10 @@ namespace doll { namespace script {
 		return true;
 	}
 	template< UPtr tNumKeys >
-	static Bool addKeywords( CCompilerContext &ctx, IdentDictionary &dstDict, const SKeyword( &keys )[ tNumKeys ] )
+	static Bool addKeywords( CCompilerContext &ctx, CCompilerArena &arena, IdentDictionary &dstDict, const SKeyword( &keys )[ tNumKeys ] )
 	{
 		for( const SKeyword &key : keys ) {
-			if( !addKeyword( ctx, dstDict, key ) ) {
+			if( !addKeyword( ctx, arena, dstDict, key ) ) {
 				return false;
 			}
 		}
@@ -42,7 +43,7 @@ namespace doll { namespace script {
 		return true;
 	}
 
-	static Bool addKeywordsV1p0( CCompilerContext &ctx, IdentDictionary &dstDict )
+	static Bool addKeywordsV1p0( CCompilerContext &ctx, CCompilerArena &arena, IdentDictionary &dstDict )
 	{
 		static const SKeyword keywords[] = {
 			{ "null"        , kKW_Null         },
@@ -76,10 +77,10 @@ namespace doll { namespace script {
 			{ "multimessage", kKW_Multimessage }
 		};
 
-		return addKeywords( ctx, dstDict, keywords );
+		return addKeywords( ctx, arena, dstDict, keywords );
 	}
 
-	Bool initCompilerDictionary( CCompilerContext &ctx, IdentDictionary &dstDict, EVersion ver )
+	Bool initCompilerDictionary( CCompilerContext &ctx, CCompilerArena &arena, IdentDictionary &dstDict, EVersion ver )
 	{
 		if( !dstDict.init( AX_DICT_IDENT AX_DICT_UNICODE "." ) ) {
 			return false;
@@ -87,11 +88,15 @@ namespace doll { namespace script {
 
 		switch( ver ) {
 		case kVer_1_0:
-			return addKeywordsV1p0( ctx, dstDict );
+			return addKeywordsV1p0( ctx, arena, dstDict );
 		}
 
 		AX_ASSERT_MSG( false, "Unknown version" );
 		return false;
 	}
+	Bool initCompilerDictionary( CCompilerContext &ctx, IdentDictionary &dstDict, EVersion ver )
+	{
+		return initCompilerDictionary( ctx, ctx.getArena(), dstDict, ver );
+	}
 
 }}
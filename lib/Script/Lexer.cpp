@@ -6,6 +6,8 @@
 
 #include "doll/Math/Math.hpp"
 
+#include "LexerScan.hpp"
+
 namespace doll { namespace script {
 
 	namespace detail
@@ -31,10 +33,15 @@ namespace doll { namespace script {
 	}
 
 	CLexer::CLexer( Source &src, CDiagnosticEngine &diagEngine, IdentDictionary &dict, CProgramData &progData, const LexerOpts &opts )
+	: CLexer( src, diagEngine, dict, progData, src.getContext().getArena(), opts )
+	{
+	}
+	CLexer::CLexer( Source &src, CDiagnosticEngine &diagEngine, IdentDictionary &dict, CProgramData &progData, CCompilerArena &arena, const LexerOpts &opts )
 	: m_src( src )
 	, m_diagEngine( diagEngine )
 	, m_progData( progData )
 	, m_dict( dict )
+	, m_arena( arena )
 	, m_buffer( src.buffer )
 	, m_tokStack()
 	, m_nextToken()
@@ -44,15 +51,46 @@ namespace doll { namespace script {
 	, m_balance()
 	, m_nestingLevels()
 	, m_opts( opts )
+	, m_strBlob()
 	{
 		// Initialize the lexer
 		lexNextToken();
 	}
+	CLexer::CLexer( Source &src, CDiagnosticEngine &diagEngine, IdentDictionary &dict, CProgramData &progData, CCompilerArena &arena, const SLexerState &state, const LexerOpts &opts )
+	: m_src( src )
+	, m_diagEngine( diagEngine )
+	, m_progData( progData )
+	, m_dict( dict )
+	, m_arena( arena )
+	, m_buffer( src.buffer )
+	, m_tokStack()
+	, m_nextToken( state.nextToken )
+	, m_keepToken()
+	, m_pComment( detail::selectCommentToken( opts, m_nextToken, m_keepToken ) )
+	, m_stateFlags( state.stateFlags )
+	, m_balance( state.balance )
+	, m_nestingLevels()
+	, m_opts( opts )
+	, m_strBlob()
+	{
+		static_assert( U32( kNumBalances ) == SLexerState::kNumBalances, "SLexerState must match the lexer" );
+
+		AX_ASSERT( state.uResume <= src.buffer.len() );
+		AX_ASSERT( state.nextToken.getOffset() + state.nextToken.getLength() <= state.uResume );
+
+		for( U32 i = 0; i < kNumBalances; ++i ) {
+			m_nestingLevels[ i ] = state.nestingLevels[ i ];
+		}
+
+		// The next token was already read; continue just after it
+		m_buffer = Str( src.buffer.get() + state.uResume, src.buffer.getEnd() );
+	}
 	CLexer::CLexer( CCompilerContext &ctx, const LexerOpts &opts )
 	: m_src( *ctx.getActiveSource() )
 	, m_diagEngine( ctx.getDiagnosticEngine() )
 	, m_progData( ctx.getProgramData() )
 	, m_dict( ctx.getSymbolMap() )
+	, m_arena( ctx.getArena() )
 	, m_buffer( ctx.getActiveSource()->buffer )
 	, m_tokStack()
 	, m_nextToken()
@@ -62,6 +100,7 @@ namespace doll { namespace script {
 	, m_balance()
 	, m_nestingLevels()
 	, m_opts( opts )
+	, m_strBlob()
 	{
 		AX_ASSERT_NOT_NULL( ctx.getActiveSource() );
 
@@ -113,6 +152,25 @@ namespace doll { namespace script {
 		dstTok = m_nextToken;
 		return !dstTok.isEOF();
 	}
+	Bool CLexer::saveState( SLexerState &dst, U32 uToken ) const
+	{
+		// Tokens pushed back can't be restored
+		if( m_tokStack.isUsed() ) {
+			return false;
+		}
+
+		dst.uToken     = uToken;
+		dst.uResume    = U32( m_buffer.get() - m_src.buffer.get() );
+		dst.nextToken  = m_nextToken;
+		dst.stateFlags = m_stateFlags;
+		dst.balance    = m_balance;
+
+		for( U32 i = 0; i < kNumBalances; ++i ) {
+			dst.nestingLevels[ i ] = m_nestingLevels[ i ];
+		}
+
+		return true;
+	}
 	Bool CLexer::skip()
 	{
 		if( m_nextToken.isEOF() ) {
@@ -276,6 +334,13 @@ namespace doll { namespace script {
 
 		// Check for punctuation (should always happen after checking for an identifier!)
 		if( readPunct( m_nextToken ) ) {
+			// A stray closer is a bad token, so whatever reads the tokens can
+			// carry on past it
+			if( !checkCloser( m_nextToken ) ) {
+				m_nextToken.setType( kTT_None );
+				m_nextToken.setFlags( kTN_Error );
+			}
+
 			return true;
 		}
 
@@ -292,6 +357,58 @@ namespace doll { namespace script {
 		return true;
 	}
 
+	Bool CLexer::checkCloser( const SToken &tok )
+	{
+		unsigned which = ~0U;
+
+		switch( tok.getFlags() ) {
+		case kPn_RParen:
+			which = kBalance_Paren;
+			break;
+
+		case kPn_RBracket:
+			which = kBalance_Brack;
+			break;
+
+		case kPn_RBrace:
+			// Choices have to be in braces after "menu"; give up on the menu
+			if( ( m_stateFlags & ( kStateF_AwaitMenu | kStateF_InMenu ) ) == kStateF_AwaitMenu ) {
+				m_diagEngine.diagnose( getLocFromToken( tok ), Diag::ExpectedMenu );
+				m_stateFlags &= ~kStateF_AwaitMenu;
+				return false;
+			}
+
+			which = kBalance_Brace;
+			break;
+
+		default:
+			return true;
+		}
+
+		// Checked again as the token is taken (see lexNextToken()), which
+		// only fails for tokens pushed back since
+		if( m_balance.isTop( which ) ) {
+			return true;
+		}
+
+		const SourceLoc loc( getLocFromToken( tok ) );
+		switch( which ) {
+		case kBalance_Paren:
+			m_diagEngine.diagnose( loc, Diag::UnbalancedRParen );
+			break;
+
+		case kBalance_Brack:
+			m_diagEngine.diagnose( loc, Diag::UnbalancedRBrack );
+			break;
+
+		case kBalance_Brace:
+			m_diagEngine.diagnose( loc, Diag::UnbalancedRBrace );
+			break;
+		}
+
+		return false;
+	}
+
 	Bool CLexer::skipWhitespaceAndComments()
 	{
 		const char *const pOrg = m_buffer.get();
@@ -305,7 +422,9 @@ namespace doll { namespace script {
 
 		Str s = m_buffer;
 		for(;;) {
-			s = m_buffer.skipWhitespace();
+			// Skip the common blank characters in bulk, then anything else
+			// that counts as whitespace
+			s = lexScan_find( m_buffer, SLexScan_Blank() ).skipWhitespace();
 
 			const Str base( s );
 
@@ -358,6 +477,12 @@ namespace doll { namespace script {
 
 				UPtr cNesting = 1;
 				while( cNesting > 0 && !s.isEmpty() ) {
+					// Only a '/' or '*' can open or close a comment
+					s = lexScan_find( s, SLexScan_Either( '/', '*' ) );
+					if( s.isEmpty() ) {
+						break;
+					}
+
 					if( s.startsWith( "/*" ) ) {
 						++cNesting;
 						s = s.skip( 2 );
@@ -381,7 +506,7 @@ namespace doll { namespace script {
 					flags = ( flags & ~kSC_StyleMask ) | kSC_NormalStyle;
 				}
 
-				s = s.searchAny( "\r\n" );
+				s = lexScan_find( s, SLexScan_Either( '\r', '\n' ) );
 			}
 
 			if( m_pComment != nullptr && ( m_opts.comments != ELexCommentMode::EmitTests || ( flags & kSC_StyleMask ) == kSC_TestStyle ) ) {
@@ -488,15 +613,7 @@ namespace doll { namespace script {
 				}
 			}
 		} else {
-			while( s.isUsed() ) {
-				const unsigned char ch = ( unsigned char )*s.get();
-
-				if( axstr_isalnum( ch ) || ch == '_' ) {
-					s = s.skip();
-				} else {
-					break;
-				}
-			}
+			s = lexScan_find( s, SLexScan_Ident() );
 		}
 
 		switch( t ) {
@@ -557,13 +674,17 @@ namespace doll { namespace script {
 				// FIXME: Check for a standard type
 			}
 		} else {
-			if( !AX_VERIFY_MEMORY( pEntry->pData = DOLL__SCRIPTOBJ_NEW Ident( m_src.getContext() ) ) ) {
+			if( !AX_VERIFY_MEMORY( pEntry->pData = DOLL__SCRIPTOBJ_NEW( m_arena ) Ident( m_src.getContext() ) ) ) {
 				return false;
 			}
 		}
 
 		if( pEntry->pData->name.isEmpty() ) {
-			pEntry->pData->name = sym;
+			// Copied, since the buffer can change under an identifier that
+			// outlives its tokens (see `CCompilerContext::editSource`)
+			if( !AX_VERIFY_MEMORY( ( pEntry->pData->name = m_arena.copyStr( sym ) ).isUsed() ) ) {
+				return false;
+			}
 		}
 
 		dstTok.value.p = pEntry->pData;
@@ -1075,7 +1196,7 @@ namespace doll { namespace script {
 	}
 	Bool CLexer::readString( SToken &dstTok, Bool acceptDlg )
 	{
-		static MutStr blob;
+		MutStr &blob = m_strBlob;
 		Str s( m_buffer );
 		Str t;
 
@@ -1160,6 +1281,9 @@ namespace doll { namespace script {
 			}
 		}
 
+		// Bytes worth stopping on within the body; everything else is copied as is
+		const SLexScan_String plainScan( lexScan_utf8Lead( expectChar ), type == TXT && !expectChar );
+
 		t = s;
 		Bool unmatched = false;
 		Str ps;
@@ -1203,6 +1327,7 @@ namespace doll { namespace script {
 
 			if( *s != '\\' ) {
 				s.readChar();
+				s = lexScan_find( s, plainScan );
 				continue;
 			}
 
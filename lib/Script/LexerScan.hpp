@@ -0,0 +1,239 @@
+#pragma once
+
+#include "doll/Core/Defs.hpp"
+#include "doll/Math/SIMD.hpp"
+
+#if AX_INTRIN_SSE && _MSC_VER
+# include <intrin.h>
+#endif
+
+/*
+===============================================================================
+
+	LEXER BYTE SCANNING
+
+	The lexer spends most of its time walking over runs of bytes it doesn't
+	care about: indentation, comment bodies, identifier characters and the
+	text of strings and dialogue. `lexScan_find()` finds the end of such a
+	run. With SSE it classifies sixteen bytes per step (one compare per
+	character class, then a movemask to find the first hit). The bytes left
+	over at the end of the buffer, and every byte when there's no SSE, go
+	through the scalar test instead. Both paths give the same answer, and
+	neither reads past `e`.
+
+	Each class is a small struct with two `match()` functions. One takes a
+	single byte and the other takes sixteen; both are true/set for a byte
+	that ends the run. Only ASCII (or UTF-8 lead) bytes are used as
+	delimiters, so the scan always stops on a character boundary.
+
+===============================================================================
+*/
+
+namespace doll { namespace script {
+
+#if AX_INTRIN_SSE
+	// Index of the lowest set bit (`uMask` must be nonzero)
+	inline U32 lexScan_firstBit( U32 uMask )
+	{
+# if _MSC_VER
+		unsigned long uIndex;
+		_BitScanForward( &uIndex, uMask );
+		return U32( uIndex );
+# else
+		return U32( __builtin_ctz( uMask ) );
+# endif
+	}
+
+	// Bytes equal to `ch`
+	inline __m128i lexScan_eq( __m128i v, U8 ch )
+	{
+		return _mm_cmpeq_epi8( v, _mm_set1_epi8( char( ch ) ) );
+	}
+	// Bytes within [lo,hi]; both must be in [0x01,0x7E] (bytes >= 0x80 are
+	// negative as signed bytes, so they never match)
+	inline __m128i lexScan_range( __m128i v, U8 lo, U8 hi )
+	{
+		return
+			_mm_and_si128
+			(
+				_mm_cmpgt_epi8( v, _mm_set1_epi8( char( lo - 1 ) ) ),
+				_mm_cmplt_epi8( v, _mm_set1_epi8( char( hi + 1 ) ) )
+			);
+	}
+	// Bytes not set in `m`
+	inline __m128i lexScan_not( __m128i m )
+	{
+		return _mm_xor_si128( m, _mm_set1_epi8( char( -1 ) ) );
+	}
+#endif
+
+	// Pointer to the first byte in [p,e) matching `cls`, or `e`, one byte at a
+	// time (the tail of `lexScan_find()`; the tests compare the two)
+	template< typename TClass >
+	inline const char *lexScan_findScalar( const char *p, const char *e, const TClass &cls )
+	{
+		while( p < e && !cls.match( U8( *p ) ) ) {
+			++p;
+		}
+
+		return p;
+	}
+
+	// Pointer to the first byte in [p,e) matching `cls`, or `e`
+	template< typename TClass >
+	inline const char *lexScan_find( const char *p, const char *e, const TClass &cls )
+	{
+#if AX_INTRIN_SSE
+		while( e - p >= 16 ) {
+			const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i * >( p ) );
+			const U32 uMask = U32( _mm_movemask_epi8( cls.match( v ) ) );
+
+			if( uMask != 0 ) {
+				return p + lexScan_firstBit( uMask );
+			}
+
+			p += 16;
+		}
+#endif
+
+		return lexScan_findScalar( p, e, cls );
+	}
+	template< typename TClass >
+	inline Str lexScan_find( const Str &s, const TClass &cls )
+	{
+		return Str( lexScan_find( s.get(), s.getEnd(), cls ), s.getEnd() );
+	}
+
+	// Stops on anything other than a space, tab, or line break
+	struct SLexScan_Blank
+	{
+		inline Bool match( U8 ch ) const
+		{
+			return ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n';
+		}
+#if AX_INTRIN_SSE
+		inline __m128i match( __m128i v ) const
+		{
+			return
+				lexScan_not
+				(
+					_mm_or_si128
+					(
+						_mm_or_si128( lexScan_eq( v, ' ' ), lexScan_eq( v, '\t' ) ),
+						_mm_or_si128( lexScan_eq( v, '\r' ), lexScan_eq( v, '\n' ) )
+					)
+				);
+		}
+#endif
+	};
+
+	// Stops on anything that can't continue a plain identifier ([A-Za-z0-9_])
+	struct SLexScan_Ident
+	{
+		inline Bool match( U8 ch ) const
+		{
+			const U8 lower = ch | 0x20;
+
+			return
+				!( lower >= 'a' && lower <= 'z' ) &&
+				!( ch >= '0' && ch <= '9' ) &&
+				ch != '_';
+		}
+#if AX_INTRIN_SSE
+		inline __m128i match( __m128i v ) const
+		{
+			const __m128i lower = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+
+			return
+				lexScan_not
+				(
+					_mm_or_si128
+					(
+						_mm_or_si128( lexScan_range( lower, 'a', 'z' ), lexScan_range( v, '0', '9' ) ),
+						lexScan_eq( v, '_' )
+					)
+				);
+		}
+#endif
+	};
+
+	// Stops on either of two bytes
+	struct SLexScan_Either
+	{
+		U8 a, b;
+
+		inline SLexScan_Either( U8 a, U8 b )
+		: a( a )
+		, b( b )
+		{
+		}
+
+		inline Bool match( U8 ch ) const
+		{
+			return ch == a || ch == b;
+		}
+#if AX_INTRIN_SSE
+		inline __m128i match( __m128i v ) const
+		{
+			return _mm_or_si128( lexScan_eq( v, a ), lexScan_eq( v, b ) );
+		}
+#endif
+	};
+
+	// Stops on anything a string body has to look at: the first byte of its
+	// closing character, a backslash, a line break, and (for strings that
+	// end at whitespace) any byte up to and including space
+	struct SLexScan_String
+	{
+		U8   uClose;
+		Bool bStopAtBlank;
+
+		inline SLexScan_String( U8 uClose, Bool bStopAtBlank )
+		: uClose( uClose )
+		, bStopAtBlank( bStopAtBlank )
+		{
+		}
+
+		inline Bool match( U8 ch ) const
+		{
+			return
+				ch == uClose || ch == '\\' || ch == '\r' || ch == '\n' ||
+				( bStopAtBlank && ch <= ' ' );
+		}
+#if AX_INTRIN_SSE
+		inline __m128i match( __m128i v ) const
+		{
+			__m128i m =
+				_mm_or_si128
+				(
+					_mm_or_si128( lexScan_eq( v, uClose ), lexScan_eq( v, '\\' ) ),
+					_mm_or_si128( lexScan_eq( v, '\r' ), lexScan_eq( v, '\n' ) )
+				);
+
+			if( bStopAtBlank ) {
+				// Unsigned `v <= ' '`
+				m = _mm_or_si128( m, _mm_cmpeq_epi8( _mm_min_epu8( v, _mm_set1_epi8( ' ' ) ), v ) );
+			}
+
+			return m;
+		}
+#endif
+	};
+
+	// First byte of the UTF-8 encoding of `cp`
+	inline U8 lexScan_utf8Lead( axstr_utf32_t cp )
+	{
+		if( cp < 0x80 ) {
+			return U8( cp );
+		}
+		if( cp < 0x800 ) {
+			return U8( 0xC0 | ( cp>>6 ) );
+		}
+		if( cp < 0x10000 ) {
+			return U8( 0xE0 | ( cp>>12 ) );
+		}
+
+		return U8( 0xF0 | ( cp>>18 ) );
+	}
+
+}}
@@ -0,0 +1,93 @@
+#include "../BuildSettings.hpp"
+#include "doll/Script/Operator.hpp"
+#include "doll/Script/Token.hpp"
+
+namespace doll { namespace script {
+
+	static const SOperator g_binaryOps[] = {
+#define OP_(Text_,Punct_,Prec_,Assoc_,Builtin_,IsAssign_) \
+	{ Text_, kPn_##Punct_, kPrec_##Prec_, EAssoc::Assoc_, EOpType::Binary, EBuiltinOp::Builtin_, IsAssign_ }
+
+		OP_( "=",   Assign,         Assignment,     Right, None,    true  ),
+		OP_( ":=",  AutoAssign,     Assignment,     Right, None,    true  ),
+		OP_( "?=",  OptionalAssign, Assignment,     Right, None,    true  ),
+		OP_( "+=",  AddAssign,      Assignment,     Right, Add,     true  ),
+		OP_( "-=",  SubAssign,      Assignment,     Right, Sub,     true  ),
+		OP_( "*=",  MulAssign,      Assignment,     Right, Mul,     true  ),
+		OP_( "/=",  DivAssign,      Assignment,     Right, Div,     true  ),
+		OP_( "%=",  ModAssign,      Assignment,     Right, Mod,     true  ),
+		OP_( "|=",  BitOrAssign,    Assignment,     Right, BitOr,   true  ),
+		OP_( "&=",  BitAndAssign,   Assignment,     Right, BitAnd,  true  ),
+		OP_( "^=",  BitXorAssign,   Assignment,     Right, BitXor,  true  ),
+		OP_( "<<=", LShAssign,      Assignment,     Right, BitSL,   true  ),
+		OP_( ">>=", RShAssign,      Assignment,     Right, BitSR,   true  ),
+		OP_( "&+=", AddOFAssign,    Assignment,     Right, None,    true  ),
+		OP_( "&-=", SubOFAssign,    Assignment,     Right, None,    true  ),
+		OP_( "&*=", MulOFAssign,    Assignment,     Right, None,    true  ),
+		OP_( "||=", RelOrAssign,    Assignment,     Right, RelOr,   true  ),
+		OP_( "&&=", RelAndAssign,   Assignment,     Right, RelAnd,  true  ),
+		OP_( "<=>", Swap,           Assignment,     Right, None,    true  ),
+
+		OP_( "??",  NilCoalesce,    NilCoalesce,    Right, None,    false ),
+
+		OP_( "||",  RelOr,          RelOr,          Left,  RelOr,   false ),
+		OP_( "&&",  RelAnd,         RelAnd,         Left,  RelAnd,  false ),
+
+		OP_( "==",  Eq,             Comparison,     Left,  CmpEq,   false ),
+		OP_( "!=",  NE,             Comparison,     Left,  CmpNe,   false ),
+		OP_( "<",   Lt,             Comparison,     Left,  CmpLt,   false ),
+		OP_( ">",   Gt,             Comparison,     Left,  CmpGt,   false ),
+		OP_( "<=",  LE,             Comparison,     Left,  CmpLe,   false ),
+		OP_( ">=",  GE,             Comparison,     Left,  CmpGe,   false ),
+		OP_( "~=",  ApxEq,          Comparison,     Left,  None,    false ),
+		OP_( "===", IdEq,           Comparison,     Left,  None,    false ),
+		OP_( "!==", IdNE,           Comparison,     Left,  None,    false ),
+
+		OP_( "...", Ellipsis,       Range,          Left,  None,    false ),
+		OP_( "..<", HalfOpenRange,  Range,          Left,  None,    false ),
+
+		OP_( "+",   Add,            Additive,       Left,  Add,     false ),
+		OP_( "-",   Sub,            Additive,       Left,  Sub,     false ),
+		OP_( "|",   BitOr,          Additive,       Left,  BitOr,   false ),
+		OP_( "^",   BitXor,         Additive,       Left,  BitXor,  false ),
+		OP_( "&+",  AddOF,          Additive,       Left,  None,    false ),
+		OP_( "&-",  SubOF,          Additive,       Left,  None,    false ),
+
+		OP_( "*",   Mul,            Multiplicative, Left,  Mul,     false ),
+		OP_( "/",   Div,            Multiplicative, Left,  Div,     false ),
+		OP_( "%",   Mod,            Multiplicative, Left,  Mod,     false ),
+		OP_( "&",   BitAnd,         Multiplicative, Left,  BitAnd,  false ),
+		OP_( "&*",  MulOF,          Multiplicative, Left,  None,    false ),
+
+		OP_( "<<",  LSh,            Shift,          Left,  BitSL,   false ),
+		OP_( ">>",  RSh,            Shift,          Left,  BitSR,   false )
+
+#undef OP_
+	};
+
+	static const SOperator g_unaryOps[] = {
+#define OP_(Text_,Punct_,Builtin_) \
+	{ Text_, kPn_##Punct_, kPrec_Prefix, EAssoc::Right, EOpType::Unary, EBuiltinOp::Builtin_, false }
+
+		OP_( "-",  Sub,    Neg    ),
+		OP_( "+",  Add,    None   ),
+		OP_( "!",  RelNot, RelNot ),
+		OP_( "~",  BitNot, BitNot ),
+		OP_( "&",  BitAnd, Addr   ),
+		OP_( "*",  Mul,    Deref  ),
+		OP_( "++", Inc,    None   ),
+		OP_( "--", Dec,    None   )
+
+#undef OP_
+	};
+
+	TArr<SOperator> getBuiltinBinaryOps()
+	{
+		return TArr<SOperator>( g_binaryOps );
+	}
+	TArr<SOperator> getBuiltinUnaryOps()
+	{
+		return TArr<SOperator>( g_unaryOps );
+	}
+
+}}
@@ -1 +1,1188 @@
 #include "../BuildSettings.hpp"
+
+#include "doll/Script/Parser.hpp"
+#include "doll/Script/Diagnostics.hpp"
+
+namespace doll { namespace script {
+
+	// Marks a punctuation subtoken that isn't an operator in the tables
+	static const U8 kNoOp = 0xFF;
+
+	// Counts one level of recursion for as long as it's in scope
+	struct SParseDepth
+	{
+		U32 &cDepth;
+
+		SParseDepth( U32 &cDepth )
+		: cDepth( cDepth )
+		{
+			++cDepth;
+		}
+		~SParseDepth()
+		{
+			--cDepth;
+		}
+	};
+
+	static Bool isDialogueToken( const SToken &tok )
+	{
+		return tok.isAny( kTT_KoePrefix, kTT_Koe, kTT_Speaker, kTT_Message );
+	}
+
+	CParser::CParser( CLexer &lexer, CDiagnosticEngine &diagEngine, CSyntaxTree &tree, TArr<SOperator> binaryOps, TArr<SOperator> unaryOps )
+	: m_lexer( lexer )
+	, m_diagEngine( diagEngine )
+	, m_tree( tree )
+	, m_binaryOps( binaryOps )
+	, m_unaryOps( unaryOps )
+	, m_tok()
+	, m_cGroupDepth( 0 )
+	, m_cDepth( 0 )
+	, m_cErrors( 0 )
+	, m_uErrorOffset( 0 )
+	, m_bNoMem( false )
+	{
+		AX_ASSERT_MSG( binaryOps.num() < kNoOp && unaryOps.num() < kNoOp, "Too many operators" );
+
+		memset( ( Void * )m_binaryIndex, kNoOp, sizeof( m_binaryIndex ) );
+		memset( ( Void * )m_unaryIndex, kNoOp, sizeof( m_unaryIndex ) );
+
+		for( UPtr i = 0; i < m_binaryOps.num() && i < kNoOp; ++i ) {
+			AX_ASSERT( m_binaryOps[ i ].type == EOpType::Binary && m_binaryOps[ i ].punct < 128 );
+			m_binaryIndex[ m_binaryOps[ i ].punct & 0x7F ] = U8( i );
+		}
+		for( UPtr i = 0; i < m_unaryOps.num() && i < kNoOp; ++i ) {
+			AX_ASSERT( m_unaryOps[ i ].type == EOpType::Unary && m_unaryOps[ i ].punct < 128 );
+			m_unaryIndex[ m_unaryOps[ i ].punct & 0x7F ] = U8( i );
+		}
+
+		// Look at the first token (skipping comments and bad tokens, as
+		// advance() does)
+		Bool bSkippedError = false;
+
+		m_lexer.peek( m_tok );
+		while( m_tok.is( kTT_Comment ) || m_tok.isError() ) {
+			bSkippedError |= m_tok.isError();
+
+			SToken tok;
+			if( !m_lexer.lex( tok ) ) {
+				break;
+			}
+
+			m_lexer.peek( m_tok );
+		}
+
+		if( bSkippedError ) {
+			noteLexerError();
+		}
+	}
+
+	//------------------------------------------------------------------------//
+
+	Void CParser::advance()
+	{
+		SToken tok;
+		Bool bSkippedError = false;
+
+		do {
+			const UPtr uOffset = m_tok.getOffset();
+
+			if( !m_lexer.lex( tok ) ) {
+				break;
+			}
+
+			m_lexer.peek( m_tok );
+
+			// The lexer refused to move past the token (and said why), so
+			// there's nothing more to parse
+			if( m_tok.getOffset() == uOffset && !m_tok.isEOF() ) {
+				noteLexerError();
+
+				m_tok.setType( kTT_None );
+				m_tok.setFlags( kTN_End );
+				m_tok.setOffset( m_lexer.getEndLoc().uOffset );
+				m_tok.setLength( 0 );
+				return;
+			}
+
+			// Bad tokens were already reported by the lexer
+			bSkippedError |= m_tok.isError();
+		} while( m_tok.is( kTT_Comment ) || m_tok.isError() );
+
+		if( bSkippedError ) {
+			noteLexerError();
+		}
+	}
+	Void CParser::noteLexerError()
+	{
+		// Counts as an error, and anything the parser would say about where
+		// it ended up likely follows from it
+		++m_cErrors;
+		m_uErrorOffset = U32( m_tok.getOffset() );
+	}
+	Bool CParser::isPunct( U8 punct ) const
+	{
+		return m_tok.is( kTT_Punctuation ) && m_tok.getFlags() == punct;
+	}
+	Bool CParser::isKeyword( U8 keyword ) const
+	{
+		return m_tok.is( kTT_Keyword ) && m_tok.getFlags() == keyword;
+	}
+	Bool CParser::acceptPunct( U8 punct )
+	{
+		if( !isPunct( punct ) ) {
+			return false;
+		}
+
+		advance();
+		return true;
+	}
+	Bool CParser::expectPunct( U8 punct, const Str &text )
+	{
+		if( acceptPunct( punct ) ) {
+			return true;
+		}
+
+		report( m_tok, Diag::ExpectedToken, text );
+		return false;
+	}
+	Bool CParser::expectKeyword( U8 keyword, const Str &text )
+	{
+		if( isKeyword( keyword ) ) {
+			advance();
+			return true;
+		}
+
+		report( m_tok, Diag::ExpectedToken, text );
+		return false;
+	}
+	Bool CParser::isAtStatementEnd() const
+	{
+		return
+			m_tok.isEOF() || m_tok.isStartingLine() ||
+			isPunct( kPn_Semicolon ) || isPunct( kPn_RBrace );
+	}
+	Bool CParser::isAtExpressionEnd() const
+	{
+		return m_tok.isEOF() || ( m_cGroupDepth == 0 && m_tok.isStartingLine() );
+	}
+
+	U32 CParser::addNode( ESyntaxKind kind, const SToken &tok, U8 uFlags )
+	{
+		const U32 uNode = m_tree.addNode( kind, tok, uFlags );
+		if( !uNode ) {
+			m_bNoMem = true;
+		}
+
+		return uNode;
+	}
+	U32 CParser::addLeaf( ESyntaxKind kind )
+	{
+		const U32 uNode = addNode( kind, m_tok );
+		if( uNode != 0 ) {
+			advance();
+		}
+
+		return uNode;
+	}
+	Void CParser::append( U32 uParent, U32 &uLastChild, U32 uChild )
+	{
+		if( !uParent || !uChild ) {
+			return;
+		}
+
+		m_tree.appendChild( uParent, uLastChild, uChild );
+	}
+
+	Void CParser::reportUnexpected( const SToken &tok )
+	{
+		if( tok.isEOF() ) {
+			report( tok, Diag::UnexpectedToken, Str( "end of file" ) );
+			return;
+		}
+
+		report( tok, Diag::UnexpectedToken, m_lexer.getLexan( tok ) );
+	}
+	U32 CParser::errorNode( const SToken &tok )
+	{
+		return addNode( kSN_Error, tok );
+	}
+	Void CParser::synchronize()
+	{
+		U32 cBraces = 0;
+
+		while( !m_tok.isEOF() ) {
+			if( cBraces == 0 ) {
+				if( m_tok.isStartingLine() ) {
+					break;
+				}
+				if( isPunct( kPn_Semicolon ) ) {
+					advance();
+					break;
+				}
+				if( isPunct( kPn_RBrace ) ) {
+					break;
+				}
+			}
+
+			if( isPunct( kPn_LBrace ) ) {
+				++cBraces;
+			} else if( isPunct( kPn_RBrace ) ) {
+				--cBraces;
+			}
+
+			advance();
+		}
+	}
+
+	//------------------------------------------------------------------------//
+
+	Bool CParser::parseProgram()
+	{
+		m_tree.clear();
+
+		// Roughly one node per token, and a token every few bytes
+		if( !m_tree.reserve( m_lexer.getEndLoc().uOffset/5 + 16 ) ) {
+			return false;
+		}
+
+		m_tree.addNode( kSN_Program, m_tok );
+		if( m_tree.isEmpty() ) {
+			m_bNoMem = true;
+			return false;
+		}
+
+		U32 uLastChild = 0;
+		while( !m_tok.isEOF() && !m_bNoMem ) {
+			parseStatement( CSyntaxTree::kRoot, uLastChild );
+		}
+
+		return !m_bNoMem && m_cErrors == 0;
+	}
+
+	Bool CParser::parseStatement( U32 uParent, U32 &uLastChild )
+	{
+		SParseDepth depth( m_cDepth );
+
+		const SToken firstTok = m_tok;
+		const U32 cErrors = m_cErrors;
+
+		// Empty statement
+		if( acceptPunct( kPn_Semicolon ) ) {
+			return true;
+		}
+
+		if( m_cDepth > kMaxDepth ) {
+			report( m_tok, Diag::NestingTooDeep );
+			append( uParent, uLastChild, errorNode( m_tok ) );
+			synchronize();
+
+			if( m_tok.getOffset() == firstTok.getOffset() && !m_tok.isEOF() ) {
+				advance();
+			}
+			return !m_bNoMem;
+		}
+
+		U32 uStmt = 0;
+		Bool bNeedEnd = true;
+
+		switch( m_tok.getType() ) {
+		case kTT_Keyword:
+			switch( m_tok.getFlags() ) {
+			case kKW_Var:
+			case kKW_Let:
+				uStmt = parseVarDecl();
+				break;
+			case kKW_Func:
+				uStmt = parseFuncDecl();
+				break;
+			case kKW_Struct:
+			case kKW_Class:
+			case kKW_Extension:
+			case kKW_Interface:
+			case kKW_Protocol:
+				uStmt = parseTypeDecl();
+				break;
+			case kKW_If:
+				uStmt = parseIf();
+				break;
+			case kKW_While:
+				uStmt = parseWhile();
+				break;
+			case kKW_Do:
+				uStmt = parseDoWhile();
+				break;
+			case kKW_Loop:
+				uStmt = parseLoop();
+				break;
+			case kKW_For:
+				uStmt = parseForIn();
+				break;
+			case kKW_Switch:
+				uStmt = parseSwitch();
+				break;
+			case kKW_Menu:
+				uStmt = parseMenu();
+				break;
+			case kKW_Return:
+				uStmt = parseReturn();
+				break;
+			case kKW_Break:
+				uStmt = parseKeywordLeaf( kSN_Break );
+				break;
+			case kKW_Continue:
+				uStmt = parseKeywordLeaf( kSN_Continue );
+				break;
+			case kKW_Defer:
+				uStmt = parseDefer();
+				break;
+			case kKW_Goto:
+				uStmt = parseGoto();
+				break;
+			case kKW_Multimessage:
+				uStmt = parseMultiMessage();
+				break;
+
+			case kKW_Null:
+			case kKW_False:
+			case kKW_True:
+				break;
+
+			default:
+				// `elseif`, `case`, etc. without what they belong to
+				reportUnexpected( m_tok );
+				uStmt = errorNode( m_tok );
+				advance();
+				break;
+			}
+			break;
+
+		case kTT_Label:
+			// A label starting a line defines it; anything may follow
+			if( m_tok.isStartingLine() ) {
+				uStmt = addLeaf( kSN_Label );
+				bNeedEnd = false;
+			}
+			break;
+
+		case kTT_KoePrefix:
+		case kTT_Koe:
+		case kTT_Speaker:
+		case kTT_Message:
+			uStmt = parseDialogue();
+			break;
+
+		case kTT_Punctuation:
+			if( isPunct( kPn_LBrace ) ) {
+				uStmt = parseBlock();
+			} else if( isPunct( kPn_RBrace ) ) {
+				reportUnexpected( m_tok );
+				uStmt = errorNode( m_tok );
+				advance();
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		// Anything else is an expression
+		if( !uStmt && !m_bNoMem && m_tok.getOffset() == firstTok.getOffset() ) {
+			const SToken exprTok = m_tok;
+			const U32 uExpr = parseExpression();
+
+			if( uExpr != 0 && ( uStmt = addNode( kSN_ExprStmt, exprTok ) ) != 0 ) {
+				U32 uLastExpr = 0;
+				append( uStmt, uLastExpr, uExpr );
+			}
+		}
+
+		if( m_bNoMem ) {
+			return false;
+		}
+
+		append( uParent, uLastChild, uStmt );
+
+		if( bNeedEnd ) {
+			if( isAtStatementEnd() ) {
+				acceptPunct( kPn_Semicolon );
+			} else {
+				// Something went wrong within the statement if errors were
+				// reported; otherwise there's junk after it
+				if( m_cErrors == cErrors ) {
+					report( m_tok, Diag::ExpectedStatementEnd );
+				}
+
+				synchronize();
+			}
+		}
+
+		// Always move on, even past a token nothing could make sense of
+		if( m_tok.getOffset() == firstTok.getOffset() && !m_tok.isEOF() ) {
+			if( m_cErrors == cErrors ) {
+				reportUnexpected( m_tok );
+			}
+
+			advance();
+		}
+
+		return true;
+	}
+
+	U32 CParser::parseBlock()
+	{
+		if( !isPunct( kPn_LBrace ) ) {
+			report( m_tok, Diag::ExpectedBlock );
+			return errorNode( m_tok );
+		}
+
+		const U32 uBlock = addNode( kSN_Block, m_tok );
+		if( !uBlock ) {
+			return 0;
+		}
+
+		advance();
+
+		// Lines end statements again within the block
+		const U32 cGroupDepth = m_cGroupDepth;
+		m_cGroupDepth = 0;
+
+		U32 uLastChild = 0;
+		while( !m_tok.isEOF() && !isPunct( kPn_RBrace ) ) {
+			if( !parseStatement( uBlock, uLastChild ) ) {
+				m_cGroupDepth = cGroupDepth;
+				return 0;
+			}
+		}
+
+		m_cGroupDepth = cGroupDepth;
+
+		expectPunct( kPn_RBrace, "}" );
+		return uBlock;
+	}
+
+	U32 CParser::parseVarDecl()
+	{
+		const U32 uDecl = addNode( kSN_VarDecl, m_tok );
+		if( !uDecl ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+
+		if( !m_tok.is( kTT_Name ) ) {
+			report( m_tok, Diag::ExpectedName );
+			append( uDecl, uLastChild, errorNode( m_tok ) );
+			return uDecl;
+		}
+
+		append( uDecl, uLastChild, addLeaf( kSN_Name ) );
+
+		if( acceptPunct( kPn_Colon ) ) {
+			append( uDecl, uLastChild, parseTypeName() );
+		}
+
+		if( acceptPunct( kPn_Assign ) || acceptPunct( kPn_AutoAssign ) ) {
+			append( uDecl, uLastChild, parseExpression() );
+		}
+
+		return uDecl;
+	}
+	U32 CParser::parseFuncDecl()
+	{
+		const U32 uDecl = addNode( kSN_FuncDecl, m_tok );
+		if( !uDecl ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+
+		if( !m_tok.is( kTT_Name ) ) {
+			report( m_tok, Diag::ExpectedName );
+			append( uDecl, uLastChild, errorNode( m_tok ) );
+			return uDecl;
+		}
+
+		append( uDecl, uLastChild, addLeaf( kSN_Name ) );
+
+		if( !expectPunct( kPn_LParen, "(" ) ) {
+			return uDecl;
+		}
+
+		// Parameters: name [: Type], ...
+		if( !isPunct( kPn_RParen ) ) {
+			do {
+				if( !m_tok.is( kTT_Name ) ) {
+					report( m_tok, Diag::ExpectedName );
+					append( uDecl, uLastChild, errorNode( m_tok ) );
+					return uDecl;
+				}
+
+				const U32 uParam = addNode( kSN_Param, m_tok );
+				if( !uParam ) {
+					return 0;
+				}
+
+				U32 uLastParamChild = 0;
+				append( uParam, uLastParamChild, addLeaf( kSN_Name ) );
+
+				if( acceptPunct( kPn_Colon ) ) {
+					append( uParam, uLastParamChild, parseTypeName() );
+				}
+
+				append( uDecl, uLastChild, uParam );
+			} while( acceptPunct( kPn_Comma ) );
+		}
+
+		if( !expectPunct( kPn_RParen, ")" ) ) {
+			return uDecl;
+		}
+
+		if( acceptPunct( kPn_Colon ) ) {
+			append( uDecl, uLastChild, parseTypeName() );
+		}
+
+		// func f( x ) => x*2
+		if( acceptPunct( kPn_FuncDef ) ) {
+			m_tree.addFlags( uDecl, kSNF_ExprBody );
+			append( uDecl, uLastChild, parseExpression() );
+			return uDecl;
+		}
+
+		append( uDecl, uLastChild, parseBlock() );
+		return uDecl;
+	}
+	U32 CParser::parseTypeDecl()
+	{
+		const U32 uDecl = addNode( kSN_TypeDecl, m_tok );
+		if( !uDecl ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uDecl, uLastChild, parseTypeName() );
+
+		// Base types and protocols
+		if( acceptPunct( kPn_Colon ) ) {
+			do {
+				append( uDecl, uLastChild, parseTypeName() );
+			} while( acceptPunct( kPn_Comma ) );
+		}
+
+		append( uDecl, uLastChild, parseBlock() );
+		return uDecl;
+	}
+	U32 CParser::parseTypeName()
+	{
+		if( !m_tok.is( kTT_Type ) ) {
+			report( m_tok, Diag::ExpectedTypeName );
+			return errorNode( m_tok );
+		}
+
+		return addLeaf( kSN_Name );
+	}
+
+	U32 CParser::parseIf()
+	{
+		SParseDepth depth( m_cDepth );
+
+		// Also parses `elseif`
+		const U32 uIf = addNode( kSN_If, m_tok );
+		if( !uIf ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uIf, uLastChild, parseExpression() );
+		append( uIf, uLastChild, parseBlock() );
+
+		if( m_cDepth > kMaxDepth ) {
+			report( m_tok, Diag::NestingTooDeep );
+			return uIf;
+		}
+
+		if( isKeyword( kKW_ElseIf ) ) {
+			append( uIf, uLastChild, parseIf() );
+		} else if( isKeyword( kKW_Else ) ) {
+			advance();
+
+			if( isKeyword( kKW_If ) ) {
+				append( uIf, uLastChild, parseIf() );
+			} else {
+				append( uIf, uLastChild, parseBlock() );
+			}
+		}
+
+		return uIf;
+	}
+	U32 CParser::parseWhile()
+	{
+		const U32 uWhile = addNode( kSN_While, m_tok );
+		if( !uWhile ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uWhile, uLastChild, parseExpression() );
+		append( uWhile, uLastChild, parseBlock() );
+
+		return uWhile;
+	}
+	U32 CParser::parseDoWhile()
+	{
+		const U32 uDo = addNode( kSN_DoWhile, m_tok );
+		if( !uDo ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uDo, uLastChild, parseBlock() );
+
+		if( expectKeyword( kKW_While, "while" ) ) {
+			append( uDo, uLastChild, parseExpression() );
+		}
+
+		return uDo;
+	}
+	U32 CParser::parseLoop()
+	{
+		const U32 uLoop = addNode( kSN_Loop, m_tok );
+		if( !uLoop ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uLoop, uLastChild, parseBlock() );
+
+		return uLoop;
+	}
+	U32 CParser::parseForIn()
+	{
+		const U32 uFor = addNode( kSN_ForIn, m_tok );
+		if( !uFor ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+
+		if( !m_tok.is( kTT_Name ) ) {
+			report( m_tok, Diag::ExpectedName );
+			append( uFor, uLastChild, errorNode( m_tok ) );
+			return uFor;
+		}
+
+		append( uFor, uLastChild, addLeaf( kSN_Name ) );
+
+		if( !expectKeyword( kKW_In, "in" ) ) {
+			return uFor;
+		}
+
+		append( uFor, uLastChild, parseExpression() );
+		append( uFor, uLastChild, parseBlock() );
+
+		return uFor;
+	}
+	U32 CParser::parseSwitch()
+	{
+		const U32 uSwitch = addNode( kSN_Switch, m_tok );
+		if( !uSwitch ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uSwitch, uLastChild, parseExpression() );
+
+		if( !isPunct( kPn_LBrace ) ) {
+			report( m_tok, Diag::ExpectedBlock );
+			return uSwitch;
+		}
+
+		advance();
+
+		const U32 cGroupDepth = m_cGroupDepth;
+		m_cGroupDepth = 0;
+
+		while( !m_tok.isEOF() && !isPunct( kPn_RBrace ) && !m_bNoMem ) {
+			if( !isKeyword( kKW_Case ) && !isKeyword( kKW_Default ) ) {
+				report( m_tok, Diag::ExpectedToken, Str( "case" ) );
+
+				const U32 uOffset = U32( m_tok.getOffset() );
+				synchronize();
+				if( m_tok.getOffset() == uOffset && !isPunct( kPn_RBrace ) ) {
+					advance();
+				}
+
+				continue;
+			}
+
+			const Bool bDefault = isKeyword( kKW_Default );
+
+			const U32 uCase = addNode( kSN_Case, m_tok, bDefault ? kSNF_Default : 0 );
+			if( !uCase ) {
+				break;
+			}
+
+			advance();
+
+			U32 uLastCaseChild = 0;
+
+			if( !bDefault ) {
+				do {
+					append( uCase, uLastCaseChild, parseExpression() );
+				} while( acceptPunct( kPn_Comma ) );
+			}
+
+			expectPunct( kPn_Colon, ":" );
+
+			while( !m_tok.isEOF() && !isPunct( kPn_RBrace ) && !isKeyword( kKW_Case ) && !isKeyword( kKW_Default ) ) {
+				if( !parseStatement( uCase, uLastCaseChild ) ) {
+					break;
+				}
+			}
+
+			append( uSwitch, uLastChild, uCase );
+		}
+
+		m_cGroupDepth = cGroupDepth;
+
+		expectPunct( kPn_RBrace, "}" );
+		return uSwitch;
+	}
+	U32 CParser::parseMenu()
+	{
+		const U32 uMenu = addNode( kSN_Menu, m_tok );
+		if( !uMenu ) {
+			return 0;
+		}
+
+		advance();
+
+		if( !isPunct( kPn_LBrace ) ) {
+			report( m_tok, Diag::ExpectedBlock );
+			return uMenu;
+		}
+
+		advance();
+
+		const U32 cGroupDepth = m_cGroupDepth;
+		m_cGroupDepth = 0;
+
+		U32 uLastChild = 0;
+		while( !m_tok.isEOF() && !isPunct( kPn_RBrace ) && !m_bNoMem ) {
+			const U32 uOffset = U32( m_tok.getOffset() );
+
+			if( m_tok.is( kTT_Blank ) ) {
+				append( uMenu, uLastChild, addLeaf( kSN_MenuChoice ) );
+				continue;
+			}
+
+			// caption { ... }
+			const U32 uChoice = addNode( kSN_MenuChoice, m_tok );
+			if( !uChoice ) {
+				break;
+			}
+
+			U32 uLastChoiceChild = 0;
+			append( uChoice, uLastChoiceChild, parseExpression() );
+			append( uChoice, uLastChoiceChild, parseBlock() );
+
+			append( uMenu, uLastChild, uChoice );
+
+			if( m_tok.getOffset() == uOffset && !m_tok.isEOF() ) {
+				advance();
+			}
+		}
+
+		m_cGroupDepth = cGroupDepth;
+
+		expectPunct( kPn_RBrace, "}" );
+		return uMenu;
+	}
+	U32 CParser::parseReturn()
+	{
+		const U32 uReturn = addNode( kSN_Return, m_tok );
+		if( !uReturn ) {
+			return 0;
+		}
+
+		advance();
+
+		if( !isAtStatementEnd() ) {
+			U32 uLastChild = 0;
+			append( uReturn, uLastChild, parseExpression() );
+		}
+
+		return uReturn;
+	}
+	U32 CParser::parseKeywordLeaf( ESyntaxKind kind )
+	{
+		return addLeaf( kind );
+	}
+	U32 CParser::parseDefer()
+	{
+		const U32 uDefer = addNode( kSN_Defer, m_tok );
+		if( !uDefer ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uDefer, uLastChild, parseBlock() );
+
+		return uDefer;
+	}
+	U32 CParser::parseGoto()
+	{
+		const U32 uGoto = addNode( kSN_Goto, m_tok );
+		if( !uGoto ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+
+		if( !m_tok.is( kTT_Label ) ) {
+			report( m_tok, Diag::ExpectedLabel );
+			append( uGoto, uLastChild, errorNode( m_tok ) );
+			return uGoto;
+		}
+
+		append( uGoto, uLastChild, addLeaf( kSN_Name ) );
+		return uGoto;
+	}
+	U32 CParser::parseDialogue()
+	{
+		const U32 uDialogue = addNode( kSN_Dialogue, m_tok );
+		if( !uDialogue ) {
+			return 0;
+		}
+
+		// The koe and speaker can be on a line of their own, before the
+		// message; the line ends after a message
+		U32 uLastChild = 0;
+		Bool bHadMessage = false;
+		do {
+			bHadMessage |= m_tok.is( kTT_Message );
+			append( uDialogue, uLastChild, addLeaf( kSN_DialogueToken ) );
+		} while( !m_bNoMem && isDialogueToken( m_tok ) && ( !bHadMessage || !m_tok.isStartingLine() ) );
+
+		return uDialogue;
+	}
+	U32 CParser::parseMultiMessage()
+	{
+		const U32 uMulti = addNode( kSN_MultiMessage, m_tok );
+		if( !uMulti ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		append( uMulti, uLastChild, parseBlock() );
+
+		return uMulti;
+	}
+
+	//------------------------------------------------------------------------//
+
+	U32 CParser::parseExpression()
+	{
+		return parseSubexpression( 0 );
+	}
+
+	U32 CParser::parseTerminal()
+	{
+		switch( m_tok.getType() ) {
+		case kTT_Name:
+		case kTT_Type:
+		case kTT_Label:
+		case kTT_ConfigVar:
+		case kTT_SystemVar:
+		case kTT_TagRef:
+		case kTT_ProgTagRef:
+		case kTT_ResRef:
+		case kTT_CharRef:
+			return parseNameTerminal();
+
+		case kTT_NumericLiteral:
+			return addLeaf( kSN_Number );
+		case kTT_StringLiteral:
+			return addLeaf( kSN_String );
+
+		case kTT_Koe:
+		case kTT_Speaker:
+		case kTT_Message:
+			return addLeaf( kSN_DialogueToken );
+
+		case kTT_Keyword:
+			switch( m_tok.getFlags() ) {
+			case kKW_Null:
+			case kKW_False:
+			case kKW_True:
+				return addLeaf( kSN_Constant );
+
+			default:
+				break;
+			}
+			break;
+
+		case kTT_Punctuation:
+			if( isPunct( kPn_LParen ) ) {
+				advance();
+
+				++m_cGroupDepth;
+				const U32 uExpr = parseExpression();
+				--m_cGroupDepth;
+
+				expectPunct( kPn_RParen, ")" );
+				return uExpr;
+			}
+
+			if( isPunct( kPn_LBracket ) ) {
+				return parseArrayLiteral();
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		report( m_tok, Diag::ExpectedExpression );
+		return errorNode( m_tok );
+	}
+	U32 CParser::parseNameTerminal()
+	{
+		return addLeaf( kSN_Name );
+	}
+	U32 CParser::parseArrayLiteral()
+	{
+		const U32 uArray = addNode( kSN_ArrayLiteral, m_tok );
+		if( !uArray ) {
+			return 0;
+		}
+
+		advance();
+
+		U32 uLastChild = 0;
+		parseExpressionList( uArray, uLastChild, kPn_RBracket, "]" );
+
+		return uArray;
+	}
+	U32 CParser::parsePostfix( U32 uOperand )
+	{
+		while( uOperand != 0 && !isAtExpressionEnd() && m_tok.is( kTT_Punctuation ) ) {
+			U32 uNode = 0;
+			U32 uLastChild = 0;
+
+			switch( m_tok.getFlags() ) {
+			// f( args... )
+			case kPn_LParen:
+				if( !( uNode = addNode( kSN_Call, m_tok ) ) ) {
+					return 0;
+				}
+
+				advance();
+
+				append( uNode, uLastChild, uOperand );
+				parseExpressionList( uNode, uLastChild, kPn_RParen, ")" );
+				break;
+
+			// a[ index ]
+			case kPn_LBracket:
+				if( !( uNode = addNode( kSN_Index, m_tok ) ) ) {
+					return 0;
+				}
+
+				advance();
+
+				append( uNode, uLastChild, uOperand );
+
+				++m_cGroupDepth;
+				append( uNode, uLastChild, parseExpression() );
+				--m_cGroupDepth;
+
+				expectPunct( kPn_RBracket, "]" );
+				break;
+
+			// a.name
+			case kPn_Dot:
+				if( !( uNode = addNode( kSN_Member, m_tok ) ) ) {
+					return 0;
+				}
+
+				advance();
+
+				append( uNode, uLastChild, uOperand );
+
+				if( m_tok.isAny( kTT_Name, kTT_Type ) ) {
+					append( uNode, uLastChild, addLeaf( kSN_Name ) );
+				} else {
+					report( m_tok, Diag::ExpectedName );
+					append( uNode, uLastChild, errorNode( m_tok ) );
+				}
+				break;
+
+			// a++, a--
+			case kPn_Inc:
+			case kPn_Dec:
+				if( !( uNode = addNode( kSN_Unary, m_tok, kSNF_Postfix ) ) ) {
+					return 0;
+				}
+
+				advance();
+
+				append( uNode, uLastChild, uOperand );
+				break;
+
+			default:
+				return uOperand;
+			}
+
+			uOperand = uNode;
+		}
+
+		return uOperand;
+	}
+	U32 CParser::parseUnaryExpression()
+	{
+		SParseDepth depth( m_cDepth );
+
+		if( m_cDepth > kMaxDepth ) {
+			report( m_tok, Diag::NestingTooDeep );
+			return errorNode( m_tok );
+		}
+
+		if( m_tok.is( kTT_Punctuation ) ) {
+			const U8 punct = m_tok.getFlags();
+			const U8 uOp = punct < 128 ? m_unaryIndex[ punct ] : kNoOp;
+
+			if( uOp != kNoOp ) {
+				const U32 uNode = addNode( kSN_Unary, m_tok );
+				if( !uNode ) {
+					return 0;
+				}
+
+				advance();
+
+				U32 uLastChild = 0;
+				append( uNode, uLastChild, parseUnaryExpression() );
+
+				return uNode;
+			}
+		}
+
+		return parsePostfix( parseTerminal() );
+	}
+	U32 CParser::parseSubexpression( S32 precedenceLevel )
+	{
+		SParseDepth depth( m_cDepth );
+
+		if( m_cDepth > kMaxDepth ) {
+			report( m_tok, Diag::NestingTooDeep );
+			return errorNode( m_tok );
+		}
+
+		U32 uLeft = parseUnaryExpression();
+
+		while( uLeft != 0 && !m_bNoMem && !isAtExpressionEnd() && m_tok.is( kTT_Punctuation ) ) {
+			const U8 punct = m_tok.getFlags();
+
+			// cond ? a : b
+			if( punct == kPn_Conditional ) {
+				if( kPrec_Conditional < precedenceLevel ) {
+					break;
+				}
+
+				const U32 uNode = addNode( kSN_Conditional, m_tok );
+				if( !uNode ) {
+					return 0;
+				}
+
+				advance();
+
+				U32 uLastChild = 0;
+				append( uNode, uLastChild, uLeft );
+				append( uNode, uLastChild, parseExpression() );
+
+				if( expectPunct( kPn_Colon, ":" ) ) {
+					append( uNode, uLastChild, parseSubexpression( kPrec_Conditional ) );
+				} else {
+					append( uNode, uLastChild, errorNode( m_tok ) );
+				}
+
+				uLeft = uNode;
+				continue;
+			}
+
+			const U8 uOp = punct < 128 ? m_binaryIndex[ punct ] : kNoOp;
+			if( uOp == kNoOp ) {
+				break;
+			}
+
+			const SOperator &op = m_binaryOps[ uOp ];
+			if( op.precedence < precedenceLevel ) {
+				break;
+			}
+
+			const U32 uNode = addNode( kSN_Binary, m_tok, op.isAssignment ? kSNF_Assignment : 0 );
+			if( !uNode ) {
+				return 0;
+			}
+
+			advance();
+
+			// Left-associative operators only take tighter operators on
+			// their right; right-associative ones also take themselves
+			const S32 rightLevel = op.assoc == EAssoc::Left ? op.precedence + 1 : op.precedence;
+
+			U32 uLastChild = 0;
+			append( uNode, uLastChild, uLeft );
+			append( uNode, uLastChild, parseSubexpression( rightLevel ) );
+
+			uLeft = uNode;
+		}
+
+		return m_bNoMem ? 0 : uLeft;
+	}
+	Bool CParser::parseExpressionList( U32 uParent, U32 &uLastChild, U8 closePunct, const Str &closeText )
+	{
+		++m_cGroupDepth;
+
+		if( !isPunct( closePunct ) ) {
+			do {
+				const U32 uExpr = parseExpression();
+				if( !uExpr ) {
+					--m_cGroupDepth;
+					return false;
+				}
+
+				append( uParent, uLastChild, uExpr );
+			} while( acceptPunct( kPn_Comma ) );
+		}
+
+		--m_cGroupDepth;
+
+		return expectPunct( closePunct, closeText );
+	}
+
+}}
@@ -8,6 +8,7 @@ namespace doll { namespace script {
 	CProgramData::CProgramData()
 	: m_strings()
 	, m_blob()
+	, m_index()
 	{
 	}
 	CProgramData::~CProgramData()
@@ -34,13 +35,20 @@ namespace doll { namespace script {
 
 		const U64 uHash = ( ( uA & 0xFFFF0000 )<<32 ) | ( uB << 16 ) | ( uA & 0x0000FFFF );
 
-		axpf( "<<\"%.*s\":%.16llX\n", s.lenInt(), s.get(), uHash );
+		// Keep the index at most 3/4 full
+		if( ( m_strings.num() + 1 )*4 > m_index.num()*3 && !growIndex() ) {
+			return false;
+		}
 
-		// FIXME: Use better search
-		for( UPtr i = 0; i < m_strings.num(); ++i ) {
-			if( m_strings[ i ].uHash == uHash ) {
+		const UPtr uMask = m_index.num() - 1;
+		UPtr uSlot = getIndexSlot( uHash ) & uMask;
+		while( m_index[ uSlot ] != 0 ) {
+			const SStringData &strdat = m_strings[ m_index[ uSlot ] - 1 ];
+			if( strdat.uHash == uHash && strdat.cBytes == s.len() + 1 && memcmp( m_blob.pointer() + strdat.uOffset, s.get(), s.len() ) == 0 ) {
 				return true;
 			}
+
+			uSlot = ( uSlot + 1 ) & uMask;
 		}
 
 		if( !AX_VERIFY_MEMORY( m_blob.append( s.len(), ( const U8 * )s.get() ) ) ) {
@@ -61,6 +69,28 @@ namespace doll { namespace script {
 		strdat.cBytes  = U16( s.len() + 1 );
 		strdat.uFlags  = 0;
 
+		m_index[ uSlot ] = U32( m_strings.num() );
+		return true;
+	}
+	Bool CProgramData::growIndex()
+	{
+		const UPtr cSlots = m_index.num() < 256 ? 256 : m_index.num()*2;
+		if( !AX_VERIFY_MEMORY( m_index.resize( cSlots ) ) ) {
+			return false;
+		}
+
+		memset( ( Void * )m_index.pointer(), 0, sizeof( U32 )*cSlots );
+
+		const UPtr uMask = cSlots - 1;
+		for( UPtr i = 0; i < m_strings.num(); ++i ) {
+			UPtr uSlot = getIndexSlot( m_strings[ i ].uHash ) & uMask;
+			while( m_index[ uSlot ] != 0 ) {
+				uSlot = ( uSlot + 1 ) & uMask;
+			}
+
+			m_index[ uSlot ] = U32( i + 1 );
+		}
+
 		return true;
 	}
 	/*
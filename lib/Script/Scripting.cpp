@@ -68,6 +68,21 @@ public:
 	Bool testCurrentSource() {
 		return m_compiler.testCurrentSource();
 	}
+
+	Bool lexSources( U32 cThreads ) {
+		return m_compiler.lexSources( cThreads );
+	}
+	Bool setTokenCacheDir( const Str &dir ) {
+		return m_compiler.setTokenCacheDir( dir );
+	}
+	Bool editSource( U32 uOffset, U32 cRemoveBytes, const Str &text ) {
+		Source *const source = m_compiler.getActiveSource();
+		if( !source ) {
+			return false;
+		}
+
+		return m_compiler.editSource( *source, uOffset, cRemoveBytes, text );
+	}
 };
 
 DOLL_FUNC RCompiler *DOLL_API sc_new() {
@@ -118,4 +133,20 @@ DOLL_FUNC Bool DOLL_API sc_testCurrentSource( RCompiler *compiler ) {
 	return compiler->testCurrentSource();
 }
 
+DOLL_FUNC Bool DOLL_API sc_lexSources( RCompiler *compiler, U32 cThreads ) {
+	AX_ASSERT_NOT_NULL( compiler );
+
+	return compiler->lexSources( cThreads );
+}
+DOLL_FUNC Bool DOLL_API sc_setTokenCacheDir( RCompiler *compiler, const Str &dir ) {
+	AX_ASSERT_NOT_NULL( compiler );
+
+	return compiler->setTokenCacheDir( dir );
+}
+DOLL_FUNC Bool DOLL_API sc_editSource( RCompiler *compiler, U32 uOffset, U32 cRemoveBytes, const Str &text ) {
+	AX_ASSERT_NOT_NULL( compiler );
+
+	return compiler->editSource( uOffset, cRemoveBytes, text );
+}
+
 }
@@ -3,48 +3,149 @@
 #include "doll/Script/Source.hpp"
 #include "doll/Script/Compiler.hpp"
 
+#include "LexerScan.hpp"
+
 namespace doll { namespace script {
 
 	Source::Source( CCompilerContext &ctx )
 	: CompilerObject( ctx )
 	, filename()
 	, buffer()
+	, tokens()
+	, isLexed( false )
+	, lexStates()
+	, isFromTokenCache( false )
+	, cRelexedTokens( 0 )
 	, index( 0 )
+	, m_lineStarts()
 	{
 	}
 	Source::~Source()
 	{
 	}
 
+	Void Source::clearLineStarts()
+	{
+		m_lineStarts.clear();
+	}
+
+	Bool Source::calcLineStarts() const
+	{
+		if( m_lineStarts.isUsed() ) {
+			return true;
+		}
+
+		const char *const s = buffer.pointer();
+		const char *const e = s + buffer.len();
+
+		// Most lines are longer than this, so the table is rarely regrown
+		if( !AX_VERIFY_MEMORY( m_lineStarts.reserve( buffer.len()/32 + 1 ) ) ) {
+			return false;
+		}
+
+		if( !AX_VERIFY_MEMORY( m_lineStarts.append( 0 ) ) ) {
+			return false;
+		}
+
+		const char *p = s;
+		while( p < e ) {
+			p = lexScan_find( p, e, SLexScan_Either( '\r', '\n' ) );
+			if( p == e ) {
+				break;
+			}
+
+			// "\r\n", "\r" and "\n" each end a line
+			if( *p == '\r' && p + 1 < e && *( p + 1 ) == '\n' ) {
+				++p;
+			}
+			++p;
+
+			if( !AX_VERIFY_MEMORY( m_lineStarts.append( U32( p - s ) ) ) ) {
+				m_lineStarts.clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	U32 Source::numLines() const
+	{
+		if( !calcLineStarts() ) {
+			return 1;
+		}
+
+		return U32( m_lineStarts.num() );
+	}
+	U32 Source::findLine( U32 uOffset ) const
+	{
+		if( !calcLineStarts() ) {
+			return 0;
+		}
+
+		// Last line starting at or before the offset
+		U32 lo = 0;
+		U32 hi = U32( m_lineStarts.num() );
+		while( hi - lo > 1 ) {
+			const U32 mid = lo + ( hi - lo )/2;
+
+			if( m_lineStarts[ mid ] <= uOffset ) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+	U32 Source::getLineStart( U32 uLine ) const
+	{
+		if( !calcLineStarts() || uLine >= m_lineStarts.num() ) {
+			return U32( buffer.len() );
+		}
+
+		return m_lineStarts[ uLine ];
+	}
+	Str Source::getLineText( U32 uLine ) const
+	{
+		if( !calcLineStarts() || uLine >= m_lineStarts.num() ) {
+			return Str();
+		}
+
+		const char *const s = buffer.pointer();
+		const char *const b = s + m_lineStarts[ uLine ];
+		const char *e = uLine + 1 < m_lineStarts.num() ? s + m_lineStarts[ uLine + 1 ] : s + buffer.len();
+
+		while( e > b && ( *( e - 1 ) == '\r' || *( e - 1 ) == '\n' ) ) {
+			--e;
+		}
+
+		return Str( b, e );
+	}
+
 	DOLL_FUNC Bool DOLL_API scr_calcLineInfo( U32 &dstRow, U32 &dstCol, SourceLoc loc )
 	{
 		if( !loc.pSource || axstr_size_t( loc.uOffset ) > loc.pSource->buffer.len() ) {
 			return false;
 		}
 
-		const char *const e = loc.pSource->buffer.pointer( axstr_size_t( loc.uOffset ) );
-		const char *const s = loc.pSource->buffer.pointer();
-		const char *b = s;
+		const Source &src = *loc.pSource;
+
+		const U32 uLine = src.findLine( loc.uOffset );
 
-		U32 row = 1;
-		for( const char *p = s; p < e; ++p ) {
-			if( *p == '\r' ) {
-				if( *( p + 1 ) == '\n' ) {
-					++p;
-				}
+		const char *const b = src.buffer.pointer( axstr_size_t( src.getLineStart( uLine ) ) );
+		const char *const e = src.buffer.pointer( axstr_size_t( loc.uOffset ) );
 
-				++row;
-				b = p + 1;
-			} else if( *p == '\n' ) {
-				++row;
-				b = p + 1;
+		// Columns are counted in code points (continuation bytes don't count)
+		U32 col = 0;
+		for( const char *p = b; p < e; ++p ) {
+			if( ( U8( *p ) & 0xC0 ) != 0x80 ) {
+				++col;
 			}
 		}
 
-		const Str linetext( b, e );
-
-		dstRow = row;
-		dstCol = U32( linetext.numColumns() );
+		dstRow = uLine + 1;
+		dstCol = col;
 
 		return true;
 	}
@@ -0,0 +1,556 @@
+#include "../BuildSettings.hpp"
+
+#include "doll/Script/TokenCache.hpp"
+#include "doll/Script/LanguageVersion.hpp"
+#include "doll/Script/Token.hpp"
+
+#include "doll/IO/SysFS.hpp"
+#include "doll/Util/Hash.hpp"
+
+namespace doll { namespace script {
+
+	// "DTKC"
+	static const U32 kTokenCacheMagic = 0x434B5444;
+	// Larger cache files are ignored rather than loaded
+	static const U64 kMaxTokenCacheBytes = U64( 1 )<<30;
+
+#pragma pack(push,1)
+	struct STokenCacheHeader
+	{
+		// `kTokenCacheMagic`
+		U32 uMagic;
+		// `kTokenCacheFormat`
+		U16 uFormat;
+		// Language version the source was lexed with
+		U16 uVersion;
+		// Hash and size of the source's contents
+		U64 uSourceHash;
+		U32 cSourceBytes;
+
+		// Number of `SToken`s (right after the header)
+		U32 cTokens;
+		// Number of `STokenCacheIdent`s (after the tokens)
+		U32 cIdents;
+		// Number of strings, and bytes they take (after the identifiers);
+		// each string is a U16 length followed by its bytes
+		U32 cStrings;
+		U32 cStringBytes;
+		// Number of saved lexer states, and bytes they take (after the
+		// strings); each is an `STokenCacheLexState` followed by its
+		// balance stack, one byte per entry, bottom first
+		U32 cLexStates;
+		U32 cLexStateBytes;
+	};
+	// An identifier; identifier tokens store its index in `value.i`
+	struct STokenCacheIdent
+	{
+		// Range of the source buffer holding the name
+		U32 uNameOffset;
+		U16 cNameBytes;
+		// Whether this is a keyword, and which one
+		U8  bKeyword;
+		U8  uKeyword;
+	};
+	// A saved lexer state (see `SLexerState`). The next token's value isn't
+	// stored: it's a copy of token `uToken`'s
+	struct STokenCacheLexState
+	{
+		U32    uToken;
+		U32    uResume;
+		SToken nextToken;
+		U32    stateFlags;
+		U32    nestingLevels[ SLexerState::kNumBalances ];
+		// Number of balance stack entries that follow
+		U32    cBalance;
+	};
+#pragma pack(pop)
+
+	static U64 hashSource( const Str &buffer )
+	{
+		return ( U64( hashCRC32( buffer ) )<<32 ) | U64( hashSimple( buffer ) );
+	}
+
+	// "<cacheDir>/<hash>.dtk"
+	static Bool getCacheFilename( MutStr &dst, const Str &cacheDir, U64 uSourceHash )
+	{
+		static const char *const pszHex = "0123456789abcdef";
+
+		char szName[ 16 + 4 + 1 ];
+		for( UPtr i = 0; i < 16; ++i ) {
+			szName[ i ] = pszHex[ ( uSourceHash>>( 60 - i*4 ) ) & 0xF ];
+		}
+		szName[ 16 ] = '.';
+		szName[ 17 ] = 'd';
+		szName[ 18 ] = 't';
+		szName[ 19 ] = 'k';
+		szName[ 20 ] = '\0';
+
+		return dst.assign( cacheDir ) && dst.tryAppendPath( Str( szName ) );
+	}
+
+	static Bool readCacheFile( TMutArr<U8> &dst, const Str &filename )
+	{
+		OSFile f = nullptr;
+		if( sysfs_open( f, filename, kFileOpenF_R, kFileAttrib_Regular ) != EFileOpenResult::Ok ) {
+			return false;
+		}
+
+		const U64 cBytes = sysfs_size( f );
+		UPtr cRead = 0;
+
+		const Bool bRead =
+			cBytes >= sizeof( STokenCacheHeader ) &&
+			cBytes <= kMaxTokenCacheBytes &&
+			AX_VERIFY_MEMORY( dst.resize( UPtr( cBytes ) ) ) &&
+			sysfs_read( f, dst.pointer(), UPtr( cBytes ), cRead ) == EFileIOResult::Ok &&
+			cRead == UPtr( cBytes );
+
+		sysfs_close( f );
+		return bRead;
+	}
+	static Bool writeCacheFile( const Str &filename, const TMutArr<U8> &src )
+	{
+		OSFile f = nullptr;
+		if( sysfs_open( f, filename, kFileOpenF_W | kFileOpenF_Recreate, kFileAttrib_Regular ) != EFileOpenResult::Ok ) {
+			return false;
+		}
+
+		UPtr cWritten = 0;
+		const Bool bWritten =
+			sysfs_write( f, src.pointer(), src.num(), cWritten ) == EFileIOResult::Ok &&
+			cWritten == src.num();
+
+		sysfs_close( f );
+		return bWritten;
+	}
+
+	template< typename T >
+	static Bool appendRaw( TMutArr<U8> &dst, const T &x )
+	{
+		return dst.append( sizeof( T ), reinterpret_cast< const U8 * >( &x ) );
+	}
+
+	ETokenCacheResult loadTokenCache( const Str &cacheDir, Source &src, EVersion ver, CCompilerArena &arena, IdentDictionary &dict, CProgramData &progData )
+	{
+		if( cacheDir.isEmpty() ) {
+			return ETokenCacheResult::Miss;
+		}
+
+		const Str buffer( src.buffer );
+		const U64 uSourceHash = hashSource( buffer );
+
+		MutStr filename;
+		if( !getCacheFilename( filename, cacheDir, uSourceHash ) ) {
+			return ETokenCacheResult::Miss;
+		}
+
+		TMutArr<U8> image;
+		if( !readCacheFile( image, filename ) ) {
+			return ETokenCacheResult::Miss;
+		}
+
+		//
+		//	Check the whole file before touching the source or tables
+		//
+
+		STokenCacheHeader hdr;
+		memcpy( &hdr, image.pointer(), sizeof( hdr ) );
+
+		if( hdr.uMagic != kTokenCacheMagic || hdr.uFormat != kTokenCacheFormat || hdr.uVersion != U16( ver ) ) {
+			return ETokenCacheResult::Miss;
+		}
+		if( hdr.uSourceHash != uSourceHash || hdr.cSourceBytes != buffer.len() ) {
+			return ETokenCacheResult::Miss;
+		}
+
+		const U64 cExpectedBytes =
+			U64( sizeof( STokenCacheHeader ) ) +
+			U64( hdr.cTokens )*sizeof( SToken ) +
+			U64( hdr.cIdents )*sizeof( STokenCacheIdent ) +
+			U64( hdr.cStringBytes ) +
+			U64( hdr.cLexStateBytes );
+		if( cExpectedBytes != U64( image.num() ) ) {
+			return ETokenCacheResult::Miss;
+		}
+
+		const U8 *const pTokenData = image.pointer() + sizeof( STokenCacheHeader );
+		const U8 *const pIdentData = pTokenData + UPtr( hdr.cTokens )*sizeof( SToken );
+		const U8 *const pStringData = pIdentData + UPtr( hdr.cIdents )*sizeof( STokenCacheIdent );
+		const U8 *const pLexStateData = pStringData + hdr.cStringBytes;
+
+		for( U32 i = 0; i < hdr.cIdents; ++i ) {
+			STokenCacheIdent ident;
+			memcpy( &ident, pIdentData + i*sizeof( ident ), sizeof( ident ) );
+
+			if( !ident.cNameBytes || U64( ident.uNameOffset ) + ident.cNameBytes > buffer.len() ) {
+				return ETokenCacheResult::Miss;
+			}
+		}
+
+		for( U32 i = 0; i < hdr.cTokens; ++i ) {
+			SToken tok;
+			memcpy( &tok, pTokenData + i*sizeof( tok ), sizeof( tok ) );
+
+			if( tok.getOffset() + tok.getLength() > buffer.len() ) {
+				return ETokenCacheResult::Miss;
+			}
+			if( tok.hasIdent() && tok.value.i >= hdr.cIdents ) {
+				return ETokenCacheResult::Miss;
+			}
+		}
+
+		{
+			UPtr uOffset = 0;
+			for( U32 i = 0; i < hdr.cStrings; ++i ) {
+				if( uOffset + 2 > hdr.cStringBytes ) {
+					return ETokenCacheResult::Miss;
+				}
+
+				U16 cBytes;
+				memcpy( &cBytes, pStringData + uOffset, 2 );
+
+				uOffset += 2 + cBytes;
+				if( uOffset > hdr.cStringBytes ) {
+					return ETokenCacheResult::Miss;
+				}
+			}
+
+			if( uOffset != hdr.cStringBytes ) {
+				return ETokenCacheResult::Miss;
+			}
+		}
+
+		{
+			UPtr uOffset = 0;
+			for( U32 i = 0; i < hdr.cLexStates; ++i ) {
+				if( uOffset + sizeof( STokenCacheLexState ) > hdr.cLexStateBytes ) {
+					return ETokenCacheResult::Miss;
+				}
+
+				STokenCacheLexState state;
+				memcpy( &state, pLexStateData + uOffset, sizeof( state ) );
+
+				if( state.uToken >= hdr.cTokens || state.uResume > buffer.len() ) {
+					return ETokenCacheResult::Miss;
+				}
+				if( state.nextToken.getOffset() + state.nextToken.getLength() > buffer.len() ) {
+					return ETokenCacheResult::Miss;
+				}
+
+				uOffset += sizeof( state );
+				if( state.cBalance > hdr.cLexStateBytes - uOffset ) {
+					return ETokenCacheResult::Miss;
+				}
+
+				for( U32 j = 0; j < state.cBalance; ++j ) {
+					if( pLexStateData[ uOffset + j ] >= SLexerState::kNumBalances ) {
+						return ETokenCacheResult::Miss;
+					}
+				}
+
+				uOffset += state.cBalance;
+			}
+
+			if( uOffset != hdr.cLexStateBytes ) {
+				return ETokenCacheResult::Miss;
+			}
+		}
+
+		//
+		//	Rebuild what the lexer would have produced
+		//
+
+		TMutArr<Ident *> pIdents;
+		if( !AX_VERIFY_MEMORY( pIdents.resize( hdr.cIdents ) ) ) {
+			return ETokenCacheResult::Failed;
+		}
+
+		for( U32 i = 0; i < hdr.cIdents; ++i ) {
+			STokenCacheIdent ident;
+			memcpy( &ident, pIdentData + i*sizeof( ident ), sizeof( ident ) );
+
+			const Str name( buffer.get() + ident.uNameOffset, buffer.get() + ident.uNameOffset + ident.cNameBytes );
+
+			IdentDictionary::SEntry *const pEntry = dict.lookup( name );
+			if( !AX_VERIFY_MEMORY( pEntry ) ) {
+				return ETokenCacheResult::Failed;
+			}
+
+			if( !pEntry->pData ) {
+				// Keywords are already in the dictionary
+				if( ident.bKeyword ) {
+					return ETokenCacheResult::Miss;
+				}
+
+				if( !AX_VERIFY_MEMORY( pEntry->pData = DOLL__SCRIPTOBJ_NEW( arena ) Ident( src.getContext() ) ) ) {
+					return ETokenCacheResult::Failed;
+				}
+
+				if( !AX_VERIFY_MEMORY( ( pEntry->pData->name = arena.copyStr( name ) ).isUsed() ) ) {
+					return ETokenCacheResult::Failed;
+				}
+			} else if( pEntry->pData->isKeyword != !!ident.bKeyword || ( ident.bKeyword && pEntry->pData->keyword != ident.uKeyword ) ) {
+				return ETokenCacheResult::Miss;
+			}
+
+			pIdents[ i ] = pEntry->pData;
+		}
+
+		if( !AX_VERIFY_MEMORY( src.tokens.resize( hdr.cTokens ) ) ) {
+			return ETokenCacheResult::Failed;
+		}
+
+		for( U32 i = 0; i < hdr.cTokens; ++i ) {
+			SToken &tok = src.tokens[ i ];
+			memcpy( &tok, pTokenData + i*sizeof( tok ), sizeof( tok ) );
+
+			tok.setSourceIndex( src.index );
+			if( tok.hasIdent() ) {
+				const UPtr uIdent = UPtr( tok.value.i );
+				tok.value.p = pIdents[ uIdent ];
+			}
+		}
+
+		{
+			UPtr uOffset = 0;
+			for( U32 i = 0; i < hdr.cStrings; ++i ) {
+				U16 cBytes;
+				memcpy( &cBytes, pStringData + uOffset, 2 );
+
+				const char *const s = reinterpret_cast< const char * >( pStringData + uOffset + 2 );
+				if( !AX_VERIFY_MEMORY( progData.addString( Str( s, s + cBytes ) ) ) ) {
+					src.tokens.clear();
+					return ETokenCacheResult::Failed;
+				}
+
+				uOffset += 2 + cBytes;
+			}
+		}
+
+		// editSource() restarts the lexer from these
+		src.lexStates.clear();
+		if( !AX_VERIFY_MEMORY( src.lexStates.reserve( hdr.cLexStates ) ) ) {
+			src.tokens.clear();
+			return ETokenCacheResult::Failed;
+		}
+
+		{
+			UPtr uOffset = 0;
+			for( U32 i = 0; i < hdr.cLexStates; ++i ) {
+				STokenCacheLexState cached;
+				memcpy( &cached, pLexStateData + uOffset, sizeof( cached ) );
+				uOffset += sizeof( cached );
+
+				SLexerState state;
+				state.uToken     = cached.uToken;
+				state.uResume    = cached.uResume;
+				state.nextToken  = cached.nextToken;
+				state.nextToken.setSourceIndex( src.index );
+				state.nextToken.value = src.tokens[ cached.uToken ].value;
+				state.stateFlags = cached.stateFlags;
+				for( unsigned j = 0; j < SLexerState::kNumBalances; ++j ) {
+					state.nestingLevels[ j ] = cached.nestingLevels[ j ];
+				}
+
+				for( U32 j = 0; j < cached.cBalance; ++j ) {
+					if( !AX_VERIFY_MEMORY( state.balance.push( pLexStateData[ uOffset + j ] ) ) ) {
+						src.tokens.clear();
+						src.lexStates.clear();
+						return ETokenCacheResult::Failed;
+					}
+				}
+				uOffset += cached.cBalance;
+
+				if( !AX_VERIFY_MEMORY( src.lexStates.append( state ) ) ) {
+					src.tokens.clear();
+					src.lexStates.clear();
+					return ETokenCacheResult::Failed;
+				}
+			}
+		}
+
+		return ETokenCacheResult::Hit;
+	}
+
+	Bool saveTokenCache( const Str &cacheDir, const Source &src, EVersion ver, const CProgramData &progData )
+	{
+		if( cacheDir.isEmpty() ) {
+			return false;
+		}
+
+		const Str buffer( src.buffer );
+
+		// Index of each distinct identifier, through an open-addressed table
+		// keyed by pointer (sized for at most half full)
+		UPtr cSlots = 64;
+		while( cSlots < src.tokens.num()*2 ) {
+			cSlots *= 2;
+		}
+
+		TMutArr<const Ident *> pSlotIdents;
+		TMutArr<U32>           slotIndexes;
+		if( !AX_VERIFY_MEMORY( pSlotIdents.resize( cSlots ) ) || !AX_VERIFY_MEMORY( slotIndexes.resize( cSlots ) ) ) {
+			return false;
+		}
+		for( const Ident *&pIdent : pSlotIdents ) {
+			pIdent = nullptr;
+		}
+
+		STokenCacheHeader hdr;
+		hdr.uMagic         = kTokenCacheMagic;
+		hdr.uFormat        = kTokenCacheFormat;
+		hdr.uVersion       = U16( ver );
+		hdr.uSourceHash    = hashSource( buffer );
+		hdr.cSourceBytes   = U32( buffer.len() );
+		hdr.cTokens        = U32( src.tokens.num() );
+		hdr.cIdents        = 0;
+		hdr.cStrings       = U32( progData.getStringCount() );
+		hdr.cStringBytes   = 0;
+		hdr.cLexStates     = U32( src.lexStates.num() );
+		hdr.cLexStateBytes = 0;
+
+		TMutArr<U8> tokenData;
+		TMutArr<U8> identData;
+		if( !AX_VERIFY_MEMORY( tokenData.reserve( src.tokens.num()*sizeof( SToken ) ) ) ) {
+			return false;
+		}
+
+		for( const SToken &srcTok : src.tokens ) {
+			SToken tok = srcTok;
+
+			if( tok.hasIdent() ) {
+				const Ident *const pIdent = tok.value.p;
+				if( !pIdent ) {
+					return false;
+				}
+
+				UPtr uSlot = ( ( UPtr( pIdent )>>4 )*2654435761U ) & ( cSlots - 1 );
+				while( pSlotIdents[ uSlot ] != nullptr && pSlotIdents[ uSlot ] != pIdent ) {
+					uSlot = ( uSlot + 1 ) & ( cSlots - 1 );
+				}
+
+				if( !pSlotIdents[ uSlot ] ) {
+					STokenCacheIdent ident;
+
+					const Str name( pIdent->name );
+					if( name.isEmpty() || name.len() > 0xFFFF ) {
+						return false;
+					}
+
+					// Names are copies, but each appears in the text of the
+					// token (a keyword's token is its name; other tokens can
+					// put a sigil or brackets around it)
+					const char *const pLexan = buffer.get() + tok.getOffset();
+					UPtr uNameOffset = ~UPtr( 0 );
+					for( UPtr j = 0; j + name.len() <= tok.getLength(); ++j ) {
+						if( memcmp( pLexan + j, name.get(), name.len() ) == 0 ) {
+							uNameOffset = tok.getOffset() + j;
+							break;
+						}
+					}
+					if( uNameOffset == ~UPtr( 0 ) ) {
+						return false;
+					}
+
+					ident.uNameOffset = U32( uNameOffset );
+
+					ident.cNameBytes = U16( name.len() );
+					ident.bKeyword   = pIdent->isKeyword ? 1 : 0;
+					ident.uKeyword   = pIdent->isKeyword ? U8( pIdent->keyword ) : 0;
+
+					if( !AX_VERIFY_MEMORY( appendRaw( identData, ident ) ) ) {
+						return false;
+					}
+
+					pSlotIdents[ uSlot ] = pIdent;
+					slotIndexes[ uSlot ] = hdr.cIdents++;
+				}
+
+				tok.value.i = slotIndexes[ uSlot ];
+			}
+
+			if( !AX_VERIFY_MEMORY( appendRaw( tokenData, tok ) ) ) {
+				return false;
+			}
+		}
+
+		TMutArr<U8> stringData;
+		for( UPtr i = 0; i < progData.getStringCount(); ++i ) {
+			const Str s( progData.getString( i ) );
+
+			// Lengths are stored in 16 bits; such sources just aren't cached
+			if( s.len() > 0xFFFF ) {
+				return false;
+			}
+			const U16 cBytes = U16( s.len() );
+
+			if( !AX_VERIFY_MEMORY( appendRaw( stringData, cBytes ) ) ) {
+				return false;
+			}
+			if( !AX_VERIFY_MEMORY( stringData.append( s.len(), reinterpret_cast< const U8 * >( s.get() ) ) ) ) {
+				return false;
+			}
+		}
+		hdr.cStringBytes = U32( stringData.num() );
+
+		TMutArr<U8> lexStateData;
+		for( const SLexerState &state : src.lexStates ) {
+			STokenCacheLexState cached;
+			cached.uToken     = state.uToken;
+			cached.uResume    = state.uResume;
+			cached.nextToken  = state.nextToken;
+			cached.nextToken.value.i = 0;
+			cached.stateFlags = state.stateFlags;
+			for( unsigned j = 0; j < SLexerState::kNumBalances; ++j ) {
+				cached.nestingLevels[ j ] = state.nestingLevels[ j ];
+			}
+			cached.cBalance   = U32( state.balance.num() );
+
+			if( !AX_VERIFY_MEMORY( appendRaw( lexStateData, cached ) ) ) {
+				return false;
+			}
+
+			// The stack only gives up its entries from the top, so pop a copy
+			// into place from the end
+			const UPtr uBalanceStart = lexStateData.num();
+			if( !AX_VERIFY_MEMORY( lexStateData.resize( uBalanceStart + cached.cBalance ) ) ) {
+				return false;
+			}
+
+			TValueStack<SLexerState::kNumBalances> balance( state.balance );
+			for( U32 j = cached.cBalance; j > 0; --j ) {
+				lexStateData[ uBalanceStart + j - 1 ] = U8( balance.top() );
+				balance.pop();
+			}
+		}
+		hdr.cLexStateBytes = U32( lexStateData.num() );
+
+		TMutArr<U8> image;
+		if( !AX_VERIFY_MEMORY( image.reserve( sizeof( hdr ) + tokenData.num() + identData.num() + stringData.num() + lexStateData.num() ) ) ) {
+			return false;
+		}
+
+		const Bool bBuilt =
+			appendRaw( image, hdr ) &&
+			image.append( tokenData.num(), tokenData.pointer() ) &&
+			image.append( identData.num(), identData.pointer() ) &&
+			image.append( stringData.num(), stringData.pointer() ) &&
+			image.append( lexStateData.num(), lexStateData.pointer() );
+		if( !AX_VERIFY_MEMORY( bBuilt ) ) {
+			return false;
+		}
+
+		MutStr filename;
+		if( !getCacheFilename( filename, cacheDir, hdr.uSourceHash ) ) {
+			return false;
+		}
+
+		return writeCacheFile( filename, image );
+	}
+
+	Bool getTokenCacheFilename( MutStr &dst, const Str &cacheDir, const Source &src )
+	{
+		return getCacheFilename( dst, cacheDir, hashSource( Str( src.buffer ) ) );
+	}
+
+}}
@@ -39,6 +39,7 @@ namespace doll
 	MWidgets::MWidgets()
 	: m_widgets()
 	, m_refreshWidgets()
+	, m_pickIndex()
 	, m_pHoverWidget( nullptr )
 	, m_pWidgetLayer( nullptr )
 	{
@@ -108,6 +109,11 @@ namespace doll
 		for( IWidget *pWidget = m_refreshWidgets.head(); pWidget != nullptr; pWidget = pNextWidget ) {
 			pNextWidget = pWidget->m_refreshLink.next();
 
+			if( !pWidget->isShown() ) {
+				pWidget->validate();
+				continue;
+			}
+
 			if( pWidget->m_pLayer != nullptr ) {
 				gfx_setCurrentLayer( pWidget->m_pLayer );
 				gfx_clearQueue();
@@ -158,56 +164,27 @@ namespace doll
 		return false;
 	}
 
-	struct SWidgetPickData
-	{
-		static constexpr U32 kMaxStack = 32;
-
-		SIntVector2 posStack[ kMaxStack ] = {};
-		U32         uStackIndex           = 0;
-		IWidget *   pPicked               = nullptr;
-	};
-	static EWidgetVisitResult DOLL_API pickWidget_f( IWidget *pWidget, IWidget *pParent, Void *pVisitData )
+	IWidget *MWidgets::pick( const SIntVector2 &pos ) const
 	{
-		AX_PUSH_DISABLE_WARNING_MSVC(6386) // There is no buffer overrun
+		IWidget *pPicked = nullptr;
 
-		AX_ASSERT_NOT_NULL( pVisitData );
+		// Each level only considers the subwidgets of the widget picked at the
+		// level above, with `localPos` relative to that widget
+		const CWidgetIndex *pIndex = &m_pickIndex;
+		SIntVector2 localPos( pos );
 
-		SWidgetPickData &data = *reinterpret_cast< SWidgetPickData * >( pVisitData );
-		AX_ASSERT( data.uStackIndex < SWidgetPickData::kMaxStack );
-
-		if( data.pPicked != nullptr && pParent != data.pPicked ) {
-			return EWidgetVisitResult::Break;
-		}
-
-		const SIntVector2 &pos = data.posStack[ data.uStackIndex ];
-		const Bool bPicked = pWidget->pick( pos - pWidget->localToGlobal() );
-
-		if( !bPicked ) {
-			return EWidgetVisitResult::Continue;
-		}
-
-		data.pPicked = pWidget;
+		for(;;) {
+			IWidget *const pWidget = pIndex->pick( localPos );
+			if( !pWidget ) {
+				break;
+			}
 
-		if( data.uStackIndex + 1 < SWidgetPickData::kMaxStack ) {
-			// 6386: buffer overrun ('writable size is 256 bytes, but 264 bytes might be written')
-			data.posStack[ ++data.uStackIndex ] = pos;
-			return EWidgetVisitResult::Recurse;
+			pPicked = pWidget;
+			localPos -= pWidget->getPosition();
+			pIndex = &pWidget->m_childIndex;
 		}
 
-		return EWidgetVisitResult::Break;
-
-		AX_POP_DISABLE_WARNING_MSVC()
-	}
-	IWidget *MWidgets::pick( const SIntVector2 &pos ) const
-	{
-		SWidgetPickData data;
-
-		data.posStack[ 0 ] = pos;
-		data.uStackIndex   = 0;
-		data.pPicked       = nullptr;
-
-		visit( &pickWidget_f, data );
-		return data.pPicked;
+		return pPicked;
 	}
 
 	EWndReply MWidgets::onKeyPress( EKey key, U32 mods, Bool isRepeat )
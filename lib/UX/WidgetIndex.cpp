@@ -0,0 +1,426 @@
+#include "../BuildSettings.hpp"
+#include "doll/UX/WidgetIndex.hpp"
+#include "doll/UX/Widget.hpp"
+
+namespace doll
+{
+
+	static inline SRect unite( const SRect &a, const SRect &b )
+	{
+		return SRect
+		(
+			a.x1 < b.x1 ? a.x1 : b.x1,
+			a.y1 < b.y1 ? a.y1 : b.y1,
+			a.x2 > b.x2 ? a.x2 : b.x2,
+			a.y2 > b.y2 ? a.y2 : b.y2
+		);
+	}
+	static inline S64 perimeter( const SRect &r )
+	{
+		return 2*( S64( r.x2 ) - S64( r.x1 ) + S64( r.y2 ) - S64( r.y1 ) );
+	}
+	// Same convention as `WBaseWidget::pick()`: the far edges are exclusive
+	static inline Bool containsPoint( const SRect &r, const SIntVector2 &pos )
+	{
+		return pos.x >= r.x1 && pos.y >= r.y1 && pos.x < r.x2 && pos.y < r.y2;
+	}
+
+	CWidgetIndex::CWidgetIndex()
+	: m_pNodes( nullptr )
+	, m_cNodes( 0 )
+	, m_cCapacity( 0 )
+	, m_uRoot( kNull )
+	, m_uFreeList( kNull )
+	, m_cLeaves( 0 )
+	, m_uLastOrder( 0 )
+	{
+	}
+	CWidgetIndex::~CWidgetIndex()
+	{
+		AX_ASSERT( m_cLeaves == 0 );
+
+		if( m_pNodes != nullptr ) {
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pNodes );
+			m_pNodes = nullptr;
+		}
+	}
+
+	Bool CWidgetIndex::reserveNodes( U32 cNodes )
+	{
+		if( m_cNodes + cNodes <= m_cCapacity ) {
+			return true;
+		}
+
+		U32 cNewCapacity = m_cCapacity < 8 ? 8 : m_cCapacity*2;
+		while( cNewCapacity < m_cNodes + cNodes ) {
+			cNewCapacity *= 2;
+		}
+
+		SNode *const pNewNodes = reinterpret_cast< SNode * >( DOLL_ALLOC( *DOLL__DEFAULT_ALLOCATOR, sizeof( SNode )*cNewCapacity, kTag_UX ) );
+		if( !AX_VERIFY_MEMORY( pNewNodes ) ) {
+			return false;
+		}
+
+		if( m_pNodes != nullptr ) {
+			memcpy( ( Void * )pNewNodes, ( const Void * )m_pNodes, sizeof( SNode )*m_cNodes );
+			DOLL_DEALLOC( *DOLL__DEFAULT_ALLOCATOR, ( Void * )m_pNodes );
+		}
+
+		m_pNodes = pNewNodes;
+		m_cCapacity = cNewCapacity;
+
+		return true;
+	}
+	U32 CWidgetIndex::allocNode()
+	{
+		U32 uNode = m_uFreeList;
+		if( uNode != kNull ) {
+			m_uFreeList = m_pNodes[ uNode ].uParent;
+		} else {
+			AX_ASSERT( m_cNodes < m_cCapacity );
+			uNode = m_cNodes++;
+		}
+
+		SNode &node = m_pNodes[ uNode ];
+
+		node.box       = SRect();
+		node.uMinOrder = 0;
+		node.pWidget   = nullptr;
+		node.uParent   = kNull;
+		node.uChild1   = kNull;
+		node.uChild2   = kNull;
+		node.iHeight   = 0;
+
+		return uNode;
+	}
+	Void CWidgetIndex::freeNode( U32 uNode )
+	{
+		AX_ASSERT( uNode < m_cNodes );
+
+		SNode &node = m_pNodes[ uNode ];
+
+		node.pWidget = nullptr;
+		node.uParent = m_uFreeList;
+		node.iHeight = -1;
+
+		m_uFreeList = uNode;
+	}
+
+	U32 CWidgetIndex::insert( IWidget *pWidget, const SRect &shape, U64 uOrder )
+	{
+		AX_ASSERT_NOT_NULL( pWidget );
+
+		// The leaf and the branch joining it to the tree
+		if( !reserveNodes( 2 ) ) {
+			return kNull;
+		}
+
+		const U32 uLeaf = allocNode();
+
+		SNode &leaf = m_pNodes[ uLeaf ];
+
+		leaf.box       = shape.fixed();
+		leaf.uMinOrder = uOrder;
+		leaf.pWidget   = pWidget;
+
+		insertLeaf( uLeaf );
+		++m_cLeaves;
+
+		return uLeaf;
+	}
+	Void CWidgetIndex::remove( U32 uLeaf )
+	{
+		AX_ASSERT( uLeaf < m_cNodes );
+		AX_ASSERT( m_pNodes[ uLeaf ].isLeaf() );
+		AX_ASSERT( m_cLeaves > 0 );
+
+		removeLeaf( uLeaf );
+		freeNode( uLeaf );
+
+		--m_cLeaves;
+	}
+	Void CWidgetIndex::update( U32 uLeaf, const SRect &shape )
+	{
+		AX_ASSERT( uLeaf < m_cNodes );
+		AX_ASSERT( m_pNodes[ uLeaf ].isLeaf() );
+
+		const SRect box( shape.fixed() );
+		if( m_pNodes[ uLeaf ].box == box ) {
+			return;
+		}
+
+		removeLeaf( uLeaf );
+		m_pNodes[ uLeaf ].box = box;
+		insertLeaf( uLeaf );
+	}
+
+	Void CWidgetIndex::insertLeaf( U32 uLeaf )
+	{
+		if( m_uRoot == kNull ) {
+			m_uRoot = uLeaf;
+			m_pNodes[ uLeaf ].uParent = kNull;
+			return;
+		}
+
+		const SRect leafBox( m_pNodes[ uLeaf ].box );
+
+		// Find the sibling that grows the tree's total perimeter the least
+		U32 uIndex = m_uRoot;
+		while( !m_pNodes[ uIndex ].isLeaf() ) {
+			const SNode &node = m_pNodes[ uIndex ];
+
+			const S64 combined = perimeter( unite( node.box, leafBox ) );
+
+			const S64 cost = 2*combined;
+			const S64 inheritCost = 2*( combined - perimeter( node.box ) );
+
+			const SNode &child1 = m_pNodes[ node.uChild1 ];
+			const SNode &child2 = m_pNodes[ node.uChild2 ];
+
+			S64 cost1 = perimeter( unite( leafBox, child1.box ) ) + inheritCost;
+			if( !child1.isLeaf() ) {
+				cost1 -= perimeter( child1.box );
+			}
+			S64 cost2 = perimeter( unite( leafBox, child2.box ) ) + inheritCost;
+			if( !child2.isLeaf() ) {
+				cost2 -= perimeter( child2.box );
+			}
+
+			if( cost < cost1 && cost < cost2 ) {
+				break;
+			}
+
+			uIndex = cost1 < cost2 ? node.uChild1 : node.uChild2;
+		}
+
+		const U32 uSibling = uIndex;
+		const U32 uOldParent = m_pNodes[ uSibling ].uParent;
+
+		// Space was reserved by `insert()`; `update()` reuses the branch
+		// that `removeLeaf()` just freed
+		const U32 uNewParent = allocNode();
+
+		SNode &newParent = m_pNodes[ uNewParent ];
+		newParent.uParent = uOldParent;
+		newParent.uChild1 = uSibling;
+		newParent.uChild2 = uLeaf;
+		refit( uNewParent );
+
+		if( uOldParent != kNull ) {
+			SNode &oldParent = m_pNodes[ uOldParent ];
+			if( oldParent.uChild1 == uSibling ) {
+				oldParent.uChild1 = uNewParent;
+			} else {
+				oldParent.uChild2 = uNewParent;
+			}
+		} else {
+			m_uRoot = uNewParent;
+		}
+
+		m_pNodes[ uSibling ].uParent = uNewParent;
+		m_pNodes[ uLeaf ].uParent = uNewParent;
+
+		fixUpwards( m_pNodes[ uLeaf ].uParent );
+	}
+	Void CWidgetIndex::removeLeaf( U32 uLeaf )
+	{
+		if( uLeaf == m_uRoot ) {
+			m_uRoot = kNull;
+			return;
+		}
+
+		const U32 uParent = m_pNodes[ uLeaf ].uParent;
+		AX_ASSERT( uParent != kNull );
+
+		const U32 uGrandParent = m_pNodes[ uParent ].uParent;
+		const U32 uSibling =
+			m_pNodes[ uParent ].uChild1 == uLeaf
+			? m_pNodes[ uParent ].uChild2
+			: m_pNodes[ uParent ].uChild1;
+
+		if( uGrandParent != kNull ) {
+			SNode &grandParent = m_pNodes[ uGrandParent ];
+			if( grandParent.uChild1 == uParent ) {
+				grandParent.uChild1 = uSibling;
+			} else {
+				grandParent.uChild2 = uSibling;
+			}
+			m_pNodes[ uSibling ].uParent = uGrandParent;
+			freeNode( uParent );
+
+			fixUpwards( uGrandParent );
+		} else {
+			m_uRoot = uSibling;
+			m_pNodes[ uSibling ].uParent = kNull;
+			freeNode( uParent );
+		}
+
+		m_pNodes[ uLeaf ].uParent = kNull;
+	}
+
+	Void CWidgetIndex::refit( U32 uNode )
+	{
+		SNode &node = m_pNodes[ uNode ];
+		const SNode &child1 = m_pNodes[ node.uChild1 ];
+		const SNode &child2 = m_pNodes[ node.uChild2 ];
+
+		node.box       = unite( child1.box, child2.box );
+		node.uMinOrder = child1.uMinOrder < child2.uMinOrder ? child1.uMinOrder : child2.uMinOrder;
+		node.iHeight   = 1 + ( child1.iHeight > child2.iHeight ? child1.iHeight : child2.iHeight );
+	}
+	Void CWidgetIndex::fixUpwards( U32 uNode )
+	{
+		while( uNode != kNull ) {
+			uNode = balance( uNode );
+			refit( uNode );
+			uNode = m_pNodes[ uNode ].uParent;
+		}
+	}
+
+	// Rotate `uA` with the taller of its children if the two sides differ in
+	// height by more than one; returns the node now occupying A's position
+	U32 CWidgetIndex::balance( U32 uA )
+	{
+		SNode *const A = &m_pNodes[ uA ];
+		if( A->isLeaf() || A->iHeight < 2 ) {
+			return uA;
+		}
+
+		const U32 uB = A->uChild1;
+		const U32 uC = A->uChild2;
+		SNode *const B = &m_pNodes[ uB ];
+		SNode *const C = &m_pNodes[ uC ];
+
+		const S32 iBalance = C->iHeight - B->iHeight;
+
+		// Rotate C up
+		if( iBalance > 1 ) {
+			const U32 uF = C->uChild1;
+			const U32 uG = C->uChild2;
+			SNode *const F = &m_pNodes[ uF ];
+			SNode *const G = &m_pNodes[ uG ];
+
+			C->uChild1 = uA;
+			C->uParent = A->uParent;
+			A->uParent = uC;
+
+			if( C->uParent != kNull ) {
+				SNode &P = m_pNodes[ C->uParent ];
+				if( P.uChild1 == uA ) {
+					P.uChild1 = uC;
+				} else {
+					P.uChild2 = uC;
+				}
+			} else {
+				m_uRoot = uC;
+			}
+
+			if( F->iHeight > G->iHeight ) {
+				C->uChild2 = uF;
+				A->uChild2 = uG;
+				G->uParent = uA;
+			} else {
+				C->uChild2 = uG;
+				A->uChild2 = uF;
+				F->uParent = uA;
+			}
+
+			refit( uA );
+			refit( uC );
+			return uC;
+		}
+
+		// Rotate B up
+		if( iBalance < -1 ) {
+			const U32 uD = B->uChild1;
+			const U32 uE = B->uChild2;
+			SNode *const D = &m_pNodes[ uD ];
+			SNode *const E = &m_pNodes[ uE ];
+
+			B->uChild1 = uA;
+			B->uParent = A->uParent;
+			A->uParent = uB;
+
+			if( B->uParent != kNull ) {
+				SNode &P = m_pNodes[ B->uParent ];
+				if( P.uChild1 == uA ) {
+					P.uChild1 = uB;
+				} else {
+					P.uChild2 = uB;
+				}
+			} else {
+				m_uRoot = uB;
+			}
+
+			if( D->iHeight > E->iHeight ) {
+				B->uChild2 = uD;
+				A->uChild1 = uE;
+				E->uParent = uA;
+			} else {
+				B->uChild2 = uE;
+				A->uChild1 = uD;
+				D->uParent = uA;
+			}
+
+			refit( uA );
+			refit( uB );
+			return uB;
+		}
+
+		return uA;
+	}
+
+	IWidget *CWidgetIndex::pick( const SIntVector2 &pos ) const
+	{
+		if( m_uRoot == kNull ) {
+			return nullptr;
+		}
+
+		// The tree is kept height-balanced, so its depth stays well below
+		// this even with 2^32 nodes
+		static constexpr U32 kMaxStack = 64;
+
+		U32 stack[ kMaxStack ];
+		U32 cStack = 0;
+
+		IWidget *pBest = nullptr;
+		U64 uBestOrder = ~U64( 0 );
+
+		stack[ cStack++ ] = m_uRoot;
+		while( cStack > 0 ) {
+			const SNode &node = m_pNodes[ stack[ --cStack ] ];
+
+			if( node.uMinOrder >= uBestOrder || !containsPoint( node.box, pos ) ) {
+				continue;
+			}
+
+			if( node.isLeaf() ) {
+				AX_ASSERT_NOT_NULL( node.pWidget );
+
+				if( node.pWidget->pick( pos - SIntVector2( node.box.x1, node.box.y1 ) ) ) {
+					pBest = node.pWidget;
+					uBestOrder = node.uMinOrder;
+				}
+
+				continue;
+			}
+
+			AX_ASSERT( cStack + 2 <= kMaxStack );
+
+			// Visit the child holding the earlier sibling first so later
+			// siblings can be culled by `uBestOrder`
+			U32 uFirst = node.uChild1;
+			U32 uSecond = node.uChild2;
+			if( m_pNodes[ uSecond ].uMinOrder < m_pNodes[ uFirst ].uMinOrder ) {
+				uFirst = node.uChild2;
+				uSecond = node.uChild1;
+			}
+
+			stack[ cStack++ ] = uSecond;
+			stack[ cStack++ ] = uFirst;
+		}
+
+		return pBest;
+	}
+
+}
@@ -5,38 +5,301 @@
 
 #include "doll/Math/Basic.hpp"
 
+#include <atomic>
+#include <new>
+
 namespace doll
 {
 
-	U64                        CFrameCounter::guCurrentTick = 0;
-	TIntrList< CFrameCounter > CFrameCounter::gFrameCounters;
-	ax::CQuickMutex            CFrameCounter::gListAccessor;
+	/*
+	===========================================================================
+
+		COUNTER REGISTRY
+
+		Counter state lives in a structure-of-arrays table, split into fixed
+		size pages, so updateAll() can stream each field linearly instead of
+		chasing a linked list of heap objects. Pages are never moved or
+		released once committed, so a slot index stays valid for as long as
+		the counter holding it.
+
+		Slots are handed out from a lock-free (tagged) free stack, and the
+		page mutex is only taken to commit a new page. Nothing else locks.
+
+		A destroyed counter's slot is retired rather than freed: its callback
+		is cleared and it goes onto a second lock-free stack, which updateAll()
+		moves onto the free stack once its pass is over. So a slot is never
+		handed out again while a pass may still be reading it, and destroying
+		a counter never waits for an update. (A pass already under way when a
+		counter is destroyed may still call its callback once, so the
+		parameter must stay valid until that updateAll() returns.)
+
+		The callback, its parameter and the curve type are written under a
+		per-slot sequence count; updateAll() skips a slot for that frame if
+		it was being written while read, so it always sees them as a set.
+
+	===========================================================================
+	*/
+
+	static const U32 kCounterPageShift = 10;
+	static const U32 kCounterPageSize  = U32( 1 )<<kCounterPageShift;
+	static const U32 kCounterPageMask  = kCounterPageSize - 1;
+	static const U32 kMaxCounterPages  = 256;
+	static const U32 kMaxCounters      = kCounterPageSize*kMaxCounterPages;
+
+	struct SCounterPage
+	{
+		// Hot: read by updateAll() every frame
+		U64                     uStart      [ kCounterPageSize ];
+		U64                     uEnd        [ kCounterPageSize ];
+		F64                     fCurrent    [ kCounterPageSize ];
+		F64                     fRange      [ kCounterPageSize ][ 2 ];
+		FnCalculateFrameCounter pfnCalculate[ kCounterPageSize ];
+		Void *                  pParm       [ kCounterPageSize ];
+		U8                      uType       [ kCounterPageSize ];
+		U8                      uMode       [ kCounterPageSize ];
+
+		// Odd while the callback, parameter and type are being written
+		std::atomic< U32 >      uCalcSeq    [ kCounterPageSize ];
+
+		// Cold: only touched when a slot is acquired or released
+		U32                     uGeneration [ kCounterPageSize ];
+		std::atomic< U32 >      uNextFree   [ kCounterPageSize ];
+	};
+
+	static std::atomic< SCounterPage * > g_counterPages[ kMaxCounterPages ];
+	// Slots handed out so far (high-water mark); updateAll() stops here
+	static std::atomic< U32 >            g_cCounterSlots( 0 );
+	static std::atomic< U32 >            g_cLiveCounters( 0 );
+	// Tops of the free and retired stacks: ( tag<<32 ) | ( slot + 1 ); zero
+	// slot means empty
+	static std::atomic< U64 >            g_counterFreeHead( 0 );
+	static std::atomic< U64 >            g_counterRetiredHead( 0 );
+	// Odd while updateAll() is making a pass
+	static std::atomic< U32 >            g_counterUpdateEpoch( 0 );
+	static ax::CQuickMutex               g_counterPageLock;
+
+	U64 CFrameCounter::guCurrentTick = 0;
+
+	static inline SCounterPage &counterPage( U32 uSlot )
+	{
+		SCounterPage *const pPage = g_counterPages[ uSlot>>kCounterPageShift ].load( std::memory_order_acquire );
+		AX_ASSERT_NOT_NULL( pPage );
+		return *pPage;
+	}
+
+	static Bool commitCounterPage( U32 uPage )
+	{
+		if( g_counterPages[ uPage ].load( std::memory_order_acquire ) != nullptr ) {
+			return true;
+		}
+
+		g_counterPageLock.lock();
+
+		Bool bResult = true;
+		if( !g_counterPages[ uPage ].load( std::memory_order_relaxed ) ) {
+			Void *const p = DOLL_ALLOC( *DOLL__HEAP_ALLOCATOR, sizeof( SCounterPage ), kTag_Counter );
+			if( AX_VERIFY_MEMORY( p ) ) {
+				// Value-initialization zeroes every field
+				g_counterPages[ uPage ].store( new( p ) SCounterPage(), std::memory_order_release );
+			} else {
+				bResult = false;
+			}
+		}
+
+		g_counterPageLock.unlock();
+		return bResult;
+	}
+
+	static Void pushCounterSlot( std::atomic< U64 > &head, U32 uSlot )
+	{
+		SCounterPage &page = counterPage( uSlot );
+		const U32 uIndex = uSlot & kCounterPageMask;
+
+		U64 uHead = head.load( std::memory_order_relaxed );
+		U64 uNewHead;
+		do {
+			page.uNextFree[ uIndex ].store( U32( uHead ), std::memory_order_relaxed );
+			uNewHead = ( ( ( uHead>>32 ) + 1 )<<32 ) | U64( uSlot + 1 );
+		} while( !head.compare_exchange_weak( uHead, uNewHead, std::memory_order_release, std::memory_order_relaxed ) );
+	}
+	static Bool popFreeCounterSlot( U32 &uSlot )
+	{
+		U64 uHead = g_counterFreeHead.load( std::memory_order_acquire );
+		U64 uNewHead;
+		do {
+			if( U32( uHead ) == 0 ) {
+				return false;
+			}
+
+			// The tag in the upper half keeps a recycled top from passing the
+			// exchange (ABA); a stale next link is then simply retried
+			const U32 uTop = U32( uHead ) - 1;
+			const U32 uNext = counterPage( uTop ).uNextFree[ uTop & kCounterPageMask ].load( std::memory_order_relaxed );
+			uNewHead = ( ( ( uHead>>32 ) + 1 )<<32 ) | U64( uNext );
+		} while( !g_counterFreeHead.compare_exchange_weak( uHead, uNewHead, std::memory_order_acquire, std::memory_order_acquire ) );
+
+		uSlot = U32( uHead ) - 1;
+		return true;
+	}
+
+	// Push each slot of a list taken off one of the stacks (by its top link)
+	static Void pushCounterSlots( std::atomic< U64 > &head, U32 uLink )
+	{
+		while( uLink != 0 ) {
+			const U32 uSlot = uLink - 1;
+			uLink = counterPage( uSlot ).uNextFree[ uSlot & kCounterPageMask ].load( std::memory_order_relaxed );
+
+			pushCounterSlot( head, uSlot );
+		}
+	}
+	// Move every retired slot onto the free stack
+	static Void recycleRetiredCounterSlots()
+	{
+		pushCounterSlots( g_counterFreeHead, U32( g_counterRetiredHead.exchange( 0, std::memory_order_acquire ) ) );
+	}
+	// Recycle the retired slots now if no update pass is running (for when
+	// the table is full and updateAll() hasn't been called lately)
+	static Bool tryRecycleRetiredCounterSlots()
+	{
+		const U32 uEpoch = g_counterUpdateEpoch.load( std::memory_order_acquire );
+		if( uEpoch & 1 ) {
+			return false;
+		}
+
+		const U32 uRetired = U32( g_counterRetiredHead.exchange( 0, std::memory_order_acquire ) );
+		if( !uRetired ) {
+			return false;
+		}
+
+		// A pass started meanwhile may be reading them; put them back for it
+		// to recycle when it's done
+		if( g_counterUpdateEpoch.load( std::memory_order_acquire ) != uEpoch ) {
+			pushCounterSlots( g_counterRetiredHead, uRetired );
+			return false;
+		}
+
+		pushCounterSlots( g_counterFreeHead, uRetired );
+		return true;
+	}
+
+	static Bool acquireCounterSlot( U32 &uSlot )
+	{
+		if( popFreeCounterSlot( uSlot ) ) {
+			return true;
+		}
+
+		const U32 uNewSlot = g_cCounterSlots.load( std::memory_order_relaxed );
+		if( uNewSlot >= kMaxCounters ) {
+			return tryRecycleRetiredCounterSlots() && popFreeCounterSlot( uSlot );
+		}
+
+		// Commit the page before publishing the slot through the high-water
+		// mark so updateAll() never sees a slot without backing storage
+		if( !commitCounterPage( uNewSlot>>kCounterPageShift ) ) {
+			return false;
+		}
+
+		U32 uExpected = uNewSlot;
+		if( g_cCounterSlots.compare_exchange_strong( uExpected, uNewSlot + 1, std::memory_order_acq_rel ) ) {
+			uSlot = uNewSlot;
+			return true;
+		}
+
+		// Lost the race; somebody else took that slot so try again
+		return acquireCounterSlot( uSlot );
+	}
+
+	static Void resetCounterSlot( SCounterPage &page, U32 uIndex )
+	{
+		page.uStart      [ uIndex ]    = 0;
+		page.uEnd        [ uIndex ]    = 0;
+		page.fCurrent    [ uIndex ]    = 0.0;
+		page.fRange      [ uIndex ][0] = 0.0;
+		page.fRange      [ uIndex ][1] = 1.0;
+		page.pfnCalculate[ uIndex ]    = NULL;
+		page.pParm       [ uIndex ]    = NULL;
+		page.uType       [ uIndex ]    = U8( EFrameCounter::UserCallback );
+		page.uMode       [ uIndex ]    = U8( EFrameCounterMode::Normal );
+	}
+
+	// Write the callback, parameter and type so updateAll() sees them together
+	static Void setCounterCalculate( SCounterPage &page, U32 uIndex, FnCalculateFrameCounter pfnCalculate, Void *pParm, EFrameCounter type )
+	{
+		std::atomic< U32 > &seq = page.uCalcSeq[ uIndex ];
+		const U32 uSeq = seq.load( std::memory_order_relaxed );
+
+		seq.store( uSeq + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+
+		page.pfnCalculate[ uIndex ] = pfnCalculate;
+		page.pParm       [ uIndex ] = pParm;
+		page.uType       [ uIndex ] = U8( type );
+
+		seq.store( uSeq + 2, std::memory_order_release );
+	}
+
+	static SCounterPage g_deadCounterPage;
+	static const U32 kDeadCounterSlot = ~U32( 0 );
 
 	CFrameCounter::CFrameCounter()
-	: mpfnCalculate( NULL )
-	, mpParm( NULL )
-	, mMode( EFrameCounterMode::Normal )
-	, muStart( 0 )
-	, muEnd( 0 )
-	, mfCurrent( 0.0 )
-	, mSiblings( this )
 	{
-		mfRange[ 0 ] = 0.0;
-		mfRange[ 1 ] = 1.0;
+		mHandle.uIndex = 0;
+		mHandle.uGeneration = 0;
 
-		{
-			gListAccessor.lock();
-			gFrameCounters.addTail( mSiblings );
-			gListAccessor.unlock();
+		U32 uSlot;
+		if( !AX_VERIFY_MSG( acquireCounterSlot( uSlot ), "Out of frame counter slots" ) ) {
+			return;
 		}
+
+		SCounterPage &page = counterPage( uSlot );
+		const U32 uIndex = uSlot & kCounterPageMask;
+
+		resetCounterSlot( page, uIndex );
+
+		mHandle.uIndex = uSlot + 1;
+		mHandle.uGeneration = page.uGeneration[ uIndex ] & internal::HandleImpl::kGenMask;
+
+		g_cLiveCounters.fetch_add( 1, std::memory_order_relaxed );
 	}
 	CFrameCounter::~CFrameCounter()
 	{
-		gListAccessor.lock();
-		gFrameCounters.unlink( mSiblings );
-		gListAccessor.unlock();
+		if( !mHandle.uIndex ) {
+			return;
+		}
+
+		const U32 uSlot = slot();
+		SCounterPage &page = counterPage( uSlot );
+		const U32 uIndex = uSlot & kCounterPageMask;
+
+		// Passes from here on skip the slot; it's only handed out again once
+		// the pass that may be running now is over
+		setCounterCalculate( page, uIndex, NULL, NULL, EFrameCounter::UserCallback );
+		++page.uGeneration[ uIndex ];
+
+		mHandle.uIndex = 0;
+
+		pushCounterSlot( g_counterRetiredHead, uSlot );
+		g_cLiveCounters.fetch_sub( 1, std::memory_order_relaxed );
+	}
+
+	U32 CFrameCounter::slot() const
+	{
+		if( !mHandle.uIndex ) {
+			return kDeadCounterSlot;
+		}
+
+		const U32 uSlot = U32( mHandle.uIndex ) - 1;
+		AX_ASSERT_MSG( ( counterPage( uSlot ).uGeneration[ uSlot & kCounterPageMask ] & internal::HandleImpl::kGenMask ) == mHandle.uGeneration, "Stale frame counter handle" );
+
+		return uSlot;
 	}
 
+	// Counters that failed to get a slot read and write a scratch page instead
+#define DOLL__COUNTER_FIELD( Field_ )\
+	( uSlot_ != kDeadCounterSlot ? counterPage( uSlot_ ) : g_deadCounterPage ).Field_[ uSlot_ & kCounterPageMask ]
+#define DOLL__COUNTER_SLOT()\
+	const U32 uSlot_ = slot()
+
 	static F64 DOLL_API calcLinear_f( Void *, F64 fValue, F64 )
 	{
 		return fValue;
@@ -67,77 +330,75 @@ namespace doll
 
 	Void CFrameCounter::setType( EFrameCounter type )
 	{
+		DOLL__COUNTER_SLOT();
+
+		FnCalculateFrameCounter pfnCalculate = NULL;
 		switch( type )
 		{
 		case EFrameCounter::UserCallback:
-			mpfnCalculate = NULL;
-			mpParm = NULL;
+			pfnCalculate = NULL;
 			break;
 
 		case EFrameCounter::Linear:
-			mpfnCalculate = &calcLinear_f;
-			mpParm = NULL;
+			pfnCalculate = &calcLinear_f;
 			break;
 
 		case EFrameCounter::Slerp:
-			mpfnCalculate = &calcSlerp_f;
-			mpParm = NULL;
+			pfnCalculate = &calcSlerp_f;
 			break;
 
 		case EFrameCounter::Accel:
-			mpfnCalculate = &calcAccel_f;
-			mpParm = NULL;
+			pfnCalculate = &calcAccel_f;
 			break;
 		case EFrameCounter::Decel:
-			mpfnCalculate = &calcDecel_f;
-			mpParm = NULL;
+			pfnCalculate = &calcDecel_f;
 			break;
 		case EFrameCounter::AccelDecel:
-			mpfnCalculate = &calcAccelDecel_f;
-			mpParm = NULL;
+			pfnCalculate = &calcAccelDecel_f;
 			break;
 		}
+
+		if( uSlot_ != kDeadCounterSlot ) {
+			setCounterCalculate( counterPage( uSlot_ ), uSlot_ & kCounterPageMask, pfnCalculate, NULL, type );
+		}
 	}
 	EFrameCounter CFrameCounter::getType() const
 	{
-		if( mpfnCalculate == &calcLinear_f ) {
-			return EFrameCounter::Linear;
-		}
-		if( mpfnCalculate == &calcSlerp_f ) {
-			return EFrameCounter::Slerp;
-		}
-		if( mpfnCalculate == &calcAccel_f ) {
-			return EFrameCounter::Accel;
-		}
-		if( mpfnCalculate == &calcDecel_f ) {
-			return EFrameCounter::Decel;
-		}
-		if( mpfnCalculate == &calcAccelDecel_f ) {
-			return EFrameCounter::AccelDecel;
-		}
+		DOLL__COUNTER_SLOT();
 
-		return EFrameCounter::UserCallback;
+		return EFrameCounter( DOLL__COUNTER_FIELD( uType ) );
 	}
 
 	Void CFrameCounter::setMode( EFrameCounterMode mode )
 	{
-		mMode = mode;
+		DOLL__COUNTER_SLOT();
+
+		DOLL__COUNTER_FIELD( uMode ) = U8( mode );
 	}
 	EFrameCounterMode CFrameCounter::getMode() const
 	{
-		return mMode;
+		DOLL__COUNTER_SLOT();
+
+		return EFrameCounterMode( DOLL__COUNTER_FIELD( uMode ) );
 	}
 
 	F64 CFrameCounter::getValue() const
 	{
-		return mfCurrent;
+		DOLL__COUNTER_SLOT();
+
+		return DOLL__COUNTER_FIELD( fCurrent );
 	}
 	Bool CFrameCounter::isActive() const
 	{
-		const U64 uElapsed = muStart - guCurrentTick;
-		const U64 uTotal = muEnd - muStart;
+		DOLL__COUNTER_SLOT();
 
-		switch( mMode )
+		const U64 uStart = DOLL__COUNTER_FIELD( uStart );
+		const U64 uEnd = DOLL__COUNTER_FIELD( uEnd );
+
+		const U64 uElapsed = uStart - guCurrentTick;
+		const U64 uTotal = uEnd - uStart;
+
+		switch( EFrameCounterMode( DOLL__COUNTER_FIELD( uMode ) ) )
 		{
 		case EFrameCounterMode::Normal:
 		case EFrameCounterMode::Clamp:
@@ -157,30 +418,43 @@ namespace doll
 
 	Void CFrameCounter::setCalculateCallback( FnCalculateFrameCounter pfnCalculate, Void *pParameter )
 	{
-		mpfnCalculate = pfnCalculate;
-		mpParm = pParameter;
+		DOLL__COUNTER_SLOT();
+
+		if( uSlot_ != kDeadCounterSlot ) {
+			setCounterCalculate( counterPage( uSlot_ ), uSlot_ & kCounterPageMask, pfnCalculate, pParameter, EFrameCounter::UserCallback );
+		}
 	}
 	FnCalculateFrameCounter CFrameCounter::getCalculateFunction() const
 	{
-		return mpfnCalculate;
+		DOLL__COUNTER_SLOT();
+
+		return DOLL__COUNTER_FIELD( pfnCalculate );
 	}
 	Void *CFrameCounter::getCalculateParameter() const
 	{
-		return mpParm;
+		DOLL__COUNTER_SLOT();
+
+		return DOLL__COUNTER_FIELD( pParm );
 	}
 
 	Void CFrameCounter::setRange( F64 fStart, F64 fEnd )
 	{
-		mfRange[ 0 ] = fStart;
-		mfRange[ 1 ] = fEnd;
+		DOLL__COUNTER_SLOT();
+
+		DOLL__COUNTER_FIELD( fRange )[ 0 ] = fStart;
+		DOLL__COUNTER_FIELD( fRange )[ 1 ] = fEnd;
 	}
 	F64 CFrameCounter::getRangeStart() const
 	{
-		return mfRange[ 0 ];
+		DOLL__COUNTER_SLOT();
+
+		return DOLL__COUNTER_FIELD( fRange )[ 0 ];
 	}
 	F64 CFrameCounter::getRangeEnd() const
 	{
-		return mfRange[ 1 ];
+		DOLL__COUNTER_SLOT();
+
+		return DOLL__COUNTER_FIELD( fRange )[ 1 ];
 	}
 
 	Void CFrameCounter::activate( F64 fTimeInSeconds )
@@ -189,13 +463,25 @@ namespace doll
 	}
 	Void CFrameCounter::activateMicroseconds( U64 uTimeInMicroseconds )
 	{
-		muStart = guCurrentTick;
-		muEnd = muStart + uTimeInMicroseconds;
+		DOLL__COUNTER_SLOT();
+
+		DOLL__COUNTER_FIELD( uStart ) = guCurrentTick;
+		DOLL__COUNTER_FIELD( uEnd ) = guCurrentTick + uTimeInMicroseconds;
 	}
 	Void CFrameCounter::deactivate()
 	{
-		muStart = 0;
-		muEnd = 0;
+		DOLL__COUNTER_SLOT();
+
+		DOLL__COUNTER_FIELD( uStart ) = 0;
+		DOLL__COUNTER_FIELD( uEnd ) = 0;
+	}
+
+#undef DOLL__COUNTER_SLOT
+#undef DOLL__COUNTER_FIELD
+
+	U32 CFrameCounter::getLiveCount()
+	{
+		return g_cLiveCounters.load( std::memory_order_relaxed );
 	}
 
 	static F64 calculateValueFromMode( EFrameCounterMode Mode, F64 fElapsed )
@@ -250,37 +536,85 @@ namespace doll
 		return 0.0;
 	}
 
-	Void CFrameCounter::update()
+	static Void updateCounterPage( SCounterPage &page, U32 cSlots, U64 uTick )
 	{
-		// avoid division by zero and uninitialized counters
-		if( muEnd == muStart || !mpfnCalculate ) {
-			return;
+		F64 fElapsed[ kCounterPageSize ];
+
+		// amount of time that has passed in terms of how far along each
+		// counter is; branch-free over plain arrays so the compiler can
+		// vectorize it (inactive slots get a dummy divisor of one)
+		for( U32 i = 0; i < cSlots; ++i ) {
+			const U64 uTotal = page.uEnd[ i ] - page.uStart[ i ];
+			const U64 uDivisor = uTotal + U64( uTotal == 0 );
+
+			fElapsed[ i ] = F64( uTick - page.uStart[ i ] )/F64( uDivisor );
 		}
 
-		// amount of time that has passed in microseconds
-		const U64 uElapsed = guCurrentTick - muStart;
-		// amount of time that has passed in terms of how far along this counter is
-		const F64 fElapsed = F64( uElapsed )/F64( muEnd - muStart );
+		for( U32 i = 0; i < cSlots; ++i ) {
+			// read the callback, its parameter and the type once; if they were
+			// being changed meanwhile, leave the counter be until next frame
+			const U32 uSeq = page.uCalcSeq[ i ].load( std::memory_order_acquire );
+
+			const FnCalculateFrameCounter pfnCalculate = page.pfnCalculate[ i ];
+			Void *const pParm = page.pParm[ i ];
+			const EFrameCounter type = EFrameCounter( page.uType[ i ] );
+
+			std::atomic_thread_fence( std::memory_order_acquire );
+			if( ( uSeq & 1 ) != 0 || page.uCalcSeq[ i ].load( std::memory_order_relaxed ) != uSeq ) {
+				continue;
+			}
 
-		// adjusted elapsed time value based on the mode
-		const F64 fValue = calculateValueFromMode( mMode, fElapsed );
+			// avoid division by zero and uninitialized counters
+			if( page.uEnd[ i ] == page.uStart[ i ] || !pfnCalculate ) {
+				continue;
+			}
 
-		// calculate the new value
-		const F64 fcalculated = mpfnCalculate( mpParm, fValue, mfCurrent );
+			// adjusted elapsed time value based on the mode
+			const F64 fValue = calculateValueFromMode( EFrameCounterMode( page.uMode[ i ] ), fElapsed[ i ] );
 
-		// store the new value
-		mfCurrent = mfRange[ 0 ] + fcalculated*( mfRange[ 1 ] - mfRange[ 0 ] );
+			// calculate the new value; built-in curves are evaluated inline
+			F64 fCalculated;
+			switch( type )
+			{
+			case EFrameCounter::Linear:
+				fCalculated = fValue;
+				break;
+			case EFrameCounter::Accel:
+				fCalculated = fValue*fValue;
+				break;
+			default:
+				fCalculated = pfnCalculate( pParm, fValue, page.fCurrent[ i ] );
+				break;
+			}
+
+			// store the new value
+			const F64 fStart = page.fRange[ i ][ 0 ];
+			page.fCurrent[ i ] = fStart + fCalculated*( page.fRange[ i ][ 1 ] - fStart );
+		}
 	}
 
 	Void CFrameCounter::updateAll()
 	{
-		guCurrentTick = microseconds();
+		const U64 uTick = microseconds();
+		guCurrentTick = uTick;
 
-		gListAccessor.lock();
-		for( CFrameCounter *pCounter = gFrameCounters.head(); pCounter != nullptr; pCounter = pCounter->mSiblings.next() ) {
-			pCounter->update();
+		g_counterUpdateEpoch.fetch_add( 1, std::memory_order_acq_rel );
+
+		const U32 cSlots = g_cCounterSlots.load( std::memory_order_acquire );
+		for( U32 uBase = 0; uBase < cSlots; uBase += kCounterPageSize ) {
+			SCounterPage *const pPage = g_counterPages[ uBase>>kCounterPageShift ].load( std::memory_order_acquire );
+			if( !pPage ) {
+				continue;
+			}
+
+			const U32 cPageSlots = cSlots - uBase < kCounterPageSize ? cSlots - uBase : kCounterPageSize;
+			updateCounterPage( *pPage, cPageSlots, uTick );
 		}
-		gListAccessor.unlock();
+
+		g_counterUpdateEpoch.fetch_add( 1, std::memory_order_acq_rel );
+
+		// nothing reads the slots retired so far any more
+		recycleRetiredCounterSlots();
 	}
 
 }
@@ -0,0 +1,152 @@
+#pragma once
+
+// Shared by the tests (tests/), benchmarks (bench/) and tools (tools/)
+//
+// Each of those is a single translation unit built against Doll's internals
+// (see DOLL_BUILD_TESTS in the top-level CMakeLists.txt), so everything here
+// is header-only.
+
+#include "doll/Core/Defs.hpp"
+#include "doll/Front/Frontend.hpp"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace doll
+{
+
+	namespace test
+	{
+
+		struct STestState
+		{
+			U32 cChecks   = 0;
+			U32 cFailures = 0;
+		};
+		inline STestState &state()
+		{
+			static STestState s;
+			return s;
+		}
+
+		// Record the result of a check, reporting it if it failed
+		inline Bool check( Bool bPassed, const char *pszExpr, const char *pszFile, int iLine )
+		{
+			STestState &s = state();
+
+			++s.cChecks;
+			if( !bPassed ) {
+				++s.cFailures;
+				fprintf( stderr, "%s(%i): check failed: %s\n", pszFile, iLine, pszExpr );
+				fflush( stderr );
+			}
+
+			return bPassed;
+		}
+
+		// Print a summary; the result is the process exit code
+		inline int finish( const char *pszName )
+		{
+			const STestState &s = state();
+
+			printf( "%s: %u/%u checks passed\n", pszName, s.cChecks - s.cFailures, s.cChecks );
+			fflush( stdout );
+
+			return s.cFailures != 0 ? 1 : 0;
+		}
+
+		// Deterministic pseudo-random numbers, so runs are comparable
+		struct SRandom
+		{
+			U32 uState;
+
+			inline U32 next()
+			{
+				uState = uState*1664525 + 1013904223;
+				return uState>>8;
+			}
+			// Uniform in [iMin, iMax)
+			inline S32 range( S32 iMin, S32 iMax )
+			{
+				return iMin + S32( next()%U32( iMax - iMin ) );
+			}
+		};
+
+		// Initializes the engine as a console app (file system, async IO and
+		// config; no window, graphics or sound) for as long as it's in scope
+		struct SConsoleApp
+		{
+			Bool bInitialized;
+
+			SConsoleApp()
+			: bInitialized( doll_initConsoleApp() )
+			{
+			}
+			~SConsoleApp()
+			{
+				if( bInitialized ) {
+					doll_fini();
+				}
+			}
+		};
+
+		// Wall clock time in seconds (only meaningful as a difference)
+		inline F64 seconds()
+		{
+			typedef std::chrono::steady_clock Clock;
+			return std::chrono::duration< F64 >( Clock::now().time_since_epoch() ).count();
+		}
+
+		// Whether `pszArg` was passed on the command line
+		inline Bool hasArg( int argc, char **argv, const char *pszArg )
+		{
+			for( int i = 1; i < argc; ++i ) {
+				if( strcmp( argv[ i ], pszArg ) == 0 ) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// Value following `pszArg` on the command line, or `pszDefault`
+		inline const char *argValue( int argc, char **argv, const char *pszArg, const char *pszDefault = nullptr )
+		{
+			for( int i = 1; i + 1 < argc; ++i ) {
+				if( strcmp( argv[ i ], pszArg ) == 0 ) {
+					return argv[ i + 1 ];
+				}
+			}
+
+			return pszDefault;
+		}
+
+		// Benchmarks run a shortened workload when passed `--quick` (as they
+		// are under ctest) so they double as smoke tests
+		inline Bool isQuickRun( int argc, char **argv )
+		{
+			return hasArg( argc, argv, "--quick" );
+		}
+
+		// Benchmark output: one aligned line per measurement
+		inline Void report( const char *pszName, F64 fValue, const char *pszUnit )
+		{
+			printf( "  %-40s %14.3f %s\n", pszName, fValue, pszUnit );
+			fflush( stdout );
+		}
+
+		// Keep the optimizer from discarding a result that is otherwise unused
+		template< typename T >
+		inline Void keep( T x )
+		{
+			static volatile F64 s_fSink;
+			s_fSink = F64( x );
+		}
+
+	}
+
+}
+
+#define DOLL_CHECK( Expr_ )\
+	doll::test::check( !!( Expr_ ), #Expr_, __FILE__, __LINE__ )
@@ -0,0 +1,125 @@
+#pragma once
+
+// Synthetic dialogue scripts for the script tests and benchmarks
+//
+// Each scene is a label followed by dialogue (speaker lines and messages,
+// some of them repeated verbatim across the script, as short replies are in
+// real scripts), a variable, a call and an `if`/`else` that jumps to the
+// next scene. Everything generated lexes and parses without diagnostics.
+
+#include "DollTest.hpp"
+
+#include "doll/IO/VFS.hpp"
+
+#include <string>
+
+namespace doll
+{
+
+	namespace test
+	{
+
+		static const char *const kScriptSpeakers[] = {
+			"Alice", "Bob", "Narrator", "Mysterious Voice", "Shopkeeper", "Captain Reyes"
+		};
+		static const char *const kScriptWords[] = {
+			"the", "old", "lighthouse", "was", "quiet", "tonight", "and", "nobody",
+			"could", "remember", "why", "we", "came", "here", "in", "first",
+			"place", "maybe", "it", "is", "time", "to", "go", "home", "but",
+			"storm", "has", "not", "passed", "yet", "listen", "waves", "keep",
+			"calling", "names", "of", "those", "who", "left", "before", "us"
+		};
+		static const char *const kScriptReplies[] = {
+			"Yes.", "No.", "I see.", "...", "Are you sure?", "Let's go.",
+			"Wait for me!", "Hm.", "That can't be right.", "Thank you."
+		};
+
+		inline Void appendScriptSentence( std::string &dst, SRandom &rng )
+		{
+			// A third of the lines are stock replies (duplicate strings)
+			if( rng.next()%3 == 0 ) {
+				dst += kScriptReplies[ rng.next()%arraySize( kScriptReplies ) ];
+				return;
+			}
+
+			const U32 cWords = 6 + rng.next()%10;
+			for( U32 i = 0; i < cWords; ++i ) {
+				const char *const pszWord = kScriptWords[ rng.next()%arraySize( kScriptWords ) ];
+
+				if( i == 0 ) {
+					dst += char( pszWord[ 0 ] >= 'a' && pszWord[ 0 ] <= 'z' ? pszWord[ 0 ] - 'a' + 'A' : pszWord[ 0 ] );
+					dst += pszWord + 1;
+				} else {
+					dst += ' ';
+					dst += pszWord;
+				}
+			}
+
+			dst += rng.next()%4 == 0 ? "?" : ".";
+		}
+
+		inline Void appendScriptScene( std::string &dst, U32 uScene, SRandom &rng )
+		{
+			char szBuf[ 256 ];
+
+			axspf( szBuf, "*scene_%u\n", uScene );
+			dst += szBuf;
+
+			axspf( szBuf, "var mood_%u = %u * 3 + ( %u - 1 )\n", uScene, rng.next()%100, uScene%17 );
+			dst += szBuf;
+
+			const U32 cLines = 3 + rng.next()%6;
+			for( U32 i = 0; i < cLines; ++i ) {
+				axspf( szBuf, "@\"%s\"\n", kScriptSpeakers[ rng.next()%arraySize( kScriptSpeakers ) ] );
+				dst += szBuf;
+
+				dst += i%4 == 3 ? "< " : "> ";
+				appendScriptSentence( dst, rng );
+				dst += '\n';
+			}
+
+			axspf( szBuf, "wait( %u, \"fade\" )\n", 100 + rng.next()%900 );
+			dst += szBuf;
+
+			axspf( szBuf, "if mood_%u > 50 {\n", uScene );
+			dst += szBuf;
+			dst += "\t> ";
+			appendScriptSentence( dst, rng );
+			dst += '\n';
+			dst += "} else {\n";
+			axspf( szBuf, "\tgoto *scene_%u\n", uScene + 1 );
+			dst += szBuf;
+			dst += "}\n\n";
+		}
+
+		// A script of at least `cMinBytes` bytes
+		inline std::string makeDialogueScript( UPtr cMinBytes, U32 uSeed = 1 )
+		{
+			std::string script;
+			script.reserve( cMinBytes + 1024 );
+
+			SRandom rng = { uSeed };
+			for( U32 uScene = 0; script.size() < cMinBytes; ++uScene ) {
+				appendScriptScene( script, uScene, rng );
+			}
+
+			return script;
+		}
+
+		// Write `text` to a file through the VFS (needs an SConsoleApp)
+		inline Bool writeTextFile( const Str &filename, const std::string &text )
+		{
+			IFile *const pFile = fs_open( filename, kFileOpenF_W | kFileOpenF_Recreate );
+			if( !pFile ) {
+				return false;
+			}
+
+			const Bool bWritten = fs_write( pFile, text.data(), text.size() ) == text.size();
+			fs_close( pFile );
+
+			return bWritten;
+		}
+
+	}
+
+}
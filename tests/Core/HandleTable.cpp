@@ -0,0 +1,173 @@
+// Handle tables: a handle resolves to nullptr once its object is deleted,
+// even after another object takes the slot (which gets a new generation),
+// and freed slots are reused before new ones are handed out; the handle
+// commands of the C API behave the same way
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Core/Handle.hpp"
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/Texture.hpp"
+
+#include <vector>
+
+using namespace doll;
+
+// Four slots to a page, so a few objects span several pages
+struct SItem;
+typedef THandleTable< SItem, 0, 4 > ItemTable;
+
+struct SItem: public TPoolObject< SItem, 0, ItemTable >
+{
+	U32 uValue;
+
+	SItem( U32 uValue )
+	: uValue( uValue )
+	{
+	}
+
+	ItemTable::Handle getHandle() const
+	{
+		return getPool().handleOf( this );
+	}
+};
+
+static Void testTable()
+{
+	ItemTable &table = SItem::getPool();
+
+	// The null handle is all zeroes and resolves to nothing
+	const ItemTable::Handle hNull = ItemTable::Handle();
+	DOLL_CHECK( !hNull );
+	DOLL_CHECK( hNull == nullptr );
+	DOLL_CHECK( table.get( hNull ) == nullptr );
+	DOLL_CHECK( !table.isValid( hNull ) );
+	DOLL_CHECK( table.handleOf( nullptr ) == nullptr );
+
+	std::vector< SItem * > items;
+	std::vector< ItemTable::Handle > handles;
+	for( U32 i = 0; i < 10; ++i ) {
+		SItem *const pItem = new SItem( i );
+		if( !DOLL_CHECK( pItem != nullptr ) ) {
+			return;
+		}
+
+		items.push_back( pItem );
+		handles.push_back( pItem->getHandle() );
+	}
+
+	DOLL_CHECK( table.getLiveCount() == 10 );
+	DOLL_CHECK( table.getSlotCount() == 10 );
+
+	for( U32 i = 0; i < 10; ++i ) {
+		DOLL_CHECK( handles[ i ] != nullptr );
+		DOLL_CHECK( table.get( handles[ i ] ) == items[ i ] );
+		DOLL_CHECK( table.getBySlot( handles[ i ].uIndex - 1 ) == items[ i ] );
+	}
+
+	// Deleted objects resolve to nullptr
+	const ItemTable::Handle hThree = handles[ 3 ];
+	const ItemTable::Handle hSeven = handles[ 7 ];
+	delete items[ 3 ];
+	delete items[ 7 ];
+
+	DOLL_CHECK( table.get( hThree ) == nullptr );
+	DOLL_CHECK( table.get( hSeven ) == nullptr );
+	DOLL_CHECK( !table.isValid( hThree ) );
+	DOLL_CHECK( table.getBySlot( hThree.uIndex - 1 ) == nullptr );
+	DOLL_CHECK( table.getLiveCount() == 8 );
+	DOLL_CHECK( table.get( handles[ 4 ] ) == items[ 4 ] );
+
+	// The freed slots are taken again (most recently freed first) before any
+	// new one, each with a new generation
+	SItem *const pReuseA = new SItem( 100 );
+	SItem *const pReuseB = new SItem( 101 );
+	if( DOLL_CHECK( pReuseA != nullptr ) && DOLL_CHECK( pReuseB != nullptr ) ) {
+		const ItemTable::Handle hA = pReuseA->getHandle();
+		const ItemTable::Handle hB = pReuseB->getHandle();
+
+		DOLL_CHECK( hA.uIndex == hSeven.uIndex );
+		DOLL_CHECK( hB.uIndex == hThree.uIndex );
+		DOLL_CHECK( hA.uGeneration != hSeven.uGeneration );
+		DOLL_CHECK( hB.uGeneration != hThree.uGeneration );
+		DOLL_CHECK( hA != hSeven );
+		DOLL_CHECK( table.getSlotCount() == 10 );
+
+		// The old handles still don't resolve, to the new objects least of all
+		DOLL_CHECK( table.get( hSeven ) == nullptr );
+		DOLL_CHECK( table.get( hThree ) == nullptr );
+		DOLL_CHECK( table.get( hA ) == pReuseA );
+		DOLL_CHECK( table.get( hB ) == pReuseB );
+		DOLL_CHECK( pReuseA->uValue == 100 && pReuseB->uValue == 101 );
+
+		items[ 7 ] = pReuseA;
+		items[ 3 ] = pReuseB;
+	}
+
+	// Only once the free list is empty does the table grow
+	SItem *const pNew = new SItem( 102 );
+	if( DOLL_CHECK( pNew != nullptr ) ) {
+		DOLL_CHECK( pNew->getHandle().uIndex == 11 );
+		DOLL_CHECK( table.getSlotCount() == 11 );
+		items.push_back( pNew );
+	}
+
+	for( SItem *pItem : items ) {
+		delete pItem;
+	}
+
+	DOLL_CHECK( table.getLiveCount() == 0 );
+	for( const ItemTable::Handle &h : handles ) {
+		DOLL_CHECK( table.get( h ) == nullptr );
+	}
+}
+
+static Void testTextureHandles()
+{
+	const U32 texel = DOLL_RGB( 255, 255, 255 );
+
+	const HTexture hFirst = gfx_newTextureHandle( 1, 1, &texel, kTexFmtRGBA8 );
+	if( !DOLL_CHECK( hFirst != nullptr ) ) {
+		return;
+	}
+
+	DOLL_CHECK( gfx_isTextureHandleValid( hFirst ) );
+	DOLL_CHECK( gfx_getTextureFromHandle( hFirst ) != nullptr );
+	DOLL_CHECK( gfx_getTextureHandle( gfx_getTextureFromHandle( hFirst ) ) == hFirst );
+	DOLL_CHECK( gfx_getTextureResXByHandle( hFirst ) == 1 );
+
+	// Deleting hands back the null handle and leaves the old one dead
+	DOLL_CHECK( gfx_deleteTextureByHandle( hFirst ) == nullptr );
+	DOLL_CHECK( !gfx_isTextureHandleValid( hFirst ) );
+	DOLL_CHECK( gfx_getTextureFromHandle( hFirst ) == nullptr );
+	DOLL_CHECK( gfx_getTextureResXByHandle( hFirst ) == 0 );
+	DOLL_CHECK( gfx_deleteTextureByHandle( hFirst ) == nullptr );
+
+	// The next texture takes the slot under a new generation
+	const HTexture hSecond = gfx_newTextureHandle( 1, 1, &texel, kTexFmtRGBA8 );
+	if( DOLL_CHECK( hSecond != nullptr ) ) {
+		DOLL_CHECK( hSecond.uIndex == hFirst.uIndex );
+		DOLL_CHECK( hSecond != hFirst );
+		DOLL_CHECK( gfx_getTextureFromHandle( hFirst ) == nullptr );
+		DOLL_CHECK( gfx_getTextureFromHandle( hSecond ) != nullptr );
+
+		gfx_deleteTextureByHandle( hSecond );
+	}
+
+	DOLL_CHECK( gfx_getTextureHandle( nullptr ) == nullptr );
+}
+
+int main()
+{
+	testTable();
+
+	SCoreConfig conf;
+	conf.setResolution( 16, 16 );
+
+	if( DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		testTextureHandles();
+		doll_fini();
+	}
+
+	return test::finish( "Test-HandleTable" );
+}
@@ -0,0 +1,119 @@
+// Capture and replay: frames drawn headlessly on the software renderer are
+// recorded (starting after the first frame, so the capture has to recreate
+// the objects and state from before it), replayed on a second software
+// renderer, and must come out the same
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Capture.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+#include "doll/Gfx/Texture.hpp"
+#include "doll/IO/VFS.hpp"
+
+#include <vector>
+
+using namespace doll;
+
+static const char *const kCaptureFilename = "Test-CaptureReplay.dcap";
+
+static const U32 kResX = 128;
+static const U32 kResY = 96;
+
+static const U32 kFirstFrame = 1;
+static const U32 kCapturedFrames = 3;
+
+// Something different every frame: boxes that move and a textured quad
+static Void drawFrame( U32 uFrame, const RTexture *pTexture )
+{
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	gfx_clearQueue();
+
+	gfx_queClearRect( 0, 0, S32( kResX ), S32( kResY ), DOLL_RGB( 30, 30, 50 ) );
+
+	for( S32 i = 0; i < 6; ++i ) {
+		const S32 x = ( i*21 + S32( uFrame )*5 )%S32( kResX - 16 );
+
+		gfx_ink( DOLL_RGBA( 60 + i*30, 200 - i*25, 120, 255 - i*20 ) );
+		gfx_box( x, i*15 + 2, x + 16, i*15 + 14 );
+	}
+
+	gfx_stretchImage( pTexture, 40 + S32( uFrame ), 30, 48, 48 );
+}
+
+int main()
+{
+	SCoreConfig conf;
+	conf.setResolution( kResX, kResY );
+	conf.setCapture( kCaptureFilename, kFirstFrame, kCapturedFrames );
+
+	if( !DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		return test::finish( "Test-CaptureReplay" );
+	}
+
+	IGfxAPI &api = gfx_r_getFrame()->getContext();
+	CGfxAPI_Soft *const pRecordedAPI = gfx_getSoftAPI( gfx_getCapturedAPI( &api ) );
+
+	// Uploaded before the capture starts
+	std::vector< U32 > texels( 8*8 );
+	for( U32 i = 0; i < texels.size(); ++i ) {
+		texels[ i ] = ( i/8 + i%8 )%2 != 0 ? DOLL_RGB( 250, 240, 200 ) : DOLL_RGBA( 200, 40, 40, 200 );
+	}
+	RTexture *const pTexture = gfx_newTexture( 8, 8, texels.data(), kTexFmtRGBA8 );
+
+	std::vector< U32 > recorded;
+	U32 uResX = 0, uResY = 0;
+
+	if( DOLL_CHECK( gfx_getCapturedAPI( &api ) != &api ) && DOLL_CHECK( pRecordedAPI != nullptr ) && DOLL_CHECK( pTexture != nullptr ) ) {
+		for( U32 uFrame = 0; uFrame < kFirstFrame + kCapturedFrames + 2 && !gfx_isCaptureDone( &api ); ++uFrame ) {
+			drawFrame( uFrame, pTexture );
+			doll_sync();
+		}
+		DOLL_CHECK( gfx_isCaptureDone( &api ) );
+
+		// The last frame captured (nothing has been drawn since)
+		pRecordedAPI->getSize( uResX, uResY );
+		const U32 *const pPixels = pRecordedAPI->readback();
+		if( DOLL_CHECK( pPixels != nullptr ) ) {
+			recorded.assign( pPixels, pPixels + uResX*uResY );
+		}
+	}
+
+	// Replay on a second software renderer
+	IGfxAPIProvider *const pProvider = doll_findGfxAPIByName( "soft" );
+
+	SGfxInitDesc desc;
+	desc.apis      = TArr<IGfxAPIProvider *>( &pProvider, 1 );
+	desc.windowing = kGfxScreenModeWindowed;
+	desc.vsync     = 0;
+
+	IGfxAPI *const pReplayAPI = !recorded.empty() && DOLL_CHECK( pProvider != nullptr ) ? gfx_initAPI( OSWindow( 0 ), &desc ) : nullptr;
+	CGfxAPI_Soft *const pReplaySoftAPI = gfx_getSoftAPI( pReplayAPI );
+
+	if( DOLL_CHECK( pReplaySoftAPI != nullptr ) ) {
+		SGfxReplayStats stats;
+		DOLL_CHECK( gfx_replayCapture( *pReplayAPI, kCaptureFilename, &stats ) );
+
+		DOLL_CHECK( stats.cFrames == kCapturedFrames );
+		DOLL_CHECK( stats.calls[ kGfxCapPresent ].cCalls == kCapturedFrames );
+		// Including the texture, recreated from the contents it was created with
+		DOLL_CHECK( stats.calls[ kGfxCapCreateTexture ].cCalls > 0 );
+		DOLL_CHECK( stats.calls[ kGfxCapDraw ].cCalls + stats.calls[ kGfxCapDrawIndexed ].cCalls > 0 );
+
+		SSoftImageDiff diff;
+		if( !DOLL_CHECK( pReplaySoftAPI->compareImage( recorded.data(), uResX, uResY, 0, diff ) ) ) {
+			fprintf( stderr, "  %u of %u pixels differ (by up to %u), first at %u,%u%s\n",
+				diff.cMismatched, diff.cPixels, diff.uMaxDelta, diff.uFirstX, diff.uFirstY, diff.bSameSize ? "" : " -- the sizes differ" );
+		}
+	}
+
+	gfx_finiAPI( pReplayAPI );
+	if( pTexture != nullptr ) {
+		gfx_deleteTexture( pTexture );
+	}
+	fs_remove( kCaptureFilename );
+
+	doll_fini();
+	return test::finish( "Test-CaptureReplay" );
+}
@@ -0,0 +1,568 @@
+// Compact vertices: the primitive buffer draws each batch in the smallest
+// form every vertex fits (whole-pixel S16 or F16 positions within 1/32 of a
+// pixel, UNORM16 texture coordinates), falls back to wider forms for batches
+// that don't fit, and only tries a layout the API refused once. Batches are
+// drawn on the software renderer through a wrapper that records the layout
+// and vertex bytes of each draw, which are decoded and compared with what
+// was submitted.
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+#include "doll/Gfx/PrimitiveBuffer.hpp"
+#include "doll/Math/HalfFloat.hpp"
+
+#include <math.h>
+#include <vector>
+
+using namespace doll;
+
+typedef PrimitiveBuffer::Vertex SVertex;
+
+// Passes everything on to another API, recording the layouts created and
+// the draws made, and refusing layouts with UNORM16 texture coordinates on
+// request (as the GL backend always does)
+class CRecordingAPI : public IGfxAPI
+{
+  public:
+	struct SElement
+	{
+		EGfxLayoutElement type;
+		EVectorType       compTy;
+		UPtr              uOffset;
+	};
+	struct SDraw
+	{
+		UPtr                    stride;
+		std::vector< SElement > elements;
+		std::vector< U8 >       data;
+		U32                     cVerts;
+	};
+
+	Bool bRefuseUNorm16TexCoords;
+
+	U32 cLayoutsCreated;
+	U32 cLayoutsRefused;
+	std::vector< SDraw > draws;
+
+	CRecordingAPI( IGfxAPI &inner )
+	: IGfxAPI( inner.getAPIProvider() )
+	, bRefuseUNorm16TexCoords( false )
+	, cLayoutsCreated( 0 )
+	, cLayoutsRefused( 0 )
+	, draws()
+	, m_inner( inner )
+	, m_layouts()
+	, m_pLayout( nullptr )
+	, m_written()
+	{
+	}
+
+	virtual EGfxAPI getAPI() const override { return m_inner.getAPI(); }
+
+	virtual TArr<EShaderFormat> getSupportedShaderFormats() const override { return m_inner.getSupportedShaderFormats(); }
+	virtual TArr<EShaderStage> getSupportedShaderStages() const override { return m_inner.getSupportedShaderStages(); }
+
+	virtual Void setDefaultState( const Mat4f &proj ) override { m_inner.setDefaultState( proj ); }
+
+	virtual Void resize( U32 uResX, U32 uResY ) override { m_inner.resize( uResX, uResY ); }
+	virtual Void getSize( U32 &uResX, U32 &uResY ) override { m_inner.getSize( uResX, uResY ); }
+
+	virtual Void wsiPresent() override { m_inner.wsiPresent(); }
+
+	virtual IGfxAPISampler *createSampler( const SGfxSamplerDesc &desc ) override { return m_inner.createSampler( desc ); }
+	virtual Void destroySampler( IGfxAPISampler *p ) override { m_inner.destroySampler( p ); }
+
+	virtual IGfxAPITexture *createTexture( ETextureFormat fmt, U16 resX, U16 resY, const U8 *pData ) override { return m_inner.createTexture( fmt, resX, resY, pData ); }
+	virtual Void destroyTexture( IGfxAPITexture *p ) override { m_inner.destroyTexture( p ); }
+
+	virtual IGfxAPIRenderTarget *createRenderTarget( U16 resX, U16 resY ) override { return m_inner.createRenderTarget( resX, resY ); }
+	virtual Void destroyRenderTarget( IGfxAPIRenderTarget *p ) override { m_inner.destroyRenderTarget( p ); }
+	virtual IGfxAPITexture *getRenderTargetTexture( IGfxAPIRenderTarget *p ) override { return m_inner.getRenderTargetTexture( p ); }
+
+	virtual IGfxAPIVLayout *createLayout( const SGfxLayout &desc ) override
+	{
+		++cLayoutsCreated;
+
+		if( bRefuseUNorm16TexCoords ) {
+			for( UPtr i = 0; i < desc.cElements; ++i ) {
+				if( desc.elements[ i ].type == kGfxLayoutElementTexCoord && desc.elements[ i ].compTy == kVectorTypeU16_UNorm ) {
+					++cLayoutsRefused;
+					return nullptr;
+				}
+			}
+		}
+
+		IGfxAPIVLayout *const pLayout = m_inner.createLayout( desc );
+		if( pLayout != nullptr ) {
+			m_layouts.push_back( SLayout{ pLayout, &desc } );
+		}
+
+		return pLayout;
+	}
+	virtual Void destroyLayout( IGfxAPIVLayout *p ) override
+	{
+		for( UPtr i = 0; i < m_layouts.size(); ++i ) {
+			if( m_layouts[ i ].pAPIObj == p ) {
+				if( m_pLayout == m_layouts[ i ].pDesc ) {
+					m_pLayout = nullptr;
+				}
+				m_layouts.erase( m_layouts.begin() + i );
+				break;
+			}
+		}
+
+		m_inner.destroyLayout( p );
+	}
+
+	virtual IGfxAPIVBuffer *createVBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) override { return m_inner.createVBuffer( cBytes, pData, perf, purpose ); }
+	virtual IGfxAPIIBuffer *createIBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) override { return m_inner.createIBuffer( cBytes, pData, perf, purpose ); }
+	virtual IGfxAPIUBuffer *createUBuffer( UPtr cBytes, const Void *pData, EBufferPerformance perf, EBufferPurpose purpose ) override { return m_inner.createUBuffer( cBytes, pData, perf, purpose ); }
+	virtual Void destroyVBuffer( IGfxAPIVBuffer *p ) override { m_inner.destroyVBuffer( p ); }
+	virtual Void destroyIBuffer( IGfxAPIIBuffer *p ) override { m_inner.destroyIBuffer( p ); }
+	virtual Void destroyUBuffer( IGfxAPIUBuffer *p ) override { m_inner.destroyUBuffer( p ); }
+
+	virtual IGfxAPIShader *createShader( Str filename, EShaderFormat fmt, EShaderStage stage, UPtr cBytes, const Void *pData, IGfxDiagnostic *pDiag ) override { return m_inner.createShader( filename, fmt, stage, cBytes, pData, pDiag ); }
+	virtual IGfxAPIProgram *createProgram( TArr<IGfxAPIShader *> shaders, IGfxDiagnostic *pDiag ) override { return m_inner.createProgram( shaders, pDiag ); }
+	virtual Void destroyShader( IGfxAPIShader *p ) override { m_inner.destroyShader( p ); }
+	virtual Void destroyProgram( IGfxAPIProgram *p ) override { m_inner.destroyProgram( p ); }
+	virtual Bool setCacheDirectory( Str basePath ) override { return m_inner.setCacheDirectory( basePath ); }
+	virtual Str getCacheDirectory() const override { return m_inner.getCacheDirectory(); }
+	virtual Void invalidateShaderCache() override { m_inner.invalidateShaderCache(); }
+
+	virtual Void vsSetProjectionMatrix( const F32 *matrix ) override { m_inner.vsSetProjectionMatrix( matrix ); }
+	virtual Void vsSetModelViewMatrix( const F32 *matrix ) override { m_inner.vsSetModelViewMatrix( matrix ); }
+
+	virtual Void psoSetScissorEnable( Bool enable ) override { m_inner.psoSetScissorEnable( enable ); }
+	virtual Void psoSetTextureEnable( Bool enable ) override { m_inner.psoSetTextureEnable( enable ); }
+	virtual Void psoSetBlend( EBlendOp op, EBlendFactor colA, EBlendFactor colB, EBlendFactor alphaA, EBlendFactor alphaB ) override { m_inner.psoSetBlend( op, colA, colB, alphaA, alphaB ); }
+
+	virtual Void rsSetScissor( S32 posX, S32 posY, U32 resX, U32 resY ) override { m_inner.rsSetScissor( posX, posY, resX, resY ); }
+	virtual Void rsSetViewport( S32 posX, S32 posY, U32 resX, U32 resY ) override { m_inner.rsSetViewport( posX, posY, resX, resY ); }
+
+	virtual Void iaSetLayout( IGfxAPIVLayout *p ) override
+	{
+		m_pLayout = nullptr;
+		for( const SLayout &layout : m_layouts ) {
+			if( layout.pAPIObj == p ) {
+				m_pLayout = layout.pDesc;
+				break;
+			}
+		}
+
+		m_inner.iaSetLayout( p );
+	}
+
+	virtual Void tsBindTexture( IGfxAPITexture *p, U32 uStage ) override { m_inner.tsBindTexture( p, uStage ); }
+	virtual Void tsBindSampler( IGfxAPISampler *p, U32 uStage ) override { m_inner.tsBindSampler( p, uStage ); }
+	virtual Void iaBindVBuffer( IGfxAPIVBuffer *p ) override { m_inner.iaBindVBuffer( p ); }
+	virtual Void iaBindIBuffer( IGfxAPIIBuffer *p, EIndexFormat fmt ) override { m_inner.iaBindIBuffer( p, fmt ); }
+	virtual Void iaBindInstanceBuffer( IGfxAPIVBuffer *p ) override { m_inner.iaBindInstanceBuffer( p ); }
+
+	virtual Void plBindProgram( IGfxAPIProgram *p ) override { m_inner.plBindProgram( p ); }
+	virtual Void plUnbindProgram() override { m_inner.plUnbindProgram(); }
+	virtual Void cmdUpdateProgramBindings( const SGfxBinding &binding ) override { m_inner.cmdUpdateProgramBindings( binding ); }
+
+	virtual Void omBindRenderTarget( IGfxAPIRenderTarget *p ) override { m_inner.omBindRenderTarget( p ); }
+
+	virtual Void cmdClearRect( S32 posX, S32 posY, U32 resX, U32 resY, U32 value ) override { m_inner.cmdClearRect( posX, posY, resX, resY, value ); }
+	virtual Void cmdUpdateTexture( IGfxAPITexture *p, U16 posX, U16 posY, U16 resX, U16 resY, const U8 *pData ) override { m_inner.cmdUpdateTexture( p, posX, posY, resX, resY, pData ); }
+	virtual Void cmdWriteVBuffer( IGfxAPIVBuffer *p, UPtr offset, UPtr size, const Void *pData ) override
+	{
+		// Vertices drawn from memory are written at the start of the buffer
+		if( offset == 0 ) {
+			m_written.assign( ( const U8 * )pData, ( const U8 * )pData + size );
+		}
+
+		m_inner.cmdWriteVBuffer( p, offset, size, pData );
+	}
+	virtual Void cmdWriteIBuffer( IGfxAPIIBuffer *p, UPtr offset, UPtr size, const Void *pData ) override { m_inner.cmdWriteIBuffer( p, offset, size, pData ); }
+	virtual Void cmdWriteUBuffer( IGfxAPIUBuffer *p, UPtr offset, UPtr size, const Void *pData ) override { m_inner.cmdWriteUBuffer( p, offset, size, pData ); }
+	virtual Void cmdReadVBuffer( IGfxAPIVBuffer *p, UPtr offset, UPtr size, Void *pData ) override { m_inner.cmdReadVBuffer( p, offset, size, pData ); }
+	virtual Void cmdReadIBuffer( IGfxAPIIBuffer *p, UPtr offset, UPtr size, Void *pData ) override { m_inner.cmdReadIBuffer( p, offset, size, pData ); }
+	virtual Void cmdReadUBuffer( IGfxAPIUBuffer *p, UPtr offset, UPtr size, Void *pData ) override { m_inner.cmdReadUBuffer( p, offset, size, pData ); }
+	virtual Void cmdResolveRenderTarget( IGfxAPIRenderTarget *p ) override { m_inner.cmdResolveRenderTarget( p ); }
+
+	virtual Void cmdDraw( ETopology mode, U32 cVerts, U32 uOffset ) override
+	{
+		SDraw draw;
+		draw.stride = m_pLayout != nullptr ? m_pLayout->stride : 0;
+		draw.cVerts = cVerts;
+		draw.data   = m_written;
+		if( m_pLayout != nullptr ) {
+			for( UPtr i = 0; i < m_pLayout->cElements; ++i ) {
+				const SGfxLayoutElement &q = m_pLayout->elements[ i ];
+				draw.elements.push_back( SElement{ q.type, q.compTy, q.uOffset } );
+			}
+		}
+		draws.push_back( draw );
+
+		m_inner.cmdDraw( mode, cVerts, uOffset );
+	}
+	virtual Void cmdDrawIndexed( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias ) override { m_inner.cmdDrawIndexed( mode, cIndices, uOffset, uBias ); }
+	virtual Void cmdDrawInstanced( ETopology mode, U32 cVerts, U32 uOffset, U32 cInstances ) override { m_inner.cmdDrawInstanced( mode, cVerts, uOffset, cInstances ); }
+	virtual Void cmdDrawIndexedInstanced( ETopology mode, U32 cIndices, U32 uOffset, U32 uBias, U32 cInstances ) override { m_inner.cmdDrawIndexedInstanced( mode, cIndices, uOffset, uBias, cInstances ); }
+
+  private:
+	struct SLayout
+	{
+		IGfxAPIVLayout   *pAPIObj;
+		const SGfxLayout *pDesc;
+	};
+
+	IGfxAPI &m_inner;
+	std::vector< SLayout > m_layouts;
+	const SGfxLayout *m_pLayout;
+	std::vector< U8 > m_written;
+};
+
+// Holds a whole batch (one batch never needs more than MAX_BUFFER)
+static PrimitiveBuffer g_prims;
+
+static F32 readComponent( const U8 *p, EVectorType ty )
+{
+	switch( ty ) {
+	case kVectorTypeS16: {
+		S16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return F32( x );
+	}
+	case kVectorTypeF16: {
+		U16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return F32( F16::fromBits( x ) );
+	}
+	case kVectorTypeU16_UNorm: {
+		U16 x;
+		memcpy( &x, p, sizeof( x ) );
+		return F32( x )/65535.0f;
+	}
+	case kVectorTypeF32: {
+		F32 x;
+		memcpy( &x, p, sizeof( x ) );
+		return x;
+	}
+	default:
+		break;
+	}
+
+	return NAN;
+}
+static UPtr getComponentSize( EVectorType ty )
+{
+	return ty == kVectorTypeF32 ? 4 : 2;
+}
+
+static const CRecordingAPI::SElement *findElement( const CRecordingAPI::SDraw &draw, EGfxLayoutElement type )
+{
+	for( const CRecordingAPI::SElement &elm : draw.elements ) {
+		if( elm.type == type ) {
+			return &elm;
+		}
+	}
+
+	return nullptr;
+}
+
+// How a batch was drawn
+struct SDrawnAs
+{
+	UPtr        stride;
+	EVectorType posTy;
+	EVectorType texTy;
+	// Furthest any decoded position or texture coordinate is from what was
+	// submitted
+	F32         fMaxPosError;
+	F32         fMaxTexError;
+};
+
+// Submit `verts` as one batch of triangles and decode what was drawn
+static Bool drawBatch( SDrawnAs &dst, CRecordingAPI &api, const std::vector< SVertex > &verts, Bool bTextured )
+{
+	AX_ASSERT( verts.size()%3 == 0 );
+
+	api.draws.clear();
+
+	g_prims.setPrimitiveType( kTopologyTriangleList );
+	g_prims.setVertexFormat( bTextured ? PrimitiveConfig::kFormat_Textured : PrimitiveConfig::kFormat_Colored );
+	g_prims.addVertices( verts.data(), verts.size() );
+	g_prims.submit();
+
+	if( !DOLL_CHECK( api.draws.size() == 1 ) ) {
+		return false;
+	}
+
+	const CRecordingAPI::SDraw &draw = api.draws[ 0 ];
+	const CRecordingAPI::SElement *const pPos = findElement( draw, kGfxLayoutElementVertex );
+	const CRecordingAPI::SElement *const pTex = findElement( draw, kGfxLayoutElementTexCoord );
+
+	if( !DOLL_CHECK( draw.cVerts == verts.size() ) || !DOLL_CHECK( pPos != nullptr ) || !DOLL_CHECK( ( pTex != nullptr ) == bTextured ) ) {
+		return false;
+	}
+	if( !DOLL_CHECK( draw.stride > 0 && draw.data.size() >= draw.stride*verts.size() ) ) {
+		return false;
+	}
+
+	dst.stride       = draw.stride;
+	dst.posTy        = pPos->compTy;
+	dst.texTy        = pTex != nullptr ? pTex->compTy : kVectorTypeF32;
+	dst.fMaxPosError = 0.0f;
+	dst.fMaxTexError = 0.0f;
+
+	for( UPtr i = 0; i < verts.size(); ++i ) {
+		const U8 *const pVert = draw.data.data() + i*draw.stride;
+
+		const UPtr cPosComp = getComponentSize( pPos->compTy );
+		const F32 x = readComponent( pVert + pPos->uOffset, pPos->compTy );
+		const F32 y = readComponent( pVert + pPos->uOffset + cPosComp, pPos->compTy );
+
+		dst.fMaxPosError = fmaxf( dst.fMaxPosError, fmaxf( fabsf( x - verts[ i ].x ), fabsf( y - verts[ i ].y ) ) );
+
+		if( pTex != nullptr ) {
+			const UPtr cTexComp = getComponentSize( pTex->compTy );
+			const F32 u = readComponent( pVert + pTex->uOffset, pTex->compTy );
+			const F32 v = readComponent( pVert + pTex->uOffset + cTexComp, pTex->compTy );
+
+			dst.fMaxTexError = fmaxf( dst.fMaxTexError, fmaxf( fabsf( u - verts[ i ].u ), fabsf( v - verts[ i ].v ) ) );
+		}
+	}
+
+	return true;
+}
+
+static SVertex makeVertex( F32 x, F32 y, F32 u = 0.0f, F32 v = 0.0f )
+{
+	SVertex vert;
+	vert.x       = x;
+	vert.y       = y;
+	vert.diffuse = 0xFFFFFFFF;
+	vert.u       = u;
+	vert.v       = v;
+	return vert;
+}
+
+// A quad (two triangles) from x1,y1 to x2,y2 showing the whole texture
+static Void addQuad( std::vector< SVertex > &dst, F32 x1, F32 y1, F32 x2, F32 y2, F32 u1 = 0.0f, F32 v1 = 0.0f, F32 u2 = 1.0f, F32 v2 = 1.0f )
+{
+	dst.push_back( makeVertex( x1, y1, u1, v1 ) );
+	dst.push_back( makeVertex( x2, y1, u2, v1 ) );
+	dst.push_back( makeVertex( x1, y2, u1, v2 ) );
+
+	dst.push_back( makeVertex( x2, y1, u2, v1 ) );
+	dst.push_back( makeVertex( x2, y2, u2, v2 ) );
+	dst.push_back( makeVertex( x1, y2, u1, v2 ) );
+}
+
+static Void testThresholds()
+{
+	// S16: whole pixels in range only
+	DOLL_CHECK( PrimitiveBuffer::fitsPosS16( 0.0f, 0.0f ) );
+	DOLL_CHECK( PrimitiveBuffer::fitsPosS16( -32768.0f, 32767.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosS16( 32768.0f, 0.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosS16( 0.0f, -32769.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosS16( 10.5f, 0.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosS16( 0.0f, -0.25f ) );
+
+	// F16: within 1/32 of a pixel. From 256 to 512 half floats are 1/4
+	// apart, so 1/32 off one is just close enough and 1/16 isn't
+	DOLL_CHECK( PrimitiveBuffer::fitsPosF16( 0.3f, 17.125f ) );
+	DOLL_CHECK( PrimitiveBuffer::fitsPosF16( 300.03125f, 300.25f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 300.0625f, 0.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 0.0f, 300.04f ) );
+	// From 1024 on they're a whole pixel or more apart
+	DOLL_CHECK( PrimitiveBuffer::fitsPosF16( 1000.5f, 1024.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 1024.5f, 0.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 3001.0f, 0.0f ) );
+
+	// The ends of the F16 range: 65504 is the largest half float, and
+	// anything from 65520 on becomes infinite
+	DOLL_CHECK( PrimitiveBuffer::fitsPosF16( 65504.0f, -65504.0f ) );
+	DOLL_CHECK( PrimitiveBuffer::fitsPosF16( 40000.0f, 0.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 65519.0f, 0.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 0.0f, -65520.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsPosF16( 1.0e6f, 0.0f ) );
+
+	// UNORM16: 0 to 1 inclusive
+	DOLL_CHECK( PrimitiveBuffer::fitsTexUNorm16( 0.0f, 1.0f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsTexUNorm16( -0.0001f, 0.5f ) );
+	DOLL_CHECK( !PrimitiveBuffer::fitsTexUNorm16( 0.5f, 1.0001f ) );
+}
+
+static Void testUNorm16()
+{
+	// Every UNORM16 value comes back as itself
+	Bool bExact = true;
+	for( U32 i = 0; i <= 0xFFFF; ++i ) {
+		bExact = bExact && PrimitiveBuffer::packUNorm16( F32( i )/65535.0f ) == U16( i );
+	}
+	DOLL_CHECK( bExact );
+
+	// Anything in between is packed to the nearest value, so it's off by
+	// no more than half a step once read back
+	test::SRandom rng = { 49 };
+
+	F32 fMaxError = 0.0f;
+	for( U32 i = 0; i < 100000; ++i ) {
+		const F32 u = F32( rng.next() )/16777215.0f;
+		const F32 fError = fabsf( F32( PrimitiveBuffer::packUNorm16( u ) )/65535.0f - u );
+		fMaxError = fmaxf( fMaxError, fError );
+	}
+	DOLL_CHECK( fMaxError <= 0.5f/65535.0f + 1.0e-7f );
+}
+
+// Runs first, while none of the layouts it uses are cached yet
+static Void testRefusedLayout( CRecordingAPI &api )
+{
+	api.bRefuseUNorm16TexCoords = true;
+
+	std::vector< SVertex > verts;
+	addQuad( verts, 0.0f, 0.0f, 16.0f, 16.0f );
+
+	// Whole pixels and texture coordinates in range would be 12 bytes, but
+	// the API refuses UNORM16 texture coordinates, so they stay F32
+	SDrawnAs drawn;
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.stride == 16 );
+		DOLL_CHECK( drawn.posTy == kVectorTypeS16 );
+		DOLL_CHECK( drawn.texTy == kVectorTypeF32 );
+		DOLL_CHECK( drawn.fMaxPosError == 0.0f && drawn.fMaxTexError == 0.0f );
+	}
+	DOLL_CHECK( api.cLayoutsRefused == 1 );
+
+	// The refusal is remembered, so the next batch doesn't ask again (nor
+	// make the layout it fell back to again)
+	const U32 cCreated = api.cLayoutsCreated;
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.stride == 16 );
+	}
+	DOLL_CHECK( api.cLayoutsRefused == 1 );
+	DOLL_CHECK( api.cLayoutsCreated == cCreated );
+
+	api.bRefuseUNorm16TexCoords = false;
+}
+
+static Void testFallback( CRecordingAPI &api )
+{
+	static const F32 kMaxF16Error = 1.0f/32;
+	static const F32 kMaxUNorm16Error = 0.5f/65535.0f + 1.0e-7f;
+
+	SDrawnAs drawn;
+	std::vector< SVertex > verts;
+
+	// Whole pixels, untextured: S16
+	addQuad( verts, -100.0f, 20.0f, 32000.0f, 240.0f );
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, false ) ) ) {
+		DOLL_CHECK( drawn.stride == 8 && drawn.posTy == kVectorTypeS16 );
+		DOLL_CHECK( drawn.fMaxPosError == 0.0f );
+	}
+
+	// One vertex off the pixel grid turns the whole batch to F16
+	verts.clear();
+	addQuad( verts, 0.0f, 0.0f, 64.0f, 64.0f, 0.0f, 0.0f, 0.5f, 0.25f );
+	verts.back().x = 12.5f;
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.stride == 12 );
+		DOLL_CHECK( drawn.posTy == kVectorTypeF16 && drawn.texTy == kVectorTypeU16_UNorm );
+		DOLL_CHECK( drawn.fMaxPosError <= kMaxF16Error );
+		DOLL_CHECK( drawn.fMaxTexError <= kMaxUNorm16Error );
+	}
+
+	// A whole pixel F16 can't hold, ahead of the vertex that rules out S16,
+	// keeps positions F32
+	verts.clear();
+	addQuad( verts, 3001.0f, 0.0f, 3003.0f, 8.0f );
+	verts.back().y = 0.5f;
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, false ) ) ) {
+		DOLL_CHECK( drawn.posTy == kVectorTypeF32 );
+		DOLL_CHECK( drawn.fMaxPosError == 0.0f );
+	}
+
+	// As does a position more than 1/32 of a pixel from any half float,
+	// while the texture coordinates still pack
+	verts.clear();
+	addQuad( verts, 0.0f, 0.0f, 300.0625f, 64.0f );
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.stride == 16 );
+		DOLL_CHECK( drawn.posTy == kVectorTypeF32 && drawn.texTy == kVectorTypeU16_UNorm );
+		DOLL_CHECK( drawn.fMaxPosError == 0.0f );
+		DOLL_CHECK( drawn.fMaxTexError <= kMaxUNorm16Error );
+	}
+
+	// Texture coordinates outside 0 to 1 (repeating) stay F32, while the
+	// positions still pack
+	verts.clear();
+	addQuad( verts, 0.5f, 0.5f, 32.5f, 32.5f, 0.0f, 0.0f, 2.0f, 1.0f );
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.stride == 16 );
+		DOLL_CHECK( drawn.posTy == kVectorTypeF16 && drawn.texTy == kVectorTypeF32 );
+		DOLL_CHECK( drawn.fMaxTexError == 0.0f );
+	}
+
+	// Nothing fits: the full vertex, as submitted
+	verts.clear();
+	addQuad( verts, 0.0f, 0.0f, 70000.25f, 10.0f, -1.0f, 0.0f, 1.0f, 1.0f );
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.stride == sizeof( SVertex ) );
+		DOLL_CHECK( drawn.posTy == kVectorTypeF32 && drawn.texTy == kVectorTypeF32 );
+		DOLL_CHECK( drawn.fMaxPosError == 0.0f && drawn.fMaxTexError == 0.0f );
+	}
+
+	// Texture coordinates spread over the whole range come back within half
+	// a UNORM16 step
+	test::SRandom rng = { 7 };
+
+	verts.clear();
+	for( U32 i = 0; i < 300; ++i ) {
+		const F32 u = F32( rng.next() )/16777215.0f;
+		const F32 v = F32( rng.next() )/16777215.0f;
+		verts.push_back( makeVertex( F32( rng.range( 0, 256 ) ), F32( rng.range( 0, 256 ) ), u, v ) );
+	}
+	if( DOLL_CHECK( drawBatch( drawn, api, verts, true ) ) ) {
+		DOLL_CHECK( drawn.texTy == kVectorTypeU16_UNorm );
+		DOLL_CHECK( drawn.fMaxTexError <= kMaxUNorm16Error );
+	}
+}
+
+int main()
+{
+	SCoreConfig conf;
+	conf.setResolution( 64, 64 );
+
+	if( !DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		return test::finish( "Test-CompactVertices" );
+	}
+
+	testThresholds();
+	testUNorm16();
+
+	// A software renderer of its own, wrapped so draws can be looked at
+	IGfxAPIProvider *const pProvider = doll_findGfxAPIByName( "soft" );
+
+	SGfxInitDesc desc;
+	desc.apis      = TArr<IGfxAPIProvider *>( &pProvider, 1 );
+	desc.windowing = kGfxScreenModeWindowed;
+	desc.vsync     = 0;
+
+	IGfxAPI *const pSoftAPI = DOLL_CHECK( pProvider != nullptr ) ? gfx_initAPI( OSWindow( 0 ), &desc ) : nullptr;
+	if( DOLL_CHECK( pSoftAPI != nullptr ) ) {
+		CRecordingAPI api( *pSoftAPI );
+		CGfxFrame *const pPrevFrame = gfx_r_getFrame();
+
+		{
+			CGfxFrame frame( api );
+			gfx_r_setFrame( &frame );
+			frame.setDefaultState();
+
+			testRefusedLayout( api );
+			testFallback( api );
+
+			gfx_r_setFrame( pPrevFrame );
+		}
+
+		gfx_finiAPI( pSoftAPI );
+	}
+
+	doll_fini();
+	return test::finish( "Test-CompactVertices" );
+}
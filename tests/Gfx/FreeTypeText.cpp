@@ -0,0 +1,243 @@
+// FreeType text: laid out text advances the pen by each glyph's advance plus
+// the kerning of each pair, measures to the laid out size, shares one cached
+// glyph (and one atlas texture) between every use of a character, and draws
+// the right way up
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+#include "doll/Gfx/Texture.hpp"
+
+#include "Gfx/FreeType/OSText_FreeType.hpp"
+
+#include <vector>
+
+using namespace doll;
+using namespace doll::FreeType;
+
+static const U32 kResX = 128;
+static const U32 kResY = 64;
+
+static const U32 kPixelSize = 24;
+
+// Copy of a layout, since the layout's quads are reused between calls
+static std::vector< SGlyphQuad > layOut( const FreeTypeFont &font, const char *pszText, SIntVector2 *pSize = nullptr )
+{
+	STextLayout text;
+
+	std::vector< SGlyphQuad > quads;
+	if( !DOLL_CHECK( font.layout( text, pszText, 0 ) ) ) {
+		return quads;
+	}
+
+	quads.assign( text.quads.pointer(), text.quads.pointer() + text.quads.len() );
+	if( pSize != nullptr ) {
+		*pSize = text.size;
+	}
+
+	return quads;
+}
+
+// Kerning between the glyphs of quads[ i ] and quads[ i + 1 ] on one line
+static S32 kerningAt( const std::vector< SGlyphQuad > &quads, UPtr i )
+{
+	return quads[ i + 1 ].iPenX - quads[ i ].iPenX - quads[ i ].pGlyph->iAdvance;
+}
+
+static Void testLayout( const FreeTypeFont &font )
+{
+	SIntVector2 size;
+	const std::vector< SGlyphQuad > avav = layOut( font, "AVAV", &size );
+	if( !DOLL_CHECK( avav.size() == 4 ) ) {
+		return;
+	}
+
+	// Repeated characters are one cached glyph
+	DOLL_CHECK( avav[ 0 ].pGlyph == avav[ 2 ].pGlyph );
+	DOLL_CHECK( avav[ 1 ].pGlyph == avav[ 3 ].pGlyph );
+	DOLL_CHECK( avav[ 0 ].pGlyph != avav[ 1 ].pGlyph );
+	DOLL_CHECK( avav[ 0 ].pGlyph->uPixelSize == kPixelSize );
+	DOLL_CHECK( !avav[ 0 ].pGlyph->bStroke );
+
+	const S32 iAdvanceA = avav[ 0 ].pGlyph->iAdvance;
+	const S32 iAdvanceV = avav[ 1 ].pGlyph->iAdvance;
+	DOLL_CHECK( iAdvanceA > 0 && iAdvanceV > 0 );
+
+	// Everything sits on the first line, starting at the left edge
+	DOLL_CHECK( avav[ 0 ].iPenX == 0 );
+	for( const SGlyphQuad &quad : avav ) {
+		DOLL_CHECK( quad.iBaseline == font.getAscender() );
+	}
+
+	// "AV" and "VA" both kern closer together, and each pair the same way
+	// wherever it occurs
+	const S32 iKernAV = kerningAt( avav, 0 );
+	const S32 iKernVA = kerningAt( avav, 1 );
+	DOLL_CHECK( iKernAV < 0 );
+	DOLL_CHECK( iKernVA < 0 );
+	DOLL_CHECK( kerningAt( avav, 2 ) == iKernAV );
+
+	const std::vector< SGlyphQuad > av = layOut( font, "AV" );
+	if( DOLL_CHECK( av.size() == 2 ) ) {
+		DOLL_CHECK( av[ 0 ].pGlyph == avav[ 0 ].pGlyph );
+		DOLL_CHECK( av[ 1 ].iPenX == iAdvanceA + iKernAV );
+	}
+
+	// Pairs that don't kern are spaced by the advance alone
+	const std::vector< SGlyphQuad > hh = layOut( font, "HH" );
+	if( DOLL_CHECK( hh.size() == 2 ) ) {
+		DOLL_CHECK( hh[ 1 ].iPenX == hh[ 0 ].pGlyph->iAdvance );
+	}
+
+	// The size covers the pen at the end of the text, rounded up
+	const S32 iEndPen = 2*iAdvanceA + 2*iAdvanceV + 2*iKernAV + iKernVA;
+	DOLL_CHECK( avav[ 3 ].iPenX + iAdvanceV == iEndPen );
+	DOLL_CHECK( size.x == ( iEndPen + 63 )>>6 );
+	DOLL_CHECK( size.y == font.getLineHeight() );
+
+	SRect area;
+	font.measure( "AVAV", area );
+	DOLL_CHECK( area.x1 == 0 && area.y1 == 0 );
+	DOLL_CHECK( area.x2 == size.x && area.y2 == size.y );
+
+	// A new line starts over at the left, one line further down, without
+	// kerning against the end of the line before
+	SIntVector2 twoLines;
+	const std::vector< SGlyphQuad > lines = layOut( font, "AV\nVA", &twoLines );
+	if( DOLL_CHECK( lines.size() == 4 ) ) {
+		DOLL_CHECK( lines[ 2 ].iPenX == 0 );
+		DOLL_CHECK( lines[ 2 ].iBaseline == font.getAscender() + font.getLineHeight() );
+		DOLL_CHECK( lines[ 3 ].iPenX == iAdvanceV + iKernVA );
+		DOLL_CHECK( twoLines.y == 2*font.getLineHeight() );
+	}
+
+	// Another size is another set of glyphs
+	FreeTypeFont larger;
+	if( DOLL_CHECK( larger.set( "sans", kPixelSize*2 ) ) ) {
+		const std::vector< SGlyphQuad > big = layOut( larger, "A" );
+		if( DOLL_CHECK( big.size() == 1 ) ) {
+			DOLL_CHECK( big[ 0 ].pGlyph != avav[ 0 ].pGlyph );
+			DOLL_CHECK( big[ 0 ].pGlyph->iAdvance > iAdvanceA );
+		}
+	}
+}
+
+static Void drawFrame( const FreeTypeFont &font, const char *pszText )
+{
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	gfx_clearQueue();
+
+	gfx_queClearRect( 0, 0, S32( kResX ), S32( kResY ), DOLL_RGB( 30, 30, 50 ) );
+	DOLL_CHECK( font.draw( pszText, SRect( 0, 0, S32( kResX ), S32( kResY ) ), 0, DOLL_RGB( 255, 255, 255 ) ) );
+
+	doll_sync();
+}
+
+static Void testAtlas( const FreeTypeFont &font )
+{
+	const std::vector< SGlyphQuad > avav = layOut( font, "AVAV" );
+	if( !DOLL_CHECK( avav.size() == 4 ) ) {
+		return;
+	}
+
+	SGlyph &glyphA = *avav[ 0 ].pGlyph;
+	SGlyph &glyphV = *avav[ 1 ].pGlyph;
+
+	// Glyphs only get a texture once they're drawn
+	drawFrame( font, "AVAV" );
+
+	RTexture *const pTextureA = glyphA.pTexture;
+	RTexture *const pTextureV = glyphV.pTexture;
+	if( !DOLL_CHECK( pTextureA != nullptr ) || !DOLL_CHECK( pTextureV != nullptr ) ) {
+		return;
+	}
+
+	// With the border around the coverage, on one glyph page
+	DOLL_CHECK( pTextureA != pTextureV );
+	DOLL_CHECK( pTextureA->getResolution().x == glyphA.uResX + 2 );
+	DOLL_CHECK( pTextureA->getResolution().y == glyphA.uResY + 2 );
+	DOLL_CHECK( pTextureA->getBackingTexture() != 0 );
+	DOLL_CHECK( pTextureA->getBackingTexture() == pTextureV->getBackingTexture() );
+
+	// Drawing again (and other text with the same characters) reuses them
+	drawFrame( font, "AVAV" );
+	drawFrame( font, "VAVA" );
+
+	DOLL_CHECK( glyphA.pTexture == pTextureA );
+	DOLL_CHECK( glyphV.pTexture == pTextureV );
+
+	const std::vector< SGlyphQuad > vava = layOut( font, "VAVA" );
+	if( DOLL_CHECK( vava.size() == 4 ) ) {
+		DOLL_CHECK( vava[ 0 ].pGlyph == &glyphV );
+		DOLL_CHECK( vava[ 1 ].pGlyph == &glyphA );
+	}
+}
+
+// Lit pixels in row `y` of the frame, between `x1` and `x2`
+static U32 countLit( CGfxAPI_Soft &softAPI, S32 y, S32 x1, S32 x2 )
+{
+	const U32 *const pPixels = softAPI.readback();
+	if( !pPixels || y < 0 || y >= S32( kResY ) ) {
+		return 0;
+	}
+
+	U32 cLit = 0;
+	for( S32 x = x1 < 0 ? 0 : x1; x < x2 && x < S32( kResX ); ++x ) {
+		cLit += U32( DOLL_COLOR_R( pPixels[ y*S32( kResX ) + x ] ) > 160 );
+	}
+
+	return cLit;
+}
+
+static Void testOrientation( const FreeTypeFont &font, CGfxAPI_Soft &softAPI )
+{
+	const std::vector< SGlyphQuad > t = layOut( font, "T" );
+	if( !DOLL_CHECK( t.size() == 1 ) || !DOLL_CHECK( t[ 0 ].pGlyph->uResY > 8 ) ) {
+		return;
+	}
+
+	drawFrame( font, "T" );
+
+	// The bar of a "T" is at the top and its stem is narrow; drawn upside
+	// down, the bar would be at the bottom
+	const SGlyph &glyph = *t[ 0 ].pGlyph;
+	const S32 x1 = t[ 0 ].getLeft();
+	const S32 x2 = x1 + S32( glyph.uResX );
+	const S32 y1 = t[ 0 ].getTop();
+	const S32 y2 = y1 + S32( glyph.uResY );
+
+	const U32 cLitTop = countLit( softAPI, y1 + 1, x1, x2 );
+	const U32 cLitBottom = countLit( softAPI, y2 - 2, x1, x2 );
+	DOLL_CHECK( cLitTop > glyph.uResX/2 );
+	DOLL_CHECK( cLitBottom < glyph.uResX/2 );
+	DOLL_CHECK( cLitBottom > 0 );
+}
+
+int main()
+{
+	SCoreConfig conf;
+	conf.setResolution( kResX, kResY );
+
+	if( !DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		return test::finish( "Test-FreeTypeText" );
+	}
+
+	// Nothing to check on a system without any of the fonts looked for
+	FreeTypeFont font;
+	if( font.set( "sans", kPixelSize ) ) {
+		testLayout( font );
+		testAtlas( font );
+
+		CGfxAPI_Soft *const pSoftAPI = gfx_getSoftAPI( &gfx_r_getFrame()->getContext() );
+		if( DOLL_CHECK( pSoftAPI != nullptr ) ) {
+			testOrientation( font, *pSoftAPI );
+		}
+	} else {
+		printf( "No sans font found; skipping\n" );
+	}
+
+	doll_fini();
+	return test::finish( "Test-FreeTypeText" );
+}
@@ -0,0 +1,249 @@
+// Shader cache: keys are plain 64-bit FNV-1a over their inputs (the same on
+// every platform), and entries stored under a key load back intact; damaged,
+// mismatched and removed entries don't load at all
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Gfx/ShaderCache.hpp"
+#include "doll/IO/VFS.hpp"
+
+#include <vector>
+
+using namespace doll;
+
+static const char *const kCacheDir = "Test-ShaderCache.cache";
+
+// Same naming as the cache: "<dir>/<key as 16 hex digits>.dsc"
+static Void getEntryFilename( char ( &szDst )[ 128 ], U64 uKey )
+{
+	static const char *const pszHex = "0123456789abcdef";
+
+	char szKey[ 17 ];
+	for( UPtr i = 0; i < 16; ++i ) {
+		szKey[ i ] = pszHex[ ( uKey>>( 60 - i*4 ) ) & 0xF ];
+	}
+	szKey[ 16 ] = '\0';
+
+	axspf( szDst, "%s/%s.dsc", kCacheDir, szKey );
+}
+
+static std::vector< U8 > makeBlob( UPtr cBytes, U32 uSeed )
+{
+	test::SRandom rng = { uSeed };
+
+	std::vector< U8 > blob( cBytes );
+	for( U8 &x : blob ) {
+		x = U8( rng.next() );
+	}
+
+	return blob;
+}
+
+static Bool loadsAs( CShaderCache &cache, U64 uKey, const std::vector< U8 > &blob, U32 uTag )
+{
+	TMutArr<U8> loaded;
+	U32 uLoadedTag = ~0U;
+	if( !cache.load( uKey, loaded, uLoadedTag ) ) {
+		return false;
+	}
+
+	return
+		uLoadedTag == uTag &&
+		loaded.num() == blob.size() &&
+		( blob.empty() || memcmp( loaded.pointer(), blob.data(), blob.size() ) == 0 );
+}
+
+static Bool loadsAtAll( CShaderCache &cache, U64 uKey )
+{
+	TMutArr<U8> loaded;
+	U32 uTag = 0;
+	return cache.load( uKey, loaded, uTag );
+}
+
+static Bool writeFile( const char *pszFilename, const Void *pData, UPtr cBytes )
+{
+	IFile *const pFile = fs_open( pszFilename, kFileOpenF_W | kFileOpenF_Recreate );
+	if( !pFile ) {
+		return false;
+	}
+
+	const Bool bWritten = fs_write( pFile, pData, cBytes ) == cBytes;
+	fs_close( pFile );
+
+	return bWritten;
+}
+static Bool readFile( std::vector< U8 > &dst, const char *pszFilename )
+{
+	IFile *const pFile = fs_open( pszFilename );
+	if( !pFile ) {
+		return false;
+	}
+
+	dst.resize( UPtr( fs_size( pFile ) ) );
+	const Bool bRead = dst.empty() || fs_read( pFile, dst.data(), dst.size() ) == dst.size();
+	fs_close( pFile );
+
+	return bRead;
+}
+
+static Void testKeys()
+{
+	// Published FNV-1a test vectors
+	DOLL_CHECK( CShaderCacheKey().get() == 0xCBF29CE484222325ULL );
+	DOLL_CHECK( CShaderCacheKey().addBytes( "a", 1 ).get() == 0xAF63DC4C8601EC8CULL );
+	DOLL_CHECK( CShaderCacheKey().addBytes( "foobar", 6 ).get() == 0x85944171F73967E8ULL );
+
+	// Integers go in least significant byte first, whatever the platform
+	static const U8 kBytes[ 8 ] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+	DOLL_CHECK( CShaderCacheKey().addU32( 0x04030201 ).get() == CShaderCacheKey().addBytes( kBytes, 4 ).get() );
+	DOLL_CHECK( CShaderCacheKey().addU64( 0x0807060504030201ULL ).get() == CShaderCacheKey().addBytes( kBytes, 8 ).get() );
+
+	// Strings are length prefixed, so splitting them differently matters
+	DOLL_CHECK( CShaderCacheKey().addString( "ab" ).addString( "c" ).get() != CShaderCacheKey().addString( "a" ).addString( "bc" ).get() );
+	DOLL_CHECK( CShaderCacheKey().addString( "ab" ).addString( "c" ).get() == CShaderCacheKey().addString( "ab" ).addString( "c" ).get() );
+
+	// Every input of a shader's key counts
+	static const char kSource[] = "void main() { gl_FragColor = vec4( 1.0 ); }";
+	const UPtr cSource = sizeof( kSource ) - 1;
+	const U64 uKey = gfx_calcShaderCacheKey( kShaderFormatGLSL, kShaderStagePixel, kSource, cSource, 42 );
+
+	DOLL_CHECK( uKey == gfx_calcShaderCacheKey( kShaderFormatGLSL, kShaderStagePixel, kSource, cSource, 42 ) );
+	DOLL_CHECK( uKey != gfx_calcShaderCacheKey( kShaderFormatGLSL, kShaderStageVertex, kSource, cSource, 42 ) );
+	DOLL_CHECK( uKey != gfx_calcShaderCacheKey( kShaderFormatGLSL, kShaderStagePixel, kSource, cSource, 43 ) );
+	DOLL_CHECK( uKey != gfx_calcShaderCacheKey( kShaderFormatGLSL, kShaderStagePixel, kSource, cSource - 1, 42 ) );
+}
+
+static Void testStore()
+{
+	CShaderCache cache;
+	if( !DOLL_CHECK( cache.setDirectory( kCacheDir ) ) || !DOLL_CHECK( cache.isEnabled() ) ) {
+		return;
+	}
+
+	const U64 uKeyA = 0x0123456789ABCDEFULL;
+	const U64 uKeyB = 0xFEDCBA9876543210ULL;
+	const U64 uKeyC = 0x00000000000000C0ULL;
+
+	const std::vector< U8 > blobA  = makeBlob( 1000, 1 );
+	const std::vector< U8 > blobA2 = makeBlob( 300, 2 );
+	const std::vector< U8 > blobB  = makeBlob( 4096, 3 );
+
+	// Round trip, including the tag and an empty blob
+	DOLL_CHECK( cache.store( uKeyA, 7, blobA.data(), blobA.size() ) );
+	DOLL_CHECK( loadsAs( cache, uKeyA, blobA, 7 ) );
+	DOLL_CHECK( cache.store( uKeyC, 9, nullptr, 0 ) );
+	DOLL_CHECK( loadsAs( cache, uKeyC, std::vector< U8 >(), 9 ) );
+
+	// Nothing stored under this key yet
+	cache.remove( uKeyB );
+	DOLL_CHECK( !loadsAtAll( cache, uKeyB ) );
+
+	// Storing again replaces the entry
+	DOLL_CHECK( cache.store( uKeyA, 8, blobA2.data(), blobA2.size() ) );
+	DOLL_CHECK( loadsAs( cache, uKeyA, blobA2, 8 ) );
+
+	// An entry copied under another key's name is rejected (its header
+	// names the key it was stored under) and deleted
+	char szFilenameA[ 128 ];
+	char szFilenameB[ 128 ];
+	getEntryFilename( szFilenameA, uKeyA );
+	getEntryFilename( szFilenameB, uKeyB );
+
+	std::vector< U8 > image;
+	if( DOLL_CHECK( readFile( image, szFilenameA ) ) && DOLL_CHECK( writeFile( szFilenameB, image.data(), image.size() ) ) ) {
+		DOLL_CHECK( !loadsAtAll( cache, uKeyB ) );
+		DOLL_CHECK( !fs_fileExists( szFilenameB ) );
+	}
+
+	// So is an entry with a damaged blob (the checksum no longer matches),
+	// and one cut short
+	DOLL_CHECK( cache.store( uKeyB, 3, blobB.data(), blobB.size() ) );
+	if( DOLL_CHECK( readFile( image, szFilenameB ) ) ) {
+		image[ image.size()/2 ] ^= 0x10;
+		if( DOLL_CHECK( writeFile( szFilenameB, image.data(), image.size() ) ) ) {
+			DOLL_CHECK( !loadsAtAll( cache, uKeyB ) );
+			DOLL_CHECK( !fs_fileExists( szFilenameB ) );
+		}
+	}
+	DOLL_CHECK( cache.store( uKeyB, 3, blobB.data(), blobB.size() ) );
+	if( DOLL_CHECK( readFile( image, szFilenameB ) ) ) {
+		if( DOLL_CHECK( writeFile( szFilenameB, image.data(), image.size() - 1 ) ) ) {
+			DOLL_CHECK( !loadsAtAll( cache, uKeyB ) );
+		}
+	}
+
+	// Removed entries are gone
+	cache.remove( uKeyA );
+	DOLL_CHECK( !loadsAtAll( cache, uKeyA ) );
+	DOLL_CHECK( loadsAs( cache, uKeyC, std::vector< U8 >(), 9 ) );
+	cache.remove( uKeyC );
+
+	// A disabled cache neither stores nor loads
+	DOLL_CHECK( cache.setDirectory( Str() ) );
+	DOLL_CHECK( !cache.isEnabled() );
+	DOLL_CHECK( !cache.store( uKeyA, 7, blobA.data(), blobA.size() ) );
+	DOLL_CHECK( !loadsAtAll( cache, uKeyA ) );
+}
+
+// Bytes of entry files in the cache directory, or false if it can't be listed
+static Bool sumEntryBytes( U64 &dst )
+{
+	IDir *const pDir = fs_openDir( kCacheDir );
+	if( !pDir ) {
+		return false;
+	}
+
+	dst = 0;
+
+	SDirEntry entry;
+	while( fs_readDir( pDir, entry ) ) {
+		if( Str( entry.getName() ).getExtension().caseCmp( ".dsc" ) ) {
+			dst += entry.cBytes;
+		}
+	}
+
+	fs_closeDir( pDir );
+	return true;
+}
+
+static Void testBudget()
+{
+	U64 cBytes = 0;
+	if( !sumEntryBytes( cBytes ) ) {
+		printf( "  (directories can't be listed here; not checking the byte budget)\n" );
+		return;
+	}
+
+	CShaderCache cache;
+	if( !DOLL_CHECK( cache.setDirectory( kCacheDir ) ) ) {
+		return;
+	}
+
+	// Room for three entries (and their headers) at a time
+	const std::vector< U8 > blob = makeBlob( 2000, 4 );
+	cache.setMaxBytes( 3*( blob.size() + 64 ) );
+
+	for( U64 uKey = 1; uKey <= 8; ++uKey ) {
+		DOLL_CHECK( cache.store( uKey, 0, blob.data(), blob.size() ) );
+	}
+
+	DOLL_CHECK( sumEntryBytes( cBytes ) && cBytes <= cache.getMaxBytes() );
+	DOLL_CHECK( cBytes >= blob.size() );
+
+	cache.clear();
+	DOLL_CHECK( sumEntryBytes( cBytes ) && cBytes == 0 );
+}
+
+int main()
+{
+	test::SConsoleApp app;
+	if( !DOLL_CHECK( app.bInitialized ) ) {
+		return test::finish( "Test-ShaderCache" );
+	}
+
+	testKeys();
+	testStore();
+	testBudget();
+
+	return test::finish( "Test-ShaderCache" );
+}
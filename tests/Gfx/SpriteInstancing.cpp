@@ -0,0 +1,217 @@
+// Sprite instancing: sprites that stay axis-aligned and are one color are
+// drawn as one instance record each rather than six vertices, and the frame
+// comes out exactly as it does with every sprite expanded; flipped, scaled
+// and tinted sprites on two textures are covered, as are rotated and
+// corner-colored sprites (which can't be instances) drawn in between them,
+// over which the instances have to keep their order
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+#include "doll/Gfx/RenderStats.hpp"
+#include "doll/Gfx/Sprite.hpp"
+#include "doll/Gfx/Texture.hpp"
+
+#include <string.h>
+#include <vector>
+
+using namespace doll;
+
+static const U32 kResX = 128;
+static const U32 kResY = 96;
+
+static const U32 kCellRes = 16;
+static const U32 kSpriteCount = 40;
+
+// Rectangle, texture rectangle and color of one sprite
+static const U64 kInstanceBytes = 4*4 + 4*4 + 4;
+
+static const U32 kBackground = DOLL_RGB( 30, 30, 50 );
+
+struct SScene
+{
+	std::vector< RTexture * > textures;
+	std::vector< RSprite * >  sprites;
+	// Sprites that can be drawn as instances
+	U32                       cInstanceable;
+};
+
+// Two cells of uneven stripes (so flips show), with translucent gaps
+static RTexture *newCellTexture( U32 uSeed )
+{
+	static const U32 kTexResX = kCellRes*2;
+	static const U32 kTexResY = kCellRes;
+
+	std::vector< U32 > texels( kTexResX*kTexResY );
+	for( U32 y = 0; y < kTexResY; ++y ) {
+		for( U32 x = 0; x < kTexResX; ++x ) {
+			const U32 uCell = x/kCellRes;
+			const Bool bLit = ( x/3 + y/5 )%2 == 0 || x%kCellRes == 1;
+
+			texels[ y*kTexResX + x ] = bLit ? DOLL_RGB( 40 + uSeed*90, 60 + uCell*120, 200 - uSeed*80 ) : DOLL_RGBA( uSeed*50, 0, 0, 96 );
+		}
+	}
+
+	return gfx_newTexture( U16( kTexResX ), U16( kTexResY ), texels.data(), kTexFmtRGBA8 );
+}
+
+// Overlapping sprites in runs of three on each texture; with `bMixed`, every
+// fifth is rotated or given corner colors
+static Bool buildScene( SScene &scene, Bool bMixed )
+{
+	scene.cInstanceable = 0;
+
+	for( U32 i = 0; i < 2; ++i ) {
+		RTexture *const pTexture = newCellTexture( i );
+		if( !DOLL_CHECK( pTexture != nullptr ) ) {
+			return false;
+		}
+		scene.textures.push_back( pTexture );
+	}
+
+	for( U32 i = 0; i < kSpriteCount; ++i ) {
+		RSprite *const pSprite = gfx_loadAnimSprite( scene.textures[ ( i/3 )%2 ], S32( kCellRes ), S32( kCellRes ), S32( i%2 ), 1, 0, 0, 0, 0 );
+		if( !DOLL_CHECK( pSprite != nullptr ) ) {
+			return false;
+		}
+		scene.sprites.push_back( pSprite );
+
+		gfx_setSpritePosition( pSprite, F32( ( i*23 )%( kResX - 2*kCellRes ) ), F32( ( i*13 )%( kResY - 2*kCellRes ) ) );
+
+		if( i%4 == 1 ) {
+			gfx_flipSpriteHorizontal( pSprite );
+		}
+		if( i%5 == 2 ) {
+			gfx_flipSpriteVertical( pSprite );
+		}
+		if( i%6 == 3 ) {
+			gfx_setSpriteScale( pSprite, 2, 2 );
+		}
+		if( i%7 == 4 ) {
+			gfx_setSpriteFrameColor( pSprite, DOLL_RGBA( 255, 160, 160, 200 ) );
+		}
+
+		if( !bMixed || i%5 != 4 ) {
+			++scene.cInstanceable;
+		} else if( i%10 == 4 ) {
+			gfx_setSpriteRotation( pSprite, 30 );
+		} else {
+			gfx_setSpriteFrameCornerColors( pSprite, DOLL_RGB( 255, 0, 0 ), DOLL_RGB( 0, 255, 0 ), DOLL_RGB( 0, 0, 255 ), DOLL_RGB( 255, 255, 255 ) );
+		}
+	}
+
+	return true;
+}
+static Void destroyScene( SScene &scene )
+{
+	for( RSprite *pSprite : scene.sprites ) {
+		gfx_deleteSprite( pSprite );
+	}
+	for( RTexture *pTexture : scene.textures ) {
+		gfx_deleteTexture( pTexture );
+	}
+
+	scene.sprites.clear();
+	scene.textures.clear();
+}
+
+// Draw a frame, keeping its pixels and what the default sprite group did
+static Bool drawFrame( CGfxAPI_Soft &softAPI, Bool bInstancing, std::vector< U32 > &pixels, SGfxRenderCounters &counters )
+{
+	gfx_enableSpriteInstancing( bInstancing );
+
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	gfx_clearQueue();
+	gfx_queClearRect( 0, 0, S32( kResX ), S32( kResY ), kBackground );
+
+	doll_sync();
+
+	const U32 *const pPixels = softAPI.readback();
+	if( !DOLL_CHECK( pPixels != nullptr ) ) {
+		return false;
+	}
+	pixels.assign( pPixels, pPixels + kResX*kResY );
+
+	memset( &counters, 0, sizeof( counters ) );
+
+	SGfxRenderFrameStats frame;
+	if( !DOLL_CHECK( gfx_getRenderStatsFrame( frame ) ) ) {
+		return false;
+	}
+
+	for( U32 i = 0; i < frame.cScopes; ++i ) {
+		SGfxRenderScopeStats scope;
+		if( !gfx_getRenderStatsScope( scope, i ) || scope.pGroup != gfx_getDefaultSpriteGroup() ) {
+			continue;
+		}
+
+		counters.cDraws        += scope.counters.cDraws;
+		counters.cVertices     += scope.counters.cVertices;
+		counters.cVBufferBytes += scope.counters.cVBufferBytes;
+	}
+
+	return true;
+}
+
+static Void checkScene( CGfxAPI_Soft &softAPI, const char *pszName, Bool bMixed )
+{
+	SScene scene;
+	if( !buildScene( scene, bMixed ) ) {
+		destroyScene( scene );
+		return;
+	}
+
+	std::vector< U32 > instanced;
+	std::vector< U32 > expanded;
+	SGfxRenderCounters instancedCounters;
+	SGfxRenderCounters expandedCounters;
+	if( drawFrame( softAPI, true, instanced, instancedCounters ) && drawFrame( softAPI, false, expanded, expandedCounters ) ) {
+		U32 cMismatched = 0;
+		U32 cDrawn = 0;
+		for( UPtr i = 0; i < instanced.size(); ++i ) {
+			cMismatched += U32( instanced[ i ] != expanded[ i ] );
+			cDrawn += U32( expanded[ i ] != kBackground );
+		}
+
+		if( !DOLL_CHECK( cMismatched == 0 ) ) {
+			fprintf( stderr, "  %s: %u of %u pixels differ when instanced\n", pszName, cMismatched, U32( instanced.size() ) );
+		}
+		DOLL_CHECK( cDrawn > kResX*kResY/8 );
+
+		// The same vertices either way, from a record per instanced sprite
+		DOLL_CHECK( instancedCounters.cVertices == kSpriteCount*6 );
+		DOLL_CHECK( expandedCounters.cVertices == kSpriteCount*6 );
+		DOLL_CHECK( instancedCounters.cVBufferBytes < expandedCounters.cVBufferBytes );
+		if( !bMixed ) {
+			DOLL_CHECK( instancedCounters.cVBufferBytes == scene.cInstanceable*kInstanceBytes );
+		}
+	}
+
+	destroyScene( scene );
+}
+
+int main()
+{
+	SCoreConfig conf;
+	conf.setResolution( kResX, kResY );
+
+	if( !DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		return test::finish( "Test-SpriteInstancing" );
+	}
+
+	DOLL_CHECK( gfx_isSpriteInstancingEnabled() );
+	DOLL_CHECK( gfx_enableRenderStats() );
+
+	CGfxAPI_Soft *const pSoftAPI = gfx_getSoftAPI( &gfx_r_getFrame()->getContext() );
+	if( DOLL_CHECK( pSoftAPI != nullptr ) ) {
+		checkScene( *pSoftAPI, "instanceable", false );
+		checkScene( *pSoftAPI, "mixed", true );
+	}
+
+	gfx_enableSpriteInstancing();
+
+	doll_fini();
+	return test::finish( "Test-SpriteInstancing" );
+}
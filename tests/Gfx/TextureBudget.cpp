@@ -0,0 +1,220 @@
+// Texture budget: atlases of loaded images are evicted least recently drawn
+// first once over the budget, but never while drawn from this frame and never
+// if they hold textures made from memory; an evicted atlas draws as a
+// placeholder until its images have been read back in, then as before
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+#include "doll/Gfx/Texture.hpp"
+#include "doll/IO/VFS.hpp"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace doll;
+
+static const U32 kResX = 64;
+static const U32 kResY = 64;
+
+static const U16 kAtlasRes = 64;
+static const U16 kImageRes = 16;
+
+static const char *const kImageFilenames[] = {
+	"Test-TextureBudget-A.tga",
+	"Test-TextureBudget-B.tga",
+	"Test-TextureBudget-C.tga"
+};
+static const UPtr kNumImages = sizeof( kImageFilenames )/sizeof( kImageFilenames[ 0 ] );
+
+// Longest to wait for an evicted atlas to be read back in
+static const U32 kMaxReloadFrames = 5000;
+
+// Uncompressed 32-bit TGA of one colour
+static Bool writeImage( const char *pszFilename, U8 r, U8 g, U8 b )
+{
+	std::vector< U8 > image( 18 + kImageRes*kImageRes*4 );
+
+	image[ 2 ]  = 2;
+	image[ 12 ] = U8( kImageRes & 0xFF );
+	image[ 13 ] = U8( kImageRes>>8 );
+	image[ 14 ] = U8( kImageRes & 0xFF );
+	image[ 15 ] = U8( kImageRes>>8 );
+	image[ 16 ] = 32;
+	image[ 17 ] = 8;
+
+	for( UPtr i = 18; i < image.size(); i += 4 ) {
+		image[ i + 0 ] = b;
+		image[ i + 1 ] = g;
+		image[ i + 2 ] = r;
+		image[ i + 3 ] = 255;
+	}
+
+	IFile *const pFile = fs_open( pszFilename, kFileOpenF_W | kFileOpenF_Recreate );
+	if( !pFile ) {
+		return false;
+	}
+
+	const Bool bWritten = fs_write( pFile, image.data(), image.size() ) == image.size();
+	fs_close( pFile );
+
+	return bWritten;
+}
+
+// Present a frame with `pTexture` (if any) stretched over all of it, returning
+// the pixel in the middle
+static U32 drawFrame( CGfxAPI_Soft &softAPI, const RTexture *pTexture )
+{
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	gfx_clearQueue();
+
+	gfx_queClearRect( 0, 0, S32( kResX ), S32( kResY ), DOLL_RGB( 30, 30, 50 ) );
+	if( pTexture != nullptr ) {
+		gfx_stretchImage( pTexture, 0, 0, S32( kResX ), S32( kResY ) );
+	}
+
+	doll_sync();
+
+	U32 uResX = 0, uResY = 0;
+	softAPI.getSize( uResX, uResY );
+
+	const U32 *const pPixels = softAPI.readback();
+	if( !pPixels || uResX == 0 || uResY == 0 ) {
+		return 0;
+	}
+
+	return pPixels[ ( uResY/2 )*uResX + uResX/2 ];
+}
+
+static Void testBudget( CGfxAPI_Soft &softAPI )
+{
+	CTextureAtlas *atlases[ kNumImages ] = {};
+	RTexture *textures[ kNumImages ] = {};
+
+	static const U8 kColors[ kNumImages ][ 3 ] = {
+		{ 220, 40, 40 }, { 40, 220, 40 }, { 40, 40, 220 }
+	};
+
+	// One image to an atlas, so each can be evicted on its own
+	Bool bLoaded = true;
+	for( UPtr i = 0; i < kNumImages; ++i ) {
+		atlases[ i ] = gfx_newTextureAtlas( kAtlasRes, kAtlasRes, kTexFmtRGBA8 );
+		bLoaded &= DOLL_CHECK( atlases[ i ] != nullptr );
+		bLoaded &= DOLL_CHECK( writeImage( kImageFilenames[ i ], kColors[ i ][ 0 ], kColors[ i ][ 1 ], kColors[ i ][ 2 ] ) );
+
+		if( atlases[ i ] != nullptr ) {
+			textures[ i ] = gfx_loadTextureInAtlas( kImageFilenames[ i ], atlases[ i ] );
+		}
+		bLoaded &= DOLL_CHECK( textures[ i ] != nullptr );
+	}
+
+	// And one with a texture that can't be read back in
+	std::vector< U32 > texels( kImageRes*kImageRes, DOLL_RGB( 250, 240, 200 ) );
+
+	CTextureAtlas *const pMemAtlas = gfx_newTextureAtlas( kAtlasRes, kAtlasRes, kTexFmtRGBA8 );
+	RTexture *const pMemTexture = pMemAtlas != nullptr ? gfx_newTextureInAtlas( kImageRes, kImageRes, texels.data(), kTexFmtRGBA8, pMemAtlas ) : nullptr;
+	bLoaded &= DOLL_CHECK( pMemTexture != nullptr );
+
+	if( bLoaded ) {
+		CTextureAtlas &atlasA = *atlases[ 0 ];
+		CTextureAtlas &atlasB = *atlases[ 1 ];
+		CTextureAtlas &atlasC = *atlases[ 2 ];
+
+		DOLL_CHECK( textures[ 0 ]->getSource().cmp( kImageFilenames[ 0 ] ) );
+		DOLL_CHECK( pMemTexture->getSource().isEmpty() );
+
+		// Drawn least recently: A, then B, then C
+		const U32 uColorA = drawFrame( softAPI, textures[ 0 ] );
+		DOLL_CHECK( uColorA != drawFrame( softAPI, nullptr ) );
+
+		textures[ 1 ]->useBackingTexture();
+		drawFrame( softAPI, nullptr );
+		textures[ 2 ]->useBackingTexture();
+		drawFrame( softAPI, nullptr );
+
+		// C is drawn from in this frame too
+		DOLL_CHECK( textures[ 2 ]->useBackingTexture() == atlasC.getBackingTexture() );
+
+		// Just over the budget: the oldest goes first
+		gfx_setTextureBudget( gfx_getResidentTextureBytes() - 1 );
+		DOLL_CHECK( !atlasA.isResident() );
+		DOLL_CHECK( atlasB.isResident() );
+		DOLL_CHECK( atlasC.isResident() );
+		DOLL_CHECK( pMemAtlas->isResident() );
+
+		// Far over the budget: everything else that can go does, except for
+		// C, which is kept until its frame is over
+		gfx_setTextureBudget( 1 );
+		DOLL_CHECK( !atlasB.isResident() );
+		DOLL_CHECK( atlasC.isResident() );
+		DOLL_CHECK( pMemAtlas->isResident() );
+
+		drawFrame( softAPI, nullptr );
+		DOLL_CHECK( atlasC.isResident() );
+
+		drawFrame( softAPI, nullptr );
+		DOLL_CHECK( !atlasC.isResident() );
+		DOLL_CHECK( pMemAtlas->isResident() );
+		DOLL_CHECK( gfx_getResidentTextureBytes() >= pMemAtlas->getByteCount() );
+
+		// Drawing from an evicted atlas brings it back, drawing the
+		// placeholder until its image has been read back in
+		gfx_setTextureBudget( 0 );
+
+		const UPtr placeholder = textures[ 0 ]->useBackingTexture();
+		DOLL_CHECK( atlasA.isResident() );
+		DOLL_CHECK( placeholder != 0 );
+		DOLL_CHECK( placeholder != atlasA.getBackingTexture() );
+
+		UPtr drawnTexture = placeholder;
+		for( U32 uFrame = 0; uFrame < kMaxReloadFrames && drawnTexture == placeholder; ++uFrame ) {
+			drawFrame( softAPI, nullptr );
+			drawnTexture = textures[ 0 ]->useBackingTexture();
+
+			if( drawnTexture == placeholder ) {
+				std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			}
+		}
+
+		// Then the image as it was
+		if( DOLL_CHECK( drawnTexture == atlasA.getBackingTexture() ) ) {
+			DOLL_CHECK( drawFrame( softAPI, textures[ 0 ] ) == uColorA );
+		}
+
+		// The others stay evicted until they're drawn from
+		DOLL_CHECK( !atlasB.isResident() );
+		DOLL_CHECK( !atlasC.isResident() );
+	}
+
+	gfx_setTextureBudget( 0 );
+
+	for( UPtr i = 0; i < kNumImages; ++i ) {
+		gfx_deleteTexture( textures[ i ] );
+		gfx_deleteTextureAtlas( atlases[ i ] );
+		fs_remove( kImageFilenames[ i ] );
+	}
+
+	gfx_deleteTexture( pMemTexture );
+	gfx_deleteTextureAtlas( pMemAtlas );
+}
+
+int main()
+{
+	SCoreConfig conf;
+	conf.setResolution( kResX, kResY );
+
+	if( !DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		return test::finish( "Test-TextureBudget" );
+	}
+
+	CGfxAPI_Soft *const pSoftAPI = gfx_getSoftAPI( &gfx_r_getFrame()->getContext() );
+	if( DOLL_CHECK( pSoftAPI != nullptr ) ) {
+		testBudget( *pSoftAPI );
+	}
+
+	doll_fini();
+	return test::finish( "Test-TextureBudget" );
+}
@@ -0,0 +1,214 @@
+// Parallel lexing: lexSources() gives the same result on any number of
+// threads; the same tokens, identifiers entering the dictionary in the same
+// order, the same string table and the same diagnostics in the same order,
+// including for sources with lexer errors
+
+#include "Common/DollTest.hpp"
+#include "Common/ScriptGen.hpp"
+
+#include "doll/Script/Compiler.hpp"
+#include "doll/Script/Diagnostics.hpp"
+#include "doll/Script/LanguageVersion.hpp"
+#include "doll/Script/Source.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace doll;
+using namespace doll::script;
+
+static const U32 kNumSources = 24;
+
+// Sources that get stray brackets (lexer errors) written into them
+static const U32 kBadSources[] = { 5, 17 };
+
+static Void getFilename( char( &szDst )[ 64 ], U32 uSource )
+{
+	axspf( szDst, "Test-LexDeterminism-%u.script", uSource );
+}
+
+// Everything lexSources() produced, flattened so two runs can be compared
+struct SLexResult
+{
+	Bool                       bLexed;
+
+	// Per token: type and flags, offset and length, then the value (or the
+	// identifier's name)
+	std::vector< std::string > tokens;
+	// Names of identifiers in the order they were first merged
+	std::vector< std::string > idents;
+	std::vector< std::string > strings;
+	// Per diagnostic: id, source and offset
+	std::vector< std::string > diags;
+};
+
+static Bool lexAll( SLexResult &dst, U32 cThreads )
+{
+	CCompilerContext ctx;
+	if( !DOLL_CHECK( ctx.init( kVer_1_0 ) ) ) {
+		return false;
+	}
+
+	std::vector< Source * > sources;
+	for( U32 i = 0; i < kNumSources; ++i ) {
+		char szFilename[ 64 ];
+		getFilename( szFilename, i );
+
+		if( !DOLL_CHECK( ctx.openSource( szFilename ) ) || !DOLL_CHECK( ctx.getActiveSource() != nullptr ) ) {
+			return false;
+		}
+
+		sources.push_back( ctx.getActiveSource() );
+	}
+
+	// Kept rather than printed, so their order can be checked
+	CDiagnosticEngine &diagEngine = ctx.getDiagnosticEngine();
+	diagEngine.enableDeferred();
+
+	dst.bLexed = ctx.lexSources( cThreads );
+
+	IdentDictionary &dict = ctx.getSymbolMap();
+	std::vector< const Ident * > seenIdents;
+	U32 cForeignIdents = 0;
+
+	char szBuf[ 128 ];
+	for( const Source *pSrc : sources ) {
+		for( const SToken &tok : pSrc->tokens ) {
+			axspf( szBuf, "%u:%u %u+%u ", U32( tok.getType() ), U32( tok.getFlags() ), U32( tok.getOffset() ), U32( tok.getLength() ) );
+			std::string desc( szBuf );
+
+			if( !tok.hasIdent() ) {
+				axspf( szBuf, "%llu", ( unsigned long long )tok.value.i );
+				desc += szBuf;
+			} else if( tok.value.p != nullptr ) {
+				const Ident &ident = *tok.value.p;
+				desc.append( ident.name.get(), ident.name.len() );
+
+				// Tokens refer to the context's identifiers, not a worker's
+				const IdentDictionary::SEntry *const pEntry = dict.lookup( ident.name );
+				cForeignIdents += U32( !pEntry || pEntry->pData != &ident );
+
+				Bool bSeen = false;
+				for( const Ident *pSeen : seenIdents ) {
+					bSeen |= pSeen == &ident;
+				}
+				if( !bSeen && !ident.isKeyword ) {
+					seenIdents.push_back( &ident );
+					dst.idents.push_back( std::string( ident.name.get(), ident.name.len() ) );
+				}
+			}
+
+			dst.tokens.push_back( desc );
+		}
+	}
+
+	DOLL_CHECK( cForeignIdents == 0 );
+
+	const CProgramData &progData = ctx.getProgramData();
+	for( UPtr i = 0; i < progData.getStringCount(); ++i ) {
+		const Str s = progData.getString( i );
+		dst.strings.push_back( std::string( s.get(), s.len() ) );
+	}
+
+	for( UPtr i = 0; i < diagEngine.numDeferred(); ++i ) {
+		const Diagnostic &diag = diagEngine.getDeferred( i );
+		const SourceLoc loc = diag.getLoc();
+
+		axspf( szBuf, "%u @%u:%u", U32( diag.getId() ), loc.pSource != nullptr ? U32( loc.pSource->index ) : ~0U, loc.uOffset );
+		dst.diags.push_back( szBuf );
+	}
+
+	return true;
+}
+
+static UPtr countMismatches( const std::vector< std::string > &a, const std::vector< std::string > &b )
+{
+	if( a.size() != b.size() ) {
+		return a.size() > b.size() ? a.size() - b.size() : b.size() - a.size();
+	}
+
+	UPtr cMismatches = 0;
+	for( UPtr i = 0; i < a.size(); ++i ) {
+		cMismatches += UPtr( a[ i ] != b[ i ] );
+	}
+
+	return cMismatches;
+}
+
+static Void compareRuns( const SLexResult &serial, U32 cThreads )
+{
+	SLexResult parallel;
+	if( !lexAll( parallel, cThreads ) ) {
+		return;
+	}
+
+	const UPtr cTokenMismatches = countMismatches( serial.tokens, parallel.tokens );
+	const UPtr cIdentMismatches = countMismatches( serial.idents, parallel.idents );
+	const UPtr cStringMismatches = countMismatches( serial.strings, parallel.strings );
+	const UPtr cDiagMismatches = countMismatches( serial.diags, parallel.diags );
+
+	DOLL_CHECK( parallel.bLexed == serial.bLexed );
+	DOLL_CHECK( cTokenMismatches == 0 );
+	DOLL_CHECK( cIdentMismatches == 0 );
+	DOLL_CHECK( cStringMismatches == 0 );
+	DOLL_CHECK( cDiagMismatches == 0 );
+
+	if( cTokenMismatches + cIdentMismatches + cStringMismatches + cDiagMismatches > 0 ) {
+		fprintf( stderr, "  %u threads: %u token, %u identifier, %u string and %u diagnostic mismatches\n",
+			cThreads, U32( cTokenMismatches ), U32( cIdentMismatches ), U32( cStringMismatches ), U32( cDiagMismatches ) );
+	}
+}
+
+int main()
+{
+	test::SConsoleApp app;
+	if( !DOLL_CHECK( app.bInitialized ) ) {
+		return test::finish( "Test-LexDeterminism" );
+	}
+
+	// Sizes vary, so the threads get different shares of the sources
+	Bool bWritten = true;
+	for( U32 i = 0; i < kNumSources; ++i ) {
+		std::string script = test::makeDialogueScript( 2048 + ( i*7919 )%( 48*1024 ), 100 + i );
+
+		for( U32 uBad : kBadSources ) {
+			if( i != uBad ) {
+				continue;
+			}
+
+			// Between two scenes, a third of the way in and near the end
+			for( UPtr uAt : { script.size()/3, script.size()*9/10 } ) {
+				const std::string::size_type uScene = script.find( "}\n\n", uAt );
+				if( uScene != std::string::npos ) {
+					script.insert( uScene + 3, "x = ( 1 + 2 ))\ny = [ 3 ]]\n}\n" );
+				}
+			}
+		}
+
+		char szFilename[ 64 ];
+		getFilename( szFilename, i );
+		bWritten &= DOLL_CHECK( test::writeTextFile( szFilename, script ) );
+	}
+
+	SLexResult serial;
+	if( bWritten && lexAll( serial, 1 ) ) {
+		DOLL_CHECK( serial.tokens.size() > kNumSources*100 );
+		DOLL_CHECK( serial.idents.size() > 0 );
+		DOLL_CHECK( serial.strings.size() > 0 );
+
+		// Three stray closers at each of the two places in each bad source
+		DOLL_CHECK( serial.diags.size() == arraySize( kBadSources )*2*3 );
+
+		compareRuns( serial, 3 );
+		compareRuns( serial, 8 );
+		compareRuns( serial, kNumSources );
+	}
+
+	for( U32 i = 0; i < kNumSources; ++i ) {
+		char szFilename[ 64 ];
+		getFilename( szFilename, i );
+		fs_remove( szFilename );
+	}
+
+	return test::finish( "Test-LexDeterminism" );
+}
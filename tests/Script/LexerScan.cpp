@@ -0,0 +1,111 @@
+// Lexer byte scanning: lexScan_find() (sixteen bytes per step with SSE) must
+// stop exactly where the byte-at-a-time lexScan_findScalar() does, for every
+// byte class, alignment and length, including the tail shorter than a step
+
+#include "Common/DollTest.hpp"
+
+#include "Script/LexerScan.hpp"
+
+#include <vector>
+
+using namespace doll;
+using namespace doll::script;
+
+// Bytes the classes care about turn up often; the rest are arbitrary,
+// including NUL, DEL and non-ASCII bytes
+static const U8 kInterestingBytes[] = {
+	' ', '\t', '\r', '\n', '_', '"', '\'', '\\', '*', '/', '`',
+	'a', 'z', 'A', 'Z', '0', '9', '@', '[', '{', 0x00, 0x1F, 0x20, 0x21,
+	0x7F, 0x80, 0xC3, 0xE3, 0xFF
+};
+
+static Void fillRandom( std::vector< char > &buf, test::SRandom &rng )
+{
+	for( char &ch : buf ) {
+		const U32 uRoll = rng.next();
+		ch = char( uRoll%4 != 0 ? kInterestingBytes[ ( uRoll>>2 )%arraySize( kInterestingBytes ) ] : U8( uRoll>>8 ) );
+	}
+}
+
+// Long runs of a single "skip" byte, so the scan goes several steps before
+// stopping
+static Void fillRuns( std::vector< char > &buf, test::SRandom &rng, char chSkip )
+{
+	for( char &ch : buf ) {
+		const U32 uRoll = rng.next();
+		ch = uRoll%40 != 0 ? chSkip : char( kInterestingBytes[ ( uRoll>>6 )%arraySize( kInterestingBytes ) ] );
+	}
+}
+
+template< typename TClass >
+static U32 countMismatches( const std::vector< char > &buf, const TClass &cls )
+{
+	U32 cMismatches = 0;
+
+	const char *const pBase = buf.data();
+	const UPtr cBytes = buf.size();
+
+	for( UPtr uStart = 0; uStart < 33 && uStart <= cBytes; ++uStart ) {
+		for( UPtr uEnd = uStart; uEnd <= cBytes; ++uEnd ) {
+			const char *const p = pBase + uStart;
+			const char *const e = pBase + uEnd;
+
+			cMismatches += U32( lexScan_find( p, e, cls ) != lexScan_findScalar( p, e, cls ) );
+		}
+	}
+
+	return cMismatches;
+}
+
+template< typename TClass >
+static Void checkClass( const char *pszName, const TClass &cls, char chSkip )
+{
+	test::SRandom rng = { 0x5EED };
+
+	U32 cMismatches = 0;
+	for( U32 uRound = 0; uRound < 64; ++uRound ) {
+		// Exactly sized, so a read past `e` lands outside the allocation
+		std::vector< char > buf( 1 + rng.next()%160 );
+
+		fillRandom( buf, rng );
+		cMismatches += countMismatches( buf, cls );
+
+		fillRuns( buf, rng, chSkip );
+		cMismatches += countMismatches( buf, cls );
+	}
+
+	if( !DOLL_CHECK( cMismatches == 0 ) ) {
+		fprintf( stderr, "  %s: %u mismatches\n", pszName, cMismatches );
+	}
+}
+
+int main()
+{
+	// Every byte value against the single byte test
+	{
+		U32 cMismatches = 0;
+		for( U32 i = 0; i < 256; ++i ) {
+			const char ch = char( i );
+			const char *const p = &ch;
+
+			cMismatches += U32( lexScan_find( p, p + 1, SLexScan_Blank() ) != lexScan_findScalar( p, p + 1, SLexScan_Blank() ) );
+			cMismatches += U32( lexScan_find( p, p + 1, SLexScan_Ident() ) != lexScan_findScalar( p, p + 1, SLexScan_Ident() ) );
+		}
+		DOLL_CHECK( cMismatches == 0 );
+	}
+
+	checkClass( "blank", SLexScan_Blank(), ' ' );
+	checkClass( "ident", SLexScan_Ident(), 'q' );
+	checkClass( "either", SLexScan_Either( '*', '\n' ), '-' );
+	checkClass( "string", SLexScan_String( '"', false ), 'x' );
+	checkClass( "string (blank)", SLexScan_String( '`', true ), 'x' );
+	checkClass( "string (UTF-8)", SLexScan_String( lexScan_utf8Lead( 0x300D ), false ), 'x' );
+
+	// Str overload
+	{
+		const Str s( "    \t\r\nword" );
+		DOLL_CHECK( lexScan_find( s, SLexScan_Blank() ).get() == s.get() + 7 );
+	}
+
+	return test::finish( "Test-LexerScan" );
+}
@@ -0,0 +1,92 @@
+// Parser recovery: stray closing brackets and a menu without its braces are
+// reported once each, and parsing still runs to the end of the source rather
+// than stopping on (or looping over) the token the lexer refused
+
+#include "Common/DollTest.hpp"
+#include "Common/ScriptGen.hpp"
+
+#include "doll/Script/AST.hpp"
+#include "doll/Script/Compiler.hpp"
+#include "doll/Script/LanguageVersion.hpp"
+#include "doll/Script/Parser.hpp"
+
+#include <string>
+
+using namespace doll;
+using namespace doll::script;
+
+static const char *const kScriptFilename = "Test-ParserRecovery.script";
+
+// Parse `text`, returning how many diagnostics were raised (~0U if the source
+// couldn't be set up)
+static U32 parseText( const char *pszText, Bool &bParsed )
+{
+	bParsed = false;
+
+	if( !DOLL_CHECK( test::writeTextFile( kScriptFilename, pszText ) ) ) {
+		return ~0U;
+	}
+
+	CCompilerContext ctx;
+	if( !DOLL_CHECK( ctx.init( kVer_1_0 ) ) || !DOLL_CHECK( ctx.openSource( kScriptFilename ) ) ) {
+		return ~0U;
+	}
+
+	// Recorded rather than printed; only the count matters here
+	CDiagnosticEngine &diagEngine = ctx.getDiagnosticEngine();
+	diagEngine.enableDeferred();
+
+	CLexer lexer( ctx );
+	CSyntaxTree tree;
+	CParser parser( lexer, diagEngine, tree );
+
+	bParsed = parser.parseProgram();
+	return U32( diagEngine.numDeferred() );
+}
+
+static Void checkOneDiagnostic( const char *pszText )
+{
+	Bool bParsed = true;
+	const U32 cDiags = parseText( pszText, bParsed );
+
+	if( !DOLL_CHECK( cDiags == 1 ) || !DOLL_CHECK( !bParsed ) ) {
+		fprintf( stderr, "  %u diagnostics for: %s\n", cDiags, pszText );
+	}
+}
+
+int main()
+{
+	test::SConsoleApp app;
+	if( !DOLL_CHECK( app.bInitialized ) ) {
+		return test::finish( "Test-ParserRecovery" );
+	}
+
+	// Nothing wrong
+	{
+		Bool bParsed = false;
+		DOLL_CHECK( parseText( "x = 1\ny = ( x + 2 )*3\n", bParsed ) == 0 );
+		DOLL_CHECK( bParsed );
+	}
+
+	// Stray closers at the end of a statement and on their own
+	checkOneDiagnostic( "x = 1 )\n" );
+	checkOneDiagnostic( "x = a[ 1 ] ]\n" );
+	checkOneDiagnostic( "}\n" );
+	checkOneDiagnostic( "x = 1\n}\ny = 2\n" );
+
+	// A menu without its choices, and one never closed
+	checkOneDiagnostic( "menu\n}\n" );
+	checkOneDiagnostic( "menu {\n\t\"Yes\" { x = 1 }\n" );
+
+	// A menu within a menu stops the lexer for good; parsing stops with it
+	{
+		Bool bParsed = true;
+		const U32 cDiags = parseText( "menu {\n\tmenu {\n\t}\n}\nx = 1\n", bParsed );
+		DOLL_CHECK( cDiags >= 1 && cDiags != ~0U );
+		DOLL_CHECK( !bParsed );
+	}
+
+	fs_remove( kScriptFilename );
+
+	return test::finish( "Test-ParserRecovery" );
+}
@@ -0,0 +1,161 @@
+// Token cache: a source loaded from the cache comes back with the lexer
+// states saved along its tokens, so an edit to it re-lexes only the edited
+// part (as it does for a freshly lexed source) and ends up with the same
+// tokens as lexing the edited text from scratch
+
+#include "Common/DollTest.hpp"
+#include "Common/ScriptGen.hpp"
+
+#include "doll/IO/SysFS.hpp"
+#include "doll/Script/Compiler.hpp"
+#include "doll/Script/LanguageVersion.hpp"
+#include "doll/Script/Source.hpp"
+#include "doll/Script/TokenCache.hpp"
+
+#include <string>
+
+using namespace doll;
+using namespace doll::script;
+
+static const char *const kScriptFilename = "Test-TokenCache.script";
+static const char *const kEditedFilename = "Test-TokenCache-edited.script";
+static const char *const kCacheDir       = "Test-TokenCache.cache";
+
+// An edit touches a few tokens; re-lexing must stop within a couple of
+// saved states (they're 256 tokens apart) of it
+static const U32 kMaxRelexedTokens = 600;
+
+static Source *openAndLex( CCompilerContext &ctx, const char *pszFilename, const char *pszCacheDir )
+{
+	if( !DOLL_CHECK( ctx.init( kVer_1_0 ) ) ) {
+		return nullptr;
+	}
+	if( pszCacheDir != nullptr && !DOLL_CHECK( ctx.setTokenCacheDir( pszCacheDir ) ) ) {
+		return nullptr;
+	}
+	if( !DOLL_CHECK( ctx.openSource( pszFilename ) ) ) {
+		return nullptr;
+	}
+
+	Source *const pSrc = ctx.getActiveSource();
+	if( !DOLL_CHECK( pSrc != nullptr ) || !DOLL_CHECK( ctx.lexSources( 1 ) ) || !DOLL_CHECK( pSrc->isLexed ) ) {
+		return nullptr;
+	}
+
+	return pSrc;
+}
+
+// Remove the cache file an earlier run (or this one) left for `pszFilename`
+static Void removeCacheFile( const char *pszFilename )
+{
+	CCompilerContext ctx;
+	if( !ctx.init( kVer_1_0 ) || !ctx.openSource( pszFilename ) || !ctx.getActiveSource() ) {
+		return;
+	}
+
+	MutStr cacheFilename;
+	if( getTokenCacheFilename( cacheFilename, kCacheDir, *ctx.getActiveSource() ) ) {
+		( Void )sysfs_remove( cacheFilename );
+	}
+}
+
+static Bool isSameText( const Str &a, const Str &b )
+{
+	return a.len() == b.len() && ( a.isEmpty() || memcmp( a.get(), b.get(), a.len() ) == 0 );
+}
+
+// Tokens of `a` and `b` match (position, kind and identifier names)
+static U32 countTokenMismatches( const Source &a, const Source &b )
+{
+	if( a.tokens.num() != b.tokens.num() ) {
+		fprintf( stderr, "  token counts differ: %u vs %u\n", U32( a.tokens.num() ), U32( b.tokens.num() ) );
+		return 1;
+	}
+
+	U32 cMismatches = 0;
+	for( UPtr i = 0; i < a.tokens.num(); ++i ) {
+		const SToken &x = a.tokens[ i ];
+		const SToken &y = b.tokens[ i ];
+
+		if( x.getType() != y.getType() || x.getFlags() != y.getFlags() || x.getOffset() != y.getOffset() || x.getLength() != y.getLength() ) {
+			++cMismatches;
+			continue;
+		}
+
+		if( x.hasIdent() && ( !x.value.p || !y.value.p || !isSameText( x.value.p->name, y.value.p->name ) ) ) {
+			++cMismatches;
+		}
+	}
+
+	return cMismatches;
+}
+
+int main()
+{
+	test::SConsoleApp app;
+	if( !DOLL_CHECK( app.bInitialized ) ) {
+		return test::finish( "Test-TokenCache" );
+	}
+
+	std::string script = test::makeDialogueScript( 256*1024, 39 );
+	if( !DOLL_CHECK( test::writeTextFile( kScriptFilename, script ) ) ) {
+		return test::finish( "Test-TokenCache" );
+	}
+
+	// Start without a cache, so the first context really lexes
+	removeCacheFile( kScriptFilename );
+
+	// Rewrite part of a message in the middle of the script
+	const std::string::size_type uLine = script.find( "\n> ", script.size()/2 );
+	if( !DOLL_CHECK( uLine != std::string::npos ) ) {
+		return test::finish( "Test-TokenCache" );
+	}
+	const U32 uEditOffset = U32( uLine + 3 );
+	const U32 cEditRemove = 4;
+	const Str editText( "Quite suddenly, " );
+
+	script.replace( uEditOffset, cEditRemove, std::string( editText.get(), editText.len() ) );
+	DOLL_CHECK( test::writeTextFile( kEditedFilename, script ) );
+
+	// Lexed and saved
+	CCompilerContext lexedCtx;
+	Source *const pLexed = openAndLex( lexedCtx, kScriptFilename, kCacheDir );
+
+	// Loaded from the cache the first context saved
+	CCompilerContext cachedCtx;
+	Source *const pCached = openAndLex( cachedCtx, kScriptFilename, kCacheDir );
+
+	// The edited text, lexed from scratch
+	CCompilerContext freshCtx;
+	Source *const pFresh = openAndLex( freshCtx, kEditedFilename, nullptr );
+
+	if( pLexed != nullptr && pCached != nullptr && pFresh != nullptr ) {
+		DOLL_CHECK( !pLexed->isFromTokenCache );
+		DOLL_CHECK( pCached->isFromTokenCache );
+		DOLL_CHECK( pCached->lexStates.num() > 1 );
+		DOLL_CHECK( pCached->lexStates.num() == pLexed->lexStates.num() );
+		DOLL_CHECK( countTokenMismatches( *pLexed, *pCached ) == 0 );
+
+		DOLL_CHECK( lexedCtx.editSource( *pLexed, uEditOffset, cEditRemove, editText ) );
+		DOLL_CHECK( cachedCtx.editSource( *pCached, uEditOffset, cEditRemove, editText ) );
+
+		test::report( "tokens", F64( pFresh->tokens.num() ), "" );
+		test::report( "re-lexed after edit (lexed source)", F64( pLexed->cRelexedTokens ), "tokens" );
+		test::report( "re-lexed after edit (cached source)", F64( pCached->cRelexedTokens ), "tokens" );
+
+		DOLL_CHECK( pCached->cRelexedTokens > 0 );
+		DOLL_CHECK( pCached->cRelexedTokens <= kMaxRelexedTokens );
+		DOLL_CHECK( pCached->cRelexedTokens == pLexed->cRelexedTokens );
+
+		DOLL_CHECK( countTokenMismatches( *pCached, *pFresh ) == 0 );
+		DOLL_CHECK( countTokenMismatches( *pLexed, *pFresh ) == 0 );
+	}
+
+	removeCacheFile( kScriptFilename );
+	( Void )sysfs_rmdir( kCacheDir );
+
+	fs_remove( kScriptFilename );
+	fs_remove( kEditedFilename );
+
+	return test::finish( "Test-TokenCache" );
+}
@@ -0,0 +1,169 @@
+// Capture replay: makes the calls recorded in a graphics capture (see
+// SUserConfig::setCapture() and doll/Gfx/API-Capture.hpp) on a render API,
+// then prints how long each kind of call took and which frames were slowest,
+// with the slowest one broken down by call.
+//
+//   Tool-GfxReplay <capture> [<api>] [--threads <n>] [--top <n>]
+//
+// <api> is a render API name as in the configuration ("soft" by default).
+// The software renderer replays headlessly; other APIs open a window.
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Capture.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <vector>
+
+using namespace doll;
+
+// Time spent in each kind of call during one frame
+struct SFrameTimes
+{
+	U64 uMicrosecs;
+	U32 cCalls;
+	U64 callMicrosecs[ kNumGfxCaptureCalls ];
+	U32 callCounts[ kNumGfxCaptureCalls ];
+};
+
+static Void DOLL_API onReplayCall( Void *pParm, EGfxCaptureCall call, U32 uFrame, U64 uMicrosecs )
+{
+	std::vector< SFrameTimes > &frames = *reinterpret_cast< std::vector< SFrameTimes > * >( pParm );
+
+	if( uFrame >= frames.size() ) {
+		frames.resize( uFrame + 1, SFrameTimes() );
+	}
+
+	SFrameTimes &frame = frames[ uFrame ];
+	frame.uMicrosecs += uMicrosecs;
+	++frame.cCalls;
+	frame.callMicrosecs[ call ] += uMicrosecs;
+	++frame.callCounts[ call ];
+}
+
+static Void printCallName( EGfxCaptureCall call )
+{
+	printf( "  %-26s", gfx_getCaptureCallName( call ) );
+}
+
+// Kinds of call that were made, most total time first
+template< typename TCount, typename TTime >
+static std::vector< EGfxCaptureCall > sortCalls( TCount getCount, TTime getTime )
+{
+	std::vector< EGfxCaptureCall > calls;
+	for( U32 i = 0; i < U32( kNumGfxCaptureCalls ); ++i ) {
+		if( getCount( EGfxCaptureCall( i ) ) > 0 ) {
+			calls.push_back( EGfxCaptureCall( i ) );
+		}
+	}
+
+	std::stable_sort( calls.begin(), calls.end(), [&]( EGfxCaptureCall a, EGfxCaptureCall b ) { return getTime( a ) > getTime( b ); } );
+	return calls;
+}
+
+static Void printCallTable( const SGfxReplayStats &stats )
+{
+	const F64 fTotalUs = stats.uMicrosecs > 0 ? F64( stats.uMicrosecs ) : 1.0;
+
+	printf( "\n  %-26s %10s %12s %10s %10s %7s\n", "Call", "Calls", "Total ms", "Mean us", "Max us", "Share" );
+
+	const std::vector< EGfxCaptureCall > calls = sortCalls(
+		[&]( EGfxCaptureCall call ) { return stats.calls[ call ].cCalls; },
+		[&]( EGfxCaptureCall call ) { return stats.calls[ call ].uMicrosecs; } );
+	for( EGfxCaptureCall call : calls ) {
+		const SGfxReplayCallStats &c = stats.calls[ call ];
+
+		printCallName( call );
+		printf( " %10u %12.3f %10.2f %10u %6.1f%%\n",
+			c.cCalls, F64( c.uMicrosecs )/1000.0, F64( c.uMicrosecs )/F64( c.cCalls ), U32( c.uMaxMicrosecs ), F64( c.uMicrosecs )*100.0/fTotalUs );
+	}
+}
+
+static Void printSlowestFrames( const std::vector< SFrameTimes > &frames, U32 cTop )
+{
+	std::vector< U32 > order( frames.size() );
+	for( U32 i = 0; i < U32( frames.size() ); ++i ) {
+		order[ i ] = i;
+	}
+	std::stable_sort( order.begin(), order.end(), [&]( U32 a, U32 b ) { return frames[ a ].uMicrosecs > frames[ b ].uMicrosecs; } );
+
+	if( order.size() > cTop ) {
+		order.resize( cTop );
+	}
+
+	printf( "\n  %-26s %10s %12s\n", "Slowest frames", "Calls", "Total ms" );
+	for( U32 uFrame : order ) {
+		printf( "  frame %-20u %10u %12.3f\n", uFrame, frames[ uFrame ].cCalls, F64( frames[ uFrame ].uMicrosecs )/1000.0 );
+	}
+
+	if( order.empty() ) {
+		return;
+	}
+
+	const SFrameTimes &slowest = frames[ order[ 0 ] ];
+	const F64 fTotalUs = slowest.uMicrosecs > 0 ? F64( slowest.uMicrosecs ) : 1.0;
+
+	printf( "\n  %-26s %10s %12s %7s\n", "Slowest frame by call", "Calls", "Total us", "Share" );
+
+	const std::vector< EGfxCaptureCall > calls = sortCalls(
+		[&]( EGfxCaptureCall call ) { return slowest.callCounts[ call ]; },
+		[&]( EGfxCaptureCall call ) { return slowest.callMicrosecs[ call ]; } );
+	for( EGfxCaptureCall call : calls ) {
+		printCallName( call );
+		printf( " %10u %12u %6.1f%%\n", slowest.callCounts[ call ], U32( slowest.callMicrosecs[ call ] ), F64( slowest.callMicrosecs[ call ] )*100.0/fTotalUs );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	if( argc < 2 || argv[ 1 ][ 0 ] == '-' ) {
+		fprintf( stderr, "usage: %s <capture> [<api>] [--threads <n>] [--top <n>]\n", argv[ 0 ] );
+		return 2;
+	}
+
+	const char *const pszCapture = argv[ 1 ];
+	const char *const pszAPI = argc > 2 && argv[ 2 ][ 0 ] != '-' ? argv[ 2 ] : "soft";
+	const U32 cThreads = U32( atoi( test::argValue( argc, argv, "--threads", "0" ) ) );
+	const U32 cTop = U32( atoi( test::argValue( argc, argv, "--top", "5" ) ) );
+
+	IGfxAPIProvider *const pProvider = doll_findGfxAPIByName( pszAPI );
+	if( !DOLL_CHECK( pProvider != nullptr ) ) {
+		fprintf( stderr, "  no render API named \"%s\"\n", pszAPI );
+		return test::finish( "Tool-GfxReplay" );
+	}
+
+	SCoreConfig conf;
+	conf.setRenderAPI( pszAPI );
+
+	const Bool bHeadless = pProvider == doll_findGfxAPIByName( "soft" );
+	if( !DOLL_CHECK( bHeadless ? doll_initHeadless( &conf ) : doll_init( &conf ) ) ) {
+		return test::finish( "Tool-GfxReplay" );
+	}
+
+	IGfxAPI &api = gfx_r_getFrame()->getContext();
+	if( CGfxAPI_Soft *const pSoftAPI = gfx_getSoftAPI( &api ) ) {
+		pSoftAPI->setThreadCount( cThreads );
+	}
+
+	SGfxReplayStats stats;
+	std::vector< SFrameTimes > frames;
+
+	const Bool bReplayed = gfx_replayCapture( api, pszCapture, &stats, &onReplayCall, &frames );
+	if( !DOLL_CHECK( bReplayed ) ) {
+		fprintf( stderr, "  couldn't replay all of \"%s\"; timings cover the calls before the failure\n", pszCapture );
+	}
+
+	printf( "%s on %s: %u frames, %u calls, %.3f ms in the API (%.3f ms/frame, slowest frame %u at %.3f ms)\n",
+		pszCapture, pszAPI, stats.cFrames, stats.cCalls, F64( stats.uMicrosecs )/1000.0,
+		stats.cFrames > 0 ? F64( stats.uMicrosecs )/1000.0/F64( stats.cFrames ) : 0.0,
+		stats.uMaxFrame, F64( stats.uMaxFrameMicrosecs )/1000.0 );
+
+	printCallTable( stats );
+	printSlowestFrames( frames, cTop > 0 ? cTop : 1 );
+
+	doll_fini();
+	return test::finish( "Tool-GfxReplay" );
+}
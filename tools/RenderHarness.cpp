@@ -0,0 +1,502 @@
+// Render harness: builds a few scenes with the public drawing API, renders
+// them headlessly with the software renderer and reports how long the frames
+// took and what they handed the renderer (draw calls, vertices, bytes
+// uploaded), optionally as a JSON report.
+//
+//   Tool-RenderHarness [--scene <name>] [--frames <n>] [--threads <n>]
+//                      [--json <file>] [--golden <dir>] [--write-golden <dir>]
+//                      [--tolerance <n>] [--quick]
+//
+// With --golden, each scene that has a golden image (<dir>/<scene>.png, see
+// tests/Golden) is drawn once more as it is on its first frame, after the
+// timed frames, and compared against it; --write-golden saves that frame of
+// every scene run to <dir> instead. Scenes with a golden image keep all of
+// their edges and images on whole pixels, so only the rounding of blends and
+// gradients (which the tolerance covers) can change a pixel.
+
+#include "Common/DollTest.hpp"
+
+#include "doll/Front/Setup.hpp"
+#include "doll/Gfx/API-Soft.hpp"
+#include "doll/Gfx/Layer.hpp"
+#include "doll/Gfx/RenderCommands.hpp"
+#include "doll/Gfx/RenderStats.hpp"
+#include "doll/Gfx/Sprite.hpp"
+#include "doll/Gfx/Texture.hpp"
+#include "doll/IO/VFS.hpp"
+
+#include <stdlib.h>
+#include <vector>
+
+// Text is drawn with the FreeType backend everywhere but Windows and Apple's
+// systems
+#if !( AX_OS_WINDOWS || AX_OS_UWP || AX_OS_MACOSX || AX_OS_IOS )
+# define DOLL_HARNESS_FREETYPE 1
+# include "Gfx/FreeType/OSText_FreeType.hpp"
+#else
+# define DOLL_HARNESS_FREETYPE 0
+#endif
+
+using namespace doll;
+
+// Golden images are only valid at this resolution
+static const U32 kResX = 256;
+static const U32 kResY = 128;
+
+// Everything a scene creates, deleted before the next scene runs
+struct SSceneObjects
+{
+	std::vector< RLayer * >   layers;
+	std::vector< RSprite * >  sprites;
+	std::vector< RTexture * > textures;
+
+	// Set by a scene whose image depends on the system it runs on in a way
+	// its golden image doesn't cover (e.g., which font was found)
+	Bool                      bSkipGolden;
+
+	SSceneObjects()
+	: layers()
+	, sprites()
+	, textures()
+	, bSkipGolden( false )
+	{
+	}
+};
+
+struct SScene
+{
+	const char *pszName;
+	// Whether the scene has a golden image (checked with --golden)
+	Bool        bHasGolden;
+	// Create the scene's objects (may be null)
+	Bool     ( *pfnBuild )( SSceneObjects & );
+	// Update the scene before each frame (may be null)
+	Void     ( *pfnFrame )( SSceneObjects &, U32 uFrame );
+};
+
+struct SOptions
+{
+	const char *pszScene;
+	U32         cFrames;
+	U32         cThreads;
+	U32         uTolerance;
+	const char *pszJSONFile;
+	const char *pszGoldenDir;
+	const char *pszWriteGoldenDir;
+};
+
+struct SSceneResult
+{
+	const char *pszName;
+	U32         cFrames;
+	F64         fTotalMs;
+	F64         fMinMs;
+	F64         fMaxMs;
+	// Summed over all frames
+	U64         cDraws;
+	U64         cVertices;
+	U64         cVBufferBytes;
+	U64         cTextureBytes;
+	// "match", "mismatch", "written", "failed" (couldn't be written) or null
+	// if not checked
+	const char *pszGolden;
+};
+
+static Void beginDefaultQueue( U32 uBackground )
+{
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	gfx_clearQueue();
+
+	gfx_queClearRect( 0, 0, S32( kResX ), S32( kResY ), uBackground );
+}
+
+//----------------------------------------------------------------------------//
+
+// Solid boxes and clears on pixel boundaries: every pixel is either fully
+// covered or not at all, so the image is exact
+static Bool buildBoxes( SSceneObjects & )
+{
+	beginDefaultQueue( DOLL_RGB( 24, 28, 40 ) );
+
+	for( S32 y = 0; y < 4; ++y ) {
+		for( S32 x = 0; x < 8; ++x ) {
+			gfx_ink( DOLL_RGB( 40 + x*26, 40 + y*50, 200 - x*20 ) );
+			gfx_box( x*32 + 4, y*32 + 4, x*32 + 28, y*32 + 28 );
+		}
+	}
+
+	// Drawn over the boxes above
+	gfx_ink( DOLL_RGB( 250, 250, 250 ) );
+	gfx_box( 16, 60, 240, 68 );
+	gfx_queClearRect( 200, 96, 256, 128, DOLL_RGB( 255, 128, 0 ) );
+
+	return true;
+}
+
+// Gradients, blended circles and ellipses, rounded boxes and lines, some of
+// them moving
+static Void drawShapes( SSceneObjects &, U32 uFrame )
+{
+	const S32 d = S32( uFrame%32 );
+
+	beginDefaultQueue( DOLL_RGB( 16, 16, 24 ) );
+
+	gfx_hgradBox( 0, 0, 256, 24, DOLL_RGB( 200, 40, 40 ), DOLL_RGB( 40, 40, 200 ) );
+	gfx_gradBox( 8, 32, 72, 96, DOLL_RGB( 255, 0, 0 ), DOLL_RGB( 0, 255, 0 ), DOLL_RGB( 0, 0, 255 ), DOLL_RGB( 255, 255, 255 ) );
+
+	gfx_ink( DOLL_RGBA( 255, 220, 80, 200 ) );
+	gfx_circle( 104 + d, 64, 28 );
+	gfx_ink( DOLL_RGBA( 80, 200, 255, 160 ) );
+	gfx_ellipse( 136, 64 + d/4, 36, 18 );
+
+	gfx_ink( DOLL_RGB( 120, 220, 120 ) );
+	gfx_roundedBox( 176, 32, 248 - d, 96, 12 );
+
+	gfx_ink( DOLL_RGB( 230, 230, 230 ) );
+	for( S32 i = 0; i < 8; ++i ) {
+		gfx_line( i*32, 127, 255 - i*32 - d, 104 );
+	}
+	gfx_outline( 2, 2, 253, 125 );
+}
+
+// Many small textured sprites (four cells of one texture), all moving by whole
+// pixels and drawn at the texture's size
+static const U32 kSpriteCount = 256;
+static const U32 kSpriteCellRes = 16;
+
+static Bool buildSprites( SSceneObjects &objs )
+{
+	static const U32 kTexResX = kSpriteCellRes*4;
+	static const U32 kTexResY = kSpriteCellRes;
+
+	// Checkered cells, each tinted differently, with translucent gaps
+	std::vector< U32 > texels( kTexResX*kTexResY );
+	for( U32 y = 0; y < kTexResY; ++y ) {
+		for( U32 x = 0; x < kTexResX; ++x ) {
+			const U32 uCell = x/kSpriteCellRes;
+			const Bool bLit = ( x/4 + y/4 )%2 == 0;
+
+			texels[ y*kTexResX + x ] = bLit ? DOLL_RGB( 63 + uCell*64, 255 - uCell*64, 128 ) : DOLL_RGBA( 0, 0, 0, 96 );
+		}
+	}
+
+	RTexture *const pTexture = gfx_newTexture( U16( kTexResX ), U16( kTexResY ), texels.data(), kTexFmtRGBA8 );
+	if( !DOLL_CHECK( pTexture != nullptr ) ) {
+		return false;
+	}
+	objs.textures.push_back( pTexture );
+
+	for( U32 i = 0; i < kSpriteCount; ++i ) {
+		RSprite *const pSprite = gfx_loadAnimSprite( pTexture, S32( kSpriteCellRes ), S32( kSpriteCellRes ), S32( i%4 ), 1, 0, 0, 0, 0 );
+		if( !DOLL_CHECK( pSprite != nullptr ) ) {
+			return false;
+		}
+		objs.sprites.push_back( pSprite );
+	}
+
+	beginDefaultQueue( DOLL_RGB( 32, 24, 16 ) );
+	return true;
+}
+static Void moveSprites( SSceneObjects &objs, U32 uFrame )
+{
+	for( UPtr i = 0; i < objs.sprites.size(); ++i ) {
+		const U32 x = U32( i )*37 + uFrame*( 1 + U32( i )%5 );
+		const U32 y = U32( i )*11 + uFrame;
+
+		gfx_setSpritePosition( objs.sprites[ i ], F32( x%( kResX - kSpriteCellRes ) ), F32( y%( kResY - kSpriteCellRes ) ) );
+	}
+}
+
+// Cached layers: each layer's commands render into its cache once, after
+// which moving a layer only draws the cache again; each holds a gradient, a
+// translucent box over it and a solid bar
+static Bool buildLayers( SSceneObjects &objs )
+{
+	beginDefaultQueue( DOLL_RGB( 20, 32, 20 ) );
+
+	for( S32 i = 0; i < 6; ++i ) {
+		RLayer *const pLayer = gfx_newLayer();
+		if( !DOLL_CHECK( pLayer != nullptr ) ) {
+			return false;
+		}
+		objs.layers.push_back( pLayer );
+
+		gfx_setLayerPosition( pLayer, ( i%3 )*84 + 4, ( i/3 )*64 + 4 );
+		gfx_setLayerSize( pLayer, 76, 56 );
+		gfx_enableLayerCache( pLayer );
+
+		gfx_setCurrentLayer( pLayer );
+		gfx_vgradBox( 0, 0, 76, 56, DOLL_RGB( 40 + i*30, 60, 120 ), DOLL_RGB( 20, 20 + i*30, 40 ) );
+		gfx_ink( DOLL_RGBA( 255, 255, 255, 128 ) );
+		gfx_box( 18, 8, 58 - i*4, 36 );
+		gfx_ink( DOLL_RGB( 250, 200, 60 ) );
+		gfx_box( 6, 42, 70, 50 );
+	}
+
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	return true;
+}
+static Void moveLayers( SSceneObjects &objs, U32 uFrame )
+{
+	// The others stay where they are
+	gfx_setLayerPosition( objs.layers[ 0 ], 4 + S32( uFrame%8 ), 4 );
+}
+
+#if DOLL_HARNESS_FREETYPE
+// Text from the FreeType backend: outlined and plain, at two sizes, with
+// kerned pairs. Glyphs are drawn from the glyph pages at their size and on
+// whole pixels, so the image only depends on the font and on how FreeType
+// rasterizes it; the golden image is of DejaVu Sans (the first "sans" font
+// looked for) and isn't checked if another font was found
+static Bool buildText( SSceneObjects &objs )
+{
+	beginDefaultQueue( DOLL_RGB( 40, 48, 72 ) );
+
+	FreeType::FreeTypeFont title;
+	FreeType::FreeTypeFont body;
+	if( !title.set( "sans", 28 ) || !body.set( "sans", 14 ) ) {
+		printf( "  text: no sans font found; not checking the golden image\n" );
+		objs.bSkipGolden = true;
+		return true;
+	}
+
+	const Str family = title.getFamilyName();
+	if( !family.cmp( "DejaVu Sans" ) ) {
+		printf( "  text: found \"%.*s\" rather than DejaVu Sans; not checking the golden image\n", family.lenInt(), family.get() );
+		objs.bSkipGolden = true;
+	}
+
+	DOLL_CHECK( title.draw( "Doll: AVATAR", SRect( 8, 4, 248, 44 ), DOLL_RGB( 0, 0, 0 ), DOLL_RGB( 255, 255, 255 ) ) );
+	DOLL_CHECK( body.draw( "The quick brown fox jumps over\nthe lazy dog. Wo Ty 0123456789", SRect( 8, 52, 248, 124 ), 0, DOLL_RGB( 255, 200, 60 ) ) );
+
+	return true;
+}
+#endif
+
+static const SScene kScenes[] = {
+	{ "boxes",   true,  &buildBoxes,   nullptr      },
+	{ "shapes",  false, nullptr,       &drawShapes  },
+	{ "sprites", true,  &buildSprites, &moveSprites },
+	{ "layers",  true,  &buildLayers,  &moveLayers  },
+#if DOLL_HARNESS_FREETYPE
+	{ "text",    true,  &buildText,    nullptr      }
+#endif
+};
+
+//----------------------------------------------------------------------------//
+
+static Void destroyScene( SSceneObjects &objs )
+{
+	for( RSprite *pSprite : objs.sprites ) {
+		gfx_deleteSprite( pSprite );
+	}
+	for( RTexture *pTexture : objs.textures ) {
+		gfx_deleteTexture( pTexture );
+	}
+	for( RLayer *pLayer : objs.layers ) {
+		gfx_deleteLayer( pLayer );
+	}
+
+	objs.sprites.clear();
+	objs.textures.clear();
+	objs.layers.clear();
+
+	gfx_setCurrentLayer( gfx_getDefaultLayer() );
+	gfx_clearQueue();
+}
+
+static CGfxAPI_Soft *getSoftAPI()
+{
+	CGfxFrame *const pFrame = gfx_r_getFrame();
+	return pFrame != nullptr ? gfx_getSoftAPI( &pFrame->getContext() ) : nullptr;
+}
+
+// Compare the frame against the scene's golden image, or save it
+static const char *checkGolden( const SScene &scene, const SSceneObjects &objs, const SOptions &opts )
+{
+	CGfxAPI_Soft *const pSoftAPI = getSoftAPI();
+	char szPath[ 512 ];
+
+	if( opts.pszWriteGoldenDir != nullptr ) {
+		axspf( szPath, "%s/%s.png", opts.pszWriteGoldenDir, scene.pszName );
+		return DOLL_CHECK( pSoftAPI != nullptr && pSoftAPI->writePNG( szPath ) ) ? "written" : "failed";
+	}
+
+	if( opts.pszGoldenDir == nullptr || !scene.bHasGolden || objs.bSkipGolden ) {
+		return nullptr;
+	}
+
+	axspf( szPath, "%s/%s.png", opts.pszGoldenDir, scene.pszName );
+
+	SSoftImageDiff diff;
+	if( !DOLL_CHECK( pSoftAPI != nullptr && pSoftAPI->compareImageFile( szPath, opts.uTolerance, diff ) ) ) {
+		if( pSoftAPI != nullptr ) {
+			fprintf( stderr, "  %s: %u of %u pixels differ from %s (by up to %u), first at %u,%u%s\n",
+				scene.pszName, diff.cMismatched, diff.cPixels, szPath, diff.uMaxDelta, diff.uFirstX, diff.uFirstY,
+				diff.bSameSize ? "" : " -- the sizes differ" );
+		}
+		return "mismatch";
+	}
+
+	return "match";
+}
+
+static Bool runScene( SSceneResult &dst, const SScene &scene, const SOptions &opts )
+{
+	dst = SSceneResult();
+	dst.pszName = scene.pszName;
+
+	SSceneObjects objs;
+	if( scene.pfnBuild != nullptr && !scene.pfnBuild( objs ) ) {
+		destroyScene( objs );
+		return false;
+	}
+
+	for( U32 uFrame = 0; uFrame < opts.cFrames; ++uFrame ) {
+		const F64 fStart = test::seconds();
+
+		if( scene.pfnFrame != nullptr ) {
+			scene.pfnFrame( objs, uFrame );
+		}
+		doll_sync();
+
+		const F64 fMs = ( test::seconds() - fStart )*1000.0;
+
+		dst.fTotalMs += fMs;
+		dst.fMinMs = uFrame == 0 || fMs < dst.fMinMs ? fMs : dst.fMinMs;
+		dst.fMaxMs = fMs > dst.fMaxMs ? fMs : dst.fMaxMs;
+		++dst.cFrames;
+
+		SGfxRenderFrameStats stats;
+		if( DOLL_CHECK( gfx_getRenderStatsFrame( stats ) ) ) {
+			dst.cDraws        += stats.total.cDraws;
+			dst.cVertices     += stats.total.cVertices;
+			dst.cVBufferBytes += stats.total.cVBufferBytes;
+			dst.cTextureBytes += stats.total.cTextureBytes;
+		}
+	}
+
+	if( opts.pszGoldenDir != nullptr || opts.pszWriteGoldenDir != nullptr ) {
+		if( scene.pfnFrame != nullptr ) {
+			scene.pfnFrame( objs, 0 );
+			doll_sync();
+		}
+
+		dst.pszGolden = checkGolden( scene, objs, opts );
+	}
+
+	destroyScene( objs );
+	return true;
+}
+
+static Void printResult( const SSceneResult &r )
+{
+	const F64 fFrames = F64( r.cFrames );
+
+	printf( "%s (%u frames)%s%s\n", r.pszName, r.cFrames, r.pszGolden != nullptr ? ", golden image: " : "", r.pszGolden != nullptr ? r.pszGolden : "" );
+	test::report( "frame time (mean)", r.fTotalMs/fFrames, "ms" );
+	test::report( "frame time (max)", r.fMaxMs, "ms" );
+	test::report( "draw calls", F64( r.cDraws )/fFrames, "/frame" );
+	test::report( "vertices", F64( r.cVertices )/fFrames, "/frame" );
+	test::report( "vertex buffer uploads", F64( r.cVBufferBytes )/fFrames, "bytes/frame" );
+	test::report( "texture uploads (all frames)", F64( r.cTextureBytes ), "bytes" );
+}
+
+static Void writeCounters( IFile *pFile, const char *pszKey, const SSceneResult &r, F64 fDivisor, const char *pszSuffix )
+{
+	fs_pf( pFile, "      \"%s\": { \"drawCalls\": %.2f, \"vertices\": %.2f, \"vbufferBytes\": %.2f, \"textureBytes\": %.2f }%s\n",
+		pszKey, F64( r.cDraws )/fDivisor, F64( r.cVertices )/fDivisor, F64( r.cVBufferBytes )/fDivisor, F64( r.cTextureBytes )/fDivisor, pszSuffix );
+}
+
+static Bool writeReport( const SOptions &opts, U32 cThreads, const std::vector< SSceneResult > &results )
+{
+	IFile *const pFile = fs_open( opts.pszJSONFile, kFileOpenF_W | kFileOpenF_Recreate );
+	if( !pFile ) {
+		return false;
+	}
+
+	fs_pf( pFile, "{\n" );
+	fs_pf( pFile, "  \"renderer\": \"soft\",\n" );
+	fs_pf( pFile, "  \"resolution\": [ %u, %u ],\n", kResX, kResY );
+	fs_pf( pFile, "  \"threads\": %u,\n", cThreads );
+	fs_pf( pFile, "  \"frames\": %u,\n", opts.cFrames );
+	fs_pf( pFile, "  \"scenes\": [\n" );
+
+	for( UPtr i = 0; i < results.size(); ++i ) {
+		const SSceneResult &r = results[ i ];
+
+		fs_pf( pFile, "    {\n" );
+		fs_pf( pFile, "      \"name\": \"%s\",\n", r.pszName );
+		fs_pf( pFile, "      \"frameTimeMs\": { \"mean\": %.4f, \"min\": %.4f, \"max\": %.4f },\n", r.fTotalMs/F64( r.cFrames ), r.fMinMs, r.fMaxMs );
+		writeCounters( pFile, "perFrame", r, F64( r.cFrames ), "," );
+		writeCounters( pFile, "total", r, 1.0, "," );
+		if( r.pszGolden != nullptr ) {
+			fs_pf( pFile, "      \"golden\": \"%s\"\n", r.pszGolden );
+		} else {
+			fs_pf( pFile, "      \"golden\": null\n" );
+		}
+		fs_pf( pFile, "    }%s\n", i + 1 < results.size() ? "," : "" );
+	}
+
+	fs_pf( pFile, "  ]\n" );
+	fs_pf( pFile, "}\n" );
+
+	fs_close( pFile );
+	return true;
+}
+
+int main( int argc, char **argv )
+{
+	const Bool bQuick = test::isQuickRun( argc, argv );
+
+	SOptions opts;
+	opts.pszScene          = test::argValue( argc, argv, "--scene", "all" );
+	opts.cFrames           = U32( atoi( test::argValue( argc, argv, "--frames", bQuick ? "8" : "120" ) ) );
+	opts.cThreads          = U32( atoi( test::argValue( argc, argv, "--threads", "0" ) ) );
+	opts.uTolerance        = U32( atoi( test::argValue( argc, argv, "--tolerance", "1" ) ) );
+	opts.pszJSONFile       = test::argValue( argc, argv, "--json" );
+	opts.pszGoldenDir      = test::argValue( argc, argv, "--golden" );
+	opts.pszWriteGoldenDir = test::argValue( argc, argv, "--write-golden" );
+
+	if( opts.cFrames == 0 ) {
+		opts.cFrames = 1;
+	}
+
+	SCoreConfig conf;
+	conf.setResolution( kResX, kResY );
+
+	if( !DOLL_CHECK( doll_initHeadless( &conf ) ) ) {
+		return test::finish( "Tool-RenderHarness" );
+	}
+
+	CGfxAPI_Soft *const pSoftAPI = getSoftAPI();
+	if( DOLL_CHECK( pSoftAPI != nullptr ) && DOLL_CHECK( gfx_enableRenderStats( 4 ) ) ) {
+		pSoftAPI->setThreadCount( opts.cThreads );
+
+		std::vector< SSceneResult > results;
+		for( const SScene &scene : kScenes ) {
+			if( strcmp( opts.pszScene, "all" ) != 0 && strcmp( opts.pszScene, scene.pszName ) != 0 ) {
+				continue;
+			}
+
+			SSceneResult result;
+			if( DOLL_CHECK( runScene( result, scene, opts ) ) ) {
+				printResult( result );
+				results.push_back( result );
+			}
+		}
+
+		if( !DOLL_CHECK( !results.empty() ) ) {
+			fprintf( stderr, "  no scene named \"%s\"\n", opts.pszScene );
+		}
+
+		if( opts.pszJSONFile != nullptr ) {
+			DOLL_CHECK( writeReport( opts, pSoftAPI->getThreadCount(), results ) );
+		}
+
+		gfx_disableRenderStats();
+	}
+
+	doll_fini();
+	return test::finish( "Tool-RenderHarness" );
+}